@@ -0,0 +1,666 @@
+#include "AssetCooker.h"
+#include "AssetPackBuilder.h"
+#include "DdsFile.h"
+#include "FileSystem.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+	enum class StepKind
+	{
+		Texture,
+		Mesh,
+		Font,
+		Irradiance,
+		Specular,
+		Brdf			// The only step without an input - one LUT for every sky
+	};
+
+	// One output and the source it's cooked from (names relative to their roots)
+	struct CookStep
+	{
+		StepKind Kind;
+		TextureKind Texture;
+		std::string Input;
+		std::string SecondInput;	// The metalness map of a packed roughness/metalness texture
+		std::string Output;
+		uint64_t InputHash;
+		uint64_t Key;
+		bool Dirty;
+		bool Ok;
+		double Seconds;
+	};
+
+	struct SourceFile
+	{
+		std::string Name;
+		FileStamp Stamp;
+		uint64_t Hash;
+		bool Known;			// Hash came from the manifest
+	};
+
+	struct ManifestStep
+	{
+		uint64_t Key;
+		uint64_t Size;
+	};
+
+	struct Manifest
+	{
+		std::unordered_map<std::string, SourceFile> Files;
+		std::unordered_map<std::string, ManifestStep> Steps;
+		uint64_t PackKey = 0;
+	};
+
+	double SecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	bool EndsWith(const std::string& name, const char* suffix)
+	{
+		size_t length = strlen(suffix);
+		return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+	}
+
+	std::string Lower(std::string text)
+	{
+		for (size_t i = 0; i < text.size(); i++)
+			text[i] = (char)tolower((unsigned char)text[i]);
+		return text;
+	}
+
+	uint64_t Mix(uint64_t key, uint64_t value)
+	{
+		return HashBytes(&value, sizeof(value), key);
+	}
+
+	uint64_t Mix(uint64_t key, const std::string& text)
+	{
+		return HashBytes(text.data(), text.size(), key);
+	}
+
+	// Data maps by name - the repo's textures are named <material>_<map>.png
+	TextureKind TextureKindFor(const std::string& name)
+	{
+		std::string lower = Lower(name);
+		if (lower.find("normal") != std::string::npos)
+			return TextureKind::NormalMap;
+		if (lower.find("rough") != std::string::npos || lower.find("metal") != std::string::npos)
+			return TextureKind::Mask;
+		return TextureKind::Albedo;
+	}
+
+	// --------------------------------------------------------
+	// Reads a RoughnessMetalness.txt: one "<roughness.png>
+	// <metalness.png>" pair per line, relative to the list's
+	// folder, and # for comments.  Returns the pairs with their
+	// names relative to the source root
+	// --------------------------------------------------------
+	std::vector<std::pair<std::string, std::string>> ReadPackedPairs(const AssetCookerSettings& settings, const std::string& listName)
+	{
+		std::vector<std::pair<std::string, std::string>> pairs;
+		size_t slash = listName.find_last_of('/');
+		std::string folder = slash == std::string::npos ? "" : listName.substr(0, slash + 1);
+
+		std::ifstream in(settings.SourceRoot + "/" + listName);
+		std::string line;
+		while (std::getline(in, line))
+		{
+			std::istringstream record(line);
+			std::string roughness, metalness;
+			if (!(record >> roughness) || roughness[0] == '#')
+				continue;
+			if (!(record >> metalness))
+			{
+				printf("AssetCooker: %s: \"%s\" needs a metalness map too\n", listName.c_str(), line.c_str());
+				continue;
+			}
+			pairs.push_back(std::make_pair(folder + roughness, folder + metalness));
+		}
+		return pairs;
+	}
+
+	// Fonts/Cambria26.spritefont -> Fonts/Cambria.sdffont, size 26
+	std::string FontFamily(const std::string& name, int& size)
+	{
+		std::string base = name.substr(0, name.size() - strlen(".spritefont"));
+		size_t digits = base.size();
+		while (digits > 0 && isdigit((unsigned char)base[digits - 1]))
+			digits--;
+
+		size = digits < base.size() ? atoi(base.c_str() + digits) : 0;
+		if (digits > 0 && base[digits - 1] != '/')
+			base.resize(digits);
+		return base + ".sdffont";
+	}
+
+	// --------------------------------------------------------
+	// Manifest (plain text, one record per line):
+	//   AssetCooker <version>
+	//   file <size> <time> <hash> <name>
+	//   step <key> <size> <output>
+	//   pack <key>
+	// Names go last so they can hold spaces
+	// --------------------------------------------------------
+	bool ReadManifest(const std::string& path, Manifest& manifest)
+	{
+		std::ifstream in(path);
+		std::string line;
+		if (!in.is_open() || !std::getline(in, line))
+			return false;
+
+		//Another version's hashes are fine to reuse, but its step keys never match anyway
+		std::istringstream header(line);
+		std::string magic;
+		uint32_t version = 0;
+		header >> magic >> version;
+		if (magic != "AssetCooker")
+			return false;
+
+		while (std::getline(in, line))
+		{
+			std::istringstream record(line);
+			std::string type;
+			record >> type;
+
+			if (type == "file")
+			{
+				SourceFile file;
+				record >> file.Stamp.Size >> file.Stamp.ModifiedTime >> std::hex >> file.Hash >> std::dec;
+				record.get();
+				std::getline(record, file.Name);
+				file.Known = true;
+				if (record && !file.Name.empty())
+					manifest.Files[file.Name] = file;
+			}
+			else if (type == "step")
+			{
+				ManifestStep step;
+				std::string output;
+				record >> std::hex >> step.Key >> std::dec >> step.Size;
+				record.get();
+				std::getline(record, output);
+				if (record && !output.empty())
+					manifest.Steps[output] = step;
+			}
+			else if (type == "pack")
+				record >> std::hex >> manifest.PackKey;
+		}
+		return true;
+	}
+
+	bool WriteManifest(const std::string& path, const std::vector<SourceFile>& files, const std::unordered_map<std::string, ManifestStep>& steps, uint64_t packKey)
+	{
+		std::string tempFile = path + ".tmp";
+		{
+			std::ofstream out(tempFile, std::ios::trunc);
+			if (!out.is_open())
+				return false;
+
+			out << "AssetCooker " << AssetCooker::Version << "\n";
+			for (size_t i = 0; i < files.size(); i++)
+				out << "file " << files[i].Stamp.Size << " " << files[i].Stamp.ModifiedTime << " " << std::hex << files[i].Hash << std::dec << " " << files[i].Name << "\n";
+			for (std::unordered_map<std::string, ManifestStep>::const_iterator s = steps.begin(); s != steps.end(); ++s)
+				out << "step " << std::hex << s->second.Key << std::dec << " " << s->second.Size << " " << s->first << "\n";
+			out << "pack " << std::hex << packKey << std::dec << "\n";
+			if (!out.good())
+				return false;
+		}
+
+		//rename() won't replace an existing file on Windows
+		remove(path.c_str());
+		if (rename(tempFile.c_str(), path.c_str()) != 0)
+		{
+			remove(tempFile.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool CookTexture(const AssetCookerSettings& settings, const CookStep& step, bool verbose)
+	{
+		TextureCompressStats stats;
+		std::string destination = settings.OutputRoot + "/" + step.Output;
+		bool ok = step.SecondInput.empty() ?
+			TextureCompressor::Compress(settings.SourceRoot + "/" + step.Input, destination, step.Texture, &stats) :
+			TextureCompressor::CompressRoughnessMetalness(settings.SourceRoot + "/" + step.Input, settings.SourceRoot + "/" + step.SecondInput, destination, &stats);
+		std::string inputs = step.SecondInput.empty() ? step.Input : step.Input + " + " + step.SecondInput;
+		if (verbose && ok)
+			printf("  %-40s -> %s (%.1f KB, PSNR %.2f dB)\n", inputs.c_str(), step.Output.c_str(), stats.CompressedBytes / 1024.0, stats.Psnr);
+		return ok;
+	}
+
+	bool CookLighting(const AssetCookerSettings& settings, const CookStep& step, bool verbose, unsigned int& workers)
+	{
+		std::string source = settings.SourceRoot + "/" + step.Input;
+		std::string destination = settings.OutputRoot + "/" + step.Output;
+
+		IblBakeStats stats;
+		bool ok =
+			step.Kind == StepKind::Irradiance ? IblBaker::BakeIrradiance(source, destination, &stats) :
+			step.Kind == StepKind::Specular ? IblBaker::BakeSpecular(source, destination, settings.Lighting, &stats) :
+			IblBaker::BakeBrdf(destination, settings.Lighting, &stats);
+		workers = stats.Workers;
+		if (verbose && ok)
+			printf("  %-40s -> %s (%s, %.1f M samples)\n", step.Input.empty() ? "-" : step.Input.c_str(), step.Output.c_str(), stats.Stage, stats.Samples / 1e6);
+		return ok;
+	}
+
+	bool CookFont(const AssetCookerSettings& settings, const CookStep& step, bool verbose)
+	{
+		SdfFontStats stats;
+		bool ok = SdfFontBuilder::Cook(settings.SourceRoot + "/" + step.Input, settings.OutputRoot + "/" + step.Output, settings.Fonts, &stats);
+		if (verbose && ok)
+			printf("  %-40s -> %s (%u glyphs, %.1f KB -> %.1f KB)\n", step.Input.c_str(), step.Output.c_str(), stats.Glyphs, stats.SourceBytes / 1024.0, stats.AtlasBytes / 1024.0);
+		return ok;
+	}
+
+	// Only the header is read (it's mapped, so the pixels never are)
+	bool IsCubeMap(const std::string& path)
+	{
+		MappedFile file(path.c_str());
+		DdsImage image;
+		return file.IsOpen() && DdsFile::Parse(file.GetData(), file.GetSize(), image) && image.Cube && image.ArraySize == 6;
+	}
+
+	bool CookMesh(const AssetCookerSettings& settings, const CookStep& step, bool verbose)
+	{
+		std::string sourcePath = settings.SourceRoot + "/" + step.Input;
+		MappedFile file(sourcePath.c_str());
+		if (!file.IsOpen())
+			return false;
+
+		AssetSpan source;
+		source.Data = file.GetData();
+		source.Size = file.GetSize();
+		source.ContentHash = step.InputHash;
+
+		CookedMesh mesh;
+		if (!MeshCooker::Cook(sourcePath.c_str(), &source, settings.Meshes, mesh) ||
+			!MeshCooker::Write((settings.OutputRoot + "/" + step.Output).c_str(), step.InputHash, settings.Meshes, mesh))
+			return false;
+
+		if (verbose)
+			printf("  %-40s -> %s (%zu vertices, %zu LODs)\n", step.Input.c_str(), step.Output.c_str(), mesh.Vertices.size(), mesh.Lods.size());
+		return true;
+	}
+}
+
+const char* AssetCooker::ManifestName = "AssetCooker.manifest";
+
+bool AssetCooker::Run(const AssetCookerSettings& settings, AssetCookStats* stats)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	AssetCookStats local;
+	AssetCookStats& result = stats ? *stats : local;
+	result = AssetCookStats();
+
+	if (!FileSystem::CreateDirectories(settings.OutputRoot))
+		return false;
+
+	std::string manifestPath = settings.OutputRoot + "/" + ManifestName;
+	Manifest manifest;
+	ReadManifest(manifestPath, manifest);
+
+	//Outputs (or the pack) may live inside the source folder - they aren't sources
+	std::string outputPrefix;
+	if (settings.OutputRoot.compare(0, settings.SourceRoot.size() + 1, settings.SourceRoot + "/") == 0)
+		outputPrefix = settings.OutputRoot.substr(settings.SourceRoot.size() + 1) + "/";
+
+	std::vector<std::string> names;
+	FileSystem::ListFiles(settings.SourceRoot, names);
+
+	std::vector<SourceFile> sources;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		const std::string& name = names[i];
+		if ((!outputPrefix.empty() && name.compare(0, outputPrefix.size(), outputPrefix) == 0) ||
+			EndsWith(name, ".pack") || EndsWith(name, ".tmp") || EndsWith(name, ManifestName))
+			continue;
+
+		SourceFile file;
+		file.Name = name;
+		file.Hash = 0;
+		file.Known = false;
+		if (!FileSystem::GetStamp(settings.SourceRoot + "/" + name, file.Stamp))
+			continue;
+
+		//Same size and write time as last run - trust the hash we had
+		std::unordered_map<std::string, SourceFile>::const_iterator old = manifest.Files.find(name);
+		if (old != manifest.Files.end() && old->second.Stamp == file.Stamp)
+		{
+			file.Hash = old->second.Hash;
+			file.Known = true;
+		}
+		sources.push_back(file);
+	}
+
+	//Only changed files get read
+	std::vector<size_t> toHash;
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		if (!sources[i].Known)
+			toHash.push_back(i);
+	}
+
+	ParallelFor(toHash.size(), [&](size_t i)
+	{
+		SourceFile& file = sources[toHash[i]];
+		MappedFile mapped((settings.SourceRoot + "/" + file.Name).c_str());
+		file.Hash = mapped.IsOpen() ? HashBytes(mapped.GetData(), mapped.GetSize()) : 0;
+	});
+
+	result.Sources = sources.size();
+	result.Hashed = toHash.size();
+
+	//What gets cooked from what
+	uint64_t textureSettings = Mix(Mix(Version, 1), (uint64_t)settings.TextureMips);
+	uint64_t meshSettings = Mix(Mix(Mix(Version, 2), (uint64_t)settings.Meshes.Flags()), settings.Meshes.OptionsHash());
+	uint64_t lightingSettings = Mix(Mix(Version, 4), settings.Lighting.Hash());
+	uint64_t fontSettings = Mix(Mix(Version, 5), settings.Fonts.Hash());
+	bool hasSky = false;
+
+	//Every size of a font becomes one distance field font, built from the largest (the most detail to work from)
+	std::unordered_map<std::string, std::string> fontFamilies;		//.spritefont -> the font it's part of
+	std::unordered_map<std::string, std::pair<int, std::string>> fontSources;		//Font -> its largest size and that .spritefont
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		if (!EndsWith(Lower(sources[i].Name), ".spritefont"))
+			continue;
+
+		int size = 0;
+		std::string font = FontFamily(sources[i].Name, size);
+		fontFamilies[sources[i].Name] = font;
+		std::unordered_map<std::string, std::pair<int, std::string>>::iterator largest = fontSources.find(font);
+		if (largest == fontSources.end() || size > largest->second.first)
+			fontSources[font] = std::make_pair(size, sources[i].Name);
+	}
+
+	//Roughness and metalness pairs are one texture each, dirty when either map changes.  Maps in a pair aren't cooked on their own
+	std::unordered_map<std::string, uint64_t> sourceHashes;
+	for (size_t i = 0; i < sources.size(); i++)
+		sourceHashes[sources[i].Name] = sources[i].Hash;
+
+	std::vector<CookStep> steps;
+	std::unordered_set<std::string> packedMaps;
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		if (!EndsWith(Lower(sources[i].Name), "roughnessmetalness.txt"))
+			continue;
+
+		std::vector<std::pair<std::string, std::string>> pairs = ReadPackedPairs(settings, sources[i].Name);
+		for (size_t p = 0; p < pairs.size(); p++)
+		{
+			if (!sourceHashes.count(pairs[p].first) || !sourceHashes.count(pairs[p].second))
+			{
+				printf("AssetCooker: %s: no %s or %s to pack\n", sources[i].Name.c_str(), pairs[p].first.c_str(), pairs[p].second.c_str());
+				continue;
+			}
+
+			CookStep step;
+			step.Kind = StepKind::Texture;
+			step.Texture = TextureKind::RoughnessMetalness;
+			step.Input = pairs[p].first;
+			step.SecondInput = pairs[p].second;
+			step.InputHash = sourceHashes[step.Input];
+			step.Output = DdsFile::GetPackedName(step.Input, step.SecondInput);
+			step.Key = Mix(Mix(Mix(textureSettings, (uint64_t)step.Texture), step.InputHash), sourceHashes[step.SecondInput]);
+			step.Ok = false;
+			step.Seconds = 0.0;
+			steps.push_back(step);
+			packedMaps.insert(step.Input);
+			packedMaps.insert(step.SecondInput);
+		}
+	}
+
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		const SourceFile& file = sources[i];
+		std::string lower = Lower(file.Name);
+
+		CookStep step;
+		step.Input = file.Name;
+		step.InputHash = file.Hash;
+		step.Texture = TextureKind::Albedo;
+		step.Ok = false;
+		step.Seconds = 0.0;
+
+		if (EndsWith(lower, ".png") && !packedMaps.count(file.Name))
+		{
+			step.Kind = StepKind::Texture;
+			step.Texture = TextureKindFor(file.Name);
+			step.Output = file.Name.substr(0, file.Name.size() - 4) + ".dds";
+			step.Key = Mix(Mix(textureSettings, (uint64_t)step.Texture), file.Hash);
+		}
+		else if (EndsWith(lower, ".obj"))
+		{
+			step.Kind = StepKind::Mesh;
+			step.Output = MeshCache::GetCachePath(file.Name.c_str());
+			step.Key = Mix(meshSettings, file.Hash);
+		}
+		else if (fontFamilies.count(file.Name))
+		{
+			const std::string& font = fontFamilies[file.Name];
+			if (fontSources[font].second != file.Name)
+				continue;
+
+			step.Kind = StepKind::Font;
+			step.Output = font;
+			step.Key = Mix(fontSettings, file.Hash);
+		}
+		else if (EndsWith(lower, ".dds") && IsCubeMap(settings.SourceRoot + "/" + file.Name))
+		{
+			//Diffuse and specular are separate outputs, so they cook side by side
+			std::string base = file.Name.substr(0, file.Name.size() - 4);
+			step.Kind = StepKind::Irradiance;
+			step.Output = base + "_irradiance.dds";
+			step.Key = Mix(Mix(lightingSettings, 1), file.Hash);
+			steps.push_back(step);
+
+			step.Kind = StepKind::Specular;
+			step.Output = base + "_specular.dds";
+			step.Key = Mix(Mix(lightingSettings, 2), file.Hash);
+			hasSky = true;
+		}
+		else
+			continue;
+
+		steps.push_back(step);
+	}
+
+	//Every sky shares one BRDF table, which depends on nothing but the settings
+	if (hasSky)
+	{
+		CookStep step;
+		step.Kind = StepKind::Brdf;
+		step.Texture = TextureKind::Albedo;
+		step.Output = "Textures/BrdfLut.dds";
+		step.InputHash = 0;
+		step.Key = Mix(lightingSettings, 3);
+		step.Ok = false;
+		step.Seconds = 0.0;
+		steps.push_back(step);
+	}
+
+	for (size_t i = 0; i < steps.size(); i++)
+	{
+		CookStep& step = steps[i];
+		step.Key = Mix(step.Key, step.Input);
+		if (!step.SecondInput.empty())
+			step.Key = Mix(step.Key, step.SecondInput);
+
+		//Dirty unless the manifest has this exact key and the output is still there, untouched in size
+		std::unordered_map<std::string, ManifestStep>::const_iterator old = manifest.Steps.find(step.Output);
+		FileStamp outputStamp;
+		step.Dirty = settings.Force || old == manifest.Steps.end() || old->second.Key != step.Key ||
+			!FileSystem::GetStamp(settings.OutputRoot + "/" + step.Output, outputStamp) || outputStamp.Size != old->second.Size;
+		step.Ok = !step.Dirty;
+	}
+
+	//Lighting bakes are few and heavy, so they're kept out of the step pool and split across every core themselves
+	std::vector<size_t> dirty, lighting;
+	for (size_t i = 0; i < steps.size(); i++)
+	{
+		if (steps[i].Dirty)
+		{
+			bool isLighting = steps[i].Kind == StepKind::Irradiance || steps[i].Kind == StepKind::Specular || steps[i].Kind == StepKind::Brdf;
+			(isLighting ? lighting : dirty).push_back(i);
+			FileSystem::CreateDirectories(FileSystem::GetDirectory(settings.OutputRoot + "/" + steps[i].Output));
+		}
+	}
+
+	result.Steps = steps.size();
+	result.Skipped = steps.size() - dirty.size() - lighting.size();
+	result.ScanSeconds = SecondsSince(start);
+
+	//Cook - every step is independent.  Work inside a step (blocks, mips) stays on its thread
+	std::chrono::high_resolution_clock::time_point cookStart = std::chrono::high_resolution_clock::now();
+	TextureCompressor::MipKernel = settings.TextureMips;
+	result.Workers = ParallelFor(dirty.size(), [&](size_t i)
+	{
+		CookStep& step = steps[dirty[i]];
+		std::chrono::high_resolution_clock::time_point stepStart = std::chrono::high_resolution_clock::now();
+		step.Ok =
+			step.Kind == StepKind::Texture ? CookTexture(settings, step, settings.Verbose) :
+			step.Kind == StepKind::Mesh ? CookMesh(settings, step, settings.Verbose) :
+			CookFont(settings, step, settings.Verbose);
+		step.Seconds = SecondsSince(stepStart);
+	});
+
+	for (size_t i = 0; i < lighting.size(); i++)
+	{
+		CookStep& step = steps[lighting[i]];
+		std::chrono::high_resolution_clock::time_point stepStart = std::chrono::high_resolution_clock::now();
+		unsigned int workers = 0;
+		step.Ok = CookLighting(settings, step, settings.Verbose, workers);
+		step.Seconds = SecondsSince(stepStart);
+		result.Workers = (std::max)(result.Workers, workers);
+	}
+	result.CookSeconds = SecondsSince(cookStart);
+
+	//Last run's outputs that nothing cooks now - only files the manifest recorded, and never a source
+	std::unordered_set<std::string> stepOutputs, sourcePaths;
+	for (size_t i = 0; i < steps.size(); i++)
+		stepOutputs.insert(steps[i].Output);
+	for (size_t i = 0; i < sources.size(); i++)
+		sourcePaths.insert(settings.SourceRoot + "/" + sources[i].Name);
+	for (std::unordered_map<std::string, ManifestStep>::const_iterator old = manifest.Steps.begin(); old != manifest.Steps.end(); ++old)
+	{
+		std::string path = settings.OutputRoot + "/" + old->first;
+		FileStamp stamp;
+		if (stepOutputs.count(old->first) || sourcePaths.count(path) || !FileSystem::GetStamp(path, stamp))
+			continue;
+
+		if (remove(path.c_str()) != 0)
+		{
+			printf("AssetCooker: couldn't remove %s\n", path.c_str());
+			continue;
+		}
+		result.Removed++;
+		if (settings.Verbose)
+			printf("  %-40s    removed (its source is gone)\n", old->first.c_str());
+	}
+
+	std::unordered_map<std::string, ManifestStep> cookedSteps;
+	std::unordered_set<std::string> outputs;
+	for (size_t i = 0; i < steps.size(); i++)
+	{
+		const CookStep& step = steps[i];
+		result.StepSeconds += step.Seconds;
+		if (step.Dirty)
+			result.Cooked += step.Ok ? 1 : 0;
+
+		FileStamp outputStamp;
+		if (!step.Ok || !FileSystem::GetStamp(settings.OutputRoot + "/" + step.Output, outputStamp))
+		{
+			//Not recorded, so it's tried again next time
+			result.Failed++;
+			printf("AssetCooker: couldn't cook %s\n", step.Output.c_str());
+			continue;
+		}
+
+		ManifestStep record;
+		record.Key = step.Key;
+		record.Size = outputStamp.Size;
+		cookedSteps[step.Output] = record;
+		outputs.insert(AssetPack::NormalizeName(step.Output));
+	}
+
+	//The pack holds every source the game still loads directly plus every output.  Bitmap
+	//fonts are left out once their distance field font is cooked - nothing loads them
+	uint64_t packKey = manifest.PackKey;
+	if (!settings.PackFile.empty())
+	{
+		std::chrono::high_resolution_clock::time_point packStart = std::chrono::high_resolution_clock::now();
+
+		//A cooked output wins over a stale copy of itself among the sources (e.g. a mesh cache the game wrote)
+		AssetPackBuilder pack;
+		packKey = Mix(Version, 3);
+		for (size_t i = 0; i < sources.size(); i++)
+		{
+			if (outputs.count(AssetPack::NormalizeName(sources[i].Name)))
+				continue;
+
+			std::unordered_map<std::string, std::string>::const_iterator font = fontFamilies.find(sources[i].Name);
+			if (font != fontFamilies.end() && outputs.count(AssetPack::NormalizeName(font->second)))
+				continue;
+
+			pack.AddFile(sources[i].Name, settings.SourceRoot + "/" + sources[i].Name);
+			packKey = Mix(Mix(packKey, sources[i].Name), sources[i].Hash);
+		}
+		for (size_t i = 0; i < steps.size(); i++)
+		{
+			std::unordered_map<std::string, ManifestStep>::const_iterator step = cookedSteps.find(steps[i].Output);
+			if (step == cookedSteps.end())
+				continue;
+
+			pack.AddFile(steps[i].Output, settings.OutputRoot + "/" + steps[i].Output);
+			packKey = Mix(Mix(packKey, steps[i].Output), step->second.Key);
+		}
+
+		FileStamp packStamp;
+		if (settings.Force || packKey != manifest.PackKey || !FileSystem::GetStamp(settings.PackFile, packStamp))
+		{
+			AssetPackStats packStats;
+			result.PackWritten = pack.Write(settings.PackFile, &packStats);
+			if (!result.PackWritten)
+			{
+				printf("AssetCooker: couldn't write %s\n", settings.PackFile.c_str());
+				packKey = 0;
+				result.Failed++;
+			}
+			else if (settings.Verbose)
+				AssetPackBuilder::Report(packStats);
+		}
+		result.PackSeconds = SecondsSince(packStart);
+	}
+
+	if (!WriteManifest(manifestPath, sources, cookedSteps, packKey))
+		printf("AssetCooker: couldn't write %s\n", manifestPath.c_str());
+
+	result.WallSeconds = SecondsSince(start);
+	return result.Failed == 0;
+}
+
+void AssetCooker::Report(const AssetCookStats& stats)
+{
+	printf("Cooked %zu of %zu steps (%zu up to date, %zu failed, %zu removed) from %zu sources (%zu re-hashed)%s\n",
+		stats.Cooked, stats.Steps, stats.Skipped, stats.Failed, stats.Removed, stats.Sources, stats.Hashed, stats.PackWritten ? ", pack written" : "");
+	printf("  scan %.2f ms, cook %.2f ms on %u threads (%.2f ms of work), pack %.2f ms, total %.2f ms\n",
+		stats.ScanSeconds * 1000.0, stats.CookSeconds * 1000.0, stats.Workers, stats.StepSeconds * 1000.0,
+		stats.PackSeconds * 1000.0, stats.WallSeconds * 1000.0);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "IblBaker.h"
+#include "MeshCooker.h"
+#include "MipGenerator.h"
+#include "SdfFontBuilder.h"
+
+struct AssetCookerSettings
+{
+	std::string SourceRoot;				// The Assets folder
+	std::string OutputRoot;				// Cooked files go here, under the same relative names
+	std::string PackFile;				// Sources + cooked files as one AssetPack ("" = don't write one)
+	bool Force = false;					// Cook everything, whatever the manifest says
+	bool Verbose = false;				// A line per cooked file
+
+	MeshCookSettings Meshes;			// Has to match Mesh's import settings, or the game re-cooks at load
+	MipFilter TextureMips = MipFilter::Kaiser;
+	IblSettings Lighting;
+	SdfFontSettings Fonts;
+};
+
+struct AssetCookStats
+{
+	size_t Sources = 0;
+	size_t Hashed = 0;					// Sources read because they changed - the rest reuse the manifest's hash
+	size_t Steps = 0;
+	size_t Cooked = 0;
+	size_t Skipped = 0;					// Already up to date
+	size_t Failed = 0;
+	size_t Removed = 0;					// Outputs deleted because nothing cooks them any more (their source is gone)
+	bool PackWritten = false;
+	unsigned int Workers = 0;
+	double ScanSeconds = 0.0;
+	double CookSeconds = 0.0;			// Wall time of the parallel cook
+	double StepSeconds = 0.0;			// Sum of every step's time (what cooking one after another costs)
+	double PackSeconds = 0.0;
+	double WallSeconds = 0.0;
+};
+
+// --------------------------------------------------------
+// Offline, incremental cook of the Assets folder
+//
+// - PNGs become block-compressed DDS files (TextureCompressor;
+//   format picked from the name), OBJs become cooked meshes
+//   (MeshCooker), DDS cube maps get their image lighting
+//   baked (IblBaker) and each family of .spritefonts becomes
+//   one distance field font, built from its largest size
+//   (SdfFontBuilder), then everything goes into an AssetPack
+// - Each pair in a RoughnessMetalness.txt is packed into one
+//   BC5 texture, roughness in red and metalness in green (see
+//   DdsFile::GetPackedName for what it's called).  Maps in a
+//   pair aren't cooked on their own
+// - A manifest in the output folder remembers each source's
+//   size, write time and content hash, and each output's key
+//   (cooker version + settings + its inputs' hashes).  Unchanged
+//   sources aren't read again and up-to-date outputs aren't
+//   touched, so a build with nothing to do only stats files.
+//   Outputs the manifest has that no step makes any more
+//   (their source was deleted or renamed) are deleted too
+// - Steps don't depend on each other, so they all cook at
+//   once on worker threads (see Parallel.h)
+// - No D3D anywhere, so it runs headless on Linux
+//   (see AssetCookerMain.cpp)
+// --------------------------------------------------------
+class AssetCooker
+{
+public:
+	// Bump whenever a step would write something different for the same input
+	static const uint32_t Version = 1;
+
+	// Lives in the output folder
+	static const char* ManifestName;
+
+	// False if anything failed to cook (everything else is still written)
+	static bool Run(const AssetCookerSettings& settings, AssetCookStats* stats = nullptr);
+
+	static void Report(const AssetCookStats& stats);
+};
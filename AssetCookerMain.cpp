@@ -0,0 +1,114 @@
+// --------------------------------------------------------
+// Command line front end for AssetCooker
+//
+// Not part of the game project (it has its own main) - build it
+// on its own, e.g. headless on Linux:
+//
+//   g++ -std=c++14 -O2 -pthread -I<DirectXMath headers> -o AssetCooker
+//       AssetCookerMain.cpp AssetCooker.cpp AssetPack.cpp AssetPackBuilder.cpp
+//       BlockCompressor.cpp DdsFile.cpp FileSystem.cpp IblBaker.cpp ImageDecoder.cpp
+//       Lz4.cpp MappedFile.cpp MeshCache.cpp MeshCooker.cpp MeshOptimizer.cpp
+//       MeshSimplifier.cpp MipGenerator.cpp ObjImporter.cpp SdfFontBuilder.cpp
+//       SdfFontFile.cpp TangentGenerator.cpp TextureCompressor.cpp VertexWelder.cpp
+//
+// Usage:
+//   AssetCooker <Assets folder> [--out <folder>] [--pack <file>] [--no-pack]
+//               [--force] [--verbose] [--box-mips]
+//   AssetCooker --benchmark-ibl [sky.dds] [iterations]
+// --------------------------------------------------------
+#include "AssetCooker.h"
+#include "IblBaker.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace
+{
+	void PrintUsage()
+	{
+		printf("Usage: AssetCooker <Assets folder> [options]\n");
+		printf("  --out <folder>   Where cooked files go (default: <Assets folder>/../Cooked)\n");
+		printf("  --pack <file>    Pack to write (default: <Assets folder>/Assets.pack)\n");
+		printf("  --no-pack        Only cook, don't write a pack\n");
+		printf("  --force          Cook everything, even if it's up to date\n");
+		printf("  --verbose        A line per cooked file\n");
+		printf("  --box-mips       Box filtered mips instead of Kaiser\n");
+		printf("Or: AssetCooker --benchmark-ibl [sky.dds] [iterations]\n");
+		printf("  Times the image lighting bakes on 1, 2, 4 and every core (default: a made-up sky, 3 iterations)\n");
+	}
+
+	// The arguments after --benchmark-ibl, either of which can be left out
+	int BenchmarkIbl(int argc, char* argv[])
+	{
+		std::string source;
+		int iterations = 3;
+		for (int i = 2; i < argc; i++)
+		{
+			if (atoi(argv[i]) > 0)
+				iterations = atoi(argv[i]);
+			else
+				source = argv[i];
+		}
+		return IblBaker::Benchmark(source, AssetCookerSettings().Lighting, iterations) ? 0 : 1;
+	}
+
+	std::string TrimSeparators(std::string path)
+	{
+		while (path.size() > 1 && (path.back() == '/' || path.back() == '\\'))
+			path.pop_back();
+		return path;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "--benchmark-ibl") == 0)
+		return BenchmarkIbl(argc, argv);
+
+	AssetCookerSettings settings;
+	bool pack = true;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		if (strcmp(arg, "--out") == 0 && i + 1 < argc)
+			settings.OutputRoot = TrimSeparators(argv[++i]);
+		else if (strcmp(arg, "--pack") == 0 && i + 1 < argc)
+			settings.PackFile = argv[++i];
+		else if (strcmp(arg, "--no-pack") == 0)
+			pack = false;
+		else if (strcmp(arg, "--force") == 0)
+			settings.Force = true;
+		else if (strcmp(arg, "--verbose") == 0)
+			settings.Verbose = true;
+		else if (strcmp(arg, "--box-mips") == 0)
+			settings.TextureMips = MipFilter::Box;
+		else if (arg[0] != '-' && settings.SourceRoot.empty())
+			settings.SourceRoot = TrimSeparators(arg);
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	if (settings.SourceRoot.empty())
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	if (settings.OutputRoot.empty())
+		settings.OutputRoot = settings.SourceRoot + "/../Cooked";
+	if (!pack)
+		settings.PackFile.clear();
+	else if (settings.PackFile.empty())
+		settings.PackFile = settings.SourceRoot + "/Assets.pack";
+
+	AssetCookStats stats;
+	bool ok = AssetCooker::Run(settings, &stats);
+	AssetCooker::Report(stats);
+	return ok ? 0 : 1;
+}
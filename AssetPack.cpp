@@ -0,0 +1,224 @@
+#include "AssetPack.h"
+#include "Hash.h"
+#include "Lz4.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace
+{
+	const char AssetPackMagic[4] = { 'A', 'P', 'A', 'K' };
+
+	// Section has to lie inside the file (checked so huge counts can't wrap)
+	bool Fits(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+	{
+		return offset <= fileSize && count <= (fileSize - offset) / elementSize;
+	}
+}
+
+AssetPack::AssetPack() :
+	header(nullptr), entries(nullptr), blobs(nullptr), buckets(nullptr), names(nullptr)
+{
+}
+
+AssetPack::AssetPack(const char* fileName) : AssetPack()
+{
+	Open(fileName);
+}
+
+AssetPack::~AssetPack()
+{
+	Close();
+}
+
+// --------------------------------------------------------
+// Maps a pack and checks its table of contents
+//
+// Blob data isn't touched here (that would read the whole
+// pack) - only that every blob lies inside the file
+// --------------------------------------------------------
+bool AssetPack::Open(const char* fileName)
+{
+	Close();
+
+	if (!file.Open(fileName) || file.GetSize() < sizeof(AssetPackHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const unsigned char* data = file.GetData();
+	uint64_t size = file.GetSize();
+	const AssetPackHeader* h = (const AssetPackHeader*)data;
+
+	if (memcmp(h->Magic, AssetPackMagic, 4) != 0 ||
+		h->Version != ASSET_PACK_VERSION ||
+		h->EntryCount == 0 || h->BucketCount == 0 ||
+		h->Alignment == 0 || (h->Alignment & (h->Alignment - 1)) != 0 ||
+		!Fits(h->EntryOffset, h->EntryCount, sizeof(AssetPackEntry), size) ||
+		!Fits(h->BlobOffset, h->BlobCount, sizeof(AssetPackBlob), size) ||
+		!Fits(h->BucketOffset, h->BucketCount, sizeof(uint32_t), size) ||
+		!Fits(h->NameOffset, h->NameBytes, 1, size) ||
+		h->EntryOffset % 8 != 0 || h->BlobOffset % 8 != 0 || h->BucketOffset % 4 != 0 ||
+		h->NameOffset + h->NameBytes < h->EntryOffset)
+	{
+		Close();
+		return false;
+	}
+
+	if (HashBytes(data + h->EntryOffset, (size_t)(h->NameOffset + h->NameBytes - h->EntryOffset)) != h->TocHash)
+	{
+		Close();
+		return false;
+	}
+
+	//Entries have to name a real blob and a real name; blobs have to be inside the file
+	const AssetPackEntry* e = (const AssetPackEntry*)(data + h->EntryOffset);
+	for (uint32_t i = 0; i < h->EntryCount; i++)
+	{
+		if (e[i].Blob >= h->BlobCount || (uint64_t)e[i].NameOffset + e[i].NameLength > h->NameBytes)
+		{
+			Close();
+			return false;
+		}
+	}
+
+	const AssetPackBlob* b = (const AssetPackBlob*)(data + h->BlobOffset);
+	for (uint32_t i = 0; i < h->BlobCount; i++)
+	{
+		bool known = b[i].Compression == ASSET_PACK_STORED || b[i].Compression == ASSET_PACK_LZ4;
+		bool sized = b[i].Compression == ASSET_PACK_LZ4 || b[i].StoredSize == b[i].Size;
+		if (!known || !sized || b[i].Offset % h->Alignment != 0 || !Fits(b[i].Offset, b[i].StoredSize, 1, size))
+		{
+			Close();
+			return false;
+		}
+	}
+
+	header = h;
+	entries = e;
+	blobs = b;
+	buckets = (const uint32_t*)(data + h->BucketOffset);
+	names = (const char*)(data + h->NameOffset);
+	inflated.resize(h->BlobCount);
+	return true;
+}
+
+void AssetPack::Close()
+{
+	file.Close();
+	header = nullptr;
+	entries = nullptr;
+	blobs = nullptr;
+	buckets = nullptr;
+	names = nullptr;
+	inflated.clear();
+}
+
+bool AssetPack::IsOpen()
+{
+	return header != nullptr;
+}
+
+bool AssetPack::Find(const std::string& path, AssetSpan& out)
+{
+	if (!header)
+		return false;
+
+	std::string name = NormalizeName(path);
+	uint64_t hash = HashBytes(name.data(), name.size());
+	uint32_t displacement = buckets[hash % header->BucketCount];
+	const AssetPackEntry& entry = entries[SlotFor(hash, displacement, header->EntryCount)];
+
+	//Every name lands on some slot - make sure it's this one
+	if (entry.NameHash != hash || entry.NameLength != name.size() || memcmp(names + entry.NameOffset, name.data(), name.size()) != 0)
+		return false;
+
+	const AssetPackBlob& blob = blobs[entry.Blob];
+	out.Size = (size_t)blob.Size;
+	out.ContentHash = blob.ContentHash;
+
+	if (blob.Compression == ASSET_PACK_STORED)
+	{
+		out.Data = file.GetData() + blob.Offset;
+		return true;
+	}
+
+	std::lock_guard<std::mutex> lock(inflateMutex);
+	if (!inflated[entry.Blob])
+	{
+		//Checked against the content hash, since a bad block could still decompress to the right size
+		std::unique_ptr<uint8_t[]> bytes(new uint8_t[blob.Size ? (size_t)blob.Size : 1]);
+		if (!Lz4::Decompress(file.GetData() + blob.Offset, (size_t)blob.StoredSize, bytes.get(), (size_t)blob.Size) ||
+			HashBytes(bytes.get(), (size_t)blob.Size) != blob.ContentHash)
+			return false;
+		inflated[entry.Blob] = std::move(bytes);
+	}
+	out.Data = inflated[entry.Blob].get();
+	return true;
+}
+
+size_t AssetPack::GetEntryCount()
+{
+	return header ? header->EntryCount : 0;
+}
+
+size_t AssetPack::GetBlobCount()
+{
+	return header ? header->BlobCount : 0;
+}
+
+std::string AssetPack::NormalizeName(const std::string& path)
+{
+	std::vector<std::string> parts;
+	size_t start = 0;
+	while (start <= path.size())
+	{
+		size_t end = path.find_first_of("/\\", start);
+		if (end == std::string::npos)
+			end = path.size();
+
+		std::string part = path.substr(start, end - start);
+		for (size_t i = 0; i < part.size(); i++)
+			part[i] = (char)tolower((unsigned char)part[i]);
+
+		if (part == "..")
+		{
+			if (!parts.empty() && parts.back() != "..")
+				parts.pop_back();
+			else
+				parts.push_back(part);
+		}
+		else if (!part.empty() && part != ".")
+			parts.push_back(part);
+
+		start = end + 1;
+	}
+
+	//Everything up to the (last) Assets folder is where the game happens to run from
+	size_t first = 0;
+	for (size_t i = 0; i + 1 < parts.size(); i++)
+	{
+		if (parts[i] == "assets")
+			first = i + 1;
+	}
+
+	std::string name;
+	for (size_t i = first; i < parts.size(); i++)
+	{
+		if (!name.empty())
+			name += '/';
+		name += parts[i];
+	}
+	return name;
+}
+
+uint32_t AssetPack::SlotFor(uint64_t nameHash, uint32_t displacement, uint32_t slotCount)
+{
+	//splitmix64's finaliser, so each displacement scatters the bucket's names independently
+	uint64_t x = nameHash + (uint64_t)displacement * 0x9e3779b97f4a7c15ull;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+	x ^= x >> 31;
+	return (uint32_t)(x % slotCount);
+}
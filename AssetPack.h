@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// Bump whenever the layout below changes
+#define ASSET_PACK_VERSION 1
+
+// How a blob's bytes are stored (AssetPackBlob::Compression)
+#define ASSET_PACK_STORED	0
+#define ASSET_PACK_LZ4		1
+
+// --------------------------------------------------------
+// Header at the start of an asset pack
+//
+// File layout:
+//   AssetPackHeader
+//   AssetPackEntry[EntryCount]		(at EntryOffset, in perfect hash slot order)
+//   AssetPackBlob[BlobCount]		(at BlobOffset)
+//   uint32_t[BucketCount]			(at BucketOffset, perfect hash displacements)
+//   char[NameBytes]				(at NameOffset, every name back to back)
+//   blob data						(each blob at a multiple of Alignment)
+//
+// Everything up to the blob data is the table of contents; its
+// hash is stored so a damaged pack is caught when it's opened
+// --------------------------------------------------------
+struct AssetPackHeader
+{
+	char Magic[4];				// "APAK"
+	uint32_t Version;			// ASSET_PACK_VERSION
+	uint32_t EntryCount;
+	uint32_t BlobCount;			// Unique contents - entries with the same bytes share a blob
+	uint32_t BucketCount;
+	uint32_t Alignment;
+	uint64_t EntryOffset;
+	uint64_t BlobOffset;
+	uint64_t BucketOffset;
+	uint64_t NameOffset;
+	uint64_t NameBytes;
+	uint64_t TocHash;			// Hash of everything from EntryOffset to the end of the names
+};
+
+struct AssetPackEntry
+{
+	uint64_t NameHash;			// HashBytes of the normalised name
+	uint32_t NameOffset;		// Into the names
+	uint32_t NameLength;
+	uint32_t Blob;
+	uint32_t Reserved;
+};
+
+struct AssetPackBlob
+{
+	uint64_t Offset;			// From the start of the file
+	uint64_t StoredSize;		// Bytes in the file
+	uint64_t Size;				// Bytes once decompressed
+	uint64_t ContentHash;		// HashBytes of the decompressed bytes
+	uint32_t Compression;		// ASSET_PACK_STORED / ASSET_PACK_LZ4
+	uint32_t Reserved;
+};
+
+// --------------------------------------------------------
+// Bytes of one asset.  Points into the pack - valid until the
+// pack is closed
+// --------------------------------------------------------
+struct AssetSpan
+{
+	const uint8_t* Data = nullptr;
+	size_t Size = 0;
+	uint64_t ContentHash = 0;	// Same hash MeshCache uses for source files
+};
+
+// --------------------------------------------------------
+// Read-only view of an asset pack (see AssetPackBuilder for
+// writing one)
+//
+// - The whole pack is memory mapped; stored entries are handed
+//   out as spans straight into the mapping, so nothing is
+//   copied and only the pages an asset touches are read
+// - Names go through a minimal perfect hash - one hash of the
+//   name, one displacement lookup, one compare
+// - LZ4 entries are decompressed the first time they're asked
+//   for and kept until the pack closes, so their spans stay
+//   valid too.  Safe to call Find from several loader threads
+// --------------------------------------------------------
+class AssetPack
+{
+public:
+	AssetPack();
+	AssetPack(const char* fileName);
+	~AssetPack();
+
+	// Maps the pack and validates its table of contents
+	bool Open(const char* fileName);
+	void Close();
+	bool IsOpen();
+
+	// Looks an asset up by path (see NormalizeName) - false if it isn't in the pack
+	bool Find(const std::string& path, AssetSpan& out);
+
+	size_t GetEntryCount();
+	size_t GetBlobCount();
+
+	// Lower case, forward slashes, "." and ".." resolved, and relative to
+	// the Assets folder, so "C:\...\Assets\Textures\Floor.png" and
+	// "textures/floor.png" name the same entry
+	static std::string NormalizeName(const std::string& path);
+
+	// Which slot a name hash lands in for a bucket's displacement (shared with the builder)
+	static uint32_t SlotFor(uint64_t nameHash, uint32_t displacement, uint32_t slotCount);
+
+private:
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+
+	MappedFile file;
+	const AssetPackHeader* header;
+	const AssetPackEntry* entries;
+	const AssetPackBlob* blobs;
+	const uint32_t* buckets;
+	const char* names;
+
+	//Decompressed copies of LZ4 blobs, made on first use
+	std::mutex inflateMutex;
+	std::vector<std::unique_ptr<uint8_t[]>> inflated;
+};
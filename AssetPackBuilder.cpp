@@ -0,0 +1,325 @@
+#include "AssetPackBuilder.h"
+#include "FileSystem.h"
+#include "Hash.h"
+#include "Lz4.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace
+{
+	const char AssetPackMagic[4] = { 'A', 'P', 'A', 'K' };
+
+	// Give up on a bucket after this many displacements (only happens if two names hash the same)
+	const uint32_t MaxDisplacement = 1u << 20;
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	bool HasExtension(const std::string& name, const char* extension)
+	{
+		size_t length = strlen(extension);
+		return name.size() >= length && name.compare(name.size() - length, length, extension) == 0;
+	}
+}
+
+void AssetPackBuilder::AddFile(const std::string& name, const std::string& path, bool compress)
+{
+	Source source;
+	source.Name = AssetPack::NormalizeName(name);
+	source.Path = path;
+	source.Compress = compress;
+	sources.push_back(source);
+}
+
+void AssetPackBuilder::AddMemory(const std::string& name, const std::vector<uint8_t>& bytes, bool compress)
+{
+	Source source;
+	source.Name = AssetPack::NormalizeName(name);
+	source.Bytes = bytes;
+	source.Compress = compress;
+	sources.push_back(source);
+}
+
+size_t AssetPackBuilder::AddDirectory(const std::string& root, bool compress)
+{
+	std::vector<std::string> files;
+	FileSystem::ListFiles(root, files);
+
+	size_t added = 0;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		//Old packs and half-written files aren't assets
+		if (HasExtension(files[i], ".pack") || HasExtension(files[i], ".tmp"))
+			continue;
+
+		AddFile(files[i], root + "/" + files[i], compress);
+		added++;
+	}
+	return added;
+}
+
+// --------------------------------------------------------
+// Reads every source, merges identical contents, compresses
+// and writes the pack
+//
+// Written to a temporary file first and then renamed over the
+// old one, so a crash mid-write can't leave a half-written pack
+// --------------------------------------------------------
+bool AssetPackBuilder::Write(const std::string& fileName, AssetPackStats* stats)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	AssetPackStats local;
+	AssetPackStats& result = stats ? *stats : local;
+	result = AssetPackStats();
+
+	if (sources.empty())
+		return false;
+
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		if (sources[i].Path.empty())
+			continue;
+
+		MappedFile file(sources[i].Path.c_str());
+		if (!file.IsOpen())
+			return false;
+		sources[i].Bytes.assign(file.GetData(), file.GetData() + file.GetSize());
+	}
+
+	//Names have to be unique, or the lookup couldn't tell them apart
+	std::unordered_map<std::string, size_t> byName;
+	std::vector<uint64_t> nameHashes(sources.size());
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		if (sources[i].Name.empty() || !byName.insert(std::make_pair(sources[i].Name, i)).second)
+			return false;
+		nameHashes[i] = HashBytes(sources[i].Name.data(), sources[i].Name.size());
+	}
+
+	//One blob per distinct content (hash first, then the bytes themselves)
+	std::vector<uint32_t> entryBlob(sources.size());
+	std::vector<size_t> blobSource;
+	std::vector<AssetPackBlob> blobs;
+	std::unordered_map<uint64_t, std::vector<uint32_t>> byContent;
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		const std::vector<uint8_t>& bytes = sources[i].Bytes;
+		uint64_t hash = HashBytes(bytes.data(), bytes.size());
+		result.SourceBytes += bytes.size();
+
+		std::vector<uint32_t>& candidates = byContent[hash];
+		uint32_t blob = (uint32_t)blobs.size();
+		for (size_t c = 0; c < candidates.size(); c++)
+		{
+			if (sources[blobSource[candidates[c]]].Bytes == bytes)
+			{
+				blob = candidates[c];
+				break;
+			}
+		}
+
+		if (blob == blobs.size())
+		{
+			AssetPackBlob b = {};
+			b.Size = bytes.size();
+			b.StoredSize = bytes.size();
+			b.ContentHash = hash;
+			b.Compression = ASSET_PACK_STORED;
+			blobs.push_back(b);
+			blobSource.push_back(i);
+			candidates.push_back(blob);
+		}
+		else
+			result.Duplicates++;
+
+		//Any entry sharing a blob can ask for it to be compressed
+		if (sources[i].Compress)
+			blobs[blob].Compression = ASSET_PACK_LZ4;
+		entryBlob[i] = blob;
+	}
+
+	//Compress on worker threads; only keep it where it actually pays
+	std::vector<std::vector<uint8_t>> packed(blobs.size());
+	ParallelFor(blobs.size(), [&](size_t b)
+	{
+		if (blobs[b].Compression != ASSET_PACK_LZ4)
+			return;
+
+		const std::vector<uint8_t>& bytes = sources[blobSource[b]].Bytes;
+		packed[b].resize(Lz4::CompressBound(bytes.size()));
+		size_t size = Lz4::Compress(bytes.data(), bytes.size(), packed[b].data(), packed[b].size());
+		if (size == 0 || size > bytes.size() - bytes.size() / 8)
+		{
+			blobs[b].Compression = ASSET_PACK_STORED;
+			packed[b].clear();
+			return;
+		}
+		packed[b].resize(size);
+		blobs[b].StoredSize = size;
+	});
+
+	std::vector<uint32_t> buckets, slots;
+	if (!BuildPerfectHash(nameHashes, buckets, slots))
+		return false;
+
+	std::string nameData;
+	std::vector<AssetPackEntry> entries(sources.size());
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		AssetPackEntry& entry = entries[slots[i]];
+		entry.NameHash = nameHashes[i];
+		entry.NameOffset = (uint32_t)nameData.size();
+		entry.NameLength = (uint32_t)sources[i].Name.size();
+		entry.Blob = entryBlob[i];
+		nameData += sources[i].Name;
+	}
+
+	AssetPackHeader header = {};
+	memcpy(header.Magic, AssetPackMagic, 4);
+	header.Version = ASSET_PACK_VERSION;
+	header.EntryCount = (uint32_t)entries.size();
+	header.BlobCount = (uint32_t)blobs.size();
+	header.BucketCount = (uint32_t)buckets.size();
+	header.Alignment = Alignment;
+	header.EntryOffset = AlignUp(sizeof(AssetPackHeader), 8);
+	header.BlobOffset = header.EntryOffset + entries.size() * sizeof(AssetPackEntry);
+	header.BucketOffset = header.BlobOffset + blobs.size() * sizeof(AssetPackBlob);
+	header.NameOffset = header.BucketOffset + buckets.size() * sizeof(uint32_t);
+	header.NameBytes = nameData.size();
+
+	uint64_t offset = AlignUp(header.NameOffset + header.NameBytes, Alignment);
+	for (size_t b = 0; b < blobs.size(); b++)
+	{
+		blobs[b].Offset = offset;
+		offset = AlignUp(offset + blobs[b].StoredSize, Alignment);
+		result.Compressed += blobs[b].Compression == ASSET_PACK_LZ4 ? 1 : 0;
+	}
+
+	//Table of contents as one block, so it can be hashed the way the reader sees it
+	std::vector<uint8_t> toc((size_t)(header.NameOffset + header.NameBytes - header.EntryOffset));
+	uint8_t* t = toc.data();
+	memcpy(t, entries.data(), entries.size() * sizeof(AssetPackEntry));
+	t += entries.size() * sizeof(AssetPackEntry);
+	memcpy(t, blobs.data(), blobs.size() * sizeof(AssetPackBlob));
+	t += blobs.size() * sizeof(AssetPackBlob);
+	memcpy(t, buckets.data(), buckets.size() * sizeof(uint32_t));
+	t += buckets.size() * sizeof(uint32_t);
+	memcpy(t, nameData.data(), nameData.size());
+	header.TocHash = HashBytes(toc.data(), toc.size());
+
+	std::string tempFile = fileName + ".tmp";
+	{
+		std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+			return false;
+
+		std::vector<char> padding(Alignment, 0);
+		out.write((const char*)&header, sizeof(header));
+		out.write(padding.data(), header.EntryOffset - sizeof(header));
+		out.write((const char*)toc.data(), toc.size());
+
+		uint64_t written = header.NameOffset + header.NameBytes;
+		for (size_t b = 0; b < blobs.size(); b++)
+		{
+			out.write(padding.data(), blobs[b].Offset - written);
+			if (blobs[b].Compression == ASSET_PACK_LZ4)
+				out.write((const char*)packed[b].data(), packed[b].size());
+			else
+				out.write((const char*)sources[blobSource[b]].Bytes.data(), blobs[b].StoredSize);
+			written = blobs[b].Offset + blobs[b].StoredSize;
+		}
+		if (!out.good())
+			return false;
+
+		result.PackBytes = (size_t)written;
+	}
+
+	//rename() won't replace an existing file on Windows
+	remove(fileName.c_str());
+	if (rename(tempFile.c_str(), fileName.c_str()) != 0)
+	{
+		remove(tempFile.c_str());
+		return false;
+	}
+
+	result.Entries = entries.size();
+	result.Blobs = blobs.size();
+	result.Seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	return true;
+}
+
+void AssetPackBuilder::Report(const AssetPackStats& stats)
+{
+	printf("Asset pack: %zu entries in %zu blobs (%zu duplicates merged, %zu compressed), %.1f KB -> %.1f KB in %.2f ms\n",
+		stats.Entries, stats.Blobs, stats.Duplicates, stats.Compressed,
+		stats.SourceBytes / 1024.0, stats.PackBytes / 1024.0, stats.Seconds * 1000.0);
+}
+
+// --------------------------------------------------------
+// Hash and displace: names are split into buckets by hash, and
+// each bucket (largest first) gets the first displacement that
+// puts all of its names into free slots.  Slots = names, so the
+// entry table has no holes
+// --------------------------------------------------------
+bool AssetPackBuilder::BuildPerfectHash(const std::vector<uint64_t>& hashes, std::vector<uint32_t>& buckets, std::vector<uint32_t>& slots)
+{
+	uint32_t count = (uint32_t)hashes.size();
+	uint32_t bucketCount = (count + 1) / 2;
+	buckets.assign(bucketCount, 0);
+	slots.assign(count, 0);
+
+	std::vector<std::vector<uint32_t>> members(bucketCount);
+	for (uint32_t i = 0; i < count; i++)
+		members[hashes[i] % bucketCount].push_back(i);
+
+	std::vector<uint32_t> order(bucketCount);
+	for (uint32_t b = 0; b < bucketCount; b++)
+		order[b] = b;
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return members[a].size() > members[b].size(); });
+
+	std::vector<bool> taken(count, false);
+	std::vector<uint32_t> tried;
+	for (uint32_t o = 0; o < bucketCount; o++)
+	{
+		const std::vector<uint32_t>& keys = members[order[o]];
+		if (keys.empty())
+			break;
+
+		bool placed = false;
+		for (uint32_t d = 0; d < MaxDisplacement && !placed; d++)
+		{
+			tried.clear();
+			for (size_t k = 0; k < keys.size(); k++)
+			{
+				uint32_t slot = AssetPack::SlotFor(hashes[keys[k]], d, count);
+				if (taken[slot] || std::find(tried.begin(), tried.end(), slot) != tried.end())
+					break;
+				tried.push_back(slot);
+			}
+
+			if (tried.size() != keys.size())
+				continue;
+
+			for (size_t k = 0; k < keys.size(); k++)
+			{
+				taken[tried[k]] = true;
+				slots[keys[k]] = tried[k];
+			}
+			buckets[order[o]] = d;
+			placed = true;
+		}
+
+		if (!placed)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+
+struct AssetPackStats
+{
+	size_t Entries = 0;
+	size_t Blobs = 0;
+	size_t Duplicates = 0;			// Entries whose bytes were already in the pack
+	size_t Compressed = 0;			// Blobs stored as LZ4
+	size_t SourceBytes = 0;			// Every entry's bytes, duplicates included
+	size_t PackBytes = 0;
+	double Seconds = 0.0;
+};
+
+// --------------------------------------------------------
+// Writes an asset pack (see AssetPack for the layout)
+//
+// - Entries with identical contents are stored once
+// - Compression is only kept where it saves at least an
+//   eighth - PNGs and block-compressed DDS files are stored
+//   as they are, since LZ4 gains nothing on them
+// - The name lookup is a hash-and-displace minimal perfect
+//   hash, built once here so the reader never probes
+// --------------------------------------------------------
+class AssetPackBuilder
+{
+public:
+	// Alignment of every blob in the file (a page, so each one maps on its own)
+	static const uint32_t Alignment = 4096;
+
+	// name is normalised (see AssetPack::NormalizeName); the file is read by Write
+	void AddFile(const std::string& name, const std::string& path, bool compress = true);
+	void AddMemory(const std::string& name, const std::vector<uint8_t>& bytes, bool compress = true);
+
+	// Every file under root, named by its path relative to root.  Returns how many were added
+	size_t AddDirectory(const std::string& root, bool compress = true);
+
+	bool Write(const std::string& fileName, AssetPackStats* stats = nullptr);
+
+	static void Report(const AssetPackStats& stats);
+
+private:
+	struct Source
+	{
+		std::string Name;
+		std::string Path;				// Empty for AddMemory
+		std::vector<uint8_t> Bytes;
+		bool Compress;
+	};
+
+	std::vector<Source> sources;
+
+	static bool BuildPerfectHash(const std::vector<uint64_t>& hashes, std::vector<uint32_t>& buckets, std::vector<uint32_t>& slots);
+};
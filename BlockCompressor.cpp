@@ -0,0 +1,702 @@
+#include "BlockCompressor.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace
+{
+	// Times the endpoints get refit to the indices they produced
+	const int RefineIterations = 3;
+
+	// Interpolation weights (out of 64) for BC7's 4-bit indices
+	const int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Weight of the second endpoint for each BC1 (4 colour mode) index
+	const float BC1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	// Weight of the second endpoint for each BC4 (8 value mode) index
+	const float BC4Weights[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+
+	// --------------------------------------------------------
+	// A block as floats - per pixel for fitting, and as four
+	// groups of four pixels per channel for the SSE index search
+	// --------------------------------------------------------
+	struct BlockPixels
+	{
+		float values[16][4];
+		__m128 lanes[4][4];		// [channel][group]
+	};
+
+	void LoadBlock(const uint8_t* rgba, BlockPixels& block)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 4; c++)
+				block.values[i][c] = rgba[i * 4 + c];
+		}
+
+		for (int c = 0; c < 4; c++)
+		{
+			for (int g = 0; g < 4; g++)
+				block.lanes[c][g] = _mm_setr_ps(block.values[g * 4][c], block.values[g * 4 + 1][c], block.values[g * 4 + 2][c], block.values[g * 4 + 3][c]);
+		}
+	}
+
+	// --------------------------------------------------------
+	// Picks the closest palette entry for every pixel (squared
+	// distance over the first `channels` channels) and returns
+	// the block's total squared error
+	// --------------------------------------------------------
+	float FindIndices(const BlockPixels& block, const float (*palette)[4], int count, int channels, uint8_t* indices)
+	{
+		float total = 0.0f;
+		for (int g = 0; g < 4; g++)
+		{
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128 bestIndex = _mm_setzero_ps();
+
+			for (int e = 0; e < count; e++)
+			{
+				__m128 distance = _mm_setzero_ps();
+				for (int c = 0; c < channels; c++)
+				{
+					__m128 diff = _mm_sub_ps(block.lanes[c][g], _mm_set1_ps(palette[e][c]));
+					distance = _mm_add_ps(distance, _mm_mul_ps(diff, diff));
+				}
+
+				__m128 closer = _mm_cmplt_ps(distance, best);
+				best = _mm_min_ps(distance, best);
+				bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps((float)e)), _mm_andnot_ps(closer, bestIndex));
+			}
+
+			float errors[4], chosen[4];
+			_mm_storeu_ps(errors, best);
+			_mm_storeu_ps(chosen, bestIndex);
+			for (int k = 0; k < 4; k++)
+			{
+				indices[g * 4 + k] = (uint8_t)chosen[k];
+				total += errors[k];
+			}
+		}
+		return total;
+	}
+
+	// --------------------------------------------------------
+	// Endpoints at either end of the block's spread along its
+	// principal axis (power iteration on the covariance)
+	// --------------------------------------------------------
+	void FitEndpoints(const BlockPixels& block, int channels, float* e0, float* e1)
+	{
+		float mean[4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < channels; c++)
+				mean[c] += block.values[i][c] / 16.0f;
+		}
+
+		float covariance[4][4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			for (int a = 0; a < channels; a++)
+			{
+				for (int b = 0; b < channels; b++)
+					covariance[a][b] += (block.values[i][a] - mean[a]) * (block.values[i][b] - mean[b]);
+			}
+		}
+
+		float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			float length = 0.0f;
+			for (int a = 0; a < channels; a++)
+			{
+				for (int b = 0; b < channels; b++)
+					next[a] += covariance[a][b] * axis[b];
+				length = (std::max)(length, fabsf(next[a]));
+			}
+
+			//Flat block - any axis will do
+			if (length < 1e-6f)
+				break;
+			for (int a = 0; a < channels; a++)
+				axis[a] = next[a] / length;
+		}
+
+		float axisLengthSq = 0.0f;
+		for (int c = 0; c < channels; c++)
+			axisLengthSq += axis[c] * axis[c];
+
+		float minT = FLT_MAX, maxT = -FLT_MAX;
+		for (int i = 0; i < 16; i++)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < channels; c++)
+				t += (block.values[i][c] - mean[c]) * axis[c];
+			t /= axisLengthSq;
+			minT = (std::min)(minT, t);
+			maxT = (std::max)(maxT, t);
+		}
+
+		for (int c = 0; c < channels; c++)
+		{
+			e0[c] = (std::min)(255.0f, (std::max)(0.0f, mean[c] + axis[c] * minT));
+			e1[c] = (std::min)(255.0f, (std::max)(0.0f, mean[c] + axis[c] * maxT));
+		}
+	}
+
+	// --------------------------------------------------------
+	// Least squares endpoints for a fixed set of indices, where
+	// each pixel is (1 - w) * e0 + w * e1.  False if every pixel
+	// uses the same weight (nothing to solve)
+	// --------------------------------------------------------
+	bool RefineEndpoints(const BlockPixels& block, int channels, const uint8_t* indices, const float* weights, float* e0, float* e1)
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			float w = weights[indices[i]];
+			float a = 1.0f - w;
+			aa += a * a;
+			ab += a * w;
+			bb += w * w;
+			for (int c = 0; c < channels; c++)
+			{
+				ax[c] += a * block.values[i][c];
+				bx[c] += w * block.values[i][c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (fabsf(determinant) < 1e-6f)
+			return false;
+
+		for (int c = 0; c < channels; c++)
+		{
+			e0[c] = (std::min)(255.0f, (std::max)(0.0f, (bb * ax[c] - ab * bx[c]) / determinant));
+			e1[c] = (std::min)(255.0f, (std::max)(0.0f, (aa * bx[c] - ab * ax[c]) / determinant));
+		}
+		return true;
+	}
+
+	// --------------------------------------------------------
+	// Bit packing (little endian, lowest bit first)
+	// --------------------------------------------------------
+	void PutBits(uint8_t* out, int& position, uint32_t value, int count)
+	{
+		for (int i = 0; i < count; i++, position++)
+		{
+			if ((value >> i) & 1)
+				out[position >> 3] |= (uint8_t)(1 << (position & 7));
+		}
+	}
+
+	uint32_t GetBits(const uint8_t* in, int& position, int count)
+	{
+		uint32_t value = 0;
+		for (int i = 0; i < count; i++, position++)
+			value |= (uint32_t)((in[position >> 3] >> (position & 7)) & 1) << i;
+		return value;
+	}
+
+	// --------------------------------------------------------
+	// BC1 helpers
+	// --------------------------------------------------------
+	uint16_t To565(const float* color)
+	{
+		int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+		int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+		int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	void From565(uint16_t packed, int* color)
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// Palette for c0 > c1 (4 colours), or the 3 colours + black mode otherwise
+	void BC1Palette(uint16_t c0, uint16_t c1, int palette[4][4])
+	{
+		From565(c0, palette[0]);
+		From565(c1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			if (c0 > c1)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c] + 1) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		for (int i = 0; i < 4; i++)
+			palette[i][3] = 255;
+	}
+
+	// --------------------------------------------------------
+	// BC4 helpers
+	// --------------------------------------------------------
+	void BC4Palette(int e0, int e1, int palette[8])
+	{
+		palette[0] = e0;
+		palette[1] = e1;
+		if (e0 > e1)
+		{
+			for (int i = 2; i < 8; i++)
+				palette[i] = ((8 - i) * e0 + (i - 1) * e1 + 3) / 7;
+		}
+		else
+		{
+			for (int i = 2; i < 6; i++)
+				palette[i] = ((6 - i) * e0 + (i - 1) * e1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	// Nearest palette entry for each value, returns the squared error
+	int BC4Indices(const int* values, const int* palette, uint8_t* indices)
+	{
+		int total = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			int best = INT32_MAX;
+			for (int e = 0; e < 8; e++)
+			{
+				int d = (values[i] - palette[e]) * (values[i] - palette[e]);
+				if (d < best)
+				{
+					best = d;
+					indices[i] = (uint8_t)e;
+				}
+			}
+			total += best;
+		}
+		return total;
+	}
+
+	// --------------------------------------------------------
+	// BC7 mode 6 helpers - endpoints are 7 bits plus a shared
+	// low bit (the p-bit) per endpoint
+	// --------------------------------------------------------
+	int QuantizeBC7(float value, int pBit)
+	{
+		int q = (int)floorf((value - pBit) / 2.0f + 0.5f);
+		return (std::min)(127, (std::max)(0, q));
+	}
+
+	void BC7Palette(const int* q0, const int* q1, int p0, int p1, float palette[16][4])
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			int a = (q0[c] << 1) | p0;
+			int b = (q1[c] << 1) | p1;
+			for (int i = 0; i < 16; i++)
+				palette[i][c] = (float)(((64 - BC7Weights[i]) * a + BC7Weights[i] * b + 32) >> 6);
+		}
+	}
+
+	// Gathers the 4x4 block at (bx, by), repeating the last row/column past the edges
+	void GatherBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, uint8_t* block)
+	{
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			uint32_t sy = (std::min)(by * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				uint32_t sx = (std::min)(bx * 4 + x, width - 1);
+				memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+			}
+		}
+	}
+}
+
+size_t BlockCompressor::BlockBytes(BlockFormat format)
+{
+	return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+size_t BlockCompressor::CompressedSize(BlockFormat format, uint32_t width, uint32_t height)
+{
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format);
+}
+
+int BlockCompressor::ChannelCount(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1: return 3;
+	case BlockFormat::BC4: return 1;
+	case BlockFormat::BC5: return 2;
+	default: return 4;
+	}
+}
+
+uint32_t BlockCompressor::DxgiFormat(BlockFormat format, bool srgb)
+{
+	//DXGI_FORMAT_BC1_UNORM(_SRGB), BC4_UNORM, BC5_UNORM, BC7_UNORM(_SRGB)
+	switch (format)
+	{
+	case BlockFormat::BC1: return srgb ? 72 : 71;
+	case BlockFormat::BC4: return 80;
+	case BlockFormat::BC5: return 83;
+	default: return srgb ? 99 : 98;
+	}
+}
+
+// --------------------------------------------------------
+// BC1: two RGB565 endpoints and 2-bit indices.  Always uses
+// the 4 colour mode, so there's no punch-through alpha
+// --------------------------------------------------------
+void BlockCompressor::EncodeBC1(const uint8_t* rgba, uint8_t* out)
+{
+	BlockPixels block;
+	LoadBlock(rgba, block);
+
+	float e0[4], e1[4];
+	FitEndpoints(block, 3, e0, e1);
+
+	float bestError = FLT_MAX;
+	uint16_t bestC0 = 0, bestC1 = 0;
+	uint8_t bestIndices[16] = {};
+
+	for (int iteration = 0; iteration < RefineIterations; iteration++)
+	{
+		uint16_t c0 = To565(e0);
+		uint16_t c1 = To565(e1);
+
+		//Evaluate as 4 colour mode regardless of order - swapped below if needed
+		int palette[4][4];
+		BC1Palette((std::max)(c0, c1), (std::min)(c0, c1), palette);
+		if (c0 < c1)
+		{
+			std::swap(palette[0], palette[1]);
+			std::swap(palette[2], palette[3]);
+		}
+
+		float paletteF[4][4];
+		for (int i = 0; i < 4; i++)
+		{
+			for (int c = 0; c < 4; c++)
+				paletteF[i][c] = (float)palette[i][c];
+		}
+
+		uint8_t indices[16];
+		float error = FindIndices(block, paletteF, c0 == c1 ? 1 : 4, 3, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			bestC0 = c0;
+			bestC1 = c1;
+			memcpy(bestIndices, indices, sizeof(indices));
+		}
+
+		if (error == 0.0f || !RefineEndpoints(block, 3, indices, BC1Weights, e0, e1))
+			break;
+	}
+
+	//c0 > c1 selects 4 colour mode; swapping the endpoints swaps index pairs 0/1 and 2/3
+	if (bestC0 < bestC1)
+	{
+		std::swap(bestC0, bestC1);
+		for (int i = 0; i < 16; i++)
+			bestIndices[i] ^= 1;
+	}
+
+	memset(out, 0, 8);
+	out[0] = (uint8_t)(bestC0 & 0xFF);
+	out[1] = (uint8_t)(bestC0 >> 8);
+	out[2] = (uint8_t)(bestC1 & 0xFF);
+	out[3] = (uint8_t)(bestC1 >> 8);
+
+	//Equal endpoints are 3 colour mode, where only index 0 is safe
+	if (bestC0 == bestC1)
+		return;
+
+	int position = 32;
+	for (int i = 0; i < 16; i++)
+		PutBits(out, position, bestIndices[i], 2);
+}
+
+// --------------------------------------------------------
+// BC4: two 8-bit endpoints and 3-bit indices, always in the
+// 8 value mode (e0 > e1)
+// --------------------------------------------------------
+void BlockCompressor::EncodeBC4(const uint8_t* rgba, int channel, uint8_t* out)
+{
+	int values[16];
+	int low = 255, high = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		values[i] = rgba[i * 4 + channel];
+		low = (std::min)(low, values[i]);
+		high = (std::max)(high, values[i]);
+	}
+
+	memset(out, 0, 8);
+	if (low == high)
+	{
+		out[0] = out[1] = (uint8_t)low;
+		return;
+	}
+
+	int e0 = high, e1 = low;
+	int palette[8];
+	uint8_t indices[16];
+	BC4Palette(e0, e1, palette);
+	int error = BC4Indices(values, palette, indices);
+
+	//One least squares pass - kept only if it stays in 8 value mode and helps
+	BlockPixels block;
+	for (int i = 0; i < 16; i++)
+		block.values[i][0] = (float)values[i];
+	float r0, r1;
+	if (RefineEndpoints(block, 1, indices, BC4Weights, &r0, &r1))
+	{
+		int f0 = (int)(r0 + 0.5f), f1 = (int)(r1 + 0.5f);
+		if (f0 > f1)
+		{
+			int refinedPalette[8];
+			uint8_t refinedIndices[16];
+			BC4Palette(f0, f1, refinedPalette);
+			int refinedError = BC4Indices(values, refinedPalette, refinedIndices);
+			if (refinedError < error)
+			{
+				e0 = f0;
+				e1 = f1;
+				memcpy(indices, refinedIndices, sizeof(indices));
+			}
+		}
+	}
+
+	out[0] = (uint8_t)e0;
+	out[1] = (uint8_t)e1;
+	int position = 16;
+	for (int i = 0; i < 16; i++)
+		PutBits(out, position, indices[i], 3);
+}
+
+void BlockCompressor::EncodeBC5(const uint8_t* rgba, uint8_t* out)
+{
+	EncodeBC4(rgba, 0, out);
+	EncodeBC4(rgba, 1, out + 8);
+}
+
+// --------------------------------------------------------
+// BC7 mode 6: one subset, RGBA 7.7.7.7 endpoints each with a
+// p-bit, and 4-bit indices.  Every p-bit combination is tried
+// for each refinement of the endpoints
+// --------------------------------------------------------
+void BlockCompressor::EncodeBC7(const uint8_t* rgba, uint8_t* out)
+{
+	BlockPixels block;
+	LoadBlock(rgba, block);
+
+	float e0[4], e1[4];
+	FitEndpoints(block, 4, e0, e1);
+
+	float weights[16];
+	for (int i = 0; i < 16; i++)
+		weights[i] = BC7Weights[i] / 64.0f;
+
+	float bestError = FLT_MAX;
+	int bestQ0[4] = {}, bestQ1[4] = {};
+	int bestP0 = 0, bestP1 = 0;
+	uint8_t bestIndices[16] = {};
+
+	for (int iteration = 0; iteration < RefineIterations; iteration++)
+	{
+		float iterationError = FLT_MAX;
+		uint8_t iterationIndices[16] = {};
+
+		for (int pBits = 0; pBits < 4; pBits++)
+		{
+			int p0 = pBits & 1, p1 = pBits >> 1;
+			int q0[4], q1[4];
+			for (int c = 0; c < 4; c++)
+			{
+				q0[c] = QuantizeBC7(e0[c], p0);
+				q1[c] = QuantizeBC7(e1[c], p1);
+			}
+
+			float palette[16][4];
+			BC7Palette(q0, q1, p0, p1, palette);
+
+			uint8_t indices[16];
+			float error = FindIndices(block, palette, 16, 4, indices);
+			if (error < iterationError)
+			{
+				iterationError = error;
+				memcpy(iterationIndices, indices, sizeof(indices));
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				memcpy(bestQ0, q0, sizeof(q0));
+				memcpy(bestQ1, q1, sizeof(q1));
+				bestP0 = p0;
+				bestP1 = p1;
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+		}
+
+		if (bestError == 0.0f || !RefineEndpoints(block, 4, iterationIndices, weights, e0, e1))
+			break;
+	}
+
+	//The first pixel's index drops its top bit, so it has to be < 8
+	if (bestIndices[0] >= 8)
+	{
+		for (int c = 0; c < 4; c++)
+			std::swap(bestQ0[c], bestQ1[c]);
+		std::swap(bestP0, bestP1);
+		for (int i = 0; i < 16; i++)
+			bestIndices[i] = (uint8_t)(15 - bestIndices[i]);
+	}
+
+	memset(out, 0, 16);
+	int position = 0;
+	PutBits(out, position, 1 << 6, 7);
+	for (int c = 0; c < 4; c++)
+	{
+		PutBits(out, position, (uint32_t)bestQ0[c], 7);
+		PutBits(out, position, (uint32_t)bestQ1[c], 7);
+	}
+	PutBits(out, position, (uint32_t)bestP0, 1);
+	PutBits(out, position, (uint32_t)bestP1, 1);
+	for (int i = 0; i < 16; i++)
+		PutBits(out, position, bestIndices[i], i == 0 ? 3 : 4);
+}
+
+void BlockCompressor::DecodeBlock(BlockFormat format, const uint8_t* block, uint8_t* rgba)
+{
+	memset(rgba, 0, 64);
+	for (int i = 0; i < 16; i++)
+		rgba[i * 4 + 3] = 255;
+
+	switch (format)
+	{
+	case BlockFormat::BC1:
+	{
+		uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+		uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+		int palette[4][4];
+		BC1Palette(c0, c1, palette);
+		if (c0 <= c1)
+			palette[3][3] = 0;
+
+		int position = 32;
+		for (int i = 0; i < 16; i++)
+		{
+			uint32_t index = GetBits(block, position, 2);
+			for (int c = 0; c < 4; c++)
+				rgba[i * 4 + c] = (uint8_t)palette[index][c];
+		}
+		break;
+	}
+	case BlockFormat::BC4:
+	case BlockFormat::BC5:
+	{
+		int channels = format == BlockFormat::BC5 ? 2 : 1;
+		for (int channel = 0; channel < channels; channel++)
+		{
+			const uint8_t* part = block + channel * 8;
+			int palette[8];
+			BC4Palette(part[0], part[1], palette);
+
+			int position = 16;
+			for (int i = 0; i < 16; i++)
+				rgba[i * 4 + channel] = (uint8_t)palette[GetBits(part, position, 3)];
+		}
+		break;
+	}
+	case BlockFormat::BC7:
+	{
+		//Anything but mode 6 (lowest set bit = bit 6) isn't something we write
+		if ((block[0] & 0x7F) != 0x40)
+			break;
+
+		int position = 7;
+		int q0[4], q1[4];
+		for (int c = 0; c < 4; c++)
+		{
+			q0[c] = (int)GetBits(block, position, 7);
+			q1[c] = (int)GetBits(block, position, 7);
+		}
+		int p0 = (int)GetBits(block, position, 1);
+		int p1 = (int)GetBits(block, position, 1);
+
+		float palette[16][4];
+		BC7Palette(q0, q1, p0, p1, palette);
+		for (int i = 0; i < 16; i++)
+		{
+			uint32_t index = GetBits(block, position, i == 0 ? 3 : 4);
+			for (int c = 0; c < 4; c++)
+				rgba[i * 4 + c] = (uint8_t)palette[index][c];
+		}
+		break;
+	}
+	}
+}
+
+unsigned int BlockCompressor::CompressImage(const uint8_t* rgba, uint32_t width, uint32_t height, BlockFormat format, uint8_t* out)
+{
+	uint32_t blocksX = (width + 3) / 4;
+	uint32_t blocksY = (height + 3) / 4;
+	size_t blockBytes = BlockBytes(format);
+
+	return ParallelForRange(blocksY, 4, [&](size_t begin, size_t end, unsigned int)
+	{
+		uint8_t pixels[64];
+		for (size_t by = begin; by < end; by++)
+		{
+			for (uint32_t bx = 0; bx < blocksX; bx++)
+			{
+				GatherBlock(rgba, width, height, bx, (uint32_t)by, pixels);
+				uint8_t* dst = out + (by * blocksX + bx) * blockBytes;
+				switch (format)
+				{
+				case BlockFormat::BC1: EncodeBC1(pixels, dst); break;
+				case BlockFormat::BC4: EncodeBC4(pixels, 0, dst); break;
+				case BlockFormat::BC5: EncodeBC5(pixels, dst); break;
+				case BlockFormat::BC7: EncodeBC7(pixels, dst); break;
+				}
+			}
+		}
+	});
+}
+
+void BlockCompressor::DecompressImage(const uint8_t* blocks, uint32_t width, uint32_t height, BlockFormat format, uint8_t* rgba)
+{
+	uint32_t blocksX = (width + 3) / 4;
+	uint32_t blocksY = (height + 3) / 4;
+	size_t blockBytes = BlockBytes(format);
+
+	uint8_t pixels[64];
+	for (uint32_t by = 0; by < blocksY; by++)
+	{
+		for (uint32_t bx = 0; bx < blocksX; bx++)
+		{
+			DecodeBlock(format, blocks + ((size_t)by * blocksX + bx) * blockBytes, pixels);
+			for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++)
+			{
+				for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++)
+					memcpy(rgba + ((size_t)(by * 4 + y) * width + bx * 4 + x) * 4, pixels + (y * 4 + x) * 4, 4);
+			}
+		}
+	}
+}
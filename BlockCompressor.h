@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// --------------------------------------------------------
+// Block-compressed texture formats the encoder can write
+// --------------------------------------------------------
+enum class BlockFormat
+{
+	BC1,		// RGB, 8 bytes per 4x4 block
+	BC4,		// One channel (R), 8 bytes per block
+	BC5,		// Two channels (RG), 16 bytes per block
+	BC7			// RGBA, 16 bytes per block
+};
+
+// --------------------------------------------------------
+// CPU BC1/BC4/BC5/BC7 encoder (and decoder, for measuring
+// what the encoding lost)
+//
+// - Endpoints start on the block's principal axis and are then
+//   refined by least squares against the chosen indices
+// - Index search is SSE, four pixels at a time
+// - BC7 only writes mode 6 (one RGBA subset, 4-bit indices),
+//   which suits our mostly smooth, single-colour textures and
+//   is the only mode DecodeBlock understands
+// - Whole images are encoded a row of blocks per task on
+//   worker threads
+//
+// Pixels are RGBA8.  A block is 16 pixels, row by row
+// --------------------------------------------------------
+class BlockCompressor
+{
+public:
+	static size_t BlockBytes(BlockFormat format);
+	static size_t CompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+	// How many channels (from R on) the format keeps
+	static int ChannelCount(BlockFormat format);
+
+	// The matching DXGI_FORMAT value
+	static uint32_t DxgiFormat(BlockFormat format, bool srgb);
+
+	static void EncodeBC1(const uint8_t* rgba, uint8_t* out);
+	static void EncodeBC4(const uint8_t* rgba, int channel, uint8_t* out);
+	static void EncodeBC5(const uint8_t* rgba, uint8_t* out);
+	static void EncodeBC7(const uint8_t* rgba, uint8_t* out);
+
+	// Channels the format doesn't store come back as 0 (alpha as 255)
+	static void DecodeBlock(BlockFormat format, const uint8_t* block, uint8_t* rgba);
+
+	// Edge blocks of sizes that aren't a multiple of 4 repeat the last row/column.
+	// Returns the number of worker threads used
+	static unsigned int CompressImage(const uint8_t* rgba, uint32_t width, uint32_t height, BlockFormat format, uint8_t* out);
+	static void DecompressImage(const uint8_t* blocks, uint32_t width, uint32_t height, BlockFormat format, uint8_t* rgba);
+};
@@ -98,3 +98,44 @@ Transform* Camera::GetTransform()
 {
     return &transform;
 }
+
+// --------------------------------------------------------
+// Projected height of a sphere as a fraction of the screen's
+// height (1 = fills it top to bottom), used for picking LODs
+// --------------------------------------------------------
+float Camera::GetScreenSize(DirectX::XMFLOAT3 center, float radius)
+{
+    XMMATRIX view = XMLoadFloat4x4(&viewMatrix);
+    float depth = XMVectorGetZ(XMVector3TransformCoord(XMLoadFloat3(&center), view));
+
+    //Entirely behind the camera, or close enough to surround it
+    if (depth < -radius) return 0.0f;
+    if (depth <= radius) return 1.0f;
+
+    //_22 is cot(fov / 2) - what scales view space heights into [-1, 1]
+    return radius * projectionMatrix._22 / depth;
+}
+
+// --------------------------------------------------------
+// Frustum planes pulled straight out of view * projection
+// (Gribb & Hartmann) - clip space is -w <= x,y <= w, 0 <= z <= w
+// --------------------------------------------------------
+void Camera::GetFrustumPlanes(DirectX::XMFLOAT4 planes[6])
+{
+    XMFLOAT4X4 vp;
+    XMStoreFloat4x4(&vp, XMMatrixMultiply(XMLoadFloat4x4(&viewMatrix), XMLoadFloat4x4(&projectionMatrix)));
+
+    //Columns of the matrix, since points are multiplied as rows
+    XMVECTOR colX = XMVectorSet(vp._11, vp._21, vp._31, vp._41);
+    XMVECTOR colY = XMVectorSet(vp._12, vp._22, vp._32, vp._42);
+    XMVECTOR colZ = XMVectorSet(vp._13, vp._23, vp._33, vp._43);
+    XMVECTOR colW = XMVectorSet(vp._14, vp._24, vp._34, vp._44);
+
+    XMVECTOR sides[6] = { colW + colX, colW - colX, colW + colY, colW - colY, colZ, colW - colZ };
+    for (int i = 0; i < 6; i++)
+    {
+        //Normalize by the normal's length so distances come out in world units
+        float length = XMVectorGetX(XMVector3Length(sides[i]));
+        XMStoreFloat4(&planes[i], sides[i] / length);
+    }
+}
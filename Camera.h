@@ -18,6 +18,12 @@ public:
 	DirectX::XMFLOAT4X4 GetProjection();
 	Transform* GetTransform();
 
+	//How much of the screen's height a world space sphere covers
+	float GetScreenSize(DirectX::XMFLOAT3 center, float radius);
+
+	//World space view frustum as 6 normalized planes facing inwards (left, right, bottom, top, near, far)
+	void GetFrustumPlanes(DirectX::XMFLOAT4 planes[6]);
+
 	void SetFoV(float fov);
 
 private:
@@ -0,0 +1,336 @@
+// --------------------------------------------------------
+// Standalone test for the game's constant buffer split
+//
+// Not part of the game project (it has its own main) - build it
+// on its own, e.g. headless on Linux, against the stand-in
+// Direct3D headers in TestStubs:
+//
+//   g++ -std=c++14 -O2 -ITestStubs -o ConstantBufferUploadTest
+//       ConstantBufferUploadTest.cpp SimpleShader.cpp
+//       DxbcReflection.cpp ShaderReflectionCache.cpp MappedFile.cpp
+//
+// Usage:
+//   ConstantBufferUploadTest [obstacles (default 24)] [frames (default 4)]
+//
+// Plays the frames Game::Draw does - camera and lights once, a
+// material whenever it changes, then each entity - through two
+// sets of shaders: VertexShader and PixelShader as they are now
+// (PerFrame / PerMaterial / PerObject, sized from ShaderConstants.h)
+// and the same variables in one buffer per shader, as it was
+// before the split.  Every split frame has to cost at most what
+// its draws should (each PerFrame once, PerMaterial per switch,
+// both PerObjects per draw), and the split has to upload less than
+// the single buffers, whether buffers go whole or only their dirty
+// ranges do.  The stub device counts every byte.  Returns 0 when
+// everything passed
+// --------------------------------------------------------
+#include "SimpleShader.h"
+#include "ShaderConstants.h"
+#include "ShaderReflectionCache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool condition, const char* what, int line)
+	{
+		if (condition)
+			return;
+		printf("  FAILED (line %d): %s\n", line, what);
+		failures++;
+	}
+
+	#define CHECK(condition) Check((condition), #condition, __LINE__)
+
+	struct BufferLayout
+	{
+		const char* Name;
+		unsigned int Size;
+		std::vector<ShaderVariableInfo> Variables;
+	};
+
+	ShaderVariableInfo Variable(const char* name, size_t offset, size_t size)
+	{
+		ShaderVariableInfo variable;
+		variable.Name = name;
+		variable.StartOffset = (uint32_t)offset;
+		variable.Size = (uint32_t)size;
+		return variable;
+	}
+
+	// --------------------------------------------------------
+	// Writes a stand-in .cso and caches its reflection, so the
+	// shader loads without a compiler.  The "bytecode" is only
+	// there to be hashed, so each file's text has to differ
+	// --------------------------------------------------------
+	std::wstring WriteShader(ShaderReflectionCache& cache, const char* file, uint32_t version, const std::vector<BufferLayout>& buffers)
+	{
+		std::string bytecode = std::string("ConstantBufferUploadTest - ") + file;
+		std::ofstream(file, std::ios::binary).write(bytecode.data(), bytecode.size());
+
+		ShaderReflection reflection;
+		reflection.Version = version;
+		for (size_t b = 0; b < buffers.size(); b++)
+		{
+			ShaderBufferInfo info;
+			info.Name = buffers[b].Name;
+			info.Size = buffers[b].Size;
+			info.BindPoint = (uint32_t)b;
+			info.Variables = buffers[b].Variables;
+			reflection.ConstantBuffers.push_back(info);
+
+			ShaderBindingInfo binding;
+			binding.Name = info.Name;
+			binding.Type = D3D_SIT_CBUFFER;
+			binding.BindPoint = info.BindPoint;
+			binding.BindCount = 1;
+			reflection.Bindings.push_back(binding);
+		}
+
+		cache.Put(bytecode.data(), bytecode.size(), reflection);
+		return std::wstring(file, file + strlen(file));
+	}
+
+	const uint32_t VertexShaderVersion = 0x10050;	// vs_5_0
+	const uint32_t PixelShaderVersion = 0x50;		// ps_5_0
+
+	// The variables of each split buffer, at their ShaderConstants.h offsets
+	std::vector<ShaderVariableInfo> VertexFrameVariables()
+	{
+		return { Variable("view", offsetof(VertexShaderPerFrame, view), sizeof(XMFLOAT4X4)),
+			Variable("projection", offsetof(VertexShaderPerFrame, projection), sizeof(XMFLOAT4X4)) };
+	}
+
+	std::vector<ShaderVariableInfo> VertexObjectVariables()
+	{
+		return { Variable("world", offsetof(VertexShaderPerObject, world), sizeof(XMFLOAT4X4)),
+			Variable("worldInvTranspose", offsetof(VertexShaderPerObject, worldInvTranspose), sizeof(XMFLOAT4X4)) };
+	}
+
+	std::vector<ShaderVariableInfo> PixelFrameVariables()
+	{
+		return { Variable("lights", offsetof(PixelShaderPerFrame, lights), sizeof(PixelShaderPerFrame::lights)),
+			Variable("ambient", offsetof(PixelShaderPerFrame, ambient), sizeof(XMFLOAT3)),
+			Variable("specularMips", offsetof(PixelShaderPerFrame, specularMips), sizeof(float)),
+			Variable("cameraPosition", offsetof(PixelShaderPerFrame, cameraPosition), sizeof(XMFLOAT3)),
+			Variable("shIrradiance", offsetof(PixelShaderPerFrame, shIrradiance), sizeof(PixelShaderPerFrame::shIrradiance)) };
+	}
+
+	std::vector<ShaderVariableInfo> Offset(std::vector<ShaderVariableInfo> variables, size_t offset)
+	{
+		for (size_t v = 0; v < variables.size(); v++)
+			variables[v].StartOffset += (uint32_t)offset;
+		return variables;
+	}
+
+	// --------------------------------------------------------
+	// One layout's pair of shaders.  The single buffer layouts
+	// put the split buffers back to back, in the same order
+	// --------------------------------------------------------
+	struct ShaderPair
+	{
+		SimpleVertexShader* Vertex;
+		SimplePixelShader* Pixel;
+		bool Split;
+	};
+
+	ShaderPair LoadSplit(ShaderReflectionCache& cache, ID3D11Device* device, ID3D11DeviceContext* context)
+	{
+		std::vector<BufferLayout> vs = {
+			{ VertexShaderPerFrame::BufferName, sizeof(VertexShaderPerFrame), VertexFrameVariables() },
+			{ VertexShaderPerObject::BufferName, sizeof(VertexShaderPerObject), VertexObjectVariables() } };
+		std::vector<BufferLayout> ps = {
+			{ PixelShaderPerFrame::BufferName, sizeof(PixelShaderPerFrame), PixelFrameVariables() },
+			{ PixelShaderPerMaterial::BufferName, sizeof(PixelShaderPerMaterial), { Variable("colorTint", 0, sizeof(XMFLOAT4)) } },
+			{ PixelShaderPerObject::BufferName, sizeof(PixelShaderPerObject), { Variable("albedoSlice", 0, sizeof(float)) } } };
+
+		ShaderPair pair;
+		pair.Vertex = new SimpleVertexShader(device, context, WriteShader(cache, "SplitVS.cso", VertexShaderVersion, vs).c_str());
+		pair.Pixel = new SimplePixelShader(device, context, WriteShader(cache, "SplitPS.cso", PixelShaderVersion, ps).c_str());
+		pair.Split = true;
+		return pair;
+	}
+
+	ShaderPair LoadSingle(ShaderReflectionCache& cache, ID3D11Device* device, ID3D11DeviceContext* context)
+	{
+		size_t vsObject = sizeof(VertexShaderPerFrame);
+		size_t psMaterial = sizeof(PixelShaderPerFrame);
+		size_t psObject = psMaterial + sizeof(PixelShaderPerMaterial);
+
+		BufferLayout vs = { "Constants", (unsigned int)(vsObject + sizeof(VertexShaderPerObject)), VertexFrameVariables() };
+		std::vector<ShaderVariableInfo> objectVariables = Offset(VertexObjectVariables(), vsObject);
+		vs.Variables.insert(vs.Variables.end(), objectVariables.begin(), objectVariables.end());
+
+		BufferLayout ps = { "Constants", (unsigned int)(psObject + sizeof(PixelShaderPerObject)), PixelFrameVariables() };
+		ps.Variables.push_back(Variable("colorTint", psMaterial, sizeof(XMFLOAT4)));
+		ps.Variables.push_back(Variable("albedoSlice", psObject, sizeof(float)));
+
+		ShaderPair pair;
+		pair.Vertex = new SimpleVertexShader(device, context, WriteShader(cache, "SingleVS.cso", VertexShaderVersion, { vs }).c_str());
+		pair.Pixel = new SimplePixelShader(device, context, WriteShader(cache, "SinglePS.cso", PixelShaderVersion, { ps }).c_str());
+		pair.Split = false;
+		return pair;
+	}
+
+	XMFLOAT4X4 Translation(float x, float y, float z)
+	{
+		XMFLOAT4X4 m = {};
+		m.m[0][0] = m.m[1][1] = m.m[2][2] = m.m[3][3] = 1.0f;
+		m.m[3][0] = x;
+		m.m[3][1] = y;
+		m.m[3][2] = z;
+		return m;
+	}
+
+	// --------------------------------------------------------
+	// One of Game::Draw's frames: the camera moves, and every
+	// obstacle has moved and has its own albedo slice.  The
+	// obstacles share a material, then the player and the ground
+	// have one each.  Returns the draws and material switches
+	// --------------------------------------------------------
+	void DrawFrame(ShaderPair& shaders, int frame, int obstacles, int& draws, int& materialBinds)
+	{
+		XMFLOAT4X4 view = Translation(0.0f, -2.0f, (float)frame);
+		XMFLOAT4X4 projection = Translation(0.0f, 0.0f, 0.0f);
+		PixelShaderPerFrame::Light lights[6] = {};
+		lights[0].Intensity = 1.0f + frame;
+		XMFLOAT3 cameraPosition(0.0f, 2.0f, -(float)frame);
+		XMFLOAT3 ambient(0.1f, 0.1f, 0.1f);
+		XMFLOAT4 sh[9] = {};
+
+		SimpleVertexShader* vs = shaders.Vertex;
+		SimplePixelShader* ps = shaders.Pixel;
+		vs->SetMatrix4x4("view", view);
+		vs->SetMatrix4x4("projection", projection);
+		ps->SetData("lights", lights, sizeof(lights));
+		ps->SetFloat3("ambient", ambient);
+		ps->SetFloat("specularMips", 8.0f);
+		ps->SetFloat3("cameraPosition", cameraPosition);
+		ps->SetData("shIrradiance", sh, sizeof(sh));
+		if (shaders.Split)
+		{
+			vs->CopyBufferData(VertexShaderPerFrame::BufferName);
+			ps->CopyBufferData(PixelShaderPerFrame::BufferName);
+		}
+
+		const XMFLOAT4 tints[3] = { XMFLOAT4(1, 1, 1, 1), XMFLOAT4(0.2f, 0.4f, 1, 1), XMFLOAT4(0.5f, 0.5f, 0.5f, 1) };
+		int boundMaterial = -1;
+		draws = 0;
+		materialBinds = 0;
+		for (int e = 0; e < obstacles + 2; e++)
+		{
+			int material = e < obstacles ? 0 : e - obstacles + 1;
+			if (material != boundMaterial)
+			{
+				ps->SetFloat4("colorTint", tints[material]);
+				if (shaders.Split)
+					ps->CopyBufferData(PixelShaderPerMaterial::BufferName);
+				boundMaterial = material;
+				materialBinds++;
+			}
+
+			XMFLOAT4X4 world = Translation((float)e, 0.0f, (float)(frame * 3 + e));
+			vs->SetMatrix4x4("world", world);
+			vs->SetMatrix4x4("worldInvTranspose", world);
+			ps->SetFloat("albedoSlice", (float)((e + frame) % 4));
+			if (shaders.Split)
+			{
+				vs->CopyBufferData(VertexShaderPerObject::BufferName);
+				ps->CopyBufferData(PixelShaderPerObject::BufferName);
+			}
+			else
+			{
+				vs->CopyAllBufferData();
+				ps->CopyAllBufferData();
+			}
+			draws++;
+		}
+	}
+
+	// Bytes each layout uploads over the frames, checking the split one's frames against their draws
+	void TestLayouts(ID3D11Device* device, ID3D11DeviceContext* context, ShaderReflectionCache& cache, int obstacles, int frames)
+	{
+		ShaderPair split = LoadSplit(cache, device, context);
+		ShaderPair single = LoadSingle(cache, device, context);
+		CHECK(split.Vertex->IsShaderValid() && split.Pixel->IsShaderValid());
+		CHECK(single.Vertex->IsShaderValid() && single.Pixel->IsShaderValid());
+		CHECK(split.Pixel->GetBufferCount() == 3 && single.Pixel->GetBufferCount() == 1);
+
+		size_t splitBytes = 0;
+		size_t singleBytes = 0;
+		bool withinBudget = true;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			int draws = 0;
+			int materialBinds = 0;
+			ISimpleShader::ResetUploadStats();
+			DrawFrame(split, frame, obstacles, draws, materialBinds);
+			size_t bytes = ISimpleShader::UploadStats.BytesUploaded;
+			splitBytes += bytes;
+
+			//Each PerFrame once, PerMaterial per switch, both PerObjects per draw
+			size_t budget = sizeof(VertexShaderPerFrame) + sizeof(PixelShaderPerFrame) + materialBinds * sizeof(PixelShaderPerMaterial) +
+				draws * (sizeof(VertexShaderPerObject) + sizeof(PixelShaderPerObject));
+			withinBudget = withinBudget && bytes <= budget;
+
+			ISimpleShader::ResetUploadStats();
+			DrawFrame(single, frame, obstacles, draws, materialBinds);
+			singleBytes += ISimpleShader::UploadStats.BytesUploaded;
+		}
+
+		printf("  %d frames of %d draws: %zu bytes split, %zu in one buffer per shader\n", frames, obstacles + 2, splitBytes, singleBytes);
+		CHECK(withinBudget);
+		CHECK(splitBytes < singleBytes);
+
+		delete split.Vertex;
+		delete split.Pixel;
+		delete single.Vertex;
+		delete single.Pixel;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int obstacles = argc > 1 ? atoi(argv[1]) : 24;
+	int frames = argc > 2 ? atoi(argv[2]) : 4;
+
+	ShaderReflectionCache cache;
+	ISimpleShader::ReflectionCache = &cache;
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> context;
+	device.Attach(new ID3D11Device());
+	context.Attach(new ID3D11DeviceContext1());
+
+	//Whole buffers - what every upload costs on an 11.0 driver or with Map(DISCARD)
+	printf("Whole buffers\n");
+	device->PartialUpdates = FALSE;
+	TestLayouts(device.Get(), context.Get(), cache, obstacles, frames);
+
+	printf("Dirty ranges\n");
+	device->PartialUpdates = TRUE;
+	TestLayouts(device.Get(), context.Get(), cache, obstacles, frames);
+
+	CHECK(cache.GetMisses() == 0);
+	ISimpleShader::ReflectionCache = nullptr;
+	const char* files[] = { "SplitVS.cso", "SplitPS.cso", "SingleVS.cso", "SinglePS.cso" };
+	for (const char* file : files)
+		remove(file);
+
+	if (failures)
+	{
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("All passed\n");
+	return 0;
+}
@@ -0,0 +1,377 @@
+#include "DdsFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const uint32_t FourCCDx10 = 0x30315844;		// "DX10"
+
+	// Header flags
+	const uint32_t DdsdCaps = 0x1;
+	const uint32_t DdsdHeight = 0x2;
+	const uint32_t DdsdWidth = 0x4;
+	const uint32_t DdsdPixelFormat = 0x1000;
+	const uint32_t DdsdMipMapCount = 0x20000;
+	const uint32_t DdsdLinearSize = 0x80000;
+
+	const uint32_t DdsdDepth = 0x800000;
+
+	const uint32_t DdpfAlpha = 0x2;
+	const uint32_t DdpfFourCC = 0x4;
+	const uint32_t DdpfRgb = 0x40;
+	const uint32_t DdpfLuminance = 0x20000;
+
+	const uint32_t DdsCapsComplex = 0x8;
+	const uint32_t DdsCapsTexture = 0x1000;
+	const uint32_t DdsCapsMipMap = 0x400000;
+
+	const uint32_t DdsCaps2CubeMap = 0x200;
+	const uint32_t DdsCaps2AllFaces = 0xFC00;
+	const uint32_t DdsCaps2Volume = 0x200000;
+
+	// D3D11_RESOURCE_DIMENSION_*
+	const uint32_t DimensionTexture1D = 2;
+	const uint32_t DimensionTexture2D = 3;
+	const uint32_t DimensionTexture3D = 4;
+
+	// D3D11_RESOURCE_MISC_TEXTURECUBE
+	const uint32_t MiscTextureCube = 0x4;
+
+	// D3D11's limits (16384 wide, 15 mips, 2048 slices)
+	const uint32_t MaxMipLevels = 15;
+	const uint32_t MaxArraySize = 2048;
+
+	uint32_t MakeFourCC(char a, char b, char c, char d)
+	{
+		return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+	}
+
+	bool HasMasks(const DdsPixelFormat& format, uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+	{
+		return format.RBitMask == r && format.GBitMask == g && format.BBitMask == b && format.ABitMask == a;
+	}
+
+	// --------------------------------------------------------
+	// The DXGI format a pre-DX10 pixel format maps to (0 if it
+	// has none, like 24 bit RGB)
+	// --------------------------------------------------------
+	uint32_t LegacyFormat(const DdsPixelFormat& format)
+	{
+		if (format.Flags & DdpfFourCC)
+		{
+			switch (format.FourCC)
+			{
+			case 36:	return 11;		// D3DFMT_A16B16G16R16 -> R16G16B16A16_UNORM
+			case 110:	return 13;		// D3DFMT_Q16W16V16U16 -> R16G16B16A16_SNORM
+			case 111:	return 54;		// D3DFMT_R16F -> R16_FLOAT
+			case 112:	return 34;		// D3DFMT_G16R16F -> R16G16_FLOAT
+			case 113:	return 10;		// D3DFMT_A16B16G16R16F -> R16G16B16A16_FLOAT
+			case 114:	return 41;		// D3DFMT_R32F -> R32_FLOAT
+			case 115:	return 16;		// D3DFMT_G32R32F -> R32G32_FLOAT
+			case 116:	return 2;		// D3DFMT_A32B32G32R32F -> R32G32B32A32_FLOAT
+			}
+
+			if (format.FourCC == MakeFourCC('D', 'X', 'T', '1'))
+				return 71;
+			if (format.FourCC == MakeFourCC('D', 'X', 'T', '2') || format.FourCC == MakeFourCC('D', 'X', 'T', '3'))
+				return 74;
+			if (format.FourCC == MakeFourCC('D', 'X', 'T', '4') || format.FourCC == MakeFourCC('D', 'X', 'T', '5'))
+				return 77;
+			if (format.FourCC == MakeFourCC('A', 'T', 'I', '1') || format.FourCC == MakeFourCC('B', 'C', '4', 'U'))
+				return 80;
+			if (format.FourCC == MakeFourCC('B', 'C', '4', 'S'))
+				return 81;
+			if (format.FourCC == MakeFourCC('A', 'T', 'I', '2') || format.FourCC == MakeFourCC('B', 'C', '5', 'U'))
+				return 83;
+			if (format.FourCC == MakeFourCC('B', 'C', '5', 'S'))
+				return 84;
+			return 0;
+		}
+
+		if (format.Flags & DdpfRgb)
+		{
+			if (format.RGBBitCount == 32)
+			{
+				if (HasMasks(format, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
+					return 28;		// R8G8B8A8_UNORM
+				if (HasMasks(format, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000))
+					return 87;		// B8G8R8A8_UNORM
+				if (HasMasks(format, 0x00ff0000, 0x0000ff00, 0x000000ff, 0))
+					return 88;		// B8G8R8X8_UNORM
+				if (HasMasks(format, 0x0000ffff, 0xffff0000, 0, 0))
+					return 35;		// R16G16_UNORM
+				if (HasMasks(format, 0xffffffff, 0, 0, 0))
+					return 41;		// R32_FLOAT (D3DX writes it this way)
+			}
+			else if (format.RGBBitCount == 16)
+			{
+				if (HasMasks(format, 0xf800, 0x07e0, 0x001f, 0))
+					return 85;		// B5G6R5_UNORM
+				if (HasMasks(format, 0x7c00, 0x03e0, 0x001f, 0x8000))
+					return 86;		// B5G5R5A1_UNORM
+			}
+			return 0;
+		}
+
+		if (format.Flags & DdpfLuminance)
+		{
+			if (format.RGBBitCount == 8)
+				return 61;			// R8_UNORM
+			if (format.RGBBitCount == 16 && HasMasks(format, 0xffff, 0, 0, 0))
+				return 56;			// R16_UNORM
+			if (format.RGBBitCount == 16 && HasMasks(format, 0x00ff, 0, 0, 0xff00))
+				return 49;			// R8G8_UNORM
+			return 0;
+		}
+
+		if ((format.Flags & DdpfAlpha) && format.RGBBitCount == 8)
+			return 65;				// A8_UNORM
+
+		return 0;
+	}
+
+	// Headers then every subresource back to back (cube maps count
+	// as one array item, with six faces)
+	bool WriteTexture(const std::string& path, uint32_t dxgiFormat, uint32_t width, uint32_t height, uint32_t mipLevels, bool cube, const std::vector<std::vector<uint8_t>>& subresources)
+	{
+		if (subresources.empty() || mipLevels == 0)
+			return false;
+
+		DdsHeader header;
+		memset(&header, 0, sizeof(header));
+		header.Size = sizeof(DdsHeader);
+		header.Flags = DdsdCaps | DdsdHeight | DdsdWidth | DdsdPixelFormat | DdsdMipMapCount | DdsdLinearSize;
+		header.Height = height;
+		header.Width = width;
+		header.PitchOrLinearSize = (uint32_t)subresources[0].size();
+		header.MipMapCount = mipLevels;
+		header.PixelFormat.Size = sizeof(DdsPixelFormat);
+		header.PixelFormat.Flags = DdpfFourCC;
+		header.PixelFormat.FourCC = FourCCDx10;
+		header.Caps = DdsCapsTexture | (mipLevels > 1 ? DdsCapsComplex | DdsCapsMipMap : 0) | (cube ? DdsCapsComplex : 0);
+		header.Caps2 = cube ? DdsCaps2CubeMap | DdsCaps2AllFaces : 0;
+
+		DdsHeaderDx10 dx10;
+		memset(&dx10, 0, sizeof(dx10));
+		dx10.DxgiFormat = dxgiFormat;
+		dx10.ResourceDimension = DimensionTexture2D;
+		dx10.MiscFlag = cube ? MiscTextureCube : 0;
+		dx10.ArraySize = 1;
+
+		std::string tempFile = path + ".tmp";
+		{
+			std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+			if (!out.is_open())
+				return false;
+
+			uint32_t magic = DdsFile::Magic;
+			out.write((const char*)&magic, sizeof(magic));
+			out.write((const char*)&header, sizeof(header));
+			out.write((const char*)&dx10, sizeof(dx10));
+			for (size_t i = 0; i < subresources.size(); i++)
+				out.write((const char*)subresources[i].data(), subresources[i].size());
+			if (!out.good())
+				return false;
+		}
+
+		//rename() won't replace an existing file on Windows
+		remove(path.c_str());
+		if (rename(tempFile.c_str(), path.c_str()) != 0)
+		{
+			remove(tempFile.c_str());
+			return false;
+		}
+
+		return true;
+	}
+}
+
+uint32_t DdsFile::GetElementBytes(uint32_t dxgiFormat, bool& blockCompressed)
+{
+	blockCompressed = false;
+	switch (dxgiFormat)
+	{
+	case 70: case 71: case 72:				// BC1
+	case 79: case 80: case 81:				// BC4
+		blockCompressed = true;
+		return 8;
+	case 73: case 74: case 75:				// BC2
+	case 76: case 77: case 78:				// BC3
+	case 82: case 83: case 84:				// BC5
+	case 94: case 95: case 96:				// BC6H
+	case 97: case 98: case 99:				// BC7
+		blockCompressed = true;
+		return 16;
+	case 67:								// R9G9B9E5_SHAREDEXP
+	case 87: case 88: case 89: case 90: case 91: case 92: case 93:	// B8G8R8A8/X8
+		return 4;
+	case 85: case 86: case 115:				// B5G6R5, B5G5R5A1, B4G4R4A4
+		return 2;
+	}
+
+	//The plain formats are grouped by size in DXGI_FORMAT's order
+	if (dxgiFormat >= 1 && dxgiFormat <= 4)
+		return 16;
+	if (dxgiFormat >= 5 && dxgiFormat <= 8)
+		return 12;
+	if (dxgiFormat >= 9 && dxgiFormat <= 22)
+		return 8;
+	if (dxgiFormat >= 23 && dxgiFormat <= 47)
+		return 4;
+	if (dxgiFormat >= 48 && dxgiFormat <= 59)
+		return 2;
+	if (dxgiFormat >= 60 && dxgiFormat <= 65)
+		return 1;
+	return 0;
+}
+
+// --------------------------------------------------------
+// Pixel data follows the headers with no padding: for each
+// array item (or cube face), each mip from the top down
+// --------------------------------------------------------
+bool DdsFile::Parse(const uint8_t* data, size_t size, DdsImage& image)
+{
+	image = DdsImage();
+
+	uint32_t magic;
+	if (!data || size < sizeof(magic) + sizeof(DdsHeader))
+		return false;
+	memcpy(&magic, data, sizeof(magic));
+	if (magic != Magic)
+		return false;
+
+	DdsHeader header;
+	memcpy(&header, data + sizeof(magic), sizeof(header));
+	if (header.Size != sizeof(DdsHeader) || header.PixelFormat.Size != sizeof(DdsPixelFormat))
+		return false;
+
+	size_t offset = sizeof(magic) + sizeof(DdsHeader);
+	image.Width = header.Width;
+	image.Height = header.Height;
+	image.Depth = 1;
+	image.MipLevels = header.MipMapCount ? header.MipMapCount : 1;
+	image.ArraySize = 1;
+
+	if ((header.PixelFormat.Flags & DdpfFourCC) && header.PixelFormat.FourCC == FourCCDx10)
+	{
+		DdsHeaderDx10 dx10;
+		if (size < offset + sizeof(dx10))
+			return false;
+		memcpy(&dx10, data + offset, sizeof(dx10));
+		offset += sizeof(dx10);
+
+		image.DxgiFormat = dx10.DxgiFormat;
+		image.Dimension = dx10.ResourceDimension;
+		image.ArraySize = dx10.ArraySize;
+		if (image.Dimension == DimensionTexture1D)
+			image.Height = 1;
+		else if (image.Dimension == DimensionTexture2D && (dx10.MiscFlag & MiscTextureCube))
+		{
+			image.Cube = true;
+			image.ArraySize *= 6;
+		}
+		else if (image.Dimension == DimensionTexture3D)
+		{
+			if (image.ArraySize != 1)
+				return false;
+			image.Depth = header.Depth;
+		}
+		else if (image.Dimension != DimensionTexture2D)
+			return false;
+	}
+	else
+	{
+		image.DxgiFormat = LegacyFormat(header.PixelFormat);
+		image.Dimension = DimensionTexture2D;
+		if ((header.Flags & DdsdDepth) && (header.Caps2 & DdsCaps2Volume))
+		{
+			image.Dimension = DimensionTexture3D;
+			image.Depth = header.Depth;
+		}
+		else if (header.Caps2 & DdsCaps2CubeMap)
+		{
+			//D3D can't make a cube out of some of the faces
+			if ((header.Caps2 & DdsCaps2AllFaces) != DdsCaps2AllFaces)
+				return false;
+			image.Cube = true;
+			image.ArraySize = 6;
+		}
+	}
+
+	bool blockCompressed;
+	uint32_t elementBytes = GetElementBytes(image.DxgiFormat, blockCompressed);
+	if (elementBytes == 0 || image.Width == 0 || image.Height == 0 || image.Depth == 0 ||
+		image.ArraySize == 0 || image.ArraySize > MaxArraySize || image.MipLevels > MaxMipLevels)
+		return false;
+
+	//More mips than the top level can halve into is a broken file
+	uint32_t largest = image.Width > image.Height ? image.Width : image.Height;
+	largest = largest > image.Depth ? largest : image.Depth;
+	if ((largest >> (image.MipLevels - 1)) == 0)
+		return false;
+
+	image.Subresources.resize((size_t)image.ArraySize * image.MipLevels);
+	for (uint32_t item = 0; item < image.ArraySize; item++)
+	{
+		uint32_t width = image.Width;
+		uint32_t height = image.Height;
+		uint32_t depth = image.Depth;
+		for (uint32_t mip = 0; mip < image.MipLevels; mip++)
+		{
+			uint64_t rowPitch, rows;
+			if (blockCompressed)
+			{
+				rowPitch = (uint64_t)((width + 3) / 4) * elementBytes;
+				rows = (height + 3) / 4;
+			}
+			else
+			{
+				rowPitch = (uint64_t)width * elementBytes;
+				rows = height;
+			}
+
+			uint64_t slicePitch = rowPitch * rows;
+			uint64_t bytes = slicePitch * depth;
+			if (slicePitch > UINT32_MAX || bytes > size - offset)
+				return false;
+
+			DdsSubresource& sub = image.Subresources[item * image.MipLevels + mip];
+			sub.Data = data + offset;
+			sub.Size = (size_t)bytes;
+			sub.Width = width;
+			sub.Height = height;
+			sub.Depth = depth;
+			sub.RowPitch = (uint32_t)rowPitch;
+			sub.SlicePitch = (uint32_t)slicePitch;
+			offset += (size_t)bytes;
+
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+			depth = depth > 1 ? depth / 2 : 1;
+		}
+	}
+
+	return true;
+}
+
+bool DdsFile::Write(const std::string& path, uint32_t dxgiFormat, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& mips)
+{
+	return WriteTexture(path, dxgiFormat, width, height, (uint32_t)mips.size(), false, mips);
+}
+
+bool DdsFile::WriteCube(const std::string& path, uint32_t dxgiFormat, uint32_t size, uint32_t mipLevels, const std::vector<std::vector<uint8_t>>& faces)
+{
+	if (faces.size() != (size_t)mipLevels * 6)
+		return false;
+	return WriteTexture(path, dxgiFormat, size, size, mipLevels, true, faces);
+}
+
+std::string DdsFile::GetPackedName(const std::string& roughness, const std::string& metalness)
+{
+	//Both without their extension, and the metalness map without its folder too
+	size_t slash = metalness.find_last_of("/\\");
+	std::string second = metalness.substr(slash == std::string::npos ? 0 : slash + 1);
+	return roughness.substr(0, roughness.find_last_of('.')) + "+" + second.substr(0, second.find_last_of('.')) + ".dds";
+}
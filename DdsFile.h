@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// On-disk DDS layout ("DDS " magic, then these)
+// --------------------------------------------------------
+#pragma pack(push, 1)
+struct DdsPixelFormat
+{
+	uint32_t Size;
+	uint32_t Flags;
+	uint32_t FourCC;
+	uint32_t RGBBitCount;
+	uint32_t RBitMask;
+	uint32_t GBitMask;
+	uint32_t BBitMask;
+	uint32_t ABitMask;
+};
+
+struct DdsHeader
+{
+	uint32_t Size;
+	uint32_t Flags;
+	uint32_t Height;
+	uint32_t Width;
+	uint32_t PitchOrLinearSize;
+	uint32_t Depth;
+	uint32_t MipMapCount;
+	uint32_t Reserved1[11];
+	DdsPixelFormat PixelFormat;
+	uint32_t Caps;
+	uint32_t Caps2;
+	uint32_t Caps3;
+	uint32_t Caps4;
+	uint32_t Reserved2;
+};
+
+// Follows the header when the pixel format's FourCC is "DX10"
+struct DdsHeaderDx10
+{
+	uint32_t DxgiFormat;
+	uint32_t ResourceDimension;
+	uint32_t MiscFlag;
+	uint32_t ArraySize;
+	uint32_t MiscFlags2;
+};
+#pragma pack(pop)
+
+// One mip of one array slice (or cube face), pointing straight
+// into the bytes that were parsed - nothing is copied
+struct DdsSubresource
+{
+	const uint8_t* Data = nullptr;
+	size_t Size = 0;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t Depth = 1;
+	uint32_t RowPitch = 0;			// Bytes per row of pixels (or of 4x4 blocks)
+	uint32_t SlicePitch = 0;		// Bytes per depth slice
+};
+
+struct DdsImage
+{
+	uint32_t DxgiFormat = 0;
+	uint32_t Dimension = 0;			// D3D11_RESOURCE_DIMENSION_TEXTURE1D/2D/3D
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t Depth = 1;
+	uint32_t MipLevels = 0;
+	uint32_t ArraySize = 0;			// Cube maps count every face (6 per cube)
+	bool Cube = false;
+
+	// D3D's order: every mip of item 0, then every mip of item 1...
+	std::vector<DdsSubresource> Subresources;
+
+	const DdsSubresource& Get(uint32_t item, uint32_t mip) const { return Subresources[item * MipLevels + mip]; }
+};
+
+// --------------------------------------------------------
+// Reading and writing DDS files without D3D
+// --------------------------------------------------------
+class DdsFile
+{
+public:
+	static const uint32_t Magic = 0x20534444;		// "DDS "
+
+	// Reads the headers (legacy and DX10) and lays out every
+	// subresource over the given bytes, which have to outlive the
+	// image.  False for anything malformed, truncated or in a
+	// format D3D11 can't sample
+	static bool Parse(const uint8_t* data, size_t size, DdsImage& image);
+
+	// Bytes per pixel (or per 4x4 block when compressed), 0 if unsupported
+	static uint32_t GetElementBytes(uint32_t dxgiFormat, bool& blockCompressed);
+
+	// Writes a 2D texture with a DX10 header.  mips[0] is the top
+	// level, each one already in the format's layout
+	static bool Write(const std::string& path, uint32_t dxgiFormat, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& mips);
+
+	// Writes a cube map.  faces holds every mip of +X, then every
+	// mip of -X, and so on (+Y, -Y, +Z, -Z) - D3D's order
+	static bool WriteCube(const std::string& path, uint32_t dxgiFormat, uint32_t size, uint32_t mipLevels, const std::vector<std::vector<uint8_t>>& faces);
+
+	// Where a roughness map and a metalness map packed into one texture
+	// are cooked to, in the roughness map's folder:
+	//   Textures/a_roughness.png + Textures/b_metal.png -> Textures/a_roughness+b_metal.dds
+	static std::string GetPackedName(const std::string& roughness, const std::string& metalness);
+};
@@ -0,0 +1,670 @@
+#include "DxbcReflection.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	// The bytes of the whole container or of one chunk, read with bounds checks
+	struct ByteSpan
+	{
+		const uint8_t* Data;
+		size_t Size;
+	};
+
+	inline uint32_t FourCC(char a, char b, char c, char d)
+	{
+		return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+	}
+
+	const uint32_t ChunkDXBC = FourCC('D', 'X', 'B', 'C');
+	const uint32_t ChunkRDEF = FourCC('R', 'D', 'E', 'F');
+	const uint32_t ChunkRD11 = FourCC('R', 'D', '1', '1');
+	const uint32_t ChunkISGN = FourCC('I', 'S', 'G', 'N');
+	const uint32_t ChunkISG1 = FourCC('I', 'S', 'G', '1');
+	const uint32_t ChunkOSGN = FourCC('O', 'S', 'G', 'N');
+	const uint32_t ChunkOSG5 = FourCC('O', 'S', 'G', '5');
+	const uint32_t ChunkOSG1 = FourCC('O', 'S', 'G', '1');
+	const uint32_t ChunkSHDR = FourCC('S', 'H', 'D', 'R');
+	const uint32_t ChunkSHEX = FourCC('S', 'H', 'E', 'X');
+
+	// D3D11_SHADER_VERSION_TYPE, which is how the code's version token stores it
+	const uint32_t ProgramPixel = 0;
+	const uint32_t ProgramVertex = 1;
+	const uint32_t ProgramGeometry = 2;
+	const uint32_t ProgramHull = 3;
+	const uint32_t ProgramDomain = 4;
+	const uint32_t ProgramCompute = 5;
+
+	// D3D_SHADER_VARIABLE_CLASS / D3D_SHADER_VARIABLE_TYPE values ElementSize() needs
+	const uint32_t ClassScalar = 0;
+	const uint32_t ClassVector = 1;
+	const uint32_t ClassMatrixRows = 2;
+	const uint32_t ClassMatrixColumns = 3;
+	const uint32_t ClassStruct = 5;
+	const uint32_t TypeDouble = 39;
+
+	//Structs inside structs - anything deeper is a corrupt file pointing back at itself
+	const int MaxStructDepth = 16;
+
+	const uint32_t OpcodeCustomData = 0x35;
+	const uint32_t OpcodeDclThreadGroup = 0x9B;
+
+	uint32_t ProgramTypeFromRdef(uint32_t rdefType)
+	{
+		switch (rdefType)
+		{
+		case 0xFFFF: return ProgramPixel;
+		case 0xFFFE: return ProgramVertex;
+		case 0x4753: return ProgramGeometry;
+		case 0x4853: return ProgramHull;
+		case 0x4453: return ProgramDomain;
+		case 0x4353: return ProgramCompute;
+		default: return 0xFFFF;
+		}
+	}
+
+	bool ReadU32(const ByteSpan& span, uint64_t offset, uint32_t& value)
+	{
+		if (offset + 4 > span.Size)
+			return false;
+		memcpy(&value, span.Data + offset, 4);
+		return true;
+	}
+
+	bool ReadU16(const ByteSpan& span, uint64_t offset, uint32_t& value)
+	{
+		uint16_t raw;
+		if (offset + 2 > span.Size)
+			return false;
+		memcpy(&raw, span.Data + offset, 2);
+		value = raw;
+		return true;
+	}
+
+	bool ReadU8(const ByteSpan& span, uint64_t offset, uint8_t& value)
+	{
+		if (offset + 1 > span.Size)
+			return false;
+		value = span.Data[offset];
+		return true;
+	}
+
+	// Null terminated, and the terminator has to be inside the span
+	bool ReadString(const ByteSpan& span, uint64_t offset, std::string& text)
+	{
+		if (offset >= span.Size)
+			return false;
+		const uint8_t* start = span.Data + offset;
+		const uint8_t* end = (const uint8_t*)memchr(start, 0, span.Size - (size_t)offset);
+		if (!end)
+			return false;
+		text.assign((const char*)start, end - start);
+		return true;
+	}
+
+	// count records of stride bytes starting at offset, all inside the span
+	bool TableFits(const ByteSpan& span, uint32_t offset, uint32_t count, uint32_t stride)
+	{
+		return (uint64_t)offset + (uint64_t)count * stride <= span.Size;
+	}
+
+	bool FindChunk(const ByteSpan& container, uint32_t fourCC, ByteSpan& chunk)
+	{
+		uint32_t chunkCount;
+		if (!ReadU32(container, 28, chunkCount))
+			return false;
+		for (uint32_t i = 0; i < chunkCount; i++)
+		{
+			uint32_t offset, name, size;
+			if (!ReadU32(container, 32 + (uint64_t)i * 4, offset) || !ReadU32(container, offset, name) || !ReadU32(container, (uint64_t)offset + 4, size))
+				return false;
+			if (name != fourCC)
+				continue;
+			if ((uint64_t)offset + 8 + size > container.Size)
+				return false;
+
+			chunk.Data = container.Data + offset + 8;
+			chunk.Size = size;
+			return true;
+		}
+		return false;
+	}
+
+	uint32_t AlignTo16(uint32_t size)
+	{
+		return (size + 15) & ~15u;
+	}
+
+	// Every element but the last is padded out to a whole register
+	uint32_t VariableSize(const ShaderVariableInfo& variable)
+	{
+		uint32_t element = DxbcReflection::ElementSize(variable);
+		if (variable.Elements == 0)
+			return element;
+		return AlignTo16(element) * (variable.Elements - 1) + element;
+	}
+
+	// --------------------------------------------------------
+	// A variable's type: class, base type, dimensions, array
+	// size and (for structs) members, each with a type of its
+	// own.  Shader model 5 types also have a name
+	// --------------------------------------------------------
+	bool ParseType(const ByteSpan& rdef, uint32_t typeOffset, uint32_t typeStride, ShaderVariableInfo& variable, int depth)
+	{
+		uint32_t memberCount, memberOffset;
+		if (depth > MaxStructDepth ||
+			!ReadU16(rdef, typeOffset, variable.Class) || !ReadU16(rdef, (uint64_t)typeOffset + 2, variable.BaseType) ||
+			!ReadU16(rdef, (uint64_t)typeOffset + 4, variable.Rows) || !ReadU16(rdef, (uint64_t)typeOffset + 6, variable.Columns) ||
+			!ReadU16(rdef, (uint64_t)typeOffset + 8, variable.Elements) || !ReadU16(rdef, (uint64_t)typeOffset + 10, memberCount) ||
+			!ReadU32(rdef, (uint64_t)typeOffset + 12, memberOffset))
+			return false;
+
+		uint32_t nameOffset;
+		if (typeStride >= 36 && ReadU32(rdef, (uint64_t)typeOffset + 32, nameOffset) && nameOffset != 0 &&
+			!ReadString(rdef, nameOffset, variable.TypeName))
+			return false;
+
+		if (memberCount == 0)
+			return true;
+		if (!TableFits(rdef, memberOffset, memberCount, 12))
+			return false;
+
+		variable.Members.resize(memberCount);
+		for (uint32_t m = 0; m < memberCount; m++)
+		{
+			ShaderVariableInfo& member = variable.Members[m];
+			uint64_t record = memberOffset + (uint64_t)m * 12;
+			uint32_t memberType;
+			if (!ReadU32(rdef, record, nameOffset) || !ReadString(rdef, nameOffset, member.Name) ||
+				!ReadU32(rdef, record + 4, memberType) || !ReadU32(rdef, record + 8, member.StartOffset) ||
+				!ParseType(rdef, memberType, typeStride, member, depth + 1))
+				return false;
+			member.Size = VariableSize(member);
+		}
+		return true;
+	}
+
+	// --------------------------------------------------------
+	// RDEF: header, then constant buffers (each pointing at its
+	// variables) and resource bindings.  Shader model 5 adds an
+	// "RD11" block giving the record sizes, which grew
+	// --------------------------------------------------------
+	bool ParseRdef(const ByteSpan& rdef, ShaderReflection& reflection)
+	{
+		uint32_t bufferCount, bufferOffset, bindCount, bindOffset, version;
+		if (!ReadU32(rdef, 0, bufferCount) || !ReadU32(rdef, 4, bufferOffset) ||
+			!ReadU32(rdef, 8, bindCount) || !ReadU32(rdef, 12, bindOffset) || !ReadU32(rdef, 16, version))
+			return false;
+
+		//Stored as minor, major (a byte each), then the program type as
+		//two characters ("CS", "GS", ...) or 0xFFFF/0xFFFE for pixel/vertex
+		uint32_t minor = version & 0xFF;
+		uint32_t major = (version >> 8) & 0xFF;
+		uint32_t programType = ProgramTypeFromRdef(version >> 16);
+		reflection.Version = (programType << 16) | (major << 4) | minor;
+
+		uint32_t bufferStride = 24;
+		uint32_t bindStride = 32;
+		uint32_t variableStride = major >= 5 ? 40 : 24;
+		uint32_t typeStride = major >= 5 ? 36 : 16;
+		uint32_t magic;
+		if (major >= 5 && ReadU32(rdef, 28, magic) && magic == ChunkRD11)
+		{
+			if (!ReadU32(rdef, 36, bufferStride) || !ReadU32(rdef, 40, bindStride) ||
+				!ReadU32(rdef, 44, variableStride) || !ReadU32(rdef, 48, typeStride))
+				return false;
+			if (bufferStride < 24 || bindStride < 32 || variableStride < 24 || typeStride < 16)
+				return false;
+		}
+
+		if (!TableFits(rdef, bindOffset, bindCount, bindStride) || !TableFits(rdef, bufferOffset, bufferCount, bufferStride))
+			return false;
+
+		reflection.Bindings.resize(bindCount);
+		for (uint32_t b = 0; b < bindCount; b++)
+		{
+			ShaderBindingInfo& binding = reflection.Bindings[b];
+			uint64_t record = bindOffset + (uint64_t)b * bindStride;
+			uint32_t nameOffset;
+			if (!ReadU32(rdef, record, nameOffset) || !ReadString(rdef, nameOffset, binding.Name) ||
+				!ReadU32(rdef, record + 4, binding.Type) || !ReadU32(rdef, record + 20, binding.BindPoint) || !ReadU32(rdef, record + 24, binding.BindCount))
+				return false;
+		}
+
+		reflection.ConstantBuffers.resize(bufferCount);
+		for (uint32_t c = 0; c < bufferCount; c++)
+		{
+			ShaderBufferInfo& buffer = reflection.ConstantBuffers[c];
+			uint64_t record = bufferOffset + (uint64_t)c * bufferStride;
+			uint32_t nameOffset, variableCount, variableOffset;
+			if (!ReadU32(rdef, record, nameOffset) || !ReadString(rdef, nameOffset, buffer.Name) ||
+				!ReadU32(rdef, record + 4, variableCount) || !ReadU32(rdef, record + 8, variableOffset) ||
+				!ReadU32(rdef, record + 12, buffer.Size) || !ReadU32(rdef, record + 20, buffer.Type))
+				return false;
+
+			//Bound under the same name (a structured buffer's layout shares its SRV's name)
+			for (size_t b = 0; b < reflection.Bindings.size(); b++)
+			{
+				if (reflection.Bindings[b].Name == buffer.Name)
+				{
+					buffer.BindPoint = reflection.Bindings[b].BindPoint;
+					break;
+				}
+			}
+
+			if (!TableFits(rdef, variableOffset, variableCount, variableStride))
+				return false;
+
+			buffer.Variables.resize(variableCount);
+			for (uint32_t v = 0; v < variableCount; v++)
+			{
+				ShaderVariableInfo& variable = buffer.Variables[v];
+				uint64_t varRecord = variableOffset + (uint64_t)v * variableStride;
+				uint32_t typeOffset;
+				if (!ReadU32(rdef, varRecord, nameOffset) || !ReadString(rdef, nameOffset, variable.Name) ||
+					!ReadU32(rdef, varRecord + 4, variable.StartOffset) || !ReadU32(rdef, varRecord + 8, variable.Size) ||
+					!ReadU32(rdef, varRecord + 16, typeOffset) ||
+					(typeOffset != 0 && !ParseType(rdef, typeOffset, typeStride, variable, 0)))
+					return false;
+				if ((uint64_t)variable.StartOffset + variable.Size > buffer.Size)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// --------------------------------------------------------
+	// Signatures: a count, then fixed-size elements.  The
+	// variants differ by a leading stream index (OSG5, *SG1) and
+	// a trailing min precision (*SG1)
+	// --------------------------------------------------------
+	bool ParseSignature(const ByteSpan& chunk, uint32_t fourCC, std::vector<ShaderSignatureElement>& elements)
+	{
+		uint32_t stride = 24;
+		uint32_t first = 0;
+		if (fourCC == ChunkOSG5)
+		{
+			stride = 28;
+			first = 4;
+		}
+		else if (fourCC == ChunkISG1 || fourCC == ChunkOSG1)
+		{
+			stride = 32;
+			first = 4;
+		}
+
+		uint32_t count;
+		if (!ReadU32(chunk, 0, count) || !TableFits(chunk, 8, count, stride))
+			return false;
+
+		elements.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			ShaderSignatureElement& element = elements[i];
+			uint64_t record = 8 + (uint64_t)i * stride;
+			uint64_t fields = record + first;
+			uint32_t nameOffset;
+			if (first > 0 && !ReadU32(chunk, record, element.Stream))
+				return false;
+			if (!ReadU32(chunk, fields, nameOffset) || !ReadString(chunk, nameOffset, element.SemanticName) ||
+				!ReadU32(chunk, fields + 4, element.SemanticIndex) || !ReadU32(chunk, fields + 8, element.SystemValue) ||
+				!ReadU32(chunk, fields + 12, element.ComponentType) || !ReadU32(chunk, fields + 16, element.Register) ||
+				!ReadU8(chunk, fields + 20, element.Mask) || !ReadU8(chunk, fields + 21, element.ReadWriteMask))
+				return false;
+		}
+		return true;
+	}
+
+	// --------------------------------------------------------
+	// Walks the code's declarations for dcl_thread_group.  Each
+	// instruction's length is in its opcode token, except custom
+	// data blocks, which keep it in the next token
+	// --------------------------------------------------------
+	void ParseThreadGroup(const ByteSpan& code, uint32_t threadGroup[3])
+	{
+		uint32_t tokenCount;
+		if (!ReadU32(code, 4, tokenCount))
+			return;
+		if ((uint64_t)tokenCount * 4 > code.Size)
+			tokenCount = (uint32_t)(code.Size / 4);
+
+		uint32_t token = 2;
+		while (token < tokenCount)
+		{
+			uint32_t opcodeToken;
+			if (!ReadU32(code, (uint64_t)token * 4, opcodeToken))
+				return;
+			uint32_t opcode = opcodeToken & 0x7FF;
+			uint32_t length = (opcodeToken >> 24) & 0x7F;
+			if (opcode == OpcodeCustomData && !ReadU32(code, ((uint64_t)token + 1) * 4, length))
+				return;
+
+			if (opcode == OpcodeDclThreadGroup && length >= 4 && token + 4 <= tokenCount)
+			{
+				//All three or none
+				uint32_t size[3];
+				if (ReadU32(code, ((uint64_t)token + 1) * 4, size[0]) && ReadU32(code, ((uint64_t)token + 2) * 4, size[1]) &&
+					ReadU32(code, ((uint64_t)token + 3) * 4, size[2]))
+				{
+					threadGroup[0] = size[0];
+					threadGroup[1] = size[1];
+					threadGroup[2] = size[2];
+				}
+				return;
+			}
+
+			//A zero length would never move on
+			if (length == 0)
+				return;
+			token += length;
+		}
+	}
+
+	// Little helpers for Write/Read
+	void PutU32(std::vector<uint8_t>& bytes, uint32_t value)
+	{
+		uint8_t raw[4];
+		memcpy(raw, &value, 4);
+		bytes.insert(bytes.end(), raw, raw + 4);
+	}
+
+	void PutString(std::vector<uint8_t>& bytes, const std::string& text)
+	{
+		PutU32(bytes, (uint32_t)text.size());
+		bytes.insert(bytes.end(), text.begin(), text.end());
+	}
+
+	void PutVariable(std::vector<uint8_t>& bytes, const ShaderVariableInfo& variable)
+	{
+		PutString(bytes, variable.Name);
+		PutU32(bytes, variable.StartOffset);
+		PutU32(bytes, variable.Size);
+		PutU32(bytes, variable.Class);
+		PutU32(bytes, variable.BaseType);
+		PutU32(bytes, variable.Rows);
+		PutU32(bytes, variable.Columns);
+		PutU32(bytes, variable.Elements);
+		PutString(bytes, variable.TypeName);
+		PutU32(bytes, (uint32_t)variable.Members.size());
+		for (size_t m = 0; m < variable.Members.size(); m++)
+			PutVariable(bytes, variable.Members[m]);
+	}
+
+	// Only what decides the generated C++ struct - names, offsets, sizes
+	// and numeric types.  A struct's own rows/columns and type name are
+	// left out, so renaming an HLSL struct doesn't invalidate the layout
+	void PutLayout(std::vector<uint8_t>& bytes, const ShaderVariableInfo& variable)
+	{
+		PutString(bytes, variable.Name);
+		PutU32(bytes, variable.StartOffset);
+		PutU32(bytes, variable.Size);
+		PutU32(bytes, variable.Elements);
+		if (variable.Class != ClassStruct)
+		{
+			PutU32(bytes, variable.Class);
+			PutU32(bytes, variable.BaseType);
+			PutU32(bytes, variable.Rows);
+			PutU32(bytes, variable.Columns);
+		}
+		PutU32(bytes, (uint32_t)variable.Members.size());
+		for (size_t m = 0; m < variable.Members.size(); m++)
+			PutLayout(bytes, variable.Members[m]);
+	}
+
+	void PutSignature(std::vector<uint8_t>& bytes, const std::vector<ShaderSignatureElement>& elements)
+	{
+		PutU32(bytes, (uint32_t)elements.size());
+		for (size_t i = 0; i < elements.size(); i++)
+		{
+			const ShaderSignatureElement& e = elements[i];
+			PutString(bytes, e.SemanticName);
+			PutU32(bytes, e.SemanticIndex);
+			PutU32(bytes, e.SystemValue);
+			PutU32(bytes, e.ComponentType);
+			PutU32(bytes, e.Register);
+			PutU32(bytes, e.Stream);
+			PutU32(bytes, e.Mask | ((uint32_t)e.ReadWriteMask << 8));
+		}
+	}
+
+	// Reads sequentially from a serialized blob
+	struct BlobReader
+	{
+		ByteSpan Span;
+		uint64_t Offset;
+
+		bool U32(uint32_t& value)
+		{
+			if (!ReadU32(Span, Offset, value))
+				return false;
+			Offset += 4;
+			return true;
+		}
+
+		bool String(std::string& text)
+		{
+			uint32_t length;
+			if (!U32(length) || Offset + length > Span.Size)
+				return false;
+			text.assign((const char*)Span.Data + Offset, length);
+			Offset += length;
+			return true;
+		}
+
+		// Every record takes at least minBytes, so a bad count can't ask for a huge allocation
+		bool Count(uint32_t& count, uint32_t minBytes)
+		{
+			return U32(count) && (uint64_t)count * minBytes <= Span.Size - Offset;
+		}
+
+		bool Variable(ShaderVariableInfo& variable, int depth)
+		{
+			uint32_t memberCount;
+			if (depth > MaxStructDepth || !String(variable.Name) || !U32(variable.StartOffset) || !U32(variable.Size) ||
+				!U32(variable.Class) || !U32(variable.BaseType) || !U32(variable.Rows) || !U32(variable.Columns) ||
+				!U32(variable.Elements) || !String(variable.TypeName) || !Count(memberCount, 40))
+				return false;
+
+			variable.Members.resize(memberCount);
+			for (uint32_t m = 0; m < memberCount; m++)
+			{
+				if (!Variable(variable.Members[m], depth + 1))
+					return false;
+			}
+			return true;
+		}
+
+		bool Signature(std::vector<ShaderSignatureElement>& elements)
+		{
+			uint32_t count;
+			if (!Count(count, 28))
+				return false;
+			elements.resize(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				ShaderSignatureElement& e = elements[i];
+				uint32_t masks;
+				if (!String(e.SemanticName) || !U32(e.SemanticIndex) || !U32(e.SystemValue) ||
+					!U32(e.ComponentType) || !U32(e.Register) || !U32(e.Stream) || !U32(masks))
+					return false;
+				e.Mask = (uint8_t)(masks & 0xFF);
+				e.ReadWriteMask = (uint8_t)((masks >> 8) & 0xFF);
+			}
+			return true;
+		}
+	};
+}
+
+bool DxbcReflection::Parse(const void* data, size_t size, ShaderReflection& reflection)
+{
+	reflection = ShaderReflection();
+
+	ByteSpan container = { (const uint8_t*)data, size };
+	uint32_t magic, totalSize;
+	if (!data || !ReadU32(container, 0, magic) || magic != ChunkDXBC || !ReadU32(container, 24, totalSize) || totalSize > size)
+		return false;
+	container.Size = totalSize;
+
+	//A shader compiled with reflection stripped has no RDEF - nothing to go on
+	ByteSpan chunk;
+	if (!FindChunk(container, ChunkRDEF, chunk) || !ParseRdef(chunk, reflection))
+		return false;
+
+	//Newer variants first; a shader without a signature (compute) just has none
+	if (FindChunk(container, ChunkISG1, chunk))
+	{
+		if (!ParseSignature(chunk, ChunkISG1, reflection.Inputs))
+			return false;
+	}
+	else if (FindChunk(container, ChunkISGN, chunk) && !ParseSignature(chunk, ChunkISGN, reflection.Inputs))
+		return false;
+
+	const uint32_t outputs[3] = { ChunkOSG1, ChunkOSG5, ChunkOSGN };
+	for (int i = 0; i < 3; i++)
+	{
+		if (FindChunk(container, outputs[i], chunk))
+		{
+			if (!ParseSignature(chunk, outputs[i], reflection.Outputs))
+				return false;
+			break;
+		}
+	}
+
+	//The code's own version token is what D3DReflect reports, and
+	//only compute shaders have a thread group to look for
+	if (FindChunk(container, ChunkSHEX, chunk) || FindChunk(container, ChunkSHDR, chunk))
+	{
+		uint32_t version;
+		if (ReadU32(chunk, 0, version))
+			reflection.Version = version;
+		if ((reflection.Version >> 16) == ProgramCompute)
+			ParseThreadGroup(chunk, reflection.ThreadGroup);
+	}
+
+	return true;
+}
+
+void DxbcReflection::Write(const ShaderReflection& reflection, std::vector<uint8_t>& bytes)
+{
+	bytes.clear();
+	PutU32(bytes, SHADER_REFLECTION_VERSION);
+	PutU32(bytes, reflection.Version);
+
+	PutU32(bytes, (uint32_t)reflection.ConstantBuffers.size());
+	for (size_t c = 0; c < reflection.ConstantBuffers.size(); c++)
+	{
+		const ShaderBufferInfo& buffer = reflection.ConstantBuffers[c];
+		PutString(bytes, buffer.Name);
+		PutU32(bytes, buffer.Type);
+		PutU32(bytes, buffer.Size);
+		PutU32(bytes, buffer.BindPoint);
+		PutU32(bytes, (uint32_t)buffer.Variables.size());
+		for (size_t v = 0; v < buffer.Variables.size(); v++)
+			PutVariable(bytes, buffer.Variables[v]);
+	}
+
+	PutU32(bytes, (uint32_t)reflection.Bindings.size());
+	for (size_t b = 0; b < reflection.Bindings.size(); b++)
+	{
+		const ShaderBindingInfo& binding = reflection.Bindings[b];
+		PutString(bytes, binding.Name);
+		PutU32(bytes, binding.Type);
+		PutU32(bytes, binding.BindPoint);
+		PutU32(bytes, binding.BindCount);
+	}
+
+	PutSignature(bytes, reflection.Inputs);
+	PutSignature(bytes, reflection.Outputs);
+	for (int i = 0; i < 3; i++)
+		PutU32(bytes, reflection.ThreadGroup[i]);
+}
+
+bool DxbcReflection::Read(const void* data, size_t size, ShaderReflection& reflection)
+{
+	reflection = ShaderReflection();
+
+	BlobReader reader = { { (const uint8_t*)data, size }, 0 };
+	uint32_t version, count;
+	if (!data || !reader.U32(version) || version != SHADER_REFLECTION_VERSION || !reader.U32(reflection.Version))
+		return false;
+
+	if (!reader.Count(count, 20))
+		return false;
+	reflection.ConstantBuffers.resize(count);
+	for (uint32_t c = 0; c < count; c++)
+	{
+		ShaderBufferInfo& buffer = reflection.ConstantBuffers[c];
+		uint32_t variableCount;
+		if (!reader.String(buffer.Name) || !reader.U32(buffer.Type) || !reader.U32(buffer.Size) ||
+			!reader.U32(buffer.BindPoint) || !reader.Count(variableCount, 40))
+			return false;
+
+		buffer.Variables.resize(variableCount);
+		for (uint32_t v = 0; v < variableCount; v++)
+		{
+			if (!reader.Variable(buffer.Variables[v], 0))
+				return false;
+		}
+	}
+
+	if (!reader.Count(count, 16))
+		return false;
+	reflection.Bindings.resize(count);
+	for (uint32_t b = 0; b < count; b++)
+	{
+		ShaderBindingInfo& binding = reflection.Bindings[b];
+		if (!reader.String(binding.Name) || !reader.U32(binding.Type) || !reader.U32(binding.BindPoint) || !reader.U32(binding.BindCount))
+			return false;
+	}
+
+	if (!reader.Signature(reflection.Inputs) || !reader.Signature(reflection.Outputs))
+		return false;
+	for (int i = 0; i < 3; i++)
+	{
+		if (!reader.U32(reflection.ThreadGroup[i]))
+			return false;
+	}
+
+	//Anything left over means it wasn't written by this version
+	return reader.Offset == size;
+}
+
+uint32_t DxbcReflection::ElementSize(const ShaderVariableInfo& variable)
+{
+	uint32_t component = variable.BaseType == TypeDouble ? 8 : 4;
+	switch (variable.Class)
+	{
+	case ClassScalar:
+	case ClassVector:
+		return variable.Columns * component;
+
+	//Each row (or column) takes a register, except the last one isn't padded
+	case ClassMatrixRows:
+		return variable.Rows == 0 ? 0 : 16 * (variable.Rows - 1) + variable.Columns * component;
+	case ClassMatrixColumns:
+		return variable.Columns == 0 ? 0 : 16 * (variable.Columns - 1) + variable.Rows * component;
+
+	case ClassStruct:
+	{
+		uint32_t end = 0;
+		for (size_t m = 0; m < variable.Members.size(); m++)
+			end = (std::max)(end, variable.Members[m].StartOffset + variable.Members[m].Size);
+		return end;
+	}
+
+	//No type to go on
+	default:
+		return variable.Size;
+	}
+}
+
+uint64_t DxbcReflection::LayoutHash(const ShaderBufferInfo& buffer)
+{
+	std::vector<uint8_t> bytes;
+	PutU32(bytes, buffer.Size);
+	for (size_t v = 0; v < buffer.Variables.size(); v++)
+		PutLayout(bytes, buffer.Variables[v]);
+	return HashBytes(bytes.data(), bytes.size());
+}
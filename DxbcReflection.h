@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Bump whenever ShaderReflection or its serialized layout changes
+#define SHADER_REFLECTION_VERSION 2
+
+// --------------------------------------------------------
+// One variable in a constant buffer, or one member of a
+// struct (StartOffset is then from the start of the struct)
+//
+// Class is D3D_SHADER_VARIABLE_CLASS and BaseType is
+// D3D_SHADER_VARIABLE_TYPE.  Size covers every element of an
+// array - only the last one isn't padded out to 16 bytes
+// --------------------------------------------------------
+struct ShaderVariableInfo
+{
+	std::string Name;
+	uint32_t StartOffset = 0;
+	uint32_t Size = 0;
+
+	uint32_t Class = 0;
+	uint32_t BaseType = 0;
+	uint32_t Rows = 0;
+	uint32_t Columns = 0;
+	uint32_t Elements = 0;			// 0 = not an array
+	std::string TypeName;			// "float4", a struct's name... (shader model 5 only)
+	std::vector<ShaderVariableInfo> Members;
+};
+
+// --------------------------------------------------------
+// One constant buffer (or tbuffer, or a structured buffer's
+// element layout) - values of Type are D3D_CBUFFER_TYPE
+// --------------------------------------------------------
+struct ShaderBufferInfo
+{
+	std::string Name;
+	uint32_t Type = 0;
+	uint32_t Size = 0;
+	uint32_t BindPoint = 0;			// From the binding with the same name
+	std::vector<ShaderVariableInfo> Variables;
+};
+
+// --------------------------------------------------------
+// One bound resource - values of Type are D3D_SHADER_INPUT_TYPE
+// --------------------------------------------------------
+struct ShaderBindingInfo
+{
+	std::string Name;
+	uint32_t Type = 0;
+	uint32_t BindPoint = 0;
+	uint32_t BindCount = 0;
+};
+
+// --------------------------------------------------------
+// One input or output signature element - ComponentType is
+// D3D_REGISTER_COMPONENT_TYPE, SystemValue is D3D_NAME
+// --------------------------------------------------------
+struct ShaderSignatureElement
+{
+	std::string SemanticName;
+	uint32_t SemanticIndex = 0;
+	uint32_t SystemValue = 0;
+	uint32_t ComponentType = 0;
+	uint32_t Register = 0;
+	uint32_t Stream = 0;
+	uint8_t Mask = 0;
+	uint8_t ReadWriteMask = 0;
+};
+
+// --------------------------------------------------------
+// Everything SimpleShader needs to know about a compiled
+// shader - the same things ID3D11ShaderReflection reports
+// --------------------------------------------------------
+struct ShaderReflection
+{
+	uint32_t Version = 0;			// Program type << 16 | major << 4 | minor, as in D3D11_SHADER_DESC
+	std::vector<ShaderBufferInfo> ConstantBuffers;
+	std::vector<ShaderBindingInfo> Bindings;
+	std::vector<ShaderSignatureElement> Inputs;
+	std::vector<ShaderSignatureElement> Outputs;
+	uint32_t ThreadGroup[3] = { 0, 0, 0 };		// Compute shaders only
+
+	// Total threads in a group, like ID3D11ShaderReflection::GetThreadGroupSize
+	uint32_t GetThreadGroupSize() const { return ThreadGroup[0] * ThreadGroup[1] * ThreadGroup[2]; }
+};
+
+// --------------------------------------------------------
+// Reads reflection data straight out of compiled shader
+// bytecode (.cso) - no d3dcompiler, so it runs anywhere
+//
+// - The DXBC container holds chunks: RDEF (constant buffers,
+//   their variables and types, and resource bindings),
+//   ISGN/OSGN and their variants (signatures) and SHDR/SHEX
+//   (the code, which is only read for its version and a
+//   compute shader's thread group size)
+// - Every offset and count is bounds checked, so a truncated
+//   or corrupt file fails to parse instead of crashing
+// - Write()/Read() turn the result into a compact blob for
+//   ShaderReflectionCache
+// --------------------------------------------------------
+class DxbcReflection
+{
+public:
+	static bool Parse(const void* data, size_t size, ShaderReflection& reflection);
+
+	static void Write(const ShaderReflection& reflection, std::vector<uint8_t>& bytes);
+	static bool Read(const void* data, size_t size, ShaderReflection& reflection);
+
+	// Size of one element of a variable (the whole variable if it isn't an array)
+	static uint32_t ElementSize(const ShaderVariableInfo& variable);
+
+	// Hash of a buffer's size and every variable's name, offset and type - two
+	// buffers with the same hash can be filled from the same C++ struct
+	static uint64_t LayoutHash(const ShaderBufferInfo& buffer);
+};
@@ -0,0 +1,658 @@
+// --------------------------------------------------------
+// Standalone tests for DxbcReflection
+//
+// Not part of the game project (it has its own main) - build it
+// on its own, e.g. headless on Linux:
+//
+//   g++ -std=c++14 -O2 -o DxbcReflectionTest DxbcReflectionTest.cpp
+//       DxbcReflection.cpp MappedFile.cpp
+//
+// Usage:
+//   DxbcReflectionTest [folder with the compiled .cso files]
+//
+// The game's three shaders have their reflection written down
+// below - what D3DReflect reports for them by HLSL's packing
+// rules (buffers, bind points, variable offsets and sizes,
+// input semantics).  The test writes DXBC containers in fxc's
+// layout from that table (plus a compute shader, a shader model
+// 4 shader and a stripped one) and checks Parse gets the same
+// values back.  Given the build's output folder it also checks
+// the real VertexShader/PixelShader/SkyVertexShader.cso against
+// the table, so a parser or packing mistake shows up against
+// fxc's own output.
+//
+// Every container is then parsed cut short at every length and
+// with random bytes changed - run it under a sanitizer to catch
+// reads out of bounds.  Returns 0 when everything passed
+// --------------------------------------------------------
+#include "DxbcReflection.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool condition, const char* what, const std::string& context, int line)
+	{
+		if (condition)
+			return;
+		printf("  FAILED (line %d, %s): %s\n", line, context.c_str(), what);
+		failures++;
+	}
+
+	#define CHECK(condition, context) Check((condition), #condition, (context), __LINE__)
+
+	// D3D_SHADER_INPUT_TYPE / D3D_SHADER_VARIABLE_CLASS / D3D_SHADER_VARIABLE_TYPE values used here
+	const uint32_t InputCbuffer = 0;
+	const uint32_t InputTexture = 2;
+	const uint32_t InputSampler = 3;
+	const uint16_t ClassScalar = 0;
+	const uint16_t ClassVector = 1;
+	const uint16_t ClassMatrixColumns = 3;
+	const uint16_t ClassStruct = 5;
+	const uint16_t TypeVoid = 0;
+	const uint16_t TypeInt = 2;
+	const uint16_t TypeFloat = 3;
+
+	// Program types as the RDEF header and the code's version token spell them
+	struct Program
+	{
+		uint32_t Rdef;
+		uint32_t Code;
+	};
+	const Program PixelProgram = { 0xFFFF, 0 };
+	const Program VertexProgram = { 0xFFFE, 1 };
+	const Program ComputeProgram = { 0x4353, 5 };
+
+	// --------------------------------------------------------
+	// The shaders' reflection, as D3DReflect reports it
+	// --------------------------------------------------------
+	struct FixtureType;
+
+	struct FixtureMember
+	{
+		const char* Name;
+		const FixtureType* Type;
+		uint32_t Offset;
+	};
+
+	struct FixtureType
+	{
+		uint16_t Class;
+		uint16_t Base;
+		uint16_t Rows;
+		uint16_t Columns;
+		uint16_t Elements;
+		const char* Name;
+		std::vector<FixtureMember> Members;
+	};
+
+	struct ExpectedVariable
+	{
+		const char* Name;
+		uint32_t Offset;
+		uint32_t Size;
+		const FixtureType* Type;
+	};
+
+	struct ExpectedBuffer
+	{
+		const char* Name;
+		uint32_t BindPoint;
+		uint32_t Size;
+		std::vector<ExpectedVariable> Variables;
+	};
+
+	struct ExpectedBinding
+	{
+		const char* Name;
+		uint32_t Type;
+		uint32_t BindPoint;
+	};
+
+	struct ExpectedInput
+	{
+		const char* Semantic;
+		uint8_t Mask;
+	};
+
+	struct ExpectedShader
+	{
+		const char* File;
+		Program Kind;
+		std::vector<ExpectedBuffer> Buffers;
+		std::vector<ExpectedBinding> Bindings;		// Besides the buffers
+		std::vector<ExpectedInput> Inputs;
+	};
+
+	const FixtureType Float = { ClassScalar, TypeFloat, 1, 1, 0, "float", {} };
+	const FixtureType Int = { ClassScalar, TypeInt, 1, 1, 0, "int", {} };
+	const FixtureType Float3 = { ClassVector, TypeFloat, 1, 3, 0, "float3", {} };
+	const FixtureType Float4 = { ClassVector, TypeFloat, 1, 4, 0, "float4", {} };
+	const FixtureType Float4Array9 = { ClassVector, TypeFloat, 1, 4, 9, "float4", {} };
+	const FixtureType Matrix = { ClassMatrixColumns, TypeFloat, 4, 4, 0, "float4x4", {} };
+
+	// ShaderIncludes.hlsli's Light - 64 bytes, in an array of 6
+	const FixtureType Lights = { ClassStruct, TypeVoid, 1, 16, 6, "Light", {
+		{ "Type", &Int, 0 }, { "Direction", &Float3, 4 }, { "Range", &Float, 16 }, { "Position", &Float3, 20 },
+		{ "Intensity", &Float, 32 }, { "Color", &Float3, 36 }, { "SpotFalloff", &Float, 48 }, { "Padding", &Float3, 52 } } };
+
+	std::vector<ExpectedShader> GameShaders()
+	{
+		std::vector<ExpectedBuffer> cameraBuffer = {
+			{ "PerFrame", 0, 128, { { "view", 0, 64, &Matrix }, { "projection", 64, 64, &Matrix } } } };
+		std::vector<ExpectedInput> vertexInputs = { { "POSITION", 0x7 }, { "NORMAL", 0x7 }, { "TEXCOORD", 0x3 }, { "TANGENT", 0xF } };
+
+		ExpectedShader vertex = { "VertexShader.cso", VertexProgram, cameraBuffer, {}, vertexInputs };
+		vertex.Buffers.push_back({ "PerObject", 1, 128, { { "world", 0, 64, &Matrix }, { "worldInvTranspose", 64, 64, &Matrix } } });
+
+		ExpectedShader sky = { "SkyVertexShader.cso", VertexProgram, cameraBuffer, {}, vertexInputs };
+
+		ExpectedShader pixel = { "PixelShader.cso", PixelProgram,
+			{
+				{ "PerFrame", 0, 560, { { "lights", 0, 384, &Lights }, { "ambient", 384, 12, &Float3 }, { "specularMips", 396, 4, &Float },
+					{ "cameraPosition", 400, 12, &Float3 }, { "shIrradiance", 416, 144, &Float4Array9 } } },
+				{ "PerMaterial", 1, 16, { { "colorTint", 0, 16, &Float4 } } },
+				{ "PerObject", 2, 16, { { "albedoSlice", 0, 4, &Float } } },
+			},
+			{
+				{ "BasicSampler", InputSampler, 0 }, { "ClampSampler", InputSampler, 1 },
+				{ "Albedo", InputTexture, 0 }, { "NormalMap", InputTexture, 1 }, { "RoughMetalMap", InputTexture, 2 },
+				{ "SpecularMap", InputTexture, 3 }, { "BrdfLut", InputTexture, 4 },
+			},
+			{ { "SV_POSITION", 0xF }, { "TEXCOORD", 0x3 }, { "NORMAL", 0x7 }, { "POSITION", 0x7 }, { "TANGENT", 0xF } } };
+
+		std::vector<ExpectedShader> shaders;
+		shaders.push_back(vertex);
+		shaders.push_back(pixel);
+		shaders.push_back(sky);
+		return shaders;
+	}
+
+	// --------------------------------------------------------
+	// Writes a chunk.  Strings are written as placeholders and
+	// placed at the end by FinishStrings, like fxc does
+	// --------------------------------------------------------
+	struct ChunkWriter
+	{
+		std::vector<uint8_t> Bytes;
+		std::vector<std::pair<size_t, std::string>> StringRefs;
+
+		uint32_t Size() const { return (uint32_t)Bytes.size(); }
+
+		void U32(uint32_t value)
+		{
+			uint8_t raw[4];
+			memcpy(raw, &value, 4);
+			Bytes.insert(Bytes.end(), raw, raw + 4);
+		}
+
+		void U16(uint16_t value)
+		{
+			uint8_t raw[2];
+			memcpy(raw, &value, 2);
+			Bytes.insert(Bytes.end(), raw, raw + 2);
+		}
+
+		void Set32(uint32_t at, uint32_t value)
+		{
+			memcpy(&Bytes[at], &value, 4);
+		}
+
+		void String(const std::string& text)
+		{
+			StringRefs.push_back(std::make_pair(Bytes.size(), text));
+			U32(0);
+		}
+
+		void FinishStrings()
+		{
+			std::map<std::string, uint32_t> placed;
+			for (size_t i = 0; i < StringRefs.size(); i++)
+			{
+				const std::string& text = StringRefs[i].second;
+				if (!placed.count(text))
+				{
+					placed[text] = Size();
+					Bytes.insert(Bytes.end(), text.begin(), text.end());
+					Bytes.push_back(0);
+				}
+				Set32((uint32_t)StringRefs[i].first, placed[text]);
+			}
+		}
+	};
+
+	// Type records after the variables; members' types go first.  Returns the record's offset
+	uint32_t WriteType(ChunkWriter& out, const FixtureType* type, std::map<const FixtureType*, uint32_t>& written)
+	{
+		std::map<const FixtureType*, uint32_t>::iterator found = written.find(type);
+		if (found != written.end())
+			return found->second;
+
+		std::vector<uint32_t> memberTypes;
+		for (size_t m = 0; m < type->Members.size(); m++)
+			memberTypes.push_back(WriteType(out, type->Members[m].Type, written));
+
+		uint32_t memberOffset = 0;
+		if (!type->Members.empty())
+		{
+			memberOffset = out.Size();
+			for (size_t m = 0; m < type->Members.size(); m++)
+			{
+				out.String(type->Members[m].Name);
+				out.U32(memberTypes[m]);
+				out.U32(type->Members[m].Offset);
+			}
+		}
+
+		uint32_t offset = out.Size();
+		out.U16(type->Class);
+		out.U16(type->Base);
+		out.U16(type->Rows);
+		out.U16(type->Columns);
+		out.U16(type->Elements);
+		out.U16((uint16_t)type->Members.size());
+		out.U32(memberOffset);
+		for (int i = 0; i < 4; i++)
+			out.U32(0);
+		out.String(type->Name);
+
+		written[type] = offset;
+		return offset;
+	}
+
+	// --------------------------------------------------------
+	// RDEF: header (with the RD11 block for shader model 5),
+	// bindings, buffers, variables, types, then strings
+	// --------------------------------------------------------
+	std::vector<uint8_t> Rdef(const ExpectedShader& shader, uint32_t major)
+	{
+		bool sm5 = major >= 5;
+		std::vector<ExpectedBinding> bindings = shader.Bindings;
+		for (size_t b = 0; b < shader.Buffers.size(); b++)
+		{
+			ExpectedBinding binding = { shader.Buffers[b].Name, InputCbuffer, shader.Buffers[b].BindPoint };
+			bindings.push_back(binding);
+		}
+
+		uint32_t headerSize = sm5 ? 60 : 28;
+		uint32_t variableStride = sm5 ? 40 : 24;
+		uint32_t bindingOffset = headerSize;
+		uint32_t bufferOffset = bindingOffset + 32 * (uint32_t)bindings.size();
+		uint32_t variableOffset = bufferOffset + 24 * (uint32_t)shader.Buffers.size();
+
+		ChunkWriter out;
+		out.U32((uint32_t)shader.Buffers.size());
+		out.U32(shader.Buffers.empty() ? 0 : bufferOffset);
+		out.U32((uint32_t)bindings.size());
+		out.U32(bindingOffset);
+		out.U32(0 | (major << 8) | (shader.Kind.Rdef << 16));
+		out.U32(0);
+		out.String("Microsoft (R) HLSL Shader Compiler 10.1");
+		if (sm5)
+		{
+			out.U32(0x31314452);	// "RD11"
+			out.U32(60);
+			out.U32(24);
+			out.U32(32);
+			out.U32(40);
+			out.U32(36);
+			out.U32(12);
+			out.U32(0);
+		}
+
+		for (size_t b = 0; b < bindings.size(); b++)
+		{
+			out.String(bindings[b].Name);
+			out.U32(bindings[b].Type);
+			out.U32(0);
+			out.U32(0);
+			out.U32(0);
+			out.U32(bindings[b].BindPoint);
+			out.U32(1);
+			out.U32(0);
+		}
+
+		uint32_t next = variableOffset;
+		for (size_t b = 0; b < shader.Buffers.size(); b++)
+		{
+			out.String(shader.Buffers[b].Name);
+			out.U32((uint32_t)shader.Buffers[b].Variables.size());
+			out.U32(next);
+			out.U32(shader.Buffers[b].Size);
+			out.U32(0);
+			out.U32(0);
+			next += variableStride * (uint32_t)shader.Buffers[b].Variables.size();
+		}
+
+		std::vector<std::pair<uint32_t, const FixtureType*>> typeRefs;
+		for (size_t b = 0; b < shader.Buffers.size(); b++)
+		{
+			for (size_t v = 0; v < shader.Buffers[b].Variables.size(); v++)
+			{
+				const ExpectedVariable& variable = shader.Buffers[b].Variables[v];
+				out.String(variable.Name);
+				out.U32(variable.Offset);
+				out.U32(variable.Size);
+				out.U32(2);			// D3D_SVF_USED
+				typeRefs.push_back(std::make_pair(out.Size(), variable.Type));
+				out.U32(0);
+				out.U32(0);
+				if (sm5)
+				{
+					out.U32(0xFFFFFFFF);
+					out.U32(0);
+					out.U32(0xFFFFFFFF);
+					out.U32(0);
+				}
+			}
+		}
+
+		std::map<const FixtureType*, uint32_t> written;
+		for (size_t i = 0; i < typeRefs.size(); i++)
+			out.Set32(typeRefs[i].first, WriteType(out, typeRefs[i].second, written));
+
+		out.FinishStrings();
+		return out.Bytes;
+	}
+
+	std::vector<uint8_t> Signature(const std::vector<ExpectedInput>& elements)
+	{
+		ChunkWriter out;
+		out.U32((uint32_t)elements.size());
+		out.U32(8);
+		for (size_t i = 0; i < elements.size(); i++)
+		{
+			bool position = strcmp(elements[i].Semantic, "SV_POSITION") == 0;
+			out.String(elements[i].Semantic);
+			out.U32(0);
+			out.U32(position ? 1 : 0);		// D3D_NAME_POSITION
+			out.U32(3);						// D3D_REGISTER_COMPONENT_FLOAT32
+			out.U32((uint32_t)i);
+			out.U32(elements[i].Mask | (elements[i].Mask << 8));
+		}
+		out.FinishStrings();
+		return out.Bytes;
+	}
+
+	// Version token, length, the given declarations, then ret
+	std::vector<uint8_t> Code(Program kind, uint32_t major, const std::vector<uint32_t>& declarations)
+	{
+		std::vector<uint32_t> tokens;
+		tokens.push_back((major << 4) | (kind.Code << 16));
+		tokens.push_back(0);
+		tokens.insert(tokens.end(), declarations.begin(), declarations.end());
+		tokens.push_back(0x3E | (1 << 24));
+		tokens[1] = (uint32_t)tokens.size();
+
+		ChunkWriter out;
+		for (size_t i = 0; i < tokens.size(); i++)
+			out.U32(tokens[i]);
+		return out.Bytes;
+	}
+
+	std::vector<uint8_t> Container(const std::vector<std::pair<uint32_t, std::vector<uint8_t>>>& chunks)
+	{
+		uint32_t headerSize = 32 + 4 * (uint32_t)chunks.size();
+		uint32_t total = headerSize;
+		for (size_t i = 0; i < chunks.size(); i++)
+			total += 8 + (uint32_t)chunks[i].second.size();
+
+		ChunkWriter out;
+		out.U32(0x43425844);		// "DXBC"
+		for (int i = 0; i < 4; i++)
+			out.U32(0x11111111);	// Checksum - the parser doesn't check it
+		out.U32(1);
+		out.U32(total);
+		out.U32((uint32_t)chunks.size());
+
+		uint32_t offset = headerSize;
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			out.U32(offset);
+			offset += 8 + (uint32_t)chunks[i].second.size();
+		}
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			out.U32(chunks[i].first);
+			out.U32((uint32_t)chunks[i].second.size());
+			out.Bytes.insert(out.Bytes.end(), chunks[i].second.begin(), chunks[i].second.end());
+		}
+		return out.Bytes;
+	}
+
+	const uint32_t ChunkRDEF = 0x46454452;
+	const uint32_t ChunkISGN = 0x4E475349;
+	const uint32_t ChunkSHEX = 0x58454853;
+	const uint32_t ChunkSHDR = 0x52444853;
+
+	std::vector<uint8_t> ShaderFixture(const ExpectedShader& shader, uint32_t major = 5)
+	{
+		std::vector<std::pair<uint32_t, std::vector<uint8_t>>> chunks;
+		chunks.push_back(std::make_pair(ChunkRDEF, Rdef(shader, major)));
+		if (!shader.Inputs.empty())
+			chunks.push_back(std::make_pair(ChunkISGN, Signature(shader.Inputs)));
+		chunks.push_back(std::make_pair(major >= 5 ? ChunkSHEX : ChunkSHDR, Code(shader.Kind, major, std::vector<uint32_t>())));
+		return Container(chunks);
+	}
+
+	// --------------------------------------------------------
+	// Compares what Parse found against the table.  Real shaders
+	// can have more than the table (fxc is free to add), but
+	// everything in it has to be there with the same values
+	// --------------------------------------------------------
+	void CheckVariable(const ShaderVariableInfo& found, const ExpectedVariable& expected, const std::string& context)
+	{
+		CHECK(found.StartOffset == expected.Offset, context);
+		CHECK(found.Size == expected.Size, context);
+		CHECK(found.Class == expected.Type->Class, context);
+		CHECK(found.BaseType == expected.Type->Base, context);
+		CHECK(found.Rows == expected.Type->Rows && found.Columns == expected.Type->Columns, context);
+		CHECK(found.Elements == expected.Type->Elements, context);
+		CHECK(found.Members.size() == expected.Type->Members.size(), context);
+		for (size_t m = 0; m < found.Members.size() && m < expected.Type->Members.size(); m++)
+		{
+			CHECK(found.Members[m].Name == expected.Type->Members[m].Name, context + "." + found.Members[m].Name);
+			CHECK(found.Members[m].StartOffset == expected.Type->Members[m].Offset, context + "." + found.Members[m].Name);
+		}
+	}
+
+	void CheckShader(const ShaderReflection& reflection, const ExpectedShader& shader, const std::string& context)
+	{
+		CHECK((reflection.Version >> 16) == shader.Kind.Code, context);
+
+		for (size_t b = 0; b < shader.Buffers.size(); b++)
+		{
+			const ExpectedBuffer& expected = shader.Buffers[b];
+			const ShaderBufferInfo* found = nullptr;
+			for (size_t i = 0; i < reflection.ConstantBuffers.size(); i++)
+				if (reflection.ConstantBuffers[i].Name == expected.Name)
+					found = &reflection.ConstantBuffers[i];
+
+			std::string bufferContext = context + " " + expected.Name;
+			CHECK(found != nullptr, bufferContext);
+			if (!found)
+				continue;
+			CHECK(found->Size == expected.Size, bufferContext);
+			CHECK(found->BindPoint == expected.BindPoint, bufferContext);
+			CHECK(found->Variables.size() == expected.Variables.size(), bufferContext);
+			for (size_t v = 0; v < found->Variables.size() && v < expected.Variables.size(); v++)
+			{
+				CHECK(found->Variables[v].Name == expected.Variables[v].Name, bufferContext);
+				CheckVariable(found->Variables[v], expected.Variables[v], bufferContext + "::" + expected.Variables[v].Name);
+			}
+		}
+
+		for (size_t b = 0; b < shader.Bindings.size(); b++)
+		{
+			const ExpectedBinding& expected = shader.Bindings[b];
+			bool found = false;
+			for (size_t i = 0; i < reflection.Bindings.size(); i++)
+			{
+				const ShaderBindingInfo& binding = reflection.Bindings[i];
+				if (binding.Name == expected.Name)
+				{
+					found = true;
+					CHECK(binding.Type == expected.Type && binding.BindPoint == expected.BindPoint && binding.BindCount == 1, context + " " + expected.Name);
+				}
+			}
+			CHECK(found, context + " " + expected.Name);
+		}
+
+		CHECK(reflection.Inputs.size() == shader.Inputs.size(), context + " inputs");
+		for (size_t i = 0; i < reflection.Inputs.size() && i < shader.Inputs.size(); i++)
+		{
+			CHECK(reflection.Inputs[i].SemanticName == shader.Inputs[i].Semantic, context + " input " + shader.Inputs[i].Semantic);
+			CHECK(reflection.Inputs[i].Mask == shader.Inputs[i].Mask, context + " input " + shader.Inputs[i].Semantic);
+		}
+	}
+
+	// --------------------------------------------------------
+	// Every length short of the whole (with the container's own
+	// size field cut to match, so chunks get cut too) and random
+	// corruption past the header.  Nothing is checked but that
+	// Parse comes back - the sanitizer does the rest
+	// --------------------------------------------------------
+	int Fuzz(const std::vector<uint8_t>& container, std::mt19937& random)
+	{
+		ShaderReflection reflection;
+		int parsed = 0;
+		for (size_t n = 0; n < container.size(); n++)
+		{
+			std::vector<uint8_t> cut(container.begin(), container.begin() + n);
+			if (n >= 28)
+			{
+				uint32_t size = (uint32_t)n;
+				memcpy(&cut[24], &size, 4);
+			}
+			parsed += DxbcReflection::Parse(cut.data(), cut.size(), reflection);
+		}
+
+		for (int i = 0; i < 5000 && container.size() > 32; i++)
+		{
+			std::vector<uint8_t> changed = container;
+			int changes = 1 + random() % 4;
+			for (int c = 0; c < changes; c++)
+				changed[32 + random() % (changed.size() - 32)] = (uint8_t)random();
+			parsed += DxbcReflection::Parse(changed.data(), changed.size(), reflection);
+		}
+		return parsed;
+	}
+
+	void RoundTrip(const ShaderReflection& reflection, const std::string& context)
+	{
+		std::vector<uint8_t> blob, again;
+		ShaderReflection back;
+		DxbcReflection::Write(reflection, blob);
+		CHECK(DxbcReflection::Read(blob.data(), blob.size(), back), context);
+		DxbcReflection::Write(back, again);
+		CHECK(blob == again, context);
+		for (size_t n = 0; n < blob.size(); n++)
+			CHECK(!DxbcReflection::Read(blob.data(), n, back), context);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<ExpectedShader> shaders = GameShaders();
+	std::vector<std::pair<std::string, std::vector<uint8_t>>> containers;
+
+	printf("Fixtures\n");
+	for (size_t s = 0; s < shaders.size(); s++)
+	{
+		std::vector<uint8_t> fixture = ShaderFixture(shaders[s]);
+		ShaderReflection reflection;
+		CHECK(DxbcReflection::Parse(fixture.data(), fixture.size(), reflection), shaders[s].File);
+		CheckShader(reflection, shaders[s], std::string("fixture ") + shaders[s].File);
+		RoundTrip(reflection, shaders[s].File);
+		containers.push_back(std::make_pair(std::string("fixture ") + shaders[s].File, fixture));
+	}
+
+	//Shader model 4: no RD11 block and shorter variable records
+	{
+		ExpectedShader old = shaders[0];
+		std::vector<uint8_t> fixture = ShaderFixture(old, 4);
+		ShaderReflection reflection;
+		CHECK(DxbcReflection::Parse(fixture.data(), fixture.size(), reflection), "sm4");
+		CHECK(reflection.Version == ((VertexProgram.Code << 16) | 0x40), "sm4");
+		CHECK(reflection.ConstantBuffers.size() == 2 && reflection.ConstantBuffers[1].Variables[1].StartOffset == 64, "sm4");
+		containers.push_back(std::make_pair(std::string("sm4 fixture"), fixture));
+	}
+
+	//Compute: a custom data block ahead of dcl_thread_group 8, 8, 1
+	{
+		ExpectedShader compute = { "compute", ComputeProgram, { { "Params", 0, 16, { { "size", 0, 4, &Float } } } }, {}, {} };
+		std::vector<uint32_t> declarations = { 0x35, 4, 0xAAAA, 0xBBBB, 0x6A | (1 << 24), 0x9B | (4 << 24), 8, 8, 1 };
+		std::vector<std::pair<uint32_t, std::vector<uint8_t>>> chunks;
+		chunks.push_back(std::make_pair(ChunkRDEF, Rdef(compute, 5)));
+		chunks.push_back(std::make_pair(ChunkSHEX, Code(ComputeProgram, 5, declarations)));
+		std::vector<uint8_t> fixture = Container(chunks);
+
+		ShaderReflection reflection;
+		CHECK(DxbcReflection::Parse(fixture.data(), fixture.size(), reflection), "compute");
+		CHECK(reflection.GetThreadGroupSize() == 64 && reflection.ThreadGroup[2] == 1, "compute");
+		containers.push_back(std::make_pair(std::string("compute fixture"), fixture));
+
+		//Code cut off inside dcl_thread_group - no group size, but the rest still parses
+		std::vector<uint8_t> cut = Code(ComputeProgram, 5, declarations);
+		cut.resize(cut.size() - 12);
+		chunks[1].second = cut;
+		fixture = Container(chunks);
+		CHECK(DxbcReflection::Parse(fixture.data(), fixture.size(), reflection), "cut compute");
+		CHECK(reflection.GetThreadGroupSize() == 0, "cut compute");
+	}
+
+	//Reflection stripped - nothing to go on
+	{
+		std::vector<std::pair<uint32_t, std::vector<uint8_t>>> chunks;
+		chunks.push_back(std::make_pair(ChunkISGN, Signature(shaders[0].Inputs)));
+		chunks.push_back(std::make_pair(ChunkSHEX, Code(VertexProgram, 5, std::vector<uint32_t>())));
+		std::vector<uint8_t> fixture = Container(chunks);
+		ShaderReflection reflection;
+		CHECK(!DxbcReflection::Parse(fixture.data(), fixture.size(), reflection), "stripped");
+	}
+
+	//The real thing, when there's a build to look at
+	if (argc > 1)
+	{
+		printf("Compiled shaders in %s\n", argv[1]);
+		for (size_t s = 0; s < shaders.size(); s++)
+		{
+			std::string path = std::string(argv[1]) + "/" + shaders[s].File;
+			MappedFile file(path.c_str());
+			ShaderReflection reflection;
+			CHECK(file.IsOpen(), path);
+			if (!file.IsOpen())
+				continue;
+
+			CHECK(DxbcReflection::Parse(file.GetData(), file.GetSize(), reflection), path);
+			CheckShader(reflection, shaders[s], path);
+			RoundTrip(reflection, path);
+			containers.push_back(std::make_pair(path, std::vector<uint8_t>(file.GetData(), file.GetData() + file.GetSize())));
+		}
+	}
+	else
+		printf("No shader folder given - only the fixtures are checked\n");
+
+	std::mt19937 random(1);
+	for (size_t c = 0; c < containers.size(); c++)
+	{
+		int parsed = Fuzz(containers[c].second, random);
+		printf("Fuzzed %s (%zu bytes): %d damaged copies still parsed\n", containers[c].first.c_str(), containers[c].second.size(), parsed);
+	}
+
+	if (failures)
+	{
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("All passed\n");
+	return 0;
+}
@@ -1,5 +1,10 @@
 #include "Entity.h"
+#include "ShaderConstants.h"
 #include <d3d11.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 
 using namespace DirectX;
 
@@ -7,6 +12,7 @@ Entity::Entity(Mesh* mesh, Material* mat, bool draw)
 {
 	mesh_ = mesh;
 	material_ = mat;
+	albedoSlice_ = 0;
 
 	shouldDraw = draw;
 }
@@ -40,26 +46,142 @@ bool Entity::GetDrawState()
 	return shouldDraw;
 }
 
+void Entity::SetAlbedoSlice(int slice)
+{
+	albedoSlice_ = slice;
+}
+
+int Entity::GetAlbedoSlice()
+{
+	return albedoSlice_;
+}
+
 void Entity::Draw(Microsoft::WRL::ComPtr<ID3D11DeviceContext> cntxt,Camera* c,float totalTime)
 {
 	//Used to have to do VS or PS SetShader from the context before added simple shader
 	material_->GetVertexShader()->SetShader();
 	material_->GetPixelShader()->SetShader();
 	
+	SetDrawParameters();
+
+	//Pick the level of detail from how much of the screen the mesh's bounding sphere covers
+	XMFLOAT3 bMin = mesh_->GetBoundsMin();
+	XMFLOAT3 bMax = mesh_->GetBoundsMax();
+	XMFLOAT3 scale = transform_.GetScale();
+	XMFLOAT4X4 world = transform_.GetWorldMatrix();
+
+	XMFLOAT3 center;
+	XMVECTOR localCenter = XMVectorSet((bMin.x + bMax.x) * 0.5f, (bMin.y + bMax.y) * 0.5f, (bMin.z + bMax.z) * 0.5f, 1.0f);
+	XMStoreFloat3(&center, XMVector3TransformCoord(localCenter, XMLoadFloat4x4(&world)));
+
+	float maxScale = (std::max)(fabsf(scale.x), (std::max)(fabsf(scale.y), fabsf(scale.z)));
+	float radius = 0.5f * XMVectorGetX(XMVector3Length(XMLoadFloat3(&bMax) - XMLoadFloat3(&bMin))) * maxScale;
+
+	int lod = mesh_->SelectLod(c->GetScreenSize(center, radius));
+
+	//Full detail gets culled a meshlet at a time, when the mesh has them
+	if (lod == 0 && mesh_->GetMeshletCount() > 0)
+	{
+		XMFLOAT4 planes[6];
+		c->GetFrustumPlanes(planes);
+		mesh_->DrawClusters(MeshletCuller::MakeView(planes, c->GetTransform()->GetPosition(), world));
+	}
+	else
+	{
+		mesh_->Draw(lod);
+	}
+}
+
+// --------------------------------------------------------
+// Per-object shader variables, as whole PerObject buffers
+// (the generated structs) at the indices the material already
+// resolved.  Only those buffers are copied - the camera and
+// lights went up once this frame (Game::Draw) and the tint
+// when the material was bound
+// --------------------------------------------------------
+void Entity::SetDrawParameters()
+{
+	const Material::DrawParameters& params = material_->GetDrawParameters();
+
+	VertexShaderPerObject objectData = {};
+	objectData.world = transform_.GetWorldMatrix();	//Get world matrix from entities transform
+	objectData.worldInvTranspose = transform_.GetWorldInverseTranspose();
 	SimpleVertexShader* vs = material_->GetVertexShader();
-	vs->SetMatrix4x4("world", transform_.GetWorldMatrix());	//Get world matrix from entities transform
-	vs->SetMatrix4x4("view", c->GetView());					//Get View matrix from passed in camera
-	vs->SetMatrix4x4("projection", c->GetProjection());			//Get Projection matrix from passed in camera
-	vs->SetMatrix4x4("worldInvTranspose", transform_.GetWorldInverseTranspose());
+	vs->SetBuffer(params.World.ConstantBufferIndex, objectData);
+	vs->CopyBufferData(params.World.ConstantBufferIndex);
 
-	vs->CopyAllBufferData();
-	//Used to have to manually copy it over using memcpy, but now uses simple shader call to copy the buffer 
+	//Packed vertices are scaled back to the mesh's bounds and UV range in the vertex shader.
+	//Entities sharing a mesh set the same values, which SetBuffer sees and doesn't upload again
+	if (params.Quantization.IsValid() && mesh_->HasPackedVertices())
+	{
+		VertexQuantization q = mesh_->GetQuantization();
+		PackedVertexShaderPerMesh meshData = {};
+		meshData.positionOffset = q.PositionOffset;
+		meshData.positionScale = q.PositionScale;
+		meshData.uvOffset = q.UVOffset;
+		meshData.uvScale = q.UVScale;
+		vs->SetBuffer(params.Quantization.ConstantBufferIndex, meshData);
+		vs->CopyBufferData(params.Quantization.ConstantBufferIndex);
+	}
 
+	PixelShaderPerObject surfaceData = {};
+	surfaceData.albedoSlice = (float)albedoSlice_;
 	SimplePixelShader* ps = material_->GetPixelShader();
-	ps->SetFloat4("colorTint", material_->GetColorTint());	//Get color tint from the material
-	ps->SetFloat3("cameraPosition", c->GetTransform()->GetPosition()); //Needs to be adjusted when >1 camera is in scene - needs current camera
+	ps->SetBuffer(params.AlbedoSlice.ConstantBufferIndex, surfaceData);
+	ps->CopyBufferData(params.AlbedoSlice.ConstantBufferIndex);
+}
+
+// --------------------------------------------------------
+// Times the CPU side of setting one draw's shader variables,
+// by name, through resolved parameters and as whole buffers.
+// Only the local buffers are written - nothing goes to the GPU
+// --------------------------------------------------------
+void Entity::Benchmark(Material* material, int draws)
+{
+	SimpleVertexShader* vs = material->GetVertexShader();
+	SimplePixelShader* ps = material->GetPixelShader();
+	const Material::DrawParameters& params = material->GetDrawParameters();
+	Transform transform;
+
+	double byName = 1e30;
+	double byParameter = 1e30;
+	double byBuffer = 1e30;
+	for (int round = 0; round < 5; round++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < draws; i++)
+		{
+			vs->SetMatrix4x4("world", transform.GetWorldMatrix());
+			vs->SetMatrix4x4("worldInvTranspose", transform.GetWorldInverseTranspose());
+			ps->SetFloat("albedoSlice", (float)(i & 3));
+		}
+		std::chrono::high_resolution_clock::time_point middle = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < draws; i++)
+		{
+			vs->SetMatrix4x4(params.World, transform.GetWorldMatrix());
+			vs->SetMatrix4x4(params.WorldInvTranspose, transform.GetWorldInverseTranspose());
+			ps->SetFloat(params.AlbedoSlice, (float)(i & 3));
+		}
+		std::chrono::high_resolution_clock::time_point resolved = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < draws; i++)
+		{
+			VertexShaderPerObject objectData = {};
+			objectData.world = transform.GetWorldMatrix();
+			objectData.worldInvTranspose = transform.GetWorldInverseTranspose();
+			vs->SetBuffer(params.World.ConstantBufferIndex, objectData);
+
+			PixelShaderPerObject surfaceData = {};
+			surfaceData.albedoSlice = (float)(i & 3);
+			ps->SetBuffer(params.AlbedoSlice.ConstantBufferIndex, surfaceData);
+		}
+		std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
 
-	ps->CopyAllBufferData();
+		byName = (std::min)(byName, std::chrono::duration<double>(middle - start).count());
+		byParameter = (std::min)(byParameter, std::chrono::duration<double>(resolved - middle).count());
+		byBuffer = (std::min)(byBuffer, std::chrono::duration<double>(end - resolved).count());
+	}
 
-	mesh_->Draw();
+	printf("Entity::Benchmark - %d draws (best of 5): by name %.1f ns/draw, by parameter %.1f ns/draw (%.1fx), by buffer %.1f ns/draw (%.1fx)\n", draws,
+		byName * 1e9 / draws, byParameter * 1e9 / draws, byParameter > 0.0 ? byName / byParameter : 0.0,
+		byBuffer * 1e9 / draws, byBuffer > 0.0 ? byName / byBuffer : 0.0);
 }
@@ -10,7 +10,10 @@ private:
 	Mesh* mesh_;
 	Transform transform_;
 	Material* material_;
+	int albedoSlice_;		//Which slice of the material's albedo array this entity uses
 	bool shouldDraw;
+
+	void SetDrawParameters();
 	
 public:
 	Entity(Mesh* mesh, Material* mat, bool draw);
@@ -23,6 +26,12 @@ public:
 	void SetDrawState(bool draw);
 	bool GetDrawState();
 
+	void SetAlbedoSlice(int slice);
+	int GetAlbedoSlice();
+
 	void Draw(Microsoft::WRL::ComPtr<ID3D11DeviceContext> cntxt, Camera* c,float deltaTime);
+
+	// Prints the CPU cost of one draw's per-object shader variables, set by name and through resolved parameters
+	static void Benchmark(Material* material, int draws);
 };
 
@@ -0,0 +1,121 @@
+#include "FileSystem.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	void ListFilesIn(const std::string& directory, const std::string& prefix, std::vector<std::string>& files)
+	{
+	#ifdef _WIN32
+		WIN32_FIND_DATAA found;
+		HANDLE find = FindFirstFileA((directory + "\\*").c_str(), &found);
+		if (find == INVALID_HANDLE_VALUE)
+			return;
+
+		do
+		{
+			std::string name = found.cFileName;
+			if (name == "." || name == "..")
+				continue;
+
+			if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				ListFilesIn(directory + "\\" + name, prefix + name + "/", files);
+			else
+				files.push_back(prefix + name);
+		} while (FindNextFileA(find, &found));
+		FindClose(find);
+	#else
+		DIR* dir = opendir(directory.c_str());
+		if (!dir)
+			return;
+
+		while (dirent* found = readdir(dir))
+		{
+			std::string name = found->d_name;
+			if (name == "." || name == "..")
+				continue;
+
+			struct stat info;
+			std::string path = directory + "/" + name;
+			if (stat(path.c_str(), &info) != 0)
+				continue;
+
+			if (S_ISDIR(info.st_mode))
+				ListFilesIn(path, prefix + name + "/", files);
+			else if (S_ISREG(info.st_mode))
+				files.push_back(prefix + name);
+		}
+		closedir(dir);
+	#endif
+	}
+}
+
+void FileSystem::ListFiles(const std::string& root, std::vector<std::string>& files)
+{
+	files.clear();
+	ListFilesIn(root, "", files);
+
+	//Directory order isn't defined - sorted, the same folder always lists the same way
+	std::sort(files.begin(), files.end());
+}
+
+bool FileSystem::GetStamp(const std::string& path, FileStamp& stamp)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &info) || (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		return false;
+
+	stamp.Size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+	stamp.ModifiedTime = (int64_t)(((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime);
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+		return false;
+
+	stamp.Size = (uint64_t)info.st_size;
+	#ifdef __linux__
+		stamp.ModifiedTime = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+	#else
+		stamp.ModifiedTime = (int64_t)info.st_mtime;
+	#endif
+#endif
+	return true;
+}
+
+bool FileSystem::CreateDirectories(const std::string& path)
+{
+	//Each prefix ending at a separator, then the whole path
+	for (size_t i = 1; i <= path.size(); i++)
+	{
+		if (i < path.size() && path[i] != '/' && path[i] != '\\')
+			continue;
+
+		std::string directory = path.substr(0, i);
+		if (directory.back() == ':')
+			continue;
+
+	#ifdef _WIN32
+		if (!CreateDirectoryA(directory.c_str(), 0) && GetLastError() != ERROR_ALREADY_EXISTS)
+			return false;
+	#else
+		if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+			return false;
+	#endif
+	}
+	return true;
+}
+
+std::string FileSystem::GetDirectory(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? std::string() : path.substr(0, slash);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Size and last write time - enough to tell that a file
+// hasn't changed without reading it
+// --------------------------------------------------------
+struct FileStamp
+{
+	uint64_t Size = 0;
+	int64_t ModifiedTime = 0;		// Platform units (100 ns on Windows, ns on Linux) - only compared, never shown
+
+	bool operator==(const FileStamp& other) const { return Size == other.Size && ModifiedTime == other.ModifiedTime; }
+	bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+// --------------------------------------------------------
+// The few file system operations the offline tools need, on
+// Windows and POSIX (C++14 has no <filesystem>)
+// --------------------------------------------------------
+class FileSystem
+{
+public:
+	// Every file under root, as '/' separated paths relative to it, sorted
+	static void ListFiles(const std::string& root, std::vector<std::string>& files);
+
+	// False if the file doesn't exist
+	static bool GetStamp(const std::string& path, FileStamp& stamp);
+
+	// Makes every missing folder along path
+	static bool CreateDirectories(const std::string& path);
+
+	// Everything before the last separator ("" if there isn't one)
+	static std::string GetDirectory(const std::string& path);
+};
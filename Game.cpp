@@ -29,6 +29,15 @@ Game::Game(HINSTANCE hInstance)
 		true)						// Show extra stats (fps) in title bar?
 {
 	camera1 = 0;
+	geometryArena = 0;
+	packedArena = 0;
+	meshRegistry = 0;
+	assetPack = 0;
+	skyLighting = 0;
+	pixelShaderText = 0;
+	cambriaFont = 0;
+	textureResidency = 0;
+	textureBudget = 64 * 1024 * 1024;
 
 	#if defined(DEBUG) || defined(_DEBUG)
 		// Do we want a console window?  Probably only in debug mode
@@ -55,6 +64,9 @@ Game::~Game()
 	delete vertexShader;
 	vertexShader = nullptr;
 
+	delete packedVertexShader;
+	packedVertexShader = nullptr;
+
 	delete pixelShader;
 	pixelShader = nullptr;
 
@@ -64,20 +76,36 @@ Game::~Game()
 	delete pixelShaderSky;
 	pixelShaderSky = nullptr;
 
+	delete pixelShaderText;
+	pixelShaderText = nullptr;
+
 	delete skyInstance;
 	skyInstance = nullptr;
 
+	delete skyLighting;
+	skyLighting = nullptr;
+
 	//Clean up camera (just required one here)
 	delete camera1;
 	camera1 = nullptr;
 
 	//Clean up lists of meshes, entities (obstacles and player included!) & materials
-	for (int i = 0; i < meshes.size(); i++)
+	for (int i = 0; i < meshHandles.size(); i++)
 	{
-		delete meshes[i];
+		meshRegistry->Release(meshHandles[i]);
 		meshes[i] = nullptr;
 	}
 
+	delete meshRegistry;
+	meshRegistry = nullptr;
+
+	//After the meshes, which hand their ranges back to it
+	delete geometryArena;
+	geometryArena = nullptr;
+
+	delete packedArena;
+	packedArena = nullptr;
+
 	for (int i = 0; i < entities.size(); i++)
 	{
 		delete entities[i];
@@ -90,6 +118,21 @@ Game::~Game()
 		materials[i] = nullptr;
 	}
 
+	#if defined(DEBUG) || defined(_DEBUG)
+		if (textureResidency)
+			textureResidency->Report();
+
+		SimpleUploadStats uploads = ISimpleShader::LastFrameUploadStats;
+		printf("Constant buffers, last frame: %u uploads (%u partial, %u mapped), %u skipped, %zu bytes\n",
+			uploads.Uploads, uploads.PartialUploads, uploads.Maps, uploads.Skipped, uploads.BytesUploaded);
+	#endif
+	delete textureResidency;
+	textureResidency = nullptr;
+
+	//After the textures, which may still be decoding from it
+	delete assetPack;
+	assetPack = nullptr;
+
 	for (int i = 0; i < chunks.size(); i++)
 	{
 		delete chunks[i];
@@ -99,8 +142,8 @@ Game::~Game()
 	delete sBatch;
 	sBatch = nullptr;
 
-	delete cambriaFont26;
-	cambriaFont26 = nullptr;
+	delete cambriaFont;
+	cambriaFont = nullptr;
 }
 
 // --------------------------------------------------------
@@ -152,11 +195,37 @@ void Game::Init()
 // --------------------------------------------------------
 void Game::LoadShaders()
 {
+	//Reflection from the last run - only shaders whose bytecode changed get parsed again
+	ShaderReflectionCache reflectionCache;
+	reflectionCache.Load(GetFullPathTo("ShaderReflection.cache").c_str());
+	ISimpleShader::ReflectionCache = &reflectionCache;
+
 	vertexShader = new SimpleVertexShader(device.Get(),context.Get(),GetFullPathTo_Wide(L"VertexShader.cso").c_str());
 	vertexShaderSky = new SimpleVertexShader(device.Get(), context.Get(), GetFullPathTo_Wide(L"SkyVertexShader.cso").c_str());
 
 	pixelShader = new SimplePixelShader(device.Get(), context.Get(), GetFullPathTo_Wide(L"PixelShader.cso").c_str());
 	pixelShaderSky = new SimplePixelShader(device.Get(), context.Get(), GetFullPathTo_Wide(L"SkyPixelShader.cso").c_str());
+	pixelShaderText = new SimplePixelShader(device.Get(), context.Get(), GetFullPathTo_Wide(L"SdfTextPixelShader.cso").c_str());
+
+	//Packed vertices are 16-bit normalized values, which the layout SimpleShader builds from
+	//reflection (32-bit only) can't describe - this one's layout comes from the format instead
+	std::wstring packedPath = GetFullPathTo_Wide(L"PackedVertexShader.cso");
+	Microsoft::WRL::ComPtr<ID3DBlob> packedBlob;
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> packedLayout;
+	if (SUCCEEDED(D3DReadFileToBlob(packedPath.c_str(), packedBlob.GetAddressOf())))
+		device->CreateInputLayout(Unorm16VertexFormat::InputElements, Unorm16VertexFormat::InputElementCount, packedBlob->GetBufferPointer(), packedBlob->GetBufferSize(), packedLayout.GetAddressOf());
+	packedVertexShader = new SimpleVertexShader(device.Get(), context.Get(), packedPath.c_str(), packedLayout, false);
+
+	//Without it the meshes stay full floats
+	materialVertexShader = packedLayout && packedVertexShader->IsShaderValid() ? packedVertexShader : vertexShader;
+
+	reflectionCache.Save();
+	ISimpleShader::ReflectionCache = nullptr;
+
+	//Per-object data changes every draw, so those buffers are rewritten whole rather than updated
+	vertexShader->SetBufferUploadMode("PerObject", SimpleUploadMode::MapDiscard);
+	packedVertexShader->SetBufferUploadMode("PerObject", SimpleUploadMode::MapDiscard);
+	pixelShader->SetBufferUploadMode("PerObject", SimpleUploadMode::MapDiscard);
 }
 
 
@@ -164,9 +233,22 @@ void Game::LoadShaders()
 //Creation/storing of meshes, textures & entities
 void Game::SetupGameObjects()
 {
-	// Set up sprite batch and sprite font
+	//One mapped file instead of one per asset - anything not in it is loaded loose
+	assetPack = new AssetPack(GetFullPathTo("../../Assets/Assets.pack").c_str());
+	#if defined(DEBUG) || defined(_DEBUG)
+		if (assetPack->IsOpen())
+			printf("Assets.pack: %zu assets (%zu unique)\n", assetPack->GetEntryCount(), assetPack->GetBlobCount());
+		else
+			printf("No Assets.pack - loading loose files\n");
+	#endif
+
+	// Set up sprite batch and the distance field font (every text size comes from its one atlas)
 	sBatch = new SpriteBatch(context.Get());
-	cambriaFont26 = new SpriteFont(device.Get(), GetFullPathTo_Wide(L"../../Assets/Fonts/Cambria26.spritefont").c_str());
+	cambriaFont = new SdfFont();
+	cambriaFont->Load(device, assetPack,
+		GetFullPathTo("../../Assets/Fonts/Cambria.sdffont"),
+		GetFullPathTo("../../Cooked/Fonts/Cambria.sdffont"),
+		GetFullPathTo("../../Assets/Fonts/Cambria72.spritefont"));
 
 
 	// Create some temporary variables to represent colors
@@ -174,11 +256,28 @@ void Game::SetupGameObjects()
 	XMFLOAT3 normal = XMFLOAT3(0, 0, -1);
 	XMFLOAT2 uv = XMFLOAT2(0, 0);
 
-	Mesh* cubeMesh = new Mesh(GetFullPathTo("../../Assets/Models/cube.obj").c_str(), device, context);
-	Mesh* quadMesh = new Mesh(GetFullPathTo("../../Assets/Models/quad.obj").c_str(), device, context);
+	geometryArena = new GeometryArena(device, context);
+	packedArena = new GeometryArena(device, context, 65536, 1 << 20, Unorm16VertexFormat::Stride);
+	meshRegistry = new MeshRegistry(device, context, geometryArena, assetPack, packedArena);
+
+	//Entities draw packed meshes (20 bytes a vertex instead of 48) when the packed shader loaded.
+	//The sky's vertex shader takes full floats, so it asks for the cube separately - without
+	//packing the registry hands back the same mesh
+	bool packed = materialVertexShader == packedVertexShader;
+	const char* modelPaths[] = { "../../Assets/Models/cube.obj", "../../Assets/Models/quad.obj", "../../Assets/Models/cube.obj" };
+	bool modelPacked[] = { packed, packed, false };
+	for (int i = 0; i < 3; i++)
+	{
+		MeshHandle handle = meshRegistry->Acquire(GetFullPathTo(modelPaths[i]), modelPacked[i]);
+		meshHandles.push_back(handle);
+		meshes.push_back(meshRegistry->Get(handle));
+	}
+	meshRegistry->UploadPending();
+
+	Mesh* skyMesh = meshes[2];
 
-	meshes.push_back(cubeMesh);
-	meshes.push_back(quadMesh);
+	geometryArena->ReportStats("Geometry arena");
+	packedArena->ReportStats("Packed geometry arena");
 
 	D3D11_SAMPLER_DESC normalSamplerDesc = {};
 
@@ -196,55 +295,61 @@ void Game::SetupGameObjects()
 	//Create sample state - using desc. + pointer to it
 	device->CreateSamplerState(&normalSamplerDesc, normalSamplerState.GetAddressOf());
 
-	//WIC Textures
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/no_normal.png").c_str(), nullptr, obstacleNormal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/bronze_roughness.png").c_str(), nullptr, obstacleRoughness.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/bronze_metal.png").c_str(), nullptr, obstacleMetal.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/no_metalness.png").c_str(), nullptr, noMetal.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/obstacle_green.png").c_str(), nullptr, obstacleGreen.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/obstacle_orange.png").c_str(), nullptr, obstacleOrange.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/obstacle_pink.png").c_str(), nullptr, obstaclePink.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/obstacle_purple.png").c_str(), nullptr, obstaclePurple.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/obstacle_turquoise.png").c_str(), nullptr, obstacleTurquoise.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/obstacle_yellow.png").c_str(), nullptr, obstacleYellow.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/floor.png").c_str(), nullptr, floorSRV.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/player.png").c_str(), nullptr, playerSRV.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), GetFullPathTo_Wide(L"../../Assets/Textures/player_metal.png").c_str(), nullptr, playerMetal.GetAddressOf());
+	//Textures - nothing is read yet.  Each one loads (decoded with whatever else was
+	//missed that frame) once a material draws with it; until then it's a flat colour
+	textureResidency = new TextureResidency(device, context, assetPack, textureBudget);
+	textureResidency->SetCookedRoots(GetFullPathTo("../../Assets/"), GetFullPathTo("../../Cooked/"));
+	XMFLOAT4 flatAlbedo = XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f);
+	XMFLOAT4 flatNormal = XMFLOAT4(0.5f, 0.5f, 1.0f, 1.0f);
+	XMFLOAT4 midRoughNotMetal = XMFLOAT4(0.5f, 0.0f, 0.0f, 1.0f);
+
+	//Roughness and metalness share a texture (see Assets/Textures/RoughnessMetalness.txt)
+	std::string bronzeRoughness = GetFullPathTo("../../Assets/Textures/bronze_roughness.png");
+	obstacleNormal = textureResidency->Add(GetFullPathTo("../../Assets/Textures/no_normal.png"), flatNormal);
+	obstacleRoughMetal = textureResidency->AddRoughnessMetalness(bronzeRoughness, GetFullPathTo("../../Assets/Textures/bronze_metal.png"), midRoughNotMetal);
+	floorRoughMetal = textureResidency->AddRoughnessMetalness(bronzeRoughness, GetFullPathTo("../../Assets/Textures/no_metalness.png"), midRoughNotMetal);
+
+	std::vector<std::string> obstacleColors;
+	obstacleColors.push_back(GetFullPathTo("../../Assets/Textures/obstacle_green.png"));
+	obstacleColors.push_back(GetFullPathTo("../../Assets/Textures/obstacle_orange.png"));
+	obstacleColors.push_back(GetFullPathTo("../../Assets/Textures/obstacle_pink.png"));
+	obstacleColors.push_back(GetFullPathTo("../../Assets/Textures/obstacle_purple.png"));
+	obstacleColors.push_back(GetFullPathTo("../../Assets/Textures/obstacle_turquoise.png"));
+	obstacleColors.push_back(GetFullPathTo("../../Assets/Textures/obstacle_yellow.png"));
+	obstacleAlbedoCount = (int)obstacleColors.size();
+	obstacleAlbedos = textureResidency->AddArray(obstacleColors, flatAlbedo);
+
+	//Albedo is always an array in the pixel shader, so these are one-slice arrays
+	floorSRV = textureResidency->AddArray(std::vector<std::string>(1, GetFullPathTo("../../Assets/Textures/floor.png")), flatAlbedo);
+	playerSRV = textureResidency->AddArray(std::vector<std::string>(1, GetFullPathTo("../../Assets/Textures/player.png")), flatAlbedo);
+	playerRoughMetal = textureResidency->AddRoughnessMetalness(bronzeRoughness, GetFullPathTo("../../Assets/Textures/player_metal.png"), midRoughNotMetal);
 
 	//Sky stuff
-	skyInstance = new Sky(cubeMesh, vertexShaderSky, pixelShaderSky, normalSamplerState, device, GetFullPathTo_Wide(L"../../Assets/Textures/blueGradient.dds").c_str());
+	skyInstance = new Sky(skyMesh, vertexShaderSky, pixelShaderSky, normalSamplerState, device, context, GetFullPathTo("../../Assets/Textures/blueGradient.dds").c_str(), assetPack);
+	skyLighting = new SkyLighting();
+	skyLighting->Load(device, assetPack, GetFullPathTo("../../Assets/"), GetFullPathTo("../../Cooked/"), "Textures/blueGradient");
 
 
 	//Making materials and storing them
 
-	CreateObstacleMaterial(obstacleGreen);
-	CreateObstacleMaterial(obstacleOrange);
-	CreateObstacleMaterial(obstaclePink);
-	CreateObstacleMaterial(obstaclePurple);
-	CreateObstacleMaterial(obstacleTurquoise);
-	CreateObstacleMaterial(obstacleYellow);
+	CreateObstacleMaterial(obstacleAlbedos);
 	
-	Material* floorMat = new Material(pixelShader, vertexShader, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+	Material* floorMat = new Material(pixelShader, materialVertexShader, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
 	floorMat->AddSampler("BasicSampler", normalSamplerState);
-	floorMat->AddTextureSRV("Albedo", floorSRV);
-	floorMat->AddTextureSRV("NormalMap", obstacleNormal);
-	floorMat->AddTextureSRV("RoughnessMap", obstacleRoughness);
-	floorMat->AddTextureSRV("MetalnessMap", noMetal);
+	floorMat->AddTexture("Albedo", textureResidency, floorSRV);
+	floorMat->AddTexture("NormalMap", textureResidency, obstacleNormal);
+	floorMat->AddTexture("RoughMetalMap", textureResidency, floorRoughMetal);
 
-	Material* playerMat = new Material(pixelShader, vertexShader, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+	Material* playerMat = new Material(pixelShader, materialVertexShader, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
 	playerMat->AddSampler("BasicSampler", normalSamplerState);
-	playerMat->AddTextureSRV("Albedo", playerSRV);
-	playerMat->AddTextureSRV("NormalMap", obstacleNormal);
-	playerMat->AddTextureSRV("RoughnessMap", obstacleRoughness);
-	playerMat->AddTextureSRV("MetalnessMap", playerMetal);
+	playerMat->AddTexture("Albedo", textureResidency, playerSRV);
+	playerMat->AddTexture("NormalMap", textureResidency, obstacleNormal);
+	playerMat->AddTexture("RoughMetalMap", textureResidency, playerRoughMetal);
 	
 	materials.push_back(floorMat);
 	materials.push_back(playerMat);
 
-	Entity *floor = new Entity(meshes[1],materials[6],true);
+	Entity *floor = new Entity(meshes[1],materials[1],true);
 	floorInitialPosition = XMFLOAT3(0.0f, -5.0f, 2.0f);
 	Transform *floorTransform = floor->GetTransform();
 	floorTransform->SetScale(5.0f, 5.0f, 40.0f);
@@ -272,21 +377,20 @@ void Game::SetupGameObjects()
 	
 
 	//Add player
-	player = new Player(meshes[0], materials[7]);
+	player = new Player(meshes[0], materials[2]);
 	player->GetTransform()->SetScale(1.0f, 1.0f, 1.0f);
 	player->GetTransform()->MoveGlobal(0.0f, -4.5f, -35.0f);
 
 	entities.push_back(player);
 }
 
-void Game::CreateObstacleMaterial(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> albedo)
+void Game::CreateObstacleMaterial(TextureHandle albedo)
 {
-	Material* mat = new Material(pixelShader, vertexShader, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+	Material* mat = new Material(pixelShader, materialVertexShader, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
 	mat->AddSampler("BasicSampler", normalSamplerState);
-	mat->AddTextureSRV("Albedo", albedo);
-	mat->AddTextureSRV("NormalMap", obstacleNormal);
-	mat->AddTextureSRV("RoughnessMap", obstacleRoughness);
-	mat->AddTextureSRV("MetalnessMap", obstacleMetal);
+	mat->AddTexture("Albedo", textureResidency, albedo);
+	mat->AddTexture("NormalMap", textureResidency, obstacleNormal);
+	mat->AddTexture("RoughMetalMap", textureResidency, obstacleRoughMetal);
 
 	materials.push_back(mat);
 }
@@ -296,10 +400,9 @@ std::vector<Entity*> Game::InitializeChunkObstacleList()
 	std::vector<Entity*> tempList;
 	for (int i = 0; i < chunkSlotAmount; i++)
 	{
-		Material* m = materials[(rand() % (materials.size() - 2))];
-
 		//Garbage collection handled by the larger entity list 'entities'
-		Entity* o = new Entity(meshes[0], m, false);
+		Entity* o = new Entity(meshes[0], materials[0], false);
+		o->SetAlbedoSlice(rand() % obstacleAlbedoCount);
 
 		Transform* oTransform = o->GetTransform();
 		
@@ -490,6 +593,12 @@ void Game::Update(float deltaTime, float totalTime)
 	//Get a reference to the input manager
 	Input& input = Input::GetInstance(); //Used for starting/retrying to simplify the 'player' implementation (keep it away from state machine stuff)
 
+	#if defined(DEBUG) || defined(_DEBUG)
+		//F1 times setting a draw's shader variables on the floor's material (prints to the console)
+		if (input.KeyPress(VK_F1))
+			Entity::Benchmark(entities[0]->GetMaterial(), 10000);
+	#endif
+
 	switch (currentGameState)
 	{
 	case GameState::InGame:
@@ -530,17 +639,45 @@ void Game::Draw(float deltaTime, float totalTime)
 	context->ClearRenderTargetView(backBufferRTV.Get(), color);
 	context->ClearDepthStencilView(depthStencilView.Get(),D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL,1.0f,0);
 
+	//The sprite batch rebinds its own buffers after the meshes each frame
+	Mesh::ResetBindings();
+	ISimpleShader::ResetUploadStats();
+
+	//Loads whatever was drawn with a placeholder last frame, then trims to the budget
+	textureResidency->Update();
+	meshRegistry->UploadPending();
+
+	//Every material uses the same two shaders, so the per-frame data (sky light, lights,
+	//camera) is set and uploaded once, before any entity
+	//Each buffer is filled as its generated struct and set in one copy
+	PixelShaderPerFrame frame = {};
+	for (int i = 0; i < 6; i++)
+		frame.lights[i] = lightsArr[i];
+	frame.ambient = ambientColor;
+	frame.cameraPosition = camera1->GetTransform()->GetPosition();
+	skyLighting->Bind(pixelShader, frame);
+	pixelShader->SetBuffer(frame);
+	pixelShader->CopyBufferData(PixelShaderPerFrame::BufferName);
+
+	VertexShaderPerFrame cameraData = {};
+	cameraData.view = camera1->GetView();
+	cameraData.projection = camera1->GetProjection();
+	materialVertexShader->SetBuffer(cameraData);
+	materialVertexShader->CopyBufferData(VertexShaderPerFrame::BufferName);
+
 	// DRAW EACH ENTITY
+	Material* boundMaterial = nullptr;
 	for(int i = 0; i < entities.size(); i++)
 	{
 		//If it is supposed to be drawn (basically to enable or disable an objects rendering)
 		if (entities[i]->GetDrawState() == true)
 		{
-			SimplePixelShader* p = entities[i]->GetMaterial()->GetPixelShader();
-
-			p->SetData("lights", &lightsArr, sizeof(Light) * 6);
-			p->SetFloat3("ambient", ambientColor);
-			entities[i]->GetMaterial()->ReadyTexture();
+			//Obstacles all share one material, so its data and textures only need binding once
+			if (entities[i]->GetMaterial() != boundMaterial)
+			{
+				entities[i]->GetMaterial()->Bind();
+				boundMaterial = entities[i]->GetMaterial();
+			}
 			entities[i]->Draw(context, camera1, totalTime);
 		}
 	}
@@ -584,10 +721,13 @@ void Game::Draw(float deltaTime, float totalTime)
 void Game::DisplayHUD()
 {
 
-	sBatch->Begin();
+	if (!cambriaFont->IsLoaded())
+		return;
+
+	cambriaFont->Begin(sBatch, pixelShaderText);
 	//thanks to IGME 540 '2D Rendering With Spritebatch w/ the to_string()
 	std::string hudText = "Chunks Survived : " + std::to_string(chunkNumber-2);
-	cambriaFont26->DrawString(sBatch, hudText.c_str(), XMFLOAT2(0, 0));
+	cambriaFont->DrawString(sBatch, hudText.c_str(), XMFLOAT2(0, 0), GetTextLineHeight());
 	sBatch->End();
 
 	//End() doesn't reset a couple things Begin() modifies..
@@ -598,13 +738,23 @@ void Game::DisplayHUD()
 
 void Game::DisplayText(std::string text,std::string text2,float xPos, float yPos, float xPos2, float yPos2)
 {
-	sBatch->Begin();
-	cambriaFont26->DrawString(sBatch, text.c_str(), XMFLOAT2(xPos, yPos));
-	cambriaFont26->DrawString(sBatch, text2.c_str(), XMFLOAT2(xPos2, yPos2));
+	if (!cambriaFont->IsLoaded())
+		return;
+
+	float lineHeight = GetTextLineHeight();
+	cambriaFont->Begin(sBatch, pixelShaderText);
+	cambriaFont->DrawString(sBatch, text.c_str(), XMFLOAT2(xPos, yPos), lineHeight);
+	cambriaFont->DrawString(sBatch, text2.c_str(), XMFLOAT2(xPos2, yPos2), lineHeight);
 	sBatch->End();
 
 	//End() doesn't reset a couple things Begin() modifies..
 	context->OMSetBlendState(0, 0, 0xFFFFFFFF);
 	context->RSSetState(0);
 	context->OMSetDepthStencilState(0, 0);
+}
+
+//The old Cambria26 bitmap's line height at 720p, kept in proportion at any other size
+float Game::GetTextLineHeight()
+{
+	return height * (40.64f / 720.0f);
 }
\ No newline at end of file
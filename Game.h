@@ -4,6 +4,7 @@
 #include <DirectXMath.h>
 #include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
 #include "Mesh.h"
+#include "MeshRegistry.h"
 #include <vector>
 #include "Entity.h"
 #include "Camera.h"
@@ -11,12 +12,14 @@
 #include "SimpleShader.h"
 #include "Lights.h"
 #include "Sky.h"
+#include "SkyLighting.h"
 #include "Player.h"
 #include "Chunk.h"
 #include "WICTextureLoader.h"
+#include "TextureResidency.h"
 
 #include "SpriteBatch.h"
-#include "SpriteFont.h"
+#include "SdfFont.h"
 
 enum GameState
 {
@@ -86,12 +89,26 @@ private:
 	//Vectors for holding general objects
 	std::vector<Entity*> entities;
 	std::vector<Material*> materials;
-	std::vector<Mesh*> meshes;
+	std::vector<Mesh*> meshes;				//Owned by the registry through meshHandles
+	std::vector<MeshHandle> meshHandles;
+
+	//Shared vertex/index buffers every mesh is sub-allocated from - packed meshes have their own
+	GeometryArena* geometryArena;
+	GeometryArena* packedArena;
+
+	//Loads each model file once and shares it between everything that asks
+	MeshRegistry* meshRegistry;
+
+	//Every asset in one mapped file, if Assets.pack exists (loaders fall back to loose files)
+	AssetPack* assetPack;
 
 	Player* player;
 	Camera* camera1;
 
 	Sky* skyInstance;
+
+	//Ambient + reflections baked from the sky by the asset cooker
+	SkyLighting* skyLighting;
 	
 	// Note the usage of ComPtr below
 	//  - This is a smart pointer for objects that abide by the
@@ -103,36 +120,41 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
 
 
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> obstacleRoughness;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> obstacleMetal;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> obstacleNormal;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> noMetal;
+	//Material textures load the first time they're drawn and give memory back when unused
+	TextureResidency* textureResidency;
+	size_t textureBudget;
+
+	TextureHandle obstacleRoughMetal;
+	TextureHandle obstacleNormal;
+	TextureHandle floorRoughMetal;
 
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> obstacleGreen;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> obstacleOrange;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> obstaclePink;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> obstaclePurple;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> obstacleTurquoise;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> obstacleYellow;
+	//Every obstacle colour, one slice each - obstacles share one material and pick a slice
+	TextureHandle obstacleAlbedos;
+	int obstacleAlbedoCount;
 
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> floorSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> playerSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> playerMetal;
+	TextureHandle floorSRV;
+	TextureHandle playerSRV;
+	TextureHandle playerRoughMetal;
 
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> normalSamplerState;
 
-	void CreateObstacleMaterial(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> albedo);
+	void CreateObstacleMaterial(TextureHandle albedo);
 	
 	// Shaders and shader-related constructs
 	SimplePixelShader* pixelShader;
 	SimpleVertexShader* vertexShader;
+	SimpleVertexShader* packedVertexShader;		//Takes 20 byte Unorm16VertexFormat vertices
+	SimpleVertexShader* materialVertexShader;	//Whichever of the two the meshes were loaded for
 
 	SimplePixelShader* pixelShaderSky;
 	SimpleVertexShader* vertexShaderSky;
 
-	//For text
+	SimplePixelShader* pixelShaderText;
+
+	//For text - one distance field font, sized from the window's height
 	DirectX::SpriteBatch* sBatch;
-	DirectX::SpriteFont* cambriaFont26;
+	SdfFont* cambriaFont;
+	float GetTextLineHeight();
 	void DisplayHUD();
 	void DisplayText(std::string text, std::string text2, float xPos, float yPos, float xPos2, float yPos2);
 	
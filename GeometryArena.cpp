@@ -0,0 +1,259 @@
+#include "GeometryArena.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+
+namespace
+{
+	// Largest vertex count 16-bit indices can address
+	const int MaxShortIndexVertices = 65536;
+
+	// 32-bit index ranges have to start on a multiple of 4 bytes
+	const size_t IndexAlignment = 4;
+
+	UINT IndexSize(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_R16_UINT ? 2 : 4;
+	}
+}
+
+GeometryArena::GeometryArena(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, UINT vertexCapacity, UINT indexBytes, UINT vertexStride)
+	: device(device), context(context), vertexStride(vertexStride), vertexRanges(vertexCapacity), indexRanges(indexBytes), generation(0)
+{
+	vertexBuffer = CreateBuffer(vertexStride * vertexCapacity, D3D11_BIND_VERTEX_BUFFER);
+	indexBuffer = CreateBuffer(indexBytes, D3D11_BIND_INDEX_BUFFER);
+}
+
+GeometryArena::~GeometryArena()
+{
+}
+
+int GeometryArena::Allocate(const void* vertices, int vertexCount, const unsigned int* indices, int indexCount)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (vertexCount <= 0 || indexCount <= 0 || !vertexBuffer || !indexBuffer)
+		return -1;
+
+	Entry entry;
+	entry.VertexCount = (UINT)vertexCount;
+	entry.IndexCount = (UINT)indexCount;
+	entry.IndexFormat = vertexCount <= MaxShortIndexVertices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	entry.Live = true;
+
+	size_t indexBytes = (size_t)indexCount * IndexSize(entry.IndexFormat);
+	entry.VertexOffset = AllocateOrGrow(vertexBuffer, vertexRanges, vertexStride, vertexCount, 1, D3D11_BIND_VERTEX_BUFFER);
+	entry.IndexOffset = AllocateOrGrow(indexBuffer, indexRanges, 1, (indexBytes + IndexAlignment - 1) & ~(IndexAlignment - 1), IndexAlignment, D3D11_BIND_INDEX_BUFFER);
+
+	if (entry.VertexOffset == RangeAllocator::InvalidOffset || entry.IndexOffset == RangeAllocator::InvalidOffset)
+	{
+		vertexRanges.Free(entry.VertexOffset);
+		indexRanges.Free(entry.IndexOffset);
+		return -1;
+	}
+
+	Upload(vertexBuffer.Get(), entry.VertexOffset * vertexStride, vertices, (size_t)vertexStride * vertexCount);
+
+	//Indices stay relative to the mesh - BaseVertex does the offsetting
+	if (entry.IndexFormat == DXGI_FORMAT_R16_UINT)
+	{
+		std::vector<uint16_t> shortIndices(indices, indices + indexCount);
+		Upload(indexBuffer.Get(), entry.IndexOffset, &shortIndices[0], indexBytes);
+	}
+	else
+	{
+		Upload(indexBuffer.Get(), entry.IndexOffset, indices, indexBytes);
+	}
+
+	int handle;
+	if (!freeHandles.empty())
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+		entries[handle] = entry;
+	}
+	else
+	{
+		handle = (int)entries.size();
+		entries.push_back(entry);
+	}
+	return handle;
+}
+
+void GeometryArena::Free(int handle)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (handle < 0 || handle >= (int)entries.size() || !entries[handle].Live)
+		return;
+
+	vertexRanges.Free(entries[handle].VertexOffset);
+	indexRanges.Free(entries[handle].IndexOffset);
+	entries[handle].Live = false;
+	freeHandles.push_back(handle);
+}
+
+GeometryRange GeometryArena::GetRange(int handle)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	GeometryRange range = { 0, 0, 0, 0, DXGI_FORMAT_R32_UINT };
+	if (handle < 0 || handle >= (int)entries.size() || !entries[handle].Live)
+		return range;
+
+	const Entry& entry = entries[handle];
+	range.BaseVertex = (UINT)entry.VertexOffset;
+	range.VertexCount = entry.VertexCount;
+	range.StartIndex = (UINT)(entry.IndexOffset / IndexSize(entry.IndexFormat));
+	range.IndexCount = entry.IndexCount;
+	range.IndexFormat = entry.IndexFormat;
+	return range;
+}
+
+Microsoft::WRL::ComPtr<ID3D11Buffer> GeometryArena::GetVertexBuffer()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return vertexBuffer;
+}
+
+Microsoft::WRL::ComPtr<ID3D11Buffer> GeometryArena::GetIndexBuffer()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return indexBuffer;
+}
+
+// --------------------------------------------------------
+// Packs each allocator, then copies every live range into a
+// fresh buffer at its new spot (copies within one buffer
+// can't overlap, so it can't be done in place)
+// --------------------------------------------------------
+void GeometryArena::Defragment()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<RangeMove> vertexMoves = vertexRanges.Defragment();
+	std::vector<RangeMove> indexMoves = indexRanges.Defragment();
+
+	std::map<size_t, size_t> vertexMoved, indexMoved;
+	for (size_t i = 0; i < vertexMoves.size(); i++)
+		vertexMoved[vertexMoves[i].From] = vertexMoves[i].To;
+	for (size_t i = 0; i < indexMoves.size(); i++)
+		indexMoved[indexMoves[i].From] = indexMoves[i].To;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> newVertices = vertexMoves.empty() ? vertexBuffer : CreateBuffer(vertexStride * (UINT)vertexRanges.GetCapacity(), D3D11_BIND_VERTEX_BUFFER);
+	Microsoft::WRL::ComPtr<ID3D11Buffer> newIndices = indexMoves.empty() ? indexBuffer : CreateBuffer((UINT)indexRanges.GetCapacity(), D3D11_BIND_INDEX_BUFFER);
+	if (!newVertices || !newIndices)
+		return;
+
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		Entry& entry = entries[i];
+		if (!entry.Live)
+			continue;
+
+		if (!vertexMoves.empty())
+		{
+			size_t to = vertexMoved.count(entry.VertexOffset) ? vertexMoved[entry.VertexOffset] : entry.VertexOffset;
+			D3D11_BOX box = { (UINT)(entry.VertexOffset * vertexStride), 0, 0, (UINT)((entry.VertexOffset + entry.VertexCount) * vertexStride), 1, 1 };
+			context->CopySubresourceRegion(newVertices.Get(), 0, (UINT)(to * vertexStride), 0, 0, vertexBuffer.Get(), 0, &box);
+			entry.VertexOffset = to;
+		}
+
+		if (!indexMoves.empty())
+		{
+			size_t to = indexMoved.count(entry.IndexOffset) ? indexMoved[entry.IndexOffset] : entry.IndexOffset;
+			D3D11_BOX box = { (UINT)entry.IndexOffset, 0, 0, (UINT)(entry.IndexOffset + indexRanges.GetSize(to)), 1, 1 };
+			context->CopySubresourceRegion(newIndices.Get(), 0, (UINT)to, 0, 0, indexBuffer.Get(), 0, &box);
+			entry.IndexOffset = to;
+		}
+	}
+
+	vertexBuffer = newVertices;
+	indexBuffer = newIndices;
+	if (!vertexMoves.empty() || !indexMoves.empty())
+		generation++;
+}
+
+UINT GeometryArena::GetVertexStride()
+{
+	return vertexStride;
+}
+
+UINT GeometryArena::GetGeneration()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return generation;
+}
+
+RangeAllocatorStats GeometryArena::GetVertexStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return vertexRanges.GetStats();
+}
+
+RangeAllocatorStats GeometryArena::GetIndexStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return indexRanges.GetStats();
+}
+
+void GeometryArena::ReportStats(const char* label)
+{
+	#if defined(DEBUG) || defined(_DEBUG)
+		std::lock_guard<std::mutex> lock(mutex);
+		RangeAllocatorStats v = vertexRanges.GetStats();
+		RangeAllocatorStats i = indexRanges.GetStats();
+		printf("%s: %zu meshes, vertices %zu/%zu (%.1f%%, fragmentation %.2f), index bytes %zu/%zu (%.1f%%, fragmentation %.2f)\n",
+			label, v.Allocations, v.Used, v.Capacity, v.Occupancy() * 100.0f, v.Fragmentation(),
+			i.Used, i.Capacity, i.Occupancy() * 100.0f, i.Fragmentation());
+	#else
+		(void)label;
+	#endif
+}
+
+Microsoft::WRL::ComPtr<ID3D11Buffer> GeometryArena::CreateBuffer(UINT byteWidth, UINT bindFlags)
+{
+	//Default usage - written with UpdateSubresource, moved with CopySubresourceRegion
+	D3D11_BUFFER_DESC desc;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.ByteWidth = byteWidth;
+	desc.BindFlags = bindFlags;
+	desc.CPUAccessFlags = 0;
+	desc.MiscFlags = 0;
+	desc.StructureByteStride = 0;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	if (FAILED(device->CreateBuffer(&desc, 0, buffer.GetAddressOf())))
+		return nullptr;
+	return buffer;
+}
+
+//Doubles the buffer (or more, if that's still not enough) and copies the old contents over
+bool GeometryArena::GrowBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer>& buffer, RangeAllocator& ranges, UINT elementSize, size_t needed, UINT bindFlags)
+{
+	size_t capacity = ranges.GetCapacity();
+	size_t newCapacity = (std::max)(capacity * 2, capacity + needed);
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> grown = CreateBuffer((UINT)(newCapacity * elementSize), bindFlags);
+	if (!grown)
+		return false;
+
+	D3D11_BOX box = { 0, 0, 0, (UINT)(capacity * elementSize), 1, 1 };
+	context->CopySubresourceRegion(grown.Get(), 0, 0, 0, 0, buffer.Get(), 0, &box);
+
+	buffer = grown;
+	ranges.Grow(newCapacity);
+	generation++;
+	return true;
+}
+
+size_t GeometryArena::AllocateOrGrow(Microsoft::WRL::ComPtr<ID3D11Buffer>& buffer, RangeAllocator& ranges, UINT elementSize, size_t size, size_t alignment, UINT bindFlags)
+{
+	size_t offset = ranges.Allocate(size, alignment);
+	if (offset == RangeAllocator::InvalidOffset && GrowBuffer(buffer, ranges, elementSize, size + alignment, bindFlags))
+		offset = ranges.Allocate(size, alignment);
+	return offset;
+}
+
+void GeometryArena::Upload(ID3D11Buffer* buffer, size_t byteOffset, const void* data, size_t byteCount)
+{
+	D3D11_BOX box = { (UINT)byteOffset, 0, 0, (UINT)(byteOffset + byteCount), 1, 1 };
+	context->UpdateSubresource(buffer, 0, &box, data, 0, 0);
+}
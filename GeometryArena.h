@@ -0,0 +1,96 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <mutex>
+#include <vector>
+#include "Vertex.h"
+#include "RangeAllocator.h"
+
+// --------------------------------------------------------
+// Where one mesh's data sits in the shared buffers - draw with
+// DrawIndexed(count, StartIndex + first, BaseVertex)
+// --------------------------------------------------------
+struct GeometryRange
+{
+	UINT BaseVertex;
+	UINT VertexCount;
+	UINT StartIndex;			// In IndexFormat sized indices
+	UINT IndexCount;
+	DXGI_FORMAT IndexFormat;	// R16_UINT when the mesh has at most 65536 vertices
+};
+
+// --------------------------------------------------------
+// One big vertex buffer and one big index buffer shared by
+// every mesh, so drawing different meshes doesn't keep
+// rebinding buffers
+//
+// - Ranges come from RangeAllocators (vertices in vertexStride
+//   units, indices in bytes so 16 and 32-bit indices can share one
+//   buffer).  Every mesh in an arena has the same vertex format -
+//   packed meshes (see VertexFormats.h) get an arena of their own
+// - Meshes hold a handle rather than offsets, so Defragment can
+//   move their data around
+// - Buffers double in size when they run out
+// - Allocate and Defragment copy through the immediate context,
+//   so they belong on the render thread (MeshRegistry holds
+//   loader threads' meshes back until UploadPending).  The lock
+//   covers the bookkeeping, so Free and GetRange can come from
+//   any thread
+// --------------------------------------------------------
+class GeometryArena
+{
+public:
+	GeometryArena(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, UINT vertexCapacity = 65536, UINT indexBytes = 1 << 20, UINT vertexStride = sizeof(Vertex));
+	~GeometryArena();
+
+	// Copies the mesh in and returns its handle (-1 if it couldn't).  vertices are vertexStride bytes each
+	int Allocate(const void* vertices, int vertexCount, const unsigned int* indices, int indexCount);
+	void Free(int handle);
+	GeometryRange GetRange(int handle);
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
+	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
+	UINT GetVertexStride();
+
+	// Packs both buffers (copied on the GPU) so the free space is in one piece again
+	void Defragment();
+
+	// Goes up whenever growing or defragmenting replaces a buffer, so
+	// anything that cached what it bound knows to bind again
+	UINT GetGeneration();
+
+	RangeAllocatorStats GetVertexStats();
+	RangeAllocatorStats GetIndexStats();
+	void ReportStats(const char* label);
+
+private:
+	struct Entry
+	{
+		size_t VertexOffset;
+		size_t IndexOffset;		// Bytes
+		UINT VertexCount;
+		UINT IndexCount;
+		DXGI_FORMAT IndexFormat;
+		bool Live;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	UINT vertexStride;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
+	RangeAllocator vertexRanges;
+	RangeAllocator indexRanges;
+
+	std::mutex mutex;
+	std::vector<Entry> entries;
+	std::vector<int> freeHandles;
+	UINT generation;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> CreateBuffer(UINT byteWidth, UINT bindFlags);
+	bool GrowBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer>& buffer, RangeAllocator& ranges, UINT elementSize, size_t needed, UINT bindFlags);
+	size_t AllocateOrGrow(Microsoft::WRL::ComPtr<ID3D11Buffer>& buffer, RangeAllocator& ranges, UINT elementSize, size_t size, size_t alignment, UINT bindFlags);
+	void Upload(ID3D11Buffer* buffer, size_t byteOffset, const void* data, size_t byteCount);
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// --------------------------------------------------------
+// 64-bit hash of a block of memory (MurmurHash64A by Austin
+// Appleby, public domain)
+//
+// - Used for content hashes of cooked assets, so it has to
+//   give the same answer on every platform and build
+// - Not cryptographic - only meant to catch stale/corrupt data
+// --------------------------------------------------------
+inline uint64_t HashBytes(const void* data, size_t length, uint64_t seed = 0)
+{
+	const uint64_t m = 0xc6a4a7935bd1e995ull;
+	const int r = 47;
+
+	uint64_t h = seed ^ (length * m);
+
+	const unsigned char* bytes = (const unsigned char*)data;
+	const unsigned char* end = bytes + (length & ~(size_t)7);
+
+	while (bytes != end)
+	{
+		//memcpy instead of a cast so unaligned data is fine
+		uint64_t k;
+		memcpy(&k, bytes, 8);
+		bytes += 8;
+
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+
+		h ^= k;
+		h *= m;
+	}
+
+	//Each case takes its byte and falls into the next, down to the multiply
+	switch (length & 7)
+	{
+	case 7: h ^= uint64_t(bytes[6]) << 48;
+		// fall through
+	case 6: h ^= uint64_t(bytes[5]) << 40;
+		// fall through
+	case 5: h ^= uint64_t(bytes[4]) << 32;
+		// fall through
+	case 4: h ^= uint64_t(bytes[3]) << 24;
+		// fall through
+	case 3: h ^= uint64_t(bytes[2]) << 16;
+		// fall through
+	case 2: h ^= uint64_t(bytes[1]) << 8;
+		// fall through
+	case 1: h ^= uint64_t(bytes[0]);
+		h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+
+	return h;
+}
@@ -0,0 +1,834 @@
+#include "IblBaker.h"
+#include "BlockCompressor.h"
+#include "DdsFile.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include "MipGenerator.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace
+{
+	const float Pi = 3.14159265358979f;
+
+	// Same floor the shader puts under GGX's alpha squared
+	const float MinRoughness = 0.0000001f;
+
+	// DXGI formats read and written here
+	const uint32_t FormatRgba32Float = 2;
+	const uint32_t FormatRgba16Float = 10;
+	const uint32_t FormatRg16Float = 34;
+
+	double SecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	std::string FileName(const std::string& path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? path : path.substr(slash + 1);
+	}
+
+	float HalfToFloat(uint16_t half)
+	{
+		uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+		uint32_t exponent = (half >> 10) & 0x1f;
+		uint32_t mantissa = half & 0x3ff;
+
+		if (exponent == 0)
+		{
+			float value = mantissa / 16777216.0f;
+			return sign ? -value : value;
+		}
+
+		uint32_t bits = exponent == 31 ?
+			sign | 0x7f800000 | (mantissa << 13) :
+			sign | ((exponent + 112) << 23) | (mantissa << 13);
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// Rounds to nearest even, like the GPU does
+	uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		uint32_t sign = (bits >> 16) & 0x8000;
+		uint32_t mantissa = bits & 0x7fffff;
+		int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+
+		if (((bits >> 23) & 0xff) == 0xff)
+			return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+		if (exponent >= 31)
+			return (uint16_t)(sign | 0x7c00);
+
+		//Too small for a normal half - shift into a denormal
+		if (exponent <= 0)
+		{
+			if (exponent < -10)
+				return (uint16_t)sign;
+
+			mantissa |= 0x800000;
+			uint32_t shift = (uint32_t)(14 - exponent);
+			uint32_t half = mantissa >> shift;
+			uint32_t rest = mantissa & ((1u << shift) - 1);
+			uint32_t halfway = 1u << (shift - 1);
+			if (rest > halfway || (rest == halfway && (half & 1)))
+				half++;
+			return (uint16_t)(sign | half);
+		}
+
+		//A carry out of the mantissa correctly bumps the exponent
+		uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+		uint32_t rest = mantissa & 0x1fff;
+		if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+			half++;
+		return (uint16_t)half;
+	}
+
+	void Normalize(float v[3])
+	{
+		float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		v[0] /= length;
+		v[1] /= length;
+		v[2] /= length;
+	}
+
+	// --------------------------------------------------------
+	// D3D's cube layout: s and t in [-1, 1] across a face, t down
+	// --------------------------------------------------------
+	void FaceDirection(uint32_t face, float s, float t, float dir[3])
+	{
+		switch (face)
+		{
+		case 0: dir[0] = 1; dir[1] = -t; dir[2] = -s; break;
+		case 1: dir[0] = -1; dir[1] = -t; dir[2] = s; break;
+		case 2: dir[0] = s; dir[1] = 1; dir[2] = t; break;
+		case 3: dir[0] = s; dir[1] = -1; dir[2] = -t; break;
+		case 4: dir[0] = s; dir[1] = -t; dir[2] = 1; break;
+		default: dir[0] = -s; dir[1] = -t; dir[2] = -1; break;
+		}
+		Normalize(dir);
+	}
+
+	// The inverse - u and v in [0, 1]
+	void DirectionToFace(const float dir[3], uint32_t& face, float& u, float& v)
+	{
+		float ax = fabsf(dir[0]), ay = fabsf(dir[1]), az = fabsf(dir[2]);
+		float major, sc, tc;
+		if (ax >= ay && ax >= az)
+		{
+			face = dir[0] > 0 ? 0 : 1;
+			major = ax;
+			sc = dir[0] > 0 ? -dir[2] : dir[2];
+			tc = -dir[1];
+		}
+		else if (ay >= az)
+		{
+			face = dir[1] > 0 ? 2 : 3;
+			major = ay;
+			sc = dir[0];
+			tc = dir[1] > 0 ? dir[2] : -dir[2];
+		}
+		else
+		{
+			face = dir[2] > 0 ? 4 : 5;
+			major = az;
+			sc = dir[2] > 0 ? dir[0] : -dir[0];
+			tc = -dir[1];
+		}
+		u = (sc / major + 1.0f) * 0.5f;
+		v = (tc / major + 1.0f) * 0.5f;
+	}
+
+	// Solid angle of a texel, from the area of its projection onto the unit sphere
+	float AreaElement(float x, float y)
+	{
+		return atan2f(x * y, sqrtf(x * x + y * y + 1.0f));
+	}
+
+	float TexelSolidAngle(uint32_t x, uint32_t y, uint32_t size)
+	{
+		float inverse = 1.0f / size;
+		float s = 2.0f * (x + 0.5f) * inverse - 1.0f;
+		float t = 2.0f * (y + 0.5f) * inverse - 1.0f;
+		float x0 = s - inverse, x1 = s + inverse;
+		float y0 = t - inverse, y1 = t + inverse;
+		return AreaElement(x0, y0) - AreaElement(x0, y1) - AreaElement(x1, y0) + AreaElement(x1, y1);
+	}
+
+	// Each face halved with a 2x2 box (faces are filtered on their own)
+	void Downsample(const FloatCube& source, FloatCube& result)
+	{
+		result.Size = (std::max)(1u, source.Size / 2);
+		result.Texels.assign((size_t)result.Size * result.Size * 4 * 6, 0.0f);
+		uint32_t step = source.Size > 1 ? 2 : 1;
+		__m128 quarter = _mm_set1_ps(step == 2 ? 0.25f : 1.0f);
+
+		for (uint32_t f = 0; f < 6; f++)
+		{
+			const float* src = source.Face(f);
+			float* dst = result.Face(f);
+			for (uint32_t y = 0; y < result.Size; y++)
+			{
+				for (uint32_t x = 0; x < result.Size; x++)
+				{
+					size_t sx = (size_t)x * step, sy = (size_t)y * step;
+					__m128 sum = _mm_loadu_ps(src + (sy * source.Size + sx) * 4);
+					if (step == 2)
+					{
+						sum = _mm_add_ps(sum, _mm_loadu_ps(src + (sy * source.Size + sx + 1) * 4));
+						sum = _mm_add_ps(sum, _mm_loadu_ps(src + ((sy + 1) * source.Size + sx) * 4));
+						sum = _mm_add_ps(sum, _mm_loadu_ps(src + ((sy + 1) * source.Size + sx + 1) * 4));
+					}
+					_mm_storeu_ps(dst + ((size_t)y * result.Size + x) * 4, _mm_mul_ps(sum, quarter));
+				}
+			}
+		}
+	}
+
+	// Bilinear within a face, clamped at its edges
+	__m128 SampleFace(const FloatCube& cube, uint32_t face, float u, float v)
+	{
+		float fx = (std::min)((std::max)(u * cube.Size - 0.5f, 0.0f), (float)(cube.Size - 1));
+		float fy = (std::min)((std::max)(v * cube.Size - 0.5f, 0.0f), (float)(cube.Size - 1));
+		uint32_t x0 = (uint32_t)fx, y0 = (uint32_t)fy;
+		uint32_t x1 = (std::min)(x0 + 1, cube.Size - 1), y1 = (std::min)(y0 + 1, cube.Size - 1);
+		float tx = fx - x0, ty = fy - y0;
+
+		const float* texels = cube.Face(face);
+		__m128 top = _mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(texels + ((size_t)y0 * cube.Size + x0) * 4), _mm_set1_ps(1.0f - tx)),
+			_mm_mul_ps(_mm_loadu_ps(texels + ((size_t)y0 * cube.Size + x1) * 4), _mm_set1_ps(tx)));
+		__m128 bottom = _mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(texels + ((size_t)y1 * cube.Size + x0) * 4), _mm_set1_ps(1.0f - tx)),
+			_mm_mul_ps(_mm_loadu_ps(texels + ((size_t)y1 * cube.Size + x1) * 4), _mm_set1_ps(tx)));
+		return _mm_add_ps(_mm_mul_ps(top, _mm_set1_ps(1.0f - ty)), _mm_mul_ps(bottom, _mm_set1_ps(ty)));
+	}
+
+	// Trilinear across the source's mip chain
+	__m128 SampleChain(const std::vector<FloatCube>& chain, const float dir[3], float lod)
+	{
+		uint32_t face;
+		float u, v;
+		DirectionToFace(dir, face, u, v);
+
+		uint32_t level = (uint32_t)lod;
+		if (level + 1 >= chain.size())
+			return SampleFace(chain.back(), face, u, v);
+
+		float blend = lod - level;
+		__m128 a = SampleFace(chain[level], face, u, v);
+		if (blend <= 0.0f)
+			return a;
+		__m128 b = SampleFace(chain[level + 1], face, u, v);
+		return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(blend)));
+	}
+
+	// Low-discrepancy points on the unit square
+	void Hammersley(uint32_t i, uint32_t count, float& x, float& y)
+	{
+		uint32_t bits = i;
+		bits = (bits << 16) | (bits >> 16);
+		bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+		bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+		bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+		bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+		x = (float)i / count;
+		y = bits * 2.3283064365386963e-10f;
+	}
+
+	// Half vector around +Z, distributed like GGX's D(h) * (n.h)
+	void ImportanceSampleGgx(float x, float y, float roughness, float h[3])
+	{
+		float a = roughness * roughness;
+		float phi = 2.0f * Pi * x;
+		float cosTheta = sqrtf((1.0f - y) / (1.0f + (a * a - 1.0f) * y));
+		float sinTheta = sqrtf(1.0f - cosTheta * cosTheta);
+		h[0] = sinTheta * cosf(phi);
+		h[1] = sinTheta * sinf(phi);
+		h[2] = cosTheta;
+	}
+
+	// ShaderIncludes' SpecDistribution
+	float Distribution(float NdotH, float roughness)
+	{
+		float a = roughness * roughness;
+		float a2 = (std::max)(a * a, MinRoughness);
+		float denomToSquare = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+		return a2 / (Pi * denomToSquare * denomToSquare);
+	}
+
+	// Schlick-GGX with k = a / 2, the remap for image lighting (the
+	// shader's (r + 1)^2 / 8 is only meant for analytic lights)
+	float GeometrySmith(float NdotV, float NdotL, float roughness)
+	{
+		float k = roughness * roughness * 0.5f;
+		return (NdotV / (NdotV * (1.0f - k) + k)) * (NdotL / (NdotL * (1.0f - k) + k));
+	}
+
+	// Sample direction (tangent space, around +Z), its n.l weight and the source mip to read
+	struct SpecularSample
+	{
+		float L[3];
+		float Weight;
+		float Lod;
+	};
+
+	// --------------------------------------------------------
+	// Assumes N = V = R, as the split sum does.  Each sample reads
+	// the mip whose texels cover about the solid angle the sample
+	// stands for (1 / (count * pdf)), which hides the noise a
+	// handful of samples would otherwise leave
+	// --------------------------------------------------------
+	std::vector<SpecularSample> BuildSpecularSamples(float roughness, uint32_t count, uint32_t sourceSize, size_t levels)
+	{
+		std::vector<SpecularSample> samples;
+		float texelSolidAngle = 4.0f * Pi / (6.0f * sourceSize * sourceSize);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			float x, y, h[3];
+			Hammersley(i, count, x, y);
+			ImportanceSampleGgx(x, y, roughness, h);
+
+			SpecularSample sample;
+			sample.L[0] = 2.0f * h[2] * h[0];
+			sample.L[1] = 2.0f * h[2] * h[1];
+			sample.L[2] = 2.0f * h[2] * h[2] - 1.0f;
+			sample.Weight = sample.L[2];
+			if (sample.Weight <= 0.0f)
+				continue;
+
+			//pdf = D * n.h / (4 * v.h), and v.h = n.h here
+			float pdf = Distribution(h[2], roughness) * 0.25f;
+			float sampleSolidAngle = 1.0f / (count * pdf + 0.0001f);
+			float lod = 0.5f * log2f(sampleSolidAngle / texelSolidAngle) + 1.0f;
+			sample.Lod = (std::min)((std::max)(lod, 0.0f), (float)(levels - 1));
+			samples.push_back(sample);
+		}
+		return samples;
+	}
+
+	bool DecodeFace(const DdsImage& image, const DdsSubresource& sub, float* texels)
+	{
+		size_t count = (size_t)sub.Width * sub.Height;
+		switch (image.DxgiFormat)
+		{
+		case 28: case 29:			// R8G8B8A8
+		case 87: case 91:			// B8G8R8A8
+		case 88: case 93:			// B8G8R8X8
+		{
+			bool bgr = image.DxgiFormat >= 87;
+			for (uint32_t y = 0; y < sub.Height; y++)
+			{
+				const uint8_t* row = sub.Data + (size_t)y * sub.RowPitch;
+				for (uint32_t x = 0; x < sub.Width; x++)
+				{
+					float* t = texels + ((size_t)y * sub.Width + x) * 4;
+					t[0] = MipGenerator::SrgbToLinear(row[x * 4 + (bgr ? 2 : 0)]);
+					t[1] = MipGenerator::SrgbToLinear(row[x * 4 + 1]);
+					t[2] = MipGenerator::SrgbToLinear(row[x * 4 + (bgr ? 0 : 2)]);
+					t[3] = 1.0f;
+				}
+			}
+			return true;
+		}
+		case FormatRgba16Float:
+			for (size_t i = 0; i < count * 4; i++)
+			{
+				uint16_t half;
+				memcpy(&half, sub.Data + i * 2, sizeof(half));
+				texels[i] = HalfToFloat(half);
+			}
+			return true;
+		case FormatRgba32Float:
+			memcpy(texels, sub.Data, count * 16);
+			return true;
+		case 71: case 72:			// BC1
+		{
+			uint32_t blocksWide = (sub.Width + 3) / 4;
+			for (uint32_t by = 0; by < (sub.Height + 3) / 4; by++)
+			{
+				for (uint32_t bx = 0; bx < blocksWide; bx++)
+				{
+					uint8_t rgba[64];
+					BlockCompressor::DecodeBlock(BlockFormat::BC1, sub.Data + ((size_t)by * blocksWide + bx) * 8, rgba);
+					for (uint32_t p = 0; p < 16; p++)
+					{
+						uint32_t x = bx * 4 + p % 4, y = by * 4 + p / 4;
+						if (x >= sub.Width || y >= sub.Height)
+							continue;
+						float* t = texels + ((size_t)y * sub.Width + x) * 4;
+						for (int c = 0; c < 3; c++)
+							t[c] = MipGenerator::SrgbToLinear(rgba[p * 4 + c]);
+						t[3] = 1.0f;
+					}
+				}
+			}
+			return true;
+		}
+		}
+		return false;
+	}
+
+	std::vector<uint8_t> ToHalves(const float* values, size_t count)
+	{
+		std::vector<uint8_t> bytes(count * 2);
+		for (size_t i = 0; i < count; i++)
+		{
+			uint16_t half = FloatToHalf(values[i]);
+			memcpy(bytes.data() + i * 2, &half, sizeof(half));
+		}
+		return bytes;
+	}
+}
+
+uint64_t IblSettings::Hash() const
+{
+	uint32_t values[5] = { SpecularSize, SpecularMips, SpecularSamples, BrdfSize, BrdfSamples };
+	return HashBytes(values, sizeof(values));
+}
+
+bool IblBaker::LoadCube(const uint8_t* data, size_t size, FloatCube& cube)
+{
+	DdsImage image;
+	if (!DdsFile::Parse(data, size, image) || !image.Cube || image.Width != image.Height)
+		return false;
+
+	cube.Size = image.Width;
+	cube.Texels.assign((size_t)cube.Size * cube.Size * 4 * 6, 0.0f);
+	for (uint32_t f = 0; f < 6; f++)
+	{
+		if (!DecodeFace(image, image.Get(f, 0), cube.Face(f)))
+			return false;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Projects radiance onto the 9 real SH basis functions, then
+// applies the cosine lobe's convolution (pi, 2pi/3, pi/4 per
+// band) and Lambert's 1/pi
+//
+// Rows are split across workers, each summing into its own
+// coefficients so nothing is shared while they run
+// --------------------------------------------------------
+unsigned int IblBaker::ProjectIrradiance(const FloatCube& sky, float coefficients[9][4])
+{
+	struct Partial
+	{
+		float Sum[9][4];
+		float Weight;
+	};
+	std::vector<Partial> partials(GetWorkerCount());
+	memset(partials.data(), 0, partials.size() * sizeof(Partial));
+
+	size_t rows = (size_t)sky.Size * 6;
+	unsigned int workers = ParallelForRange(rows, 16, [&](size_t begin, size_t end, unsigned int worker)
+	{
+		__m128 sum[9];
+		for (int i = 0; i < 9; i++)
+			sum[i] = _mm_setzero_ps();
+		float weight = 0.0f;
+
+		for (size_t row = begin; row < end; row++)
+		{
+			uint32_t face = (uint32_t)(row / sky.Size);
+			uint32_t y = (uint32_t)(row % sky.Size);
+			const float* texels = sky.Face(face) + (size_t)y * sky.Size * 4;
+			for (uint32_t x = 0; x < sky.Size; x++)
+			{
+				float dir[3];
+				FaceDirection(face, 2.0f * (x + 0.5f) / sky.Size - 1.0f, 2.0f * (y + 0.5f) / sky.Size - 1.0f, dir);
+				float solidAngle = TexelSolidAngle(x, y, sky.Size);
+				float dx = dir[0], dy = dir[1], dz = dir[2];
+
+				float basis[9] =
+				{
+					0.282095f,
+					0.488603f * dy,
+					0.488603f * dz,
+					0.488603f * dx,
+					1.092548f * dx * dy,
+					1.092548f * dy * dz,
+					0.315392f * (3.0f * dz * dz - 1.0f),
+					1.092548f * dx * dz,
+					0.546274f * (dx * dx - dy * dy)
+				};
+
+				__m128 radiance = _mm_mul_ps(_mm_loadu_ps(texels + x * 4), _mm_set1_ps(solidAngle));
+				for (int i = 0; i < 9; i++)
+					sum[i] = _mm_add_ps(sum[i], _mm_mul_ps(radiance, _mm_set1_ps(basis[i])));
+				weight += solidAngle;
+			}
+		}
+
+		for (int i = 0; i < 9; i++)
+			_mm_storeu_ps(partials[worker].Sum[i], sum[i]);
+		partials[worker].Weight = weight;
+	});
+
+	float total = 0.0f;
+	float sums[9][4] = {};
+	for (size_t w = 0; w < partials.size(); w++)
+	{
+		total += partials[w].Weight;
+		for (int i = 0; i < 9; i++)
+			for (int c = 0; c < 4; c++)
+				sums[i][c] += partials[w].Sum[i][c];
+	}
+
+	//The texel areas only approximately add to 4 pi - scale so they do exactly
+	const float band[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+	float normalize = total > 0.0f ? 4.0f * Pi / total : 0.0f;
+	for (int i = 0; i < 9; i++)
+	{
+		for (int c = 0; c < 3; c++)
+			coefficients[i][c] = sums[i][c] * normalize * band[i];
+		coefficients[i][3] = 0.0f;
+	}
+	return workers;
+}
+
+unsigned int IblBaker::PrefilterSpecular(const FloatCube& sky, const IblSettings& settings, std::vector<FloatCube>& mips, size_t* samples)
+{
+	//Box mip chain of the sky for the filtered lookups
+	std::vector<FloatCube> chain(1, sky);
+	while (chain.back().Size > 1)
+	{
+		FloatCube next;
+		Downsample(chain.back(), next);
+		chain.push_back(next);
+	}
+
+	uint32_t size = (std::min)(settings.SpecularSize, sky.Size);
+	uint32_t levels = (std::min)(settings.SpecularMips, MipGenerator::LevelCount(size, size));
+	float topLod = log2f((float)sky.Size / size);
+
+	mips.assign(levels, FloatCube());
+	std::vector<std::vector<SpecularSample>> sampleSets(levels);
+	for (uint32_t m = 0; m < levels; m++)
+	{
+		mips[m].Size = (std::max)(1u, size >> m);
+		mips[m].Texels.assign((size_t)mips[m].Size * mips[m].Size * 4 * 6, 0.0f);
+		float roughness = levels > 1 ? (float)m / (levels - 1) : 0.0f;
+		if (m > 0)
+			sampleSets[m] = BuildSpecularSamples(roughness, settings.SpecularSamples, sky.Size, chain.size());
+	}
+
+	//Every row of every face of every mip is one task - rougher mips cost more per texel, so hand them out dynamically
+	std::vector<std::pair<uint32_t, uint32_t>> rows;
+	for (uint32_t m = 0; m < levels; m++)
+		for (uint32_t r = 0; r < mips[m].Size * 6; r++)
+			rows.push_back(std::make_pair(m, r));
+
+	std::atomic<size_t> lookups(0);
+	unsigned int workers = ParallelFor(rows.size(), [&](size_t task)
+	{
+		uint32_t m = rows[task].first;
+		FloatCube& mip = mips[m];
+		uint32_t face = rows[task].second / mip.Size;
+		uint32_t y = rows[task].second % mip.Size;
+		float* out = mip.Face(face) + (size_t)y * mip.Size * 4;
+		const std::vector<SpecularSample>& set = sampleSets[m];
+
+		for (uint32_t x = 0; x < mip.Size; x++)
+		{
+			float n[3];
+			FaceDirection(face, 2.0f * (x + 0.5f) / mip.Size - 1.0f, 2.0f * (y + 0.5f) / mip.Size - 1.0f, n);
+
+			//Mirror-like top level - just the sky at this size
+			if (m == 0)
+			{
+				_mm_storeu_ps(out + x * 4, SampleChain(chain, n, topLod));
+				continue;
+			}
+
+			float up[3] = { 0.0f, 0.0f, 1.0f };
+			if (fabsf(n[2]) > 0.999f)
+			{
+				up[0] = 1.0f;
+				up[2] = 0.0f;
+			}
+			float t[3] = { up[1] * n[2] - up[2] * n[1], up[2] * n[0] - up[0] * n[2], up[0] * n[1] - up[1] * n[0] };
+			Normalize(t);
+			float b[3] = { n[1] * t[2] - n[2] * t[1], n[2] * t[0] - n[0] * t[2], n[0] * t[1] - n[1] * t[0] };
+
+			__m128 sum = _mm_setzero_ps();
+			float weight = 0.0f;
+			for (size_t s = 0; s < set.size(); s++)
+			{
+				const SpecularSample& sample = set[s];
+				float l[3] =
+				{
+					t[0] * sample.L[0] + b[0] * sample.L[1] + n[0] * sample.L[2],
+					t[1] * sample.L[0] + b[1] * sample.L[1] + n[1] * sample.L[2],
+					t[2] * sample.L[0] + b[2] * sample.L[1] + n[2] * sample.L[2]
+				};
+				sum = _mm_add_ps(sum, _mm_mul_ps(SampleChain(chain, l, sample.Lod), _mm_set1_ps(sample.Weight)));
+				weight += sample.Weight;
+			}
+			_mm_storeu_ps(out + x * 4, _mm_mul_ps(sum, _mm_set1_ps(weight > 0.0f ? 1.0f / weight : 0.0f)));
+		}
+		lookups += (size_t)mip.Size * (m == 0 ? 1 : set.size());
+	});
+
+	if (samples)
+		*samples = lookups;
+	return workers;
+}
+
+// --------------------------------------------------------
+// Split sum: the specular integral is the prefiltered sky times
+// F0 * A + B, with A and B integrated here over GGX samples
+// for N.V (columns) and roughness (rows)
+// --------------------------------------------------------
+unsigned int IblBaker::IntegrateBrdf(const IblSettings& settings, std::vector<float>& lut)
+{
+	uint32_t size = settings.BrdfSize;
+	lut.assign((size_t)size * size * 2, 0.0f);
+
+	return ParallelForRange(size, 4, [&](size_t begin, size_t end, unsigned int)
+	{
+		for (size_t y = begin; y < end; y++)
+		{
+			float roughness = (y + 0.5f) / size;
+			for (uint32_t x = 0; x < size; x++)
+			{
+				float NdotV = (x + 0.5f) / size;
+				float v[3] = { sqrtf(1.0f - NdotV * NdotV), 0.0f, NdotV };
+
+				float a = 0.0f, b = 0.0f;
+				for (uint32_t i = 0; i < settings.BrdfSamples; i++)
+				{
+					float hx, hy, h[3];
+					Hammersley(i, settings.BrdfSamples, hx, hy);
+					ImportanceSampleGgx(hx, hy, roughness, h);
+
+					float VdotH = v[0] * h[0] + v[1] * h[1] + v[2] * h[2];
+					float NdotL = 2.0f * VdotH * h[2] - v[2];
+					if (NdotL <= 0.0f)
+						continue;
+
+					float NdotH = (std::max)(h[2], 0.0f);
+					VdotH = (std::max)(VdotH, 0.0f);
+					float visibility = GeometrySmith(NdotV, NdotL, roughness) * VdotH / (NdotH * NdotV);
+					float fresnel = powf(1.0f - VdotH, 5.0f);
+					a += (1.0f - fresnel) * visibility;
+					b += fresnel * visibility;
+				}
+
+				float* out = lut.data() + ((size_t)y * size + x) * 2;
+				out[0] = a / settings.BrdfSamples;
+				out[1] = b / settings.BrdfSamples;
+			}
+		}
+	});
+}
+
+bool IblBaker::BakeIrradiance(const std::string& source, const std::string& destination, IblBakeStats* stats)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	IblBakeStats local;
+	IblBakeStats& result = stats ? *stats : local;
+	result = IblBakeStats();
+	result.Name = FileName(destination);
+	result.Stage = "SH9";
+
+	MappedFile file(source.c_str());
+	FloatCube sky;
+	if (!file.IsOpen() || !LoadCube(file.GetData(), file.GetSize(), sky))
+		return false;
+
+	float coefficients[9][4];
+	result.Workers = ProjectIrradiance(sky, coefficients);
+
+	std::vector<std::vector<uint8_t>> mips(1, std::vector<uint8_t>(sizeof(coefficients)));
+	memcpy(mips[0].data(), coefficients, sizeof(coefficients));
+	result.Ok = DdsFile::Write(destination, FormatRgba32Float, 9, 1, mips);
+	result.Size = sky.Size;
+	result.MipLevels = 1;
+	result.Samples = (size_t)sky.Size * sky.Size * 6;
+	result.Seconds = SecondsSince(start);
+	return result.Ok;
+}
+
+bool IblBaker::BakeSpecular(const std::string& source, const std::string& destination, const IblSettings& settings, IblBakeStats* stats)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	IblBakeStats local;
+	IblBakeStats& result = stats ? *stats : local;
+	result = IblBakeStats();
+	result.Name = FileName(destination);
+	result.Stage = "GGX";
+
+	MappedFile file(source.c_str());
+	FloatCube sky;
+	if (!file.IsOpen() || !LoadCube(file.GetData(), file.GetSize(), sky))
+		return false;
+
+	std::vector<FloatCube> mips;
+	result.Workers = PrefilterSpecular(sky, settings, mips, &result.Samples);
+
+	std::vector<std::vector<uint8_t>> faces;
+	for (uint32_t f = 0; f < 6; f++)
+	{
+		for (size_t m = 0; m < mips.size(); m++)
+			faces.push_back(ToHalves(mips[m].Face(f), (size_t)mips[m].Size * mips[m].Size * 4));
+	}
+
+	result.Ok = DdsFile::WriteCube(destination, FormatRgba16Float, mips[0].Size, (uint32_t)mips.size(), faces);
+	result.Size = mips[0].Size;
+	result.MipLevels = (uint32_t)mips.size();
+	result.Seconds = SecondsSince(start);
+	return result.Ok;
+}
+
+bool IblBaker::BakeBrdf(const std::string& destination, const IblSettings& settings, IblBakeStats* stats)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	IblBakeStats local;
+	IblBakeStats& result = stats ? *stats : local;
+	result = IblBakeStats();
+	result.Name = FileName(destination);
+	result.Stage = "BRDF";
+
+	if (settings.BrdfSize == 0 || settings.BrdfSamples == 0)
+		return false;
+
+	std::vector<float> lut;
+	result.Workers = IntegrateBrdf(settings, lut);
+
+	std::vector<std::vector<uint8_t>> mips(1, ToHalves(lut.data(), lut.size()));
+	result.Ok = DdsFile::Write(destination, FormatRg16Float, settings.BrdfSize, settings.BrdfSize, mips);
+	result.Size = settings.BrdfSize;
+	result.MipLevels = 1;
+	result.Samples = (size_t)settings.BrdfSize * settings.BrdfSize * settings.BrdfSamples;
+	result.Seconds = SecondsSince(start);
+	return result.Ok;
+}
+
+void IblBaker::Report(const std::vector<IblBakeStats>& bakes)
+{
+	double seconds = 0.0;
+	for (size_t i = 0; i < bakes.size(); i++)
+	{
+		const IblBakeStats& b = bakes[i];
+		if (!b.Ok)
+		{
+			printf("  %-44s FAILED\n", b.Name.c_str());
+			continue;
+		}
+
+		printf("  %-44s %-4s %4u px %2u mips  %7.2f M samples  %8.1f ms on %u threads (%.1f M samples/s)\n",
+			b.Name.c_str(), b.Stage, b.Size, b.MipLevels, b.Samples / 1e6, b.Seconds * 1000.0, b.Workers,
+			b.Seconds > 0.0 ? b.Samples / b.Seconds / 1e6 : 0.0);
+		seconds += b.Seconds;
+	}
+	printf("Image lighting: %.1f ms\n", seconds * 1000.0);
+}
+
+// --------------------------------------------------------
+// Each stage's speed-up is against its own single worker run,
+// so the table shows how far each one scales on this machine
+// --------------------------------------------------------
+bool IblBaker::Benchmark(const std::string& source, const IblSettings& settings, int iterations)
+{
+	FloatCube sky;
+	if (source.empty())
+	{
+		//Bright overhead, dark underneath - enough variation that no sample is skipped
+		sky.Size = 128;
+		sky.Texels.resize((size_t)sky.Size * sky.Size * 4 * 6);
+		for (uint32_t face = 0; face < 6; face++)
+		{
+			for (uint32_t y = 0; y < sky.Size; y++)
+			{
+				for (uint32_t x = 0; x < sky.Size; x++)
+				{
+					float dir[3];
+					FaceDirection(face, 2.0f * (x + 0.5f) / sky.Size - 1.0f, 2.0f * (y + 0.5f) / sky.Size - 1.0f, dir);
+					float up = dir[1] * 0.5f + 0.5f;
+					float* texel = sky.Face(face) + ((size_t)y * sky.Size + x) * 4;
+					texel[0] = 0.2f + 0.8f * up * up;
+					texel[1] = 0.3f + 0.9f * up;
+					texel[2] = 0.5f + 1.5f * up;
+					texel[3] = 1.0f;
+				}
+			}
+		}
+	}
+	else
+	{
+		MappedFile file(source.c_str());
+		if (!file.IsOpen() || !LoadCube(file.GetData(), file.GetSize(), sky))
+		{
+			printf("IblBaker - couldn't load '%s'\n", source.c_str());
+			return false;
+		}
+	}
+
+	unsigned int cores = GetWorkerCount();
+	std::vector<unsigned int> counts;
+	counts.push_back(1);
+	counts.push_back(2);
+	counts.push_back(4);
+	if (cores != 1 && cores != 2 && cores != 4)
+		counts.push_back(cores);
+	if (iterations < 1)
+		iterations = 1;
+
+	printf("%s: %u px sky, %u cores, best of %d\n", source.empty() ? "Gradient sky" : FileName(source).c_str(), sky.Size, cores, iterations);
+	printf("  %-5s %8s %8s %8s %8s\n", "stage", "workers", "ms", "speedup", "per core");
+
+	const char* stages[3] = { "SH9", "GGX", "BRDF" };
+	unsigned int previous = WorkerCountOverride();
+	for (int stage = 0; stage < 3; stage++)
+	{
+		double single = 0.0;
+		for (size_t c = 0; c < counts.size(); c++)
+		{
+			WorkerCountOverride() = counts[c];
+			double best = 1e30;
+			for (int i = 0; i < iterations; i++)
+			{
+				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+				if (stage == 0)
+				{
+					float coefficients[9][4];
+					ProjectIrradiance(sky, coefficients);
+				}
+				else if (stage == 1)
+				{
+					std::vector<FloatCube> mips;
+					PrefilterSpecular(sky, settings, mips);
+				}
+				else
+				{
+					std::vector<float> lut;
+					IntegrateBrdf(settings, lut);
+				}
+				best = (std::min)(best, SecondsSince(start));
+			}
+
+			if (c == 0)
+				single = best;
+			double speedup = best > 0.0 ? single / best : 0.0;
+			printf("  %-5s %8u %8.1f %7.2fx %7.0f%%\n", stages[stage], counts[c], best * 1000.0, speedup,
+				speedup / (std::min)(counts[c], cores) * 100.0);
+		}
+	}
+	WorkerCountOverride() = previous;
+
+	if (cores == 1)
+		printf("Only one core here - more workers can only add their overhead\n");
+	return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Square cube map in linear float RGBA: face after face (+X, -X,
+// +Y, -Y, +Z, -Z), rows top to bottom
+struct FloatCube
+{
+	uint32_t Size = 0;
+	std::vector<float> Texels;
+
+	float* Face(uint32_t face) { return Texels.data() + (size_t)face * Size * Size * 4; }
+	const float* Face(uint32_t face) const { return Texels.data() + (size_t)face * Size * Size * 4; }
+};
+
+struct IblSettings
+{
+	uint32_t SpecularSize = 128;		// Top level of the prefiltered cube (never above the sky's own size)
+	uint32_t SpecularMips = 6;			// Roughness 0 at the top to 1 at the last mip
+	uint32_t SpecularSamples = 128;		// GGX samples per texel
+	uint32_t BrdfSize = 128;
+	uint32_t BrdfSamples = 512;
+
+	uint64_t Hash() const;
+};
+
+struct IblBakeStats
+{
+	std::string Name;
+	const char* Stage = "";				// SH9, GGX or BRDF
+	uint32_t Size = 0;
+	uint32_t MipLevels = 0;
+	size_t Samples = 0;					// Source lookups (or BRDF evaluations) made
+	double Seconds = 0.0;
+	unsigned int Workers = 0;
+	bool Ok = false;
+};
+
+// --------------------------------------------------------
+// Offline image-based lighting from the sky's cube map
+//
+// - Irradiance: the sky projected onto 9 spherical harmonics,
+//   already convolved with the cosine lobe and divided by pi,
+//   so diffuse ambient is albedo * the SH evaluated at N
+// - Specular: GGX importance sampled per mip (one roughness per
+//   mip), reading lower-resolution source mips for samples that
+//   cover more of the sphere so few samples stay noise free
+// - BRDF: the split-sum scale and bias of F0 over N.V and
+//   roughness, using the same GGX as ShaderIncludes
+//
+// Texels (or LUT rows) are split across worker threads and the
+// sample loops work on whole RGBA texels in SSE registers.
+// Everything is written as DDS - half floats for the textures,
+// a 9x1 float texture for the SH - so it cooks and packs like
+// every other asset
+// --------------------------------------------------------
+class IblBaker
+{
+public:
+	// Top mip of a DDS cube map as linear float.  8-bit formats are
+	// taken as gamma encoded (the sky shader outputs them as they are);
+	// BC1, 8-bit RGBA/BGRA and 16/32-bit float formats are understood
+	static bool LoadCube(const uint8_t* data, size_t size, FloatCube& cube);
+
+	// coefficients[i] is RGB + unused, ready for the shader's shIrradiance
+	static unsigned int ProjectIrradiance(const FloatCube& sky, float coefficients[9][4]);
+	static unsigned int PrefilterSpecular(const FloatCube& sky, const IblSettings& settings, std::vector<FloatCube>& mips, size_t* samples = nullptr);
+	static unsigned int IntegrateBrdf(const IblSettings& settings, std::vector<float>& lut);
+
+	static bool BakeIrradiance(const std::string& source, const std::string& destination, IblBakeStats* stats = nullptr);
+	static bool BakeSpecular(const std::string& source, const std::string& destination, const IblSettings& settings, IblBakeStats* stats = nullptr);
+	static bool BakeBrdf(const std::string& destination, const IblSettings& settings, IblBakeStats* stats = nullptr);
+
+	static void Report(const std::vector<IblBakeStats>& bakes);
+
+	// Times each stage (best of iterations) on 1, 2, 4 and one worker per core,
+	// forced through WorkerCountOverride.  An empty source uses a made-up
+	// gradient sky.  Run it headless with AssetCooker --benchmark-ibl
+	static bool Benchmark(const std::string& source, const IblSettings& settings, int iterations);
+};
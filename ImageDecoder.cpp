@@ -0,0 +1,809 @@
+#include "ImageDecoder.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	const uint8_t PngSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+	// Anything bigger than this per side is almost certainly a corrupt header
+	const uint32_t MaxDimension = 32768;
+
+	// Batch slices start on a 16 byte boundary
+	const size_t BatchAlignment = 16;
+
+	double SecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	uint32_t ReadBE32(const uint8_t* p)
+	{
+		return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+	}
+
+	// --------------------------------------------------------
+	// Inflate (RFC 1950/1951)
+	// --------------------------------------------------------
+
+	// Codes up to this long are decoded with one table lookup, longer ones bit by bit
+	const int FastBits = 10;
+
+	const uint16_t LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const uint8_t LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const uint16_t DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const uint8_t DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	const uint8_t CodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	// Canonical Huffman code: a lookup table for short codes plus
+	// counts/symbols for walking longer ones (as in zlib's puff)
+	struct Huffman
+	{
+		uint16_t fast[1 << FastBits];	// (symbol << 4) | length, 0 = too long for the table
+		uint16_t counts[16];
+		uint16_t symbols[288];
+
+		bool Build(const uint8_t* lengths, int count)
+		{
+			memset(counts, 0, sizeof(counts));
+			for (int i = 0; i < count; i++)
+				counts[lengths[i]]++;
+			counts[0] = 0;
+
+			//Over-subscribed codes can't be decoded (incomplete ones are allowed)
+			int left = 1;
+			for (int len = 1; len < 16; len++)
+			{
+				left = (left << 1) - counts[len];
+				if (left < 0)
+					return false;
+			}
+
+			uint16_t offsets[16];
+			offsets[1] = 0;
+			for (int len = 1; len < 15; len++)
+				offsets[len + 1] = offsets[len] + counts[len];
+			for (int i = 0; i < count; i++)
+			{
+				if (lengths[i])
+					symbols[offsets[lengths[i]]++] = (uint16_t)i;
+			}
+
+			//Codes are stored MSB first but read LSB first, so the table is indexed by reversed codes
+			memset(fast, 0, sizeof(fast));
+			uint32_t code = 0;
+			int index = 0;
+			for (int len = 1; len < 16; len++)
+			{
+				for (int k = 0; k < counts[len]; k++, code++)
+				{
+					uint16_t symbol = symbols[index++];
+					if (len > FastBits)
+						continue;
+
+					uint32_t reversed = 0;
+					for (int b = 0; b < len; b++)
+						reversed |= ((code >> b) & 1) << (len - 1 - b);
+					for (uint32_t j = reversed; j < (1u << FastBits); j += 1u << len)
+						fast[j] = (uint16_t)((symbol << 4) | len);
+				}
+				code <<= 1;
+			}
+			return true;
+		}
+	};
+
+	struct BitReader
+	{
+		const uint8_t* p;
+		const uint8_t* end;
+		uint64_t bits;
+		int count;
+		size_t padding;		// Zero bytes fed in past the end
+
+		BitReader(const uint8_t* data, size_t size) : p(data), end(data + size), bits(0), count(0), padding(0) {}
+
+		void Refill()
+		{
+			while (count <= 56)
+			{
+				if (p < end)
+					bits |= (uint64_t)*p++ << count;
+				else
+					padding++;
+				count += 8;
+			}
+		}
+
+		uint32_t Bits(int n)
+		{
+			if (n == 0)
+				return 0;
+			if (count < n)
+				Refill();
+			uint32_t value = (uint32_t)(bits & ((1ull << n) - 1));
+			bits >>= n;
+			count -= n;
+			return value;
+		}
+
+		int Decode(const Huffman& h)
+		{
+			if (count < 16)
+				Refill();
+
+			uint16_t entry = h.fast[bits & ((1u << FastBits) - 1)];
+			if (entry)
+			{
+				int len = entry & 15;
+				bits >>= len;
+				count -= len;
+				return entry >> 4;
+			}
+
+			int code = 0, first = 0, index = 0;
+			for (int len = 1; len < 16; len++)
+			{
+				code |= (int)(bits & 1);
+				bits >>= 1;
+				count--;
+
+				int c = h.counts[len];
+				if (code - c < first)
+					return h.symbols[index + (code - first)];
+				index += c;
+				first = (first + c) << 1;
+				code <<= 1;
+			}
+			return -1;
+		}
+
+		// Consumed more than the real data?
+		bool Overrun() const
+		{
+			return padding * 8 > (size_t)count;
+		}
+	};
+
+	// Inflates a zlib stream into out, returns the number of bytes written (or -1)
+	long long Inflate(const uint8_t* src, size_t srcSize, uint8_t* out, size_t outSize)
+	{
+		if (srcSize < 2 || (src[0] & 15) != 8 || ((src[0] << 8) | src[1]) % 31 != 0 || (src[1] & 32))
+			return -1;
+
+		BitReader in(src + 2, srcSize - 2);
+		Huffman* tables = new Huffman[3];
+		Huffman& literals = tables[0];
+		Huffman& distances = tables[1];
+		Huffman& lengthCodes = tables[2];
+		size_t pos = 0;
+		bool ok = true;
+		bool last = false;
+
+		while (ok && !last)
+		{
+			last = in.Bits(1) != 0;
+			uint32_t type = in.Bits(2);
+
+			if (type == 0)
+			{
+				//Stored - byte aligned LEN, ~LEN, then raw bytes
+				in.Bits(in.count & 7);
+				uint32_t len = in.Bits(16);
+				uint32_t nlen = in.Bits(16);
+				if ((len ^ 0xFFFF) != nlen || pos + len > outSize)
+				{
+					ok = false;
+					break;
+				}
+				for (uint32_t i = 0; i < len; i++)
+					out[pos++] = (uint8_t)in.Bits(8);
+				continue;
+			}
+
+			uint8_t lengths[288 + 32];
+			if (type == 1)
+			{
+				//Fixed codes
+				for (int i = 0; i < 144; i++) lengths[i] = 8;
+				for (int i = 144; i < 256; i++) lengths[i] = 9;
+				for (int i = 256; i < 280; i++) lengths[i] = 7;
+				for (int i = 280; i < 288; i++) lengths[i] = 8;
+				ok = literals.Build(lengths, 288);
+				for (int i = 0; i < 30; i++) lengths[i] = 5;
+				ok = ok && distances.Build(lengths, 30);
+			}
+			else if (type == 2)
+			{
+				//Dynamic codes, themselves Huffman coded
+				int literalCount = (int)in.Bits(5) + 257;
+				int distanceCount = (int)in.Bits(5) + 1;
+				int codeLengthCount = (int)in.Bits(4) + 4;
+
+				uint8_t codeLengths[19] = {};
+				for (int i = 0; i < codeLengthCount; i++)
+					codeLengths[CodeLengthOrder[i]] = (uint8_t)in.Bits(3);
+				ok = lengthCodes.Build(codeLengths, 19);
+
+				int n = 0;
+				while (ok && n < literalCount + distanceCount)
+				{
+					int symbol = in.Decode(lengthCodes);
+					int repeat = 0;
+					uint8_t value = 0;
+					if (symbol < 0)
+						ok = false;
+					else if (symbol < 16)
+						lengths[n++] = (uint8_t)symbol;
+					else if (symbol == 16)
+					{
+						if (n == 0)
+							ok = false;
+						else
+						{
+							value = lengths[n - 1];
+							repeat = 3 + (int)in.Bits(2);
+						}
+					}
+					else if (symbol == 17)
+						repeat = 3 + (int)in.Bits(3);
+					else
+						repeat = 11 + (int)in.Bits(7);
+
+					if (n + repeat > literalCount + distanceCount)
+						ok = false;
+					for (int i = 0; ok && i < repeat; i++)
+						lengths[n++] = value;
+				}
+
+				ok = ok && lengths[256] != 0;
+				ok = ok && literals.Build(lengths, literalCount);
+				ok = ok && distances.Build(lengths + literalCount, distanceCount);
+			}
+			else
+			{
+				ok = false;
+			}
+
+			//Literal/length + distance pairs until end of block
+			while (ok)
+			{
+				int symbol = in.Decode(literals);
+				if (symbol < 0)
+				{
+					ok = false;
+				}
+				else if (symbol < 256)
+				{
+					if (pos >= outSize)
+						ok = false;
+					else
+						out[pos++] = (uint8_t)symbol;
+				}
+				else if (symbol == 256)
+				{
+					break;
+				}
+				else
+				{
+					//Length extra bits come before the distance code
+					symbol -= 257;
+					if (symbol >= 29)
+					{
+						ok = false;
+						break;
+					}
+					size_t len = LengthBase[symbol] + in.Bits(LengthExtra[symbol]);
+
+					int distanceSymbol = in.Decode(distances);
+					if (distanceSymbol < 0 || distanceSymbol >= 30)
+					{
+						ok = false;
+						break;
+					}
+					size_t distance = DistanceBase[distanceSymbol] + in.Bits(DistanceExtra[distanceSymbol]);
+					if (distance > pos || pos + len > outSize)
+					{
+						ok = false;
+						break;
+					}
+
+					uint8_t* dst = out + pos;
+					const uint8_t* from = dst - distance;
+					if (distance >= len)
+						memcpy(dst, from, len);
+					else
+					{
+						//Overlapping - repeats the last `distance` bytes
+						for (size_t i = 0; i < len; i++)
+							dst[i] = from[i];
+					}
+					pos += len;
+				}
+			}
+
+			if (in.Overrun())
+				ok = false;
+		}
+
+		delete[] tables;
+		return ok ? (long long)pos : -1;
+	}
+
+	// --------------------------------------------------------
+	// PNG
+	// --------------------------------------------------------
+
+	struct PngHeader
+	{
+		uint32_t Width;
+		uint32_t Height;
+		int Depth;
+		int ColorType;
+		int Interlace;
+		int BitsPerPixel;
+
+		uint8_t Palette[256][4];
+		int PaletteSize;
+
+		bool HasKey;			// tRNS for grey/RGB - this exact colour is transparent
+		uint16_t Key[3];
+	};
+
+	int ChannelCount(int colorType)
+	{
+		switch (colorType)
+		{
+		case 0: return 1;		// Grey
+		case 2: return 3;		// RGB
+		case 3: return 1;		// Palette
+		case 4: return 2;		// Grey + alpha
+		case 6: return 4;		// RGBA
+		default: return 0;
+		}
+	}
+
+	bool ValidDepth(int colorType, int depth)
+	{
+		switch (colorType)
+		{
+		case 0: return depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+		case 3: return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+		case 2: case 4: case 6: return depth == 8 || depth == 16;
+		default: return false;
+		}
+	}
+
+	// Walks the chunks up to (and, when idat is given, through) the image data
+	bool ParsePng(const uint8_t* data, size_t size, PngHeader& header, bool& srgb, std::vector<uint8_t>* idat)
+	{
+		if (size < 8 + 25 || memcmp(data, PngSignature, 8) != 0)
+			return false;
+
+		memset(&header, 0, sizeof(header));
+		srgb = false;
+
+		bool sawHeader = false;
+		bool sawData = false;
+		size_t pos = 8;
+		while (pos + 12 <= size)
+		{
+			uint32_t length = ReadBE32(data + pos);
+			const uint8_t* type = data + pos + 4;
+			const uint8_t* body = data + pos + 8;
+			if (length > size - pos - 12)
+				return false;
+
+			if (memcmp(type, "IHDR", 4) == 0)
+			{
+				if (length != 13)
+					return false;
+				header.Width = ReadBE32(body);
+				header.Height = ReadBE32(body + 4);
+				header.Depth = body[8];
+				header.ColorType = body[9];
+				header.Interlace = body[12];
+				if (header.Width == 0 || header.Height == 0 || header.Width > MaxDimension || header.Height > MaxDimension ||
+					!ValidDepth(header.ColorType, header.Depth) || body[10] != 0 || body[11] != 0 || header.Interlace > 1)
+					return false;
+				header.BitsPerPixel = header.Depth * ChannelCount(header.ColorType);
+				sawHeader = true;
+			}
+			else if (!sawHeader)
+			{
+				return false;
+			}
+			else if (memcmp(type, "PLTE", 4) == 0)
+			{
+				header.PaletteSize = (int)(length / 3);
+				if (header.PaletteSize > 256)
+					return false;
+				for (int i = 0; i < header.PaletteSize; i++)
+				{
+					header.Palette[i][0] = body[i * 3 + 0];
+					header.Palette[i][1] = body[i * 3 + 1];
+					header.Palette[i][2] = body[i * 3 + 2];
+					header.Palette[i][3] = 255;
+				}
+			}
+			else if (memcmp(type, "tRNS", 4) == 0)
+			{
+				if (header.ColorType == 3)
+				{
+					for (uint32_t i = 0; i < length && i < 256; i++)
+						header.Palette[i][3] = body[i];
+				}
+				else if (header.ColorType == 0 && length >= 2)
+				{
+					header.HasKey = true;
+					header.Key[0] = (uint16_t)((body[0] << 8) | body[1]);
+				}
+				else if (header.ColorType == 2 && length >= 6)
+				{
+					header.HasKey = true;
+					for (int c = 0; c < 3; c++)
+						header.Key[c] = (uint16_t)((body[c * 2] << 8) | body[c * 2 + 1]);
+				}
+			}
+			else if (memcmp(type, "sRGB", 4) == 0)
+			{
+				srgb = true;
+			}
+			else if (memcmp(type, "IDAT", 4) == 0)
+			{
+				sawData = true;
+				if (!idat)
+					return true;
+				idat->insert(idat->end(), body, body + length);
+			}
+			else if (memcmp(type, "IEND", 4) == 0)
+			{
+				break;
+			}
+
+			pos += 12 + (size_t)length;
+		}
+
+		if (!sawHeader || !sawData)
+			return false;
+		if (header.ColorType == 3 && header.PaletteSize == 0)
+			return false;
+		return true;
+	}
+
+	size_t RowBytes(const PngHeader& header, uint32_t width)
+	{
+		return ((size_t)width * header.BitsPerPixel + 7) / 8;
+	}
+
+	uint8_t Paeth(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = p > a ? p - a : a - p;
+		int pb = p > b ? p - b : b - p;
+		int pc = p > c ? p - c : c - p;
+		if (pa <= pb && pa <= pc) return (uint8_t)a;
+		if (pb <= pc) return (uint8_t)b;
+		return (uint8_t)c;
+	}
+
+	// Undoes the per-row filters in place.  Each row is [filter byte][rowBytes]
+	bool Unfilter(uint8_t* rows, uint32_t rowCount, size_t rowBytes, int bytesPerPixel)
+	{
+		const uint8_t* previous = nullptr;
+		for (uint32_t y = 0; y < rowCount; y++)
+		{
+			uint8_t* row = rows + y * (rowBytes + 1);
+			uint8_t filter = row[0];
+			uint8_t* cur = row + 1;
+
+			switch (filter)
+			{
+			case 0:
+				break;
+			case 1:
+				for (size_t i = bytesPerPixel; i < rowBytes; i++)
+					cur[i] = (uint8_t)(cur[i] + cur[i - bytesPerPixel]);
+				break;
+			case 2:
+				if (previous)
+				{
+					for (size_t i = 0; i < rowBytes; i++)
+						cur[i] = (uint8_t)(cur[i] + previous[i]);
+				}
+				break;
+			case 3:
+				for (size_t i = 0; i < rowBytes; i++)
+				{
+					int left = i >= (size_t)bytesPerPixel ? cur[i - bytesPerPixel] : 0;
+					int up = previous ? previous[i] : 0;
+					cur[i] = (uint8_t)(cur[i] + ((left + up) >> 1));
+				}
+				break;
+			case 4:
+				for (size_t i = 0; i < rowBytes; i++)
+				{
+					int left = i >= (size_t)bytesPerPixel ? cur[i - bytesPerPixel] : 0;
+					int up = previous ? previous[i] : 0;
+					int upLeft = previous && i >= (size_t)bytesPerPixel ? previous[i - bytesPerPixel] : 0;
+					cur[i] = (uint8_t)(cur[i] + Paeth(left, up, upLeft));
+				}
+				break;
+			default:
+				return false;
+			}
+
+			previous = cur;
+		}
+		return true;
+	}
+
+	// Sample i of a row packed at depth bits per sample (depth <= 8)
+	uint32_t PackedSample(const uint8_t* row, uint32_t i, int depth)
+	{
+		size_t bit = (size_t)i * depth;
+		int shift = 8 - depth - (int)(bit & 7);
+		return (row[bit >> 3] >> shift) & ((1u << depth) - 1);
+	}
+
+	// Unfiltered row -> RGBA8 pixels, outStep bytes apart
+	void ConvertRow(const PngHeader& h, const uint8_t* row, uint32_t count, uint8_t* out, size_t outStep)
+	{
+		//The common case - nothing to convert
+		if (h.ColorType == 6 && h.Depth == 8 && outStep == 4)
+		{
+			memcpy(out, row, (size_t)count * 4);
+			return;
+		}
+
+		for (uint32_t i = 0; i < count; i++, out += outStep)
+		{
+			switch (h.ColorType)
+			{
+			case 0:
+			{
+				uint32_t raw;
+				uint8_t grey;
+				if (h.Depth == 16)
+				{
+					raw = ((uint32_t)row[i * 2] << 8) | row[i * 2 + 1];
+					grey = row[i * 2];
+				}
+				else if (h.Depth == 8)
+				{
+					raw = row[i];
+					grey = row[i];
+				}
+				else
+				{
+					raw = PackedSample(row, i, h.Depth);
+					grey = (uint8_t)(raw * 255 / ((1u << h.Depth) - 1));
+				}
+				out[0] = out[1] = out[2] = grey;
+				out[3] = h.HasKey && raw == h.Key[0] ? 0 : 255;
+				break;
+			}
+			case 2:
+			{
+				if (h.Depth == 16)
+				{
+					const uint8_t* p = row + i * 6;
+					out[0] = p[0]; out[1] = p[2]; out[2] = p[4];
+					out[3] = h.HasKey && ((p[0] << 8) | p[1]) == h.Key[0] && ((p[2] << 8) | p[3]) == h.Key[1] && ((p[4] << 8) | p[5]) == h.Key[2] ? 0 : 255;
+				}
+				else
+				{
+					const uint8_t* p = row + i * 3;
+					out[0] = p[0]; out[1] = p[1]; out[2] = p[2];
+					out[3] = h.HasKey && p[0] == h.Key[0] && p[1] == h.Key[1] && p[2] == h.Key[2] ? 0 : 255;
+				}
+				break;
+			}
+			case 3:
+			{
+				uint32_t index = h.Depth == 8 ? row[i] : PackedSample(row, i, h.Depth);
+				if ((int)index < h.PaletteSize)
+					memcpy(out, h.Palette[index], 4);
+				else
+					out[0] = out[1] = out[2] = 0, out[3] = 255;
+				break;
+			}
+			case 4:
+			{
+				int step = h.Depth == 16 ? 2 : 1;
+				const uint8_t* p = row + i * 2 * step;
+				out[0] = out[1] = out[2] = p[0];
+				out[3] = p[step];
+				break;
+			}
+			case 6:
+			{
+				int step = h.Depth == 16 ? 2 : 1;
+				const uint8_t* p = row + i * 4 * step;
+				out[0] = p[0]; out[1] = p[step]; out[2] = p[step * 2]; out[3] = p[step * 3];
+				break;
+			}
+			}
+		}
+	}
+
+	// Adam7 pass layout: x start, y start, x step, y step
+	const uint32_t Adam7[7][4] = { { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 } };
+
+	void PassSize(const PngHeader& h, int pass, uint32_t& width, uint32_t& height)
+	{
+		width = h.Width > Adam7[pass][0] ? (h.Width - Adam7[pass][0] + Adam7[pass][2] - 1) / Adam7[pass][2] : 0;
+		height = h.Height > Adam7[pass][1] ? (h.Height - Adam7[pass][1] + Adam7[pass][3] - 1) / Adam7[pass][3] : 0;
+	}
+}
+
+bool ImageDecoder::ReadPngInfo(const uint8_t* data, size_t size, ImageInfo& info)
+{
+	PngHeader header;
+	if (!data || !ParsePng(data, size, header, info.SRGB, nullptr))
+		return false;
+
+	info.Width = header.Width;
+	info.Height = header.Height;
+	return true;
+}
+
+// --------------------------------------------------------
+// Inflates every IDAT into one buffer of filtered rows, then
+// unfilters and converts each row (or each Adam7 pass) straight
+// into the output
+// --------------------------------------------------------
+bool ImageDecoder::DecodePng(const uint8_t* data, size_t size, uint8_t* out, size_t outSize)
+{
+	PngHeader header;
+	bool srgb;
+	std::vector<uint8_t> compressed;
+	if (!data || !ParsePng(data, size, header, srgb, &compressed))
+		return false;
+	if (outSize < (size_t)header.Width * header.Height * 4)
+		return false;
+
+	int bytesPerPixel = header.BitsPerPixel >= 8 ? header.BitsPerPixel / 8 : 1;
+
+	size_t filteredSize = 0;
+	if (header.Interlace == 0)
+	{
+		filteredSize = (size_t)header.Height * (RowBytes(header, header.Width) + 1);
+	}
+	else
+	{
+		for (int pass = 0; pass < 7; pass++)
+		{
+			uint32_t w, h;
+			PassSize(header, pass, w, h);
+			if (w && h)
+				filteredSize += (size_t)h * (RowBytes(header, w) + 1);
+		}
+	}
+
+	std::vector<uint8_t> filtered(filteredSize);
+	if (Inflate(compressed.data(), compressed.size(), filtered.data(), filteredSize) != (long long)filteredSize)
+		return false;
+
+	if (header.Interlace == 0)
+	{
+		size_t rowBytes = RowBytes(header, header.Width);
+		if (!Unfilter(filtered.data(), header.Height, rowBytes, bytesPerPixel))
+			return false;
+
+		for (uint32_t y = 0; y < header.Height; y++)
+			ConvertRow(header, &filtered[y * (rowBytes + 1) + 1], header.Width, out + (size_t)y * header.Width * 4, 4);
+		return true;
+	}
+
+	uint8_t* passData = filtered.data();
+	for (int pass = 0; pass < 7; pass++)
+	{
+		uint32_t w, h;
+		PassSize(header, pass, w, h);
+		if (!w || !h)
+			continue;
+
+		size_t rowBytes = RowBytes(header, w);
+		if (!Unfilter(passData, h, rowBytes, bytesPerPixel))
+			return false;
+
+		for (uint32_t y = 0; y < h; y++)
+		{
+			size_t outY = Adam7[pass][1] + (size_t)y * Adam7[pass][3];
+			uint8_t* dst = out + (outY * header.Width + Adam7[pass][0]) * 4;
+			ConvertRow(header, passData + y * (rowBytes + 1) + 1, w, dst, Adam7[pass][2] * 4);
+		}
+		passData += h * (rowBytes + 1);
+	}
+	return true;
+}
+
+size_t ImageDecoder::PlanBatch(const std::vector<std::string>& paths, std::vector<DecodedImage>& images, AssetPack* pack)
+{
+	images.clear();
+	images.resize(paths.size());
+
+	size_t total = 0;
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		DecodedImage& image = images[i];
+		image.Path = paths[i];
+
+		if (pack && pack->Find(paths[i], image.Source))
+			image.Ok = ReadPngInfo(image.Source.Data, image.Source.Size, image.Info);
+		else
+		{
+			MappedFile file(paths[i].c_str());
+			image.Ok = file.IsOpen() && ReadPngInfo(file.GetData(), file.GetSize(), image.Info);
+		}
+		if (!image.Ok)
+			continue;
+
+		image.Offset = total;
+		total += (image.Info.DecodedSize() + BatchAlignment - 1) & ~(BatchAlignment - 1);
+	}
+	return total;
+}
+
+void ImageDecoder::DecodeBatch(std::vector<DecodedImage>& images, uint8_t* memory, ImageBatchStats* stats)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	//Images are few and uneven in size, so hand them out one at a time
+	unsigned int workers = ParallelFor(images.size(), [&](size_t i)
+	{
+		DecodedImage& image = images[i];
+		if (!image.Ok)
+			return;
+
+		std::chrono::high_resolution_clock::time_point imageStart = std::chrono::high_resolution_clock::now();
+		if (image.Source.Data)
+			image.Ok = DecodePng(image.Source.Data, image.Source.Size, memory + image.Offset, image.Info.DecodedSize());
+		else
+		{
+			MappedFile file(image.Path.c_str());
+			image.Ok = file.IsOpen() && DecodePng(file.GetData(), file.GetSize(), memory + image.Offset, image.Info.DecodedSize());
+		}
+		image.DecodeSeconds = SecondsSince(imageStart);
+	});
+
+	if (stats)
+	{
+		*stats = ImageBatchStats();
+		stats->Images = images.size();
+		stats->Workers = workers;
+		for (size_t i = 0; i < images.size(); i++)
+		{
+			stats->DecodeSeconds += images[i].DecodeSeconds;
+			if (images[i].Ok)
+				stats->Bytes += images[i].Info.DecodedSize();
+			else
+				stats->Failed++;
+		}
+		stats->WallSeconds = SecondsSince(start);
+	}
+}
+
+void ImageDecoder::ReportBatch(const std::vector<DecodedImage>& images, const ImageBatchStats& stats)
+{
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		const DecodedImage& image = images[i];
+		size_t slash = image.Path.find_last_of("/\\");
+		const char* name = image.Path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+
+		if (image.Ok)
+			printf("  %-28s %5ux%-5u %7.2f ms\n", name, image.Info.Width, image.Info.Height, image.DecodeSeconds * 1000.0);
+		else
+			printf("  %-28s FAILED\n", name);
+	}
+
+	printf("Decoded %zu images (%.1f MB) on %u threads: %.2f ms wall, %.2f ms of decoding - saved %.2f ms\n",
+		stats.Images - stats.Failed, stats.Bytes / (1024.0 * 1024.0), stats.Workers,
+		stats.WallSeconds * 1000.0, stats.DecodeSeconds * 1000.0, stats.SavedSeconds() * 1000.0);
+}
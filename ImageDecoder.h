@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+
+// --------------------------------------------------------
+// What a PNG header says about the image
+// --------------------------------------------------------
+struct ImageInfo
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	bool SRGB = false;			// Has an sRGB chunk (the WIC loader treats these as _SRGB formats)
+
+	// Size of the RGBA8 pixels the decoder writes
+	size_t DecodedSize() const { return (size_t)Width * Height * 4; }
+};
+
+// --------------------------------------------------------
+// One image of a batch - where its pixels went and how long it took
+// --------------------------------------------------------
+struct DecodedImage
+{
+	std::string Path;
+	AssetSpan Source;			// The PNG's bytes when they came out of a pack (Path isn't read then)
+	ImageInfo Info;
+	size_t Offset = 0;			// Into the batch's pixel memory
+	double DecodeSeconds = 0.0;
+	bool Ok = false;
+};
+
+struct ImageBatchStats
+{
+	size_t Images = 0;
+	size_t Failed = 0;
+	size_t Bytes = 0;				// Decoded RGBA8 bytes
+	unsigned int Workers = 0;
+	double DecodeSeconds = 0.0;		// Sum of every image's decode (what decoding one after another costs)
+	double WallSeconds = 0.0;		// Start to finish of the parallel batch
+
+	double SavedSeconds() const { return DecodeSeconds - WallSeconds; }
+};
+
+// --------------------------------------------------------
+// PNG to RGBA8 without WIC, so textures can be decoded on any
+// thread (and headless on Linux)
+//
+// - Own inflate (stored/fixed/dynamic blocks, table driven)
+// - Every colour type and bit depth, palettes, tRNS and Adam7
+//   interlacing; 16-bit channels keep their high byte
+// - Decodes into memory the caller provides, so a batch can
+//   go into one allocation
+// --------------------------------------------------------
+class ImageDecoder
+{
+public:
+	// Reads just the header chunks
+	static bool ReadPngInfo(const uint8_t* data, size_t size, ImageInfo& info);
+
+	// out needs info.DecodedSize() bytes
+	static bool DecodePng(const uint8_t* data, size_t size, uint8_t* out, size_t outSize);
+
+	// Reads every header and lays the images out one after another.
+	// Paths the pack has are decoded from it, the rest from disk.
+	// Returns how many bytes of memory DecodeBatch needs
+	static size_t PlanBatch(const std::vector<std::string>& paths, std::vector<DecodedImage>& images, AssetPack* pack = nullptr);
+
+	// Decodes a planned batch on worker threads, each image into its own slice of memory
+	static void DecodeBatch(std::vector<DecodedImage>& images, uint8_t* memory, ImageBatchStats* stats = nullptr);
+
+	// Per-image decode times and the total saved over decoding one after another
+	static void ReportBatch(const std::vector<DecodedImage>& images, const ImageBatchStats& stats);
+};
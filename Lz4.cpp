@@ -0,0 +1,205 @@
+#include "Lz4.h"
+
+#include <cstring>
+
+namespace
+{
+	const size_t MinMatch = 4;
+	const size_t LastLiterals = 5;		// The block has to end with at least this many literals
+	const size_t MatchSafety = 12;		// ...and the last match has to start at least this far from the end
+	const size_t MaxOffset = 65535;
+
+	const int HashBits = 12;
+
+	uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t v;
+		memcpy(&v, p, 4);
+		return v;
+	}
+
+	uint32_t HashSequence(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HashBits);
+	}
+
+	// 15 in the token, then 255s and a remainder
+	uint8_t* WriteLength(uint8_t* out, size_t length)
+	{
+		length -= 15;
+		while (length >= 255)
+		{
+			*out++ = 255;
+			length -= 255;
+		}
+		*out++ = (uint8_t)length;
+		return out;
+	}
+
+	// Bytes one sequence takes at most
+	size_t SequenceBound(size_t literals, size_t matchLength)
+	{
+		return 1 + literals / 255 + 1 + literals + 2 + matchLength / 255 + 1;
+	}
+}
+
+size_t Lz4::CompressBound(size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+size_t Lz4::Compress(const uint8_t* source, size_t size, uint8_t* destination, size_t capacity)
+{
+	uint8_t* out = destination;
+	uint8_t* outEnd = destination + capacity;
+	size_t anchor = 0;
+
+	if (size > MatchSafety)
+	{
+		uint32_t table[1 << HashBits];
+		memset(table, 0, sizeof(table));
+
+		size_t matchLimit = size - LastLiterals;
+		size_t searchEnd = size - MatchSafety;
+		size_t pos = 1;
+		table[HashSequence(Read32(source))] = 0;
+
+		while (pos <= searchEnd)
+		{
+			uint32_t sequence = Read32(source + pos);
+			uint32_t hash = HashSequence(sequence);
+			size_t candidate = table[hash];
+			table[hash] = (uint32_t)pos;
+
+			if (pos - candidate > MaxOffset || Read32(source + candidate) != sequence)
+			{
+				//Step further the longer nothing has matched, so incompressible data goes quickly
+				pos += 1 + ((pos - anchor) >> 6);
+				continue;
+			}
+
+			//The match may also extend back into the pending literals
+			while (pos > anchor && candidate > 0 && source[pos - 1] == source[candidate - 1])
+			{
+				pos--;
+				candidate--;
+			}
+
+			size_t length = MinMatch;
+			while (pos + length < matchLimit && source[pos + length] == source[candidate + length])
+				length++;
+
+			size_t literals = pos - anchor;
+			size_t matchLength = length - MinMatch;
+			if ((size_t)(outEnd - out) < SequenceBound(literals, matchLength))
+				return 0;
+
+			uint8_t* token = out++;
+			*token = (uint8_t)(((literals < 15 ? literals : 15) << 4) | (matchLength < 15 ? matchLength : 15));
+			if (literals >= 15)
+				out = WriteLength(out, literals);
+			memcpy(out, source + anchor, literals);
+			out += literals;
+
+			size_t offset = pos - candidate;
+			*out++ = (uint8_t)(offset & 0xFF);
+			*out++ = (uint8_t)(offset >> 8);
+			if (matchLength >= 15)
+				out = WriteLength(out, matchLength);
+
+			pos += length;
+			anchor = pos;
+
+			//Seed the table just behind the match so back-to-back repeats are found
+			if (pos - 2 <= searchEnd)
+				table[HashSequence(Read32(source + pos - 2))] = (uint32_t)(pos - 2);
+		}
+	}
+
+	//Whatever is left goes out as literals
+	size_t literals = size - anchor;
+	if ((size_t)(outEnd - out) < 1 + literals / 255 + 1 + literals)
+		return 0;
+
+	uint8_t* token = out++;
+	*token = (uint8_t)((literals < 15 ? literals : 15) << 4);
+	if (literals >= 15)
+		out = WriteLength(out, literals);
+	if (literals)
+		memcpy(out, source + anchor, literals);
+	out += literals;
+
+	return out - destination;
+}
+
+bool Lz4::Decompress(const uint8_t* source, size_t size, uint8_t* destination, size_t originalSize)
+{
+	size_t in = 0;
+	size_t out = 0;
+
+	while (true)
+	{
+		if (in >= size)
+			return false;
+		uint8_t token = source[in++];
+
+		size_t literals = token >> 4;
+		if (literals == 15)
+		{
+			uint8_t b;
+			do
+			{
+				if (in >= size)
+					return false;
+				b = source[in++];
+				literals += b;
+			} while (b == 255);
+		}
+
+		if (literals > size - in || literals > originalSize - out)
+			return false;
+		if (literals)
+			memcpy(destination + out, source + in, literals);
+		in += literals;
+		out += literals;
+
+		//The last sequence has no match
+		if (in == size)
+			return out == originalSize;
+
+		if (size - in < 2)
+			return false;
+		size_t offset = source[in] | (source[in + 1] << 8);
+		in += 2;
+		if (offset == 0 || offset > out)
+			return false;
+
+		size_t length = token & 15;
+		if (length == 15)
+		{
+			uint8_t b;
+			do
+			{
+				if (in >= size)
+					return false;
+				b = source[in++];
+				length += b;
+			} while (b == 255);
+		}
+		length += MinMatch;
+
+		if (length > originalSize - out)
+			return false;
+
+		//Matches may overlap what they write (offset < length repeats a pattern)
+		const uint8_t* from = destination + out - offset;
+		if (offset >= length)
+			memcpy(destination + out, from, length);
+		else
+		{
+			for (size_t i = 0; i < length; i++)
+				destination[out + i] = from[i];
+		}
+		out += length;
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// --------------------------------------------------------
+// LZ4 block format (no frame header), compatible with the
+// reference lz4 library's LZ4_compress_default / LZ4_decompress_safe
+//
+// - Greedy compressor with a 4096-entry hash table - fast rather
+//   than small, since it's for cooking asset packs
+// - The decompressor checks every length and offset against both
+//   buffers, so corrupt data fails instead of reading or writing
+//   out of bounds
+// --------------------------------------------------------
+class Lz4
+{
+public:
+	// Largest output Compress can produce for `size` bytes
+	static size_t CompressBound(size_t size);
+
+	// Returns the compressed size, or 0 if it doesn't fit in `capacity`
+	static size_t Compress(const uint8_t* source, size_t size, uint8_t* destination, size_t capacity);
+
+	// `destination` must be exactly the original size - anything else is an error
+	static bool Decompress(const uint8_t* source, size_t size, uint8_t* destination, size_t originalSize);
+};
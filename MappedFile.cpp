@@ -0,0 +1,142 @@
+#include "MappedFile.h"
+#include <cstdint>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+	data(nullptr), size(0), isOpen(false), fileHandle(nullptr), mappingHandle(nullptr)
+{
+}
+
+MappedFile::MappedFile(const char* fileName) : MappedFile()
+{
+	Open(fileName);
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+// --------------------------------------------------------
+// Maps the entire file into memory as read-only
+//
+// fileName - Path to the file to map
+//
+// Returns true if the file is open (and mapped if non-empty)
+// --------------------------------------------------------
+bool MappedFile::Open(const char* fileName)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	size = (size_t)fileSize.QuadPart;
+	isOpen = true;
+
+	//Can't create a mapping of an empty file, but it's still a valid (empty) file
+	if (size == 0)
+		return true;
+
+	HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+	if (mapping == 0)
+	{
+		Close();
+		return false;
+	}
+	mappingHandle = mapping;
+
+	data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr)
+	{
+		Close();
+		return false;
+	}
+#else
+	int fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	//File descriptor is stored in the handle slot (offset by one so 0 still means "none")
+	fileHandle = (void*)(intptr_t)(fd + 1);
+	size = (size_t)fileStat.st_size;
+	isOpen = true;
+
+	if (size == 0)
+		return true;
+
+	void* mapped = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapped == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	//Loaders read front to back
+	madvise(mapped, size, MADV_SEQUENTIAL);
+	data = (const unsigned char*)mapped;
+#endif
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Unmaps the file and releases the OS handles
+// --------------------------------------------------------
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (data) UnmapViewOfFile(data);
+	if (mappingHandle) CloseHandle((HANDLE)mappingHandle);
+	if (fileHandle) CloseHandle((HANDLE)fileHandle);
+#else
+	if (data) munmap((void*)data, size);
+	if (fileHandle) close((int)(intptr_t)fileHandle - 1);
+#endif
+
+	data = nullptr;
+	size = 0;
+	isOpen = false;
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+}
+
+bool MappedFile::IsOpen()
+{
+	return isOpen;
+}
+
+const unsigned char* MappedFile::GetData()
+{
+	return data;
+}
+
+size_t MappedFile::GetSize()
+{
+	return size;
+}
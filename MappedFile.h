@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+// --------------------------------------------------------
+// Read-only memory mapping of a whole file
+//
+// - Used by the asset loaders so file contents can be parsed
+//   in place instead of being copied through a stream first
+// - Works on Windows (CreateFileMapping) and on POSIX (mmap)
+//   so the loaders can also be run headless on Linux
+// - Empty files open successfully with a null data pointer
+// --------------------------------------------------------
+class MappedFile
+{
+public:
+	MappedFile();
+	MappedFile(const char* fileName);
+	~MappedFile();
+
+	bool Open(const char* fileName);
+	void Close();
+
+	bool IsOpen();
+	const unsigned char* GetData();
+	size_t GetSize();
+
+private:
+	//Mappings own OS handles, so copying one would double-close them
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const unsigned char* data;
+	size_t size;
+	bool isOpen;
+
+	//Stored as void* so the header doesn't need Windows.h
+	void* fileHandle;
+	void* mappingHandle;
+};
@@ -1,9 +1,19 @@
 #include "Material.h"
+
+namespace
+{
+	//Hashed at compile time - only resolving them against a shader happens at run time
+	constexpr SimpleShaderName WorldName("world");
+	constexpr SimpleShaderName WorldInvTransposeName("worldInvTranspose");
+	constexpr SimpleShaderName ColorTintName("colorTint");
+	constexpr SimpleShaderName AlbedoSliceName("albedoSlice");
+	constexpr SimpleShaderName PositionOffsetName("positionOffset");
+}
 																								//, float _roughness
 Material::Material(SimplePixelShader* pShader, SimpleVertexShader* vShader, DirectX::XMFLOAT4 tint) :
-	pixelShader(pShader), vertexShader(vShader), colorTint(tint)
+	pixelShader(pShader), vertexShader(vShader), colorTint(tint), residency(nullptr)
 {
-
+	ResolveParameters();
 }
 
 Material::~Material()
@@ -25,6 +35,11 @@ DirectX::XMFLOAT4 Material::GetColorTint()
 	return colorTint;
 }
 
+const Material::DrawParameters& Material::GetDrawParameters()
+{
+	return drawParameters;
+}
+
 //float Material::GetRoughness()
 //{
 //	return roughness;
@@ -33,11 +48,13 @@ DirectX::XMFLOAT4 Material::GetColorTint()
 void Material::SetPixelShader(SimplePixelShader* pShader)
 {
 	pixelShader = pShader;
+	ResolveParameters();
 }
 
 void Material::SetVertexShader(SimpleVertexShader* vShader)
 {
 	vertexShader = vShader;
+	ResolveParameters();
 }
 
 void Material::SetColorTint(DirectX::XMFLOAT4 tint)
@@ -59,17 +76,54 @@ void Material::AddTextureSRV(std::string textureName, Microsoft::WRL::ComPtr<ID3
 	textureSRVs.insert({ textureName,textureSRV });
 }
 
+void Material::AddTexture(std::string textureName, TextureResidency* textureResidency, TextureHandle texture)
+{
+	residency = textureResidency;
+	residentTextures.insert({ textureName,texture });
+}
+
 void Material::AddSampler(std::string samplerName, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler)
 {
 	samplers.insert({ samplerName,sampler });
 }
 
+void Material::Bind()
+{
+	//An invalid parameter's buffer index is out of range, so nothing is copied without one
+	pixelShader->SetFloat4(colorTintParameter, colorTint);
+	pixelShader->CopyBufferData(colorTintParameter.ConstantBufferIndex);
+
+	ReadyTexture();
+}
+
 void Material::ReadyTexture()
 {
 	for (auto& t : textureSRVs)
 		pixelShader->SetShaderResourceView(t.first.c_str(), t.second);
 
+	//Counts as a use, so these stay resident (or get loaded) while the material is drawn
+	for (auto& t : residentTextures)
+		pixelShader->SetShaderResourceView(t.first.c_str(), residency->Use(t.second));
+
 	for (auto& s : samplers)
 		pixelShader->SetSamplerState(s.first.c_str(), s.second);
 }
 
+void Material::ResolveParameters()
+{
+	drawParameters = DrawParameters();
+	colorTintParameter = SimpleShaderParameter();
+
+	if (vertexShader)
+	{
+		drawParameters.World = vertexShader->GetParameter(WorldName);
+		drawParameters.WorldInvTranspose = vertexShader->GetParameter(WorldInvTransposeName);
+		drawParameters.Quantization = vertexShader->GetParameter(PositionOffsetName);
+	}
+
+	if (pixelShader)
+	{
+		drawParameters.AlbedoSlice = pixelShader->GetParameter(AlbedoSliceName);
+		colorTintParameter = pixelShader->GetParameter(ColorTintName);
+	}
+}
@@ -4,12 +4,22 @@
 #include <DirectXMath.h>
 #include <d3d11.h>
 #include "SimpleShader.h"
+#include "TextureResidency.h"
 #include <unordered_map>
 
 
 class Material
 {
-public:																					//, float _roughness
+public:
+	//The per-object variables Entity::Draw sets every draw, resolved whenever a shader is set
+	struct DrawParameters
+	{
+		SimpleShaderParameter World;
+		SimpleShaderParameter WorldInvTranspose;
+		SimpleShaderParameter AlbedoSlice;
+		SimpleShaderParameter Quantization;		// PackedVertexShader's PerMesh - invalid for other vertex shaders
+	};
+																					//, float _roughness
 	Material(SimplePixelShader* pShader, SimpleVertexShader* vShader, DirectX::XMFLOAT4 tint);
 	~Material();
 
@@ -17,6 +27,7 @@ public:																					//, float _roughness
 	SimplePixelShader* GetPixelShader();
 	SimpleVertexShader* GetVertexShader();
 	DirectX::XMFLOAT4 GetColorTint();
+	const DrawParameters& GetDrawParameters();
 	//float GetRoughness();
 
 	//Setters - not sure each is absolutely necessary right now
@@ -26,18 +37,27 @@ public:																					//, float _roughness
 	//void SetRoughness(float _roughness);
 
 	void AddTextureSRV(std::string textureName, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureSRV);
+	//Loaded on first use and possibly evicted later - ReadyTexture asks the residency for it every time
+	void AddTexture(std::string textureName, TextureResidency* residency, TextureHandle texture);
 	void AddSampler(std::string samplerName, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler);
 	void ReadyTexture();
+	//Uploads the material's own data (the PerMaterial buffer) and binds its textures - each time drawing switches to it
+	void Bind();
 
 private:
-	
+	void ResolveParameters();
+
 
 	//float roughness;
 	SimplePixelShader* pixelShader;
 	SimpleVertexShader* vertexShader;
 	DirectX::XMFLOAT4 colorTint;
+	DrawParameters drawParameters;
+	SimpleShaderParameter colorTintParameter;
 
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> textureSRVs;
+	std::unordered_map<std::string, TextureHandle> residentTextures;
+	TextureResidency* residency;
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11SamplerState>> samplers;
 };
 
@@ -1,260 +1,176 @@
 #include "Mesh.h"
-#include <fstream>
+#include "MeshCache.h"
+#include "MeshCooker.h"
+#include "TangentGenerator.h"
+#include <algorithm>
 #include <vector>
+#include <cstdio>
 #include <DirectXMath.h>
 
 using namespace DirectX;
 
-//Bulk of code created by Professor Cascioli - obj file loading code
-Mesh::Mesh(const char* fileName, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> dContext)
+// Run the index/vertex reordering passes (see MeshOptimizer) when importing
+bool Mesh::OptimizeOnImport = true;
+
+// Default LOD chain: 1/2, 1/4 and 1/8 of the triangles, within 5% of the bounding radius
+LodSettings Mesh::LodsOnImport;
+
+// About a pixel at 1080p
+float Mesh::LodScreenError = 1.0f / 1080.0f;
+
+// Split LOD 0 into meshlets so Entity can cull it a cluster at a time
+bool Mesh::MeshletsOnImport = true;
+
+ID3D11Buffer* Mesh::boundVertexBuffer = nullptr;
+ID3D11Buffer* Mesh::boundIndexBuffer = nullptr;
+DXGI_FORMAT Mesh::boundIndexFormat = DXGI_FORMAT_UNKNOWN;
+GeometryArena* Mesh::boundArena = nullptr;
+UINT Mesh::boundArenaGeneration = 0;
+
+namespace
 {
-	// Author: Chris Cascioli
-	// Purpose: Basic .OBJ 3D model loading, supporting positions, uvs and normals
-	// 
-	// - You are allowed to directly copy/paste this into your code base
-	//   for assignments, given that you clearly cite that this is not
-	//   code of your own design.
-	//
-	// - NOTE: You'll need to #include <fstream>
+	// Largest vertex count 16-bit indices can address
+	const int MaxShortIndexVertices = 65536;
 
+	// How many worst-case (nothing culled) clustered draws fit in a mesh's
+	// culled index buffer before it has to be discarded and started over
+	const UINT CulledIndexRingDraws = 4;
+}
 
-	// File input object
-	std::ifstream obj(fileName);
+Mesh::Mesh(const char* fileName, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> dContext, GeometryArena* arena, AssetPack* pack, bool deferUpload, bool packVertices)
+	: arena(arena), arenaHandle(-1), indexFormat(DXGI_FORMAT_R32_UINT), packVertices(packVertices), vertexStride(sizeof(Vertex)), quantization(), deferUpload(deferUpload), culledIndexCursor(0), culledIndexCapacity(0)
+{
+	meshBufferIndices = 0;
+	boundsMin = XMFLOAT3(0, 0, 0);
+	boundsMax = XMFLOAT3(0, 0, 0);
+
+	//Cooked version next to the source? Upload straight from the mapping - no parsing, no tangent pass
+	std::string cachePath = MeshCache::GetCachePath(fileName);
+	MeshCookSettings settings = GetCookSettings();
+	MeshCache cache;
+
+	//Everything comes out of the pack when the source is in it (the cooked file then has to be too)
+	AssetSpan source, cooked;
+	bool packed = pack && pack->Find(fileName, source);
+	bool cached = packed ?
+		pack->Find(cachePath, cooked) && cache.Open(cooked, source.ContentHash, settings.Flags(), settings.OptionsHash()) :
+		cache.Open(cachePath.c_str(), fileName, settings.Flags(), settings.OptionsHash());
+	if (cached)
+	{
+		boundsMin = cache.GetBoundsMin();
+		boundsMax = cache.GetBoundsMax();
+		lods.assign(cache.GetLods(), cache.GetLods() + cache.GetLodCount());
+		UploadBuffers(cache.GetVertices(), cache.GetVertexCount(), cache.GetIndices(), cache.GetIndexCount(), device, dContext);
+		BuildMeshlets(cache.GetVertices(), cache.GetVertexCount(), cache.GetIndices(), device);
+		return;
+	}
 
-	// Check for successful open
-	if (!obj.is_open())
+	//Missing, stale or corrupt - import from the source and re-cook it (see MeshCooker)
+	CookedMesh mesh;
+	if (!MeshCooker::Cook(fileName, packed ? &source : nullptr, settings, mesh))
 		return;
 
-	// Variables used while reading the file
-	std::vector<XMFLOAT3> positions;	// Positions from the file
-	std::vector<XMFLOAT3> normals;		// Normals from the file
-	std::vector<XMFLOAT2> uvs;		// UVs from the file
-	std::vector<Vertex> verts;		// Verts we're assembling
-	std::vector<UINT> indices;		// Indices of these verts
-	int vertCounter = 0;			// Count of vertices
-	int indexCounter = 0;			// Count of indices
-	char chars[100];			// String for line reading
-
-	// Still have data left?
-	while (obj.good())
-	{
-		// Get the line (100 characters should be more than enough)
-		obj.getline(chars, 100);
+	boundsMin = mesh.BoundsMin;
+	boundsMax = mesh.BoundsMax;
+	lods = mesh.Lods;
 
-		// Check the type of line
-		if (chars[0] == 'v' && chars[1] == 'n')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			XMFLOAT3 norm;
-			sscanf_s(
-				chars,
-				"vn %f %f %f",
-				&norm.x, &norm.y, &norm.z);
-
-			// Add to the list of normals
-			normals.push_back(norm);
-		}
-		else if (chars[0] == 'v' && chars[1] == 't')
-		{
-			// Read the 2 numbers directly into an XMFLOAT2
-			XMFLOAT2 uv;
-			sscanf_s(
-				chars,
-				"vt %f %f",
-				&uv.x, &uv.y);
-
-			// Add to the list of uv's
-			uvs.push_back(uv);
-		}
-		else if (chars[0] == 'v')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			XMFLOAT3 pos;
-			sscanf_s(
-				chars,
-				"v %f %f %f",
-				&pos.x, &pos.y, &pos.z);
-
-			// Add to the positions
-			positions.push_back(pos);
-		}
-		else if (chars[0] == 'f')
-		{
-			// Read the face indices into an array
-			// NOTE: This assumes the given obj file contains
-			//  vertex positions, uv coordinates AND normals.
-			unsigned int i[12];
-			int numbersRead = sscanf_s(
-				chars,
-				"f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
-				&i[0], &i[1], &i[2],
-				&i[3], &i[4], &i[5],
-				&i[6], &i[7], &i[8],
-				&i[9], &i[10], &i[11]);
-
-			// If we only got the first number, chances are the OBJ
-			// file has no UV coordinates.  This isn't great, but we
-			// still want to load the model without crashing, so we
-			// need to re-read a different pattern (in which we assume
-			// there are no UVs denoted for any of the vertices)
-			if (numbersRead == 1)
-			{
-				// Re-read with a different pattern
-				numbersRead = sscanf_s(
-					chars,
-					"f %d//%d %d//%d %d//%d %d//%d",
-					&i[0], &i[2],
-					&i[3], &i[5],
-					&i[6], &i[8],
-					&i[9], &i[11]);
-
-				// The following indices are where the UVs should 
-				// have been, so give them a valid value
-				i[1] = 1;
-				i[4] = 1;
-				i[7] = 1;
-				i[10] = 1;
-
-				// If we have no UVs, create a single UV coordinate
-				// that will be used for all vertices
-				if (uvs.size() == 0)
-					uvs.push_back(DirectX::XMFLOAT2(0, 0));
-			}
-
-			// - Create the verts by looking up
-			//    corresponding data from vectors
-			// - OBJ File indices are 1-based, so
-			//    they need to be adusted
-			Vertex v1;
-			v1.Position = positions[i[0] - 1];
-			v1.UV = uvs[i[1] - 1];
-			v1.Normal = normals[i[2] - 1];
-
-			Vertex v2;
-			v2.Position = positions[i[3] - 1];
-			v2.UV = uvs[i[4] - 1];
-			v2.Normal = normals[i[5] - 1];
-
-			Vertex v3;
-			v3.Position = positions[i[6] - 1];
-			v3.UV = uvs[i[7] - 1];
-			v3.Normal = normals[i[8] - 1];
-
-			// The model is most likely in a right-handed space,
-			// especially if it came from Maya.  We want to convert
-			// to a left-handed space for DirectX.  This means we 
-			// need to:
-			//  - Invert the Z position
-			//  - Invert the normal's Z
-			//  - Flip the winding order
-			// We also need to flip the UV coordinate since DirectX
-			// defines (0,0) as the top left of the texture, and many
-			// 3D modeling packages use the bottom left as (0,0)
-
-			// Flip the UV's since they're probably "upside down"
-			v1.UV.y = 1.0f - v1.UV.y;
-			v2.UV.y = 1.0f - v2.UV.y;
-			v3.UV.y = 1.0f - v3.UV.y;
-
-			// Flip Z (LH vs. RH)
-			v1.Position.z *= -1.0f;
-			v2.Position.z *= -1.0f;
-			v3.Position.z *= -1.0f;
-
-			// Flip normal's Z
-			v1.Normal.z *= -1.0f;
-			v2.Normal.z *= -1.0f;
-			v3.Normal.z *= -1.0f;
-
-			// Add the verts to the vector (flipping the winding order)
-			verts.push_back(v1);
-			verts.push_back(v3);
-			verts.push_back(v2);
-			vertCounter += 3;
-
-			// Add three more indices
-			indices.push_back(indexCounter); indexCounter += 1;
-			indices.push_back(indexCounter); indexCounter += 1;
-			indices.push_back(indexCounter); indexCounter += 1;
-
-			// Was there a 4th face?
-			// - 12 numbers read means 4 faces WITH uv's
-			// - 8 numbers read means 4 faces WITHOUT uv's
-			if (numbersRead == 12 || numbersRead == 8)
-			{
-				// Make the last vertex
-				Vertex v4;
-				v4.Position = positions[i[9] - 1];
-				v4.UV = uvs[i[10] - 1];
-				v4.Normal = normals[i[11] - 1];
-
-				// Flip the UV, Z pos and normal's Z
-				v4.UV.y = 1.0f - v4.UV.y;
-				v4.Position.z *= -1.0f;
-				v4.Normal.z *= -1.0f;
-
-				// Add a whole triangle (flipping the winding order)
-				verts.push_back(v1);
-				verts.push_back(v4);
-				verts.push_back(v3);
-				vertCounter += 3;
-
-				// Add three more indices
-				indices.push_back(indexCounter); indexCounter += 1;
-				indices.push_back(indexCounter); indexCounter += 1;
-				indices.push_back(indexCounter); indexCounter += 1;
-			}
-		}
-	}
+	//Packs are read-only, so only loose sources get re-cooked next to themselves
+	uint64_t sourceHash;
+	if (!packed && MeshCache::HashFile(fileName, sourceHash))
+		MeshCooker::Write(cachePath.c_str(), sourceHash, settings, mesh);
 
-	// Close the file and create the actual buffers
-	obj.close();
-
-	// - At this point, "verts" is a vector of Vertex structs, and can be used
-	//    directly to create a vertex buffer:  &verts[0] is the address of the first vert
-	//
-	// - The vector "indices" is similar. It's a vector of unsigned ints and
-	//    can be used directly for the index buffer: &indices[0] is the address of the first int
-	//
-	// - "vertCounter" is the number of vertices
-	// - "indexCounter" is the number of indices
-	// - Yes, these are effectively the same since OBJs do not index entire vertices!  This means
-	//    an index buffer isn't doing much for us.  We could try to optimize the mesh ourselves
-	//    and detect duplicate vertices, but at that point it would be better to use a more
-	//    sophisticated model loading library like TinyOBJLoader or AssImp (yes, that's its name)
-
-	CreateBuffers(&verts[0], vertCounter, &indices[0], indexCounter, device, dContext);
+	UploadBuffers(&mesh.Vertices[0], (int)mesh.Vertices.size(), &mesh.Indices[0], (int)mesh.Indices.size(), device, dContext);
+	BuildMeshlets(&mesh.Vertices[0], (int)mesh.Vertices.size(), &mesh.Indices[0], device);
+}
+
+MeshCookSettings Mesh::GetCookSettings()
+{
+	MeshCookSettings settings;
+	settings.Optimize = OptimizeOnImport;
+	settings.Lods = LodsOnImport;
+	return settings;
 }
 
-Mesh::Mesh(Vertex* vertices, int verticeNum, unsigned int* indices, int indiceNum, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> dContext)
+Mesh::Mesh(Vertex* vertices, int verticeNum, unsigned int* indices, int indiceNum, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> dContext, GeometryArena* arena)
+	: arena(arena), arenaHandle(-1), indexFormat(DXGI_FORMAT_R32_UINT), packVertices(false), vertexStride(sizeof(Vertex)), quantization(), deferUpload(false), culledIndexCursor(0), culledIndexCapacity(0)
 {
 	CreateBuffers(vertices, verticeNum, indices, indiceNum, device, dContext);
 }
 
 Mesh::~Mesh()
 {
+	if (arenaHandle >= 0)
+		arena->Free(arenaHandle);
 }
 
 Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetVertexBuffer()
 {
-	return vertexBuffer;
+	return arenaHandle >= 0 ? arena->GetVertexBuffer() : vertexBuffer;
 }
 
 Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetIndexBuffer()
 {
-	return indexBuffer;
+	return arenaHandle >= 0 ? arena->GetIndexBuffer() : indexBuffer;
 }
 
 void Mesh::CreateBuffers(Vertex* vertices, int verticeNum, unsigned int* indices, int indiceNum, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> dContext)
 {
 	//Create tangents
-	CalculateTangents(vertices, verticeNum, indices, indiceNum);
+	TangentGenerator::Generate(vertices, verticeNum, indices, indiceNum);
+	CalculateBounds(vertices, verticeNum);
+
+	UploadBuffers(vertices, verticeNum, indices, indiceNum, device, dContext);
+}
+
+//Creates the GPU buffers from final vertex data as-is (already has tangents, e.g. cooked data)
+void Mesh::UploadBuffers(const Vertex* vertices, int verticeNum, const unsigned int* indices, int indiceNum, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> dContext)
+{
+	//Buffers without a LOD chain are just the one level
+	if (lods.empty())
+	{
+		MeshLod all = { 0, (uint32_t)indiceNum, 0.0f };
+		lods.push_back(all);
+	}
+
+	meshBufferIndices = (int)lods[0].IndexCount;
+	deviceContext = dContext;
+
+	//Off the render thread only the CPU side gets built - the arena's copies and
+	//UpdateSubresource go through the immediate context, which isn't thread-safe
+	if (deferUpload)
+	{
+		pendingVertices.assign(vertices, vertices + verticeNum);
+		pendingIndices.assign(indices, indices + indiceNum);
+		pendingDevice = device;
+		return;
+	}
+
+	//20 bytes a vertex instead of 48, scaled back by the vertex shader
+	std::vector<PackedVertex> packed;
+	const void* vertexData = vertices;
+	if (packVertices)
+	{
+		quantization = VertexPacking::Encode<Unorm16VertexFormat>(vertices, verticeNum, packed);
+		vertexData = &packed[0];
+		vertexStride = Unorm16VertexFormat::Stride;
+	}
+
+	//Shared buffers - falls through to separate ones if the arena couldn't take it (or holds another format)
+	if (arena && arena->GetVertexStride() == vertexStride)
+	{
+		arenaHandle = arena->Allocate(vertexData, verticeNum, indices, indiceNum);
+		if (arenaHandle >= 0)
+		{
+			indexFormat = arena->GetRange(arenaHandle).IndexFormat;
+			return;
+		}
+	}
 
 	// Create the VERTEX BUFFER description
 	// Created on the stack because we only need it to create the buffer.  The description is then useless.
 	D3D11_BUFFER_DESC vbd;
 	vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = sizeof(Vertex) * verticeNum;       // * number of vertices in the buffer
+	vbd.ByteWidth = vertexStride * verticeNum;       // * number of vertices in the buffer
 	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER; // Tells DirectX this is a vertex buffer
 	vbd.CPUAccessFlags = 0;
 	vbd.MiscFlags = 0;
@@ -262,16 +178,25 @@ void Mesh::CreateBuffers(Vertex* vertices, int verticeNum, unsigned int* indices
 
 	//'create struct to hold initial vertex data'
 	D3D11_SUBRESOURCE_DATA initVertexData;
-	initVertexData.pSysMem = vertices;
+	initVertexData.pSysMem = vertexData;
 
 	//Create buffer w/ initial data, buffer never changed again
 	device->CreateBuffer(&vbd, &initVertexData, vertexBuffer.GetAddressOf());
 
+	//Half the size when every vertex fits in a 16-bit index
+	std::vector<uint16_t> shortIndices;
+	indexFormat = DXGI_FORMAT_R32_UINT;
+	if (verticeNum <= MaxShortIndexVertices)
+	{
+		shortIndices.assign(indices, indices + indiceNum);
+		indexFormat = DXGI_FORMAT_R16_UINT;
+	}
+
 	// Create the INDEX BUFFER description
 	// Same idea as vertex buffer
 	D3D11_BUFFER_DESC ibd;
 	ibd.Usage = D3D11_USAGE_IMMUTABLE;
-	ibd.ByteWidth = sizeof(unsigned int) * indiceNum;	// * number of indices in the buffer
+	ibd.ByteWidth = (indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(unsigned int)) * indiceNum;	// * number of indices in the buffer
 	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;	// Tells DirectX this is an index buffer
 	ibd.CPUAccessFlags = 0;
 	ibd.MiscFlags = 0;
@@ -279,12 +204,51 @@ void Mesh::CreateBuffers(Vertex* vertices, int verticeNum, unsigned int* indices
 
 	//'create struct to hold initial indice data'
 	D3D11_SUBRESOURCE_DATA initIndexData;
-	initIndexData.pSysMem = indices;
+	initIndexData.pSysMem = indexFormat == DXGI_FORMAT_R16_UINT ? (const void*)&shortIndices[0] : (const void*)indices;
 
 	device->CreateBuffer(&ibd, &initIndexData, indexBuffer.GetAddressOf());
+}
 
-	meshBufferIndices = indiceNum;
-	deviceContext = dContext;
+// --------------------------------------------------------
+// Splits LOD 0 into meshlets (see MeshletBuilder) and makes a
+// dynamic index buffer the survivors get appended to, with
+// room for several draws where all of them survive.  Meshes
+// that come out as a single meshlet are left alone - culling
+// them is the same as culling the whole entity
+// --------------------------------------------------------
+void Mesh::BuildMeshlets(const Vertex* verts, int numVerts, const unsigned int* indices, Microsoft::WRL::ComPtr<ID3D11Device> device)
+{
+	if (!MeshletsOnImport || lods.empty())
+		return;
+
+	MeshletData meshlets;
+	MeshletStats stats;
+	MeshletBuilder::Build(verts, numVerts, indices + lods[0].IndexStart, lods[0].IndexCount, meshlets, &stats);
+
+	#if defined(DEBUG) || defined(_DEBUG)
+		printf("  meshlets: %zu (%.1f vertices, %.1f triangles each, %zu with normal cones), %.2f ms\n",
+			stats.Meshlets, stats.Meshlets ? (double)stats.VertexReferences / stats.Meshlets : 0.0,
+			stats.Meshlets ? (double)stats.Triangles / stats.Meshlets : 0.0, stats.ConeCullable, stats.Seconds * 1000.0);
+	#endif
+
+	if (meshlets.Meshlets.size() <= 1)
+		return;
+
+	culler.Build(meshlets);
+
+	D3D11_BUFFER_DESC ibd;
+	ibd.Usage = D3D11_USAGE_DYNAMIC;
+	culledIndexCursor = 0;
+	culledIndexCapacity = (UINT)culler.GetMaxIndexCount() * CulledIndexRingDraws;
+
+	ibd.ByteWidth = sizeof(unsigned int) * culledIndexCapacity;
+	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	ibd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;	// Appended to by every draw that culls something
+	ibd.MiscFlags = 0;
+	ibd.StructureByteStride = 0;
+
+	if (FAILED(device->CreateBuffer(&ibd, 0, culledIndexBuffer.GetAddressOf())))
+		culler = MeshletCuller();
 }
 
 int Mesh::GetIndexCount()
@@ -292,106 +256,209 @@ int Mesh::GetIndexCount()
 	return meshBufferIndices;
 }
 
+DXGI_FORMAT Mesh::GetIndexFormat()
+{
+	return indexFormat;
+}
+
+int Mesh::GetMeshletCount()
+{
+	return (int)culler.GetMeshletCount();
+}
+
+ClusterCullStats Mesh::GetClusterStats()
+{
+	return clusterStats;
+}
+
+int Mesh::GetLodCount()
+{
+	return (int)lods.size();
+}
+
+int Mesh::GetLodIndexCount(int lod)
+{
+	return lod >= 0 && lod < (int)lods.size() ? (int)lods[lod].IndexCount : 0;
+}
+
+// --------------------------------------------------------
+// Coarsest LOD whose error stays under LodScreenError once
+// projected to the screen
+//
+// screenSize - Height of the mesh's bounding sphere as a fraction
+//              of the screen's height (see Camera::GetScreenSize)
+// --------------------------------------------------------
+int Mesh::SelectLod(float screenSize)
+{
+	//LOD errors are relative to the bounding radius, screenSize is the diameter
+	for (int i = (int)lods.size() - 1; i > 0; i--)
+	{
+		if (lods[i].Error * screenSize * 0.5f <= LodScreenError)
+			return i;
+	}
+	return 0;
+}
+
+DirectX::XMFLOAT3 Mesh::GetBoundsMin()
+{
+	return boundsMin;
+}
+
+DirectX::XMFLOAT3 Mesh::GetBoundsMax()
+{
+	return boundsMax;
+}
+
+bool Mesh::HasPackedVertices()
+{
+	return packVertices;
+}
+
+VertexQuantization Mesh::GetQuantization()
+{
+	return quantization;
+}
+
+void Mesh::CalculateBounds(const Vertex* verts, int numVerts)
+{
+	MeshCooker::CalculateBounds(verts, numVerts, boundsMin, boundsMax);
+}
+
 void Mesh::Draw()
 {
-	UINT stride = sizeof(Vertex);
-	UINT offset = 0;
+	Draw(0);
+}
 
-	deviceContext->IASetVertexBuffers(0, 1, vertexBuffer.GetAddressOf(), &stride, &offset);
-	deviceContext->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+bool Mesh::IsUploadPending()
+{
+	return !pendingIndices.empty();
+}
+
+void Mesh::FinishUpload()
+{
+	if (!IsUploadPending())
+		return;
+
+	deferUpload = false;
+	UploadBuffers(&pendingVertices[0], (int)pendingVertices.size(), &pendingIndices[0], (int)pendingIndices.size(), pendingDevice, deviceContext);
+
+	//Swapping frees the memory, clear() wouldn't
+	std::vector<Vertex>().swap(pendingVertices);
+	std::vector<unsigned int>().swap(pendingIndices);
+	pendingDevice.Reset();
+}
+
+void Mesh::Draw(int lod)
+{
+	if (lods.empty() || IsUploadPending())
+		return;
+	if (lod < 0) lod = 0;
+	if (lod >= (int)lods.size()) lod = (int)lods.size() - 1;
+
+	//In an arena the mesh is a range of the shared buffers
+	UINT startIndex = 0;
+	INT baseVertex = 0;
+	if (arenaHandle >= 0)
+	{
+		GeometryRange range = arena->GetRange(arenaHandle);
+		BindBuffers(arena->GetVertexBuffer().Get(), arena->GetIndexBuffer().Get(), range.IndexFormat);
+		startIndex = range.StartIndex;
+		baseVertex = (INT)range.BaseVertex;
+	}
+	else
+	{
+		BindBuffers(vertexBuffer.Get(), indexBuffer.Get(), indexFormat);
+	}
 
 	deviceContext->DrawIndexed(
-		GetIndexCount(),		// The number of indices to use (we could draw a subset if we wanted)
-		0,						// Offset to the first index we want to use
-		0);						// Offset to add to each index when looking up vertices
+		lods[lod].IndexCount,				// The number of indices to use (just this LOD's range)
+		startIndex + lods[lod].IndexStart,	// Offset to the first index we want to use
+		baseVertex);						// Offset to add to each index when looking up vertices
+}
+
+void Mesh::ResetBindings()
+{
+	boundVertexBuffer = nullptr;
+	boundIndexBuffer = nullptr;
+	boundIndexFormat = DXGI_FORMAT_UNKNOWN;
+}
+
+//Only touches the input assembler when the buffers differ from the last mesh drawn
+void Mesh::BindBuffers(ID3D11Buffer* vb, ID3D11Buffer* ib, DXGI_FORMAT format)
+{
+	//A grown or defragmented arena has new buffers, possibly at an old one's address.
+	//Generations are per arena, so switching arenas counts as a change too
+	if (arena && (arena != boundArena || arena->GetGeneration() != boundArenaGeneration))
+	{
+		ResetBindings();
+		boundArena = arena;
+		boundArenaGeneration = arena->GetGeneration();
+	}
+
+	if (vb != boundVertexBuffer)
+	{
+		UINT stride = vertexStride;
+		UINT offset = 0;
+		deviceContext->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
+		boundVertexBuffer = vb;
+	}
+
+	if (ib != boundIndexBuffer || format != boundIndexFormat)
+	{
+		deviceContext->IASetIndexBuffer(ib, format, 0);
+		boundIndexBuffer = ib;
+		boundIndexFormat = format;
+	}
 }
 
 // --------------------------------------------------------
-// Author: Chris Cascioli
-// Purpose: Calculates the tangents of the vertices in a mesh
-// 
-// - You are allowed to directly copy/paste this into your code base
-//   for assignments, given that you clearly cite that this is not
-//   code of your own design.
-//
-// - Code originally adapted from: http://www.terathon.com/code/tangent.html
-//   - Updated version now found here: http://foundationsofgameenginedev.com/FGED2-sample.pdf
-//   - See listing 7.4 in section 7.5 (page 9 of the PDF)
-//
-// - Note: For this code to work, your Vertex format must
-//         contain an XMFLOAT3 called Tangent
+// Culls LOD 0's meshlets and draws the survivors
 //
-// - Be sure to call this BEFORE creating your D3D vertex/index buffers
+// - Nothing culled: the mesh's own LOD 0 is drawn, with no
+//   index writes at all
+// - Otherwise the survivors' triangles are appended to the
+//   culled index buffer with NO_OVERWRITE, so earlier draws
+//   that still read it aren't disturbed.  Only when it's full
+//   does a DISCARD hand it back to the driver to rename
 // --------------------------------------------------------
-void Mesh::CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices)
+void Mesh::DrawClusters(const ClusterCullView& view)
 {
-	// Reset tangents
-	for (int i = 0; i < numVerts; i++)
+	if (IsUploadPending())
+		return;
+	if (culler.GetMeshletCount() == 0)
 	{
-		verts[i].Tangent = XMFLOAT3(0, 0, 0);
+		Draw(0);
+		return;
 	}
 
-	// Calculate tangents one whole triangle at a time
-	for (int i = 0; i < numIndices;)
+	size_t indexCount = culler.Cull(view, visibleMeshlets, &clusterStats);
+	if (indexCount == 0)
+		return;
+	if (visibleMeshlets.size() == culler.GetMeshletCount())
 	{
-		// Grab indices and vertices of first triangle
-		unsigned int i1 = indices[i++];
-		unsigned int i2 = indices[i++];
-		unsigned int i3 = indices[i++];
-		Vertex* v1 = &verts[i1];
-		Vertex* v2 = &verts[i2];
-		Vertex* v3 = &verts[i3];
-
-		// Calculate vectors relative to triangle positions
-		float x1 = v2->Position.x - v1->Position.x;
-		float y1 = v2->Position.y - v1->Position.y;
-		float z1 = v2->Position.z - v1->Position.z;
-
-		float x2 = v3->Position.x - v1->Position.x;
-		float y2 = v3->Position.y - v1->Position.y;
-		float z2 = v3->Position.z - v1->Position.z;
-
-		// Do the same for vectors relative to triangle uv's
-		float s1 = v2->UV.x - v1->UV.x;
-		float t1 = v2->UV.y - v1->UV.y;
-
-		float s2 = v3->UV.x - v1->UV.x;
-		float t2 = v3->UV.y - v1->UV.y;
-
-		// Create vectors for tangent calculation
-		float r = 1.0f / (s1 * t2 - s2 * t1);
-
-		float tx = (t2 * x1 - t1 * x2) * r;
-		float ty = (t2 * y1 - t1 * y2) * r;
-		float tz = (t2 * z1 - t1 * z2) * r;
-
-		// Adjust tangents of each vert of the triangle
-		v1->Tangent.x += tx;
-		v1->Tangent.y += ty;
-		v1->Tangent.z += tz;
-
-		v2->Tangent.x += tx;
-		v2->Tangent.y += ty;
-		v2->Tangent.z += tz;
-
-		v3->Tangent.x += tx;
-		v3->Tangent.y += ty;
-		v3->Tangent.z += tz;
+		Draw(0);
+		return;
 	}
 
-	// Ensure all of the tangents are orthogonal to the normals
-	for (int i = 0; i < numVerts; i++)
+	D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+	if (culledIndexCursor + indexCount > culledIndexCapacity)
 	{
-		// Grab the two vectors
-		XMVECTOR normal = XMLoadFloat3(&verts[i].Normal);
-		XMVECTOR tangent = XMLoadFloat3(&verts[i].Tangent);
-
-		// Use Gram-Schmidt orthonormalize to ensure
-		// the normal and tangent are exactly 90 degrees apart
-		tangent = XMVector3Normalize(
-			tangent - normal * XMVector3Dot(normal, tangent));
+		mapType = D3D11_MAP_WRITE_DISCARD;
+		culledIndexCursor = 0;
+	}
 
-		// Store the tangent
-		XMStoreFloat3(&verts[i].Tangent, tangent);
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	if (FAILED(deviceContext->Map(culledIndexBuffer.Get(), 0, mapType, 0, &mapped)))
+	{
+		Draw(0);
+		return;
 	}
+	culler.WriteIndices(visibleMeshlets, (unsigned int*)mapped.pData + culledIndexCursor);
+	deviceContext->Unmap(culledIndexBuffer.Get(), 0);
+
+	//Culled indices are always 32-bit and relative to the mesh, like the originals
+	INT baseVertex = arenaHandle >= 0 ? (INT)arena->GetRange(arenaHandle).BaseVertex : 0;
+	BindBuffers(GetVertexBuffer().Get(), culledIndexBuffer.Get(), DXGI_FORMAT_R32_UINT);
+	deviceContext->DrawIndexed((UINT)indexCount, culledIndexCursor, baseVertex);
+	culledIndexCursor += (UINT)indexCount;
 }
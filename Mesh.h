@@ -1,7 +1,15 @@
 #pragma once
 #include <d3d11.h>
 #include <wrl/client.h>
+#include <DirectXMath.h>
+#include <vector>
 #include "Vertex.h"
+#include "VertexFormats.h"
+#include "MeshSimplifier.h"
+#include "MeshletCuller.h"
+#include "GeometryArena.h"
+#include "AssetPack.h"
+#include "MeshCooker.h"
 
 // For the DirectX Math library
 //using namespace DirectX;
@@ -9,25 +17,111 @@
 class Mesh
 {
 public:	//Scopes are declared in block form rather than per item
-	Mesh(Vertex *vertices, int verticeNum, unsigned int *indices, int indiceNum, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> dContext);	//Constructor
-	Mesh(const char* fileName, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> dContext); //3D object constructor
+	//Passing an arena puts the geometry in its shared buffers instead of the mesh's own
+	Mesh(Vertex *vertices, int verticeNum, unsigned int *indices, int indiceNum, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> dContext, GeometryArena* arena = nullptr);	//Constructor
+	//Files in the pack (if given) are read from it instead of from disk.  Deferring the upload
+	//keeps the geometry on the CPU until FinishUpload(), so the file can be loaded off the render thread.
+	//Packed vertices go up as 20 byte Unorm16VertexFormat ones - the arena has to be made for those
+	Mesh(const char* fileName, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> dContext, GeometryArena* arena = nullptr, AssetPack* pack = nullptr, bool deferUpload = false, bool packVertices = false); //3D object constructor
 	~Mesh(); //Deconstructor
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
 	void CreateBuffers(Vertex* vertices, int verticeNum, unsigned int* indices, int indiceNum, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> dContext);
 	int GetIndexCount();
+	DXGI_FORMAT GetIndexFormat();
+	int GetLodCount();
+	int GetLodIndexCount(int lod);
+	int SelectLod(float screenSize);
+	DirectX::XMFLOAT3 GetBoundsMin();
+	DirectX::XMFLOAT3 GetBoundsMax();
+
+	//Packed meshes need a vertex shader that takes PackedVertexShaderInput, with the
+	//quantization in its PerMesh buffer (see Entity::SetDrawParameters)
+	bool HasPackedVertices();
+	VertexQuantization GetQuantization();
+	int GetMeshletCount();
+	ClusterCullStats GetClusterStats();
 	void Draw();
+	void Draw(int lod);
+
+	//A deferred mesh draws nothing until its data is in the arena/GPU buffers.  FinishUpload
+	//goes through the immediate context, so it's for the render thread only
+	bool IsUploadPending();
+	void FinishUpload();
+
+	//Draws only the meshlets of LOD 0 that survive culling against the view (see MeshletCuller)
+	void DrawClusters(const ClusterCullView& view);
+
+	// Whether imported files go through MeshOptimizer before being cooked/uploaded
+	static bool OptimizeOnImport;
+
+	// LOD chain built for imported files (no target ratios = LOD 0 only)
+	static LodSettings LodsOnImport;
+
+	// Largest LOD error allowed on screen, as a fraction of the screen's height
+	static float LodScreenError;
+
+	// Whether imported files are split into meshlets for per-cluster culling
+	static bool MeshletsOnImport;
+
+	// Forget which buffers are bound (call once something other than a Mesh has set them)
+	static void ResetBindings();
 
 private:
 	// Buffers to hold actual geometry data
 	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
 	
+	//Shared buffers this mesh lives in (arenaHandle -1 = uses its own buffers above)
+	GeometryArena* arena;
+	int arenaHandle;
+
+	//R16_UINT when there are few enough vertices
+	DXGI_FORMAT indexFormat;
+
+	//What the vertex buffer holds - Vertex, or PackedVertex scaled by quantization
+	bool packVertices;
+	UINT vertexStride;
+	VertexQuantization quantization;
+
 	//DeviceContext object for draw commands
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext;
 
-	//Method not created by me (see above method definition in .cpp file for details)
-	void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices);
+	//What's currently bound to the input assembler, so draws can skip rebinding it
+	static ID3D11Buffer* boundVertexBuffer;
+	static ID3D11Buffer* boundIndexBuffer;
+	static DXGI_FORMAT boundIndexFormat;
+	static GeometryArena* boundArena;
+	static UINT boundArenaGeneration;
+
+	//Geometry waiting for FinishUpload (empty once uploaded)
+	bool deferUpload;
+	std::vector<Vertex> pendingVertices;
+	std::vector<unsigned int> pendingIndices;
+	Microsoft::WRL::ComPtr<ID3D11Device> pendingDevice;
+
+	//Local space bounds of the vertices
+	DirectX::XMFLOAT3 boundsMin;
+	DirectX::XMFLOAT3 boundsMax;
+
+	//Index ranges of each level of detail, LOD 0 first
+	std::vector<MeshLod> lods;
+
+	//LOD 0's meshlets and the ring of indices the survivors get appended to (see DrawClusters)
+	MeshletCuller culler;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> culledIndexBuffer;
+	UINT culledIndexCursor;
+	UINT culledIndexCapacity;
+	std::vector<uint32_t> visibleMeshlets;
+	ClusterCullStats clusterStats;
+
+	void CalculateBounds(const Vertex* verts, int numVerts);
+
+	//Import options above as MeshCooker takes them, and raw GPU upload, used by the file constructor
+	static MeshCookSettings GetCookSettings();
+	void BindBuffers(ID3D11Buffer* vb, ID3D11Buffer* ib, DXGI_FORMAT format);
+	void BuildMeshlets(const Vertex* verts, int numVerts, const unsigned int* indices, Microsoft::WRL::ComPtr<ID3D11Device> device);
+	void UploadBuffers(const Vertex* vertices, int verticeNum, const unsigned int* indices, int indiceNum, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> dContext);
 
 	int meshBufferIndices;
 };
@@ -0,0 +1,69 @@
+// --------------------------------------------------------
+// Command line front end for the mesh pipeline's benchmarks
+//
+// Not part of the game project (it has its own main) - build it
+// on its own, e.g. headless on Linux:
+//
+//   g++ -std=c++14 -O2 -pthread -I<DirectXMath headers> -o MeshBenchmark
+//       MeshBenchmarkMain.cpp MappedFile.cpp ObjImporter.cpp MeshCooker.cpp
+//       MeshCache.cpp MeshOptimizer.cpp MeshSimplifier.cpp
+//       TangentGenerator.cpp VertexWelder.cpp AssetPack.cpp Lz4.cpp
+//
+// Usage:
+//   MeshBenchmark import <file.obj> [iterations]
+//   MeshBenchmark simplify <file.obj> [iterations]
+// --------------------------------------------------------
+#include "MeshCooker.h"
+#include "ObjImporter.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	void PrintUsage()
+	{
+		printf("Usage: MeshBenchmark <benchmark> <file.obj> [iterations]\n");
+		printf("  import     ObjImporter against the old getline/sscanf loader (default 10 iterations)\n");
+		printf("  simplify   MeshSimplifier's LOD chain on the cooked mesh, default settings (default 5 iterations)\n");
+	}
+
+	// Cooks the mesh the way Mesh does, minus the LODs, and times building them
+	bool BenchmarkSimplify(const char* fileName, int iterations)
+	{
+		MeshCookSettings settings;
+		settings.Lods.TargetRatios.clear();
+
+		CookedMesh mesh;
+		if (!MeshCooker::Cook(fileName, nullptr, settings, mesh))
+		{
+			printf("MeshBenchmark - couldn't load '%s'\n", fileName);
+			return false;
+		}
+
+		MeshSimplifier::Benchmark(fileName, mesh.Vertices, mesh.Indices, LodSettings(), iterations);
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	const char* benchmark = argv[1];
+	const char* fileName = argv[2];
+	int iterations = argc > 3 ? atoi(argv[3]) : 0;
+
+	if (strcmp(benchmark, "import") == 0)
+		return ObjImporter::Benchmark(fileName, iterations > 0 ? iterations : 10) ? 0 : 1;
+	if (strcmp(benchmark, "simplify") == 0)
+		return BenchmarkSimplify(fileName, iterations > 0 ? iterations : 5) ? 0 : 1;
+
+	PrintUsage();
+	return 2;
+}
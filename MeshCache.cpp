@@ -0,0 +1,271 @@
+#include "MeshCache.h"
+#include "Hash.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace DirectX;
+
+namespace
+{
+	const char MeshCacheMagic[4] = { 'M', 'E', 'S', 'H' };
+
+	inline uint32_t AlignUp(uint32_t value, uint32_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+MeshCache::MeshCache() :
+	header(nullptr), vertices(nullptr), indices(nullptr), lods(nullptr)
+{
+}
+
+MeshCache::~MeshCache()
+{
+	Close();
+}
+
+// --------------------------------------------------------
+// Maps a cooked mesh and checks that it's usable
+//
+// cacheFile - The cooked file
+// sourceFile - The file it was cooked from.  If the source
+//              can't be opened (e.g. only cooked data was
+//              shipped) the cache is trusted as-is
+// flags - MESH_CACHE_FLAG_* the caller expects
+// optionsHash - Hash of any other settings the caller cooks with
+//
+// Returns false if the cache is missing, stale or corrupt
+// --------------------------------------------------------
+bool MeshCache::Open(const char* cacheFile, const char* sourceFile, uint32_t flags, uint64_t optionsHash)
+{
+	Close();
+
+	if (!file.Open(cacheFile))
+	{
+		Close();
+		return false;
+	}
+
+	uint64_t sourceHash;
+	bool hasSource = sourceFile && HashFile(sourceFile, sourceHash);
+	return Attach(file.GetData(), file.GetSize(), hasSource ? &sourceHash : nullptr, flags, optionsHash);
+}
+
+// --------------------------------------------------------
+// Same checks for a cooked mesh that's already in memory (e.g.
+// a span out of an AssetPack, which has to outlive this cache)
+//
+// sourceHash - Content hash of the source it should have been
+//              cooked from (AssetSpan::ContentHash of the .obj)
+// --------------------------------------------------------
+bool MeshCache::Open(const AssetSpan& cooked, uint64_t sourceHash, uint32_t flags, uint64_t optionsHash)
+{
+	Close();
+	return Attach(cooked.Data, cooked.Size, &sourceHash, flags, optionsHash);
+}
+
+bool MeshCache::Attach(const unsigned char* data, size_t size, const uint64_t* sourceHash, uint32_t flags, uint64_t optionsHash)
+{
+	if (!data || size < sizeof(MeshCacheHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const MeshCacheHeader* h = (const MeshCacheHeader*)data;
+
+	//Wrong kind of file, written by a different version/Vertex layout, or cooked with other options
+	if (memcmp(h->Magic, MeshCacheMagic, 4) != 0 ||
+		h->Version != MESH_CACHE_VERSION ||
+		h->VertexStride != sizeof(Vertex) ||
+		h->Flags != flags ||
+		h->OptionsHash != optionsHash)
+	{
+		Close();
+		return false;
+	}
+
+	//Sections have to fit in the file (checked in 64 bits so huge counts can't wrap)
+	uint64_t vertexBytes = (uint64_t)h->VertexCount * sizeof(Vertex);
+	uint64_t indexBytes = (uint64_t)h->IndexCount * sizeof(unsigned int);
+	uint64_t lodBytes = (uint64_t)h->LodCount * sizeof(MeshLod);
+	if (h->VertexOffset % 16 != 0 || h->IndexOffset % 4 != 0 || h->LodOffset % 4 != 0 ||
+		h->VertexOffset < sizeof(MeshCacheHeader) ||
+		h->VertexOffset + vertexBytes > h->IndexOffset ||
+		h->IndexOffset + indexBytes > h->LodOffset ||
+		h->LodOffset + lodBytes != size)
+	{
+		Close();
+		return false;
+	}
+
+	//Catch truncated/damaged payloads
+	uint64_t payloadHash = HashBytes(data + h->VertexOffset, (size_t)(size - h->VertexOffset));
+	if (payloadHash != h->PayloadHash)
+	{
+		Close();
+		return false;
+	}
+
+	//Source changed since this was cooked?
+	if (sourceHash && *sourceHash != h->SourceHash)
+	{
+		Close();
+		return false;
+	}
+
+	//Every index has to be a real vertex
+	const unsigned int* idx = (const unsigned int*)(data + h->IndexOffset);
+	for (uint32_t i = 0; i < h->IndexCount; i++)
+	{
+		if (idx[i] >= h->VertexCount)
+		{
+			Close();
+			return false;
+		}
+	}
+
+	//Every LOD has to be a whole number of triangles inside the index buffer
+	const MeshLod* lod = (const MeshLod*)(data + h->LodOffset);
+	for (uint32_t i = 0; i < h->LodCount; i++)
+	{
+		if (lod[i].IndexCount % 3 != 0 || (uint64_t)lod[i].IndexStart + lod[i].IndexCount > h->IndexCount)
+		{
+			Close();
+			return false;
+		}
+	}
+
+	header = h;
+	vertices = (const Vertex*)(data + h->VertexOffset);
+	indices = idx;
+	lods = lod;
+	return true;
+}
+
+void MeshCache::Close()
+{
+	file.Close();
+	header = nullptr;
+	vertices = nullptr;
+	indices = nullptr;
+	lods = nullptr;
+}
+
+const Vertex* MeshCache::GetVertices()
+{
+	return vertices;
+}
+
+const unsigned int* MeshCache::GetIndices()
+{
+	return indices;
+}
+
+int MeshCache::GetVertexCount()
+{
+	return header ? (int)header->VertexCount : 0;
+}
+
+int MeshCache::GetIndexCount()
+{
+	return header ? (int)header->IndexCount : 0;
+}
+
+const MeshLod* MeshCache::GetLods()
+{
+	return lods;
+}
+
+int MeshCache::GetLodCount()
+{
+	return header ? (int)header->LodCount : 0;
+}
+
+XMFLOAT3 MeshCache::GetBoundsMin()
+{
+	return header ? header->BoundsMin : XMFLOAT3(0, 0, 0);
+}
+
+XMFLOAT3 MeshCache::GetBoundsMax()
+{
+	return header ? header->BoundsMax : XMFLOAT3(0, 0, 0);
+}
+
+// --------------------------------------------------------
+// Where the cooked version of a source file lives
+// --------------------------------------------------------
+std::string MeshCache::GetCachePath(const char* sourceFile)
+{
+	return std::string(sourceFile) + ".mesh";
+}
+
+// --------------------------------------------------------
+// Hashes a file's contents - returns false if it can't be opened
+// --------------------------------------------------------
+bool MeshCache::HashFile(const char* fileName, uint64_t& hash)
+{
+	MappedFile source(fileName);
+	if (!source.IsOpen())
+		return false;
+
+	hash = HashBytes(source.GetData(), source.GetSize());
+	return true;
+}
+
+// --------------------------------------------------------
+// Writes a cooked mesh
+//
+// Written to a temporary file first and then renamed over the
+// old one, so a crash mid-write can't leave a half-written cache
+// --------------------------------------------------------
+bool MeshCache::Write(const char* cacheFile, uint64_t sourceHash, uint32_t flags, uint64_t optionsHash, const std::vector<Vertex>& verts, const std::vector<unsigned int>& inds, const std::vector<MeshLod>& lods, XMFLOAT3 boundsMin, XMFLOAT3 boundsMax)
+{
+	MeshCacheHeader h = {};
+	memcpy(h.Magic, MeshCacheMagic, 4);
+	h.Version = MESH_CACHE_VERSION;
+	h.VertexStride = sizeof(Vertex);
+	h.Flags = flags;
+	h.OptionsHash = optionsHash;
+	h.VertexCount = (uint32_t)verts.size();
+	h.IndexCount = (uint32_t)inds.size();
+	h.VertexOffset = AlignUp(sizeof(MeshCacheHeader), 16);
+	h.IndexOffset = AlignUp(h.VertexOffset + h.VertexCount * (uint32_t)sizeof(Vertex), 16);
+	h.LodCount = (uint32_t)lods.size();
+	h.LodOffset = h.IndexOffset + h.IndexCount * (uint32_t)sizeof(unsigned int);
+	h.SourceHash = sourceHash;
+	h.BoundsMin = boundsMin;
+	h.BoundsMax = boundsMax;
+
+	//Build the whole file in memory so the payload hash covers exactly what's written
+	std::vector<unsigned char> bytes(h.LodOffset + h.LodCount * sizeof(MeshLod), 0);
+	if (!verts.empty()) memcpy(&bytes[h.VertexOffset], verts.data(), verts.size() * sizeof(Vertex));
+	if (!inds.empty()) memcpy(&bytes[h.IndexOffset], inds.data(), inds.size() * sizeof(unsigned int));
+	if (!lods.empty()) memcpy(&bytes[h.LodOffset], lods.data(), lods.size() * sizeof(MeshLod));
+	h.PayloadHash = HashBytes(&bytes[h.VertexOffset], bytes.size() - h.VertexOffset);
+	memcpy(&bytes[0], &h, sizeof(h));
+
+	std::string tempFile = std::string(cacheFile) + ".tmp";
+	{
+		std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+			return false;
+
+		out.write((const char*)bytes.data(), bytes.size());
+		if (!out.good())
+			return false;
+	}
+
+	//rename() won't replace an existing file on Windows
+	remove(cacheFile);
+	if (rename(tempFile.c_str(), cacheFile) != 0)
+	{
+		remove(tempFile.c_str());
+		return false;
+	}
+
+	return true;
+}
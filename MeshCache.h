@@ -0,0 +1,92 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+#include "Vertex.h"
+
+// Bump whenever the layout below, Vertex, or the import pipeline changes
+#define MESH_CACHE_VERSION 3
+
+// Which optional import steps were applied (MeshCacheHeader::Flags)
+#define MESH_CACHE_FLAG_OPTIMIZED	0x1
+
+// --------------------------------------------------------
+// Header at the start of a cooked mesh file
+//
+// File layout:
+//   MeshCacheHeader
+//   Vertex[VertexCount]			(at VertexOffset, 16-byte aligned)
+//   unsigned int[IndexCount]		(at IndexOffset, every LOD back to back)
+//   MeshLod[LodCount]			(at LodOffset)
+// --------------------------------------------------------
+struct MeshCacheHeader
+{
+	char Magic[4];				// "MESH"
+	uint32_t Version;			// MESH_CACHE_VERSION
+	uint32_t VertexStride;		// sizeof(Vertex) when written
+	uint32_t VertexCount;
+	uint32_t IndexCount;
+	uint32_t VertexOffset;
+	uint32_t IndexOffset;
+	uint32_t Flags;				// MESH_CACHE_FLAG_*
+	uint32_t LodCount;
+	uint32_t LodOffset;
+	uint64_t OptionsHash;		// Hash of other import settings (e.g. LodSettings::Hash)
+	uint64_t SourceHash;		// Hash of the source file's bytes
+	uint64_t PayloadHash;		// Hash of the vertex + index data, to catch corruption
+	DirectX::XMFLOAT3 BoundsMin;
+	DirectX::XMFLOAT3 BoundsMax;
+};
+
+// --------------------------------------------------------
+// A cooked, ready-to-upload mesh that lives next to its
+// source file (e.g. cube.obj -> cube.obj.mesh)
+//
+// - Open() memory maps the file and validates it; the vertex
+//   and index pointers point straight into the mapping
+// - Anything stale (source changed, old version) or damaged
+//   fails validation, so the caller just re-cooks it
+// --------------------------------------------------------
+class MeshCache
+{
+public:
+	MeshCache();
+	~MeshCache();
+
+	// Maps and validates a cooked file - sourceFile is hashed to check for staleness,
+	// and the file has to have been cooked with exactly the given flags and options
+	bool Open(const char* cacheFile, const char* sourceFile, uint32_t flags = 0, uint64_t optionsHash = 0);
+
+	// A cooked mesh inside a pack (pointers go straight into the span)
+	bool Open(const AssetSpan& cooked, uint64_t sourceHash, uint32_t flags = 0, uint64_t optionsHash = 0);
+	void Close();
+
+	const Vertex* GetVertices();
+	const unsigned int* GetIndices();
+	int GetVertexCount();
+	int GetIndexCount();
+	const MeshLod* GetLods();
+	int GetLodCount();
+	DirectX::XMFLOAT3 GetBoundsMin();
+	DirectX::XMFLOAT3 GetBoundsMax();
+
+	// Helpers for cooking
+	static std::string GetCachePath(const char* sourceFile);
+	static bool HashFile(const char* fileName, uint64_t& hash);
+	static bool Write(const char* cacheFile, uint64_t sourceHash, uint32_t flags, uint64_t optionsHash, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<MeshLod>& lods, DirectX::XMFLOAT3 boundsMin, DirectX::XMFLOAT3 boundsMax);
+
+private:
+	MappedFile file;		//Only open when the cache came from its own file
+	const MeshCacheHeader* header;
+	const Vertex* vertices;
+	const unsigned int* indices;
+	const MeshLod* lods;
+
+	// Validates cooked bytes and points the getters into them (sourceHash null = don't check staleness)
+	bool Attach(const unsigned char* data, size_t size, const uint64_t* sourceHash, uint32_t flags, uint64_t optionsHash);
+};
@@ -0,0 +1,215 @@
+#include "MeshCooker.h"
+#include "MeshOptimizer.h"
+#include "ObjImporter.h"
+#include "TangentGenerator.h"
+#include "VertexWelder.h"
+#include <algorithm>
+#include <cstdio>
+
+using namespace DirectX;
+
+uint32_t MeshCookSettings::Flags() const
+{
+	return Optimize ? MESH_CACHE_FLAG_OPTIMIZED : 0;
+}
+
+uint64_t MeshCookSettings::OptionsHash() const
+{
+	return Lods.Hash();
+}
+
+// --------------------------------------------------------
+// OBJ to final vertices: parse + weld, GPU reordering,
+// tangents, bounds and the LOD chain
+//
+// fileName - The OBJ (also used in log output)
+// source - Its bytes if they're already in memory (nullptr = read fileName)
+// --------------------------------------------------------
+bool MeshCooker::Cook(const char* fileName, const AssetSpan* source, const MeshCookSettings& settings, CookedMesh& out)
+{
+	out = CookedMesh();
+	if (!LoadObj(fileName, source, out.Vertices, out.Indices))
+		return false;
+
+	if (settings.Optimize)
+		OptimizeForGPU(out.Vertices, out.Indices);
+
+	TangentGenerator::Generate(out.Vertices, out.Indices);
+	CalculateBounds(&out.Vertices[0], (int)out.Vertices.size(), out.BoundsMin, out.BoundsMax);
+
+	BuildLodChain(out.Vertices, out.Indices, out.Lods, settings);
+	return true;
+}
+
+bool MeshCooker::Write(const char* cacheFile, uint64_t sourceHash, const MeshCookSettings& settings, const CookedMesh& mesh)
+{
+	return MeshCache::Write(cacheFile, sourceHash, settings.Flags(), settings.OptionsHash(), mesh.Vertices, mesh.Indices, mesh.Lods, mesh.BoundsMin, mesh.BoundsMax);
+}
+
+//Local-space axis aligned box around every vertex
+void MeshCooker::CalculateBounds(const Vertex* verts, int numVerts, XMFLOAT3& boundsMin, XMFLOAT3& boundsMax)
+{
+	if (numVerts <= 0)
+	{
+		boundsMin = XMFLOAT3(0, 0, 0);
+		boundsMax = XMFLOAT3(0, 0, 0);
+		return;
+	}
+
+	XMVECTOR minV = XMLoadFloat3(&verts[0].Position);
+	XMVECTOR maxV = minV;
+	for (int i = 1; i < numVerts; i++)
+	{
+		XMVECTOR p = XMLoadFloat3(&verts[i].Position);
+		minV = XMVectorMin(minV, p);
+		maxV = XMVectorMax(maxV, p);
+	}
+
+	XMStoreFloat3(&boundsMin, minV);
+	XMStoreFloat3(&boundsMax, maxV);
+}
+
+//Vertex assembly + handedness conversion originally by Professor Cascioli - file parsing now done by ObjImporter
+bool MeshCooker::LoadObj(const char* fileName, const AssetSpan* source, std::vector<Vertex>& outVerts, std::vector<unsigned int>& outIndices)
+{
+	// Author: Chris Cascioli
+	// Purpose: Basic .OBJ 3D model loading, supporting positions, uvs and normals
+	// 
+	// - You are allowed to directly copy/paste this into your code base
+	//   for assignments, given that you clearly cite that this is not
+	//   code of your own design.
+
+	//Parse the whole file (memory mapped + multithreaded, see ObjImporter) - or straight from the pack
+	ObjData obj;
+	ObjImportStats importStats;
+	bool parsed = source ?
+		ObjImporter::Parse((const char*)source->Data, source->Size, obj, &importStats) :
+		ObjImporter::Load(fileName, obj, &importStats);
+	if (!parsed || obj.Corners.empty())
+		return false;
+
+	#if defined(DEBUG) || defined(_DEBUG)
+		printf("Loaded %s: %zu triangles, %.2f ms (%.1f MB/s, %u threads)\n",
+			fileName, obj.Corners.size() / 3, importStats.Seconds * 1000.0, importStats.MegabytesPerSecond(), importStats.Workers);
+	#endif
+
+	std::vector<Vertex> verts;		// Verts we're assembling
+	verts.reserve(obj.Corners.size());
+
+	for (size_t t = 0; t + 2 < obj.Corners.size(); t += 3)
+	{
+		// - Create the verts by looking up
+		//    corresponding data from vectors
+		// - Indices from the importer are already zero-based
+		Vertex v[3];
+		for (int c = 0; c < 3; c++)
+		{
+			const ObjIndex& corner = obj.Corners[t + c];
+			v[c].Position = obj.Positions[corner.Position];
+
+			// If the file has no UVs, a single (0,0) coordinate
+			// is used for all vertices
+			v[c].UV = corner.UV >= 0 ? obj.UVs[corner.UV] : XMFLOAT2(0, 0);
+			v[c].Normal = corner.Normal >= 0 ? obj.Normals[corner.Normal] : XMFLOAT3(0, 0, 0);
+			v[c].Tangent = XMFLOAT4(0, 0, 0, 1);
+		}
+
+		// No normals in the file - fall back to the flat face normal
+		// (computed before the Z flip, so it gets flipped along with the rest)
+		for (int c = 0; c < 3; c++)
+		{
+			if (obj.Corners[t + c].Normal >= 0)
+				continue;
+
+			XMVECTOR p0 = XMLoadFloat3(&v[0].Position);
+			XMVECTOR p1 = XMLoadFloat3(&v[1].Position);
+			XMVECTOR p2 = XMLoadFloat3(&v[2].Position);
+			XMStoreFloat3(&v[c].Normal, XMVector3Normalize(XMVector3Cross(p1 - p0, p2 - p0)));
+		}
+
+		// The model is most likely in a right-handed space,
+		// especially if it came from Maya.  We want to convert
+		// to a left-handed space for DirectX.  This means we 
+		// need to:
+		//  - Invert the Z position
+		//  - Invert the normal's Z
+		//  - Flip the winding order
+		// We also need to flip the UV coordinate since DirectX
+		// defines (0,0) as the top left of the texture, and many
+		// 3D modeling packages use the bottom left as (0,0)
+		for (int c = 0; c < 3; c++)
+		{
+			v[c].UV.y = 1.0f - v[c].UV.y;		// Flip the UV's since they're probably "upside down"
+			v[c].Position.z *= -1.0f;			// Flip Z (LH vs. RH)
+			v[c].Normal.z *= -1.0f;				// Flip normal's Z
+		}
+
+		// Add the verts to the vector (flipping the winding order)
+		verts.push_back(v[0]);
+		verts.push_back(v[2]);
+		verts.push_back(v[1]);
+	}
+
+	// OBJs do not index entire vertices, so every corner above is its own vertex.
+	// Weld the duplicates so the index buffer actually does something
+	WeldStats weldStats;
+	VertexWelder::Weld(verts, outVerts, outIndices, &weldStats);
+
+	#if defined(DEBUG) || defined(_DEBUG)
+		printf("  welded %zu -> %zu vertices%s\n", weldStats.VerticesBefore, weldStats.VerticesAfter,
+			VertexWelder::MatchesUnwelded(verts, outVerts, outIndices) ? "" : " (MISMATCH against unwelded mesh!)");
+	#endif
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Reorders triangles for the post-transform cache (and then
+// overdraw), and vertices into first-use order for fetching
+// --------------------------------------------------------
+void MeshCooker::OptimizeForGPU(std::vector<Vertex>& verts, std::vector<unsigned int>& indices)
+{
+	VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), verts.size());
+
+	std::vector<size_t> clusters;
+	MeshOptimizer::OptimizeVertexCache(indices, verts.size(), MeshOptimizer::DefaultCacheSize, &clusters);
+	MeshOptimizer::OptimizeOverdraw(indices, verts, clusters);
+	MeshOptimizer::OptimizeVertexFetch(verts, indices);
+
+	VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), verts.size());
+
+	#if defined(DEBUG) || defined(_DEBUG)
+		printf("  vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", before.ACMR, after.ACMR, before.ATVR, after.ATVR);
+	#else
+		(void)before; (void)after;
+	#endif
+}
+
+// --------------------------------------------------------
+// Appends simplified versions of the mesh to the index buffer
+// (see MeshSimplifier) - they all share the same vertices
+// --------------------------------------------------------
+void MeshCooker::BuildLodChain(const std::vector<Vertex>& verts, std::vector<unsigned int>& indices, std::vector<MeshLod>& lods, const MeshCookSettings& settings)
+{
+	LodBuildStats stats;
+	MeshSimplifier::BuildLods(verts, indices, lods, settings.Lods, &stats);
+
+	//Collapses leave triangles in whatever order, so redo the cache pass on each new level
+	if (settings.Optimize)
+	{
+		for (size_t i = 1; i < lods.size(); i++)
+		{
+			std::vector<unsigned int>::iterator begin = indices.begin() + lods[i].IndexStart;
+			std::vector<unsigned int> level(begin, begin + lods[i].IndexCount);
+			MeshOptimizer::OptimizeVertexCache(level, verts.size());
+			std::copy(level.begin(), level.end(), begin);
+		}
+	}
+
+	#if defined(DEBUG) || defined(_DEBUG)
+		printf("  LODs:");
+		for (size_t i = 0; i < stats.Triangles.size(); i++)
+			printf(" %zu", stats.Triangles[i]);
+		printf(" triangles, %.2f ms\n", stats.Seconds * 1000.0);
+	#endif
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+#include "AssetPack.h"
+#include "MeshCache.h"
+#include "MeshSimplifier.h"
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Import options that change what gets cooked (and so have
+// to match between whoever cooks and whoever loads)
+// --------------------------------------------------------
+struct MeshCookSettings
+{
+	bool Optimize = true;		// Run the index/vertex reordering passes (see MeshOptimizer)
+	LodSettings Lods;
+
+	// What MeshCache stores/checks for these settings
+	uint32_t Flags() const;
+	uint64_t OptionsHash() const;
+};
+
+// --------------------------------------------------------
+// A mesh ready to upload or write out as a MeshCache
+// --------------------------------------------------------
+struct CookedMesh
+{
+	std::vector<Vertex> Vertices;
+	std::vector<unsigned int> Indices;		// Every LOD back to back
+	std::vector<MeshLod> Lods;
+	DirectX::XMFLOAT3 BoundsMin = DirectX::XMFLOAT3(0, 0, 0);
+	DirectX::XMFLOAT3 BoundsMax = DirectX::XMFLOAT3(0, 0, 0);
+};
+
+// --------------------------------------------------------
+// The OBJ import pipeline, without any D3D, so meshes can be
+// cooked by Mesh at load time or offline (see AssetCooker)
+// --------------------------------------------------------
+class MeshCooker
+{
+public:
+	static bool Cook(const char* fileName, const AssetSpan* source, const MeshCookSettings& settings, CookedMesh& out);
+
+	// Writes the cooked mesh as a MeshCache file
+	static bool Write(const char* cacheFile, uint64_t sourceHash, const MeshCookSettings& settings, const CookedMesh& mesh);
+
+	static void CalculateBounds(const Vertex* verts, int numVerts, DirectX::XMFLOAT3& boundsMin, DirectX::XMFLOAT3& boundsMax);
+
+private:
+	static bool LoadObj(const char* fileName, const AssetSpan* source, std::vector<Vertex>& outVerts, std::vector<unsigned int>& outIndices);
+	static void OptimizeForGPU(std::vector<Vertex>& verts, std::vector<unsigned int>& indices);
+	static void BuildLodChain(const std::vector<Vertex>& verts, std::vector<unsigned int>& indices, std::vector<MeshLod>& lods, const MeshCookSettings& settings);
+};
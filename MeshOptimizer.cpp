@@ -0,0 +1,367 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+	// --------------------------------------------------------
+	// Per-vertex list of the triangles that use it, stored as
+	// one flat array + offsets
+	// --------------------------------------------------------
+	struct TriangleAdjacency
+	{
+		std::vector<unsigned int> Counts;
+		std::vector<unsigned int> Offsets;
+		std::vector<unsigned int> Triangles;
+
+		void Build(const std::vector<unsigned int>& indices, size_t vertexCount)
+		{
+			Counts.assign(vertexCount, 0);
+			Offsets.assign(vertexCount + 1, 0);
+			Triangles.resize(indices.size());
+
+			for (size_t i = 0; i < indices.size(); i++)
+				Counts[indices[i]]++;
+
+			for (size_t v = 0; v < vertexCount; v++)
+				Offsets[v + 1] = Offsets[v] + Counts[v];
+
+			std::vector<unsigned int> fill(Offsets.begin(), Offsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++)
+				Triangles[fill[indices[i]]++] = (unsigned int)(i / 3);
+		}
+	};
+
+	// --------------------------------------------------------
+	// FIFO cache for splitting clusters, counted the same way as
+	// AnalyzeVertexCache.  Flush empties it by pushing time on
+	// past everything in it
+	// --------------------------------------------------------
+	struct FifoCache
+	{
+		std::vector<size_t> PushedAt;
+		size_t Pushes;
+		unsigned int Size;
+
+		FifoCache(size_t vertexCount, unsigned int size) : PushedAt(vertexCount, 0), Pushes(size), Size(size) { }
+
+		void Flush() { Pushes += Size; }
+
+		//Misses for one triangle
+		unsigned int Add(const unsigned int* triangle)
+		{
+			unsigned int misses = 0;
+			for (int c = 0; c < 3; c++)
+			{
+				size_t& pushedAt = PushedAt[triangle[c]];
+				if (pushedAt == 0 || Pushes - pushedAt >= Size)
+				{
+					Pushes++;
+					pushedAt = Pushes;
+					misses++;
+				}
+			}
+			return misses;
+		}
+	};
+
+	// --------------------------------------------------------
+	// Soft boundaries (section 4.2 of the Tipsify paper): the
+	// walk only jumps at dead ends, which on a connected mesh
+	// leaves a handful of huge clusters for the overdraw pass to
+	// sort.  Each of those is cut again wherever its ACMR, counted
+	// from a cold cache since the last cut, has come down to
+	// threshold times the ACMR of the whole run - that's where a
+	// new cluster has paid off the misses of starting cold.  The
+	// leftover at the end of a run never got there, so it's
+	// merged into the cluster before it
+	// --------------------------------------------------------
+	void SplitClusters(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize, float threshold, std::vector<size_t>& clusterStarts)
+	{
+		FifoCache cache(vertexCount, cacheSize);
+		std::vector<size_t> split;
+		split.reserve(clusterStarts.size());
+
+		for (size_t c = 0; c < clusterStarts.size(); c++)
+		{
+			size_t begin = clusterStarts[c];
+			size_t end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : indices.size();
+
+			cache.Flush();
+			unsigned int runMisses = 0;
+			for (size_t i = begin; i < end; i += 3)
+				runMisses += cache.Add(&indices[i]);
+			float target = threshold * (float)runMisses / (float)((end - begin) / 3);
+
+			cache.Flush();
+			split.push_back(begin);
+			unsigned int misses = 0;
+			unsigned int triangles = 0;
+			for (size_t i = begin; i < end; i += 3)
+			{
+				misses += cache.Add(&indices[i]);
+				triangles++;
+				if ((float)misses > target * (float)triangles)
+					continue;
+
+				split.push_back(i + 3);
+				cache.Flush();
+				misses = 0;
+				triangles = 0;
+			}
+
+			if (split.back() != begin)
+				split.pop_back();
+		}
+
+		clusterStarts.swap(split);
+	}
+}
+
+// --------------------------------------------------------
+// Counts cache misses for a FIFO cache of cacheSize entries
+// --------------------------------------------------------
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+	VertexCacheStats stats;
+	if (indexCount < 3 || vertexCount == 0 || cacheSize == 0)
+		return stats;
+
+	//A vertex is in the FIFO if it was pushed within the last cacheSize pushes
+	std::vector<size_t> pushedAt(vertexCount, 0);
+	size_t pushes = 0;
+	size_t misses = 0;
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		unsigned int v = indices[i];
+		if (pushedAt[v] == 0 || pushes - pushedAt[v] >= cacheSize)
+		{
+			pushes++;
+			pushedAt[v] = pushes;
+			misses++;
+		}
+	}
+
+	//Only count vertices actually referenced for ATVR
+	size_t usedVertices = 0;
+	for (size_t v = 0; v < vertexCount; v++)
+		if (pushedAt[v] != 0) usedVertices++;
+
+	stats.ACMR = (float)misses / (float)(indexCount / 3);
+	stats.ATVR = (float)misses / (float)usedVertices;
+	return stats;
+}
+
+// --------------------------------------------------------
+// Tipsify - fans around one vertex at a time, picking the next
+// vertex to fan around from the ones just emitted that will
+// still be in the cache.  When nothing qualifies it backs up
+// through recently used vertices, then scans forward
+// --------------------------------------------------------
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize, std::vector<size_t>* clusterStarts, float clusterThreshold)
+{
+	if (clusterStarts) clusterStarts->clear();
+
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0 || vertexCount == 0)
+		return;
+
+	TriangleAdjacency adjacency;
+	adjacency.Build(indices, vertexCount);
+
+	std::vector<unsigned int> liveTriangles = adjacency.Counts;		// Triangles not emitted yet, per vertex
+	std::vector<unsigned int> cacheTime(vertexCount, 0);			// When each vertex last entered the cache
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> deadEnd;								// Recently used vertices to back up to
+	std::vector<unsigned int> candidates;
+
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+
+	unsigned int time = cacheSize + 1;
+	size_t cursor = 0;
+	int fanVertex = 0;
+
+	//Jumps also start a new cluster for the overdraw pass (split further at the end)
+	if (clusterStarts) clusterStarts->push_back(0);
+
+	while (fanVertex >= 0)
+	{
+		candidates.clear();
+
+		//Emit every remaining triangle around the fanning vertex
+		for (unsigned int a = adjacency.Offsets[fanVertex]; a < adjacency.Offsets[fanVertex + 1]; a++)
+		{
+			unsigned int t = adjacency.Triangles[a];
+			if (emitted[t])
+				continue;
+
+			for (int c = 0; c < 3; c++)
+			{
+				unsigned int v = indices[t * 3 + c];
+				output.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				liveTriangles[v]--;
+
+				if (time - cacheTime[v] > cacheSize)
+				{
+					cacheTime[v] = time;
+					time++;
+				}
+			}
+			emitted[t] = true;
+		}
+
+		//Best candidate: still has work left and will still be cached after fanning it
+		int best = -1;
+		int bestPriority = -1;
+		for (size_t c = 0; c < candidates.size(); c++)
+		{
+			unsigned int v = candidates[c];
+			if (liveTriangles[v] == 0)
+				continue;
+
+			int priority = 0;
+			if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+				priority = (int)(time - cacheTime[v]);
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				best = (int)v;
+			}
+		}
+
+		if (best == -1)
+		{
+			//Dead end - back up through recent vertices, then scan forward
+			while (!deadEnd.empty() && best == -1)
+			{
+				unsigned int d = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveTriangles[d] > 0)
+					best = (int)d;
+			}
+
+			while (best == -1 && cursor < vertexCount)
+			{
+				if (liveTriangles[cursor] > 0)
+					best = (int)cursor;
+				cursor++;
+			}
+
+			if (best != -1 && clusterStarts && output.size() > clusterStarts->back())
+				clusterStarts->push_back(output.size());
+		}
+
+		fanVertex = best;
+	}
+
+	indices.swap(output);
+	if (clusterStarts)
+		SplitClusters(indices, vertexCount, cacheSize, clusterThreshold, *clusterStarts);
+}
+
+// --------------------------------------------------------
+// Sorts clusters by how much they face away from the mesh
+// center - those are the parts most likely to cover others
+// --------------------------------------------------------
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, const std::vector<size_t>& clusterStarts, float threshold, unsigned int cacheSize)
+{
+	size_t clusterCount = clusterStarts.size();
+	if (clusterCount < 2 || indices.empty())
+		return;
+
+	//Area weighted mesh centroid
+	XMVECTOR meshCenter = XMVectorZero();
+	float meshArea = 0.0f;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&vertices[indices[i]].Position);
+		XMVECTOR p1 = XMLoadFloat3(&vertices[indices[i + 1]].Position);
+		XMVECTOR p2 = XMLoadFloat3(&vertices[indices[i + 2]].Position);
+		float area = XMVectorGetX(XMVector3Length(XMVector3Cross(p1 - p0, p2 - p0)));
+		meshCenter += (p0 + p1 + p2) * (area / 3.0f);
+		meshArea += area;
+	}
+	if (meshArea > 0.0f)
+		meshCenter /= meshArea;
+
+	//Occlusion potential per cluster
+	std::vector<float> potential(clusterCount, 0.0f);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		size_t begin = clusterStarts[c];
+		size_t end = c + 1 < clusterCount ? clusterStarts[c + 1] : indices.size();
+
+		XMVECTOR center = XMVectorZero();
+		XMVECTOR normal = XMVectorZero();
+		float area = 0.0f;
+		for (size_t i = begin; i + 2 < end; i += 3)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&vertices[indices[i]].Position);
+			XMVECTOR p1 = XMLoadFloat3(&vertices[indices[i + 1]].Position);
+			XMVECTOR p2 = XMLoadFloat3(&vertices[indices[i + 2]].Position);
+			XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);	// Length is twice the area
+			float a = XMVectorGetX(XMVector3Length(n));
+			center += (p0 + p1 + p2) * (a / 3.0f);
+			normal += n;
+			area += a;
+		}
+
+		if (area > 0.0f)
+			center /= area;
+
+		//Clockwise front faces (see Mesh), so the summed cross products already point outward
+		potential[c] = XMVectorGetX(XMVector3Dot(center - meshCenter, XMVector3Normalize(normal)));
+	}
+
+	std::vector<size_t> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+		order[c] = c;
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return potential[a] > potential[b]; });
+
+	std::vector<unsigned int> sorted;
+	sorted.reserve(indices.size());
+	for (size_t o = 0; o < clusterCount; o++)
+	{
+		size_t c = order[o];
+		size_t begin = clusterStarts[c];
+		size_t end = c + 1 < clusterCount ? clusterStarts[c + 1] : indices.size();
+		sorted.insert(sorted.end(), indices.begin() + begin, indices.begin() + end);
+	}
+
+	//Don't trade away too much of the cache win for it
+	VertexCacheStats before = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size(), cacheSize);
+	VertexCacheStats after = AnalyzeVertexCache(sorted.data(), sorted.size(), vertices.size(), cacheSize);
+	if (after.ACMR <= before.ACMR * threshold)
+		indices.swap(sorted);
+}
+
+// --------------------------------------------------------
+// Renumbers vertices by first use so the vertex fetches walk
+// through memory mostly in order
+// --------------------------------------------------------
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	const unsigned int Unassigned = 0xFFFFFFFF;
+	std::vector<unsigned int> remap(vertices.size(), Unassigned);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		unsigned int& newIndex = remap[indices[i]];
+		if (newIndex == Unassigned)
+		{
+			newIndex = (unsigned int)reordered.size();
+			reordered.push_back(vertices[indices[i]]);
+		}
+		indices[i] = newIndex;
+	}
+
+	vertices.swap(reordered);
+}
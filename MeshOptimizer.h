@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Post-transform cache efficiency of an index buffer
+//
+// - ACMR: vertices transformed per triangle (0.5 is ideal on
+//   big meshes, 3.0 means the cache never hits)
+// - ATVR: vertices transformed per unique vertex (1.0 is ideal)
+// --------------------------------------------------------
+struct VertexCacheStats
+{
+	float ACMR = 0.0f;
+	float ATVR = 0.0f;
+};
+
+// --------------------------------------------------------
+// Index/vertex reordering passes run at import time
+//
+// Typical order:
+//   OptimizeVertexCache (Tipsify triangle order + clusters)
+//   OptimizeOverdraw    (sort those clusters outside-in)
+//   OptimizeVertexFetch (vertices in first-use order)
+//
+// None of these change what's drawn - only the order of it
+// --------------------------------------------------------
+class MeshOptimizer
+{
+public:
+	static const unsigned int DefaultCacheSize = 16;
+
+	// Simulates a FIFO post-transform cache of the given size
+	static VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = DefaultCacheSize);
+
+	// Reorders triangles for cache locality (Sander et al., "Fast Triangle Reordering
+	// for Vertex Locality and Reduced Overdraw", 2007).  clusterStarts optionally receives
+	// the first index of every cluster for OptimizeOverdraw: the walk's jumps, plus a cut
+	// wherever a cluster's ACMR has come down to clusterThreshold times its run's
+	static void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = DefaultCacheSize, std::vector<size_t>* clusterStarts = nullptr, float clusterThreshold = 1.05f);
+
+	// Orders clusters so outward facing parts of the mesh draw first.  The new
+	// order is only kept if ACMR doesn't get worse than threshold times the old one
+	static void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, const std::vector<size_t>& clusterStarts, float threshold = 1.05f, unsigned int cacheSize = DefaultCacheSize);
+
+	// Renumbers vertices in the order the index buffer first uses them (drops unused ones)
+	static void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+};
@@ -0,0 +1,280 @@
+#include "MeshRegistry.h"
+#include <cctype>
+#include <cstdio>
+
+MeshRegistry::MeshRegistry(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, GeometryArena* arena, AssetPack* pack, GeometryArena* packedArena)
+	: device(device), context(context), arena(arena), packedArena(packedArena), pack(pack)
+{
+}
+
+//Anything still referenced goes now - the device/arena won't outlive the registry
+MeshRegistry::~MeshRegistry()
+{
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		if (slots[i].State == SlotState::Free)
+			continue;
+
+		#if defined(DEBUG) || defined(_DEBUG)
+			printf("MeshRegistry: %s still has %d reference(s) at shutdown\n", slots[i].Path.c_str(), slots[i].RefCount);
+		#endif
+
+		delete slots[i].MeshPtr;
+		slots[i].MeshPtr = nullptr;
+	}
+}
+
+// --------------------------------------------------------
+// Returns the shared mesh for a file, loading it on first use
+//
+// The load runs outside the lock so other files can be looked
+// up (and loaded) at the same time.  Anyone asking for this file
+// meanwhile finds the Loading entry and waits on it
+// --------------------------------------------------------
+MeshHandle MeshRegistry::Acquire(const std::string& path, bool packed)
+{
+	std::string key = GetKey(path, packed);
+	std::unique_lock<std::mutex> lock(mutex);
+	stats.Lookups++;
+
+	uint32_t index;
+	std::unordered_map<std::string, uint32_t>::iterator existing = byPath.find(key);
+	if (existing != byPath.end())
+	{
+		stats.Hits++;
+		index = existing->second;
+
+		//The reference keeps the slot alive while waiting (slots can move, so go by index)
+		slots[index].RefCount++;
+		loaded.wait(lock, [&]() { return slots[index].State != SlotState::Loading; });
+	}
+	else
+	{
+		if (!freeSlots.empty())
+		{
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			index = (uint32_t)slots.size();
+			slots.push_back(Slot());
+			slots[index].Generation = 1;
+		}
+
+		slots[index].Path = key;
+		slots[index].RefCount = 1;
+		slots[index].State = SlotState::Loading;
+		byPath[key] = index;
+
+		lock.unlock();
+		Mesh* mesh = new Mesh(path.c_str(), device, context, packed ? packedArena : arena, pack, true, packed);
+		if (mesh->GetIndexCount() == 0)
+		{
+			delete mesh;
+			mesh = nullptr;
+		}
+		lock.lock();
+
+		slots[index].MeshPtr = mesh;
+		slots[index].State = SlotState::Ready;
+		stats.Loads += mesh ? 1 : 0;
+		loaded.notify_all();
+
+		if (mesh)
+		{
+			MeshHandle pending;
+			pending.Index = index;
+			pending.Generation = slots[index].Generation;
+			pendingUploads.push_back(pending);
+		}
+	}
+
+	//A failed load doesn't stay cached - the last one out frees the slot so it can be retried
+	if (!slots[index].MeshPtr)
+	{
+		if (--slots[index].RefCount == 0)
+			FreeSlot(index);
+		return MeshHandle();
+	}
+
+	MeshHandle handle;
+	handle.Index = index;
+	handle.Generation = slots[index].Generation;
+	return handle;
+}
+
+// --------------------------------------------------------
+// Finishes the GPU side of meshes the loader threads built.
+// The lock stays held so nothing can be released mid-upload -
+// anything released before this point just doesn't resolve
+// --------------------------------------------------------
+void MeshRegistry::UploadPending()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (size_t i = 0; i < pendingUploads.size(); i++)
+	{
+		Slot* slot = Resolve(pendingUploads[i]);
+		if (slot)
+			slot->MeshPtr->FinishUpload();
+	}
+	pendingUploads.clear();
+}
+
+MeshHandle MeshRegistry::Find(const std::string& path, bool packed)
+{
+	std::string key = GetKey(path, packed);
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.Lookups++;
+
+	MeshHandle handle;
+	std::unordered_map<std::string, uint32_t>::iterator existing = byPath.find(key);
+	if (existing != byPath.end() && slots[existing->second].State == SlotState::Ready)
+	{
+		stats.Hits++;
+		handle.Index = existing->second;
+		handle.Generation = slots[existing->second].Generation;
+	}
+	return handle;
+}
+
+void MeshRegistry::AddRef(MeshHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Slot* slot = Resolve(handle);
+	if (slot)
+		slot->RefCount++;
+}
+
+void MeshRegistry::Release(MeshHandle handle)
+{
+	Mesh* unloaded = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Slot* slot = Resolve(handle);
+		if (!slot || --slot->RefCount > 0)
+			return;
+
+		unloaded = slot->MeshPtr;
+		FreeSlot(handle.Index);
+		stats.Unloads++;
+	}
+
+	//Deleting hands the geometry back to the arena, which has its own lock
+	delete unloaded;
+}
+
+Mesh* MeshRegistry::Get(MeshHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Slot* slot = Resolve(handle);
+	return slot ? slot->MeshPtr : nullptr;
+}
+
+int MeshRegistry::GetRefCount(MeshHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Slot* slot = Resolve(handle);
+	return slot ? slot->RefCount : 0;
+}
+
+MeshRegistryStats MeshRegistry::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	MeshRegistryStats current = stats;
+	current.Resident = byPath.size();
+	return current;
+}
+
+std::string MeshRegistry::GetKey(const std::string& path, bool packed)
+{
+	return packed ? NormalizePath(path) + " (packed)" : NormalizePath(path);
+}
+
+// --------------------------------------------------------
+// One spelling per file: forward slashes, no "." or ".."
+// segments, no doubled separators, and (on Windows, where the
+// file system ignores case) lower case
+// --------------------------------------------------------
+std::string MeshRegistry::NormalizePath(const std::string& path)
+{
+	std::string prefix;
+	std::vector<std::string> parts;
+	std::string part;
+
+	size_t start = 0;
+	if (path.size() >= 2 && path[1] == ':')
+	{
+		prefix = path.substr(0, 2);
+		start = 2;
+	}
+	if (start < path.size() && (path[start] == '/' || path[start] == '\\'))
+		prefix += '/';
+
+	for (size_t i = start; i <= path.size(); i++)
+	{
+		char c = i < path.size() ? path[i] : '/';
+		if (c != '/' && c != '\\')
+		{
+			#ifdef _WIN32
+				c = (char)tolower((unsigned char)c);
+			#endif
+			part += c;
+			continue;
+		}
+
+		if (part == "..")
+		{
+			//Can't go above the root; relative paths keep leading ".."s
+			if (!parts.empty() && parts.back() != "..")
+				parts.pop_back();
+			else if (prefix.empty() || prefix.back() != '/')
+				parts.push_back(part);
+		}
+		else if (!part.empty() && part != ".")
+		{
+			parts.push_back(part);
+		}
+		part.clear();
+	}
+
+	#ifdef _WIN32
+		for (size_t i = 0; i < prefix.size(); i++)
+			prefix[i] = (char)tolower((unsigned char)prefix[i]);
+	#endif
+
+	std::string result = prefix;
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		if (i > 0)
+			result += '/';
+		result += parts[i];
+	}
+	return result;
+}
+
+MeshRegistry::Slot* MeshRegistry::Resolve(MeshHandle handle)
+{
+	if (!handle.IsValid() || handle.Index >= slots.size())
+		return nullptr;
+
+	Slot& slot = slots[handle.Index];
+	if (slot.Generation != handle.Generation || slot.State != SlotState::Ready || !slot.MeshPtr)
+		return nullptr;
+	return &slot;
+}
+
+void MeshRegistry::FreeSlot(uint32_t index)
+{
+	Slot& slot = slots[index];
+	byPath.erase(slot.Path);
+	slot.Path.clear();
+	slot.MeshPtr = nullptr;
+	slot.RefCount = 0;
+	slot.State = SlotState::Free;
+
+	//Old handles to this slot stop resolving (0 is reserved for "never valid")
+	if (++slot.Generation == 0)
+		slot.Generation = 1;
+	freeSlots.push_back(index);
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Mesh.h"
+
+// --------------------------------------------------------
+// Refers to one registry slot.  The generation changes when a
+// slot is reused, so stale handles stop resolving instead of
+// pointing at some other mesh
+// --------------------------------------------------------
+struct MeshHandle
+{
+	uint32_t Index = 0;
+	uint32_t Generation = 0;		// 0 = never valid
+
+	bool IsValid() const { return Generation != 0; }
+};
+
+struct MeshRegistryStats
+{
+	size_t Lookups = 0;
+	size_t Hits = 0;				// Lookups that found the file already loaded (or loading)
+	size_t Loads = 0;
+	size_t Unloads = 0;
+	size_t Resident = 0;
+};
+
+// --------------------------------------------------------
+// Loads each mesh file once and shares it
+//
+// - Paths are interned after normalising them (separators,
+//   "." / ".." and case), so different spellings of the same
+//   file land on the same entry
+// - Each Acquire adds a reference; the mesh is deleted when the
+//   last one is released
+// - Acquire is safe to call from several loader threads: a file
+//   asked for while another thread is still loading it waits for
+//   that load rather than reading it a second time
+// - Loader threads only read the file and build the CPU side.
+//   Putting the geometry in the arena goes through the immediate
+//   context, so it waits for UploadPending() on the render thread
+//   (a mesh draws nothing until then)
+// - A file acquired packed (see Mesh's packVertices) is its own
+//   entry, in the packed arena, next to any full float copy
+// --------------------------------------------------------
+class MeshRegistry
+{
+public:
+	// Meshes are read from the pack (if given) when it has them.  packedArena holds packed meshes' geometry
+	MeshRegistry(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, GeometryArena* arena = nullptr, AssetPack* pack = nullptr, GeometryArena* packedArena = nullptr);
+	~MeshRegistry();
+
+	// Loads the file if needed and adds a reference (invalid handle if it failed to load)
+	MeshHandle Acquire(const std::string& path, bool packed = false);
+
+	// Uploads meshes loaded since the last call - render thread only, once a frame
+	// (and once after loading at startup, so they draw on the first frame)
+	void UploadPending();
+
+	// Existing entry only - no load, no reference
+	MeshHandle Find(const std::string& path, bool packed = false);
+
+	void AddRef(MeshHandle handle);
+	void Release(MeshHandle handle);
+
+	// nullptr for stale/invalid handles
+	Mesh* Get(MeshHandle handle);
+	int GetRefCount(MeshHandle handle);
+
+	MeshRegistryStats GetStats();
+
+	static std::string NormalizePath(const std::string& path);
+
+private:
+	enum class SlotState { Free, Loading, Ready };
+
+	struct Slot
+	{
+		std::string Path;
+		Mesh* MeshPtr = nullptr;
+		int RefCount = 0;
+		uint32_t Generation = 0;
+		SlotState State = SlotState::Free;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	GeometryArena* arena;
+	GeometryArena* packedArena;
+	AssetPack* pack;
+
+	std::mutex mutex;
+	std::condition_variable loaded;
+
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+	std::unordered_map<std::string, uint32_t> byPath;
+	std::vector<MeshHandle> pendingUploads;
+	MeshRegistryStats stats;
+
+	// Normalized path, marked when it's the packed entry
+	static std::string GetKey(const std::string& path, bool packed);
+
+	// Call with the mutex held
+	Slot* Resolve(MeshHandle handle);
+	void FreeSlot(uint32_t index);
+};
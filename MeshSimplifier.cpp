@@ -0,0 +1,531 @@
+#include "MeshSimplifier.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace
+{
+	// --------------------------------------------------------
+	// Symmetric 4x4 quadric - sum of squared distances to a set
+	// of planes, kept in doubles since costs get tiny
+	// --------------------------------------------------------
+	struct Quadric
+	{
+		double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+		void Clear()
+		{
+			a2 = ab = ac = ad = b2 = bc = bd = c2 = cd = d2 = 0.0;
+		}
+
+		void AddPlane(double a, double b, double c, double d)
+		{
+			a2 += a * a; ab += a * b; ac += a * c; ad += a * d;
+			b2 += b * b; bc += b * c; bd += b * d;
+			c2 += c * c; cd += c * d;
+			d2 += d * d;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+		}
+
+		double Evaluate(XMFLOAT3 p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double e = x * x * a2 + y * y * b2 + z * z * c2 + d2
+				+ 2.0 * (x * y * ab + x * z * ac + y * z * bc + x * ad + y * bd + z * cd);
+			return std::max(e, 0.0);
+		}
+	};
+
+	struct Collapse
+	{
+		double Cost;
+		unsigned int From;
+		unsigned int To;
+		unsigned int Stamp;
+
+		bool operator>(const Collapse& other) const
+		{
+			//Ties broken by vertex so the result never depends on heap internals
+			if (Cost != other.Cost) return Cost > other.Cost;
+			return From > other.From;
+		}
+	};
+
+	inline XMFLOAT3 Sub(XMFLOAT3 a, XMFLOAT3 b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+	inline XMFLOAT3 Cross(XMFLOAT3 a, XMFLOAT3 b) { return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+	inline float Dot(XMFLOAT3 a, XMFLOAT3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	double SecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	float BoundingRadius(const std::vector<Vertex>& vertices)
+	{
+		if (vertices.empty())
+			return 0.0f;
+
+		XMFLOAT3 mn = vertices[0].Position;
+		XMFLOAT3 mx = vertices[0].Position;
+		for (size_t i = 1; i < vertices.size(); i++)
+		{
+			const XMFLOAT3& p = vertices[i].Position;
+			mn = XMFLOAT3(std::min(mn.x, p.x), std::min(mn.y, p.y), std::min(mn.z, p.z));
+			mx = XMFLOAT3(std::max(mx.x, p.x), std::max(mx.y, p.y), std::max(mx.z, p.z));
+		}
+		XMFLOAT3 d = Sub(mx, mn);
+		return 0.5f * sqrtf(Dot(d, d));
+	}
+
+	// --------------------------------------------------------
+	// Working state for one Simplify() call
+	// --------------------------------------------------------
+	class Simplifier
+	{
+	public:
+		Simplifier(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) :
+			vertices(vertices), indices(indices)
+		{
+		}
+
+		float Run(size_t targetIndexCount, float maxError)
+		{
+			size_t vertexCount = vertices.size();
+			size_t triangleCount = indices.size() / 3;
+			if (triangleCount == 0 || targetIndexCount >= indices.size())
+				return 0.0f;
+
+			FindLockedVertices();
+			BuildAdjacency();
+			BuildQuadrics();
+
+			stamps.assign(vertexCount, 0);
+			removed.assign(vertexCount, false);
+			for (unsigned int v = 0; v < vertexCount; v++)
+				PushBestCollapse(v);
+
+			double maxCost = (double)maxError * maxError;
+			double reached = 0.0;
+			size_t liveTriangles = triangleCount;
+
+			while (liveTriangles * 3 > targetIndexCount && !heap.empty())
+			{
+				Collapse c = heap.top();
+				heap.pop();
+
+				if (removed[c.From] || c.Stamp != stamps[c.From])
+					continue;
+
+				//Everything left costs more than this
+				if (c.Cost > maxCost)
+					break;
+
+				//Neighbourhood changed since this was queued - find a new target
+				if (removed[c.To] || !FindMoves(c.From, c.To, moves))
+				{
+					PushBestCollapse(c.From);
+					continue;
+				}
+
+				for (size_t m = 0; m < moves.size(); m++)
+					liveTriangles -= Apply(moves[m].first, moves[m].second);
+				reached = std::max(reached, c.Cost);
+
+				//Costs around the merged vertices all changed
+				for (size_t m = 0; m < moves.size(); m++)
+				{
+					unsigned int to = moves[m].second;
+					PushBestCollapse(to);
+					GatherNeighbours(to, neighbours);
+					for (size_t n = 0; n < neighbours.size(); n++)
+						PushBestCollapse(neighbours[n]);
+				}
+			}
+
+			//Compact the surviving triangles
+			std::vector<unsigned int> result;
+			result.reserve(liveTriangles * 3);
+			for (size_t t = 0; t < triangleCount; t++)
+				if (alive[t]) result.insert(result.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+			indices.swap(result);
+
+			return (float)sqrt(reached);
+		}
+
+	private:
+		const std::vector<Vertex>& vertices;
+		std::vector<unsigned int>& indices;
+
+		std::vector<bool> locked;
+		std::vector<unsigned int> positionId;				// Vertices at the same position share one
+		std::vector<unsigned int> groupOffsets;				// groupVertices[groupOffsets[id]...] = every vertex at a position
+		std::vector<unsigned int> groupVertices;
+		std::vector<bool> removed;
+		std::vector<bool> alive;
+		std::vector<std::vector<unsigned int>> adjacency;	// Triangles per vertex (may hold dead ones)
+		std::vector<Quadric> quadrics;
+		std::vector<unsigned int> stamps;					// Bumped whenever a vertex's queued collapse goes stale
+		std::vector<unsigned int> neighbours;				// Scratch lists, kept to avoid reallocating
+		std::vector<unsigned int> targets;
+		std::vector<std::pair<double, unsigned int>> candidates;
+		std::vector<std::pair<unsigned int, unsigned int>> moves;		// (from, to) for every vertex at a position
+		std::vector<std::pair<unsigned int, unsigned int>> trialMoves;
+		std::vector<unsigned int> siblingNeighbours;
+		std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+
+		// --------------------------------------------------------
+		// Groups vertices by position and locks every group that
+		// touches an open border: an edge (between positions) used
+		// by only one triangle.  Seams (several vertices at one
+		// position, e.g. UV splits) aren't locked - they move as a
+		// group instead (see FindMoves)
+		// --------------------------------------------------------
+		void FindLockedVertices()
+		{
+			size_t vertexCount = vertices.size();
+			locked.assign(vertexCount, false);
+
+			//Group vertices by exact position
+			groupVertices.resize(vertexCount);
+			for (unsigned int v = 0; v < vertexCount; v++)
+				groupVertices[v] = v;
+			std::sort(groupVertices.begin(), groupVertices.end(), [&](unsigned int a, unsigned int b)
+			{
+				const XMFLOAT3& pa = vertices[a].Position;
+				const XMFLOAT3& pb = vertices[b].Position;
+				if (pa.x != pb.x) return pa.x < pb.x;
+				if (pa.y != pb.y) return pa.y < pb.y;
+				if (pa.z != pb.z) return pa.z < pb.z;
+				return a < b;
+			});
+
+			positionId.resize(vertexCount);
+			groupOffsets.clear();
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				if (i == 0 || memcmp(&vertices[groupVertices[i]].Position, &vertices[groupVertices[i - 1]].Position, sizeof(XMFLOAT3)) != 0)
+					groupOffsets.push_back((unsigned int)i);
+				positionId[groupVertices[i]] = (unsigned int)groupOffsets.size() - 1;
+			}
+			groupOffsets.push_back((unsigned int)vertexCount);
+
+			//Count every undirected position edge
+			std::unordered_map<uint64_t, unsigned int> edgeUses;
+			edgeUses.reserve(indices.size());
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					uint64_t a = positionId[indices[i + k]];
+					uint64_t b = positionId[indices[i + (k + 1) % 3]];
+					edgeUses[a < b ? (a << 32 | b) : (b << 32 | a)]++;
+				}
+			}
+
+			std::vector<bool> lockedGroups(groupOffsets.size() - 1, false);
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					uint64_t a = positionId[indices[i + k]];
+					uint64_t b = positionId[indices[i + (k + 1) % 3]];
+					if (edgeUses[a < b ? (a << 32 | b) : (b << 32 | a)] == 1)
+						lockedGroups[(size_t)a] = lockedGroups[(size_t)b] = true;
+				}
+			}
+
+			for (size_t v = 0; v < vertexCount; v++)
+				locked[v] = lockedGroups[positionId[v]];
+		}
+
+		void BuildAdjacency()
+		{
+			size_t triangleCount = indices.size() / 3;
+			adjacency.assign(vertices.size(), std::vector<unsigned int>());
+			alive.assign(triangleCount, true);
+			for (size_t t = 0; t < triangleCount; t++)
+				for (int k = 0; k < 3; k++)
+					adjacency[indices[t * 3 + k]].push_back((unsigned int)t);
+		}
+
+		//Each vertex starts with the planes of the triangles around it
+		void BuildQuadrics()
+		{
+			quadrics.resize(vertices.size());
+			for (size_t v = 0; v < quadrics.size(); v++)
+				quadrics[v].Clear();
+
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				XMFLOAT3 p0 = vertices[indices[i]].Position;
+				XMFLOAT3 n = Cross(Sub(vertices[indices[i + 1]].Position, p0), Sub(vertices[indices[i + 2]].Position, p0));
+				double len = sqrt((double)Dot(n, n));
+				if (len <= 0.0)
+					continue;
+
+				double a = n.x / len, b = n.y / len, c = n.z / len;
+				double d = -(a * p0.x + b * p0.y + c * p0.z);
+				for (int k = 0; k < 3; k++)
+					quadrics[indices[i + k]].AddPlane(a, b, c, d);
+			}
+		}
+
+		// --------------------------------------------------------
+		// Moving from onto to mustn't flip (or flatten) any of the
+		// triangles that survive the collapse
+		// --------------------------------------------------------
+		bool IsValid(unsigned int from, unsigned int to)
+		{
+			XMFLOAT3 target = vertices[to].Position;
+			for (size_t a = 0; a < adjacency[from].size(); a++)
+			{
+				unsigned int t = adjacency[from][a];
+				if (!alive[t])
+					continue;
+
+				const unsigned int* tri = &indices[t * 3];
+				if (tri[0] == to || tri[1] == to || tri[2] == to)
+					continue;
+
+				XMFLOAT3 p[3];
+				XMFLOAT3 q[3];
+				for (int k = 0; k < 3; k++)
+				{
+					p[k] = vertices[tri[k]].Position;
+					q[k] = tri[k] == from ? target : p[k];
+				}
+
+				XMFLOAT3 before = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+				XMFLOAT3 after = Cross(Sub(q[1], q[0]), Sub(q[2], q[0]));
+				if (Dot(before, after) <= 0.0f)
+					return false;
+			}
+			return true;
+		}
+
+		//Every other vertex sharing a live triangle with v, once each
+		void GatherNeighbours(unsigned int v, std::vector<unsigned int>& out)
+		{
+			out.clear();
+			for (size_t a = 0; a < adjacency[v].size(); a++)
+			{
+				unsigned int t = adjacency[v][a];
+				if (!alive[t])
+					continue;
+
+				for (int k = 0; k < 3; k++)
+					if (indices[t * 3 + k] != v) out.push_back(indices[t * 3 + k]);
+			}
+
+			std::sort(out.begin(), out.end());
+			out.erase(std::unique(out.begin(), out.end()), out.end());
+		}
+
+		//Planes around a position, from every vertex there
+		Quadric GroupQuadric(unsigned int group) const
+		{
+			Quadric q;
+			q.Clear();
+			for (unsigned int i = groupOffsets[group]; i < groupOffsets[group + 1]; i++)
+				if (!removed[groupVertices[i]]) q.Add(quadrics[groupVertices[i]]);
+			return q;
+		}
+
+		// --------------------------------------------------------
+		// Everything that has to move for from to collapse onto to:
+		// each vertex at from's position that's still in use goes to
+		// the one vertex at to's position it shares an edge with.
+		// On a seam that means the collapse has to run along the
+		// seam, so every side keeps its own attributes.  False if
+		// any of them has no single partner, or would flip a triangle
+		// --------------------------------------------------------
+		bool FindMoves(unsigned int from, unsigned int to, std::vector<std::pair<unsigned int, unsigned int>>& out)
+		{
+			out.clear();
+			unsigned int fromGroup = positionId[from];
+			unsigned int toGroup = positionId[to];
+			if (fromGroup == toGroup)
+				return false;
+
+			for (unsigned int i = groupOffsets[fromGroup]; i < groupOffsets[fromGroup + 1]; i++)
+			{
+				unsigned int sibling = groupVertices[i];
+				if (removed[sibling] || adjacency[sibling].empty())
+					continue;
+
+				GatherNeighbours(sibling, siblingNeighbours);
+				unsigned int partner = 0;
+				int partners = 0;
+				for (size_t n = 0; n < siblingNeighbours.size(); n++)
+				{
+					if (positionId[siblingNeighbours[n]] == toGroup)
+					{
+						partner = siblingNeighbours[n];
+						partners++;
+					}
+				}
+
+				if (partners == 0 && sibling != from)
+					continue;		//Only dead triangles left here
+				if (partners != 1 || !IsValid(sibling, partner))
+					return false;
+				out.push_back(std::make_pair(sibling, partner));
+			}
+			return !out.empty();
+		}
+
+		//Cheapest valid neighbour to collapse onto, if this vertex is allowed to move at all
+		void PushBestCollapse(unsigned int from)
+		{
+			stamps[from]++;
+			if (locked[from] || removed[from])
+				return;
+
+			GatherNeighbours(from, targets);
+			Quadric fromQuadric = GroupQuadric(positionId[from]);
+
+			candidates.clear();
+			for (size_t n = 0; n < targets.size(); n++)
+			{
+				Quadric q = fromQuadric;
+				q.Add(GroupQuadric(positionId[targets[n]]));
+				candidates.push_back(std::make_pair(q.Evaluate(vertices[targets[n]].Position), targets[n]));
+			}
+
+			//Only the flip check is expensive, so do it cheapest first and stop at the first that passes
+			std::sort(candidates.begin(), candidates.end());
+			for (size_t c = 0; c < candidates.size(); c++)
+			{
+				if (FindMoves(from, candidates[c].second, trialMoves))
+				{
+					Collapse best = { candidates[c].first, from, candidates[c].second, stamps[from] };
+					heap.push(best);
+					return;
+				}
+			}
+		}
+
+		//Returns how many triangles were removed
+		size_t Apply(unsigned int from, unsigned int to)
+		{
+			size_t killed = 0;
+			for (size_t a = 0; a < adjacency[from].size(); a++)
+			{
+				unsigned int t = adjacency[from][a];
+				if (!alive[t])
+					continue;
+
+				unsigned int* tri = &indices[t * 3];
+				if (tri[0] == to || tri[1] == to || tri[2] == to)
+				{
+					alive[t] = false;
+					killed++;
+					continue;
+				}
+
+				for (int k = 0; k < 3; k++)
+					if (tri[k] == from) tri[k] = to;
+				adjacency[to].push_back(t);
+			}
+
+			//Drop dead triangles so lists around busy vertices don't keep growing
+			std::vector<unsigned int>& list = adjacency[to];
+			list.erase(std::remove_if(list.begin(), list.end(), [&](unsigned int t) { return !alive[t]; }), list.end());
+
+			adjacency[from].clear();
+			quadrics[to].Add(quadrics[from]);
+			removed[from] = true;
+			return killed;
+		}
+	};
+}
+
+uint64_t LodSettings::Hash() const
+{
+	uint64_t h = HashBytes(&MaxError, sizeof(MaxError));
+	return TargetRatios.empty() ? h : HashBytes(TargetRatios.data(), TargetRatios.size() * sizeof(float), h);
+}
+
+float MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, size_t targetIndexCount, float maxError)
+{
+	Simplifier simplifier(vertices, indices);
+	return simplifier.Run(targetIndexCount, maxError);
+}
+
+// --------------------------------------------------------
+// Each level is simplified from the one before, so the errors
+// add up - the recorded error of a level is that running total
+// --------------------------------------------------------
+void MeshSimplifier::BuildLods(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, std::vector<MeshLod>& lods, const LodSettings& settings, LodBuildStats* stats)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	lods.clear();
+	MeshLod base = { 0, (uint32_t)indices.size(), 0.0f };
+	lods.push_back(base);
+
+	float radius = BoundingRadius(vertices);
+	std::vector<unsigned int> previous(indices);
+	float totalError = 0.0f;
+
+	for (size_t r = 0; r < settings.TargetRatios.size() && radius > 0.0f; r++)
+	{
+		size_t target = (size_t)(base.IndexCount / 3 * settings.TargetRatios[r]) * 3;
+		float budget = settings.MaxError * radius - totalError;
+		if (budget <= 0.0f || target >= previous.size())
+			break;
+
+		std::vector<unsigned int> level(previous);
+		float error = Simplify(vertices, level, target, budget);
+
+		//Not worth another draw range if it barely shrank
+		if (level.empty() || level.size() > previous.size() * 9 / 10)
+			break;
+
+		totalError += error;
+		MeshLod lod = { (uint32_t)indices.size(), (uint32_t)level.size(), totalError / radius };
+		lods.push_back(lod);
+		indices.insert(indices.end(), level.begin(), level.end());
+		previous.swap(level);
+	}
+
+	if (stats)
+	{
+		stats->Triangles.clear();
+		for (size_t i = 0; i < lods.size(); i++)
+			stats->Triangles.push_back(lods[i].IndexCount / 3);
+		stats->Seconds = SecondsSince(start);
+	}
+}
+
+void MeshSimplifier::Benchmark(const char* name, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const LodSettings& settings, int iterations)
+{
+	double best = 1e30;
+	std::vector<MeshLod> lods;
+	for (int i = 0; i < iterations; i++)
+	{
+		std::vector<unsigned int> chain(indices);
+		LodBuildStats stats;
+		BuildLods(vertices, chain, lods, settings, &stats);
+		best = std::min(best, stats.Seconds);
+	}
+
+	printf("%s: %zu vertices, %zu LODs in %.2f ms (best of %d)\n", name, vertices.size(), lods.size(), best * 1000.0, iterations);
+	for (size_t i = 0; i < lods.size(); i++)
+		printf("  LOD %zu: %u triangles, error %.4f of radius\n", i, lods[i].IndexCount / 3, lods[i].Error);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// One level of detail - a range of the mesh's index buffer
+// (every LOD shares LOD 0's vertices)
+// --------------------------------------------------------
+struct MeshLod
+{
+	uint32_t IndexStart;
+	uint32_t IndexCount;
+	float Error;			// Geometric error relative to the mesh's bounding radius
+};
+
+// --------------------------------------------------------
+// How the LOD chain is built
+//
+// - TargetRatios: triangle count of each extra LOD as a
+//   fraction of LOD 0 (e.g. 0.5, 0.25, 0.125)
+// - MaxError: simplification stops once the error would go
+//   over this fraction of the mesh's bounding radius, even if
+//   the target wasn't reached
+// --------------------------------------------------------
+struct LodSettings
+{
+	std::vector<float> TargetRatios;
+	float MaxError;
+
+	LodSettings() : TargetRatios({ 0.5f, 0.25f, 0.125f }), MaxError(0.05f) {}
+
+	// For telling whether a cooked mesh was built with the same settings
+	uint64_t Hash() const;
+};
+
+struct LodBuildStats
+{
+	std::vector<size_t> Triangles;		// Per LOD
+	double Seconds = 0.0;
+};
+
+// --------------------------------------------------------
+// Quadric error edge-collapse simplification (Garland &
+// Heckbert, "Surface Simplification Using Quadric Error
+// Metrics", 1997)
+//
+// - Collapses move a vertex onto one of its neighbours, so
+//   no new vertices are made and every LOD can share LOD 0's
+//   vertex buffer
+// - Vertices on open borders never move, so the silhouette
+//   stays intact
+// - Attribute seams (several vertices at one position, e.g.
+//   UV splits or hard edges) move as a group and only along
+//   the seam, each vertex onto its own side's neighbour, so
+//   flat-shaded meshes still simplify
+// - Collapses that would flip a triangle are skipped
+//
+// Meshes where every collapse changes the shape a lot (a cube:
+// any collapse moves a whole face) get no LODs - the first
+// collapse already costs more than MaxError
+// --------------------------------------------------------
+class MeshSimplifier
+{
+public:
+	// Collapses edges until indices are down to targetIndexCount or the next collapse
+	// would cost more than maxError (mesh units).  Returns the error reached
+	static float Simplify(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, size_t targetIndexCount, float maxError);
+
+	// Appends each LOD after LOD 0 (the indices passed in) and fills in the LOD table.
+	// Levels that can't get meaningfully smaller than the previous one are left out
+	static void BuildLods(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, std::vector<MeshLod>& lods, const LodSettings& settings, LodBuildStats* stats = nullptr);
+
+	// Builds the chain several times and prints triangle counts, errors and timing
+	// (run it headless with MeshBenchmarkMain.cpp's simplify mode)
+	static void Benchmark(const char* name, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const LodSettings& settings, int iterations);
+};
@@ -0,0 +1,289 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	const uint8_t NotInMeshlet = 0xFF;
+
+	// Narrower cones than this (dot of the widest normal with the axis)
+	// almost never get culled, so they aren't worth testing
+	const float MinConeDot = 0.1f;
+
+	double SecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	// --------------------------------------------------------
+	// Everything needed while growing one meshlet at a time
+	// --------------------------------------------------------
+	struct MeshletState
+	{
+		const unsigned int* indices;
+		size_t triangleCount;
+
+		// Vertex -> triangles using it (CSR)
+		std::vector<unsigned int> adjacencyOffsets;
+		std::vector<unsigned int> adjacency;
+
+		std::vector<XMFLOAT3> centroids;
+		std::vector<uint8_t> used;
+
+		// Each vertex's slot in the current meshlet, or NotInMeshlet
+		std::vector<uint8_t> local;
+
+		Meshlet current;
+		XMFLOAT3 centroidSum;
+
+		int NewVertexCount(size_t t) const
+		{
+			int count = 0;
+			for (int c = 0; c < 3; c++)
+				count += local[indices[t * 3 + c]] == NotInMeshlet ? 1 : 0;
+			return count;
+		}
+
+		bool Fits(size_t t) const
+		{
+			return current.TriangleCount < MESHLET_MAX_TRIANGLES &&
+				current.VertexCount + NewVertexCount(t) <= MESHLET_MAX_VERTICES;
+		}
+
+		// Unused triangle touching the meshlet that adds the fewest vertices,
+		// then the closest one, then the lowest index.  Returns triangleCount if none fit
+		size_t FindNeighbour(const MeshletData& out) const
+		{
+			size_t best = triangleCount;
+			int bestNew = 4;
+			float bestDistance = FLT_MAX;
+			if (current.TriangleCount == 0 || current.TriangleCount >= MESHLET_MAX_TRIANGLES)
+				return best;
+
+			float inv = 1.0f / current.TriangleCount;
+			XMFLOAT3 center(centroidSum.x * inv, centroidSum.y * inv, centroidSum.z * inv);
+
+			for (uint32_t i = 0; i < current.VertexCount; i++)
+			{
+				unsigned int v = out.Vertices[current.VertexOffset + i];
+				for (unsigned int a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; a++)
+				{
+					size_t t = adjacency[a];
+					if (used[t])
+						continue;
+
+					int newVerts = NewVertexCount(t);
+					if (current.VertexCount + newVerts > MESHLET_MAX_VERTICES || newVerts > bestNew)
+						continue;
+
+					float dx = centroids[t].x - center.x;
+					float dy = centroids[t].y - center.y;
+					float dz = centroids[t].z - center.z;
+					float distance = dx * dx + dy * dy + dz * dz;
+
+					if (newVerts < bestNew || distance < bestDistance || (distance == bestDistance && t < best))
+					{
+						best = t;
+						bestNew = newVerts;
+						bestDistance = distance;
+					}
+				}
+			}
+			return best;
+		}
+
+		void Add(size_t t, MeshletData& out)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				unsigned int v = indices[t * 3 + c];
+				if (local[v] == NotInMeshlet)
+				{
+					local[v] = (uint8_t)current.VertexCount++;
+					out.Vertices.push_back(v);
+				}
+				out.Triangles.push_back(local[v]);
+			}
+
+			centroidSum.x += centroids[t].x;
+			centroidSum.y += centroids[t].y;
+			centroidSum.z += centroids[t].z;
+			current.TriangleCount++;
+			used[t] = 1;
+		}
+
+		void Flush(const Vertex* vertices, MeshletData& out)
+		{
+			if (current.TriangleCount > 0)
+			{
+				for (uint32_t i = 0; i < current.VertexCount; i++)
+					local[out.Vertices[current.VertexOffset + i]] = NotInMeshlet;
+
+				out.Meshlets.push_back(current);
+				out.Bounds.push_back(MeshletBuilder::ComputeBounds(vertices, out, current));
+			}
+
+			current.VertexOffset = (uint32_t)out.Vertices.size();
+			current.TriangleOffset = (uint32_t)out.Triangles.size();
+			current.VertexCount = 0;
+			current.TriangleCount = 0;
+			centroidSum = XMFLOAT3(0, 0, 0);
+		}
+	};
+}
+
+void MeshletBuilder::Build(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, MeshletData& out, MeshletStats* stats)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	out.Meshlets.clear();
+	out.Bounds.clear();
+	out.Vertices.clear();
+	out.Triangles.clear();
+
+	MeshletState state;
+	state.indices = indices;
+	state.triangleCount = indexCount / 3;
+
+	//Vertex -> triangle adjacency, triangles in index order for each vertex
+	state.adjacencyOffsets.assign(vertexCount + 1, 0);
+	for (size_t i = 0; i < state.triangleCount * 3; i++)
+		state.adjacencyOffsets[indices[i] + 1]++;
+	for (size_t v = 0; v < vertexCount; v++)
+		state.adjacencyOffsets[v + 1] += state.adjacencyOffsets[v];
+
+	std::vector<unsigned int> fill(state.adjacencyOffsets.begin(), state.adjacencyOffsets.end() - 1);
+	state.adjacency.resize(state.triangleCount * 3);
+	for (size_t i = 0; i < state.triangleCount * 3; i++)
+		state.adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+	state.centroids.resize(state.triangleCount);
+	for (size_t t = 0; t < state.triangleCount; t++)
+	{
+		XMVECTOR sum = XMLoadFloat3(&vertices[indices[t * 3 + 0]].Position) +
+			XMLoadFloat3(&vertices[indices[t * 3 + 1]].Position) +
+			XMLoadFloat3(&vertices[indices[t * 3 + 2]].Position);
+		XMStoreFloat3(&state.centroids[t], sum * (1.0f / 3.0f));
+	}
+
+	state.used.assign(state.triangleCount, 0);
+	state.local.assign(vertexCount, NotInMeshlet);
+	out.Vertices.reserve(vertexCount + vertexCount / 4);
+	out.Triangles.reserve(state.triangleCount * 3);
+
+	//Flush with nothing in the meshlet just sets up the first one's offsets
+	state.current = Meshlet();
+	state.Flush(vertices, out);
+
+	//Grow through neighbours; when there are none (the piece ran out, or the meshlet
+	//is full) carry on from the first unused triangle - already spatially coherent
+	//when the mesh went through MeshOptimizer
+	size_t cursor = 0;
+	for (;;)
+	{
+		size_t t = state.FindNeighbour(out);
+		if (t == state.triangleCount)
+		{
+			while (cursor < state.triangleCount && state.used[cursor])
+				cursor++;
+			if (cursor == state.triangleCount)
+				break;
+			t = cursor;
+		}
+
+		if (!state.Fits(t))
+		{
+			state.Flush(vertices, out);
+			continue;
+		}
+
+		state.Add(t, out);
+	}
+	state.Flush(vertices, out);
+
+	if (stats)
+	{
+		stats->Meshlets = out.Meshlets.size();
+		stats->Triangles = out.Triangles.size() / 3;
+		stats->VertexReferences = out.Vertices.size();
+		stats->ConeCullable = 0;
+		for (size_t i = 0; i < out.Bounds.size(); i++)
+			stats->ConeCullable += out.Bounds[i].ConeCutoff < 1.0f ? 1 : 0;
+		stats->Seconds = SecondsSince(start);
+	}
+}
+
+// --------------------------------------------------------
+// Sphere: centered on the meshlet's box, out to the furthest vertex
+// Cone: average of the triangle normals, wide enough for all of them
+// --------------------------------------------------------
+MeshletBounds MeshletBuilder::ComputeBounds(const Vertex* vertices, const MeshletData& data, const Meshlet& meshlet)
+{
+	MeshletBounds bounds;
+	const unsigned int* meshletVertices = &data.Vertices[meshlet.VertexOffset];
+	const uint8_t* triangles = &data.Triangles[meshlet.TriangleOffset];
+
+	XMVECTOR minV = XMLoadFloat3(&vertices[meshletVertices[0]].Position);
+	XMVECTOR maxV = minV;
+	for (uint32_t i = 1; i < meshlet.VertexCount; i++)
+	{
+		XMVECTOR p = XMLoadFloat3(&vertices[meshletVertices[i]].Position);
+		minV = XMVectorMin(minV, p);
+		maxV = XMVectorMax(maxV, p);
+	}
+
+	XMVECTOR center = (minV + maxV) * 0.5f;
+	float radiusSq = 0.0f;
+	for (uint32_t i = 0; i < meshlet.VertexCount; i++)
+	{
+		XMVECTOR p = XMLoadFloat3(&vertices[meshletVertices[i]].Position);
+		radiusSq = (std::max)(radiusSq, XMVectorGetX(XMVector3LengthSq(p - center)));
+	}
+	XMStoreFloat3(&bounds.Center, center);
+	bounds.Radius = sqrtf(radiusSq);
+
+	//Unit face normals (degenerate triangles can face any way, so they're left out)
+	XMVECTOR normals[MESHLET_MAX_TRIANGLES];
+	uint32_t normalCount = 0;
+	XMVECTOR normalSum = XMVectorZero();
+	for (uint32_t t = 0; t < meshlet.TriangleCount; t++)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&vertices[meshletVertices[triangles[t * 3 + 0]]].Position);
+		XMVECTOR p1 = XMLoadFloat3(&vertices[meshletVertices[triangles[t * 3 + 1]]].Position);
+		XMVECTOR p2 = XMLoadFloat3(&vertices[meshletVertices[triangles[t * 3 + 2]]].Position);
+		XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+
+		float length = XMVectorGetX(XMVector3Length(n));
+		if (length <= FLT_MIN)
+			continue;
+
+		normals[normalCount] = n / length;
+		normalSum += normals[normalCount];
+		normalCount++;
+	}
+
+	bounds.ConeAxis = XMFLOAT3(0, 0, 0);
+	bounds.ConeCutoff = 1.0f;
+
+	float sumLength = XMVectorGetX(XMVector3Length(normalSum));
+	if (normalCount == 0 || sumLength <= FLT_MIN)
+		return bounds;
+
+	XMVECTOR axis = normalSum / sumLength;
+	float minDot = 1.0f;
+	for (uint32_t i = 0; i < normalCount; i++)
+		minDot = (std::min)(minDot, XMVectorGetX(XMVector3Dot(axis, normals[i])));
+
+	//The camera has to be within 90 degrees - (cone angle) of the axis, i.e. sin(cone angle)
+	if (minDot > MinConeDot)
+	{
+		XMStoreFloat3(&bounds.ConeAxis, axis);
+		bounds.ConeCutoff = sqrtf(1.0f - minDot * minDot);
+	}
+	return bounds;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+// Limits per meshlet (the usual mesh shader sizes - 124 keeps the
+// triangle bytes of a full meshlet a multiple of 4)
+const size_t MESHLET_MAX_VERTICES = 64;
+const size_t MESHLET_MAX_TRIANGLES = 124;
+
+// --------------------------------------------------------
+// A small cluster of triangles
+//
+// - Vertices: VertexCount entries of MeshletData::Vertices,
+//   starting at VertexOffset, indexing the mesh's vertex buffer
+// - Triangles: TriangleCount * 3 entries of
+//   MeshletData::Triangles, starting at TriangleOffset, indexing
+//   the meshlet's own vertex list
+// --------------------------------------------------------
+struct Meshlet
+{
+	uint32_t VertexOffset;
+	uint32_t TriangleOffset;
+	uint32_t VertexCount;
+	uint32_t TriangleCount;
+};
+
+// --------------------------------------------------------
+// What the culler needs per meshlet (all in mesh space)
+//
+// - Center/Radius: sphere around every vertex
+// - ConeAxis/ConeCutoff: every triangle faces away from a camera
+//   at p once dot(Center - p, ConeAxis) >= ConeCutoff * |Center - p| + Radius.
+//   Meshlets that bend too much get a zero axis and a cutoff of 1
+//   so the test never passes
+// --------------------------------------------------------
+struct MeshletBounds
+{
+	DirectX::XMFLOAT3 Center;
+	float Radius;
+	DirectX::XMFLOAT3 ConeAxis;
+	float ConeCutoff;
+};
+
+struct MeshletData
+{
+	std::vector<Meshlet> Meshlets;
+	std::vector<MeshletBounds> Bounds;		// One per meshlet
+	std::vector<unsigned int> Vertices;
+	std::vector<uint8_t> Triangles;
+};
+
+struct MeshletStats
+{
+	size_t Meshlets = 0;
+	size_t Triangles = 0;
+	size_t VertexReferences = 0;		// Sum of every meshlet's vertex count
+	size_t ConeCullable = 0;			// Meshlets flat enough to have a usable normal cone
+	double Seconds = 0.0;
+};
+
+// --------------------------------------------------------
+// Splits an index buffer into meshlets of at most
+// MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES
+// triangles
+//
+// Meshlets grow greedily from the first unused triangle in
+// index order, always taking the neighbouring triangle that adds
+// the fewest new vertices (then the one closest to the meshlet,
+// then the lowest index).  Everything runs in a fixed order so
+// the same input always gives the same meshlets
+// --------------------------------------------------------
+class MeshletBuilder
+{
+public:
+	static void Build(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, MeshletData& out, MeshletStats* stats = nullptr);
+
+	// Bounding sphere and normal cone of one meshlet
+	static MeshletBounds ComputeBounds(const Vertex* vertices, const MeshletData& data, const Meshlet& meshlet);
+};
@@ -0,0 +1,198 @@
+#include "MeshletCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Uneven scales further apart than this turn cone culling off
+	const float MaxScaleSkew = 0.01f;
+
+	int CountBits(int mask)
+	{
+		int count = 0;
+		for (; mask; mask &= mask - 1)
+			count++;
+		return count;
+	}
+}
+
+void MeshletCuller::Build(const MeshletData& data)
+{
+	meshletCount = data.Meshlets.size();
+	size_t padded = (meshletCount + 3) & ~(size_t)3;
+
+	std::vector<float>* soa[] = { &centerX, &centerY, &centerZ, &radius, &axisX, &axisY, &axisZ, &cutoff };
+	for (std::vector<float>* v : soa)
+		v->assign(padded, 0.0f);
+
+	indices.resize(data.Triangles.size());
+	indexOffsets.resize(meshletCount);
+	indexCounts.resize(meshletCount);
+
+	for (size_t i = 0; i < meshletCount; i++)
+	{
+		const Meshlet& m = data.Meshlets[i];
+		const MeshletBounds& b = data.Bounds[i];
+
+		centerX[i] = b.Center.x;
+		centerY[i] = b.Center.y;
+		centerZ[i] = b.Center.z;
+		radius[i] = b.Radius;
+		axisX[i] = b.ConeAxis.x;
+		axisY[i] = b.ConeAxis.y;
+		axisZ[i] = b.ConeAxis.z;
+		cutoff[i] = b.ConeCutoff;
+
+		indexOffsets[i] = m.TriangleOffset;
+		indexCounts[i] = m.TriangleCount * 3;
+		for (uint32_t t = 0; t < m.TriangleCount * 3; t++)
+			indices[m.TriangleOffset + t] = data.Vertices[m.VertexOffset + data.Triangles[m.TriangleOffset + t]];
+	}
+}
+
+size_t MeshletCuller::GetMeshletCount() const
+{
+	return meshletCount;
+}
+
+size_t MeshletCuller::GetMaxIndexCount() const
+{
+	return indices.size();
+}
+
+// --------------------------------------------------------
+// 4 meshlets per step:
+// - Frustum: the sphere has to be inside (or crossing) all 6 planes
+// - Backface: dot(C - cam, axis) >= cutoff * |C - cam| + radius
+//   means every triangle faces away
+// --------------------------------------------------------
+size_t MeshletCuller::Cull(const ClusterCullView& view, std::vector<uint32_t>& visibleMeshlets, ClusterCullStats* stats) const
+{
+	visibleMeshlets.clear();
+
+	const __m128 radiusScale = _mm_set1_ps(view.RadiusScale);
+	const __m128 camX = _mm_set1_ps(view.CameraPosition.x);
+	const __m128 camY = _mm_set1_ps(view.CameraPosition.y);
+	const __m128 camZ = _mm_set1_ps(view.CameraPosition.z);
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+
+	size_t written = 0;
+	size_t frustumCulled = 0;
+	size_t backfaceCulled = 0;
+
+	for (size_t i = 0; i < meshletCount; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(&centerX[i]);
+		__m128 cy = _mm_loadu_ps(&centerY[i]);
+		__m128 cz = _mm_loadu_ps(&centerZ[i]);
+		__m128 r = _mm_loadu_ps(&radius[i]);
+
+		//Plane distances are in world units, so the radius is scaled up to match
+		__m128 negWorldRadius = _mm_xor_ps(_mm_mul_ps(r, radiusScale), signBit);
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < 6; p++)
+		{
+			const XMFLOAT4& plane = view.Planes[p];
+			__m128 d = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+				_mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negWorldRadius));
+		}
+
+		int lanes = (int)(std::min)((size_t)4, meshletCount - i);
+		int laneMask = (1 << lanes) - 1;
+		int visible = _mm_movemask_ps(inside) & laneMask;
+		frustumCulled += CountBits(laneMask & ~visible);
+
+		if (view.ConeCulling && visible)
+		{
+			__m128 dx = _mm_sub_ps(cx, camX);
+			__m128 dy = _mm_sub_ps(cy, camY);
+			__m128 dz = _mm_sub_ps(cz, camZ);
+			__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+			__m128 along = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(dx, _mm_loadu_ps(&axisX[i])),
+				_mm_mul_ps(dy, _mm_loadu_ps(&axisY[i]))),
+				_mm_mul_ps(dz, _mm_loadu_ps(&axisZ[i])));
+			__m128 limit = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&cutoff[i]), distance), r);
+
+			int backfacing = _mm_movemask_ps(_mm_cmpge_ps(along, limit)) & visible;
+			backfaceCulled += CountBits(backfacing);
+			visible &= ~backfacing;
+		}
+
+		//List the survivors
+		for (; visible; visible &= visible - 1)
+		{
+			int lane = 0;
+			while (!(visible & (1 << lane)))
+				lane++;
+
+			size_t m = i + lane;
+			visibleMeshlets.push_back((uint32_t)m);
+			written += indexCounts[m];
+		}
+	}
+
+	if (stats)
+	{
+		stats->Meshlets = meshletCount;
+		stats->FrustumCulled = frustumCulled;
+		stats->BackfaceCulled = backfaceCulled;
+		stats->Triangles = written / 3;
+	}
+	return written;
+}
+
+void MeshletCuller::WriteIndices(const std::vector<uint32_t>& visibleMeshlets, unsigned int* out) const
+{
+	for (size_t v = 0; v < visibleMeshlets.size(); v++)
+	{
+		uint32_t m = visibleMeshlets[v];
+		memcpy(out, &indices[indexOffsets[m]], indexCounts[m] * sizeof(unsigned int));
+		out += indexCounts[m];
+	}
+}
+
+// --------------------------------------------------------
+// Moves the culling inputs into the mesh's space
+//
+// A plane goes from world to local space with the transpose of
+// the inverse of (world -> local), which is just the world matrix
+// applied to it as a column.  It stays unnormalized, so distances
+// keep coming out in world units
+// --------------------------------------------------------
+ClusterCullView MeshletCuller::MakeView(const XMFLOAT4 worldPlanes[6], XMFLOAT3 cameraPosition, const XMFLOAT4X4& world)
+{
+	ClusterCullView view;
+	for (int p = 0; p < 6; p++)
+	{
+		const XMFLOAT4& w = worldPlanes[p];
+		view.Planes[p] = XMFLOAT4(
+			world._11 * w.x + world._12 * w.y + world._13 * w.z + world._14 * w.w,
+			world._21 * w.x + world._22 * w.y + world._23 * w.z + world._24 * w.w,
+			world._31 * w.x + world._32 * w.y + world._33 * w.z + world._34 * w.w,
+			world._41 * w.x + world._42 * w.y + world._43 * w.z + world._44 * w.w);
+	}
+
+	XMMATRIX worldMatrix = XMLoadFloat4x4(&world);
+	XMVECTOR determinant;
+	XMMATRIX inverse = XMMatrixInverse(&determinant, worldMatrix);
+	XMStoreFloat3(&view.CameraPosition, XMVector3TransformCoord(XMLoadFloat3(&cameraPosition), inverse));
+
+	//Scale of each local axis
+	float sx = sqrtf(world._11 * world._11 + world._12 * world._12 + world._13 * world._13);
+	float sy = sqrtf(world._21 * world._21 + world._22 * world._22 + world._23 * world._23);
+	float sz = sqrtf(world._31 * world._31 + world._32 * world._32 + world._33 * world._33);
+	float maxScale = (std::max)(sx, (std::max)(sy, sz));
+	float minScale = (std::min)(sx, (std::min)(sy, sz));
+
+	view.RadiusScale = maxScale;
+	view.ConeCulling = XMVectorGetX(determinant) > 0.0f && maxScale - minScale <= maxScale * MaxScaleSkew;
+	return view;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <vector>
+#include "MeshletBuilder.h"
+
+// --------------------------------------------------------
+// Camera info in the mesh's own space, so meshlet bounds can
+// be tested without transforming them every frame
+//
+// - Planes: frustum planes pointing inwards, scaled so that
+//   dot(plane, localPoint) is the distance in world units
+// - RadiusScale: local -> world scale for the meshlet spheres
+// - ConeCulling: off when the world matrix scales unevenly or
+//   mirrors, since the cones no longer hold
+// --------------------------------------------------------
+struct ClusterCullView
+{
+	DirectX::XMFLOAT4 Planes[6];
+	DirectX::XMFLOAT3 CameraPosition;
+	float RadiusScale;
+	bool ConeCulling;
+};
+
+struct ClusterCullStats
+{
+	size_t Meshlets = 0;
+	size_t FrustumCulled = 0;
+	size_t BackfaceCulled = 0;
+	size_t Triangles = 0;			// Left after culling
+};
+
+// --------------------------------------------------------
+// CPU cluster culling for one mesh's meshlets
+//
+// The bounds are kept as SoA (x/y/z/radius/axis/cutoff arrays,
+// padded to a multiple of 4) and tested 4 meshlets at a time
+// with SSE.  Culling only lists the survivors; writing their
+// triangles out as one compacted index list, ready to draw
+// with the mesh's vertex buffer, is a separate step so callers
+// can size (or skip) the write first
+// --------------------------------------------------------
+class MeshletCuller
+{
+public:
+	void Build(const MeshletData& data);
+	size_t GetMeshletCount() const;
+	size_t GetMaxIndexCount() const;
+
+	// Lists every meshlet that survives in visibleMeshlets and returns how many indices
+	// they add up to (visibleMeshlets.size() == GetMeshletCount() means nothing was culled)
+	size_t Cull(const ClusterCullView& view, std::vector<uint32_t>& visibleMeshlets, ClusterCullStats* stats = nullptr) const;
+
+	// Writes the listed meshlets' indices to out, back to back
+	void WriteIndices(const std::vector<uint32_t>& visibleMeshlets, unsigned int* out) const;
+
+	// World space frustum planes (see Camera::GetFrustumPlanes) + camera position -> mesh space
+	static ClusterCullView MakeView(const DirectX::XMFLOAT4 worldPlanes[6], DirectX::XMFLOAT3 cameraPosition, const DirectX::XMFLOAT4X4& world);
+
+private:
+	size_t meshletCount = 0;
+
+	// SoA bounds, meshletCount rounded up to 4 (padding lanes are masked off)
+	std::vector<float> centerX, centerY, centerZ, radius;
+	std::vector<float> axisX, axisY, axisZ, cutoff;
+
+	// Each meshlet's triangles as mesh indices, laid out like MeshletData::Triangles
+	// so a surviving meshlet is a single copy
+	std::vector<unsigned int> indices;
+	std::vector<uint32_t> indexOffsets;
+	std::vector<uint32_t> indexCounts;
+};
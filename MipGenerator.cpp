@@ -0,0 +1,329 @@
+#include "MipGenerator.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace
+{
+	// sRGB byte -> linear
+	constexpr float SrgbToLinearTable[256] =
+	{
+		0.000000000f, 0.000303527f, 0.000607054f, 0.000910581f, 0.001214108f, 0.001517635f, 0.001821162f, 0.002124689f,
+		0.002428216f, 0.002731743f, 0.003035270f, 0.003346536f, 0.003676507f, 0.004024717f, 0.004391442f, 0.004776953f,
+		0.005181517f, 0.005605392f, 0.006048833f, 0.006512091f, 0.006995410f, 0.007499032f, 0.008023193f, 0.008568126f,
+		0.009134059f, 0.009721217f, 0.010329823f, 0.010960094f, 0.011612245f, 0.012286488f, 0.012983032f, 0.013702083f,
+		0.014443844f, 0.015208514f, 0.015996293f, 0.016807376f, 0.017641954f, 0.018500220f, 0.019382361f, 0.020288563f,
+		0.021219010f, 0.022173885f, 0.023153366f, 0.024157632f, 0.025186860f, 0.026241222f, 0.027320892f, 0.028426040f,
+		0.029556834f, 0.030713444f, 0.031896033f, 0.033104767f, 0.034339807f, 0.035601315f, 0.036889450f, 0.038204372f,
+		0.039546235f, 0.040915197f, 0.042311411f, 0.043735029f, 0.045186204f, 0.046665086f, 0.048171824f, 0.049706566f,
+		0.051269458f, 0.052860647f, 0.054480276f, 0.056128490f, 0.057805430f, 0.059511238f, 0.061246054f, 0.063010018f,
+		0.064803267f, 0.066625939f, 0.068478170f, 0.070360096f, 0.072271851f, 0.074213568f, 0.076185381f, 0.078187422f,
+		0.080219820f, 0.082282707f, 0.084376212f, 0.086500462f, 0.088655586f, 0.090841711f, 0.093058963f, 0.095307467f,
+		0.097587347f, 0.099898728f, 0.102241733f, 0.104616484f, 0.107023103f, 0.109461711f, 0.111932428f, 0.114435374f,
+		0.116970668f, 0.119538428f, 0.122138772f, 0.124771818f, 0.127437680f, 0.130136477f, 0.132868322f, 0.135633330f,
+		0.138431615f, 0.141263291f, 0.144128471f, 0.147027266f, 0.149959790f, 0.152926152f, 0.155926464f, 0.158960835f,
+		0.162029376f, 0.165132195f, 0.168269400f, 0.171441101f, 0.174647404f, 0.177888416f, 0.181164244f, 0.184474995f,
+		0.187820772f, 0.191201683f, 0.194617830f, 0.198069320f, 0.201556254f, 0.205078736f, 0.208636870f, 0.212230757f,
+		0.215860500f, 0.219526200f, 0.223227957f, 0.226965874f, 0.230740049f, 0.234550582f, 0.238397574f, 0.242281122f,
+		0.246201327f, 0.250158285f, 0.254152094f, 0.258182853f, 0.262250658f, 0.266355605f, 0.270497791f, 0.274677312f,
+		0.278894263f, 0.283148740f, 0.287440838f, 0.291770650f, 0.296138271f, 0.300543794f, 0.304987314f, 0.309468923f,
+		0.313988713f, 0.318546778f, 0.323143209f, 0.327778098f, 0.332451536f, 0.337163615f, 0.341914425f, 0.346704056f,
+		0.351532600f, 0.356400144f, 0.361306780f, 0.366252596f, 0.371237680f, 0.376262123f, 0.381326011f, 0.386429434f,
+		0.391572478f, 0.396755231f, 0.401977780f, 0.407240212f, 0.412542613f, 0.417885071f, 0.423267670f, 0.428690497f,
+		0.434153636f, 0.439657174f, 0.445201195f, 0.450785783f, 0.456411023f, 0.462077000f, 0.467783796f, 0.473531496f,
+		0.479320183f, 0.485149940f, 0.491020850f, 0.496932995f, 0.502886458f, 0.508881321f, 0.514917665f, 0.520995573f,
+		0.527115126f, 0.533276404f, 0.539479489f, 0.545724461f, 0.552011402f, 0.558340390f, 0.564711506f, 0.571124829f,
+		0.577580440f, 0.584078418f, 0.590618841f, 0.597201788f, 0.603827339f, 0.610495571f, 0.617206562f, 0.623960392f,
+		0.630757136f, 0.637596874f, 0.644479682f, 0.651405637f, 0.658374817f, 0.665387298f, 0.672443157f, 0.679542470f,
+		0.686685312f, 0.693871761f, 0.701101892f, 0.708375780f, 0.715693501f, 0.723055129f, 0.730460740f, 0.737910409f,
+		0.745404210f, 0.752942217f, 0.760524505f, 0.768151147f, 0.775822218f, 0.783537792f, 0.791297940f, 0.799102738f,
+		0.806952258f, 0.814846572f, 0.822785754f, 0.830769877f, 0.838799012f, 0.846873232f, 0.854992608f, 0.863157213f,
+		0.871367119f, 0.879622397f, 0.887923118f, 0.896269353f, 0.904661174f, 0.913098652f, 0.921581856f, 0.930110858f,
+		0.938685728f, 0.947306537f, 0.955973353f, 0.964686248f, 0.973445290f, 0.982250550f, 0.991102097f, 1.000000000f
+	};
+
+	// Linear value half way (in sRGB) between each pair of neighbouring bytes
+	constexpr float SrgbThresholds[255] =
+	{
+		0.000151763f, 0.000455290f, 0.000758817f, 0.001062344f, 0.001365871f, 0.001669398f, 0.001972925f, 0.002276452f,
+		0.002579979f, 0.002883506f, 0.003188301f, 0.003509259f, 0.003848315f, 0.004205748f, 0.004581833f, 0.004976837f,
+		0.005391024f, 0.005824651f, 0.006277969f, 0.006751228f, 0.007244668f, 0.007758530f, 0.008293048f, 0.008848453f,
+		0.009424971f, 0.010022826f, 0.010642237f, 0.011283421f, 0.011946592f, 0.012631960f, 0.013339732f, 0.014070112f,
+		0.014823303f, 0.015599503f, 0.016398910f, 0.017221716f, 0.018068115f, 0.018938294f, 0.019832443f, 0.020750745f,
+		0.021693383f, 0.022660538f, 0.023652390f, 0.024669115f, 0.025710888f, 0.026777883f, 0.027870270f, 0.028988221f,
+		0.030131902f, 0.031301481f, 0.032497122f, 0.033718988f, 0.034967242f, 0.036242044f, 0.037543553f, 0.038871926f,
+		0.040227319f, 0.041609888f, 0.043019785f, 0.044457163f, 0.045922173f, 0.047414964f, 0.048935685f, 0.050484484f,
+		0.052061507f, 0.053666898f, 0.055300801f, 0.056963360f, 0.058654717f, 0.060375011f, 0.062124384f, 0.063902973f,
+		0.065710916f, 0.067548351f, 0.069415413f, 0.071312236f, 0.073238956f, 0.075195705f, 0.077182615f, 0.079199818f,
+		0.081247445f, 0.083325624f, 0.085434486f, 0.087574157f, 0.089744766f, 0.091946438f, 0.094179300f, 0.096443477f,
+		0.098739092f, 0.101066270f, 0.103425133f, 0.105815802f, 0.108238401f, 0.110693048f, 0.113179865f, 0.115698970f,
+		0.118250482f, 0.120834520f, 0.123451200f, 0.126100640f, 0.128782955f, 0.131498261f, 0.134246673f, 0.137028306f,
+		0.139843272f, 0.142691686f, 0.145573660f, 0.148489305f, 0.151438734f, 0.154422057f, 0.157439385f, 0.160490827f,
+		0.163576493f, 0.166696492f, 0.169850932f, 0.173039920f, 0.176263564f, 0.179521971f, 0.182815248f, 0.186143498f,
+		0.189506829f, 0.192905345f, 0.196339151f, 0.199808350f, 0.203313045f, 0.206853340f, 0.210429338f, 0.214041140f,
+		0.217688849f, 0.221372565f, 0.225092389f, 0.228848422f, 0.232640764f, 0.236469515f, 0.240334772f, 0.244236636f,
+		0.248175205f, 0.252150577f, 0.256162849f, 0.260212118f, 0.264298482f, 0.268422037f, 0.272582879f, 0.276781103f,
+		0.281016805f, 0.285290081f, 0.289601024f, 0.293949728f, 0.298336289f, 0.302760799f, 0.307223352f, 0.311724040f,
+		0.316262956f, 0.320840192f, 0.325455841f, 0.330109993f, 0.334802740f, 0.339534173f, 0.344304382f, 0.349113458f,
+		0.353961491f, 0.358848570f, 0.363774785f, 0.368740224f, 0.373744977f, 0.378789131f, 0.383872775f, 0.388995998f,
+		0.394158885f, 0.399361525f, 0.404604005f, 0.409886411f, 0.415208830f, 0.420571347f, 0.425974050f, 0.431417022f,
+		0.436900350f, 0.442424119f, 0.447988412f, 0.453593316f, 0.459238914f, 0.464925290f, 0.470652528f, 0.476420711f,
+		0.482229923f, 0.488080246f, 0.493971763f, 0.499904557f, 0.505878709f, 0.511894303f, 0.517951419f, 0.524050139f,
+		0.530190544f, 0.536372716f, 0.542596734f, 0.548862680f, 0.555170635f, 0.561520677f, 0.567912887f, 0.574347344f,
+		0.580824128f, 0.587343319f, 0.593904994f, 0.600509233f, 0.607156115f, 0.613845717f, 0.620578117f, 0.627353395f,
+		0.634171626f, 0.641032889f, 0.647937261f, 0.654884819f, 0.661875640f, 0.668909801f, 0.675987377f, 0.683108445f,
+		0.690273081f, 0.697481362f, 0.704733362f, 0.712029156f, 0.719368822f, 0.726752432f, 0.734180063f, 0.741651788f,
+		0.749167683f, 0.756727821f, 0.764332277f, 0.771981125f, 0.779674438f, 0.787412289f, 0.795194753f, 0.803021903f,
+		0.810893811f, 0.818810550f, 0.826772194f, 0.834778813f, 0.842830482f, 0.850927271f, 0.859069253f, 0.867256499f,
+		0.875489082f, 0.883767073f, 0.892090542f, 0.900459561f, 0.908874202f, 0.917334534f, 0.925840628f, 0.934392556f,
+		0.942990386f, 0.951634190f, 0.960324036f, 0.969059996f, 0.977842139f, 0.986670534f, 0.995545250f
+	};
+
+	const double Pi = 3.14159265358979323846;
+
+	struct Tap
+	{
+		uint32_t Index;
+		float Weight;
+	};
+
+	// Source texels (and weights) for each texel of a smaller line.
+	// Taps for output i are All[First[i]] up to All[First[i + 1]]
+	struct TapTable
+	{
+		std::vector<uint32_t> First;
+		std::vector<Tap> All;
+	};
+
+	// Zeroth order modified Bessel function, for the Kaiser window
+	double BesselI0(double x)
+	{
+		double sum = 1.0, term = 1.0;
+		for (int k = 1; k < 32; k++)
+		{
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+			if (term < sum * 1e-12)
+				break;
+		}
+		return sum;
+	}
+
+	double Sinc(double x)
+	{
+		return fabs(x) < 1e-9 ? 1.0 : sin(Pi * x) / (Pi * x);
+	}
+
+	TapTable BuildTaps(uint32_t sourceSize, uint32_t size, const MipSettings& settings)
+	{
+		TapTable table;
+		double scale = (double)sourceSize / size;
+		double kaiserNorm = 1.0 / BesselI0(settings.KaiserAlpha);
+
+		for (uint32_t i = 0; i < size; i++)
+		{
+			table.First.push_back((uint32_t)table.All.size());
+			size_t first = table.All.size();
+			double total = 0.0;
+
+			if (settings.Filter == MipFilter::Box || sourceSize == size)
+			{
+				//Weight = how much of each source texel this texel covers
+				double low = i * scale, high = (i + 1) * scale;
+				for (int64_t j = (int64_t)floor(low); (double)j < high; j++)
+				{
+					double weight = (std::min)(high, (double)j + 1.0) - (std::max)(low, (double)j);
+					if (weight <= 0.0)
+						continue;
+					table.All.push_back({ (uint32_t)(std::min)((int64_t)sourceSize - 1, j), (float)weight });
+					total += weight;
+				}
+			}
+			else
+			{
+				//Sinc cut off at the smaller level's Nyquist rate, measured in its texels
+				double center = (i + 0.5) * scale;
+				double radius = settings.KaiserWidth * scale;
+				for (int64_t j = (int64_t)floor(center - radius); j <= (int64_t)ceil(center + radius); j++)
+				{
+					double t = (j + 0.5 - center) / scale;
+					double x = t / settings.KaiserWidth;
+					if (fabs(x) >= 1.0)
+						continue;
+
+					double weight = Sinc(t) * BesselI0(settings.KaiserAlpha * sqrt(1.0 - x * x)) * kaiserNorm;
+					int64_t index = settings.Wrap ? ((j % (int64_t)sourceSize) + sourceSize) % sourceSize : (std::min)((int64_t)sourceSize - 1, (std::max)((int64_t)0, j));
+					table.All.push_back({ (uint32_t)index, (float)weight });
+					total += weight;
+				}
+			}
+
+			for (size_t t = first; t < table.All.size(); t++)
+				table.All[t].Weight = (float)(table.All[t].Weight / total);
+		}
+		table.First.push_back((uint32_t)table.All.size());
+		return table;
+	}
+
+	// --------------------------------------------------------
+	// One level down: horizontal pass into a temporary, then the
+	// vertical pass.  Images are float RGBA
+	// --------------------------------------------------------
+	void Downsample(const std::vector<float>& source, uint32_t width, uint32_t height, std::vector<float>& result, uint32_t newWidth, uint32_t newHeight, const MipSettings& settings)
+	{
+		TapTable columns = BuildTaps(width, newWidth, settings);
+		TapTable rows = BuildTaps(height, newHeight, settings);
+
+		std::vector<float> horizontal((size_t)newWidth * height * 4);
+		ParallelForRange(height, 16, [&](size_t begin, size_t end, unsigned int)
+		{
+			for (size_t y = begin; y < end; y++)
+			{
+				const float* src = &source[y * width * 4];
+				float* dst = &horizontal[y * newWidth * 4];
+				for (uint32_t x = 0; x < newWidth; x++)
+				{
+					__m128 sum = _mm_setzero_ps();
+					for (uint32_t t = columns.First[x]; t < columns.First[x + 1]; t++)
+					{
+						const Tap& tap = columns.All[t];
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + tap.Index * 4), _mm_set1_ps(tap.Weight)));
+					}
+					_mm_storeu_ps(dst + x * 4, sum);
+				}
+			}
+		});
+
+		result.assign((size_t)newWidth * newHeight * 4, 0.0f);
+		ParallelForRange(newHeight, 16, [&](size_t begin, size_t end, unsigned int)
+		{
+			for (size_t y = begin; y < end; y++)
+			{
+				float* dst = &result[y * newWidth * 4];
+				for (uint32_t t = rows.First[y]; t < rows.First[y + 1]; t++)
+				{
+					const float* src = &horizontal[(size_t)rows.All[t].Index * newWidth * 4];
+					__m128 weight = _mm_set1_ps(rows.All[t].Weight);
+					for (uint32_t x = 0; x < newWidth; x++)
+						_mm_storeu_ps(dst + x * 4, _mm_add_ps(_mm_loadu_ps(dst + x * 4), _mm_mul_ps(_mm_loadu_ps(src + x * 4), weight)));
+				}
+			}
+		});
+	}
+
+	// Bytes -> the float values the filter works on
+	std::vector<float> Decode(const uint8_t* rgba, size_t pixelCount, const MipSettings& settings)
+	{
+		std::vector<float> values(pixelCount * 4);
+		for (size_t i = 0; i < pixelCount * 4; i++)
+		{
+			bool colour = (i & 3) != 3;
+			if (colour && settings.NormalMap)
+				values[i] = rgba[i] / 255.0f * 2.0f - 1.0f;
+			else if (colour && settings.SRGB)
+				values[i] = SrgbToLinearTable[rgba[i]];
+			else
+				values[i] = rgba[i] / 255.0f;
+		}
+		return values;
+	}
+
+	uint8_t ToByte(float value)
+	{
+		return (uint8_t)((std::min)(1.0f, (std::max)(0.0f, value)) * 255.0f + 0.5f);
+	}
+
+	void Encode(const std::vector<float>& values, size_t pixelCount, const MipSettings& settings, uint8_t* rgba)
+	{
+		ParallelForRange(pixelCount, 4096, [&](size_t begin, size_t end, unsigned int)
+		{
+			for (size_t p = begin; p < end; p++)
+			{
+				const float* v = &values[p * 4];
+				uint8_t* out = rgba + p * 4;
+
+				if (settings.NormalMap)
+				{
+					float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+					float scale = length > 1e-6f ? 1.0f / length : 0.0f;
+					for (int c = 0; c < 3; c++)
+						out[c] = ToByte(v[c] * scale * 0.5f + 0.5f);
+				}
+				else
+				{
+					for (int c = 0; c < 3; c++)
+						out[c] = settings.SRGB ? MipGenerator::LinearToSrgb(v[c]) : ToByte(v[c]);
+				}
+				out[3] = ToByte(v[3]);
+			}
+		});
+	}
+}
+
+std::vector<MipLevel> MipGenerator::Generate(const uint8_t* rgba, uint32_t width, uint32_t height, const MipSettings& settings)
+{
+	std::vector<MipLevel> levels;
+	levels.reserve(LevelCount(width, height));
+
+	MipLevel top;
+	top.Width = width;
+	top.Height = height;
+	top.Pixels.assign(rgba, rgba + (size_t)width * height * 4);
+	levels.push_back(std::move(top));
+
+	std::vector<float> current = Decode(rgba, (size_t)width * height, settings);
+	std::vector<float> next;
+	while (width > 1 || height > 1)
+	{
+		uint32_t newWidth = (std::max)(1u, width / 2);
+		uint32_t newHeight = (std::max)(1u, height / 2);
+		Downsample(current, width, height, next, newWidth, newHeight, settings);
+
+		MipLevel level;
+		level.Width = newWidth;
+		level.Height = newHeight;
+		level.Pixels.resize((size_t)newWidth * newHeight * 4);
+		Encode(next, (size_t)newWidth * newHeight, settings, level.Pixels.data());
+		levels.push_back(std::move(level));
+
+		current.swap(next);
+		width = newWidth;
+		height = newHeight;
+	}
+	return levels;
+}
+
+uint32_t MipGenerator::LevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t count = 1;
+	while (width > 1 || height > 1)
+	{
+		width = (std::max)(1u, width / 2);
+		height = (std::max)(1u, height / 2);
+		count++;
+	}
+	return count;
+}
+
+float MipGenerator::SrgbToLinear(uint8_t value)
+{
+	return SrgbToLinearTable[value];
+}
+
+// The byte is how many boundaries the value is past
+uint8_t MipGenerator::LinearToSrgb(float value)
+{
+	int low = 0, high = 255;
+	while (low < high)
+	{
+		int middle = (low + high) / 2;
+		if (value > SrgbThresholds[middle])
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return (uint8_t)low;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+enum class MipFilter
+{
+	Box,		// Average of the texels each mip texel covers
+	Kaiser		// Kaiser-windowed sinc - sharper, keeps more detail in the smaller mips
+};
+
+struct MipSettings
+{
+	MipFilter Filter = MipFilter::Box;
+	bool SRGB = false;			// RGB is sRGB encoded - filter in linear space (alpha never is)
+	bool NormalMap = false;		// RGB is a [-1, 1] vector - renormalised after filtering
+	bool Wrap = true;			// Filter across the edges like a wrapping sampler does (Kaiser only)
+
+	float KaiserAlpha = 4.0f;
+	float KaiserWidth = 3.0f;	// Half width, in texels of the smaller level
+};
+
+struct MipLevel
+{
+	uint32_t Width;
+	uint32_t Height;
+	std::vector<uint8_t> Pixels;	// RGBA8
+};
+
+// --------------------------------------------------------
+// Builds a full mip chain on the CPU, so cooked textures can
+// carry their mips (block-compressed textures can't use
+// GenerateMips)
+//
+// - Every level is filtered from the one above it in float,
+//   so rounding doesn't build up down the chain
+// - sRGB decode is a table lookup and encode a search of the
+//   byte boundaries, both from constexpr tables
+// - Separable filter, one texel (RGBA) per SSE register, with
+//   rows split across worker threads
+// --------------------------------------------------------
+class MipGenerator
+{
+public:
+	// levels[0] is a copy of the source; the last level is 1x1
+	static std::vector<MipLevel> Generate(const uint8_t* rgba, uint32_t width, uint32_t height, const MipSettings& settings);
+
+	static uint32_t LevelCount(uint32_t width, uint32_t height);
+
+	static float SrgbToLinear(uint8_t value);
+	static uint8_t LinearToSrgb(float value);
+};
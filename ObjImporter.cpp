@@ -0,0 +1,707 @@
+#include "ObjImporter.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <fstream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OBJ_USE_SSE2 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Outside of MSVC the plain versions behave the same for %f/%d
+#ifndef _MSC_VER
+#define sscanf_s sscanf
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	//Files smaller than this aren't worth splitting across threads
+	const size_t MinBytesPerWorker = 512 * 1024;
+
+	// --------------------------------------------------------
+	// Per-thread results for one line-aligned range of the file
+	// --------------------------------------------------------
+	struct ObjChunk
+	{
+		const char* Begin = nullptr;
+		const char* End = nullptr;
+		ObjData Data;
+
+		// Slots (corner * 3 + component) holding negative OBJ indices, which were
+		// resolved against this chunk's local counts and still need the chunk's offset
+		std::vector<size_t> RelativeSlots;
+
+		size_t Lines = 0;
+		bool Failed = false;
+	};
+
+#if OBJ_USE_SSE2
+	inline unsigned int FirstSetBit(unsigned int mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (unsigned int)index;
+#else
+		return (unsigned int)__builtin_ctz(mask);
+#endif
+	}
+#endif
+
+	// --------------------------------------------------------
+	// Finds the next '\n' at or after p (or end), 16 bytes at a time
+	// --------------------------------------------------------
+	const char* FindLineEnd(const char* p, const char* end)
+	{
+#if OBJ_USE_SSE2
+		const __m128i newline = _mm_set1_epi8('\n');
+		while (end - p >= 16)
+		{
+			__m128i bytes = _mm_loadu_si128((const __m128i*)p);
+			unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline));
+			if (mask)
+				return p + FirstSetBit(mask);
+			p += 16;
+		}
+#endif
+		while (p < end && *p != '\n')
+			p++;
+		return p;
+	}
+
+	inline bool IsBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	// --------------------------------------------------------
+	// Skips spaces/tabs up to the start of the next token
+	//
+	// Tokens are usually separated by one space, so that case is
+	// checked directly before going wide for longer padding
+	// --------------------------------------------------------
+	const char* SkipBlanks(const char* p, const char* end)
+	{
+		if (p >= end || !IsBlank(*p)) return p;
+		p++;
+		if (p >= end || !IsBlank(*p)) return p;
+
+#if OBJ_USE_SSE2
+		const __m128i space = _mm_set1_epi8(' ');
+		const __m128i tab = _mm_set1_epi8('\t');
+		const __m128i cr = _mm_set1_epi8('\r');
+		while (end - p >= 16)
+		{
+			__m128i bytes = _mm_loadu_si128((const __m128i*)p);
+			__m128i blank = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab)),
+				_mm_cmpeq_epi8(bytes, cr));
+			unsigned int notBlank = ~(unsigned int)_mm_movemask_epi8(blank) & 0xFFFF;
+			if (notBlank)
+				return p + FirstSetBit(notBlank);
+			p += 16;
+		}
+#endif
+		while (p < end && IsBlank(*p))
+			p++;
+		return p;
+	}
+
+	inline bool IsDigit(char c)
+	{
+		return (unsigned char)(c - '0') < 10;
+	}
+
+	// --------------------------------------------------------
+	// Powers of ten that doubles represent exactly
+	// --------------------------------------------------------
+	const double ExactPowersOfTen[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	inline double PowerOfTen(int exponent)
+	{
+		if (exponent <= 22)
+			return ExactPowersOfTen[exponent];
+		return std::pow(10.0, exponent);
+	}
+
+	// --------------------------------------------------------
+	// Locale-independent float parser for [+-]digits[.digits][e[+-]digits]
+	//
+	// Returns the character after the number, or nullptr if there was no number
+	// --------------------------------------------------------
+	const char* ParseFloat(const char* p, const char* end, float& out)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			p++;
+		}
+
+		//Up to 19 significant digits fit in 64 bits; the rest only shift the exponent
+		uint64_t mantissa = 0;
+		int significantDigits = 0;
+		int exponent = 0;
+		bool anyDigits = false;
+
+		while (p < end && IsDigit(*p))
+		{
+			if (significantDigits < 19)
+			{
+				mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+				if (mantissa != 0) significantDigits++;
+			}
+			else
+				exponent++;
+			anyDigits = true;
+			p++;
+		}
+
+		if (p < end && *p == '.')
+		{
+			p++;
+			while (p < end && IsDigit(*p))
+			{
+				if (significantDigits < 19)
+				{
+					mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+					if (mantissa != 0) significantDigits++;
+					exponent--;
+				}
+				anyDigits = true;
+				p++;
+			}
+		}
+
+		if (!anyDigits)
+			return nullptr;
+
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			const char* e = p + 1;
+			bool negativeExponent = false;
+			if (e < end && (*e == '-' || *e == '+'))
+			{
+				negativeExponent = *e == '-';
+				e++;
+			}
+
+			//Only treat it as an exponent if digits follow
+			if (e < end && IsDigit(*e))
+			{
+				int value = 0;
+				while (e < end && IsDigit(*e))
+				{
+					if (value < 10000) value = value * 10 + (*e - '0');
+					e++;
+				}
+				exponent += negativeExponent ? -value : value;
+				p = e;
+			}
+		}
+
+		double value = (double)mantissa;
+		if (exponent < 0)
+			value /= PowerOfTen(-exponent);
+		else if (exponent > 0)
+			value *= PowerOfTen(exponent);
+
+		out = (float)(negative ? -value : value);
+		return p;
+	}
+
+	// --------------------------------------------------------
+	// Parses a signed integer - returns nullptr if there wasn't one
+	// or it doesn't fit in an int
+	// --------------------------------------------------------
+	const char* ParseInt(const char* p, const char* end, int& out)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			p++;
+		}
+
+		if (p >= end || !IsDigit(*p))
+			return nullptr;
+
+		int value = 0;
+		while (p < end && IsDigit(*p))
+		{
+			//Past INT_MAX it can't be an index into anything - treat it as malformed
+			int digit = *p - '0';
+			if (value > (INT_MAX - digit) / 10)
+				return nullptr;
+			value = value * 10 + digit;
+			p++;
+		}
+
+		out = negative ? -value : value;
+		return p;
+	}
+
+	// --------------------------------------------------------
+	// Parses up to "count" floats from a line - returns how many were read
+	// --------------------------------------------------------
+	int ParseFloats(const char* p, const char* end, float* values, int count)
+	{
+		int read = 0;
+		while (read < count)
+		{
+			p = SkipBlanks(p, end);
+			const char* next = ParseFloat(p, end, values[read]);
+			if (!next) break;
+			p = next;
+			read++;
+		}
+		return read;
+	}
+
+	// --------------------------------------------------------
+	// Converts an OBJ index (1-based, or negative for relative)
+	// to a zero-based one
+	//
+	// Returns false for 0, which OBJ doesn't allow
+	// --------------------------------------------------------
+	inline bool ResolveIndex(int objIndex, size_t localCount, int& resolved, bool& relative)
+	{
+		relative = false;
+		if (objIndex > 0)
+		{
+			resolved = objIndex - 1;
+			return true;
+		}
+		if (objIndex < 0)
+		{
+			//Relative to what this chunk has seen - the chunk offset gets added when merging
+			resolved = (int)localCount + objIndex;
+			relative = true;
+			return true;
+		}
+		return false;
+	}
+
+	// --------------------------------------------------------
+	// Parses an "f" line and fans it into triangles
+	// --------------------------------------------------------
+	bool ParseFace(const char* p, const char* end, ObjChunk& chunk, std::vector<ObjIndex>& polygon, std::vector<unsigned char>& relativeMasks)
+	{
+		ObjData& data = chunk.Data;
+		polygon.clear();
+		relativeMasks.clear();
+
+		while (true)
+		{
+			p = SkipBlanks(p, end);
+			if (p >= end)
+				break;
+
+			int position = 0;
+			int uv = 0;
+			int normal = 0;
+			bool hasUV = false;
+			bool hasNormal = false;
+
+			//Accepts "p", "p/t", "p//n" and "p/t/n"
+			p = ParseInt(p, end, position);
+			if (!p) return false;
+			if (p < end && *p == '/')
+			{
+				p++;
+				if (p < end && *p != '/')
+				{
+					p = ParseInt(p, end, uv);
+					if (!p) return false;
+					hasUV = true;
+				}
+				if (p < end && *p == '/')
+				{
+					p++;
+					p = ParseInt(p, end, normal);
+					if (!p) return false;
+					hasNormal = true;
+				}
+			}
+
+			ObjIndex corner = { -1, -1, -1 };
+			unsigned char mask = 0;
+			bool relative;
+
+			if (!ResolveIndex(position, data.Positions.size(), corner.Position, relative)) return false;
+			if (relative) mask |= 1;
+			if (hasUV)
+			{
+				if (!ResolveIndex(uv, data.UVs.size(), corner.UV, relative)) return false;
+				if (relative) mask |= 2;
+			}
+			if (hasNormal)
+			{
+				if (!ResolveIndex(normal, data.Normals.size(), corner.Normal, relative)) return false;
+				if (relative) mask |= 4;
+			}
+
+			polygon.push_back(corner);
+			relativeMasks.push_back(mask);
+		}
+
+		if (polygon.size() < 3)
+			return false;
+
+		//Fan from the first corner: (0, k, k+1)
+		for (size_t k = 1; k + 1 < polygon.size(); k++)
+		{
+			size_t fan[3] = { 0, k, k + 1 };
+			for (int c = 0; c < 3; c++)
+			{
+				size_t slot = data.Corners.size() * 3;
+				unsigned char mask = relativeMasks[fan[c]];
+				for (int component = 0; component < 3; component++)
+				{
+					if (mask & (1 << component))
+						chunk.RelativeSlots.push_back(slot + component);
+				}
+				data.Corners.push_back(polygon[fan[c]]);
+			}
+		}
+
+		return true;
+	}
+
+	// --------------------------------------------------------
+	// Parses every line in a chunk's range
+	// --------------------------------------------------------
+	void ParseChunk(ObjChunk& chunk)
+	{
+		ObjData& data = chunk.Data;
+		std::vector<ObjIndex> polygon;
+		std::vector<unsigned char> relativeMasks;
+
+		//Rough guess (~30 bytes per line) so the vectors don't regrow constantly
+		size_t estimatedLines = (size_t)(chunk.End - chunk.Begin) / 30;
+		data.Positions.reserve(estimatedLines / 3);
+		data.Normals.reserve(estimatedLines / 3);
+		data.UVs.reserve(estimatedLines / 3);
+		data.Corners.reserve(estimatedLines);
+
+		const char* p = chunk.Begin;
+		while (p < chunk.End)
+		{
+			const char* lineEnd = FindLineEnd(p, chunk.End);
+			const char* line = SkipBlanks(p, lineEnd);
+			chunk.Lines++;
+
+			if (lineEnd - line >= 2)
+			{
+				char c0 = line[0];
+				char c1 = line[1];
+
+				if (c0 == 'v' && IsBlank(c1))
+				{
+					XMFLOAT3 pos(0, 0, 0);
+					if (ParseFloats(line + 2, lineEnd, &pos.x, 3) != 3) { chunk.Failed = true; return; }
+					data.Positions.push_back(pos);
+				}
+				else if (c0 == 'v' && c1 == 't')
+				{
+					//Third (w) coordinate is allowed but unused
+					XMFLOAT2 uv(0, 0);
+					if (ParseFloats(line + 2, lineEnd, &uv.x, 2) < 1) { chunk.Failed = true; return; }
+					data.UVs.push_back(uv);
+				}
+				else if (c0 == 'v' && c1 == 'n')
+				{
+					XMFLOAT3 norm(0, 0, 0);
+					if (ParseFloats(line + 2, lineEnd, &norm.x, 3) != 3) { chunk.Failed = true; return; }
+					data.Normals.push_back(norm);
+				}
+				else if (c0 == 'f' && IsBlank(c1))
+				{
+					if (!ParseFace(line + 2, lineEnd, chunk, polygon, relativeMasks)) { chunk.Failed = true; return; }
+				}
+			}
+
+			p = lineEnd + 1;
+		}
+	}
+
+	// -1 is only ever "not given" by now - relative indices that went negative were rejected while merging
+	inline bool InRange(int index, size_t count, bool optional)
+	{
+		if (index == -1) return optional;
+		return index >= 0 && (size_t)index < count;
+	}
+
+	double SecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+// --------------------------------------------------------
+// Maps the file and parses it
+//
+// fileName - Path to the .obj file
+// out - Receives the parsed data
+// stats - Optional timing info (includes mapping the file)
+// --------------------------------------------------------
+bool ObjImporter::Load(const char* fileName, ObjData& out, ObjImportStats* stats)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	MappedFile file(fileName);
+	if (!file.IsOpen())
+		return false;
+
+	bool result = Parse((const char*)file.GetData(), file.GetSize(), out, stats);
+
+	if (stats)
+		stats->Seconds = SecondsSince(start);
+
+	return result;
+}
+
+// --------------------------------------------------------
+// Parses OBJ text, splitting it across threads if it's large
+// --------------------------------------------------------
+bool ObjImporter::Parse(const char* text, size_t length, ObjData& out, ObjImportStats* stats)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	out = ObjData();
+	if (text == nullptr || length == 0)
+		return false;
+
+	const char* end = text + length;
+
+	//Split into line-aligned ranges, one per worker
+	size_t chunkCount = length / MinBytesPerWorker;
+	if (chunkCount < 1) chunkCount = 1;
+	if (chunkCount > GetWorkerCount()) chunkCount = GetWorkerCount();
+
+	std::vector<ObjChunk> chunks(chunkCount);
+	const char* chunkStart = text;
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		const char* chunkEnd = end;
+		if (i + 1 < chunkCount)
+		{
+			//Push the split point to just past the next newline
+			chunkEnd = FindLineEnd(text + (length * (i + 1)) / chunkCount, end);
+			if (chunkEnd < end) chunkEnd++;
+			if (chunkEnd < chunkStart) chunkEnd = chunkStart;
+		}
+
+		chunks[i].Begin = chunkStart;
+		chunks[i].End = chunkEnd;
+		chunkStart = chunkEnd;
+	}
+
+	unsigned int workers = ParallelFor(chunkCount, [&](size_t i) { ParseChunk(chunks[i]); });
+
+	//Merge - chunk offsets are the running totals of everything before it
+	size_t totalPositions = 0, totalUVs = 0, totalNormals = 0, totalCorners = 0, totalLines = 0;
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		if (chunks[i].Failed)
+			return false;
+
+		totalPositions += chunks[i].Data.Positions.size();
+		totalUVs += chunks[i].Data.UVs.size();
+		totalNormals += chunks[i].Data.Normals.size();
+		totalCorners += chunks[i].Data.Corners.size();
+		totalLines += chunks[i].Lines;
+	}
+
+	out.Positions.reserve(totalPositions);
+	out.UVs.reserve(totalUVs);
+	out.Normals.reserve(totalNormals);
+	out.Corners.reserve(totalCorners);
+
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		ObjChunk& chunk = chunks[i];
+		int offsets[3] = { (int)out.Positions.size(), (int)out.UVs.size(), (int)out.Normals.size() };
+
+		//Only relative indices can end up negative, so they're checked here - after this, -1 means "not given"
+		for (size_t r = 0; r < chunk.RelativeSlots.size(); r++)
+		{
+			size_t slot = chunk.RelativeSlots[r];
+			ObjIndex& corner = chunk.Data.Corners[slot / 3];
+			int* index = slot % 3 == 0 ? &corner.Position : slot % 3 == 1 ? &corner.UV : &corner.Normal;
+			*index += offsets[slot % 3];
+			if (*index < 0)
+				return false;
+		}
+
+		out.Positions.insert(out.Positions.end(), chunk.Data.Positions.begin(), chunk.Data.Positions.end());
+		out.UVs.insert(out.UVs.end(), chunk.Data.UVs.begin(), chunk.Data.UVs.end());
+		out.Normals.insert(out.Normals.end(), chunk.Data.Normals.begin(), chunk.Data.Normals.end());
+		out.Corners.insert(out.Corners.end(), chunk.Data.Corners.begin(), chunk.Data.Corners.end());
+	}
+
+	//Every index has to point at something that exists
+	for (size_t c = 0; c < out.Corners.size(); c++)
+	{
+		const ObjIndex& corner = out.Corners[c];
+		if (!InRange(corner.Position, out.Positions.size(), false) ||
+			!InRange(corner.UV, out.UVs.size(), true) ||
+			!InRange(corner.Normal, out.Normals.size(), true))
+			return false;
+	}
+
+	if (stats)
+	{
+		stats->FileBytes = length;
+		stats->Lines = totalLines;
+		stats->Workers = workers;
+		stats->Seconds = SecondsSince(start);
+	}
+
+	return true;
+}
+
+// --------------------------------------------------------
+// The previous loader (getline into a 100 char buffer + sscanf_s),
+// kept only as the baseline for Benchmark()
+// --------------------------------------------------------
+bool ObjImporter::ParseLegacy(const char* fileName, ObjData& out)
+{
+	out = ObjData();
+
+	std::ifstream obj(fileName);
+	if (!obj.is_open())
+		return false;
+
+	char chars[100];
+	while (obj.good())
+	{
+		obj.getline(chars, 100);
+
+		if (chars[0] == 'v' && chars[1] == 'n')
+		{
+			XMFLOAT3 norm;
+			sscanf_s(chars, "vn %f %f %f", &norm.x, &norm.y, &norm.z);
+			out.Normals.push_back(norm);
+		}
+		else if (chars[0] == 'v' && chars[1] == 't')
+		{
+			XMFLOAT2 uv;
+			sscanf_s(chars, "vt %f %f", &uv.x, &uv.y);
+			out.UVs.push_back(uv);
+		}
+		else if (chars[0] == 'v')
+		{
+			XMFLOAT3 pos;
+			sscanf_s(chars, "v %f %f %f", &pos.x, &pos.y, &pos.z);
+			out.Positions.push_back(pos);
+		}
+		else if (chars[0] == 'f')
+		{
+			int i[12];
+			int numbersRead = sscanf_s(
+				chars,
+				"f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
+				&i[0], &i[1], &i[2],
+				&i[3], &i[4], &i[5],
+				&i[6], &i[7], &i[8],
+				&i[9], &i[10], &i[11]);
+
+			if (numbersRead == 1)
+			{
+				numbersRead = sscanf_s(
+					chars,
+					"f %d//%d %d//%d %d//%d %d//%d",
+					&i[0], &i[2],
+					&i[3], &i[5],
+					&i[6], &i[8],
+					&i[9], &i[11]);
+				i[1] = i[4] = i[7] = i[10] = 0;
+			}
+
+			ObjIndex c[4];
+			for (int k = 0; k < 4; k++)
+				c[k] = { i[k * 3] - 1, i[k * 3 + 1] - 1, i[k * 3 + 2] - 1 };
+
+			out.Corners.push_back(c[0]);
+			out.Corners.push_back(c[1]);
+			out.Corners.push_back(c[2]);
+			if (numbersRead == 12 || numbersRead == 8)
+			{
+				out.Corners.push_back(c[0]);
+				out.Corners.push_back(c[2]);
+				out.Corners.push_back(c[3]);
+			}
+		}
+	}
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Runs both loaders "iterations" times on the same file and
+// prints the best throughput of each
+// --------------------------------------------------------
+bool ObjImporter::Benchmark(const char* fileName, int iterations)
+{
+	if (iterations < 1) iterations = 1;
+
+	MappedFile file(fileName);
+	if (!file.IsOpen())
+	{
+		printf("ObjImporter::Benchmark - couldn't open '%s'\n", fileName);
+		return false;
+	}
+	double megabytes = file.GetSize() / (1024.0 * 1024.0);
+	file.Close();
+
+	double bestNew = 1e30;
+	double bestLegacy = 1e30;
+	ObjData newData;
+	ObjData legacyData;
+	ObjImportStats stats;
+
+	for (int i = 0; i < iterations; i++)
+	{
+		if (!Load(fileName, newData, &stats))
+		{
+			printf("ObjImporter::Benchmark - '%s' failed to parse\n", fileName);
+			return false;
+		}
+		if (stats.Seconds < bestNew) bestNew = stats.Seconds;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		ParseLegacy(fileName, legacyData);
+		double legacySeconds = SecondsSince(start);
+		if (legacySeconds < bestLegacy) bestLegacy = legacySeconds;
+	}
+
+	printf("OBJ import benchmark: %s (%.2f MB, %zu lines, best of %d)\n", fileName, megabytes, stats.Lines, iterations);
+	printf("  getline/sscanf : %8.2f ms  %8.1f MB/s\n", bestLegacy * 1000.0, megabytes / bestLegacy);
+	printf("  ObjImporter    : %8.2f ms  %8.1f MB/s  (%u threads)\n", bestNew * 1000.0, megabytes / bestNew, stats.Workers);
+	printf("  speedup        : %8.2fx\n", bestLegacy / bestNew);
+
+	//The old loader truncates long lines and only handles tris/quads, so counts can legitimately differ
+	if (newData.Positions.size() != legacyData.Positions.size() || newData.Corners.size() != legacyData.Corners.size())
+	{
+		printf("  note: outputs differ (positions %zu vs %zu, corners %zu vs %zu)\n",
+			newData.Positions.size(), legacyData.Positions.size(),
+			newData.Corners.size(), legacyData.Corners.size());
+	}
+	return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <vector>
+
+// --------------------------------------------------------
+// One corner of an OBJ face - zero-based indices into the
+// position/uv/normal lists, or -1 if the file left it out
+// --------------------------------------------------------
+struct ObjIndex
+{
+	int Position;
+	int UV;
+	int Normal;
+};
+
+// --------------------------------------------------------
+// Raw contents of an OBJ file
+//
+// - Corners holds 3 entries per triangle, in file order and
+//   file winding (polygons are fanned from their first corner)
+// - No handedness conversion has been applied yet; that's
+//   up to whoever builds vertices from this (see Mesh)
+// --------------------------------------------------------
+struct ObjData
+{
+	std::vector<DirectX::XMFLOAT3> Positions;
+	std::vector<DirectX::XMFLOAT2> UVs;
+	std::vector<DirectX::XMFLOAT3> Normals;
+	std::vector<ObjIndex> Corners;
+};
+
+// --------------------------------------------------------
+// Timing info from a single import
+// --------------------------------------------------------
+struct ObjImportStats
+{
+	size_t FileBytes = 0;
+	size_t Lines = 0;
+	unsigned int Workers = 0;
+	double Seconds = 0.0;
+
+	double MegabytesPerSecond() const { return Seconds > 0.0 ? (FileBytes / (1024.0 * 1024.0)) / Seconds : 0.0; }
+};
+
+// --------------------------------------------------------
+// Fast OBJ importer
+//
+// - Memory maps the file instead of streaming it
+// - Uses SSE2 to find line and token boundaries
+// - Parses numbers with a locale-independent parser
+// - Large files are split into line-aligned ranges that
+//   are parsed on separate threads and merged afterwards
+// - Supports v/vt/vn/f lines, polygons of any size, and
+//   negative (relative) indices; everything else is skipped
+// --------------------------------------------------------
+class ObjImporter
+{
+public:
+	// Loads and parses a file - returns false if it can't be opened or is malformed
+	static bool Load(const char* fileName, ObjData& out, ObjImportStats* stats = nullptr);
+
+	// Parses OBJ text that's already in memory
+	static bool Parse(const char* text, size_t length, ObjData& out, ObjImportStats* stats = nullptr);
+
+	// Times this importer against the old getline/sscanf loader on the given
+	// file and prints MB/s for both - needs no graphics device, so it can run
+	// headless (see MeshBenchmarkMain.cpp).  False if the file didn't load
+	static bool Benchmark(const char* fileName, int iterations);
+
+private:
+	static bool ParseLegacy(const char* fileName, ObjData& out);
+};
@@ -0,0 +1,50 @@
+#include "ShaderIncludes.hlsli"
+
+//Same camera and object buffers as VertexShader, so the same structs fill them
+cbuffer PerFrame : register(b0)
+{
+	matrix view;
+	matrix projection;
+}
+
+cbuffer PerObject : register(b1)
+{
+	matrix world;
+	matrix worldInvTranspose;
+}
+
+//The mesh's VertexQuantization (Unorm16VertexFormat) - stored values are [0,1] across these ranges
+cbuffer PerMesh : register(b2)
+{
+	float3 positionOffset;
+	float3 positionScale;
+	float2 uvOffset;
+	float2 uvScale;
+}
+
+// --------------------------------------------------------
+// VertexShader for 20 byte packed vertices - unpacks them
+// into the same VertexToPixel, so PixelShader works with
+// either one
+// --------------------------------------------------------
+VertexToPixel main( PackedVertexShaderInput input )
+{
+	VertexToPixel output;
+
+	float3 localPosition = positionOffset + input.localPosition.xyz * positionScale;
+	float handedness = input.localPosition.w * 2.0f - 1.0f;	//Unorm 0/1 -> -1/+1
+	float3 normal = DecodeOctahedral(input.normal);
+	float3 tangent = DecodeOctahedral(input.tangent);
+
+	matrix wvp = mul(projection, mul(view, world));
+	output.screenPosition = mul(wvp, float4(localPosition, 1.0f));
+
+	output.normal = mul((float3x3)worldInvTranspose, normal);
+	output.tangent = float4(mul((float3x3)worldInvTranspose, tangent), handedness);
+
+	output.worldPosition = mul(world, float4(localPosition, 1)).xyz;
+
+	output.uv = uvOffset + input.uv * uvScale;
+
+	return output;
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// Small helpers for splitting CPU work across cores
+//
+// - Threads are created per call, which is fine for the
+//   load-time and offline work these are used for
+// - The calling thread always does a share of the work
+// - Calls made from inside another call's work stay on their
+//   thread, so splitting at two levels (e.g. the asset cooker
+//   running textures in parallel, each split into rows) doesn't
+//   start cores * cores threads
+// --------------------------------------------------------
+
+// --------------------------------------------------------
+// Forces GetWorkerCount (0 = one per core) - for measuring
+// how work scales with threads, not for normal runs
+// --------------------------------------------------------
+inline unsigned int& WorkerCountOverride()
+{
+	static unsigned int workers = 0;
+	return workers;
+}
+
+// --------------------------------------------------------
+// Number of threads worth using (at least 1)
+// --------------------------------------------------------
+inline unsigned int GetWorkerCount()
+{
+	if (WorkerCountOverride() > 0)
+		return WorkerCountOverride();
+
+	unsigned int count = std::thread::hardware_concurrency();
+	return count == 0 ? 1 : count;
+}
+
+// --------------------------------------------------------
+// Whether this thread is running work handed out by a
+// ParallelFor/ParallelForRange that went wide
+// --------------------------------------------------------
+inline bool& InsideParallelWork()
+{
+	static thread_local bool inside = false;
+	return inside;
+}
+
+// Marks the current thread as a worker until the end of the scope
+struct ParallelWorkScope
+{
+	bool previous;
+
+	ParallelWorkScope() : previous(InsideParallelWork()) { InsideParallelWork() = true; }
+	~ParallelWorkScope() { InsideParallelWork() = previous; }
+};
+
+// --------------------------------------------------------
+// How many workers ParallelForRange will split count items
+// between (1 = it runs them all on the calling thread)
+// --------------------------------------------------------
+inline unsigned int GetRangeWorkerCount(size_t count, size_t minPerWorker)
+{
+	if (InsideParallelWork())
+		return 1;
+
+	if (minPerWorker == 0) minPerWorker = 1;
+	size_t maxWorkers = (count + minPerWorker - 1) / minPerWorker;
+	return (unsigned int)std::max<size_t>(1, std::min<size_t>(GetWorkerCount(), maxWorkers));
+}
+
+// --------------------------------------------------------
+// Splits [0, count) into one contiguous range per worker
+//
+// count - Number of items
+// minPerWorker - Don't bother with another thread for fewer items than this
+// func - Called as func(begin, end, workerIndex)
+//
+// Returns the number of workers used
+// --------------------------------------------------------
+template<typename Func>
+unsigned int ParallelForRange(size_t count, size_t minPerWorker, Func func)
+{
+	if (count == 0)
+		return 0;
+
+	unsigned int workers = GetRangeWorkerCount(count, minPerWorker);
+	if (workers <= 1)
+	{
+		func((size_t)0, count, 0u);
+		return 1;
+	}
+
+	std::vector<std::thread> threads;
+	size_t perWorker = (count + workers - 1) / workers;
+	for (unsigned int w = 1; w < workers; w++)
+	{
+		size_t begin = std::min(count, w * perWorker);
+		size_t end = std::min(count, begin + perWorker);
+		threads.emplace_back([&func, begin, end, w]()
+		{
+			ParallelWorkScope scope;
+			func(begin, end, w);
+		});
+	}
+
+	//First range on this thread
+	{
+		ParallelWorkScope scope;
+		func((size_t)0, std::min(count, perWorker), 0u);
+	}
+
+	for (size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	return workers;
+}
+
+// --------------------------------------------------------
+// Runs func(index) for every index in [0, count), handing
+// out indices dynamically so uneven items balance out
+//
+// Returns the number of workers used
+// --------------------------------------------------------
+template<typename Func>
+unsigned int ParallelFor(size_t count, Func func)
+{
+	if (count == 0)
+		return 0;
+
+	unsigned int workers = InsideParallelWork() ? 1 : (unsigned int)std::min<size_t>(GetWorkerCount(), count);
+	std::atomic<size_t> next(0);
+
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < count; i = next++)
+			func(i);
+	};
+
+	//One item, or already inside parallel work - nested calls decide for themselves
+	if (workers == 1)
+	{
+		worker();
+		return 1;
+	}
+
+	std::vector<std::thread> threads;
+	for (unsigned int w = 1; w < workers; w++)
+	{
+		threads.emplace_back([&]()
+		{
+			ParallelWorkScope scope;
+			worker();
+		});
+	}
+
+	{
+		ParallelWorkScope scope;
+		worker();
+	}
+
+	for (size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	return workers;
+}
@@ -1,18 +1,32 @@
 #include "ShaderIncludes.hlsli"
 
-Texture2D Albedo		: register(t0);	//'t' -> textures
-Texture2D NormalMap		: register(t1);
-Texture2D RoughnessMap	: register(t2);
-Texture2D MetalnessMap	: register(t3);
+Texture2DArray Albedo	: register(t0);	//'t' -> textures (a slice per entity, see albedoSlice)
+Texture2D NormalMap		: register(t1);	//Only X and Y are used - cooked normal maps are BC5, Z is rebuilt
+Texture2D RoughMetalMap	: register(t2);	//Roughness in red, metalness in green (BC5 once cooked)
+TextureCube SpecularMap	: register(t3);	//Sky prefiltered for specular - rougher further down the mips
+Texture2D BrdfLut		: register(t4);	//Split-sum scale/bias of F0 by (N.V, roughness)
 
 SamplerState BasicSampler : register(s0);	//'s' -> samplers
+SamplerState ClampSampler : register(s1);
 
-cbuffer ExternalData : register(b0)
+//Split by how often they change - once a frame, when the material changes, and every draw
+cbuffer PerFrame : register(b0)
 {
 	Light lights[6];
 	float3 ambient;
-	float4 colorTint;
+	float specularMips;				//0 when there's no baked sky lighting - ambient is then flat
 	float3 cameraPosition;
+	float4 shIrradiance[9];			//Sky irradiance as SH (already / pi)
+}
+
+cbuffer PerMaterial : register(b1)
+{
+	float4 colorTint;
+}
+
+cbuffer PerObject : register(b2)
+{
+	float albedoSlice;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////
@@ -65,23 +79,25 @@ float4 main(VertexToPixel input) : SV_TARGET
 
 	//Get the matrix of vectors ready
 	float3 N = normalize(input.normal);		//Renormalizing each vector passed - interpolation (of pixels) can lead to them being un-normalized by a bit
-	float3 T = normalize(input.tangent);
+	float3 T = normalize(input.tangent.xyz);
 	T = normalize(T - N * dot(T, N));		//Gram-Schmidt orthonormalize -> assumes T&N are normalized!
-	float3 B = cross(T, N);					//Bi-tangent
+	float3 B = cross(T, N) * input.tangent.w;	//Bi-tangent - flipped where the UVs are mirrored
 	float3x3 TBN = float3x3(T, B, N);
 
-	//Normal from texture
-	float3 unpackedNormal = NormalMap.Sample(BasicSampler, input.uv).rgb * 2 - 1;
+	//Normal from texture - BC5 keeps X and Y, and Z is whatever makes it unit length (always facing out)
+	float3 unpackedNormal;
+	unpackedNormal.xy = NormalMap.Sample(BasicSampler, input.uv).rg * 2 - 1;
+	unpackedNormal.z = sqrt(saturate(1 - dot(unpackedNormal.xy, unpackedNormal.xy)));
 	input.normal = mul(unpackedNormal, TBN);
 	
 																	    
-	float3 surfaceColor = pow(Albedo.Sample(BasicSampler, input.uv).rgb, 2.2f) * colorTint; //Getting texture color
+	float3 surfaceColor = pow(Albedo.Sample(BasicSampler, float3(input.uv, albedoSlice)).rgb, 2.2f) * colorTint; //Getting texture color
 
-	float roughness = RoughnessMap.Sample(BasicSampler, input.uv).r; //Greyscale, so getting any color channel works here
-	float metalness = MetalnessMap.Sample(BasicSampler, input.uv).r; // ''
+	float2 roughMetal = RoughMetalMap.Sample(BasicSampler, input.uv).rg; //One fetch for both
+	float roughness = roughMetal.r;
+	float metalness = roughMetal.g;
 
 
-	float3 ambientAmount = float3(0,0,0);		//Ambient color - ambient color * surface color
 	//float specularExponent = (1.0f - roughness) * MAX_SPECULAR_EXPONENT;
 	float3 viewVector = normalize((cameraPosition - input.worldPosition));
 	
@@ -93,6 +109,21 @@ float4 main(VertexToPixel input) : SV_TARGET
 	//Metal normally 0 or 1, but might be in between so a linear interpolation is in line
 	float3 specColor = lerp(F0_NON_METAL.rrr, surfaceColor.rgb, metalness);
 
+	//Ambient - the sky's baked light when there is some, otherwise ambient color * surface color
+	float3 ambientAmount = ambient * surfaceColor;
+	if (specularMips > 0)
+	{
+		float3 n = normalize(input.normal);
+		float NdotV = saturate(dot(n, viewVector));
+		float3 F = FresnelRoughness(NdotV, specColor, roughness);
+
+		float3 irradiance = ShIrradiance(n, shIrradiance);
+		float3 prefiltered = SpecularMap.SampleLevel(ClampSampler, reflect(-viewVector, n), roughness * (specularMips - 1)).rgb;
+		float2 brdf = BrdfLut.Sample(ClampSampler, float2(NdotV, roughness)).rg;
+
+		ambientAmount = (1 - F) * (1 - metalness) * surfaceColor * irradiance + prefiltered * (specColor * brdf.x + brdf.y);
+	}
+
 	//Things that need to be repeated per light
 	for (int i = 0; i < 6; i++)
 	{			
@@ -0,0 +1,203 @@
+#include "RangeAllocator.h"
+
+namespace
+{
+	size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+RangeAllocator::RangeAllocator(size_t capacity)
+	: capacity(0)
+{
+	Grow(capacity);
+}
+
+size_t RangeAllocator::Allocate(size_t size, size_t alignment)
+{
+	if (size == 0)
+		return InvalidOffset;
+	if (alignment == 0)
+		alignment = 1;
+
+	//Smallest block first - alignment padding can mean a bigger one is needed
+	for (std::set<std::pair<size_t, size_t>>::iterator it = freeBySize.lower_bound(std::make_pair(size, (size_t)0)); it != freeBySize.end(); ++it)
+	{
+		size_t blockOffset = it->second;
+		size_t blockSize = it->first;
+		size_t offset = AlignUp(blockOffset, alignment);
+		if (offset + size > blockOffset + blockSize)
+			continue;
+
+		RemoveFree(freeByOffset.find(blockOffset));
+
+		//Whatever's left on either side goes back
+		if (offset > blockOffset)
+			AddFree(blockOffset, offset - blockOffset);
+		if (offset + size < blockOffset + blockSize)
+			AddFree(offset + size, blockOffset + blockSize - (offset + size));
+
+		Allocation allocation = { size, alignment };
+		allocations[offset] = allocation;
+		return offset;
+	}
+
+	return InvalidOffset;
+}
+
+void RangeAllocator::Free(size_t offset)
+{
+	std::map<size_t, Allocation>::iterator it = allocations.find(offset);
+	if (it == allocations.end())
+		return;
+
+	size_t size = it->second.Size;
+	allocations.erase(it);
+	AddFree(offset, size);
+}
+
+void RangeAllocator::Grow(size_t newCapacity)
+{
+	if (newCapacity <= capacity)
+		return;
+
+	size_t oldCapacity = capacity;
+	capacity = newCapacity;
+	AddFree(oldCapacity, newCapacity - oldCapacity);
+}
+
+std::vector<RangeMove> RangeAllocator::Defragment()
+{
+	std::vector<RangeMove> moves;
+	std::map<size_t, Allocation> packed;
+	size_t cursor = 0;
+
+	freeByOffset.clear();
+	freeBySize.clear();
+
+	//Every allocation ends up at or below where it was, since everything before it shrank
+	for (std::map<size_t, Allocation>::iterator it = allocations.begin(); it != allocations.end(); ++it)
+	{
+		size_t to = AlignUp(cursor, it->second.Alignment);
+		if (to > cursor)
+			AddFree(cursor, to - cursor);
+		if (to != it->first)
+		{
+			RangeMove move = { it->first, to, it->second.Size };
+			moves.push_back(move);
+		}
+
+		packed[to] = it->second;
+		cursor = to + it->second.Size;
+	}
+
+	if (cursor < capacity)
+		AddFree(cursor, capacity - cursor);
+
+	allocations.swap(packed);
+	return moves;
+}
+
+size_t RangeAllocator::GetCapacity() const
+{
+	return capacity;
+}
+
+size_t RangeAllocator::GetSize(size_t offset) const
+{
+	std::map<size_t, Allocation>::const_iterator it = allocations.find(offset);
+	return it == allocations.end() ? 0 : it->second.Size;
+}
+
+RangeAllocatorStats RangeAllocator::GetStats() const
+{
+	RangeAllocatorStats stats;
+	stats.Capacity = capacity;
+	stats.Allocations = allocations.size();
+	stats.FreeBlocks = freeByOffset.size();
+	stats.LargestFree = freeBySize.empty() ? 0 : freeBySize.rbegin()->first;
+
+	size_t free = 0;
+	for (std::map<size_t, size_t>::const_iterator it = freeByOffset.begin(); it != freeByOffset.end(); ++it)
+		free += it->second;
+	stats.Used = capacity - free;
+	return stats;
+}
+
+bool RangeAllocator::Validate() const
+{
+	if (freeByOffset.size() != freeBySize.size())
+		return false;
+
+	//Walk both lists in offset order - they have to tile [0, capacity) exactly
+	std::map<size_t, size_t>::const_iterator f = freeByOffset.begin();
+	std::map<size_t, Allocation>::const_iterator a = allocations.begin();
+	size_t cursor = 0;
+	bool lastWasFree = false;
+
+	while (f != freeByOffset.end() || a != allocations.end())
+	{
+		bool takeFree = a == allocations.end() || (f != freeByOffset.end() && f->first < a->first);
+		if (takeFree)
+		{
+			//Neighbouring free blocks should have been merged
+			if (f->first != cursor || f->second == 0 || lastWasFree)
+				return false;
+			if (freeBySize.find(std::make_pair(f->second, f->first)) == freeBySize.end())
+				return false;
+			cursor += f->second;
+			lastWasFree = true;
+			++f;
+		}
+		else
+		{
+			if (a->first < cursor || a->first % a->second.Alignment != 0)
+				return false;
+
+			//Anything between the last block and this one isn't tracked
+			if (a->first != cursor)
+				return false;
+			cursor += a->second.Size;
+			lastWasFree = false;
+			++a;
+		}
+	}
+
+	return cursor == capacity;
+}
+
+//Adds a free block, merging it with the blocks directly before/after it
+void RangeAllocator::AddFree(size_t offset, size_t size)
+{
+	if (size == 0)
+		return;
+
+	std::map<size_t, size_t>::iterator next = freeByOffset.lower_bound(offset);
+	if (next != freeByOffset.begin())
+	{
+		std::map<size_t, size_t>::iterator prev = next;
+		--prev;
+		if (prev->first + prev->second == offset)
+		{
+			offset = prev->first;
+			size += prev->second;
+			RemoveFree(prev);
+		}
+	}
+
+	if (next != freeByOffset.end() && offset + size == next->first)
+	{
+		size += next->second;
+		RemoveFree(next);
+	}
+
+	freeByOffset[offset] = size;
+	freeBySize.insert(std::make_pair(size, offset));
+}
+
+void RangeAllocator::RemoveFree(std::map<size_t, size_t>::iterator block)
+{
+	freeBySize.erase(std::make_pair(block->second, block->first));
+	freeByOffset.erase(block);
+}
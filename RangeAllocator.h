@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------------
+// How full and how broken up a RangeAllocator is
+// --------------------------------------------------------
+struct RangeAllocatorStats
+{
+	size_t Capacity = 0;
+	size_t Used = 0;				// Including alignment padding inside allocations
+	size_t Allocations = 0;
+	size_t FreeBlocks = 0;
+	size_t LargestFree = 0;
+
+	// Used / Capacity
+	float Occupancy() const { return Capacity ? (float)Used / Capacity : 0.0f; }
+
+	// 0 = all free space in one block, towards 1 = scattered in small pieces
+	float Fragmentation() const
+	{
+		size_t free = Capacity - Used;
+		return free ? 1.0f - (float)LargestFree / free : 0.0f;
+	}
+};
+
+// One allocation moved by RangeAllocator::Defragment
+struct RangeMove
+{
+	size_t From;
+	size_t To;
+	size_t Size;
+};
+
+// --------------------------------------------------------
+// Hands out [offset, offset + size) ranges of some larger
+// space - no memory of its own, so it works for GPU buffers
+// (see GeometryArena) and can be tested on its own
+//
+// - Free blocks are kept coalesced, sorted by offset and by size
+// - Allocate is best fit (smallest block that fits, lowest
+//   offset on ties), so the results are deterministic
+// - Defragment slides every allocation down to the start and
+//   returns the moves for the owner to copy the data with
+// --------------------------------------------------------
+class RangeAllocator
+{
+public:
+	static const size_t InvalidOffset = (size_t)-1;
+
+	RangeAllocator(size_t capacity = 0);
+
+	// Returns the start of the range, or InvalidOffset if there's no room
+	size_t Allocate(size_t size, size_t alignment = 1);
+	void Free(size_t offset);
+
+	// Adds space to the end (never shrinks)
+	void Grow(size_t newCapacity);
+
+	// Packs allocations towards 0, in offset order.  Moves are returned in the
+	// order they're safe to apply in place (each one only moves data down)
+	std::vector<RangeMove> Defragment();
+
+	size_t GetCapacity() const;
+	size_t GetSize(size_t offset) const;
+	RangeAllocatorStats GetStats() const;
+
+	// Checks the free/used blocks exactly tile the space (for tests)
+	bool Validate() const;
+
+private:
+	struct Allocation
+	{
+		size_t Size;
+		size_t Alignment;
+	};
+
+	size_t capacity;
+	std::map<size_t, size_t> freeByOffset;				// offset -> size
+	std::set<std::pair<size_t, size_t>> freeBySize;		// (size, offset)
+	std::map<size_t, Allocation> allocations;			// offset -> allocation
+
+	void AddFree(size_t offset, size_t size);
+	void RemoveFree(std::map<size_t, size_t>::iterator block);
+};
@@ -0,0 +1,294 @@
+// --------------------------------------------------------
+// Standalone tests for RangeAllocator
+//
+// Not part of the game project (it has its own main) - build it
+// on its own, e.g. headless on Linux:
+//
+//   g++ -std=c++14 -O2 -o RangeAllocatorTest RangeAllocatorTest.cpp RangeAllocator.cpp
+//
+// Usage:
+//   RangeAllocatorTest [random operations (default 20000)] [seed]
+//
+// Every operation is followed by Validate().  Alongside the
+// allocator an id per offset records which allocation owns it,
+// so Defragment's moves are applied to real data and checked:
+// after the moves each allocation still has to own exactly its
+// own bytes.  Returns 0 when everything passed
+// --------------------------------------------------------
+#include "RangeAllocator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool condition, const char* what, int line)
+	{
+		if (condition)
+			return;
+		printf("  FAILED (line %d): %s\n", line, what);
+		failures++;
+	}
+
+	#define CHECK(condition) Check((condition), #condition, __LINE__)
+
+	// --------------------------------------------------------
+	// An allocator plus the "memory" it manages - owner ids per
+	// offset (0 = nobody), so moves can be checked on real data
+	// --------------------------------------------------------
+	struct Space
+	{
+		RangeAllocator Ranges;
+		std::vector<int> Memory;
+		std::map<size_t, int> Owners;		// offset -> id
+		int NextId = 1;
+
+		Space(size_t capacity) : Ranges(capacity), Memory(capacity, 0) {}
+
+		size_t Allocate(size_t size, size_t alignment)
+		{
+			size_t offset = Ranges.Allocate(size, alignment);
+			CHECK(Ranges.Validate());
+			if (offset == RangeAllocator::InvalidOffset)
+				return offset;
+
+			CHECK(offset % (alignment ? alignment : 1) == 0);
+			CHECK(offset + size <= Ranges.GetCapacity());
+			CHECK(Ranges.GetSize(offset) == size);
+
+			int id = NextId++;
+			for (size_t i = offset; i < offset + size; i++)
+			{
+				CHECK(Memory[i] == 0);		// Overlaps a live allocation
+				Memory[i] = id;
+			}
+			Owners[offset] = id;
+			return offset;
+		}
+
+		void Free(size_t offset)
+		{
+			size_t size = Ranges.GetSize(offset);
+			Ranges.Free(offset);
+			CHECK(Ranges.Validate());
+			CHECK(Ranges.GetSize(offset) == 0);
+
+			for (size_t i = offset; i < offset + size; i++)
+				Memory[i] = 0;
+			Owners.erase(offset);
+		}
+
+		void Grow(size_t capacity)
+		{
+			Ranges.Grow(capacity);
+			CHECK(Ranges.Validate());
+			if (capacity > Memory.size())
+				Memory.resize(capacity, 0);
+		}
+
+		// Applies the moves in the order given, as GeometryArena would in place
+		void Defragment()
+		{
+			std::vector<RangeMove> moves = Ranges.Defragment();
+			CHECK(Ranges.Validate());
+
+			std::map<size_t, int> moved = Owners;
+			for (size_t m = 0; m < moves.size(); m++)
+			{
+				const RangeMove& move = moves[m];
+				CHECK(move.To < move.From);
+				CHECK(Owners.count(move.From) == 1);
+				memmove(&Memory[move.To], &Memory[move.From], move.Size * sizeof(int));
+
+				moved.erase(move.From);
+				moved[move.To] = Owners[move.From];
+			}
+
+			//Nothing left over past the packed allocations, and each still owns its bytes
+			std::vector<int> expected(Memory.size(), 0);
+			for (std::map<size_t, int>::iterator it = moved.begin(); it != moved.end(); ++it)
+			{
+				size_t size = Ranges.GetSize(it->first);
+				CHECK(size > 0);
+				for (size_t i = it->first; i < it->first + size; i++)
+				{
+					CHECK(Memory[i] == it->second);
+					expected[i] = it->second;
+				}
+			}
+			Memory = expected;
+			Owners = moved;
+
+			RangeAllocatorStats stats = Ranges.GetStats();
+			CHECK(stats.FreeBlocks <= Owners.size() + 1);		// Only alignment gaps and the tail
+		}
+	};
+
+	void TestBasics()
+	{
+		printf("Basics\n");
+		Space space(100);
+
+		size_t a = space.Allocate(10, 1);
+		size_t b = space.Allocate(20, 1);
+		size_t c = space.Allocate(30, 1);
+		CHECK(a == 0 && b == 10 && c == 30);
+		CHECK(space.Allocate(41, 1) == RangeAllocator::InvalidOffset);
+		CHECK(space.Allocate(0, 1) == RangeAllocator::InvalidOffset);
+
+		RangeAllocatorStats stats = space.Ranges.GetStats();
+		CHECK(stats.Used == 60 && stats.Allocations == 3 && stats.FreeBlocks == 1 && stats.LargestFree == 40);
+
+		//Freeing the middle then its neighbours coalesces back to one block
+		space.Free(b);
+		CHECK(space.Ranges.GetStats().FreeBlocks == 2);
+		space.Free(a);
+		CHECK(space.Ranges.GetStats().FreeBlocks == 2);
+		space.Free(c);
+		stats = space.Ranges.GetStats();
+		CHECK(stats.Used == 0 && stats.FreeBlocks == 1 && stats.LargestFree == 100);
+
+		//Unknown offsets are ignored
+		space.Ranges.Free(55);
+		CHECK(space.Ranges.Validate());
+	}
+
+	void TestBestFit()
+	{
+		printf("Best fit\n");
+		Space space(100);
+
+		//Free holes of 30 (at 0) and 10 (at 40) - a 10 should land in the small one
+		size_t a = space.Allocate(30, 1);
+		space.Allocate(10, 1);
+		size_t c = space.Allocate(10, 1);
+		space.Allocate(10, 1);
+		space.Free(a);
+		space.Free(c);
+		CHECK(space.Allocate(10, 1) == 40);
+		CHECK(space.Allocate(25, 1) == 0);
+	}
+
+	void TestAlignment()
+	{
+		printf("Alignment\n");
+		Space space(64);
+
+		space.Allocate(3, 1);
+		size_t aligned = space.Allocate(8, 16);
+		CHECK(aligned == 16);
+
+		//The padding before it is still free
+		CHECK(space.Allocate(13, 1) == 3);
+		CHECK(space.Ranges.GetStats().Used == 24);
+	}
+
+	void TestGrow()
+	{
+		printf("Grow\n");
+		Space space(16);
+
+		space.Allocate(16, 1);
+		CHECK(space.Allocate(8, 1) == RangeAllocator::InvalidOffset);
+		space.Grow(32);
+		CHECK(space.Allocate(8, 1) == 16);
+		space.Grow(8);		// Never shrinks
+		CHECK(space.Ranges.GetCapacity() == 32);
+	}
+
+	void TestDefragment()
+	{
+		printf("Defragment\n");
+		Space space(128);
+
+		std::vector<size_t> offsets;
+		for (int i = 0; i < 8; i++)
+			offsets.push_back(space.Allocate(8 + i, i % 2 ? 4 : 1));
+		for (size_t i = 0; i < offsets.size(); i += 2)
+			space.Free(offsets[i]);
+
+		RangeAllocatorStats before = space.Ranges.GetStats();
+		space.Defragment();
+		RangeAllocatorStats after = space.Ranges.GetStats();
+		CHECK(after.Allocations == before.Allocations);
+		CHECK(after.LargestFree > before.LargestFree);
+		CHECK(after.Fragmentation() < before.Fragmentation());
+
+		//Already packed - nothing more to move
+		CHECK(space.Ranges.Defragment().empty());
+		CHECK(space.Ranges.Validate());
+	}
+
+	// Random allocate / free / grow / defragment, checked after every step
+	void TestRandom(int operations, unsigned int seed)
+	{
+		printf("Random: %d operations, seed %u\n", operations, seed);
+		std::mt19937 random(seed);
+		Space space(4096);
+
+		int allocated = 0, full = 0, freed = 0, grown = 0, defragmented = 0;
+		for (int op = 0; op < operations && failures == 0; op++)
+		{
+			unsigned int pick = random() % 100;
+			if (pick < 55)
+			{
+				size_t size = 1 + random() % 200;
+				size_t alignment = (size_t)1 << (random() % 5);
+				if (space.Allocate(size, alignment) == RangeAllocator::InvalidOffset)
+					full++;
+				else
+					allocated++;
+			}
+			else if (pick < 95)
+			{
+				if (space.Owners.empty())
+					continue;
+				std::map<size_t, int>::iterator it = space.Owners.begin();
+				std::advance(it, random() % space.Owners.size());
+				space.Free(it->first);
+				freed++;
+			}
+			else if (pick < 97 && space.Ranges.GetCapacity() < 65536)
+			{
+				space.Grow(space.Ranges.GetCapacity() + 1 + random() % 1024);
+				grown++;
+			}
+			else
+			{
+				space.Defragment();
+				defragmented++;
+			}
+		}
+
+		printf("  %d allocated (%d didn't fit), %d freed, %d grows, %d defragments, capacity %zu\n",
+			allocated, full, freed, grown, defragmented, space.Ranges.GetCapacity());
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int operations = argc > 1 ? atoi(argv[1]) : 20000;
+	unsigned int seed = argc > 2 ? (unsigned int)strtoul(argv[2], nullptr, 10) : 1;
+
+	TestBasics();
+	TestBestFit();
+	TestAlignment();
+	TestGrow();
+	TestDefragment();
+	TestRandom(operations, seed);
+
+	if (failures)
+	{
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("All passed\n");
+	return 0;
+}
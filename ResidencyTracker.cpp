@@ -0,0 +1,153 @@
+#include "ResidencyTracker.h"
+
+size_t ResidencyTracker::MinTopMipBytes = 64 * 64 * 4;
+
+ResidencyTracker::ResidencyTracker(size_t budget) :
+	frame(0)
+{
+	stats.Budget = budget;
+}
+
+uint32_t ResidencyTracker::Add()
+{
+	items.push_back(Item());
+	stats.Items = items.size();
+	return (uint32_t)(items.size() - 1);
+}
+
+void ResidencyTracker::BeginFrame()
+{
+	frame++;
+}
+
+bool ResidencyTracker::Use(uint32_t item)
+{
+	Item& i = items[item];
+	i.LastUsed = frame;
+	stats.Uses++;
+
+	if (IsResident(item) && i.TopMip == 0)
+	{
+		stats.Hits++;
+		return true;
+	}
+
+	//Failed items stay on their placeholder rather than being retried every frame
+	stats.Misses++;
+	if (!i.Queued && !i.Failed)
+	{
+		i.Queued = true;
+		loads.push_back(item);
+	}
+	return false;
+}
+
+void ResidencyTracker::TakeLoads(std::vector<uint32_t>& taken)
+{
+	taken.swap(loads);
+	loads.clear();
+}
+
+void ResidencyTracker::Loaded(uint32_t item, const std::vector<size_t>& mipBytes)
+{
+	Item& i = items[item];
+	bool wasResident = IsResident(item);
+	stats.ResidentBytes -= ResidentBytes(i);
+
+	//Suffix sums, so dropping mips is just moving TopMip
+	i.ChainBytes.assign(mipBytes.size(), 0);
+	size_t total = 0;
+	for (size_t m = mipBytes.size(); m-- > 0;)
+	{
+		total += mipBytes[m];
+		i.ChainBytes[m] = total;
+	}
+	i.TopMip = 0;
+	i.Queued = false;
+
+	stats.Loads++;
+	stats.Resident += (wasResident || mipBytes.empty()) ? 0 : 1;
+	stats.ResidentBytes += ResidentBytes(i);
+	if (stats.ResidentBytes > stats.PeakBytes)
+		stats.PeakBytes = stats.ResidentBytes;
+}
+
+void ResidencyTracker::LoadFailed(uint32_t item)
+{
+	items[item].Queued = false;
+	items[item].Failed = true;
+	stats.Failures++;
+}
+
+void ResidencyTracker::Trim(std::vector<ResidencyAction>& actions)
+{
+	while (stats.Budget > 0 && stats.ResidentBytes > stats.Budget)
+	{
+		//Least recently used of everything resident that wasn't needed last frame
+		uint32_t victim = 0;
+		bool found = false;
+		for (uint32_t i = 0; i < (uint32_t)items.size(); i++)
+		{
+			if (!IsResident(i) || items[i].LastUsed + 1 >= frame)
+				continue;
+			if (!found || items[i].LastUsed < items[victim].LastUsed)
+			{
+				victim = i;
+				found = true;
+			}
+		}
+		if (!found)
+			break;
+
+		Item& v = items[victim];
+		size_t before = ResidentBytes(v);
+		uint32_t levels = (uint32_t)v.ChainBytes.size();
+
+		//The level that would become the top - chain sizes differ by exactly that level's size
+		uint32_t next = v.TopMip + 1;
+		size_t nextBytes = next < levels ? v.ChainBytes[next] - (next + 1 < levels ? v.ChainBytes[next + 1] : 0) : 0;
+
+		ResidencyAction action;
+		action.Item = victim;
+		if (next < levels && nextBytes >= MinTopMipBytes)
+		{
+			v.TopMip = next;
+			action.Action = ResidencyAction::DropMip;
+			stats.MipDrops++;
+		}
+		else
+		{
+			v.TopMip = levels;
+			action.Action = ResidencyAction::Evict;
+			stats.Evictions++;
+			stats.Resident--;
+		}
+		stats.ResidentBytes -= before - ResidentBytes(v);
+		actions.push_back(action);
+	}
+}
+
+void ResidencyTracker::SetBudget(size_t bytes)
+{
+	stats.Budget = bytes;
+}
+
+bool ResidencyTracker::IsResident(uint32_t item)
+{
+	return items[item].TopMip < items[item].ChainBytes.size();
+}
+
+uint32_t ResidencyTracker::GetTopMip(uint32_t item)
+{
+	return IsResident(item) ? items[item].TopMip : (uint32_t)items[item].ChainBytes.size();
+}
+
+ResidencyStats ResidencyTracker::GetStats()
+{
+	return stats;
+}
+
+size_t ResidencyTracker::ResidentBytes(const Item& item) const
+{
+	return item.TopMip < item.ChainBytes.size() ? item.ChainBytes[item.TopMip] : 0;
+}
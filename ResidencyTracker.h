@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ResidencyStats
+{
+	size_t Items = 0;
+	size_t Uses = 0;
+	size_t Hits = 0;				// Uses that found the whole item resident
+	size_t Misses = 0;				// Uses that got a placeholder (or a reduced item) and asked for a load
+	size_t Loads = 0;
+	size_t Failures = 0;			// Loads that failed - those items keep their placeholder
+	size_t MipDrops = 0;
+	size_t Evictions = 0;
+	size_t Resident = 0;			// Items with anything resident
+	size_t ResidentBytes = 0;
+	size_t PeakBytes = 0;
+	size_t Budget = 0;				// 0 = unlimited
+
+	float HitRate() const { return Uses ? (float)Hits / Uses : 0.0f; }
+};
+
+// What the owner has to do to an item to get back under budget
+struct ResidencyAction
+{
+	enum Type { DropMip, Evict };
+
+	uint32_t Item;
+	Type Action;
+};
+
+// --------------------------------------------------------
+// Which items (textures) are resident and which should go -
+// bookkeeping only, so it works for any resource and can be
+// tested without a device (see TextureResidency)
+//
+// - Use() is a hit if the item is fully resident; otherwise
+//   it's queued for loading and the owner draws a stand-in
+// - Trim() works from the least recently used item: its top mip
+//   goes first (a quarter of the size each time), and the whole
+//   item once its top mip would be under MinTopMipBytes.
+//   Anything used last frame or this one is never trimmed, so
+//   a working set bigger than the budget doesn't thrash
+// --------------------------------------------------------
+class ResidencyTracker
+{
+public:
+	// Mips aren't dropped to leave a top level smaller than this (64 x 64 RGBA8)
+	static size_t MinTopMipBytes;
+
+	ResidencyTracker(size_t budget = 0);
+
+	// A new, non-resident item.  Returns its index
+	uint32_t Add();
+
+	// Starts the next frame (before any Use that frame)
+	void BeginFrame();
+
+	// True if the item is fully resident
+	bool Use(uint32_t item);
+
+	// Items missed since the last call, in the order they were missed
+	void TakeLoads(std::vector<uint32_t>& items);
+
+	// The load finished - mipBytes holds every level's size, top first
+	void Loaded(uint32_t item, const std::vector<size_t>& mipBytes);
+	void LoadFailed(uint32_t item);
+
+	// Returns what to drop, least recently used first, until under budget
+	// (or nothing more can go).  The tracker already counts them as done
+	void Trim(std::vector<ResidencyAction>& actions);
+
+	void SetBudget(size_t bytes);
+
+	bool IsResident(uint32_t item);
+
+	// 0 when fully resident; the number of levels when nothing is
+	uint32_t GetTopMip(uint32_t item);
+
+	ResidencyStats GetStats();
+
+private:
+	struct Item
+	{
+		std::vector<size_t> ChainBytes;		// Bytes from each level down to the smallest
+		uint32_t TopMip = 0;				// Most detailed level resident (== levels: none)
+		uint64_t LastUsed = 0;
+		bool Queued = false;
+		bool Failed = false;
+	};
+
+	size_t ResidentBytes(const Item& item) const;
+
+	std::vector<Item> items;
+	uint64_t frame;
+	std::vector<uint32_t> loads;
+	ResidencyStats stats;
+};
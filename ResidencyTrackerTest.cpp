@@ -0,0 +1,303 @@
+// --------------------------------------------------------
+// Standalone tests for ResidencyTracker
+//
+// Not part of the game project (it has its own main) - build it
+// on its own, e.g. headless on Linux:
+//
+//   g++ -std=c++14 -O2 -o ResidencyTrackerTest ResidencyTrackerTest.cpp ResidencyTracker.cpp
+//
+// Usage:
+//   ResidencyTrackerTest [random frames (default 2000)] [seed]
+//
+// Hits, misses and load queueing first, then Trim's order on
+// hand-built mip chains: least recently used first, a mip at a
+// time, evicted once the top would be too small, and never
+// anything used this frame or last.  The random run plays
+// frames against a model of what each item has resident, which
+// ResidentBytes has to agree with after every Trim.  Returns 0
+// when everything passed
+// --------------------------------------------------------
+#include "ResidencyTracker.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool condition, const char* what, int line)
+	{
+		if (condition)
+			return;
+		printf("  FAILED (line %d): %s\n", line, what);
+		failures++;
+	}
+
+	#define CHECK(condition) Check((condition), #condition, __LINE__)
+
+	// Every level of a square RGBA8 texture, top first
+	std::vector<size_t> MipChain(size_t size)
+	{
+		std::vector<size_t> mips;
+		for (; size > 0; size /= 2)
+			mips.push_back(size * size * 4);
+		return mips;
+	}
+
+	size_t Sum(const std::vector<size_t>& mips, size_t from)
+	{
+		size_t total = 0;
+		for (size_t m = from; m < mips.size(); m++)
+			total += mips[m];
+		return total;
+	}
+
+	// Loads whatever the tracker asked for, all with the same chain
+	void LoadAll(ResidencyTracker& tracker, const std::vector<size_t>& mips)
+	{
+		std::vector<uint32_t> loads;
+		tracker.TakeLoads(loads);
+		for (size_t i = 0; i < loads.size(); i++)
+			tracker.Loaded(loads[i], mips);
+	}
+
+	void TestUse()
+	{
+		printf("Use\n");
+		ResidencyTracker tracker;
+		uint32_t a = tracker.Add();
+		uint32_t b = tracker.Add();
+		CHECK(a == 0 && b == 1);
+		CHECK(!tracker.IsResident(a) && tracker.GetTopMip(a) == 0);
+
+		//Missed twice in a frame, asked for once
+		tracker.BeginFrame();
+		CHECK(!tracker.Use(b));
+		CHECK(!tracker.Use(a));
+		CHECK(!tracker.Use(b));
+		std::vector<uint32_t> loads;
+		tracker.TakeLoads(loads);
+		CHECK(loads.size() == 2 && loads[0] == b && loads[1] == a);
+
+		//Still queued while it loads, so not asked for again
+		tracker.BeginFrame();
+		CHECK(!tracker.Use(a));
+		tracker.TakeLoads(loads);
+		CHECK(loads.empty());
+
+		std::vector<size_t> mips = MipChain(256);
+		tracker.Loaded(a, mips);
+		tracker.LoadFailed(b);
+
+		tracker.BeginFrame();
+		CHECK(tracker.Use(a));
+		CHECK(tracker.IsResident(a) && tracker.GetTopMip(a) == 0);
+
+		//A failed item stays on its placeholder instead of being retried
+		CHECK(!tracker.Use(b));
+		tracker.TakeLoads(loads);
+		CHECK(loads.empty());
+
+		ResidencyStats stats = tracker.GetStats();
+		CHECK(stats.Items == 2 && stats.Uses == 6 && stats.Hits == 1 && stats.Misses == 5);
+		CHECK(stats.Loads == 1 && stats.Failures == 1 && stats.Resident == 1);
+		CHECK(stats.ResidentBytes == Sum(mips, 0) && stats.PeakBytes == stats.ResidentBytes);
+	}
+
+	// --------------------------------------------------------
+	// Three 256 x 256 items used on frames 1, 2 and 3 - at frame
+	// 5 the oldest goes first, a level at a time, and the newest
+	// is left alone as long as the others can give
+	// --------------------------------------------------------
+	void TestTrimOrder()
+	{
+		printf("Trim order\n");
+		std::vector<size_t> mips = MipChain(256);
+		size_t full = Sum(mips, 0);
+
+		ResidencyTracker tracker;
+		uint32_t items[3] = { tracker.Add(), tracker.Add(), tracker.Add() };
+		for (int i = 0; i < 3; i++)
+		{
+			tracker.BeginFrame();
+			tracker.Use(items[i]);
+			LoadAll(tracker, mips);
+		}
+		tracker.BeginFrame();
+		tracker.BeginFrame();
+
+		std::vector<ResidencyAction> actions;
+		tracker.SetBudget(full * 3);
+		tracker.Trim(actions);
+		CHECK(actions.empty());
+
+		tracker.SetBudget(full * 2 + Sum(mips, 1));
+		tracker.Trim(actions);
+		CHECK(actions.size() == 1 && actions[0].Item == items[0] && actions[0].Action == ResidencyAction::DropMip);
+		CHECK(tracker.GetTopMip(items[0]) == 1 && !tracker.Use(items[0]));
+
+		//The one just used is safe now - the next oldest gives up its levels until the 64 x 64 would be the top
+		tracker.BeginFrame();
+		actions.clear();
+		tracker.SetBudget(full + Sum(mips, 1) + Sum(mips, 2));
+		tracker.Trim(actions);
+		CHECK(actions.size() == 2 && actions[0].Item == items[1] && actions[1].Item == items[1]);
+		CHECK(tracker.GetTopMip(items[1]) == 2);
+
+		actions.clear();
+		tracker.SetBudget(full + Sum(mips, 1));
+		tracker.Trim(actions);
+		CHECK(actions.size() == 1 && actions[0].Item == items[1] && actions[0].Action == ResidencyAction::Evict);
+		CHECK(!tracker.IsResident(items[1]) && tracker.GetTopMip(items[1]) == mips.size());
+
+		ResidencyStats stats = tracker.GetStats();
+		CHECK(stats.MipDrops == 3 && stats.Evictions == 1 && stats.Resident == 2);
+		CHECK(stats.ResidentBytes == full + Sum(mips, 1));
+		CHECK(stats.PeakBytes == full * 3);
+
+		//Only the oldest can go, and then everything left was used this frame or last
+		actions.clear();
+		tracker.SetBudget(1);
+		tracker.Trim(actions);
+		CHECK(actions.size() == 3 && actions[0].Item == items[2] && actions[2].Item == items[2]);
+		CHECK(!tracker.IsResident(items[2]) && tracker.IsResident(items[0]));
+		actions.clear();
+		tracker.BeginFrame();
+		tracker.Use(items[0]);
+		tracker.Use(items[2]);
+		tracker.BeginFrame();
+		tracker.Trim(actions);
+		CHECK(actions.empty());
+	}
+
+	// An item short of its top mip is used - it asks for the whole thing again and counts it once
+	void TestReload()
+	{
+		printf("Reload\n");
+		std::vector<size_t> mips = MipChain(512);
+		ResidencyTracker tracker;
+		uint32_t item = tracker.Add();
+		tracker.BeginFrame();
+		tracker.Use(item);
+		LoadAll(tracker, mips);
+		tracker.BeginFrame();
+		tracker.BeginFrame();
+
+		std::vector<ResidencyAction> actions;
+		tracker.SetBudget(Sum(mips, 1));
+		tracker.Trim(actions);
+		CHECK(tracker.GetTopMip(item) == 1);
+
+		tracker.SetBudget(0);
+		tracker.BeginFrame();
+		CHECK(!tracker.Use(item));
+		LoadAll(tracker, mips);
+		tracker.BeginFrame();
+		CHECK(tracker.Use(item));
+
+		ResidencyStats stats = tracker.GetStats();
+		CHECK(stats.Loads == 2 && stats.Resident == 1 && stats.ResidentBytes == Sum(mips, 0));
+	}
+
+	// --------------------------------------------------------
+	// Random uses, loads and budgets against a model: each
+	// item's resident bytes follow from its chain and top mip,
+	// and Trim either gets under budget or has nothing left
+	// that it's allowed to touch
+	// --------------------------------------------------------
+	void TestRandom(int frames, unsigned int seed)
+	{
+		printf("Random (%d frames, seed %u)\n", frames, seed);
+		std::mt19937 random(seed);
+		const uint32_t count = 40;
+		const size_t sizes[] = { 16, 64, 128, 256, 512, 1024 };
+
+		ResidencyTracker tracker;
+		std::vector<std::vector<size_t>> chains(count);
+		std::vector<int> lastUsed(count, -10);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			tracker.Add();
+			chains[i] = MipChain(sizes[random() % 6]);
+		}
+
+		bool consistent = true;
+		bool trimmed = true;
+		bool protectedKept = true;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			tracker.BeginFrame();
+			if (random() % 50 == 0)
+				tracker.SetBudget((random() % 4) * 2 * 1024 * 1024);
+
+			//Loads land a frame after the miss, sometimes failing
+			std::vector<uint32_t> loads;
+			tracker.TakeLoads(loads);
+			for (size_t i = 0; i < loads.size(); i++)
+			{
+				if (random() % 100 == 0)
+					tracker.LoadFailed(loads[i]);
+				else
+					tracker.Loaded(loads[i], chains[loads[i]]);
+			}
+
+			//A few hot items and a random spread of the rest
+			uint32_t uses = 2 + random() % 8;
+			for (uint32_t u = 0; u < uses; u++)
+			{
+				uint32_t item = random() % 4 == 0 ? random() % 4 : random() % count;
+				tracker.Use(item);
+				lastUsed[item] = frame;
+			}
+
+			std::vector<ResidencyAction> actions;
+			tracker.Trim(actions);
+			for (size_t a = 0; a < actions.size(); a++)
+				protectedKept = protectedKept && lastUsed[actions[a].Item] + 1 < frame;
+
+			size_t resident = 0;
+			bool anyTrimmable = false;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (!tracker.IsResident(i))
+					continue;
+				resident += Sum(chains[i], tracker.GetTopMip(i));
+				anyTrimmable = anyTrimmable || lastUsed[i] + 1 < frame;
+			}
+
+			ResidencyStats stats = tracker.GetStats();
+			consistent = consistent && stats.ResidentBytes == resident && stats.PeakBytes >= resident;
+			trimmed = trimmed && (stats.Budget == 0 || resident <= stats.Budget || !anyTrimmable);
+		}
+		CHECK(consistent);
+		CHECK(trimmed);
+		CHECK(protectedKept);
+
+		ResidencyStats stats = tracker.GetStats();
+		CHECK(stats.Hits + stats.Misses == stats.Uses);
+		printf("  %zu uses, %.1f%% hits, %zu loads, %zu mips dropped, %zu evicted\n",
+			stats.Uses, stats.HitRate() * 100.0f, stats.Loads, stats.MipDrops, stats.Evictions);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int frames = argc > 1 ? atoi(argv[1]) : 2000;
+	unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+
+	TestUse();
+	TestTrimOrder();
+	TestReload();
+	TestRandom(frames, seed);
+
+	if (failures)
+	{
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("All passed\n");
+	return 0;
+}
@@ -0,0 +1,140 @@
+#include "SdfFont.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace DirectX;
+
+SdfFont::SdfFont() :
+	defaultGlyph(nullptr), lineTexels(0.0f), atlasBytes(0)
+{
+}
+
+bool SdfFont::Load(Microsoft::WRL::ComPtr<ID3D11Device> device, AssetPack* pack, const std::string& packed, const std::string& cooked, const std::string& source)
+{
+	//The atlas is read straight from the pack or mapping - they only have to last until the texture is made
+	SdfFontData font;
+	MappedFile file;
+	AssetSpan span;
+	bool parsed =
+		(pack && pack->Find(packed, span) && SdfFontFile::Parse(span.Data, span.Size, font)) ||
+		(file.Open(cooked.c_str()) && SdfFontFile::Parse(file.GetData(), file.GetSize(), font));
+
+	//Not cooked yet - the same build the cooker would do, just at load
+	std::vector<uint8_t> built;
+	if (!parsed)
+	{
+		MappedFile sourceFile;
+		SdfFontStats stats;
+		bool inPack = pack && pack->Find(source, span);
+		if (!inPack && !sourceFile.Open(source.c_str()))
+			return false;
+		if (!SdfFontBuilder::Build(inPack ? span.Data : sourceFile.GetData(), inPack ? span.Size : sourceFile.GetSize(), SdfFontSettings(), font, built, &stats))
+			return false;
+
+		#if defined(DEBUG) || defined(_DEBUG)
+			printf("SdfFont: built %s at load (%.1f ms) - run the asset cooker to skip this\n", source.c_str(), stats.Seconds * 1000.0);
+		#endif
+	}
+
+	D3D11_SUBRESOURCE_DATA data = {};
+	data.pSysMem = font.Pixels;
+	data.SysMemPitch = font.RowPitch();
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = font.AtlasWidth;
+	desc.Height = font.AtlasHeight;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = (DXGI_FORMAT)font.DxgiFormat;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	if (FAILED(device->CreateTexture2D(&desc, &data, texture.GetAddressOf())) ||
+		FAILED(device->CreateShaderResourceView(texture.Get(), 0, atlas.ReleaseAndGetAddressOf())))
+		return false;
+
+	glyphs = font.Glyphs;
+	lineTexels = font.LineTexels;
+	atlasBytes = font.PixelBytes;
+	defaultGlyph = nullptr;	//So a missing default comes back as nothing, not the last font's
+	defaultGlyph = FindGlyph(font.DefaultCharacter);
+
+	#if defined(DEBUG) || defined(_DEBUG)
+		printf("SdfFont: %zu glyphs in a %ux%u atlas (%.1f KB)\n", glyphs.size(), font.AtlasWidth, font.AtlasHeight, atlasBytes / 1024.0);
+	#endif
+	return true;
+}
+
+bool SdfFont::IsLoaded()
+{
+	return atlas.Get() != nullptr;
+}
+
+void SdfFont::Begin(SpriteBatch* batch, SimplePixelShader* textShader)
+{
+	//SpriteBatch binds the atlas (t0) and its linear clamp sampler (s0) - only the pixel shader changes
+	batch->Begin(SpriteSortMode_Deferred, nullptr, nullptr, nullptr, nullptr, [=]() { textShader->SetShader(); });
+}
+
+void XM_CALLCONV SdfFont::DrawString(SpriteBatch* batch, const char* text, XMFLOAT2 position, float lineHeight, FXMVECTOR color)
+{
+	float scale = lineHeight / lineTexels;
+	float x = position.x;
+	float y = position.y;
+	for (const char* c = text; *c; c++)
+	{
+		if (*c == '\n')
+		{
+			x = position.x;
+			y += lineHeight;
+			continue;
+		}
+
+		const SdfGlyph* glyph = FindGlyph((unsigned char)*c);
+		if (!glyph)
+			continue;
+
+		if (glyph->Width > 0)
+		{
+			RECT rect = { glyph->X, glyph->Y, glyph->X + glyph->Width, glyph->Y + glyph->Height };
+			batch->Draw(atlas.Get(), XMFLOAT2(x + glyph->XOffset * lineHeight, y + glyph->YOffset * lineHeight), &rect, color, 0.0f, XMFLOAT2(0, 0), scale);
+		}
+		x += glyph->Advance * lineHeight;
+	}
+}
+
+XMFLOAT2 SdfFont::MeasureString(const char* text, float lineHeight)
+{
+	float width = 0.0f;
+	float x = 0.0f;
+	int lines = 1;
+	for (const char* c = text; *c; c++)
+	{
+		if (*c == '\n')
+		{
+			x = 0.0f;
+			lines++;
+			continue;
+		}
+
+		const SdfGlyph* glyph = FindGlyph((unsigned char)*c);
+		if (glyph)
+			x += glyph->Advance * lineHeight;
+		width = (std::max)(width, x);
+	}
+	return XMFLOAT2(width, lines * lineHeight);
+}
+
+// Anything the font doesn't have draws as its default character (or nothing, without one)
+const SdfGlyph* SdfFont::FindGlyph(uint32_t character)
+{
+	std::vector<SdfGlyph>::const_iterator glyph = std::lower_bound(glyphs.begin(), glyphs.end(), character,
+		[](const SdfGlyph& g, uint32_t c) { return g.Character < c; });
+	if (glyph != glyphs.end() && glyph->Character == character)
+		return &*glyph;
+	return defaultGlyph;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "SdfFontBuilder.h"
+#include "SimpleShader.h"
+#include "SpriteBatch.h"
+
+// --------------------------------------------------------
+// Text drawn from one signed distance field atlas (see
+// SdfFontBuilder), at any size
+//
+// - Sizes are line heights in pixels, so text can follow the
+//   window's size instead of picking between bitmap fonts
+// - Glyphs go through a SpriteBatch like SpriteFont's do, with
+//   SdfTextPixelShader turning distance into coverage (about
+//   one pixel of anti-aliasing at every scale)
+// - The cooked .sdffont is used when there is one; otherwise
+//   the atlas is built from the source .spritefont at load
+// --------------------------------------------------------
+class SdfFont
+{
+public:
+	SdfFont();
+
+	// packed - the cooked font's name in the pack
+	// cooked - the loose cooked font
+	// source - the .spritefont to build from if neither is there
+	bool Load(Microsoft::WRL::ComPtr<ID3D11Device> device, AssetPack* pack, const std::string& packed, const std::string& cooked, const std::string& source);
+
+	bool IsLoaded();
+
+	// Starts a batch that draws with the distance field shader.  Any
+	// text drawn until the batch's End() has to come from this font
+	void Begin(DirectX::SpriteBatch* batch, SimplePixelShader* textShader);
+
+	// '\n' starts a new line.  position is the top left of the first line
+	void XM_CALLCONV DrawString(DirectX::SpriteBatch* batch, const char* text, DirectX::XMFLOAT2 position, float lineHeight, DirectX::FXMVECTOR color = DirectX::Colors::White);
+
+	// Width of the widest line and height of every line, in pixels
+	DirectX::XMFLOAT2 MeasureString(const char* text, float lineHeight);
+
+	size_t GetAtlasBytes() { return atlasBytes; }
+
+private:
+	const SdfGlyph* FindGlyph(uint32_t character);
+
+	std::vector<SdfGlyph> glyphs;		// Sorted by Character
+	const SdfGlyph* defaultGlyph;
+	float lineTexels;
+	size_t atlasBytes;
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> atlas;
+};
@@ -0,0 +1,446 @@
+#include "SdfFontBuilder.h"
+#include "BlockCompressor.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	const uint32_t FormatR8 = 61;				// DXGI_FORMAT_R8_UNORM
+	const uint32_t FormatBC4 = 80;				// DXGI_FORMAT_BC4_UNORM
+
+	// "Infinitely" far, for the distance transform - still finite so the parabola maths works
+	const float Far = 1e20f;
+
+	// --------------------------------------------------------
+	// DirectXTK .spritefont layout:
+	//   "DXTKfont", glyph count, glyphs (below), line spacing,
+	//   default character, texture width, height, DXGI format,
+	//   row stride, row count, then the texture's rows
+	// --------------------------------------------------------
+	struct SpriteFontGlyph
+	{
+		uint32_t Character;
+		int32_t Left;
+		int32_t Top;
+		int32_t Right;
+		int32_t Bottom;
+		float XOffset;
+		float YOffset;
+		float XAdvance;			// After the glyph's own width
+	};
+
+	struct SpriteFontBitmap
+	{
+		std::vector<SpriteFontGlyph> Glyphs;
+		float LineSpacing = 0.0f;
+		uint32_t DefaultCharacter = 0;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		size_t TextureBytes = 0;
+		std::vector<uint8_t> Alpha;			// Coverage, one byte per pixel
+	};
+
+	template<typename T>
+	bool Read(const uint8_t* data, size_t size, size_t& offset, T& value)
+	{
+		if (offset + sizeof(T) > size)
+			return false;
+		memcpy(&value, data + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+
+	// Coverage is in alpha whatever the format MakeSpriteFont picked (RGBA8, BGRA4 or BC2)
+	bool ReadSpriteFont(const uint8_t* data, size_t size, SpriteFontBitmap& font)
+	{
+		size_t offset = 8;
+		uint32_t glyphCount = 0;
+		if (size < 8 || memcmp(data, "DXTKfont", 8) != 0 || !Read(data, size, offset, glyphCount))
+			return false;
+		if ((uint64_t)glyphCount * sizeof(SpriteFontGlyph) > size - offset)
+			return false;
+
+		font.Glyphs.resize(glyphCount);
+		for (uint32_t i = 0; i < glyphCount; i++)
+			Read(data, size, offset, font.Glyphs[i]);
+
+		uint32_t format = 0, stride = 0, rows = 0;
+		if (!Read(data, size, offset, font.LineSpacing) || !Read(data, size, offset, font.DefaultCharacter) ||
+			!Read(data, size, offset, font.Width) || !Read(data, size, offset, font.Height) ||
+			!Read(data, size, offset, format) || !Read(data, size, offset, stride) || !Read(data, size, offset, rows))
+			return false;
+		if (font.Width == 0 || font.Height == 0 || font.Width > 16384 || font.Height > 16384 || !(font.LineSpacing > 0.0f))
+			return false;
+		if ((uint64_t)stride * rows > size - offset)
+			return false;
+
+		const uint8_t* texels = data + offset;
+		font.TextureBytes = (size_t)stride * rows;
+		font.Alpha.assign((size_t)font.Width * font.Height, 0);
+		uint8_t* alpha = font.Alpha.data();
+
+		if (format == 28 || format == 29)		// R8G8B8A8_UNORM(_SRGB)
+		{
+			if (stride < font.Width * 4 || rows < font.Height)
+				return false;
+			for (uint32_t y = 0; y < font.Height; y++)
+				for (uint32_t x = 0; x < font.Width; x++)
+					alpha[(size_t)y * font.Width + x] = texels[(size_t)y * stride + x * 4 + 3];
+		}
+		else if (format == 115)					// B4G4R4A4_UNORM, alpha in the top nibble
+		{
+			if (stride < font.Width * 2 || rows < font.Height)
+				return false;
+			for (uint32_t y = 0; y < font.Height; y++)
+				for (uint32_t x = 0; x < font.Width; x++)
+					alpha[(size_t)y * font.Width + x] = (uint8_t)((texels[(size_t)y * stride + x * 2 + 1] >> 4) * 17);
+		}
+		else if (format == 74 || format == 75)	// BC2_UNORM(_SRGB): 4-bit alpha, then a BC1 block we don't need
+		{
+			uint32_t blocksWide = (font.Width + 3) / 4;
+			if (stride < blocksWide * 16 || rows < (font.Height + 3) / 4)
+				return false;
+			for (uint32_t y = 0; y < font.Height; y++)
+			{
+				for (uint32_t x = 0; x < font.Width; x++)
+				{
+					const uint8_t* block = texels + (size_t)(y / 4) * stride + (x / 4) * 16;
+					uint32_t index = (y % 4) * 4 + (x % 4);
+					uint8_t nibble = (block[index / 2] >> ((index % 2) * 4)) & 0xF;
+					alpha[(size_t)y * font.Width + x] = (uint8_t)(nibble * 17);
+				}
+			}
+		}
+		else
+			return false;
+
+		for (uint32_t i = 0; i < glyphCount; i++)
+		{
+			const SpriteFontGlyph& g = font.Glyphs[i];
+			if (g.Left < 0 || g.Top < 0 || g.Right < g.Left || g.Bottom < g.Top || (uint32_t)g.Right > font.Width || (uint32_t)g.Bottom > font.Height)
+				return false;
+		}
+		return true;
+	}
+
+	// --------------------------------------------------------
+	// Felzenszwalb & Huttenlocher's distance transform along one
+	// line: d[q] = min over p of (q - p)^2 + f[p], as the lower
+	// envelope of the parabolas rooted at each sample
+	// --------------------------------------------------------
+	void Transform1D(const float* f, int n, float* d, int* v, float* z)
+	{
+		int k = 0;
+		v[0] = 0;
+		z[0] = -Far;
+		z[1] = Far;
+		for (int q = 1; q < n; q++)
+		{
+			float s = ((f[q] + (float)q * q) - (f[v[k]] + (float)v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+			while (s <= z[k])
+			{
+				k--;
+				s = ((f[q] + (float)q * q) - (f[v[k]] + (float)v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+			}
+			k++;
+			v[k] = q;
+			z[k] = s;
+			z[k + 1] = Far;
+		}
+
+		k = 0;
+		for (int q = 0; q < n; q++)
+		{
+			while (z[k + 1] < (float)q)
+				k++;
+			float offset = (float)(q - v[k]);
+			d[q] = offset * offset + f[v[k]];
+		}
+	}
+
+	// Squared distance from every cell to the nearest cell holding 0 (everything else holds Far)
+	void Transform2D(std::vector<float>& grid, int width, int height)
+	{
+		int n = (std::max)(width, height);
+		std::vector<float> line(n), d(n), z(n + 1);
+		std::vector<int> v(n);
+
+		for (int x = 0; x < width; x++)
+		{
+			for (int y = 0; y < height; y++)
+				line[y] = grid[(size_t)y * width + x];
+			Transform1D(line.data(), height, d.data(), v.data(), z.data());
+			for (int y = 0; y < height; y++)
+				grid[(size_t)y * width + x] = d[y];
+		}
+
+		for (int y = 0; y < height; y++)
+		{
+			float* row = &grid[(size_t)y * width];
+			Transform1D(row, width, d.data(), v.data(), z.data());
+			memcpy(row, d.data(), width * sizeof(float));
+		}
+	}
+
+	// One glyph's distance field at atlas resolution, before packing
+	struct GlyphField
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		int Padding = 0;				// Source pixels added on every side
+		std::vector<uint8_t> Texels;
+	};
+
+	void BuildField(const SpriteFontBitmap& font, const SpriteFontGlyph& glyph, const SdfFontSettings& settings, GlyphField& field)
+	{
+		int ds = (int)settings.Downsample;
+		int w = glyph.Right - glyph.Left;
+		int h = glyph.Bottom - glyph.Top;
+
+		//Room for the whole spread outside the outline, then rounded up to whole atlas texels
+		int pad = (int)ceilf(settings.Spread * ds) + ds;
+		int width = (w + 2 * pad + ds - 1) / ds * ds;
+		int height = (h + 2 * pad + ds - 1) / ds * ds;
+		size_t count = (size_t)width * height;
+
+		std::vector<float> coverage(count, 0.0f);
+		for (int y = 0; y < h; y++)
+			for (int x = 0; x < w; x++)
+				coverage[(size_t)(y + pad) * width + x + pad] = font.Alpha[(size_t)(glyph.Top + y) * font.Width + glyph.Left + x] / 255.0f;
+
+		//Distance to the inside from outside pixels, and to the outside from inside ones
+		std::vector<float> toInside(count), toOutside(count);
+		bool any = false;
+		for (size_t i = 0; i < count; i++)
+		{
+			bool inside = coverage[i] >= 0.5f;
+			toInside[i] = inside ? 0.0f : Far;
+			toOutside[i] = inside ? Far : 0.0f;
+			any |= inside;
+		}
+
+		//Nothing to draw (space) - the glyph only moves the pen
+		if (!any)
+			return;
+
+		Transform2D(toInside, width, height);
+		Transform2D(toOutside, width, height);
+
+		//Signed, in source pixels, positive outside.  Pixel centres sit half a pixel
+		//off the thresholded outline; an edge pixel's coverage says where it really is
+		std::vector<float> distance(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			float c = coverage[i];
+			float d = c < 0.5f ? sqrtf(toInside[i]) - 0.5f : 0.5f - sqrtf(toOutside[i]);
+			if (c > 0.0f && c < 1.0f && fabsf(d) <= 0.5f)
+				d = 0.5f - c;
+			distance[i] = d;
+		}
+
+		field.Width = (uint32_t)(width / ds);
+		field.Height = (uint32_t)(height / ds);
+		field.Padding = pad;
+		field.Texels.resize((size_t)field.Width * field.Height);
+
+		float scale = 1.0f / ((float)ds * ds * ds * 2.0f * settings.Spread);
+		for (uint32_t ay = 0; ay < field.Height; ay++)
+		{
+			for (uint32_t ax = 0; ax < field.Width; ax++)
+			{
+				float sum = 0.0f;
+				for (int y = 0; y < ds; y++)
+					for (int x = 0; x < ds; x++)
+						sum += distance[(size_t)(ay * ds + y) * width + ax * ds + x];
+
+				float value = 0.5f - sum * scale;
+				value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+				field.Texels[(size_t)ay * field.Width + ax] = (uint8_t)(value * 255.0f + 0.5f);
+			}
+		}
+	}
+}
+
+uint64_t SdfFontSettings::Hash() const
+{
+	uint32_t values[3];
+	values[0] = Downsample;
+	memcpy(&values[1], &Spread, sizeof(float));
+	values[2] = Compress ? 1 : 0;
+	return HashBytes(values, sizeof(values));
+}
+
+bool SdfFontBuilder::Build(const uint8_t* spriteFont, size_t size, const SdfFontSettings& settings, SdfFontData& font, std::vector<uint8_t>& pixels, SdfFontStats* stats)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	SpriteFontBitmap source;
+	if (!spriteFont || settings.Downsample == 0 || !(settings.Spread > 0.0f) || !ReadSpriteFont(spriteFont, size, source))
+		return false;
+
+	std::vector<GlyphField> fields(source.Glyphs.size());
+	unsigned int workers = ParallelFor(fields.size(), [&](size_t i)
+	{
+		BuildField(source, source.Glyphs[i], settings, fields[i]);
+	});
+
+	//Shelf packing, tallest first, into a power-of-two width about as wide as the atlas will be tall
+	std::vector<size_t> order;
+	size_t area = 0;
+	uint32_t widest = 0;
+	for (size_t i = 0; i < fields.size(); i++)
+	{
+		if (fields[i].Texels.empty())
+			continue;
+		order.push_back(i);
+		area += (size_t)(fields[i].Width + 1) * (fields[i].Height + 1);
+		widest = (std::max)(widest, fields[i].Width + 1);
+	}
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+	{
+		return fields[a].Height != fields[b].Height ? fields[a].Height > fields[b].Height : a < b;
+	});
+
+	uint32_t atlasWidth = 64;
+	while (atlasWidth < widest || (size_t)atlasWidth * atlasWidth < area + area / 8)
+		atlasWidth *= 2;
+	if (atlasWidth > 16384)
+		return false;
+
+	//One texel between glyphs, so bilinear filtering at a rect's edge never reaches another glyph
+	std::vector<uint16_t> placedX(fields.size(), 0), placedY(fields.size(), 0);
+	uint32_t x = 0, y = 0, shelf = 0;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const GlyphField& field = fields[order[i]];
+		if (x + field.Width > atlasWidth)
+		{
+			x = 0;
+			y += shelf + 1;
+			shelf = 0;
+		}
+		placedX[order[i]] = (uint16_t)x;
+		placedY[order[i]] = (uint16_t)y;
+		x += field.Width + 1;
+		shelf = (std::max)(shelf, field.Height);
+	}
+	uint32_t atlasHeight = (std::max)(4u, (y + shelf + 3) / 4 * 4);
+	if (atlasHeight > 16384)
+		return false;
+
+	std::vector<uint8_t> atlas((size_t)atlasWidth * atlasHeight, 0);
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const GlyphField& field = fields[order[i]];
+		for (uint32_t row = 0; row < field.Height; row++)
+			memcpy(&atlas[(size_t)(placedY[order[i]] + row) * atlasWidth + placedX[order[i]]], &field.Texels[(size_t)row * field.Width], field.Width);
+	}
+
+	//Metrics in lines: everything from the source is in its pixels, the rects are in atlas texels
+	float toLines = 1.0f / source.LineSpacing;
+	font.Glyphs.clear();
+	for (size_t i = 0; i < fields.size(); i++)
+	{
+		const SpriteFontGlyph& g = source.Glyphs[i];
+		const GlyphField& field = fields[i];
+
+		SdfGlyph glyph = {};
+		glyph.Character = g.Character;
+		glyph.X = placedX[i];
+		glyph.Y = placedY[i];
+		glyph.Width = (uint16_t)field.Width;
+		glyph.Height = (uint16_t)field.Height;
+		glyph.XOffset = (g.XOffset - field.Padding) * toLines;
+		glyph.YOffset = (g.YOffset - field.Padding) * toLines;
+		glyph.Advance = (g.XOffset + (g.Right - g.Left) + g.XAdvance) * toLines;
+		font.Glyphs.push_back(glyph);
+	}
+	std::sort(font.Glyphs.begin(), font.Glyphs.end(), [](const SdfGlyph& a, const SdfGlyph& b) { return a.Character < b.Character; });
+	for (size_t i = 1; i < font.Glyphs.size(); i++)
+	{
+		if (font.Glyphs[i].Character == font.Glyphs[i - 1].Character)
+			return false;
+	}
+
+	if (settings.Compress)
+	{
+		std::vector<uint8_t> rgba(atlas.size() * 4, 0);
+		for (size_t i = 0; i < atlas.size(); i++)
+			rgba[i * 4] = atlas[i];
+		pixels.resize(BlockCompressor::CompressedSize(BlockFormat::BC4, atlasWidth, atlasHeight));
+		BlockCompressor::CompressImage(rgba.data(), atlasWidth, atlasHeight, BlockFormat::BC4, pixels.data());
+		font.DxgiFormat = FormatBC4;
+	}
+	else
+	{
+		pixels.swap(atlas);
+		font.DxgiFormat = FormatR8;
+	}
+
+	font.DefaultCharacter = source.DefaultCharacter;
+	font.AtlasWidth = atlasWidth;
+	font.AtlasHeight = atlasHeight;
+	font.LineTexels = source.LineSpacing / settings.Downsample;
+	font.Spread = settings.Spread;
+	font.SourceHash = HashBytes(spriteFont, size);
+	font.Pixels = pixels.data();
+	font.PixelBytes = pixels.size();
+
+	if (stats)
+	{
+		stats->Glyphs = (uint32_t)font.Glyphs.size();
+		stats->AtlasWidth = atlasWidth;
+		stats->AtlasHeight = atlasHeight;
+		stats->SourceBytes = source.TextureBytes;
+		stats->AtlasBytes = pixels.size();
+		stats->Workers = workers;
+		stats->Seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		stats->Ok = true;
+	}
+	return true;
+}
+
+bool SdfFontBuilder::Cook(const std::string& source, const std::string& destination, const SdfFontSettings& settings, SdfFontStats* stats)
+{
+	if (stats)
+		stats->Name = source;
+
+	MappedFile file(source.c_str());
+	SdfFontData font;
+	std::vector<uint8_t> pixels;
+	if (!file.IsOpen() || !Build(file.GetData(), file.GetSize(), settings, font, pixels, stats))
+		return false;
+
+	bool ok = SdfFontFile::Write(destination, font);
+	if (stats)
+		stats->Ok = ok;
+	return ok;
+}
+
+void SdfFontBuilder::Report(const std::vector<SdfFontStats>& fonts)
+{
+	size_t source = 0, atlas = 0;
+	for (size_t i = 0; i < fonts.size(); i++)
+	{
+		const SdfFontStats& f = fonts[i];
+		if (!f.Ok)
+		{
+			printf("  %-44s FAILED\n", f.Name.c_str());
+			continue;
+		}
+
+		printf("  %-44s %3u glyphs  %4ux%-4u atlas  %7.1f KB -> %6.1f KB  %7.1f ms on %u threads\n",
+			f.Name.c_str(), f.Glyphs, f.AtlasWidth, f.AtlasHeight, f.SourceBytes / 1024.0, f.AtlasBytes / 1024.0, f.Seconds * 1000.0, f.Workers);
+		source += f.SourceBytes;
+		atlas += f.AtlasBytes;
+	}
+
+	printf("Fonts: %.1f KB -> %.1f KB\n", source / 1024.0, atlas / 1024.0);
+}
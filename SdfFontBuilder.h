@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SdfFontFile.h"
+
+struct SdfFontSettings
+{
+	uint32_t Downsample = 2;		// Source pixels per atlas texel, each way
+	float Spread = 4.0f;			// Atlas texels of distance on each side of the outline
+	bool Compress = true;			// BC4 instead of R8 - half the size, the field is smooth enough not to mind
+
+	uint64_t Hash() const;
+};
+
+struct SdfFontStats
+{
+	std::string Name;
+	uint32_t Glyphs = 0;
+	uint32_t AtlasWidth = 0;
+	uint32_t AtlasHeight = 0;
+	size_t SourceBytes = 0;			// The source .spritefont's atlas
+	size_t AtlasBytes = 0;
+	double Seconds = 0.0;
+	unsigned int Workers = 0;
+	bool Ok = false;
+};
+
+// --------------------------------------------------------
+// Builds a signed distance field font from a bitmap
+// .spritefont (DirectXTK's MakeSpriteFont output)
+//
+// - Each glyph's coverage is thresholded at 0.5 and both sides
+//   get an exact Euclidean distance transform; anti-aliased
+//   edge pixels use their coverage instead, so the outline
+//   keeps its sub-pixel position
+// - Distances are averaged down (Downsample) and stored as
+//   0.5 - distance / (2 * Spread): 0.5 on the outline, 1 deep
+//   inside.  Bilinear filtering of that rebuilds the outline at
+//   any scale, which a coverage bitmap can't do
+// - Glyphs are shelf packed into one atlas, tallest first.
+//   Blank glyphs (space) keep their advance but take no room
+// - Metrics are in lines of text, so one font draws any size
+//
+// Only one-channel SDF: MSDF needs the glyph outlines, and the
+// .spritefont only has pixels.  Feed it the largest size there
+// is - corners round off at about Downsample source pixels.
+//
+// Glyphs are built on worker threads.  No D3D, so it runs in the
+// cooker as well as at load time
+// --------------------------------------------------------
+class SdfFontBuilder
+{
+public:
+	// pixels receives the atlas, which font.Pixels then points at
+	static bool Build(const uint8_t* spriteFont, size_t size, const SdfFontSettings& settings, SdfFontData& font, std::vector<uint8_t>& pixels, SdfFontStats* stats = nullptr);
+
+	static bool Cook(const std::string& source, const std::string& destination, const SdfFontSettings& settings, SdfFontStats* stats = nullptr);
+
+	static void Report(const std::vector<SdfFontStats>& fonts);
+};
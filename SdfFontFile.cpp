@@ -0,0 +1,116 @@
+#include "SdfFontFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const char SdfFontMagic[4] = { 'S', 'D', 'F', 'F' };
+
+	const uint32_t FormatR8 = 61;			// DXGI_FORMAT_R8_UNORM
+	const uint32_t FormatBC4 = 80;			// DXGI_FORMAT_BC4_UNORM
+
+	inline uint32_t AlignUp(uint32_t value, uint32_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+uint32_t SdfFontData::RowPitch() const
+{
+	return DxgiFormat == FormatBC4 ? (AtlasWidth + 3) / 4 * 8 : AtlasWidth;
+}
+
+bool SdfFontFile::Parse(const uint8_t* data, size_t size, SdfFontData& font)
+{
+	SdfFontHeader h;
+	if (!data || size < sizeof(h))
+		return false;
+
+	memcpy(&h, data, sizeof(h));
+	if (memcmp(h.Magic, SdfFontMagic, 4) != 0 || h.Version != SDF_FONT_VERSION)
+		return false;
+	if (h.DxgiFormat != FormatR8 && h.DxgiFormat != FormatBC4)
+		return false;
+	if (h.AtlasWidth == 0 || h.AtlasHeight == 0 || h.AtlasWidth > 16384 || h.AtlasHeight > 16384 || !(h.LineTexels > 0.0f))
+		return false;
+
+	font.DxgiFormat = h.DxgiFormat;
+	font.AtlasWidth = h.AtlasWidth;
+	font.AtlasHeight = h.AtlasHeight;
+	size_t rows = h.DxgiFormat == FormatBC4 ? (h.AtlasHeight + 3) / 4 : h.AtlasHeight;
+	if ((size_t)h.PixelBytes != rows * font.RowPitch())
+		return false;
+
+	//Everything has to be inside the file (64-bit math, so nothing wraps)
+	if ((uint64_t)h.GlyphOffset + (uint64_t)h.GlyphCount * sizeof(SdfGlyph) > size ||
+		(uint64_t)h.PixelOffset + h.PixelBytes > size)
+		return false;
+
+	font.Glyphs.resize(h.GlyphCount);
+	if (h.GlyphCount > 0)
+		memcpy(font.Glyphs.data(), data + h.GlyphOffset, h.GlyphCount * sizeof(SdfGlyph));
+
+	//Rects have to be inside the atlas, or sprites would sample their neighbours' padding
+	for (size_t i = 0; i < font.Glyphs.size(); i++)
+	{
+		const SdfGlyph& g = font.Glyphs[i];
+		if ((uint32_t)g.X + g.Width > h.AtlasWidth || (uint32_t)g.Y + g.Height > h.AtlasHeight)
+			return false;
+		if (i > 0 && g.Character <= font.Glyphs[i - 1].Character)
+			return false;
+	}
+
+	font.DefaultCharacter = h.DefaultCharacter;
+	font.LineTexels = h.LineTexels;
+	font.Spread = h.Spread;
+	font.SourceHash = h.SourceHash;
+	font.Pixels = data + h.PixelOffset;
+	font.PixelBytes = h.PixelBytes;
+	return true;
+}
+
+bool SdfFontFile::Write(const std::string& path, const SdfFontData& font)
+{
+	SdfFontHeader h = {};
+	memcpy(h.Magic, SdfFontMagic, 4);
+	h.Version = SDF_FONT_VERSION;
+	h.GlyphCount = (uint32_t)font.Glyphs.size();
+	h.DefaultCharacter = font.DefaultCharacter;
+	h.AtlasWidth = font.AtlasWidth;
+	h.AtlasHeight = font.AtlasHeight;
+	h.DxgiFormat = font.DxgiFormat;
+	h.LineTexels = font.LineTexels;
+	h.Spread = font.Spread;
+	h.SourceHash = font.SourceHash;
+	h.GlyphOffset = AlignUp(sizeof(SdfFontHeader), 16);
+	h.PixelOffset = AlignUp(h.GlyphOffset + h.GlyphCount * (uint32_t)sizeof(SdfGlyph), 16);
+	h.PixelBytes = (uint32_t)font.PixelBytes;
+
+	std::vector<unsigned char> bytes(h.PixelOffset + h.PixelBytes, 0);
+	memcpy(&bytes[0], &h, sizeof(h));
+	if (!font.Glyphs.empty()) memcpy(&bytes[h.GlyphOffset], font.Glyphs.data(), font.Glyphs.size() * sizeof(SdfGlyph));
+	if (font.PixelBytes > 0) memcpy(&bytes[h.PixelOffset], font.Pixels, font.PixelBytes);
+
+	std::string tempFile = path + ".tmp";
+	{
+		std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+			return false;
+
+		out.write((const char*)bytes.data(), bytes.size());
+		if (!out.good())
+			return false;
+	}
+
+	//rename() won't replace an existing file on Windows
+	remove(path.c_str());
+	if (rename(tempFile.c_str(), path.c_str()) != 0)
+	{
+		remove(tempFile.c_str());
+		return false;
+	}
+
+	return true;
+}
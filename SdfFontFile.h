@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Bump whenever the layout below or the distance encoding changes
+#define SDF_FONT_VERSION 1
+
+// --------------------------------------------------------
+// Header at the start of a cooked distance-field font
+//
+// File layout:
+//   SdfFontHeader
+//   SdfGlyph[GlyphCount]		(at GlyphOffset, sorted by Character)
+//   Atlas texels				(at PixelOffset, top row first)
+//
+// Glyph metrics are in lines of text - multiply by the line
+// height wanted on screen to get pixels
+// --------------------------------------------------------
+struct SdfFontHeader
+{
+	char Magic[4];				// "SDFF"
+	uint32_t Version;			// SDF_FONT_VERSION
+	uint32_t GlyphCount;
+	uint32_t DefaultCharacter;	// Drawn for anything the font doesn't have
+	uint32_t AtlasWidth;
+	uint32_t AtlasHeight;
+	uint32_t DxgiFormat;		// R8_UNORM or BC4_UNORM
+	float LineTexels;			// Atlas texels per line of text
+	float Spread;				// Atlas texels from the outline (0.5) to 0 or 1
+	uint32_t GlyphOffset;
+	uint32_t PixelOffset;
+	uint32_t PixelBytes;
+	uint64_t SourceHash;		// Hash of the font it was built from
+};
+
+struct SdfGlyph
+{
+	uint32_t Character;
+	uint16_t X;					// Atlas rect, spread included.  0 x 0 for
+	uint16_t Y;					// glyphs with nothing to draw (e.g. space)
+	uint16_t Width;
+	uint16_t Height;
+	float XOffset;				// Pen position to the rect's top left
+	float YOffset;
+	float Advance;				// Pen movement to the next glyph
+};
+
+// A parsed (or freshly built) font.  Pixels points into the
+// bytes it came from, which have to outlive it
+struct SdfFontData
+{
+	uint32_t DefaultCharacter = 0;
+	uint32_t AtlasWidth = 0;
+	uint32_t AtlasHeight = 0;
+	uint32_t DxgiFormat = 0;
+	float LineTexels = 0.0f;
+	float Spread = 0.0f;
+	uint64_t SourceHash = 0;
+	std::vector<SdfGlyph> Glyphs;
+	const uint8_t* Pixels = nullptr;
+	size_t PixelBytes = 0;
+
+	// Bytes in one row of texels (or of 4x4 blocks for BC4)
+	uint32_t RowPitch() const;
+};
+
+// --------------------------------------------------------
+// Reading and writing cooked distance-field fonts (.sdffont)
+// --------------------------------------------------------
+class SdfFontFile
+{
+public:
+	// False for anything malformed, truncated or from another version
+	static bool Parse(const uint8_t* data, size_t size, SdfFontData& font);
+
+	static bool Write(const std::string& path, const SdfFontData& font);
+};
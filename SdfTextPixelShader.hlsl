@@ -0,0 +1,21 @@
+// Distance field text, drawn through SpriteBatch (see SdfFont)
+// - SpriteBatch binds the glyph atlas and a linear clamp sampler
+// - The atlas holds 0.5 on a glyph's outline, rising inside it
+
+Texture2D Atlas : register(t0); //'t' -> textures
+
+SamplerState AtlasSampler : register(s0);	//'s' -> samplers
+
+// Same inputs as SpriteBatch's own pixel shader
+float4 main(float4 color : COLOR0, float2 texCoord : TEXCOORD0) : SV_TARGET
+{
+	float distance = Atlas.Sample(AtlasSampler, texCoord).r;
+
+	//How much the distance changes over one screen pixel - so the edge is
+	//about a pixel wide whatever size the text is drawn at
+	float width = max(length(float2(ddx(distance), ddy(distance))), 0.0001f) * 0.7071f;
+	float coverage = smoothstep(0.5f - width, 0.5f + width, distance);
+
+	//SpriteBatch blends premultiplied
+	return color * coverage;
+}
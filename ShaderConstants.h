@@ -0,0 +1,161 @@
+#pragma once
+
+// --------------------------------------------------------
+// Constant buffer layouts, generated from the compiled
+// shaders by ShaderStructGenerator - don't edit by hand.
+// The game's build regenerates it after compiling shaders
+//
+// Shaders: VertexShader, PixelShader, SkyVertexShader, PackedVertexShader
+// --------------------------------------------------------
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+// cbuffer PerFrame : register(b0)
+struct VertexShaderPerFrame
+{
+	static constexpr const char* BufferName = "PerFrame";
+	static constexpr uint64_t LayoutHash = 0x989E68AE11621114ull;
+
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+};
+static_assert(offsetof(VertexShaderPerFrame, view) == 0, "VertexShaderPerFrame::view doesn't match the shader");
+static_assert(offsetof(VertexShaderPerFrame, projection) == 64, "VertexShaderPerFrame::projection doesn't match the shader");
+static_assert(sizeof(VertexShaderPerFrame) == 128, "VertexShaderPerFrame doesn't match the shader");
+
+// cbuffer PerObject : register(b1)
+struct VertexShaderPerObject
+{
+	static constexpr const char* BufferName = "PerObject";
+	static constexpr uint64_t LayoutHash = 0x01864327840882F7ull;
+
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 worldInvTranspose;
+};
+static_assert(offsetof(VertexShaderPerObject, world) == 0, "VertexShaderPerObject::world doesn't match the shader");
+static_assert(offsetof(VertexShaderPerObject, worldInvTranspose) == 64, "VertexShaderPerObject::worldInvTranspose doesn't match the shader");
+static_assert(sizeof(VertexShaderPerObject) == 128, "VertexShaderPerObject doesn't match the shader");
+
+// cbuffer PerFrame : register(b0)
+struct PixelShaderPerFrame
+{
+	static constexpr const char* BufferName = "PerFrame";
+	static constexpr uint64_t LayoutHash = 0xB6A11BCB043D4378ull;
+
+	struct Light
+	{
+		int32_t Type;
+		DirectX::XMFLOAT3 Direction;
+		float Range;
+		DirectX::XMFLOAT3 Position;
+		float Intensity;
+		DirectX::XMFLOAT3 Color;
+		float SpotFalloff;
+		DirectX::XMFLOAT3 Padding;
+	};
+	Light lights[6];
+	DirectX::XMFLOAT3 ambient;
+	float specularMips;
+	DirectX::XMFLOAT3 cameraPosition;
+	uint32_t _pad0[1];
+	DirectX::XMFLOAT4 shIrradiance[9];
+};
+static_assert(offsetof(PixelShaderPerFrame::Light, Type) == 0, "PixelShaderPerFrame::Light::Type doesn't match the shader");
+static_assert(offsetof(PixelShaderPerFrame::Light, Direction) == 4, "PixelShaderPerFrame::Light::Direction doesn't match the shader");
+static_assert(offsetof(PixelShaderPerFrame::Light, Range) == 16, "PixelShaderPerFrame::Light::Range doesn't match the shader");
+static_assert(offsetof(PixelShaderPerFrame::Light, Position) == 20, "PixelShaderPerFrame::Light::Position doesn't match the shader");
+static_assert(offsetof(PixelShaderPerFrame::Light, Intensity) == 32, "PixelShaderPerFrame::Light::Intensity doesn't match the shader");
+static_assert(offsetof(PixelShaderPerFrame::Light, Color) == 36, "PixelShaderPerFrame::Light::Color doesn't match the shader");
+static_assert(offsetof(PixelShaderPerFrame::Light, SpotFalloff) == 48, "PixelShaderPerFrame::Light::SpotFalloff doesn't match the shader");
+static_assert(offsetof(PixelShaderPerFrame::Light, Padding) == 52, "PixelShaderPerFrame::Light::Padding doesn't match the shader");
+static_assert(sizeof(PixelShaderPerFrame::Light) == 64, "PixelShaderPerFrame::Light doesn't match the shader");
+static_assert(offsetof(PixelShaderPerFrame, lights) == 0, "PixelShaderPerFrame::lights doesn't match the shader");
+static_assert(offsetof(PixelShaderPerFrame, ambient) == 384, "PixelShaderPerFrame::ambient doesn't match the shader");
+static_assert(offsetof(PixelShaderPerFrame, specularMips) == 396, "PixelShaderPerFrame::specularMips doesn't match the shader");
+static_assert(offsetof(PixelShaderPerFrame, cameraPosition) == 400, "PixelShaderPerFrame::cameraPosition doesn't match the shader");
+static_assert(offsetof(PixelShaderPerFrame, shIrradiance) == 416, "PixelShaderPerFrame::shIrradiance doesn't match the shader");
+static_assert(sizeof(PixelShaderPerFrame) == 560, "PixelShaderPerFrame doesn't match the shader");
+
+// cbuffer PerMaterial : register(b1)
+struct PixelShaderPerMaterial
+{
+	static constexpr const char* BufferName = "PerMaterial";
+	static constexpr uint64_t LayoutHash = 0x4372145B783FCFBCull;
+
+	DirectX::XMFLOAT4 colorTint;
+};
+static_assert(offsetof(PixelShaderPerMaterial, colorTint) == 0, "PixelShaderPerMaterial::colorTint doesn't match the shader");
+static_assert(sizeof(PixelShaderPerMaterial) == 16, "PixelShaderPerMaterial doesn't match the shader");
+
+// cbuffer PerObject : register(b2)
+struct PixelShaderPerObject
+{
+	static constexpr const char* BufferName = "PerObject";
+	static constexpr uint64_t LayoutHash = 0x2479E1B40522C76Eull;
+
+	float albedoSlice;
+	uint32_t _pad0[3];
+};
+static_assert(offsetof(PixelShaderPerObject, albedoSlice) == 0, "PixelShaderPerObject::albedoSlice doesn't match the shader");
+static_assert(sizeof(PixelShaderPerObject) == 16, "PixelShaderPerObject doesn't match the shader");
+
+// cbuffer PerFrame : register(b0)
+struct SkyVertexShaderPerFrame
+{
+	static constexpr const char* BufferName = "PerFrame";
+	static constexpr uint64_t LayoutHash = 0x989E68AE11621114ull;
+
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+};
+static_assert(offsetof(SkyVertexShaderPerFrame, view) == 0, "SkyVertexShaderPerFrame::view doesn't match the shader");
+static_assert(offsetof(SkyVertexShaderPerFrame, projection) == 64, "SkyVertexShaderPerFrame::projection doesn't match the shader");
+static_assert(sizeof(SkyVertexShaderPerFrame) == 128, "SkyVertexShaderPerFrame doesn't match the shader");
+
+// cbuffer PerFrame : register(b0)
+struct PackedVertexShaderPerFrame
+{
+	static constexpr const char* BufferName = "PerFrame";
+	static constexpr uint64_t LayoutHash = 0x989E68AE11621114ull;
+
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+};
+static_assert(offsetof(PackedVertexShaderPerFrame, view) == 0, "PackedVertexShaderPerFrame::view doesn't match the shader");
+static_assert(offsetof(PackedVertexShaderPerFrame, projection) == 64, "PackedVertexShaderPerFrame::projection doesn't match the shader");
+static_assert(sizeof(PackedVertexShaderPerFrame) == 128, "PackedVertexShaderPerFrame doesn't match the shader");
+
+// cbuffer PerObject : register(b1)
+struct PackedVertexShaderPerObject
+{
+	static constexpr const char* BufferName = "PerObject";
+	static constexpr uint64_t LayoutHash = 0x01864327840882F7ull;
+
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 worldInvTranspose;
+};
+static_assert(offsetof(PackedVertexShaderPerObject, world) == 0, "PackedVertexShaderPerObject::world doesn't match the shader");
+static_assert(offsetof(PackedVertexShaderPerObject, worldInvTranspose) == 64, "PackedVertexShaderPerObject::worldInvTranspose doesn't match the shader");
+static_assert(sizeof(PackedVertexShaderPerObject) == 128, "PackedVertexShaderPerObject doesn't match the shader");
+
+// cbuffer PerMesh : register(b2)
+struct PackedVertexShaderPerMesh
+{
+	static constexpr const char* BufferName = "PerMesh";
+	static constexpr uint64_t LayoutHash = 0x675B2D865DB3659Eull;
+
+	DirectX::XMFLOAT3 positionOffset;
+	uint32_t _pad0[1];
+	DirectX::XMFLOAT3 positionScale;
+	uint32_t _pad1[1];
+	DirectX::XMFLOAT2 uvOffset;
+	DirectX::XMFLOAT2 uvScale;
+};
+static_assert(offsetof(PackedVertexShaderPerMesh, positionOffset) == 0, "PackedVertexShaderPerMesh::positionOffset doesn't match the shader");
+static_assert(offsetof(PackedVertexShaderPerMesh, positionScale) == 16, "PackedVertexShaderPerMesh::positionScale doesn't match the shader");
+static_assert(offsetof(PackedVertexShaderPerMesh, uvOffset) == 32, "PackedVertexShaderPerMesh::uvOffset doesn't match the shader");
+static_assert(offsetof(PackedVertexShaderPerMesh, uvScale) == 40, "PackedVertexShaderPerMesh::uvScale doesn't match the shader");
+static_assert(sizeof(PackedVertexShaderPerMesh) == 48, "PackedVertexShaderPerMesh doesn't match the shader");
+
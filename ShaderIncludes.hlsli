@@ -32,9 +32,31 @@ struct VertexShaderInput
 	float3 localPosition	: POSITION;     // XYZ position
 	float3 normal			: NORMAL;
 	float2 uv				: TEXCOORD;
-	float3 tangent			: TANGENT;
+	float4 tangent			: TANGENT;		// XYZ tangent, W handedness (+1/-1)
 };
 
+// Packed 20 byte vertex (PackedVertex in VertexFormats.h)
+// - position.xyz is normalized inside the mesh bounds and needs the
+//   mesh's VertexQuantization scale/offset applied
+// - position.w is the tangent handedness (unorm: 0/1, half: -1/+1)
+// - normal/tangent are octahedral encoded (see DecodeOctahedral)
+struct PackedVertexShaderInput
+{
+	float4 localPosition	: POSITION;
+	float2 normal			: NORMAL;
+	float2 uv				: TEXCOORD;
+	float2 tangent			: TANGENT;
+};
+
+// Unfolds an octahedral encoded unit vector (VertexPacking::OctDecode)
+float3 DecodeOctahedral(float2 e)
+{
+	float3 n = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+	if (n.z < 0)
+		n.xy = (1.0f - abs(e.yx)) * (e.xy >= 0 ? 1.0f : -1.0f);
+	return normalize(n);
+}
+
 // Struct representing the data we're sending down the pipeline (and is received by the pixel shader!)
 // - Should match our pixel shader's input (hence the name: Vertex to Pixel)
 // - At a minimum, we need a piece of data defined tagged as SV_POSITION
@@ -51,7 +73,7 @@ struct VertexToPixel
 	float2 uv				: TEXCOORD;     // RGBA color
 	float3 normal			: NORMAL;		// Normal
 	float3 worldPosition	: POSITION;		//World Position
-	float3 tangent			: TANGENT;		//Tangent (for normal map)
+	float4 tangent			: TANGENT;		//Tangent (for normal map) + handedness in w
 };
 
 //Light Specific
@@ -196,4 +218,35 @@ float3 MicrofacetBRDF(float3 n, float3 l, float3 v, float roughness, float3 spec
 
 
 
+// IMAGE BASED LIGHTING ================
+
+// Irradiance from 9 spherical harmonics (IblBaker stores them
+// convolved with the cosine lobe and divided by pi already)
+float3 ShIrradiance(float3 n, float4 sh[9])
+{
+	float3 result =
+		sh[0].rgb * 0.282095f +
+		sh[1].rgb * 0.488603f * n.y +
+		sh[2].rgb * 0.488603f * n.z +
+		sh[3].rgb * 0.488603f * n.x +
+		sh[4].rgb * 1.092548f * n.x * n.y +
+		sh[5].rgb * 1.092548f * n.y * n.z +
+		sh[6].rgb * 0.315392f * (3 * n.z * n.z - 1) +
+		sh[7].rgb * 1.092548f * n.x * n.z +
+		sh[8].rgb * 0.546274f * (n.x * n.x - n.y * n.y);
+	return max(result, 0);
+}
+
+
+
+// Fresnel for light from every direction at once - rough surfaces
+// don't reach full reflectance at grazing angles
+// https://seblagarde.wordpress.com/2011/08/17/hello-world/
+float3 FresnelRoughness(float NdotV, float3 f0, float roughness)
+{
+	return f0 + (max((1 - roughness).rrr, f0) - f0) * pow(1 - NdotV, 5);
+}
+
+
+
 #endif
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "ShaderReflectionCache.h"
+#include "Hash.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const char ReflectionCacheMagic[4] = { 'S', 'R', 'F', 'C' };
+
+	void AppendU32(std::vector<uint8_t>& bytes, uint32_t value)
+	{
+		uint8_t raw[4];
+		memcpy(raw, &value, 4);
+		bytes.insert(bytes.end(), raw, raw + 4);
+	}
+}
+
+ShaderReflectionCache::ShaderReflectionCache()
+{
+	dirty = false;
+	hits = 0;
+	misses = 0;
+}
+
+ShaderReflectionCache::~ShaderReflectionCache()
+{
+}
+
+// --------------------------------------------------------
+// Reads the cache file.  Remembers the path for Save() even
+// when there's nothing usable to read yet
+// --------------------------------------------------------
+bool ShaderReflectionCache::Load(const char* cacheFile)
+{
+	path = cacheFile;
+	entries.clear();
+	dirty = false;
+
+	MappedFile file;
+	if (!file.Open(cacheFile))
+		return false;
+
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+
+	uint32_t version, count;
+	if (size < 12 || memcmp(data, ReflectionCacheMagic, 4) != 0)
+		return false;
+	memcpy(&version, data + 4, 4);
+	memcpy(&count, data + 8, 4);
+	if (version != SHADER_REFLECTION_VERSION)
+		return false;
+
+	size_t offset = 12;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint64_t hash;
+		uint32_t entrySize;
+		if (size - offset < 12)
+			break;
+		memcpy(&hash, data + offset, 8);
+		memcpy(&entrySize, data + offset + 8, 4);
+		offset += 12;
+		if (size - offset < entrySize)
+			break;
+
+		Entry entry;
+		entry.Bytes.assign(data + offset, data + offset + entrySize);
+		entry.Used = false;
+		entries[hash] = entry;
+		offset += entrySize;
+	}
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Writes the cache if anything changed since Load()
+//
+// Written to a temporary file first and then renamed over the
+// old one, so a crash mid-write can't leave a half-written cache
+// --------------------------------------------------------
+bool ShaderReflectionCache::Save()
+{
+	//Entries nothing asked for belong to shaders that have since changed
+	for (std::unordered_map<uint64_t, Entry>::iterator it = entries.begin(); it != entries.end();)
+	{
+		if (!it->second.Used)
+		{
+			it = entries.erase(it);
+			dirty = true;
+		}
+		else
+			++it;
+	}
+
+	if (!dirty || path.empty())
+		return true;
+
+	std::vector<uint8_t> bytes(ReflectionCacheMagic, ReflectionCacheMagic + 4);
+	AppendU32(bytes, SHADER_REFLECTION_VERSION);
+	AppendU32(bytes, (uint32_t)entries.size());
+	for (std::unordered_map<uint64_t, Entry>::iterator it = entries.begin(); it != entries.end(); ++it)
+	{
+		uint8_t hash[8];
+		memcpy(hash, &it->first, 8);
+		bytes.insert(bytes.end(), hash, hash + 8);
+		AppendU32(bytes, (uint32_t)it->second.Bytes.size());
+		bytes.insert(bytes.end(), it->second.Bytes.begin(), it->second.Bytes.end());
+	}
+
+	std::string tempFile = path + ".tmp";
+	{
+		std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+			return false;
+
+		out.write((const char*)bytes.data(), bytes.size());
+		if (!out.good())
+			return false;
+	}
+
+	//rename() won't replace an existing file on Windows
+	remove(path.c_str());
+	if (rename(tempFile.c_str(), path.c_str()) != 0)
+	{
+		remove(tempFile.c_str());
+		return false;
+	}
+
+	dirty = false;
+	return true;
+}
+
+// --------------------------------------------------------
+// Looks up the reflection for this bytecode - false when it
+// isn't cached (or the entry won't read back), so parse it
+// --------------------------------------------------------
+bool ShaderReflectionCache::Get(const void* bytecode, size_t size, ShaderReflection& reflection)
+{
+	std::unordered_map<uint64_t, Entry>::iterator found = entries.find(HashBytes(bytecode, size));
+	if (found == entries.end() || !DxbcReflection::Read(found->second.Bytes.data(), found->second.Bytes.size(), reflection))
+	{
+		misses++;
+		return false;
+	}
+
+	found->second.Used = true;
+	hits++;
+	return true;
+}
+
+void ShaderReflectionCache::Put(const void* bytecode, size_t size, const ShaderReflection& reflection)
+{
+	Entry& entry = entries[HashBytes(bytecode, size)];
+	DxbcReflection::Write(reflection, entry.Bytes);
+	entry.Used = true;
+	dirty = true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "DxbcReflection.h"
+
+// --------------------------------------------------------
+// Reflection results from earlier runs, keyed by a hash of
+// each shader's bytecode, so an unchanged shader skips parsing
+//
+// File layout:
+//   "SRFC", SHADER_REFLECTION_VERSION, entry count
+//   per entry: uint64 bytecode hash, uint32 size, bytes
+//   (DxbcReflection::Write)
+//
+// - Save() only rewrites the file when something changed, and
+//   drops entries no shader asked for this run (stale shaders)
+// - A missing, old or damaged file just means an empty cache
+// --------------------------------------------------------
+class ShaderReflectionCache
+{
+public:
+	ShaderReflectionCache();
+	~ShaderReflectionCache();
+
+	bool Load(const char* cacheFile);
+	bool Save();
+
+	bool Get(const void* bytecode, size_t size, ShaderReflection& reflection);
+	void Put(const void* bytecode, size_t size, const ShaderReflection& reflection);
+
+	int GetHits() { return hits; }
+	int GetMisses() { return misses; }
+
+private:
+	struct Entry
+	{
+		std::vector<uint8_t> Bytes;
+		bool Used;
+	};
+
+	std::string path;
+	std::unordered_map<uint64_t, Entry> entries;
+	bool dirty;
+	int hits;
+	int misses;
+};
@@ -0,0 +1,248 @@
+#include "ShaderStructGenerator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <set>
+
+namespace
+{
+	// D3D_SHADER_VARIABLE_CLASS / D3D_SHADER_VARIABLE_TYPE / D3D_CBUFFER_TYPE values used here
+	const uint32_t ClassScalar = 0;
+	const uint32_t ClassVector = 1;
+	const uint32_t ClassMatrixRows = 2;
+	const uint32_t ClassMatrixColumns = 3;
+	const uint32_t ClassStruct = 5;
+	const uint32_t TypeBool = 1;
+	const uint32_t TypeInt = 2;
+	const uint32_t TypeFloat = 3;
+	const uint32_t TypeUInt = 19;
+	const uint32_t BufferTypeCbuffer = 0;
+
+	struct StructWriter
+	{
+		std::string Code;
+		std::string Asserts;
+		bool Failed;
+	};
+
+	uint32_t AlignTo16(uint32_t size)
+	{
+		return (size + 15) & ~15u;
+	}
+
+	// Shader names as C++ identifiers ("$Globals" -> "Globals")
+	std::string Identifier(const std::string& name)
+	{
+		std::string id;
+		for (size_t i = 0; i < name.size(); i++)
+		{
+			if (isalnum((unsigned char)name[i]) || name[i] == '_')
+				id += name[i];
+		}
+		if (id.empty() || isdigit((unsigned char)id[0]))
+			id = "_" + id;
+		return id;
+	}
+
+	std::string Capitalize(std::string name)
+	{
+		if (!name.empty())
+			name[0] = (char)toupper((unsigned char)name[0]);
+		return name;
+	}
+
+	// The C++ type for one element of a scalar, vector or matrix ("" when nothing fits)
+	std::string ElementType(const ShaderVariableInfo& variable)
+	{
+		const char* scalar;
+		const char* vector;
+		switch (variable.BaseType)
+		{
+		case TypeFloat: scalar = "float"; vector = "DirectX::XMFLOAT"; break;
+		case TypeInt: scalar = "int32_t"; vector = "DirectX::XMINT"; break;
+		case TypeUInt:
+		case TypeBool: scalar = "uint32_t"; vector = "DirectX::XMUINT"; break;	//HLSL bools are 4 bytes
+		default: return "";
+		}
+
+		if (variable.Class == ClassScalar || (variable.Class == ClassVector && variable.Columns == 1))
+			return scalar;
+		if (variable.Class == ClassVector && variable.Columns <= 4)
+			return std::string(vector) + std::to_string(variable.Columns);
+
+		//Either majorness - SimpleShader has always copied XMFLOAT4X4s straight in
+		if ((variable.Class == ClassMatrixRows || variable.Class == ClassMatrixColumns) &&
+			variable.BaseType == TypeFloat && variable.Rows == 4 && variable.Columns == 4)
+			return "DirectX::XMFLOAT4X4";
+		return "";
+	}
+
+	void WritePadding(StructWriter& out, const std::string& indent, uint32_t bytes, int& count)
+	{
+		if (bytes == 0)
+			return;
+
+		std::string name = "_pad" + std::to_string(count++);
+		if (bytes % 4 == 0)
+			out.Code += indent + "uint32_t " + name + "[" + std::to_string(bytes / 4) + "];\n";
+		else
+			out.Code += indent + "uint8_t " + name + "[" + std::to_string(bytes) + "];\n";
+	}
+
+	// --------------------------------------------------------
+	// The members of a buffer or struct, each at its reflected
+	// offset, with padding in the gaps up to the given size.
+	// Struct types are written nested, just before first use
+	// --------------------------------------------------------
+	void WriteMembers(StructWriter& out, const std::string& indent, const std::string& owner, std::vector<ShaderVariableInfo> members, uint32_t size)
+	{
+		std::stable_sort(members.begin(), members.end(),
+			[](const ShaderVariableInfo& a, const ShaderVariableInfo& b) { return a.StartOffset < b.StartOffset; });
+
+		std::set<std::string> nestedTypes;
+		uint32_t cursor = 0;
+		int padding = 0;
+		for (size_t i = 0; i < members.size(); i++)
+		{
+			const ShaderVariableInfo& variable = members[i];
+			std::string name = Identifier(variable.Name);
+			uint32_t next = i + 1 < members.size() ? members[i + 1].StartOffset : size;
+			if (variable.StartOffset < cursor || variable.StartOffset + variable.Size > next)
+			{
+				out.Failed = true;
+				return;
+			}
+
+			WritePadding(out, indent, variable.StartOffset - cursor, padding);
+
+			uint32_t element = DxbcReflection::ElementSize(variable);
+			std::string type;
+			if (variable.Class == ClassStruct)
+			{
+				type = variable.TypeName.empty() ? Capitalize(name) + "Type" : Identifier(variable.TypeName);
+				if (nestedTypes.insert(type).second)
+				{
+					out.Code += indent + "struct " + type + "\n" + indent + "{\n";
+					WriteMembers(out, indent + "\t", owner + "::" + type, variable.Members, element);
+					out.Code += indent + "};\n";
+				}
+			}
+			else
+				type = ElementType(variable);
+
+			std::string assertName = name;
+			if (type.empty())
+			{
+				//Nothing in C++ fits (doubles, odd matrix shapes) - raw words
+				out.Code += indent + "uint32_t " + name + "[" + std::to_string(variable.Size / 4) + "];\t// " + variable.TypeName + "\n";
+				cursor = variable.StartOffset + variable.Size;
+			}
+			else if (variable.Elements == 0)
+			{
+				out.Code += indent + type + " " + name + ";\n";
+				cursor = variable.StartOffset + element;
+			}
+			else if (AlignTo16(element) == element)
+			{
+				out.Code += indent + type + " " + name + "[" + std::to_string(variable.Elements) + "];\n";
+				cursor = variable.StartOffset + element * variable.Elements;
+			}
+			else
+			{
+				//Each array element starts a new register, so the padding goes in an element struct
+				uint32_t stride = AlignTo16(element);
+				std::string elementType = Capitalize(name) + "Element";
+				std::string elementStruct = indent + "struct " + elementType + " { " + type + " Value; uint32_t _pad[" + std::to_string((stride - element) / 4) + "]; };\n";
+				if (variable.StartOffset + stride * variable.Elements <= next)
+				{
+					out.Code += elementStruct;
+					out.Code += indent + elementType + " " + name + "[" + std::to_string(variable.Elements) + "];\n";
+					cursor = variable.StartOffset + stride * variable.Elements;
+				}
+				else
+				{
+					//The next variable is packed into the last element's padding
+					if (variable.Elements > 1)
+					{
+						out.Code += elementStruct;
+						out.Code += indent + elementType + " " + name + "[" + std::to_string(variable.Elements - 1) + "];\n";
+					}
+					else
+						assertName = name + "Last";
+					out.Code += indent + type + " " + name + "Last;\n";
+					cursor = variable.StartOffset + variable.Size;
+				}
+			}
+
+			out.Asserts += "static_assert(offsetof(" + owner + ", " + assertName + ") == " + std::to_string(variable.StartOffset) +
+				", \"" + owner + "::" + assertName + " doesn't match the shader\");\n";
+		}
+
+		if (cursor > size)
+		{
+			out.Failed = true;
+			return;
+		}
+		WritePadding(out, indent, size - cursor, padding);
+		out.Asserts += "static_assert(sizeof(" + owner + ") == " + std::to_string(size) + ", \"" + owner + " doesn't match the shader\");\n";
+	}
+}
+
+// --------------------------------------------------------
+// Returns false if a buffer's variables overlap or run past
+// its end (which reflection from a real shader never does)
+// --------------------------------------------------------
+bool ShaderStructGenerator::Generate(const ShaderReflection& reflection, const std::string& prefix, std::string& code)
+{
+	for (size_t b = 0; b < reflection.ConstantBuffers.size(); b++)
+	{
+		const ShaderBufferInfo& buffer = reflection.ConstantBuffers[b];
+		if (buffer.Type != BufferTypeCbuffer)
+			continue;
+
+		std::string name = Identifier(prefix) + Identifier(buffer.Name);
+		StructWriter out = {};
+		WriteMembers(out, "\t", name, buffer.Variables, buffer.Size);
+		if (out.Failed)
+			return false;
+
+		char hash[32];
+		snprintf(hash, sizeof(hash), "0x%016llXull", (unsigned long long)DxbcReflection::LayoutHash(buffer));
+
+		code += "// cbuffer " + buffer.Name + " : register(b" + std::to_string(buffer.BindPoint) + ")\n";
+		code += "struct " + name + "\n{\n";
+		code += "\tstatic constexpr const char* BufferName = \"" + buffer.Name + "\";\n";
+		code += "\tstatic constexpr uint64_t LayoutHash = " + std::string(hash) + ";\n\n";
+		code += out.Code;
+		code += "};\n";
+		code += out.Asserts + "\n";
+	}
+	return true;
+}
+
+bool ShaderStructGenerator::GenerateHeader(const std::vector<std::string>& shaderNames, const std::vector<ShaderReflection>& reflections, std::string& code)
+{
+	std::string names;
+	for (size_t i = 0; i < shaderNames.size(); i++)
+		names += (i > 0 ? ", " : "") + shaderNames[i];
+
+	code = "#pragma once\n\n";
+	code += "// --------------------------------------------------------\n";
+	code += "// Constant buffer layouts, generated from the compiled\n";
+	code += "// shaders by ShaderStructGenerator - don't edit by hand.\n";
+	code += "// The game's build regenerates it after compiling shaders\n";
+	code += "//\n";
+	code += "// Shaders: " + names + "\n";
+	code += "// --------------------------------------------------------\n\n";
+	code += "#include <DirectXMath.h>\n";
+	code += "#include <cstddef>\n";
+	code += "#include <cstdint>\n\n";
+
+	for (size_t i = 0; i < reflections.size() && i < shaderNames.size(); i++)
+	{
+		if (!Generate(reflections[i], shaderNames[i], code))
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "DxbcReflection.h"
+
+// --------------------------------------------------------
+// Writes C++ structs that match shaders' constant buffers,
+// so a whole buffer can be set with ISimpleShader::SetBuffer()
+//
+// - Members sit at the offsets reflection reports, with
+//   explicit padding wherever HLSL packing leaves a gap, and
+//   each offset and struct size gets a static_assert
+// - Every struct carries its buffer's name and LayoutHash, so
+//   a header older than its shader fails at SetBuffer() too
+// - ShaderStructGeneratorMain.cpp is the command line front end
+// --------------------------------------------------------
+class ShaderStructGenerator
+{
+public:
+	// Structs for one shader's constant buffers (tbuffers and structured
+	// buffer layouts are skipped), each named prefix + buffer name
+	static bool Generate(const ShaderReflection& reflection, const std::string& prefix, std::string& code);
+
+	// A whole header - every shader's structs, named after the shader
+	static bool GenerateHeader(const std::vector<std::string>& shaderNames, const std::vector<ShaderReflection>& reflections, std::string& code);
+};
@@ -0,0 +1,110 @@
+// --------------------------------------------------------
+// Command line front end for ShaderStructGenerator
+//
+// Not compiled into the game (it has its own main) - the game
+// project builds and runs it after FXC (see the
+// GenerateShaderConstants target in DX11Starter.vcxproj), so
+// ShaderConstants.h always matches the compiled shaders.  It
+// also builds on its own, e.g. headless on Linux:
+//
+//   g++ -std=c++14 -O2 -o ShaderStructGenerator ShaderStructGeneratorMain.cpp
+//       ShaderStructGenerator.cpp DxbcReflection.cpp MappedFile.cpp
+//
+// Usage:
+//   ShaderStructGenerator <output header> <shader.cso>...
+//
+// Structs are named after each shader's file name, so
+// PixelShader.cso's PerFrame buffer becomes PixelShaderPerFrame.
+// The header is only rewritten when its contents change, so an
+// unchanged layout doesn't rebuild everything that includes it
+// --------------------------------------------------------
+#include "ShaderStructGenerator.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+	void PrintUsage()
+	{
+		printf("Usage: ShaderStructGenerator <output header> <shader.cso>...\n");
+	}
+
+	// "Shaders/PixelShader.cso" -> "PixelShader"
+	std::string FileStem(const std::string& path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+		return name.substr(0, name.find('.'));
+	}
+
+	bool WriteIfChanged(const std::string& fileName, const std::string& code)
+	{
+		{
+			std::ifstream in(fileName, std::ios::binary);
+			if (in.is_open() && std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()) == code)
+				return true;
+		}
+
+		std::string tempFile = fileName + ".tmp";
+		{
+			std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+			if (!out.is_open())
+				return false;
+
+			out.write(code.data(), code.size());
+			if (!out.good())
+				return false;
+		}
+
+		//rename() won't replace an existing file on Windows
+		remove(fileName.c_str());
+		if (rename(tempFile.c_str(), fileName.c_str()) != 0)
+		{
+			remove(tempFile.c_str());
+			return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	std::vector<std::string> names;
+	std::vector<ShaderReflection> reflections;
+	for (int i = 2; i < argc; i++)
+	{
+		MappedFile file(argv[i]);
+		ShaderReflection reflection;
+		if (!file.IsOpen() || !DxbcReflection::Parse(file.GetData(), file.GetSize(), reflection))
+		{
+			printf("Couldn't read reflection from %s (missing, not DXBC, or stripped)\n", argv[i]);
+			return 1;
+		}
+
+		names.push_back(FileStem(argv[i]));
+		reflections.push_back(reflection);
+	}
+
+	std::string code;
+	if (!ShaderStructGenerator::GenerateHeader(names, reflections, code))
+	{
+		printf("A constant buffer's variables overlap - no header written\n");
+		return 1;
+	}
+
+	if (!WriteIfChanged(argv[1], code))
+	{
+		printf("Couldn't write %s\n", argv[1]);
+		return 1;
+	}
+	return 0;
+}
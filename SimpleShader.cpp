@@ -1,9 +1,17 @@
 #include "SimpleShader.h"
+#include <algorithm>
 
 // Default error reporting state
 bool ISimpleShader::ReportErrors = false;
 bool ISimpleShader::ReportWarnings = false;
 
+// Constant buffer traffic counters
+SimpleUploadStats ISimpleShader::UploadStats;
+SimpleUploadStats ISimpleShader::LastFrameUploadStats;
+
+// No reflection cache unless one is provided
+ShaderReflectionCache* ISimpleShader::ReflectionCache = 0;
+
 // To enable error reporting, use either or both 
 // of the following lines somewhere in your program, 
 // preferably before loading/using any shaders.
@@ -29,6 +37,14 @@ ISimpleShader::ISimpleShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Micros
 	this->constantBufferCount = 0;
 	this->constantBuffers = 0;
 	this->shaderValid = false;
+
+	// Partial constant buffer updates need the 11.1 context and driver support
+	this->partialUpdates = false;
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (device && context &&
+		SUCCEEDED(context.As(&deviceContext1)) &&
+		SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+		this->partialUpdates = options.ConstantBufferPartialUpdate != FALSE;
 }
 
 // --------------------------------------------------------
@@ -65,6 +81,7 @@ void ISimpleShader::CleanUp()
 
 	// Clean up tables
 	varTable.clear();
+	varHashTable.clear();
 	cbTable.clear();
 	samplerTable.clear();
 	textureTable.clear();
@@ -94,6 +111,20 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
+	// Read the tables out of the bytecode (or the cache) - the
+	// vertex, geometry and compute shaders use them in CreateShader()
+	if (!Reflect())
+	{
+		if (ReportErrors)
+		{
+			LogError("SimpleShader::LoadShaderFile() - Error reading reflection data from file '");
+			LogW(shaderFile);
+			LogError("'. Ensure it is compiled DXBC (shader model 5 or earlier) with reflection data left in.\n");
+		}
+
+		return false;
+	}
+
 	// Create the shader - Calls an overloaded version of this abstract
 	// method in the appropriate child class
 	shaderValid = CreateShader(shaderBlob);
@@ -109,33 +140,19 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
-	// Set up shader reflection to get information about
-	// this shader and its variables,  buffers, etc.
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-	
-	// Get the description of the shader
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
 	// Create resource arrays
-	constantBufferCount = shaderDesc.ConstantBuffers;
+	constantBufferCount = (unsigned int)reflection.ConstantBuffers.size();
 	constantBuffers = new SimpleConstantBuffer[constantBufferCount];
-	
+
 	// Handle bound resources (like shaders and samplers)
-	unsigned int resourceCount = shaderDesc.BoundResources;
+	unsigned int resourceCount = (unsigned int)reflection.Bindings.size();
 	for (unsigned int r = 0; r < resourceCount; r++)
 	{
 		// Get this resource's description
-		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
-		refl->GetResourceBindingDesc(r, &resourceDesc);
+		const ShaderBindingInfo& resourceDesc = reflection.Bindings[r];
 
 		// Check the type
-		switch (resourceDesc.Type)
+		switch ((D3D_SHADER_INPUT_TYPE)resourceDesc.Type)
 		{
 		case D3D_SIT_STRUCTURED: // Treat structured buffers as texture resources
 		case D3D_SIT_TEXTURE: // A texture resource
@@ -161,71 +178,62 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 			samplerStates.push_back(samp);
 		}
 			break;
+
+		default:
+			break;
 		}
 	}
 
 	// Loop through all constant buffers
 	for (unsigned int b = 0; b < constantBufferCount; b++)
 	{
-		// Get this buffer
-		ID3D11ShaderReflectionConstantBuffer* cb =
-			refl->GetConstantBufferByIndex(b);
-		
 		// Get the description of this buffer
-		D3D11_SHADER_BUFFER_DESC bufferDesc;
-		cb->GetDesc(&bufferDesc);
+		const ShaderBufferInfo& bufferDesc = reflection.ConstantBuffers[b];
 
 		// Save the type, which we reference when setting these buffers
-		constantBuffers[b].Type = bufferDesc.Type;
-		
-		// Get the description of the resource binding, so
-		// we know exactly how it's bound in the shader
-		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
-		refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
-		
-		// Set up the buffer and put its pointer in the table
-		constantBuffers[b].BindIndex = bindDesc.BindPoint;
+		constantBuffers[b].Type = (D3D_CBUFFER_TYPE)bufferDesc.Type;
+
+		// Set up the buffer and put its pointer in the table - the
+		// bind point comes from the resource binding of the same name
+		constantBuffers[b].BindIndex = bufferDesc.BindPoint;
 		constantBuffers[b].Name = bufferDesc.Name;
 		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
 
-		// Create this constant buffer
-		D3D11_BUFFER_DESC newBuffDesc = {};
-		newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
-		newBuffDesc.ByteWidth = bufferDesc.Size;
-		newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-		newBuffDesc.CPUAccessFlags = 0;
-		newBuffDesc.MiscFlags = 0;
-		newBuffDesc.StructureByteStride = 0;
-		device->CreateBuffer(&newBuffDesc, 0, constantBuffers[b].ConstantBuffer.GetAddressOf());
-
 		// Set up the data buffer for this constant buffer
 		constantBuffers[b].Size = bufferDesc.Size;
+		constantBuffers[b].LayoutHash = DxbcReflection::LayoutHash(bufferDesc);
 		constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
 		ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
 
+		// Create this constant buffer
+		CreateConstantBuffer(&constantBuffers[b]);
+
 		// Loop through all variables in this buffer
-		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
+		for (unsigned int v = 0; v < (unsigned int)bufferDesc.Variables.size(); v++)
 		{
-			// Get this variable
-			ID3D11ShaderReflectionVariable* var =
-				cb->GetVariableByIndex(v);
-			
-			// Get the description of the variable and its type
-			D3D11_SHADER_VARIABLE_DESC varDesc;
-			var->GetDesc(&varDesc);
+			// Get the description of the variable
+			const ShaderVariableInfo& varDesc = bufferDesc.Variables[v];
 
 			// Create the variable struct
 			SimpleShaderVariable varStruct = {};
 			varStruct.ConstantBufferIndex = b;
 			varStruct.ByteOffset = varDesc.StartOffset;
 			varStruct.Size = varDesc.Size;
-			
-			// Get a string version
-			std::string varName(varDesc.Name);
 
 			// Add this variable to the table and the constant buffer
-			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
+			std::pair<std::unordered_map<std::string, SimpleShaderVariable>::iterator, bool> added =
+				varTable.insert(std::pair<std::string, SimpleShaderVariable>(varDesc.Name, varStruct));
 			constantBuffers[b].Variables.push_back(varStruct);
+
+			// Index it by hash as well, for GetParameter().  Names that
+			// share a hash are marked so they fall back to the name table
+			unsigned int hash = SimpleShaderName::HashText(varDesc.Name.c_str());
+			std::unordered_map<unsigned int, const std::pair<const std::string, SimpleShaderVariable>*>::iterator existing =
+				varHashTable.find(hash);
+			if (existing == varHashTable.end())
+				varHashTable.insert(std::make_pair(hash, &*added.first));
+			else if (existing->second != &*added.first)
+				existing->second = 0;
 		}
 	}
 
@@ -233,6 +241,59 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 	return true;
 }
 
+// --------------------------------------------------------
+// Fills in the reflection data for the loaded blob, from the
+// cache when it has this exact bytecode and otherwise by
+// parsing the DXBC container directly
+//
+// Returns false if the blob can't be parsed (not DXBC, or
+// compiled with reflection stripped)
+// --------------------------------------------------------
+bool ISimpleShader::Reflect()
+{
+	const void* bytes = shaderBlob->GetBufferPointer();
+	size_t size = shaderBlob->GetBufferSize();
+
+	if (ReflectionCache && ReflectionCache->Get(bytes, size, reflection))
+		return true;
+
+	if (!DxbcReflection::Parse(bytes, size, reflection))
+		return false;
+
+#if defined(DEBUG) || defined(_DEBUG)
+	// Check the parser against the D3D reflection API while it's
+	// around, so a container it misreads shows up right away
+	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
+	D3D11_SHADER_DESC shaderDesc = {};
+	if (SUCCEEDED(D3DReflect(bytes, size, IID_ID3D11ShaderReflection, (void**)refl.GetAddressOf())) &&
+		SUCCEEDED(refl->GetDesc(&shaderDesc)))
+	{
+		bool matches =
+			shaderDesc.Version == reflection.Version &&
+			shaderDesc.ConstantBuffers == reflection.ConstantBuffers.size() &&
+			shaderDesc.BoundResources == reflection.Bindings.size() &&
+			shaderDesc.InputParameters == reflection.Inputs.size() &&
+			shaderDesc.OutputParameters == reflection.Outputs.size();
+
+		for (unsigned int b = 0; matches && b < shaderDesc.ConstantBuffers; b++)
+		{
+			D3D11_SHADER_BUFFER_DESC bufferDesc;
+			refl->GetConstantBufferByIndex(b)->GetDesc(&bufferDesc);
+			matches = reflection.ConstantBuffers[b].Size == bufferDesc.Size &&
+				reflection.ConstantBuffers[b].Variables.size() == bufferDesc.Variables;
+		}
+
+		if (!matches && ReportWarnings)
+			LogWarning("SimpleShader::Reflect() - DXBC reflection doesn't match D3DReflect for this shader.\n");
+	}
+#endif
+
+	if (ReflectionCache)
+		ReflectionCache->Put(bytes, size, reflection);
+
+	return true;
+}
+
 // --------------------------------------------------------
 // Helper for looking up a variable by name and also
 // verifying that it is the requested size
@@ -240,7 +301,7 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 // name - the name of the variable to look for
 // size - the size of the variable (for verification), or -1 to bypass
 // --------------------------------------------------------
-SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
+SimpleShaderVariable* ISimpleShader::FindVariable(const std::string& name, int size)
 {
 	// Look for the key
 	std::unordered_map<std::string, SimpleShaderVariable>::iterator result =
@@ -345,14 +406,9 @@ void ISimpleShader::CopyAllBufferData()
 	// Ensure the shader is valid
 	if (!shaderValid) return;
 
-	// Loop through the constant buffers and copy all data
+	// Loop through the constant buffers and copy whatever changed
 	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer.Get(), 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
-	}
+		UploadBuffer(&constantBuffers[i]);
 }
 
 // --------------------------------------------------------
@@ -375,14 +431,8 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 	if(index >= this->constantBufferCount)
 		return;
 
-	// Check for the buffer
-	SimpleConstantBuffer* cb = &this->constantBuffers[index];
-	if (!cb) return;
-
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	UploadBuffer(&this->constantBuffers[index]);
 }
 
 // --------------------------------------------------------
@@ -402,9 +452,144 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	if (!cb) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	UploadBuffer(cb);
+}
+
+// --------------------------------------------------------
+// Changes how a constant buffer is copied to the GPU.  The
+// buffer is recreated (and fully copied next time), so set
+// this up front - not while the shader is bound
+//
+// index - The index of the buffer (see CopyBufferData)
+// mode  - UpdateSubresource or MapDiscard
+//
+// Returns true if the buffer was recreated
+// --------------------------------------------------------
+bool ISimpleShader::SetBufferUploadMode(unsigned int index, SimpleUploadMode mode)
+{
+	// Ensure the shader is valid
+	if (!shaderValid || index >= constantBufferCount)
+		return false;
+
+	SimpleConstantBuffer* cb = &constantBuffers[index];
+	if (cb->UploadMode == mode)
+		return true;
+
+	cb->UploadMode = mode;
+	return CreateConstantBuffer(cb);
+}
+
+// --------------------------------------------------------
+// Changes how a constant buffer is copied to the GPU, by name
+// --------------------------------------------------------
+bool ISimpleShader::SetBufferUploadMode(std::string bufferName, SimpleUploadMode mode)
+{
+	// Check for the buffer
+	SimpleConstantBuffer* cb = this->FindConstantBuffer(bufferName);
+	if (!cb) return false;
+
+	return SetBufferUploadMode((unsigned int)(cb - constantBuffers), mode);
+}
+
+// --------------------------------------------------------
+// Ends the frame's constant buffer counters - call once a
+// frame, before anything is drawn
+// --------------------------------------------------------
+void ISimpleShader::ResetUploadStats()
+{
+	LastFrameUploadStats = UploadStats;
+	UploadStats = SimpleUploadStats();
+}
+
+// --------------------------------------------------------
+// (Re)creates a constant buffer for its upload mode.  The
+// whole buffer counts as dirty afterwards
+// --------------------------------------------------------
+bool ISimpleShader::CreateConstantBuffer(SimpleConstantBuffer* cb)
+{
+	bool dynamic = cb->UploadMode == SimpleUploadMode::MapDiscard;
+
+	D3D11_BUFFER_DESC newBuffDesc = {};
+	newBuffDesc.Usage = dynamic ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_DEFAULT;
+	newBuffDesc.ByteWidth = cb->Size;
+	newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	newBuffDesc.CPUAccessFlags = dynamic ? (UINT)D3D11_CPU_ACCESS_WRITE : 0;
+	newBuffDesc.MiscFlags = 0;
+	newBuffDesc.StructureByteStride = 0;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	HRESULT hr = device->CreateBuffer(&newBuffDesc, 0, buffer.GetAddressOf());
+	if (FAILED(hr))
+	{
+		if (ReportErrors)
+		{
+			LogError("SimpleShader::CreateConstantBuffer() - Error creating constant buffer '");
+			Log(cb->Name);
+			LogError("'.\n");
+		}
+		return false;
+	}
+
+	cb->ConstantBuffer = buffer;
+	cb->DirtyStart = 0;
+	cb->DirtyEnd = cb->Size;
+	return true;
+}
+
+// --------------------------------------------------------
+// Copies a constant buffer's dirty data to the GPU, or does
+// nothing if it hasn't changed since the last copy
+// --------------------------------------------------------
+void ISimpleShader::UploadBuffer(SimpleConstantBuffer* cb)
+{
+	if (cb->DirtyStart >= cb->DirtyEnd)
+	{
+		UploadStats.Skipped++;
+		return;
+	}
+
+	if (cb->UploadMode == SimpleUploadMode::MapDiscard)
+	{
+		// Discarding means the whole buffer has to be written
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		if (FAILED(deviceContext->Map(cb->ConstantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+			return;
+		memcpy(mapped.pData, cb->LocalDataBuffer, cb->Size);
+		deviceContext->Unmap(cb->ConstantBuffer.Get(), 0);
+
+		UploadStats.Maps++;
+		UploadStats.BytesUploaded += cb->Size;
+	}
+	else if (partialUpdates && (cb->DirtyStart > 0 || cb->DirtyEnd < cb->Size))
+	{
+		// Partial updates go in whole 16 byte registers
+		D3D11_BOX box = {};
+		box.left = cb->DirtyStart & ~15u;
+		box.right = (std::min)((cb->DirtyEnd + 15) & ~15u, cb->Size);
+		box.top = 0;
+		box.bottom = 1;
+		box.front = 0;
+		box.back = 1;
+		deviceContext1->UpdateSubresource1(
+			cb->ConstantBuffer.Get(), 0, &box,
+			cb->LocalDataBuffer + box.left, 0, 0, 0);
+
+		UploadStats.PartialUploads++;
+		UploadStats.BytesUploaded += box.right - box.left;
+	}
+	else
+	{
+		// Copy the entire local data buffer
+		deviceContext->UpdateSubresource(
+			cb->ConstantBuffer.Get(), 0, 0,
+			cb->LocalDataBuffer, 0, 0);
+
+		UploadStats.BytesUploaded += cb->Size;
+	}
+
+	UploadStats.Uploads++;
+	cb->DirtyStart = 0;
+	cb->DirtyEnd = 0;
 }
 
 
@@ -417,11 +602,11 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 //
 // Returns true if data is copied, false if variable doesn't exist
 // --------------------------------------------------------
-bool ISimpleShader::SetData(std::string name, const void* data, unsigned int size)
+bool ISimpleShader::SetData(const std::string& name, const void* data, unsigned int size)
 {
 	// Look for the variable and verify
-	SimpleShaderVariable* var = FindVariable(name, -1);
-	if (var == 0)
+	SimpleShaderParameter param = GetParameter(name.c_str());
+	if (!param.IsValid())
 	{
 		if (ReportWarnings)
 		{
@@ -432,33 +617,14 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 		return false;
 	}
 
-	// Ensure we're not trying to copy more data than the variable can hold
-	// Note: We can copy less data, in the case of a subset of an array
-	if (size > var->Size)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleShader::SetData() - Shader variable '");
-			Log(name);
-			LogWarning("' is smaller than the size of the data being set. Ensure the variable is large enough for the specified data.\n");
-		}
-		return false;
-	}
-
-	// Set the data in the local data buffer
-	memcpy(
-		constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
-		data,
-		size);
-
-	// Success
-	return true;
+	// The rest is the same as setting it through a parameter
+	return SetData(param, data, size);
 }
 
 // --------------------------------------------------------
 // Sets INTEGER data
 // --------------------------------------------------------
-bool ISimpleShader::SetInt(std::string name, int data)
+bool ISimpleShader::SetInt(const std::string& name, int data)
 {
 	return this->SetData(name, (void*)(&data), sizeof(int));
 }
@@ -466,7 +632,7 @@ bool ISimpleShader::SetInt(std::string name, int data)
 // --------------------------------------------------------
 // Sets a FLOAT variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat(std::string name, float data)
+bool ISimpleShader::SetFloat(const std::string& name, float data)
 {
 	return this->SetData(name, (void*)(&data), sizeof(float));
 }
@@ -474,7 +640,7 @@ bool ISimpleShader::SetFloat(std::string name, float data)
 // --------------------------------------------------------
 // Sets a FLOAT2 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat2(std::string name, const float data[2])
+bool ISimpleShader::SetFloat2(const std::string& name, const float data[2])
 {
 	return this->SetData(name, (void*)data, sizeof(float) * 2);
 }
@@ -482,7 +648,7 @@ bool ISimpleShader::SetFloat2(std::string name, const float data[2])
 // --------------------------------------------------------
 // Sets a FLOAT2 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat2(std::string name, const DirectX::XMFLOAT2 data)
+bool ISimpleShader::SetFloat2(const std::string& name, const DirectX::XMFLOAT2 data)
 {
 	return this->SetData(name, &data, sizeof(float) * 2);
 }
@@ -490,7 +656,7 @@ bool ISimpleShader::SetFloat2(std::string name, const DirectX::XMFLOAT2 data)
 // --------------------------------------------------------
 // Sets a FLOAT3 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat3(std::string name, const float data[3])
+bool ISimpleShader::SetFloat3(const std::string& name, const float data[3])
 {
 	return this->SetData(name, (void*)data, sizeof(float) * 3);
 }
@@ -498,7 +664,7 @@ bool ISimpleShader::SetFloat3(std::string name, const float data[3])
 // --------------------------------------------------------
 // Sets a FLOAT3 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat3(std::string name, const DirectX::XMFLOAT3 data)
+bool ISimpleShader::SetFloat3(const std::string& name, const DirectX::XMFLOAT3 data)
 {
 	return this->SetData(name, &data, sizeof(float) * 3);
 }
@@ -506,7 +672,7 @@ bool ISimpleShader::SetFloat3(std::string name, const DirectX::XMFLOAT3 data)
 // --------------------------------------------------------
 // Sets a FLOAT4 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat4(std::string name, const float data[4])
+bool ISimpleShader::SetFloat4(const std::string& name, const float data[4])
 {
 	return this->SetData(name, (void*)data, sizeof(float) * 4);
 }
@@ -514,7 +680,7 @@ bool ISimpleShader::SetFloat4(std::string name, const float data[4])
 // --------------------------------------------------------
 // Sets a FLOAT4 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat4(std::string name, const DirectX::XMFLOAT4 data)
+bool ISimpleShader::SetFloat4(const std::string& name, const DirectX::XMFLOAT4 data)
 {
 	return this->SetData(name, &data, sizeof(float) * 4);
 }
@@ -522,7 +688,7 @@ bool ISimpleShader::SetFloat4(std::string name, const DirectX::XMFLOAT4 data)
 // --------------------------------------------------------
 // Sets a MATRIX (4x4) variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetMatrix4x4(std::string name, const float data[16])
+bool ISimpleShader::SetMatrix4x4(const std::string& name, const float data[16])
 {
 	return this->SetData(name, (void*)data, sizeof(float) * 16);
 }
@@ -530,11 +696,207 @@ bool ISimpleShader::SetMatrix4x4(std::string name, const float data[16])
 // --------------------------------------------------------
 // Sets a MATRIX (4x4) variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data)
+bool ISimpleShader::SetMatrix4x4(const std::string& name, const DirectX::XMFLOAT4X4& data)
 {
 	return this->SetData(name, &data, sizeof(float) * 16);
 }
 
+// --------------------------------------------------------
+// Resolves a variable to a parameter that can be set without
+// looking it up again.  Resolve once (at load, or when a
+// material's shader changes) and keep the result
+//
+// name - The variable's name.  A constexpr SimpleShaderName
+//        has its hash computed at compile time
+//
+// Returns an invalid parameter if the variable doesn't exist
+// --------------------------------------------------------
+SimpleShaderParameter ISimpleShader::GetParameter(SimpleShaderName name)
+{
+	SimpleShaderParameter param;
+
+	// Look for the hash, then make sure it's really this name
+	std::unordered_map<unsigned int, const std::pair<const std::string, SimpleShaderVariable>*>::iterator result =
+		varHashTable.find(name.Hash);
+	if (result == varHashTable.end())
+		return param;
+
+	const SimpleShaderVariable* var = 0;
+	if (result->second == 0)
+		var = FindVariable(name.Text, -1);
+	else if (result->second->first == name.Text)
+		var = &result->second->second;
+
+	if (var == 0)
+		return param;
+
+	param.ConstantBufferIndex = var->ConstantBufferIndex;
+	param.ByteOffset = var->ByteOffset;
+	param.Size = var->Size;
+	return param;
+}
+
+// --------------------------------------------------------
+// Sets a resolved variable with arbitrary data of the specified size
+//
+// param - A parameter from this shader's GetParameter()
+// data  - The data to set in the buffer
+// size  - The size of the data (this must be less than or equal to the variable's size)
+//
+// Returns true if data is copied, false if the parameter is invalid
+// --------------------------------------------------------
+bool ISimpleShader::SetData(SimpleShaderParameter param, const void* data, unsigned int size)
+{
+	// Unresolved (the shader doesn't have the variable) - nothing to do
+	if (!param.IsValid())
+		return false;
+
+	// Ensure we're not trying to copy more data than the variable can hold,
+	// and that the parameter really fits this shader's buffer
+	// Note: We can copy less data, in the case of a subset of an array
+	if (size > param.Size ||
+		param.ConstantBufferIndex >= constantBufferCount ||
+		param.ByteOffset + size > constantBuffers[param.ConstantBufferIndex].Size)
+	{
+		if (ReportWarnings)
+			LogWarning("SimpleShader::SetData() - Data doesn't fit the shader variable. Ensure the variable is large enough for the specified data and that the parameter came from this shader.\n");
+		return false;
+	}
+
+	// Nothing to do if it's the same data (the usual case for per-frame values set every draw)
+	SimpleConstantBuffer* cb = &constantBuffers[param.ConstantBufferIndex];
+	unsigned char* dest = cb->LocalDataBuffer + param.ByteOffset;
+	if (memcmp(dest, data, size) == 0)
+		return true;
+
+	// Set the data in the local data buffer and widen the dirty range to cover it
+	memcpy(dest, data, size);
+	if (cb->DirtyStart >= cb->DirtyEnd)
+	{
+		cb->DirtyStart = param.ByteOffset;
+		cb->DirtyEnd = param.ByteOffset + size;
+	}
+	else
+	{
+		cb->DirtyStart = (std::min)(cb->DirtyStart, param.ByteOffset);
+		cb->DirtyEnd = (std::max)(cb->DirtyEnd, param.ByteOffset + size);
+	}
+
+	// Success
+	return true;
+}
+
+// --------------------------------------------------------
+// Sets INTEGER data through a resolved parameter
+// --------------------------------------------------------
+bool ISimpleShader::SetInt(SimpleShaderParameter param, int data)
+{
+	return this->SetData(param, &data, sizeof(int));
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT variable through a resolved parameter
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat(SimpleShaderParameter param, float data)
+{
+	return this->SetData(param, &data, sizeof(float));
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT2 variable through a resolved parameter
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat2(SimpleShaderParameter param, const DirectX::XMFLOAT2 data)
+{
+	return this->SetData(param, &data, sizeof(float) * 2);
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT3 variable through a resolved parameter
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat3(SimpleShaderParameter param, const DirectX::XMFLOAT3 data)
+{
+	return this->SetData(param, &data, sizeof(float) * 3);
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT4 variable through a resolved parameter
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat4(SimpleShaderParameter param, const DirectX::XMFLOAT4 data)
+{
+	return this->SetData(param, &data, sizeof(float) * 4);
+}
+
+// --------------------------------------------------------
+// Sets a MATRIX (4x4) variable through a resolved parameter
+// --------------------------------------------------------
+bool ISimpleShader::SetMatrix4x4(SimpleShaderParameter param, const DirectX::XMFLOAT4X4& data)
+{
+	return this->SetData(param, &data, sizeof(float) * 16);
+}
+
+// --------------------------------------------------------
+// Sets a whole constant buffer by name - see SetBuffer()
+// --------------------------------------------------------
+bool ISimpleShader::SetBufferData(std::string bufferName, uint64_t layoutHash, const void* data, unsigned int size)
+{
+	SimpleConstantBuffer* cb = this->FindConstantBuffer(bufferName);
+	if (!cb)
+	{
+		if (ReportWarnings)
+		{
+			LogWarning("SimpleShader::SetBufferData() - Constant buffer '");
+			Log(bufferName);
+			LogWarning("' not found.\n");
+		}
+		return false;
+	}
+
+	return SetBufferData((unsigned int)(cb - constantBuffers), layoutHash, data, size);
+}
+
+// --------------------------------------------------------
+// Sets a whole constant buffer by index
+//
+// The size and layout hash must both match the buffer - a
+// generated struct that's out of date with its shader is an
+// error rather than silently scrambled constants
+// --------------------------------------------------------
+bool ISimpleShader::SetBufferData(unsigned int index, uint64_t layoutHash, const void* data, unsigned int size)
+{
+	if (index >= constantBufferCount)
+	{
+		if (ReportWarnings)
+			LogWarning("SimpleShader::SetBufferData() - Constant buffer index out of range.\n");
+		return false;
+	}
+
+	SimpleConstantBuffer* cb = &constantBuffers[index];
+	if (size != cb->Size || layoutHash != cb->LayoutHash)
+	{
+		// The buffer keeps its old contents, so this is always reported in
+		// debug builds (once per buffer) - even with ReportErrors off
+		bool report = ReportErrors;
+	#if defined(DEBUG) || defined(_DEBUG)
+		report = report || !cb->LayoutMismatchReported;
+		cb->LayoutMismatchReported = true;
+	#endif
+		if (report)
+		{
+			LogError("SimpleShader::SetBufferData() - Struct doesn't match the layout of constant buffer '");
+			Log(cb->Name);
+			LogError("'. Rebuild so ShaderConstants.h is regenerated from the compiled shaders - nothing was set.\n");
+		}
+		return false;
+	}
+
+	// The whole buffer as one parameter - one compare, one copy
+	SimpleShaderParameter whole;
+	whole.ConstantBufferIndex = index;
+	whole.ByteOffset = 0;
+	whole.Size = cb->Size;
+	return SetData(whole, data, size);
+}
+
 // --------------------------------------------------------
 // Determines if the shader contains the specified
 // variable within one of its constant buffers
@@ -767,32 +1129,19 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 		return true;
 
 	// Vertex shader was created successfully, so we now use the
-	// shader code to re-reflect and create an input layout that 
+	// input signature from reflection to create an input layout that 
 	// matches what the vertex shader expects.  Code adapted from:
 	// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
 
-	// Reflect shader info
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-	
-	// Get shader info
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
 	// Read input layout description from shader info
 	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
-	for (unsigned int i = 0; i< shaderDesc.InputParameters; i++)
+	for (unsigned int i = 0; i < (unsigned int)reflection.Inputs.size(); i++)
 	{
-		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
-		refl->GetInputParameterDesc(i, &paramDesc);
+		const ShaderSignatureElement& paramDesc = reflection.Inputs[i];
 
 		// Check the semantic name for "_PER_INSTANCE"
 		std::string perInstanceStr = "_PER_INSTANCE";
-		std::string sem = paramDesc.SemanticName;
+		const std::string& sem = paramDesc.SemanticName;
 		int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
 		bool isPerInstance = 
 			lenDiff >= 0 &&
@@ -800,7 +1149,7 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 
 		// Fill out input element desc
 		D3D11_INPUT_ELEMENT_DESC elementDesc = {};
-		elementDesc.SemanticName = paramDesc.SemanticName;
+		elementDesc.SemanticName = paramDesc.SemanticName.c_str();
 		elementDesc.SemanticIndex = paramDesc.SemanticIndex;
 		elementDesc.InputSlot = 0;
 		elementDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
@@ -1455,31 +1804,18 @@ bool SimpleGeometryShader::CreateShaderWithStreamOut(Microsoft::WRL::ComPtr<ID3D
 	// called more than once on the same object
 	this->CleanUp();
 
-	// Reflect shader info
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-
-	// Get shader info
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
-	// Set up the output signature
+	// Set up the output signature, from reflection
 	streamOutVertexSize = 0;
 	std::vector<D3D11_SO_DECLARATION_ENTRY> soDecl;
-	for (unsigned int i = 0; i < shaderDesc.OutputParameters; i++)
+	for (unsigned int i = 0; i < (unsigned int)reflection.Outputs.size(); i++)
 	{
 		// Get the info about this entry
-		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
-		refl->GetOutputParameterDesc(i, &paramDesc);
+		const ShaderSignatureElement& paramDesc = reflection.Outputs[i];
 		
 		// Create the SO Declaration
 		D3D11_SO_DECLARATION_ENTRY entry = {};
 		entry.SemanticIndex  = paramDesc.SemanticIndex;
-		entry.SemanticName   = paramDesc.SemanticName;
+		entry.SemanticName   = paramDesc.SemanticName.c_str();
 		entry.Stream         = paramDesc.Stream;
 		entry.StartComponent = 0; // Assume starting at 0
 		entry.OutputSlot     = 0; // Assume the first output slot
@@ -1730,34 +2066,21 @@ bool SimpleComputeShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBl
 	if (result != S_OK)
 		return false;
 
-	// Set up shader reflection to get information about UAV's
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-
-	// Get the description of the shader
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-	
 	// Grab the thread info
-	threadsTotal = refl->GetThreadGroupSize(
-		&threadsX,
-		&threadsY,
-		&threadsZ);
+	threadsX = reflection.ThreadGroup[0];
+	threadsY = reflection.ThreadGroup[1];
+	threadsZ = reflection.ThreadGroup[2];
+	threadsTotal = reflection.GetThreadGroupSize();
 
 	// Loop and get all UAV resources
-	unsigned int resourceCount = shaderDesc.BoundResources;
+	unsigned int resourceCount = (unsigned int)reflection.Bindings.size();
 	for (unsigned int r = 0; r < resourceCount; r++)
 	{
 		// Get this resource's description
-		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
-		refl->GetResourceBindingDesc(r, &resourceDesc);
+		const ShaderBindingInfo& resourceDesc = reflection.Bindings[r];
 
 		// Check the type, looking for any kind of UAV
-		switch (resourceDesc.Type)
+		switch ((D3D_SHADER_INPUT_TYPE)resourceDesc.Type)
 		{
 		case D3D_SIT_UAV_APPEND_STRUCTURED:
 		case D3D_SIT_UAV_CONSUME_STRUCTURED:
@@ -1766,6 +2089,10 @@ bool SimpleComputeShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBl
 		case D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER:
 		case D3D_SIT_UAV_RWTYPED:
 			uavTable.insert(std::pair<std::string, unsigned int>(resourceDesc.Name, resourceDesc.BindPoint));
+			break;
+
+		default:
+			break;
 		}
 	}
 
@@ -3,10 +3,14 @@
 #pragma comment(lib, "d3dcompiler.lib")
 
 #include <d3d11.h>
+#include <d3d11_1.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
 #include <wrl/client.h>
 
+#include "DxbcReflection.h"
+#include "ShaderReflectionCache.h"
+
 #include <unordered_map>
 #include <vector>
 #include <string>
@@ -23,6 +27,73 @@ struct SimpleShaderVariable
 	unsigned int ConstantBufferIndex;
 };
 
+// --------------------------------------------------------
+// A variable name along with its hash (32-bit FNV-1a).
+// Declared constexpr, the hash is computed at compile time:
+//
+//   constexpr SimpleShaderName worldName("world");
+//
+// Used to resolve a SimpleShaderParameter
+// --------------------------------------------------------
+struct SimpleShaderName
+{
+	const char* Text;
+	unsigned int Hash;
+
+	constexpr SimpleShaderName(const char* text) : Text(text), Hash(HashText(text)) {}
+
+	static constexpr unsigned int HashText(const char* text)
+	{
+		unsigned int hash = 2166136261u;
+		for (; *text; text++)
+			hash = (hash ^ (unsigned char)*text) * 16777619u;
+		return hash;
+	}
+};
+
+// --------------------------------------------------------
+// A variable resolved ahead of time, so setting it is a
+// bounds check and a copy instead of a string lookup.
+// Only valid for the shader that resolved it
+// --------------------------------------------------------
+struct SimpleShaderParameter
+{
+	unsigned int ConstantBufferIndex = 0xFFFFFFFF;
+	unsigned int ByteOffset = 0;
+	unsigned int Size = 0;
+
+	bool IsValid() const { return ConstantBufferIndex != 0xFFFFFFFF; }
+};
+
+// --------------------------------------------------------
+// How a constant buffer's local data gets to the GPU
+//
+// UpdateSubresource - A default-usage buffer updated with
+//                     UpdateSubresource, only the dirty range
+//                     when the driver allows partial updates.
+//                     Best for data that rarely changes
+// MapDiscard        - A dynamic buffer rewritten whole with
+//                     Map(WRITE_DISCARD).  Best for data that
+//                     changes nearly every time it's copied
+// --------------------------------------------------------
+enum class SimpleUploadMode
+{
+	UpdateSubresource,
+	MapDiscard
+};
+
+// --------------------------------------------------------
+// Constant buffer traffic across every shader, for one frame
+// --------------------------------------------------------
+struct SimpleUploadStats
+{
+	unsigned int Uploads = 0;			// Buffers actually copied to the GPU
+	unsigned int PartialUploads = 0;	// ...of which only the dirty range went
+	unsigned int Maps = 0;				// ...of which went through Map(WRITE_DISCARD)
+	unsigned int Skipped = 0;			// Copies asked for on buffers that hadn't changed
+	size_t BytesUploaded = 0;
+};
+
 // --------------------------------------------------------
 // Contains information about a specific
 // constant buffer in a shader, as well as
@@ -37,6 +108,11 @@ struct SimpleConstantBuffer
 	Microsoft::WRL::ComPtr<ID3D11Buffer> ConstantBuffer = 0;
 	unsigned char* LocalDataBuffer = 0;
 	std::vector<SimpleShaderVariable> Variables;
+	SimpleUploadMode UploadMode = SimpleUploadMode::UpdateSubresource;
+	unsigned int DirtyStart = 0;	// Bytes [DirtyStart, DirtyEnd) of the local data
+	unsigned int DirtyEnd = 0;		// changed since the last copy - empty when equal
+	uint64_t LayoutHash = 0;		// DxbcReflection::LayoutHash - matches the generated struct's
+	bool LayoutMismatchReported = false;
 };
 
 // --------------------------------------------------------
@@ -75,19 +151,46 @@ public:
 	void CopyBufferData(unsigned int index);
 	void CopyBufferData(std::string bufferName);
 
+	// Picks how a buffer is copied to the GPU (the buffer is
+	// recreated, so do this before the shader is used)
+	bool SetBufferUploadMode(unsigned int index, SimpleUploadMode mode);
+	bool SetBufferUploadMode(std::string bufferName, SimpleUploadMode mode);
+
 	// Sets arbitrary shader data
-	bool SetData(std::string name, const void* data, unsigned int size);
-
-	bool SetInt(std::string name, int data);
-	bool SetFloat(std::string name, float data);
-	bool SetFloat2(std::string name, const float data[2]);
-	bool SetFloat2(std::string name, const DirectX::XMFLOAT2 data);
-	bool SetFloat3(std::string name, const float data[3]);
-	bool SetFloat3(std::string name, const DirectX::XMFLOAT3 data);
-	bool SetFloat4(std::string name, const float data[4]);
-	bool SetFloat4(std::string name, const DirectX::XMFLOAT4 data);
-	bool SetMatrix4x4(std::string name, const float data[16]);
-	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
+	bool SetData(const std::string& name, const void* data, unsigned int size);
+
+	bool SetInt(const std::string& name, int data);
+	bool SetFloat(const std::string& name, float data);
+	bool SetFloat2(const std::string& name, const float data[2]);
+	bool SetFloat2(const std::string& name, const DirectX::XMFLOAT2 data);
+	bool SetFloat3(const std::string& name, const float data[3]);
+	bool SetFloat3(const std::string& name, const DirectX::XMFLOAT3 data);
+	bool SetFloat4(const std::string& name, const float data[4]);
+	bool SetFloat4(const std::string& name, const DirectX::XMFLOAT4 data);
+	bool SetMatrix4x4(const std::string& name, const float data[16]);
+	bool SetMatrix4x4(const std::string& name, const DirectX::XMFLOAT4X4& data);
+
+	// Resolves a variable once, for the setters below.  Returns
+	// an invalid parameter if the shader has no such variable
+	SimpleShaderParameter GetParameter(SimpleShaderName name);
+
+	// Sets data through a resolved parameter - no lookup
+	bool SetData(SimpleShaderParameter param, const void* data, unsigned int size);
+
+	bool SetInt(SimpleShaderParameter param, int data);
+	bool SetFloat(SimpleShaderParameter param, float data);
+	bool SetFloat2(SimpleShaderParameter param, const DirectX::XMFLOAT2 data);
+	bool SetFloat3(SimpleShaderParameter param, const DirectX::XMFLOAT3 data);
+	bool SetFloat4(SimpleShaderParameter param, const DirectX::XMFLOAT4 data);
+	bool SetMatrix4x4(SimpleShaderParameter param, const DirectX::XMFLOAT4X4& data);
+
+	// Sets a whole constant buffer from its generated struct (see
+	// ShaderConstants.h) - one copy, and a struct whose layout
+	// doesn't match this shader's buffer is refused
+	template<typename T> bool SetBuffer(const T& data) { return SetBufferData(T::BufferName, T::LayoutHash, &data, sizeof(T)); }
+	template<typename T> bool SetBuffer(unsigned int index, const T& data) { return SetBufferData(index, T::LayoutHash, &data, sizeof(T)); }
+	bool SetBufferData(std::string bufferName, uint64_t layoutHash, const void* data, unsigned int size);
+	bool SetBufferData(unsigned int index, uint64_t layoutHash, const void* data, unsigned int size);
 
 	// Setting shader resources
 	virtual bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv) = 0;
@@ -122,13 +225,27 @@ public:
 	static bool ReportErrors;
 	static bool ReportWarnings;
 
+	// Constant buffer traffic - UploadStats counts the current frame,
+	// and ResetUploadStats() (once a frame) moves it to LastFrameUploadStats
+	static SimpleUploadStats UploadStats;
+	static SimpleUploadStats LastFrameUploadStats;
+	static void ResetUploadStats();
+
+	// Reflection results from earlier runs (optional - null parses every shader)
+	static ShaderReflectionCache* ReflectionCache;
+
 protected:
 	
 	bool shaderValid;
 	Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob;
+	ShaderReflection reflection;	// Read from shaderBlob before CreateShader()
 	Microsoft::WRL::ComPtr<ID3D11Device> device;
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext;
 
+	// Set when the driver can update part of a constant buffer (D3D 11.1)
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> deviceContext1;
+	bool partialUpdates;
+
 	// Resource counts
 	unsigned int constantBufferCount;
 	
@@ -138,11 +255,13 @@ protected:
 	std::vector<SimpleSampler*>	samplerStates;
 	std::unordered_map<std::string, SimpleConstantBuffer*> cbTable;
 	std::unordered_map<std::string, SimpleShaderVariable> varTable;
+	std::unordered_map<unsigned int, const std::pair<const std::string, SimpleShaderVariable>*> varHashTable; // null = hash shared by two names
 	std::unordered_map<std::string, SimpleSRV*> textureTable;
 	std::unordered_map<std::string, SimpleSampler*> samplerTable;
 
-	// Initialization method
+	// Initialization methods
 	bool LoadShaderFile(LPCWSTR shaderFile);
+	bool Reflect();
 
 	// Pure virtual functions for dealing with shader types
 	virtual bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob) = 0;
@@ -150,8 +269,12 @@ protected:
 
 	virtual void CleanUp();
 
+	// Constant buffer helpers
+	bool CreateConstantBuffer(SimpleConstantBuffer* cb);
+	void UploadBuffer(SimpleConstantBuffer* cb);
+
 	// Helpers for finding data by name
-	SimpleShaderVariable* FindVariable(std::string name, int size);
+	SimpleShaderVariable* FindVariable(const std::string& name, int size);
 	SimpleConstantBuffer* FindConstantBuffer(std::string name);
 
 	// Error logging
@@ -0,0 +1,264 @@
+// --------------------------------------------------------
+// Standalone tests for SimpleShader's constant buffer uploads
+//
+// Not part of the game project (it has its own main) - build it
+// on its own, e.g. headless on Linux, against the stand-in
+// Direct3D headers in TestStubs:
+//
+//   g++ -std=c++14 -O2 -ITestStubs -o SimpleShaderUploadTest
+//       SimpleShaderUploadTest.cpp SimpleShader.cpp
+//       DxbcReflection.cpp ShaderReflectionCache.cpp MappedFile.cpp
+//
+// Usage:
+//   SimpleShaderUploadTest
+//
+// The stub device's buffers keep their bytes, and its context
+// applies (and counts) every update and map, so each path of
+// UploadBuffer is checked for what it sent as well as how:
+// skipped when nothing changed, a 16 byte aligned box through
+// UpdateSubresource1, the whole buffer through Map(DISCARD),
+// and the whole buffer through UpdateSubresource when partial
+// updates aren't available.  The shader's reflection is put in
+// a ShaderReflectionCache up front, so no compiled shader is
+// needed.  Returns 0 when everything passed
+// --------------------------------------------------------
+#include "SimpleShader.h"
+#include "ShaderReflectionCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool condition, const char* what, int line)
+	{
+		if (condition)
+			return;
+		printf("  FAILED (line %d): %s\n", line, what);
+		failures++;
+	}
+
+	#define CHECK(condition) Check((condition), #condition, __LINE__)
+
+	const char* ShaderFile = "SimpleShaderUploadTest.cso";
+	const wchar_t* ShaderFileW = L"SimpleShaderUploadTest.cso";
+
+	ShaderVariableInfo Variable(const char* name, uint32_t offset, uint32_t size)
+	{
+		ShaderVariableInfo variable;
+		variable.Name = name;
+		variable.StartOffset = offset;
+		variable.Size = size;
+		return variable;
+	}
+
+	// --------------------------------------------------------
+	// A pixel shader with an 80 byte PerFrame (b0) and a 32 byte
+	// PerObject (b1).  The "bytecode" is only there to be hashed
+	// --------------------------------------------------------
+	void WriteShader(ShaderReflectionCache& cache)
+	{
+		const char bytecode[] = "SimpleShaderUploadTest - reflection comes from the cache";
+		std::ofstream(ShaderFile, std::ios::binary).write(bytecode, sizeof(bytecode));
+
+		ShaderBufferInfo frame;
+		frame.Name = "PerFrame";
+		frame.Size = 80;
+		frame.BindPoint = 0;
+		frame.Variables.push_back(Variable("tint", 0, 16));
+		frame.Variables.push_back(Variable("fogStart", 20, 4));
+		frame.Variables.push_back(Variable("fogEnd", 40, 4));
+		frame.Variables.push_back(Variable("exposure", 76, 4));
+
+		ShaderBufferInfo object;
+		object.Name = "PerObject";
+		object.Size = 32;
+		object.BindPoint = 1;
+		object.Variables.push_back(Variable("color", 0, 16));
+		object.Variables.push_back(Variable("slice", 16, 4));
+
+		ShaderReflection reflection;
+		reflection.Version = 0x50;		// ps_5_0
+		reflection.ConstantBuffers.push_back(frame);
+		reflection.ConstantBuffers.push_back(object);
+		for (size_t b = 0; b < reflection.ConstantBuffers.size(); b++)
+		{
+			ShaderBindingInfo binding;
+			binding.Name = reflection.ConstantBuffers[b].Name;
+			binding.Type = D3D_SIT_CBUFFER;
+			binding.BindPoint = reflection.ConstantBuffers[b].BindPoint;
+			binding.BindCount = 1;
+			reflection.Bindings.push_back(binding);
+		}
+
+		cache.Put(bytecode, sizeof(bytecode), reflection);
+	}
+
+	// What the GPU has for a buffer is what was set locally
+	bool Matches(SimplePixelShader& shader, const char* buffer)
+	{
+		const SimpleConstantBuffer* cb = shader.GetBufferInfo(buffer);
+		ID3D11Buffer* gpu = cb->ConstantBuffer.Get();
+		return gpu && gpu->Data.size() == cb->Size && memcmp(gpu->Data.data(), cb->LocalDataBuffer, cb->Size) == 0;
+	}
+
+	void TestSkip(ID3D11Device* device, ID3D11DeviceContext1* context)
+	{
+		printf("Skip\n");
+		SimplePixelShader shader(device, context, ShaderFileW);
+		CHECK(shader.IsShaderValid());
+
+		//New buffers are dirty as a whole - the first copy sends everything
+		ISimpleShader::ResetUploadStats();
+		shader.CopyAllBufferData();
+		CHECK(ISimpleShader::UploadStats.Uploads == 2 && ISimpleShader::UploadStats.Skipped == 0);
+		CHECK(ISimpleShader::UploadStats.BytesUploaded == 80 + 32);
+		CHECK(context->Updates == 2 && !context->LastUpdateBoxed);
+
+		//Nothing changed, and setting the same value again doesn't count as a change
+		CHECK(shader.SetFloat("fogStart", 0.0f));
+		shader.CopyAllBufferData();
+		shader.CopyBufferData("PerObject");
+		CHECK(ISimpleShader::UploadStats.Uploads == 2 && ISimpleShader::UploadStats.Skipped == 3);
+		CHECK(context->Updates == 2 && context->PartialUpdates == 0);
+
+		//Last frame's numbers move over
+		ISimpleShader::ResetUploadStats();
+		CHECK(ISimpleShader::LastFrameUploadStats.Skipped == 3 && ISimpleShader::UploadStats.Skipped == 0);
+	}
+
+	void TestPartial(ID3D11Device* device, ID3D11DeviceContext1* context)
+	{
+		printf("Partial\n");
+		SimplePixelShader shader(device, context, ShaderFileW);
+		shader.CopyAllBufferData();
+		ISimpleShader::ResetUploadStats();
+
+		//One float in the middle of a register sends just that register
+		CHECK(shader.SetFloat("fogStart", 3.0f));
+		shader.CopyBufferData("PerFrame");
+		CHECK(context->PartialUpdates == 1 && context->LastUpdateBoxed);
+		CHECK(context->LastBox.left == 16 && context->LastBox.right == 32);
+		CHECK(ISimpleShader::UploadStats.PartialUploads == 1 && ISimpleShader::UploadStats.BytesUploaded == 16);
+		CHECK(Matches(shader, "PerFrame"));
+
+		//Two changes send the registers from the first to the last
+		CHECK(shader.SetFloat("fogStart", 4.0f));
+		CHECK(shader.SetFloat("fogEnd", 9.0f));
+		shader.CopyBufferData(0);
+		CHECK(context->PartialUpdates == 2 && context->LastBox.left == 16 && context->LastBox.right == 48);
+		CHECK(ISimpleShader::UploadStats.BytesUploaded == 16 + 32);
+		CHECK(Matches(shader, "PerFrame"));
+
+		//The last register is rounded up to the buffer's end, not past it
+		CHECK(shader.SetFloat("exposure", 1.5f));
+		shader.CopyAllBufferData();
+		CHECK(context->PartialUpdates == 3 && context->LastBox.left == 64 && context->LastBox.right == 80);
+		CHECK(Matches(shader, "PerFrame"));
+
+		//Everything changed - the whole buffer goes, without a box
+		int updates = context->Updates;
+		CHECK(shader.SetFloat4("color", DirectX::XMFLOAT4(1, 2, 3, 4)) && shader.SetInt("slice", 5));
+		const SimpleConstantBuffer* cb = shader.GetBufferInfo("PerObject");
+		CHECK(cb->DirtyStart == 0 && cb->DirtyEnd == 20);
+		shader.CopyBufferData("PerObject");
+		CHECK(context->PartialUpdates == 4 && context->LastBox.left == 0 && context->LastBox.right == 32);
+		CHECK(context->Updates == updates);
+		CHECK(Matches(shader, "PerObject"));
+		CHECK(ISimpleShader::UploadStats.Uploads == 4 && ISimpleShader::UploadStats.PartialUploads == 4);
+	}
+
+	void TestMapDiscard(ID3D11Device* device, ID3D11DeviceContext1* context)
+	{
+		printf("Map discard\n");
+		SimplePixelShader shader(device, context, ShaderFileW);
+		shader.CopyAllBufferData();
+
+		//Switching recreates the buffer as dynamic, dirty as a whole
+		int created = device->BuffersCreated;
+		CHECK(shader.SetBufferUploadMode("PerFrame", SimpleUploadMode::MapDiscard));
+		CHECK(device->BuffersCreated == created + 1);
+		CHECK(shader.GetBufferInfo("PerFrame")->ConstantBuffer->Desc.Usage == D3D11_USAGE_DYNAMIC);
+		CHECK(shader.SetBufferUploadMode(0, SimpleUploadMode::MapDiscard));
+		CHECK(device->BuffersCreated == created + 1);
+
+		ISimpleShader::ResetUploadStats();
+		CHECK(shader.SetFloat("tint", 2.0f));
+		shader.CopyAllBufferData();
+		CHECK(context->Maps == 1 && context->Unmaps == 1);
+		CHECK(ISimpleShader::UploadStats.Maps == 1 && ISimpleShader::UploadStats.Skipped == 1);
+		CHECK(Matches(shader, "PerFrame"));
+
+		//A discard loses the old contents, so one float still rewrites every byte
+		int partial = context->PartialUpdates;
+		CHECK(shader.SetFloat("fogEnd", 6.0f));
+		shader.CopyBufferData("PerFrame");
+		CHECK(context->Maps == 2 && context->PartialUpdates == partial);
+		CHECK(ISimpleShader::UploadStats.BytesUploaded == 80 + 80);
+		CHECK(Matches(shader, "PerFrame"));
+
+		//And back
+		CHECK(shader.SetBufferUploadMode("PerFrame", SimpleUploadMode::UpdateSubresource));
+		CHECK(shader.GetBufferInfo("PerFrame")->ConstantBuffer->Desc.Usage == D3D11_USAGE_DEFAULT);
+		shader.CopyBufferData("PerFrame");
+		CHECK(Matches(shader, "PerFrame") && context->Maps == 2);
+		CHECK(!shader.SetBufferUploadMode("Missing", SimpleUploadMode::MapDiscard));
+	}
+
+	// Without partial updates (the driver says no, or there's no 11.1 context) dirty ranges go whole
+	void TestFallback(ID3D11Device* device, ID3D11DeviceContext* context)
+	{
+		SimplePixelShader shader(device, context, ShaderFileW);
+		shader.CopyAllBufferData();
+		ISimpleShader::ResetUploadStats();
+
+		int updates = context->Updates;
+		CHECK(shader.SetFloat("fogEnd", 7.0f));
+		shader.CopyAllBufferData();
+		CHECK(context->Updates == updates + 1 && !context->LastUpdateBoxed);
+		CHECK(ISimpleShader::UploadStats.PartialUploads == 0 && ISimpleShader::UploadStats.BytesUploaded == 80);
+		CHECK(Matches(shader, "PerFrame"));
+	}
+}
+
+int main()
+{
+	ShaderReflectionCache cache;
+	WriteShader(cache);
+	ISimpleShader::ReflectionCache = &cache;
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> context;
+	device.Attach(new ID3D11Device());
+	context.Attach(new ID3D11DeviceContext1());
+
+	TestSkip(device.Get(), context.Get());
+	TestPartial(device.Get(), context.Get());
+	TestMapDiscard(device.Get(), context.Get());
+
+	printf("Fallback: no driver support\n");
+	device->PartialUpdates = FALSE;
+	TestFallback(device.Get(), context.Get());
+	CHECK(context->PartialUpdates == 4);
+
+	printf("Fallback: no 11.1 context\n");
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context10;
+	context10.Attach(new ID3D11DeviceContext());
+	device->PartialUpdates = TRUE;
+	TestFallback(device.Get(), context10.Get());
+
+	CHECK(cache.GetMisses() == 0);
+	ISimpleShader::ReflectionCache = nullptr;
+	remove(ShaderFile);
+
+	if (failures)
+	{
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("All passed\n");
+	return 0;
+}
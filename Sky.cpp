@@ -1,13 +1,20 @@
 #include "Sky.h"
+#include "ShaderConstants.h"
+#include <cstdio>
 
 using namespace DirectX;
 
-Sky::Sky(Mesh* mesh, SimpleVertexShader* vShader, SimplePixelShader* pShader, Microsoft::WRL::ComPtr<ID3D11SamplerState> sState, Microsoft::WRL::ComPtr<ID3D11Device> dev, const wchar_t* texturePath)
+unsigned int Sky::StartMipSize = 64;
+unsigned int Sky::MipsPerFrame = 1;
+
+Sky::Sky(Mesh* mesh, SimpleVertexShader* vShader, SimplePixelShader* pShader, Microsoft::WRL::ComPtr<ID3D11SamplerState> sState, Microsoft::WRL::ComPtr<ID3D11Device> dev, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, const char* texturePath, AssetPack* pack)
 {
 	skyboxMesh = mesh;
 	vertexShader = vShader;
 	pixelShader = pShader;
 	samplerState = sState;
+	device = dev;
+	residentMip = 0;
 
 	//Rasterizer State
 	D3D11_RASTERIZER_DESC rasterizerDesc = {};
@@ -21,11 +28,128 @@ Sky::Sky(Mesh* mesh, SimpleVertexShader* vShader, SimplePixelShader* pShader, Mi
 	depthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
 	dev.Get()->CreateDepthStencilState(&depthStencilDesc, depthStencilState.GetAddressOf());
 
-	CreateDDSTextureFromFile(dev.Get(), texturePath, nullptr, shaderResource.GetAddressOf());
+	//Straight from the pack's mapping when it's packed, otherwise map the loose file
+	AssetSpan packed;
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	if (pack && pack->Find(texturePath, packed))
+	{
+		data = packed.Data;
+		size = packed.Size;
+	}
+	else if (file.Open(texturePath))
+	{
+		data = file.GetData();
+		size = file.GetSize();
+	}
+
+	//Anything that isn't a single cube map (or that D3D can't take as-is) goes through DirectXTK
+	if (data && !CreateCubeMap(context, data, size))
+	{
+		image = DdsImage();
+		cubeMap.Reset();
+		residentMip = 0;
+		CreateDDSTextureFromMemory(dev.Get(), data, size, nullptr, shaderResource.GetAddressOf());
+		file.Close();
+	}
+
+	#if defined(DEBUG) || defined(_DEBUG)
+		if (!shaderResource)
+			printf("Sky: couldn't load %s\n", texturePath);
+		else if (cubeMap)
+			printf("Sky: %ux%u cube map, mips %u-%u resident at start\n", image.Width, image.Height, residentMip, image.MipLevels - 1);
+	#endif
+}
+
+bool Sky::IsFullyResident()
+{
+	return residentMip == 0;
+}
+
+// --------------------------------------------------------
+// Makes the texture with its full mip chain but only fills the
+// mips up to StartMipSize - the view hides the empty ones until
+// StreamMips has filled them
+// --------------------------------------------------------
+bool Sky::CreateCubeMap(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, const unsigned char* data, size_t size)
+{
+	if (!DdsFile::Parse(data, size, image) || !image.Cube || image.ArraySize != 6 || image.Dimension != D3D11_RESOURCE_DIMENSION_TEXTURE2D)
+		return false;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = image.Width;
+	desc.Height = image.Height;
+	desc.MipLevels = image.MipLevels;
+	desc.ArraySize = image.ArraySize;
+	desc.Format = (DXGI_FORMAT)image.DxgiFormat;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
+	if (FAILED(device->CreateTexture2D(&desc, nullptr, cubeMap.GetAddressOf())))
+		return false;
+
+	//The smallest mip is always resident, however big it is
+	residentMip = image.MipLevels - 1;
+	while (residentMip > 0 && image.Get(0, residentMip - 1).Width <= StartMipSize && image.Get(0, residentMip - 1).Height <= StartMipSize)
+		residentMip--;
+
+	for (uint32_t mip = residentMip; mip < image.MipLevels; mip++)
+		UploadMip(context, mip);
+	CreateView();
+
+	if (IsFullyResident())
+	{
+		image.Subresources.clear();
+		file.Close();
+	}
+	return shaderResource != nullptr;
+}
+
+void Sky::StreamMips(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+{
+	if (IsFullyResident())
+		return;
+
+	for (unsigned int i = 0; i < MipsPerFrame && residentMip > 0; i++)
+		UploadMip(context, --residentMip);
+	CreateView();
+
+	//Everything's on the GPU now - the mapping can go
+	if (IsFullyResident())
+	{
+		image.Subresources.clear();
+		file.Close();
+	}
+}
+
+void Sky::UploadMip(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, uint32_t mip)
+{
+	for (uint32_t face = 0; face < image.ArraySize; face++)
+	{
+		const DdsSubresource& sub = image.Get(face, mip);
+		context->UpdateSubresource(cubeMap.Get(), D3D11CalcSubresource(mip, face, image.MipLevels), nullptr, sub.Data, sub.RowPitch, sub.SlicePitch);
+	}
+}
+
+//Views are cheap - a new one per streamed mip just moves where sampling starts
+void Sky::CreateView()
+{
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+	viewDesc.Format = (DXGI_FORMAT)image.DxgiFormat;
+	viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+	viewDesc.TextureCube.MostDetailedMip = residentMip;
+	viewDesc.TextureCube.MipLevels = image.MipLevels - residentMip;
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> view;
+	if (SUCCEEDED(device->CreateShaderResourceView(cubeMap.Get(), &viewDesc, view.GetAddressOf())))
+		shaderResource = view;
 }
 
 void Sky::Draw(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, Camera* camera)
 {
+	StreamMips(context);
+
 	//Setting render states
 	context->RSSetState(rasterizerState.Get());
 	context->OMSetDepthStencilState(depthStencilState.Get(), 0);
@@ -38,8 +162,10 @@ void Sky::Draw(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, Camera* came
 	pixelShader->SetShaderResourceView("SkyTexture", shaderResource);
 
 	//External data of vertex buffer
-	vertexShader->SetMatrix4x4("view", camera->GetView());
-	vertexShader->SetMatrix4x4("projection", camera->GetProjection());
+	SkyVertexShaderPerFrame cameraData = {};
+	cameraData.view = camera->GetView();
+	cameraData.projection = camera->GetProjection();
+	vertexShader->SetBuffer(cameraData);
 
 	vertexShader->CopyAllBufferData();
 	pixelShader->CopyAllBufferData();
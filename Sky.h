@@ -7,19 +7,51 @@
 #include "SimpleShader.h"
 #include "Mesh.h"
 #include "Camera.h"
+#include "AssetPack.h"
+#include "DdsFile.h"
+#include "MappedFile.h"
 
 #include "DDSTextureLoader.h"
 #include "WICTextureLoader.h"
 
 
 
+// --------------------------------------------------------
+// Skybox drawn from a DDS cube map
+//
+// The cube map is parsed in place (from a memory-mapped file or
+// the asset pack) and only its small mips are uploaded at
+// creation.  The larger ones are uploaded a few at a time as the
+// sky is drawn, straight from the mapping
+// --------------------------------------------------------
 class Sky
 {
 public:
-	Sky(Mesh* mesh, SimpleVertexShader* vShader, SimplePixelShader* pShader, Microsoft::WRL::ComPtr<ID3D11SamplerState> sState, Microsoft::WRL::ComPtr<ID3D11Device> dev, const wchar_t* texturePath);
+	// Mips up to this size go up at creation - the rest are streamed in
+	static unsigned int StartMipSize;
+
+	// Mip levels (all six faces) uploaded per Draw while streaming
+	static unsigned int MipsPerFrame;
+
+	Sky(Mesh* mesh, SimpleVertexShader* vShader, SimplePixelShader* pShader, Microsoft::WRL::ComPtr<ID3D11SamplerState> sState, Microsoft::WRL::ComPtr<ID3D11Device> dev, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, const char* texturePath, AssetPack* pack = nullptr);
 	void Draw(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, Camera* camera);
 
+	bool IsFullyResident();
+
 private:
+	bool CreateCubeMap(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, const unsigned char* data, size_t size);
+	void StreamMips(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	void UploadMip(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, uint32_t mip);
+	void CreateView();
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+
+	//Where the pixels come from until every mip is up (the pack keeps its own bytes alive)
+	MappedFile file;
+	DdsImage image;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> cubeMap;
+	uint32_t residentMip;
+
 	Mesh* skyboxMesh;
 	SimpleVertexShader* vertexShader;
 	SimplePixelShader* pixelShader;
@@ -0,0 +1,136 @@
+#include "SkyLighting.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	// One baked file, from the pack or mapped - the mapping only has to last until the texture is made
+	struct BakedFile
+	{
+		MappedFile File;
+		DdsImage Image;
+
+		bool Open(AssetPack* pack, const std::string& packed, const std::string& loose)
+		{
+			AssetSpan span;
+			if (pack && pack->Find(packed, span))
+				return DdsFile::Parse(span.Data, span.Size, Image);
+			return File.Open(loose.c_str()) && DdsFile::Parse(File.GetData(), File.GetSize(), Image);
+		}
+	};
+}
+
+SkyLighting::SkyLighting()
+{
+	memset(irradiance, 0, sizeof(irradiance));
+	specularMips = 0.0f;
+}
+
+bool SkyLighting::Load(Microsoft::WRL::ComPtr<ID3D11Device> device, AssetPack* pack, const std::string& assetsRoot, const std::string& cookedRoot, const std::string& sky)
+{
+	std::string names[3] = { sky + "_irradiance.dds", sky + "_specular.dds", "Textures/BrdfLut.dds" };
+	BakedFile files[3];
+	for (int i = 0; i < 3; i++)
+	{
+		if (!files[i].Open(pack, assetsRoot + names[i], cookedRoot + names[i]))
+		{
+			#if defined(DEBUG) || defined(_DEBUG)
+				printf("SkyLighting: no baked %s - flat ambient only\n", names[i].c_str());
+			#endif
+			return false;
+		}
+	}
+
+	//SH: 9 RGBA floats in one row
+	const DdsImage& sh = files[0].Image;
+	if (sh.DxgiFormat != DXGI_FORMAT_R32G32B32A32_FLOAT || sh.Width != 9 || sh.Subresources[0].Size < sizeof(irradiance))
+		return false;
+
+	const DdsImage& specular = files[1].Image;
+	if (!specular.Cube || specular.ArraySize != 6 ||
+		!CreateTexture(device, specular, &specularMap) ||
+		!CreateTexture(device, files[2].Image, &brdfLut))
+		return false;
+
+	memcpy(irradiance, sh.Subresources[0].Data, sizeof(irradiance));
+	specularMips = (float)specular.MipLevels;
+
+	//Mips blend between roughnesses, but never across the LUT's edges
+	D3D11_SAMPLER_DESC samplerDesc = {};
+	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	device->CreateSamplerState(&samplerDesc, clampSampler.GetAddressOf());
+
+	#if defined(DEBUG) || defined(_DEBUG)
+		printf("SkyLighting: %ux%u specular cube with %u mips, %ux%u BRDF table\n", specular.Width, specular.Height, specular.MipLevels, files[2].Image.Width, files[2].Image.Height);
+	#endif
+	return true;
+}
+
+bool SkyLighting::IsLoaded()
+{
+	return specularMips > 0.0f;
+}
+
+void SkyLighting::Bind(SimplePixelShader* ps, PixelShaderPerFrame& frame)
+{
+	for (int i = 0; i < 9; i++)
+		frame.shIrradiance[i] = irradiance[i];
+	frame.specularMips = specularMips;
+	if (!IsLoaded())
+		return;
+
+	ps->SetShaderResourceView("SpecularMap", specularMap);
+	ps->SetShaderResourceView("BrdfLut", brdfLut);
+	ps->SetSamplerState("ClampSampler", clampSampler);
+}
+
+// Immutable, with every subresource pointing into the file
+bool SkyLighting::CreateTexture(Microsoft::WRL::ComPtr<ID3D11Device> device, const DdsImage& image, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv)
+{
+	if (image.Dimension != D3D11_RESOURCE_DIMENSION_TEXTURE2D)
+		return false;
+
+	std::vector<D3D11_SUBRESOURCE_DATA> data(image.Subresources.size());
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		data[i].pSysMem = image.Subresources[i].Data;
+		data[i].SysMemPitch = image.Subresources[i].RowPitch;
+		data[i].SysMemSlicePitch = image.Subresources[i].SlicePitch;
+	}
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = image.Width;
+	desc.Height = image.Height;
+	desc.MipLevels = image.MipLevels;
+	desc.ArraySize = image.ArraySize;
+	desc.Format = (DXGI_FORMAT)image.DxgiFormat;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	if (image.Cube)
+		desc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	if (FAILED(device->CreateTexture2D(&desc, data.data(), texture.GetAddressOf())))
+		return false;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+	viewDesc.Format = desc.Format;
+	if (image.Cube)
+	{
+		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+		viewDesc.TextureCube.MipLevels = image.MipLevels;
+	}
+	else
+	{
+		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		viewDesc.Texture2D.MipLevels = image.MipLevels;
+	}
+	return SUCCEEDED(device->CreateShaderResourceView(texture.Get(), &viewDesc, srv->GetAddressOf()));
+}
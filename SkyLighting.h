@@ -0,0 +1,50 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <DirectXMath.h>
+#include <string>
+#include "AssetPack.h"
+#include "DdsFile.h"
+#include "SimpleShader.h"
+#include "ShaderConstants.h"
+
+// --------------------------------------------------------
+// Ambient and reflected light from the sky, baked offline by
+// the asset cooker (see IblBaker)
+//
+// - Diffuse is 9 SH coefficients, evaluated per pixel
+// - Specular is one cube sample at the mip for the surface's
+//   roughness, scaled by one BRDF table sample
+// - Textures are created straight from the pack (or mapped
+//   file) - no decode, no copy
+//
+// Without the baked files the shader falls back to the flat
+// ambient colour
+// --------------------------------------------------------
+class SkyLighting
+{
+public:
+	SkyLighting();
+
+	// sky is the sky's name relative to the roots, without ".dds" (e.g.
+	// "Textures/blueGradient").  The pack is tried under assetsRoot
+	// first, then loose files under cookedRoot
+	bool Load(Microsoft::WRL::ComPtr<ID3D11Device> device, AssetPack* pack, const std::string& assetsRoot, const std::string& cookedRoot, const std::string& sky);
+
+	bool IsLoaded();
+
+	// Fills shIrradiance and specularMips into the frame's constants, and
+	// sets SpecularMap, BrdfLut and ClampSampler
+	void Bind(SimplePixelShader* ps, PixelShaderPerFrame& frame);
+
+private:
+	bool CreateTexture(Microsoft::WRL::ComPtr<ID3D11Device> device, const DdsImage& image, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv);
+
+	DirectX::XMFLOAT4 irradiance[9];
+	float specularMips;
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> specularMap;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> brdfLut;
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> clampSampler;
+};
@@ -1,6 +1,6 @@
 #include "ShaderIncludes.hlsli"
 
-cbuffer ExternalData : register(b0)
+cbuffer PerFrame : register(b0)
 {
 	matrix view;
 	matrix projection;
@@ -0,0 +1,728 @@
+#include "TangentGenerator.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// --------------------------------------------------------
+	// Per-vertex running sums, one per handedness ([0] = positive,
+	// [1] = negative): xyz = face tangents times their corner
+	// angles, w = the total angle.  Both sides sit together, so
+	// the face pass's scattered adds stay close in memory
+	// --------------------------------------------------------
+	struct TangentSum
+	{
+		XMFLOAT4 Side[2];
+	};
+
+	// --------------------------------------------------------
+	// Where the face pass puts each corner's contribution.  With
+	// one worker everything goes straight into the sums.  With
+	// more, each vertex belongs to the range holding the first
+	// triangle that uses it: that range adds to it directly and
+	// the later ranges hold theirs back until after the join, so
+	// every vertex is summed in triangle order whatever the
+	// thread count
+	// --------------------------------------------------------
+	struct CornerSink
+	{
+		struct Held
+		{
+			unsigned int Vertex;
+			int Side;
+			XMFLOAT4 Corner;
+		};
+
+		std::vector<TangentSum>* Sums = nullptr;
+		const unsigned int* FirstTriangle = nullptr;	// Null = one worker
+		size_t Begin = 0;								// First triangle of this range
+		std::vector<Held> Later;
+
+		//Side = 0 (positive) / 1 (negative), corner = tangent * angle with w = the angle
+		inline void Add(unsigned int vertex, int side, __m128 corner)
+		{
+			if (FirstTriangle && FirstTriangle[vertex] < Begin)
+			{
+				Held held;
+				held.Vertex = vertex;
+				held.Side = side;
+				_mm_storeu_ps(&held.Corner.x, corner);
+				Later.push_back(held);
+				return;
+			}
+			AddTo(*Sums, vertex, side, corner);
+		}
+
+		static inline void AddTo(std::vector<TangentSum>& sums, unsigned int vertex, int side, __m128 corner)
+		{
+			float* sum = &sums[vertex].Side[side].x;
+			_mm_storeu_ps(sum, _mm_add_ps(_mm_loadu_ps(sum), corner));
+		}
+	};
+
+	double SecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	inline XMFLOAT3 Sub(XMFLOAT3 a, XMFLOAT3 b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+	inline float Dot(XMFLOAT3 a, XMFLOAT3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	//Removes the part along the unit vector n and normalizes - false if nothing's left
+	inline bool ProjectAndNormalize(XMFLOAT3& v, XMFLOAT3 n)
+	{
+		float d = Dot(n, v);
+		v = XMFLOAT3(v.x - n.x * d, v.y - n.y * d, v.z - n.z * d);
+		float lenSq = Dot(v, v);
+		if (!(lenSq > FLT_MIN))
+			return false;
+
+		float inv = 1.0f / sqrtf(lenSq);
+		v = XMFLOAT3(v.x * inv, v.y * inv, v.z * inv);
+		return true;
+	}
+
+	//Any unit vector perpendicular to n, for vertices with nothing better
+	XMFLOAT3 AnyPerpendicular(XMFLOAT3 n)
+	{
+		XMFLOAT3 t = fabsf(n.x) < 0.9f ? XMFLOAT3(1, 0, 0) : XMFLOAT3(0, 1, 0);
+		ProjectAndNormalize(t, n);
+		return t;
+	}
+
+	// --------------------------------------------------------
+	// acos to about 7e-5 radians (Abramowitz & Stegun 4.4.45) -
+	// plenty for a weight, and the same in both versions below
+	// --------------------------------------------------------
+	const float AcosC0 = 1.5707288f;
+	const float AcosC1 = -0.2121144f;
+	const float AcosC2 = 0.0742610f;
+	const float AcosC3 = -0.0187293f;
+
+	inline float FastAcos(float x)
+	{
+		x = std::max(-1.0f, std::min(1.0f, x));
+		float a = fabsf(x);
+		float r = sqrtf(1.0f - a) * (AcosC0 + a * (AcosC1 + a * (AcosC2 + a * AcosC3)));
+		return x < 0.0f ? XM_PI - r : r;
+	}
+
+	inline __m128 FastAcos(__m128 x)
+	{
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		const __m128 one = _mm_set1_ps(1.0f);
+		x = _mm_max_ps(_mm_set1_ps(-1.0f), _mm_min_ps(one, x));
+		__m128 a = _mm_andnot_ps(signBit, x);
+
+		__m128 poly = _mm_add_ps(_mm_set1_ps(AcosC2), _mm_mul_ps(a, _mm_set1_ps(AcosC3)));
+		poly = _mm_add_ps(_mm_set1_ps(AcosC1), _mm_mul_ps(a, poly));
+		poly = _mm_add_ps(_mm_set1_ps(AcosC0), _mm_mul_ps(a, poly));
+		__m128 r = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(one, a)), poly);
+
+		//pi - r for negative inputs
+		__m128 negative = _mm_cmplt_ps(x, _mm_setzero_ps());
+		return _mm_or_ps(_mm_andnot_ps(negative, r), _mm_and_ps(negative, _mm_sub_ps(_mm_set1_ps(XM_PI), r)));
+	}
+
+	//Angle between two edges leaving a corner, 0 if either has no length
+	inline float CornerAngle(XMFLOAT3 a, XMFLOAT3 b)
+	{
+		float aa = Dot(a, a);
+		float bb = Dot(b, b);
+		return aa > FLT_MIN && bb > FLT_MIN ? FastAcos(Dot(a, b) / sqrtf(aa * bb)) : 0.0f;
+	}
+
+	// --------------------------------------------------------
+	// 1 / sqrt(x) - the estimate plus one Newton step, good to
+	// about 1e-7 relative, without the divide or the sqrt.  x
+	// has to be positive; callers mask out what isn't
+	// --------------------------------------------------------
+	inline __m128 InvSqrt(__m128 x)
+	{
+		__m128 r = _mm_rsqrt_ps(x);
+		__m128 rrx = _mm_mul_ps(_mm_mul_ps(r, r), x);
+		return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), r), _mm_sub_ps(_mm_set1_ps(3.0f), rrx));
+	}
+
+	inline __m128 LengthSq(__m128 x, __m128 y, __m128 z)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+	}
+
+	//The normal scaled to unit length, or zero if it has none
+	inline XMFLOAT3 UnitNormal(XMFLOAT3 n)
+	{
+		float lenSq = Dot(n, n);
+		if (!(lenSq > FLT_MIN))
+			return XMFLOAT3(0, 0, 0);
+
+		float inv = 1.0f / sqrtf(lenSq);
+		return XMFLOAT3(n.x * inv, n.y * inv, n.z * inv);
+	}
+
+	// --------------------------------------------------------
+	// One triangle's corners - the scalar version of the SSE
+	// loop below, for the leftovers.  Returns the sign: +1/-1,
+	// 0 = degenerate
+	// --------------------------------------------------------
+	signed char FaceTangent(const Vertex* corners[3], XMFLOAT4 out[3])
+	{
+		XMFLOAT3 d1 = Sub(corners[1]->Position, corners[0]->Position);
+		XMFLOAT3 d2 = Sub(corners[2]->Position, corners[0]->Position);
+		XMFLOAT3 d3 = Sub(corners[2]->Position, corners[1]->Position);
+		float angles[3] = {
+			CornerAngle(d1, d2),
+			CornerAngle(d3, XMFLOAT3(-d1.x, -d1.y, -d1.z)),
+			CornerAngle(XMFLOAT3(-d2.x, -d2.y, -d2.z), XMFLOAT3(-d3.x, -d3.y, -d3.z)) };
+
+		float s1 = corners[1]->UV.x - corners[0]->UV.x;
+		float t1 = corners[1]->UV.y - corners[0]->UV.y;
+		float s2 = corners[2]->UV.x - corners[0]->UV.x;
+		float t2 = corners[2]->UV.y - corners[0]->UV.y;
+
+		float area = s1 * t2 - t1 * s2;
+		XMFLOAT3 os(t2 * d1.x - t1 * d2.x, t2 * d1.y - t1 * d2.y, t2 * d1.z - t1 * d2.z);
+		float lenSq = Dot(os, os);
+
+		bool valid = fabsf(area) > FLT_MIN && lenSq > FLT_MIN;
+		signed char sign = !valid ? 0 : area < 0.0f ? -1 : 1;
+
+		float inv = valid ? sign / sqrtf(lenSq) : 0.0f;
+		for (int c = 0; c < 3; c++)
+		{
+			float angle = valid ? angles[c] : 0.0f;
+			out[c] = XMFLOAT4(os.x * inv * angle, os.y * inv * angle, os.z * inv * angle, angle);
+		}
+		return sign;
+	}
+
+	// --------------------------------------------------------
+	// Triangles [begin, end), 4 at a time: the corners are
+	// gathered into SoA registers and the tangent, corner angles,
+	// UV area and degenerate checks run on all 4 lanes.  The
+	// corners go to the sink in triangle order
+	// --------------------------------------------------------
+	void ComputeFaceTangents(const Vertex* vertices, const unsigned int* indices, size_t begin, size_t end, signed char* signs, CornerSink& sink)
+	{
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		const __m128 minValue = _mm_set1_ps(FLT_MIN);
+		const __m128 zero = _mm_setzero_ps();
+
+		size_t t = begin;
+		for (; t + 4 <= end; t += 4)
+		{
+			//[corner][component][lane]
+			alignas(16) float pos[3][3][4];
+			alignas(16) float uv[3][2][4];
+			for (int lane = 0; lane < 4; lane++)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					const Vertex& v = vertices[indices[(t + lane) * 3 + c]];
+					pos[c][0][lane] = v.Position.x;
+					pos[c][1][lane] = v.Position.y;
+					pos[c][2][lane] = v.Position.z;
+					uv[c][0][lane] = v.UV.x;
+					uv[c][1][lane] = v.UV.y;
+				}
+			}
+
+			__m128 p0x = _mm_load_ps(pos[0][0]), p0y = _mm_load_ps(pos[0][1]), p0z = _mm_load_ps(pos[0][2]);
+			__m128 d1x = _mm_sub_ps(_mm_load_ps(pos[1][0]), p0x);
+			__m128 d1y = _mm_sub_ps(_mm_load_ps(pos[1][1]), p0y);
+			__m128 d1z = _mm_sub_ps(_mm_load_ps(pos[1][2]), p0z);
+			__m128 d2x = _mm_sub_ps(_mm_load_ps(pos[2][0]), p0x);
+			__m128 d2y = _mm_sub_ps(_mm_load_ps(pos[2][1]), p0y);
+			__m128 d2z = _mm_sub_ps(_mm_load_ps(pos[2][2]), p0z);
+			__m128 d3x = _mm_sub_ps(d2x, d1x);
+			__m128 d3y = _mm_sub_ps(d2y, d1y);
+			__m128 d3z = _mm_sub_ps(d2z, d1z);
+
+			//Corner angles, measured in the triangle's plane from each edge's inverse length
+			__m128 l1 = LengthSq(d1x, d1y, d1z), l2 = LengthSq(d2x, d2y, d2z), l3 = LengthSq(d3x, d3y, d3z);
+			__m128 has1 = _mm_cmpgt_ps(l1, minValue), has2 = _mm_cmpgt_ps(l2, minValue), has3 = _mm_cmpgt_ps(l3, minValue);
+			__m128 e1 = InvSqrt(_mm_max_ps(l1, minValue));
+			__m128 e2 = InvSqrt(_mm_max_ps(l2, minValue));
+			__m128 e3 = InvSqrt(_mm_max_ps(l3, minValue));
+			__m128 dot12 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d1x, d2x), _mm_mul_ps(d1y, d2y)), _mm_mul_ps(d1z, d2z));
+			__m128 dot13 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d1x, d3x), _mm_mul_ps(d1y, d3y)), _mm_mul_ps(d1z, d3z));
+			__m128 dot23 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d2x, d3x), _mm_mul_ps(d2y, d3y)), _mm_mul_ps(d2z, d3z));
+			__m128 angles[3] = {
+				_mm_and_ps(FastAcos(_mm_mul_ps(dot12, _mm_mul_ps(e1, e2))), _mm_and_ps(has1, has2)),
+				_mm_and_ps(FastAcos(_mm_sub_ps(zero, _mm_mul_ps(dot13, _mm_mul_ps(e1, e3)))), _mm_and_ps(has1, has3)),
+				_mm_and_ps(FastAcos(_mm_mul_ps(dot23, _mm_mul_ps(e2, e3))), _mm_and_ps(has2, has3)) };
+
+			__m128 u0 = _mm_load_ps(uv[0][0]), v0 = _mm_load_ps(uv[0][1]);
+			__m128 s1 = _mm_sub_ps(_mm_load_ps(uv[1][0]), u0);
+			__m128 t1 = _mm_sub_ps(_mm_load_ps(uv[1][1]), v0);
+			__m128 s2 = _mm_sub_ps(_mm_load_ps(uv[2][0]), u0);
+			__m128 t2 = _mm_sub_ps(_mm_load_ps(uv[2][1]), v0);
+
+			//Twice the signed UV area, and dP/du scaled by it
+			__m128 area = _mm_sub_ps(_mm_mul_ps(s1, t2), _mm_mul_ps(t1, s2));
+			__m128 osx = _mm_sub_ps(_mm_mul_ps(t2, d1x), _mm_mul_ps(t1, d2x));
+			__m128 osy = _mm_sub_ps(_mm_mul_ps(t2, d1y), _mm_mul_ps(t1, d2y));
+			__m128 osz = _mm_sub_ps(_mm_mul_ps(t2, d1z), _mm_mul_ps(t1, d2z));
+			__m128 lenSq = LengthSq(osx, osy, osz);
+
+			//Degenerate lanes (also catches NaNs, since those compare false)
+			__m128 valid = _mm_and_ps(
+				_mm_cmpgt_ps(_mm_andnot_ps(signBit, area), minValue),
+				_mm_cmpgt_ps(lenSq, minValue));
+
+			//Flip by the area's sign so the tangent always follows +u, and normalize
+			__m128 areaSign = _mm_and_ps(area, signBit);
+			__m128 inv = _mm_xor_ps(InvSqrt(_mm_max_ps(lenSq, minValue)), areaSign);
+			__m128 tx = _mm_mul_ps(osx, inv);
+			__m128 ty = _mm_mul_ps(osy, inv);
+			__m128 tz = _mm_mul_ps(osz, inv);
+
+			int validMask = _mm_movemask_ps(valid);
+			int negativeMask = _mm_movemask_ps(area);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (!(validMask & (1 << lane)))
+					signs[t + lane] = 0;
+				else
+					signs[t + lane] = (negativeMask & (1 << lane)) ? -1 : 1;
+			}
+
+			//Each corner adds the face tangent times its angle - [lane][corner]
+			tx = _mm_and_ps(tx, valid);
+			ty = _mm_and_ps(ty, valid);
+			tz = _mm_and_ps(tz, valid);
+			__m128 corners[4][3];
+			for (int c = 0; c < 3; c++)
+			{
+				corners[0][c] = _mm_mul_ps(tx, angles[c]);
+				corners[1][c] = _mm_mul_ps(ty, angles[c]);
+				corners[2][c] = _mm_mul_ps(tz, angles[c]);
+				corners[3][c] = _mm_and_ps(angles[c], valid);
+				_MM_TRANSPOSE4_PS(corners[0][c], corners[1][c], corners[2][c], corners[3][c]);
+			}
+
+			for (int lane = 0; lane < 4; lane++)
+			{
+				int side = (negativeMask >> lane) & 1;
+				for (int c = 0; c < 3; c++)
+					sink.Add(indices[(t + lane) * 3 + c], side, corners[lane][c]);
+			}
+		}
+
+		for (; t < end; t++)
+		{
+			const Vertex* corners[3] = { &vertices[indices[t * 3]], &vertices[indices[t * 3 + 1]], &vertices[indices[t * 3 + 2]] };
+			XMFLOAT4 out[3];
+			signs[t] = FaceTangent(corners, out);
+			for (int c = 0; c < 3; c++)
+				sink.Add(indices[t * 3 + c], signs[t] < 0 ? 1 : 0, _mm_loadu_ps(&out[c].x));
+		}
+	}
+
+	// --------------------------------------------------------
+	// Face pass: every triangle's sign, and every corner added
+	// to its vertex's sums.  Ranges are rounded to whole SSE
+	// batches so only the last one has a scalar tail
+	// --------------------------------------------------------
+	unsigned int ComputeAllFaceTangents(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t triangleCount,
+		std::vector<signed char>& signs, std::vector<TangentSum>& sums, TangentStats& stats)
+	{
+		signs.resize(triangleCount);
+		sums.assign(vertexCount, TangentSum());
+
+		const size_t BatchesPerWorker = 2048;
+		size_t batches = (triangleCount + 3) / 4;
+
+		//Who owns which vertex only matters when the triangles get split up
+		std::vector<unsigned int> firstTriangle;
+		if (GetRangeWorkerCount(batches, BatchesPerWorker) > 1)
+		{
+			firstTriangle.assign(vertexCount, 0xFFFFFFFF);
+			for (size_t i = 0; i < triangleCount * 3; i++)
+				firstTriangle[indices[i]] = std::min(firstTriangle[indices[i]], (unsigned int)(i / 3));
+		}
+
+		std::vector<CornerSink> sinks(GetWorkerCount());
+		unsigned int workers = ParallelForRange(batches, BatchesPerWorker, [&](size_t begin, size_t end, unsigned int worker)
+		{
+			CornerSink& sink = sinks[worker];
+			sink.Sums = &sums;
+			sink.FirstTriangle = firstTriangle.empty() ? nullptr : firstTriangle.data();
+			sink.Begin = begin * 4;
+			ComputeFaceTangents(vertices, indices, begin * 4, std::min(end * 4, triangleCount), signs.data(), sink);
+		});
+
+		//Held back corners come from later triangles than anything already summed, in range order
+		for (size_t w = 0; w < sinks.size(); w++)
+		{
+			for (size_t h = 0; h < sinks[w].Later.size(); h++)
+			{
+				const CornerSink::Held& held = sinks[w].Later[h];
+				CornerSink::AddTo(sums, held.Vertex, held.Side, _mm_loadu_ps(&held.Corner.x));
+			}
+		}
+
+		stats.Triangles = triangleCount;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			if (signs[t] == 0) stats.DegenerateTriangles++;
+			else if (signs[t] < 0) stats.MirroredTriangles++;
+		}
+		return workers;
+	}
+
+	// --------------------------------------------------------
+	// Vertex pass: picks the handedness with more weight behind
+	// it, projects its sum onto the normal's plane and writes
+	// Tangent (xyz + handedness).  4 vertices at a time, the same
+	// way as the face pass, with the rest one by one
+	// --------------------------------------------------------
+	void FinishVertexTangents(Vertex* vertices, const std::vector<TangentSum>& sums, size_t begin, size_t end, TangentStats& stats)
+	{
+		const __m128 minValue = _mm_set1_ps(FLT_MIN);
+		const __m128 zero = _mm_setzero_ps();
+
+		size_t v = begin;
+		for (; v + 4 <= end; v += 4)
+		{
+			__m128 px = _mm_loadu_ps(&sums[v].Side[0].x), py = _mm_loadu_ps(&sums[v + 1].Side[0].x);
+			__m128 pz = _mm_loadu_ps(&sums[v + 2].Side[0].x), pw = _mm_loadu_ps(&sums[v + 3].Side[0].x);
+			__m128 nx = _mm_loadu_ps(&sums[v].Side[1].x), ny = _mm_loadu_ps(&sums[v + 1].Side[1].x);
+			__m128 nz = _mm_loadu_ps(&sums[v + 2].Side[1].x), nw = _mm_loadu_ps(&sums[v + 3].Side[1].x);
+			_MM_TRANSPOSE4_PS(px, py, pz, pw);
+			_MM_TRANSPOSE4_PS(nx, ny, nz, nw);
+
+			int mixedMask = _mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(pw, zero), _mm_cmpgt_ps(nw, zero)));
+			stats.MixedVertices += (mixedMask & 1) + ((mixedMask >> 1) & 1) + ((mixedMask >> 2) & 1) + ((mixedMask >> 3) & 1);
+
+			//Negative wins only with more weight, like the one by one version
+			__m128 negative = _mm_cmpgt_ps(nw, pw);
+			__m128 sx = _mm_or_ps(_mm_andnot_ps(negative, px), _mm_and_ps(negative, nx));
+			__m128 sy = _mm_or_ps(_mm_andnot_ps(negative, py), _mm_and_ps(negative, ny));
+			__m128 sz = _mm_or_ps(_mm_andnot_ps(negative, pz), _mm_and_ps(negative, nz));
+
+			//Unit normals (zero if they have no length)
+			__m128 ax = _mm_set_ps(vertices[v + 3].Normal.x, vertices[v + 2].Normal.x, vertices[v + 1].Normal.x, vertices[v].Normal.x);
+			__m128 ay = _mm_set_ps(vertices[v + 3].Normal.y, vertices[v + 2].Normal.y, vertices[v + 1].Normal.y, vertices[v].Normal.y);
+			__m128 az = _mm_set_ps(vertices[v + 3].Normal.z, vertices[v + 2].Normal.z, vertices[v + 1].Normal.z, vertices[v].Normal.z);
+			__m128 aLenSq = LengthSq(ax, ay, az);
+			__m128 aInv = _mm_and_ps(InvSqrt(_mm_max_ps(aLenSq, minValue)), _mm_cmpgt_ps(aLenSq, minValue));
+			ax = _mm_mul_ps(ax, aInv);
+			ay = _mm_mul_ps(ay, aInv);
+			az = _mm_mul_ps(az, aInv);
+
+			//Minus the part along the normal, normalized
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, sx), _mm_mul_ps(ay, sy)), _mm_mul_ps(az, sz));
+			sx = _mm_sub_ps(sx, _mm_mul_ps(ax, d));
+			sy = _mm_sub_ps(sy, _mm_mul_ps(ay, d));
+			sz = _mm_sub_ps(sz, _mm_mul_ps(az, d));
+			__m128 lenSq = LengthSq(sx, sy, sz);
+			__m128 inv = InvSqrt(_mm_max_ps(lenSq, minValue));
+			sx = _mm_mul_ps(sx, inv);
+			sy = _mm_mul_ps(sy, inv);
+			sz = _mm_mul_ps(sz, inv);
+			__m128 sw = _mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(negative, _mm_set1_ps(-0.0f)));
+			_MM_TRANSPOSE4_PS(sx, sy, sz, sw);
+			_mm_storeu_ps(&vertices[v].Tangent.x, sx);
+			_mm_storeu_ps(&vertices[v + 1].Tangent.x, sy);
+			_mm_storeu_ps(&vertices[v + 2].Tangent.x, sz);
+			_mm_storeu_ps(&vertices[v + 3].Tangent.x, sw);
+
+			//Nothing left after the projection
+			int fallbackMask = _mm_movemask_ps(_mm_cmple_ps(lenSq, minValue));
+			for (int lane = 0; fallbackMask && lane < 4; lane++)
+			{
+				if (!(fallbackMask & (1 << lane)))
+					continue;
+
+				Vertex& vertex = vertices[v + lane];
+				XMFLOAT3 tangent = AnyPerpendicular(UnitNormal(vertex.Normal));
+				vertex.Tangent = XMFLOAT4(tangent.x, tangent.y, tangent.z, vertex.Tangent.w);
+				stats.FallbackVertices++;
+			}
+		}
+
+		for (; v < end; v++)
+		{
+			const XMFLOAT4& positive = sums[v].Side[0];
+			const XMFLOAT4& negative = sums[v].Side[1];
+			if (positive.w > 0.0f && negative.w > 0.0f)
+				stats.MixedVertices++;
+
+			Vertex& vertex = vertices[v];
+			XMFLOAT3 n = UnitNormal(vertex.Normal);
+			int side = negative.w > positive.w ? 1 : 0;
+			const XMFLOAT4& sum = sums[v].Side[side];
+			XMFLOAT3 tangent(sum.x, sum.y, sum.z);
+			if (!ProjectAndNormalize(tangent, n))
+			{
+				tangent = AnyPerpendicular(n);
+				stats.FallbackVertices++;
+			}
+
+			vertex.Tangent = XMFLOAT4(tangent.x, tangent.y, tangent.z, side == 0 ? 1.0f : -1.0f);
+		}
+	}
+
+	void FinishAllVertexTangents(Vertex* vertices, size_t vertexCount, const std::vector<TangentSum>& sums, TangentStats& stats)
+	{
+		//Counters per worker, added up afterwards.  Ranges are whole groups of 4 again, so
+		//which vertices go one by one doesn't depend on the thread count either
+		std::vector<TangentStats> workerStats(GetWorkerCount());
+		size_t groups = (vertexCount + 3) / 4;
+		unsigned int workers = ParallelForRange(groups, 4096, [&](size_t begin, size_t end, unsigned int worker)
+		{
+			FinishVertexTangents(vertices, sums, begin * 4, std::min(end * 4, vertexCount), workerStats[worker]);
+		});
+
+		for (size_t w = 0; w < workerStats.size(); w++)
+		{
+			stats.MixedVertices += workerStats[w].MixedVertices;
+			stats.FallbackVertices += workerStats[w].FallbackVertices;
+		}
+		stats.Workers = std::max(stats.Workers, workers);
+	}
+
+	void PrintStats(const TangentStats& stats)
+	{
+		#if defined(DEBUG) || defined(_DEBUG)
+			printf("  tangents: %zu triangles (%zu degenerate, %zu mirrored), %zu split, %zu mixed, %zu fallback, %.2f ms (%u threads)\n",
+				stats.Triangles, stats.DegenerateTriangles, stats.MirroredTriangles, stats.SplitVertices,
+				stats.MixedVertices, stats.FallbackVertices, stats.Seconds * 1000.0, stats.Workers);
+		#else
+			(void)stats;
+		#endif
+	}
+}
+
+// --------------------------------------------------------
+// Tangents for an indexed mesh whose vertices can't be added to
+// --------------------------------------------------------
+void TangentGenerator::Generate(Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, TangentStats* stats)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	TangentStats localStats;
+
+	std::vector<signed char> signs;
+	std::vector<TangentSum> sums;
+	localStats.Workers = ComputeAllFaceTangents(vertices, vertexCount, indices, indexCount / 3, signs, sums, localStats);
+	FinishAllVertexTangents(vertices, vertexCount, sums, localStats);
+
+	localStats.Seconds = SecondsSince(start);
+	if (stats) *stats = localStats;
+}
+
+// --------------------------------------------------------
+// Tangents for an indexed mesh, splitting vertices on UV
+// mirror seams (what MikkTSpace's vertex groups do)
+// --------------------------------------------------------
+void TangentGenerator::Generate(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, TangentStats* stats)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	TangentStats localStats;
+
+	size_t triangleCount = indices.size() / 3;
+	std::vector<signed char> signs;
+	std::vector<TangentSum> sums;
+	localStats.Workers = ComputeAllFaceTangents(vertices.data(), vertices.size(), indices.data(), triangleCount, signs, sums, localStats);
+
+	//Which handednesses touch each vertex (bit 0 = positive, bit 1 = negative)
+	if (localStats.MirroredTriangles > 0)
+	{
+		std::vector<unsigned char> sides(vertices.size(), 0);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			if (signs[t] == 0)
+				continue;
+
+			unsigned char bit = signs[t] > 0 ? 1 : 2;
+			for (int c = 0; c < 3; c++)
+				sides[indices[t * 3 + c]] |= bit;
+		}
+
+		//Mirrored triangles on a seam move over to a copy of the vertex
+		const unsigned int NoCopy = 0xFFFFFFFF;
+		std::vector<unsigned int> copies(vertices.size(), NoCopy);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			if (signs[t] >= 0)
+				continue;
+
+			for (int c = 0; c < 3; c++)
+			{
+				unsigned int& index = indices[t * 3 + c];
+				if (sides[index] != 3)
+					continue;
+
+				if (copies[index] == NoCopy)
+				{
+					copies[index] = (unsigned int)vertices.size();
+					vertices.push_back(vertices[index]);
+					localStats.SplitVertices++;
+				}
+				index = copies[index];
+			}
+		}
+
+		//...and so does everything they added to the original
+		sums.resize(vertices.size(), TangentSum());
+		for (size_t v = 0; v < copies.size(); v++)
+		{
+			if (copies[v] == NoCopy)
+				continue;
+
+			sums[copies[v]].Side[1] = sums[v].Side[1];
+			sums[v].Side[1] = XMFLOAT4(0, 0, 0, 0);
+		}
+	}
+
+	FinishAllVertexTangents(vertices.data(), vertices.size(), sums, localStats);
+
+	localStats.Seconds = SecondsSince(start);
+	PrintStats(localStats);
+	if (stats) *stats = localStats;
+}
+
+// --------------------------------------------------------
+// Compares against the original tangent code on the same
+// mesh - the two should agree on well-formed input, since
+// both follow dP/du and are orthogonalized against the normal
+// --------------------------------------------------------
+bool TangentGenerator::CompareWithLegacy(const char* name, const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, float maxDegrees)
+{
+	std::vector<Vertex> legacy(vertices, vertices + vertexCount);
+	std::vector<Vertex> current(vertices, vertices + vertexCount);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	GenerateLegacy(legacy.data(), (int)vertexCount, indices, (int)indexCount);
+	double legacySeconds = SecondsSince(start);
+
+	TangentStats stats;
+	Generate(current.data(), vertexCount, indices, indexCount, &stats);
+
+	float worst = 0.0f;
+	double total = 0.0;
+	size_t compared = 0;
+	size_t legacyInvalid = 0;
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		XMFLOAT3 a(legacy[i].Tangent.x, legacy[i].Tangent.y, legacy[i].Tangent.z);
+		XMFLOAT3 b(current[i].Tangent.x, current[i].Tangent.y, current[i].Tangent.z);
+
+		//Old code divides by the UV area unchecked
+		if (!std::isfinite(a.x) || !std::isfinite(a.y) || !std::isfinite(a.z))
+		{
+			legacyInvalid++;
+			continue;
+		}
+
+		float angle = acosf(std::max(-1.0f, std::min(1.0f, Dot(a, b)))) * (180.0f / XM_PI);
+		worst = std::max(worst, angle);
+		total += angle;
+		compared++;
+	}
+
+	printf("%s: %zu vertices, legacy %.2f ms, new %.2f ms (%u threads)\n", name, vertexCount, legacySeconds * 1000.0, stats.Seconds * 1000.0, stats.Workers);
+	printf("  max %.4f deg, avg %.4f deg, %zu legacy NaN/inf, %zu degenerate, %zu mirrored\n",
+		worst, compared ? total / compared : 0.0, legacyInvalid, stats.DegenerateTriangles, stats.MirroredTriangles);
+
+	return worst <= maxDegrees;
+}
+
+// --------------------------------------------------------
+// Author: Chris Cascioli
+// Purpose: Calculates the tangents of the vertices in a mesh
+//
+// - You are allowed to directly copy/paste this into your code base
+//   for assignments, given that you clearly cite that this is not
+//   code of your own design.
+//
+// - Code originally adapted from: http://www.terathon.com/code/tangent.html
+//   - Updated version now found here: http://foundationsofgameenginedev.com/FGED2-sample.pdf
+//   - See listing 7.4 in section 7.5 (page 9 of the PDF)
+//
+// - Was Mesh::CalculateTangents - only kept as the reference for
+//   CompareWithLegacy (no handedness, no degenerate UV checks)
+// --------------------------------------------------------
+void TangentGenerator::GenerateLegacy(Vertex* verts, int numVerts, const unsigned int* indices, int numIndices)
+{
+	// Reset tangents
+	for (int i = 0; i < numVerts; i++)
+	{
+		verts[i].Tangent = XMFLOAT4(0, 0, 0, 1);
+	}
+
+	// Calculate tangents one whole triangle at a time
+	for (int i = 0; i < numIndices;)
+	{
+		// Grab indices and vertices of first triangle
+		unsigned int i1 = indices[i++];
+		unsigned int i2 = indices[i++];
+		unsigned int i3 = indices[i++];
+		Vertex* v1 = &verts[i1];
+		Vertex* v2 = &verts[i2];
+		Vertex* v3 = &verts[i3];
+
+		// Calculate vectors relative to triangle positions
+		float x1 = v2->Position.x - v1->Position.x;
+		float y1 = v2->Position.y - v1->Position.y;
+		float z1 = v2->Position.z - v1->Position.z;
+
+		float x2 = v3->Position.x - v1->Position.x;
+		float y2 = v3->Position.y - v1->Position.y;
+		float z2 = v3->Position.z - v1->Position.z;
+
+		// Do the same for vectors relative to triangle uv's
+		float s1 = v2->UV.x - v1->UV.x;
+		float t1 = v2->UV.y - v1->UV.y;
+
+		float s2 = v3->UV.x - v1->UV.x;
+		float t2 = v3->UV.y - v1->UV.y;
+
+		// Create vectors for tangent calculation
+		float r = 1.0f / (s1 * t2 - s2 * t1);
+
+		float tx = (t2 * x1 - t1 * x2) * r;
+		float ty = (t2 * y1 - t1 * y2) * r;
+		float tz = (t2 * z1 - t1 * z2) * r;
+
+		// Adjust tangents of each vert of the triangle
+		v1->Tangent.x += tx;
+		v1->Tangent.y += ty;
+		v1->Tangent.z += tz;
+
+		v2->Tangent.x += tx;
+		v2->Tangent.y += ty;
+		v2->Tangent.z += tz;
+
+		v3->Tangent.x += tx;
+		v3->Tangent.y += ty;
+		v3->Tangent.z += tz;
+	}
+
+	// Ensure all of the tangents are orthogonal to the normals
+	for (int i = 0; i < numVerts; i++)
+	{
+		// Grab the two vectors
+		XMFLOAT3 normal = verts[i].Normal;
+		XMFLOAT3 tangent(verts[i].Tangent.x, verts[i].Tangent.y, verts[i].Tangent.z);
+
+		// Use Gram-Schmidt orthonormalize to ensure
+		// the normal and tangent are exactly 90 degrees apart
+		float d = Dot(normal, tangent);
+		tangent = XMFLOAT3(tangent.x - normal.x * d, tangent.y - normal.y * d, tangent.z - normal.z * d);
+		float len = sqrtf(Dot(tangent, tangent));
+
+		// Store the tangent
+		verts[i].Tangent = XMFLOAT4(tangent.x / len, tangent.y / len, tangent.z / len, 1.0f);
+	}
+}
@@ -0,0 +1,212 @@
+// --------------------------------------------------------
+// Standalone tests for TangentGenerator
+//
+// Not part of the game project (it has its own main) - build it
+// on its own, e.g. headless on Linux:
+//
+//   g++ -std=c++14 -O2 -pthread -ITestStubs -o TangentGeneratorTest
+//       TangentGeneratorTest.cpp TangentGenerator.cpp
+//
+// Usage:
+//   TangentGeneratorTest [torus segments for the timing run (default 512)]
+//
+// A torus (clean UVs, no seams that mirror) has to come out
+// within a degree of the original per-triangle code through
+// CompareWithLegacy, which also prints both timings.  A grid
+// whose UVs mirror down the middle has to get its seam split
+// with each side's handedness, and a triangle with no UV area
+// has to leave usable tangents behind.  Returns 0 when
+// everything passed
+// --------------------------------------------------------
+#include "TangentGenerator.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool condition, const char* what, int line)
+	{
+		if (condition)
+			return;
+		printf("  FAILED (line %d): %s\n", line, what);
+		failures++;
+	}
+
+	#define CHECK(condition) Check((condition), #condition, __LINE__)
+
+	struct TestMesh
+	{
+		std::vector<Vertex> Vertices;
+		std::vector<unsigned int> Indices;
+	};
+
+	Vertex MakeVertex(XMFLOAT3 position, XMFLOAT3 normal, XMFLOAT2 uv)
+	{
+		Vertex v;
+		v.Position = position;
+		v.Normal = normal;
+		v.UV = uv;
+		v.Tangent = XMFLOAT4(0, 0, 0, 0);
+		return v;
+	}
+
+	// Two triangles per cell of a (columns + 1) x (rows + 1) vertex grid
+	void AddGridIndices(TestMesh& mesh, int columns, int rows)
+	{
+		for (int y = 0; y < rows; y++)
+		{
+			for (int x = 0; x < columns; x++)
+			{
+				unsigned int i = y * (columns + 1) + x;
+				unsigned int right = i + 1;
+				unsigned int below = i + columns + 1;
+				unsigned int mesh4[6] = { i, right, below, right, below + 1, below };
+				mesh.Indices.insert(mesh.Indices.end(), mesh4, mesh4 + 6);
+			}
+		}
+	}
+
+	// --------------------------------------------------------
+	// u around the ring, v around the tube - the seam vertices
+	// are duplicated, so UVs never wrap or mirror
+	// --------------------------------------------------------
+	TestMesh MakeTorus(int ringSegments, int tubeSegments)
+	{
+		TestMesh mesh;
+		const float ring = 1.0f;
+		const float tube = 0.4f;
+		for (int j = 0; j <= tubeSegments; j++)
+		{
+			float v = (float)j / tubeSegments;
+			float phi = v * XM_2PI;
+			for (int i = 0; i <= ringSegments; i++)
+			{
+				float u = (float)i / ringSegments;
+				float theta = u * XM_2PI;
+				XMFLOAT3 normal(cosf(phi) * cosf(theta), sinf(phi), cosf(phi) * sinf(theta));
+				XMFLOAT3 position((ring + tube * cosf(phi)) * cosf(theta), tube * sinf(phi), (ring + tube * cosf(phi)) * sinf(theta));
+				mesh.Vertices.push_back(MakeVertex(position, normal, XMFLOAT2(u, v)));
+			}
+		}
+		AddGridIndices(mesh, ringSegments, tubeSegments);
+		return mesh;
+	}
+
+	bool IsUnitAndPerpendicular(const Vertex& v)
+	{
+		XMFLOAT4 t = v.Tangent;
+		float length = sqrtf(t.x * t.x + t.y * t.y + t.z * t.z);
+		float along = t.x * v.Normal.x + t.y * v.Normal.y + t.z * v.Normal.z;
+		return fabsf(length - 1.0f) < 1e-4f && fabsf(along) < 1e-4f && (t.w == 1.0f || t.w == -1.0f);
+	}
+
+	void TestTorus(int ringSegments, int tubeSegments)
+	{
+		printf("Torus %dx%d\n", ringSegments, tubeSegments);
+		TestMesh mesh = MakeTorus(ringSegments, tubeSegments);
+		CHECK(TangentGenerator::CompareWithLegacy("  torus", mesh.Vertices.data(), mesh.Vertices.size(),
+			mesh.Indices.data(), mesh.Indices.size(), 1.0f));
+
+		TangentStats stats;
+		TangentGenerator::Generate(mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices.data(), mesh.Indices.size(), &stats);
+		CHECK(stats.Triangles == mesh.Indices.size() / 3);
+		CHECK(stats.DegenerateTriangles == 0 && stats.MirroredTriangles == 0 && stats.FallbackVertices == 0);
+
+		bool allValid = true;
+		for (size_t i = 0; i < mesh.Vertices.size(); i++)
+			allValid = allValid && IsUnitAndPerpendicular(mesh.Vertices[i]) && mesh.Vertices[i].Tangent.w == 1.0f;
+		CHECK(allValid);
+	}
+
+	// --------------------------------------------------------
+	// A flat grid facing -Z whose u is |x|: the right half's
+	// tangents follow +x, the left half's -x with the other
+	// handedness, and the middle column is shared by both
+	// --------------------------------------------------------
+	void TestMirrored()
+	{
+		printf("Mirrored\n");
+		const int columns = 8;
+		const int rows = 4;
+		TestMesh mesh;
+		for (int y = 0; y <= rows; y++)
+		{
+			for (int x = 0; x <= columns; x++)
+			{
+				float px = (float)(x - columns / 2);
+				mesh.Vertices.push_back(MakeVertex(XMFLOAT3(px, (float)y, 0), XMFLOAT3(0, 0, -1), XMFLOAT2(fabsf(px), (float)-y)));
+			}
+		}
+		AddGridIndices(mesh, columns, rows);
+		size_t originalVertices = mesh.Vertices.size();
+
+		TangentStats stats;
+		TangentGenerator::Generate(mesh.Vertices, mesh.Indices, &stats);
+		CHECK(stats.MirroredTriangles == (size_t)rows * columns);		// Half of the 2 per cell
+		CHECK(stats.SplitVertices == rows + 1);
+		CHECK(mesh.Vertices.size() == originalVertices + rows + 1);
+		CHECK(stats.MixedVertices == 0 && stats.FallbackVertices == 0);
+
+		//Every triangle's corners agree with the side it's on
+		bool sidesMatch = true;
+		for (size_t t = 0; t < mesh.Indices.size(); t += 3)
+		{
+			float centerX = 0.0f;
+			for (int c = 0; c < 3; c++)
+				centerX += mesh.Vertices[mesh.Indices[t + c]].Position.x / 3.0f;
+
+			for (int c = 0; c < 3; c++)
+			{
+				const Vertex& v = mesh.Vertices[mesh.Indices[t + c]];
+				sidesMatch = sidesMatch && IsUnitAndPerpendicular(v) &&
+					(centerX > 0.0f ? v.Tangent.x > 0.999f : v.Tangent.x < -0.999f) &&
+					v.Tangent.w == (centerX > 0.0f ? mesh.Vertices[0 + columns].Tangent.w : mesh.Vertices[0].Tangent.w);
+			}
+		}
+		CHECK(sidesMatch);
+		CHECK(mesh.Vertices[0].Tangent.w == -mesh.Vertices[columns].Tangent.w);
+	}
+
+	// A triangle with no UV area has nothing to give, so its corners fall back to any perpendicular
+	void TestDegenerate()
+	{
+		printf("Degenerate\n");
+		TestMesh mesh;
+		mesh.Vertices.push_back(MakeVertex(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 1, 0), XMFLOAT2(0.5f, 0.5f)));
+		mesh.Vertices.push_back(MakeVertex(XMFLOAT3(1, 0, 0), XMFLOAT3(0, 1, 0), XMFLOAT2(0.5f, 0.5f)));
+		mesh.Vertices.push_back(MakeVertex(XMFLOAT3(0, 0, 1), XMFLOAT3(0, 1, 0), XMFLOAT2(0.5f, 0.5f)));
+		mesh.Indices = { 0, 1, 2 };
+
+		TangentStats stats;
+		TangentGenerator::Generate(mesh.Vertices, mesh.Indices, &stats);
+		CHECK(stats.DegenerateTriangles == 1 && stats.FallbackVertices == 3);
+		for (size_t i = 0; i < mesh.Vertices.size(); i++)
+			CHECK(IsUnitAndPerpendicular(mesh.Vertices[i]));
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int segments = argc > 1 ? atoi(argv[1]) : 512;
+	if (segments < 4) segments = 4;
+
+	TestTorus(48, 24);
+	TestTorus(segments, segments / 2);
+	TestMirrored();
+	TestDegenerate();
+
+	if (failures)
+	{
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("All passed\n");
+	return 0;
+}
@@ -0,0 +1,15 @@
+#pragma once
+// --------------------------------------------------------
+// Stand-in for DirectXMath, for the standalone tests only (see
+// d3d11.h in this folder).  Just the storage types and constants
+// --------------------------------------------------------
+namespace DirectX
+{
+	constexpr float XM_PI = 3.141592654f;
+	constexpr float XM_2PI = 6.283185307f;
+
+	struct XMFLOAT2 { float x, y; XMFLOAT2() = default; XMFLOAT2(float x, float y) : x(x), y(y) {} };
+	struct XMFLOAT3 { float x, y, z; XMFLOAT3() = default; XMFLOAT3(float x, float y, float z) : x(x), y(y), z(z) {} };
+	struct XMFLOAT4 { float x, y, z, w; XMFLOAT4() = default; XMFLOAT4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {} };
+	struct XMFLOAT4X4 { float m[4][4]; };
+}
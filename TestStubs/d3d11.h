@@ -0,0 +1,246 @@
+#pragma once
+// --------------------------------------------------------
+// Stand-in for the parts of Direct3D 11 (and Windows) that
+// SimpleShader uses, for the standalone tests only - never on
+// the game's include path.  Build a test with -ITestStubs
+//
+// Nothing is drawn: the device hands out buffers that keep
+// their bytes in memory, and the context applies updates and
+// maps to them and counts each kind, so a test can check what
+// was sent and how
+// --------------------------------------------------------
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ---- Windows
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef unsigned int UINT;
+typedef int INT;
+typedef int32_t HRESULT;		// A 32 bit long, as on Windows
+typedef float FLOAT;
+typedef size_t SIZE_T;
+typedef const char* LPCSTR;
+typedef const wchar_t* LPCWSTR;
+typedef void* HANDLE;
+
+#define TRUE 1
+#define FALSE 0
+#define S_OK ((HRESULT)0)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define ZeroMemory(p, n) memset((p), 0, (n))
+
+#define STD_OUTPUT_HANDLE 0
+enum { FOREGROUND_BLUE = 1, FOREGROUND_GREEN = 2, FOREGROUND_RED = 4, FOREGROUND_INTENSITY = 8 };
+inline HANDLE GetStdHandle(int) { return nullptr; }
+inline void SetConsoleTextAttribute(HANDLE, int) {}
+inline void OutputDebugString(const char*) {}
+inline void OutputDebugStringW(const wchar_t*) {}
+#define printf_s printf
+#define wprintf_s wprintf
+
+// windows.h's max() (a macro there, but that would break <algorithm> here)
+template<typename A, typename B> inline A max(A a, B b) { return a > (A)b ? a : (A)b; }
+
+struct IUnknown
+{
+	virtual ~IUnknown() {}
+	unsigned long AddRef() { return ++refs; }
+	unsigned long Release() { unsigned long left = --refs; if (!left) delete this; return left; }
+
+private:
+	unsigned long refs = 1;
+};
+
+// ---- Formats, descriptions and enums
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2, DXGI_FORMAT_R32G32B32A32_UINT = 3, DXGI_FORMAT_R32G32B32A32_SINT = 4,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6, DXGI_FORMAT_R32G32B32_UINT = 7, DXGI_FORMAT_R32G32B32_SINT = 8,
+	DXGI_FORMAT_R16G16B16A16_FLOAT = 10, DXGI_FORMAT_R16G16B16A16_UNORM = 11,
+	DXGI_FORMAT_R32G32_FLOAT = 16, DXGI_FORMAT_R32G32_UINT = 17, DXGI_FORMAT_R32G32_SINT = 18,
+	DXGI_FORMAT_R16G16_UNORM = 35, DXGI_FORMAT_R16G16_SNORM = 37,
+	DXGI_FORMAT_R32_FLOAT = 41, DXGI_FORMAT_R32_UINT = 42, DXGI_FORMAT_R32_SINT = 43,
+};
+
+enum D3D11_USAGE { D3D11_USAGE_DEFAULT, D3D11_USAGE_IMMUTABLE, D3D11_USAGE_DYNAMIC, D3D11_USAGE_STAGING };
+enum D3D11_BIND_FLAG { D3D11_BIND_VERTEX_BUFFER = 0x1, D3D11_BIND_CONSTANT_BUFFER = 0x4, D3D11_BIND_STREAM_OUTPUT = 0x10 };
+enum D3D11_CPU_ACCESS_FLAG { D3D11_CPU_ACCESS_WRITE = 0x10000 };
+enum D3D11_MAP { D3D11_MAP_WRITE_DISCARD = 4, D3D11_MAP_WRITE_NO_OVERWRITE = 5 };
+enum D3D11_INPUT_CLASSIFICATION { D3D11_INPUT_PER_VERTEX_DATA, D3D11_INPUT_PER_INSTANCE_DATA };
+enum D3D11_FEATURE { D3D11_FEATURE_D3D11_OPTIONS = 7 };
+enum D3D_CBUFFER_TYPE { D3D11_CT_CBUFFER, D3D11_CT_TBUFFER };
+#define D3D11_APPEND_ALIGNED_ELEMENT 0xffffffff
+#define D3D11_SO_NO_RASTERIZED_STREAM 0xffffffff
+
+struct D3D11_BUFFER_DESC { UINT ByteWidth; D3D11_USAGE Usage; UINT BindFlags; UINT CPUAccessFlags; UINT MiscFlags; UINT StructureByteStride; };
+struct D3D11_SUBRESOURCE_DATA { const void* pSysMem; UINT SysMemPitch; UINT SysMemSlicePitch; };
+struct D3D11_MAPPED_SUBRESOURCE { void* pData; UINT RowPitch; UINT DepthPitch; };
+struct D3D11_BOX { UINT left, top, front, right, bottom, back; };
+struct D3D11_INPUT_ELEMENT_DESC { LPCSTR SemanticName; UINT SemanticIndex; DXGI_FORMAT Format; UINT InputSlot; UINT AlignedByteOffset; D3D11_INPUT_CLASSIFICATION InputSlotClass; UINT InstanceDataStepRate; };
+struct D3D11_SO_DECLARATION_ENTRY { UINT Stream; LPCSTR SemanticName; UINT SemanticIndex; BYTE StartComponent; BYTE ComponentCount; BYTE OutputSlot; };
+struct D3D11_FEATURE_DATA_D3D11_OPTIONS { BOOL OutputMergerLogicOp; BOOL UAVOnlyRenderingForcedSampleCount; BOOL DiscardAPIsSeenByDriver; BOOL FlagsForUpdateAndCopySeenByDriver; BOOL ClearView; BOOL CopyWithOverlap; BOOL ConstantBufferPartialUpdate; BOOL ConstantBufferOffsetting; BOOL MapNoOverwriteOnDynamicConstantBuffer; BOOL MapNoOverwriteOnDynamicBufferSRV; BOOL MultisampleRTVWithForcedSampleCountOne; BOOL SAD4ShaderInstructions; BOOL ExtendedDoublesShaderInstructions; BOOL ExtendedResourceSharing; };
+
+// ---- Resources, views and shaders (nothing in them but the buffers' bytes)
+struct ID3D11Resource : IUnknown {};
+
+struct ID3D11Buffer : ID3D11Resource
+{
+	D3D11_BUFFER_DESC Desc;
+	std::vector<uint8_t> Data;
+};
+
+struct ID3D11ShaderResourceView : IUnknown {};
+struct ID3D11UnorderedAccessView : IUnknown {};
+struct ID3D11SamplerState : IUnknown {};
+struct ID3D11InputLayout : IUnknown {};
+struct ID3D11ClassLinkage : IUnknown {};
+struct ID3D11VertexShader : IUnknown {};
+struct ID3D11PixelShader : IUnknown {};
+struct ID3D11DomainShader : IUnknown {};
+struct ID3D11HullShader : IUnknown {};
+struct ID3D11GeometryShader : IUnknown {};
+struct ID3D11ComputeShader : IUnknown {};
+
+// --------------------------------------------------------
+// Applies updates and maps to the buffers' bytes and counts
+// them.  A map-discard fills the buffer with 0xCD first, like
+// a fresh allocation would, so whatever isn't written shows
+// --------------------------------------------------------
+struct ID3D11DeviceContext : IUnknown
+{
+	int Updates = 0;
+	int Maps = 0;
+	int Unmaps = 0;
+	bool LastUpdateBoxed = false;
+	D3D11_BOX LastBox = {};
+
+	void UpdateSubresource(ID3D11Resource* resource, UINT, const D3D11_BOX* box, const void* data, UINT, UINT)
+	{
+		Updates++;
+		Write(resource, box, data);
+	}
+
+	HRESULT Map(ID3D11Resource* resource, UINT, D3D11_MAP type, UINT, D3D11_MAPPED_SUBRESOURCE* mapped)
+	{
+		ID3D11Buffer* buffer = dynamic_cast<ID3D11Buffer*>(resource);
+		if (!buffer || !mapped || buffer->Desc.Usage != D3D11_USAGE_DYNAMIC)
+			return E_INVALIDARG;
+		if (type == D3D11_MAP_WRITE_DISCARD)
+			memset(buffer->Data.data(), 0xCD, buffer->Data.size());
+
+		Maps++;
+		mapped->pData = buffer->Data.data();
+		mapped->RowPitch = mapped->DepthPitch = (UINT)buffer->Data.size();
+		return S_OK;
+	}
+
+	void Unmap(ID3D11Resource*, UINT) { Unmaps++; }
+
+	template<typename... A> void VSSetShader(A...) {}
+	template<typename... A> void PSSetShader(A...) {}
+	template<typename... A> void DSSetShader(A...) {}
+	template<typename... A> void HSSetShader(A...) {}
+	template<typename... A> void GSSetShader(A...) {}
+	template<typename... A> void CSSetShader(A...) {}
+	template<typename... A> void VSSetConstantBuffers(A...) {}
+	template<typename... A> void PSSetConstantBuffers(A...) {}
+	template<typename... A> void DSSetConstantBuffers(A...) {}
+	template<typename... A> void HSSetConstantBuffers(A...) {}
+	template<typename... A> void GSSetConstantBuffers(A...) {}
+	template<typename... A> void CSSetConstantBuffers(A...) {}
+	template<typename... A> void VSSetShaderResources(A...) {}
+	template<typename... A> void PSSetShaderResources(A...) {}
+	template<typename... A> void DSSetShaderResources(A...) {}
+	template<typename... A> void HSSetShaderResources(A...) {}
+	template<typename... A> void GSSetShaderResources(A...) {}
+	template<typename... A> void CSSetShaderResources(A...) {}
+	template<typename... A> void VSSetSamplers(A...) {}
+	template<typename... A> void PSSetSamplers(A...) {}
+	template<typename... A> void DSSetSamplers(A...) {}
+	template<typename... A> void HSSetSamplers(A...) {}
+	template<typename... A> void GSSetSamplers(A...) {}
+	template<typename... A> void CSSetSamplers(A...) {}
+	template<typename... A> void CSSetUnorderedAccessViews(A...) {}
+	template<typename... A> void IASetInputLayout(A...) {}
+	template<typename... A> void SOSetTargets(A...) {}
+	template<typename... A> void Dispatch(A...) {}
+
+protected:
+	void Write(ID3D11Resource* resource, const D3D11_BOX* box, const void* data)
+	{
+		ID3D11Buffer* buffer = dynamic_cast<ID3D11Buffer*>(resource);
+		if (!buffer)
+			return;
+
+		size_t start = box ? box->left : 0;
+		size_t end = box ? box->right : buffer->Data.size();
+		if (start < end && end <= buffer->Data.size())
+			memcpy(buffer->Data.data() + start, data, end - start);
+
+		LastUpdateBoxed = box != nullptr;
+		if (box)
+			LastBox = *box;
+	}
+};
+
+// --------------------------------------------------------
+// Creates working buffers and placeholder everything else.
+// PartialUpdates is what CheckFeatureSupport reports
+// --------------------------------------------------------
+struct ID3D11Device : IUnknown
+{
+	BOOL PartialUpdates = TRUE;
+	int BuffersCreated = 0;
+
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* initial, ID3D11Buffer** buffer)
+	{
+		if (!desc || !desc->ByteWidth || !buffer)
+			return E_INVALIDARG;
+
+		ID3D11Buffer* created = new ID3D11Buffer();
+		created->Desc = *desc;
+		created->Data.assign(desc->ByteWidth, 0);
+		if (initial && initial->pSysMem)
+			memcpy(created->Data.data(), initial->pSysMem, desc->ByteWidth);
+
+		BuffersCreated++;
+		*buffer = created;
+		return S_OK;
+	}
+
+	HRESULT CheckFeatureSupport(D3D11_FEATURE, void* data, UINT size)
+	{
+		if (size != sizeof(D3D11_FEATURE_DATA_D3D11_OPTIONS))
+			return E_INVALIDARG;
+		D3D11_FEATURE_DATA_D3D11_OPTIONS* options = (D3D11_FEATURE_DATA_D3D11_OPTIONS*)data;
+		ZeroMemory(options, size);
+		options->ConstantBufferPartialUpdate = PartialUpdates;
+		return S_OK;
+	}
+
+	template<typename... A> HRESULT CreateVertexShader(A... args) { return Create(args...); }
+	template<typename... A> HRESULT CreatePixelShader(A... args) { return Create(args...); }
+	template<typename... A> HRESULT CreateDomainShader(A... args) { return Create(args...); }
+	template<typename... A> HRESULT CreateHullShader(A... args) { return Create(args...); }
+	template<typename... A> HRESULT CreateGeometryShader(A... args) { return Create(args...); }
+	template<typename... A> HRESULT CreateComputeShader(A... args) { return Create(args...); }
+	template<typename... A> HRESULT CreateGeometryShaderWithStreamOutput(A... args) { return Create(args...); }
+	template<typename... A> HRESULT CreateInputLayout(A... args) { return Create(args...); }
+
+private:
+	// The created object is the last argument
+	template<typename T> HRESULT Create(T** created) { *created = new T(); return S_OK; }
+	template<typename First, typename... A> HRESULT Create(First, A... rest) { return Create(rest...); }
+};
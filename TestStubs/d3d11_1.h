@@ -0,0 +1,17 @@
+#pragma once
+// --------------------------------------------------------
+// Stand-in for the 11.1 context, for the standalone tests only
+// (see d3d11.h in this folder)
+// --------------------------------------------------------
+#include <d3d11.h>
+
+struct ID3D11DeviceContext1 : ID3D11DeviceContext
+{
+	int PartialUpdates = 0;
+
+	void UpdateSubresource1(ID3D11Resource* resource, UINT, const D3D11_BOX* box, const void* data, UINT, UINT, UINT)
+	{
+		PartialUpdates++;
+		Write(resource, box, data);
+	}
+};
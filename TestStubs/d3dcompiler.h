@@ -0,0 +1,62 @@
+#pragma once
+// --------------------------------------------------------
+// Stand-in for the compiler library, for the standalone tests
+// only (see d3d11.h in this folder).  Blobs read real files;
+// D3DReflect always fails, so debug builds skip comparing
+// against it
+// --------------------------------------------------------
+#include <d3d11.h>
+#include <fstream>
+#include <iterator>
+
+struct ID3D10Blob : IUnknown
+{
+	std::vector<uint8_t> Bytes;
+
+	void* GetBufferPointer() { return Bytes.data(); }
+	SIZE_T GetBufferSize() { return Bytes.size(); }
+};
+typedef ID3D10Blob ID3DBlob;
+
+inline HRESULT D3DReadFileToBlob(LPCWSTR fileName, ID3DBlob** blob)
+{
+	std::string narrow;
+	for (LPCWSTR c = fileName; *c; c++)
+		narrow += (char)*c;
+
+	std::ifstream file(narrow, std::ios::binary);
+	if (!file)
+		return E_FAIL;
+
+	*blob = new ID3DBlob();
+	(*blob)->Bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return S_OK;
+}
+
+// ---- Reflection types SimpleShader names
+enum D3D_SHADER_INPUT_TYPE
+{
+	D3D_SIT_CBUFFER, D3D_SIT_TBUFFER, D3D_SIT_TEXTURE, D3D_SIT_SAMPLER, D3D_SIT_UAV_RWTYPED, D3D_SIT_STRUCTURED,
+	D3D_SIT_UAV_RWSTRUCTURED, D3D_SIT_BYTEADDRESS, D3D_SIT_UAV_RWBYTEADDRESS, D3D_SIT_UAV_APPEND_STRUCTURED,
+	D3D_SIT_UAV_CONSUME_STRUCTURED, D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER
+};
+enum D3D_REGISTER_COMPONENT_TYPE { D3D_REGISTER_COMPONENT_UNKNOWN, D3D_REGISTER_COMPONENT_UINT32, D3D_REGISTER_COMPONENT_SINT32, D3D_REGISTER_COMPONENT_FLOAT32 };
+
+struct D3D11_SHADER_DESC { UINT Version; LPCSTR Creator; UINT Flags; UINT ConstantBuffers; UINT BoundResources; UINT InputParameters; UINT OutputParameters; };
+struct D3D11_SHADER_BUFFER_DESC { LPCSTR Name; D3D_CBUFFER_TYPE Type; UINT Variables; UINT Size; UINT uFlags; };
+
+struct ID3D11ShaderReflectionConstantBuffer
+{
+	HRESULT GetDesc(D3D11_SHADER_BUFFER_DESC*) { return E_FAIL; }
+};
+
+struct ID3D11ShaderReflection : IUnknown
+{
+	HRESULT GetDesc(D3D11_SHADER_DESC*) { return E_FAIL; }
+	ID3D11ShaderReflectionConstantBuffer* GetConstantBufferByIndex(UINT) { return nullptr; }
+};
+
+struct GUID { unsigned long Data1; };
+static const GUID IID_ID3D11ShaderReflection = { 0x8d536ca1 };
+
+inline HRESULT D3DReflect(const void*, SIZE_T, const GUID&, void**) { return E_FAIL; }
@@ -0,0 +1,46 @@
+#pragma once
+// --------------------------------------------------------
+// Stand-in for WRL's ComPtr, for the standalone tests only
+// (see d3d11.h in this folder).  Counts references through
+// the stub IUnknown like the real one
+// --------------------------------------------------------
+namespace Microsoft { namespace WRL {
+
+template<typename T>
+class ComPtr
+{
+public:
+	ComPtr() : ptr(nullptr) {}
+	ComPtr(T* p) : ptr(p) { if (ptr) ptr->AddRef(); }
+	ComPtr(const ComPtr& other) : ptr(other.ptr) { if (ptr) ptr->AddRef(); }
+	template<typename U> ComPtr(const ComPtr<U>& other) : ptr(other.Get()) { if (ptr) ptr->AddRef(); }
+	~ComPtr() { Reset(); }
+
+	ComPtr& operator=(ComPtr other) { T* old = ptr; ptr = other.ptr; other.ptr = old; return *this; }
+
+	T* Get() const { return ptr; }
+	T* operator->() const { return ptr; }
+	explicit operator bool() const { return ptr != nullptr; }
+
+	T** GetAddressOf() { return &ptr; }
+	T* const* GetAddressOf() const { return &ptr; }
+	T** ReleaseAndGetAddressOf() { Reset(); return &ptr; }
+
+	void Attach(T* p) { Reset(); ptr = p; }
+	void Reset() { if (ptr) ptr->Release(); ptr = nullptr; }
+
+	// QueryInterface, as far as the stubs need it
+	template<typename U> int As(ComPtr<U>* other) const
+	{
+		U* p = dynamic_cast<U*>(ptr);
+		if (!p)
+			return (int)0x80004002;	// E_NOINTERFACE
+		*other = ComPtr<U>(p);
+		return 0;
+	}
+
+private:
+	T* ptr;
+};
+
+}}
@@ -0,0 +1,245 @@
+#include "TextureCompressor.h"
+#include "DdsFile.h"
+#include "ImageDecoder.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace
+{
+	double SecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	// The runtime sampled sRGB-tagged PNGs through an _SRGB view, so
+	// data maps packed from them keep the linear values the shader saw
+	uint8_t SrgbToLinear(uint8_t value)
+	{
+		float v = value / 255.0f;
+		float linear = v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f);
+		return (uint8_t)(linear * 255.0f + 0.5f);
+	}
+
+	// RGBA8 bytes of a full mip chain
+	size_t MipChainBytes(uint32_t width, uint32_t height)
+	{
+		size_t bytes = 0;
+		while (true)
+		{
+			bytes += (size_t)width * height * 4;
+			if (width == 1 && height == 1)
+				return bytes;
+			width = (std::max)(1u, width / 2);
+			height = (std::max)(1u, height / 2);
+		}
+	}
+
+	std::string FileName(const std::string& path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? path : path.substr(slash + 1);
+	}
+
+	const char* FormatName(BlockFormat format)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1: return "BC1";
+		case BlockFormat::BC4: return "BC4";
+		case BlockFormat::BC5: return "BC5";
+		default: return "BC7";
+		}
+	}
+}
+
+MipFilter TextureCompressor::MipKernel = MipFilter::Kaiser;
+
+bool TextureCompressor::Compress(const std::string& source, const std::string& destination, TextureKind kind, TextureCompressStats* stats)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	TextureCompressStats local;
+	TextureCompressStats& result = stats ? *stats : local;
+	result = TextureCompressStats();
+	result.Name = FileName(source);
+
+	uint32_t width, height;
+	bool srgb;
+	std::vector<uint8_t> pixels;
+	if (!LoadPng(source, width, height, srgb, pixels))
+		return false;
+
+	BlockFormat format = BlockFormat::BC7;
+	switch (kind)
+	{
+	case TextureKind::Albedo: format = BlockFormat::BC7; break;
+	case TextureKind::AlbedoBC1: format = BlockFormat::BC1; break;
+	case TextureKind::NormalMap: format = BlockFormat::BC5; break;
+	case TextureKind::Mask: format = BlockFormat::BC4; break;
+	case TextureKind::RoughnessMetalness:
+		//One map on its own - roughness with no metalness
+		for (size_t i = 0; i < pixels.size(); i += 4)
+			pixels[i + 1] = 0;
+		format = BlockFormat::BC5;
+		break;
+	}
+
+	//Only colour keeps the sRGB tag - data maps store what the shader read
+	bool colour = kind == TextureKind::Albedo || kind == TextureKind::AlbedoBC1;
+	if (srgb && !colour)
+	{
+		for (size_t i = 0; i < pixels.size(); i++)
+			pixels[i] = (i & 3) == 3 ? pixels[i] : SrgbToLinear(pixels[i]);
+	}
+
+	MipSettings mipSettings;
+	mipSettings.Filter = MipKernel;
+	mipSettings.SRGB = colour;		// Albedo is sRGB encoded even without the tag - the shader linearises it
+	mipSettings.NormalMap = kind == TextureKind::NormalMap;
+
+	bool ok = Encode(pixels, width, height, format, srgb && colour, mipSettings, destination, result);
+	result.Seconds = SecondsSince(start);
+	return ok;
+}
+
+bool TextureCompressor::CompressRoughnessMetalness(const std::string& roughness, const std::string& metalness, const std::string& destination, TextureCompressStats* stats)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	TextureCompressStats local;
+	TextureCompressStats& result = stats ? *stats : local;
+	result = TextureCompressStats();
+	result.Name = FileName(roughness) + " + " + FileName(metalness);
+
+	uint32_t widths[2], heights[2];
+	bool srgb[2];
+	std::vector<uint8_t> maps[2];
+	if (!LoadPng(roughness, widths[0], heights[0], srgb[0], maps[0]) || !LoadPng(metalness, widths[1], heights[1], srgb[1], maps[1]))
+		return false;
+
+	uint32_t width = (std::max)(widths[0], widths[1]);
+	uint32_t height = (std::max)(heights[0], heights[1]);
+	std::vector<uint8_t> packed((size_t)width * height * 4);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			uint8_t* dst = &packed[((size_t)y * width + x) * 4];
+			for (int m = 0; m < 2; m++)
+			{
+				size_t sx = (size_t)x * widths[m] / width;
+				size_t sy = (size_t)y * heights[m] / height;
+				uint8_t value = maps[m][(sy * widths[m] + sx) * 4];
+				dst[m] = srgb[m] ? SrgbToLinear(value) : value;
+			}
+			dst[2] = 0;
+			dst[3] = 255;
+		}
+	}
+
+	MipSettings mipSettings;
+	mipSettings.Filter = MipKernel;
+
+	bool ok = Encode(packed, width, height, BlockFormat::BC5, false, mipSettings, destination, result);
+
+	//Compared against the two separate RGBA8 textures it replaces
+	result.SourceBytes = MipChainBytes(widths[0], heights[0]) + MipChainBytes(widths[1], heights[1]);
+	result.Seconds = SecondsSince(start);
+	return ok;
+}
+
+double TextureCompressor::Psnr(const uint8_t* a, const uint8_t* b, size_t pixelCount, int channels)
+{
+	double sum = 0.0;
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		for (int c = 0; c < channels; c++)
+		{
+			double d = (double)a[i * 4 + c] - b[i * 4 + c];
+			sum += d * d;
+		}
+	}
+
+	double mse = sum / ((double)pixelCount * channels);
+	if (mse == 0.0)
+		return std::numeric_limits<double>::infinity();
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+void TextureCompressor::Report(const std::vector<TextureCompressStats>& textures)
+{
+	size_t source = 0, compressed = 0;
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		const TextureCompressStats& t = textures[i];
+		if (!t.Ok)
+		{
+			printf("  %-44s FAILED\n", t.Name.c_str());
+			continue;
+		}
+
+		printf("  %-44s %s %4ux%-4u %2u mips  %8.1f KB -> %7.1f KB (%.1fx)  PSNR %6.2f dB  %7.1f ms on %u threads\n",
+			t.Name.c_str(), FormatName(t.Format), t.Width, t.Height, t.MipLevels,
+			t.SourceBytes / 1024.0, t.CompressedBytes / 1024.0, t.Ratio(), t.Psnr, t.Seconds * 1000.0, t.Workers);
+		source += t.SourceBytes;
+		compressed += t.CompressedBytes;
+	}
+
+	printf("Textures: %.1f MB -> %.1f MB (%.1fx smaller)\n", source / (1024.0 * 1024.0), compressed / (1024.0 * 1024.0),
+		compressed ? (double)source / compressed : 0.0);
+}
+
+bool TextureCompressor::LoadPng(const std::string& path, uint32_t& width, uint32_t& height, bool& srgb, std::vector<uint8_t>& pixels)
+{
+	MappedFile file(path.c_str());
+	ImageInfo info;
+	if (!file.IsOpen() || !ImageDecoder::ReadPngInfo(file.GetData(), file.GetSize(), info))
+		return false;
+
+	pixels.resize(info.DecodedSize());
+	if (!ImageDecoder::DecodePng(file.GetData(), file.GetSize(), pixels.data(), pixels.size()))
+		return false;
+
+	width = info.Width;
+	height = info.Height;
+	srgb = info.SRGB;
+	return true;
+}
+
+// --------------------------------------------------------
+// Builds the mip chain, compresses every level and writes the
+// DDS.  PSNR is measured on the top level by decoding it again
+// --------------------------------------------------------
+bool TextureCompressor::Encode(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, BlockFormat format, bool srgb, const MipSettings& mipSettings, const std::string& destination, TextureCompressStats& stats)
+{
+	stats.Width = width;
+	stats.Height = height;
+	stats.Format = format;
+
+	std::vector<MipLevel> levels = MipGenerator::Generate(pixels.data(), width, height, mipSettings);
+	std::vector<std::vector<uint8_t>> mips;
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		const MipLevel& level = levels[i];
+		std::vector<uint8_t> blocks(BlockCompressor::CompressedSize(format, level.Width, level.Height));
+		unsigned int workers = BlockCompressor::CompressImage(level.Pixels.data(), level.Width, level.Height, format, blocks.data());
+		stats.Workers = (std::max)(stats.Workers, workers);
+		stats.SourceBytes += level.Pixels.size();
+		stats.CompressedBytes += blocks.size();
+
+		if (i == 0)
+		{
+			std::vector<uint8_t> decoded(level.Pixels.size());
+			BlockCompressor::DecompressImage(blocks.data(), level.Width, level.Height, format, decoded.data());
+			stats.Psnr = Psnr(level.Pixels.data(), decoded.data(), (size_t)level.Width * level.Height, BlockCompressor::ChannelCount(format));
+		}
+		mips.push_back(std::move(blocks));
+	}
+
+	stats.MipLevels = (uint32_t)mips.size();
+	stats.Ok = DdsFile::Write(destination, BlockCompressor::DxgiFormat(format, srgb), width, height, mips);
+	return stats.Ok;
+}
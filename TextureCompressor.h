@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BlockCompressor.h"
+#include "MipGenerator.h"
+
+// --------------------------------------------------------
+// What a texture is used for, which decides its format
+// --------------------------------------------------------
+enum class TextureKind
+{
+	Albedo,				// BC7
+	AlbedoBC1,			// BC1 - half of BC7's size, no alpha
+	NormalMap,			// BC5 - X and Y only, Z has to be rebuilt in the shader
+	Mask,				// BC4 from the red channel
+	RoughnessMetalness	// BC5 - roughness in R, metalness in G
+};
+
+struct TextureCompressStats
+{
+	std::string Name;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t MipLevels = 0;
+	BlockFormat Format = BlockFormat::BC7;
+	size_t SourceBytes = 0;			// RGBA8 with the same mips - what the runtime uploads today
+	size_t CompressedBytes = 0;
+	double Psnr = 0.0;				// Top level, over the channels the format keeps
+	double Seconds = 0.0;
+	unsigned int Workers = 0;
+	bool Ok = false;
+
+	double Ratio() const { return CompressedBytes ? (double)SourceBytes / CompressedBytes : 0.0; }
+};
+
+// --------------------------------------------------------
+// Offline PNG -> block-compressed DDS, with its mips made by
+// MipGenerator (colour filtered in linear space, normals
+// renormalised)
+//
+// Runs headless - PNGs go through ImageDecoder and the DDS is
+// written directly, so nothing here needs D3D
+// --------------------------------------------------------
+class TextureCompressor
+{
+public:
+	// Filter for the mip chain
+	static MipFilter MipKernel;
+
+	static bool Compress(const std::string& source, const std::string& destination, TextureKind kind, TextureCompressStats* stats = nullptr);
+
+	// Packs two greyscale maps into one BC5 texture (R = roughness,
+	// G = metalness), so the shader samples one texture instead of two.
+	// The smaller map is point sampled up to the larger one's size
+	static bool CompressRoughnessMetalness(const std::string& roughness, const std::string& metalness, const std::string& destination, TextureCompressStats* stats = nullptr);
+
+	// Peak signal-to-noise ratio (dB) over the first `channels` channels of two RGBA8 images
+	static double Psnr(const uint8_t* a, const uint8_t* b, size_t pixelCount, int channels);
+
+	static void Report(const std::vector<TextureCompressStats>& textures);
+
+private:
+	static bool LoadPng(const std::string& path, uint32_t& width, uint32_t& height, bool& srgb, std::vector<uint8_t>& pixels);
+	static bool Encode(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, BlockFormat format, bool srgb, const MipSettings& mipSettings, const std::string& destination, TextureCompressStats& stats);
+};
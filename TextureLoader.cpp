@@ -0,0 +1,371 @@
+#include "TextureLoader.h"
+#include "DdsFile.h"
+#include "MappedFile.h"
+#include "WICTextureLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+// One cooked texture, from the pack or mapped - the mapping only has to last until the texture is made
+struct TextureLoader::CookedFile
+{
+	MappedFile File;
+	DdsImage Image;
+
+	bool Open(AssetPack* pack, const std::string& packed, const std::string& loose)
+	{
+		AssetSpan span;
+		if (pack && pack->Find(packed, span))
+			return DdsFile::Parse(span.Data, span.Size, Image);
+		return File.Open(loose.c_str()) && DdsFile::Parse(File.GetData(), File.GetSize(), Image);
+	}
+};
+
+namespace
+{
+	// sRGB-tagged PNGs were sampled through an _SRGB view, so a map
+	// packed from one keeps the linear values the shader saw (as the
+	// cooker does)
+	uint8_t SrgbToLinear(uint8_t value)
+	{
+		float v = value / 255.0f;
+		float linear = v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f);
+		return (uint8_t)(linear * 255.0f + 0.5f);
+	}
+}
+
+void TextureLoader::SetCookedRoots(const std::string& assetsRoot, const std::string& cookedRoot)
+{
+	this->assetsRoot = assetsRoot;
+	this->cookedRoot = cookedRoot;
+}
+
+void TextureLoader::Add(const std::string& path, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv)
+{
+	Request request;
+	request.Paths.push_back(path);
+	request.Array = false;
+	request.Packed = false;
+	request.Target = srv;
+	requests.push_back(request);
+}
+
+void TextureLoader::AddArray(const std::vector<std::string>& paths, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv)
+{
+	Request request;
+	request.Paths = paths;
+	request.Array = true;
+	request.Packed = false;
+	request.Target = srv;
+	requests.push_back(request);
+}
+
+void TextureLoader::AddRoughnessMetalness(const std::string& roughness, const std::string& metalness, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv)
+{
+	Request request;
+	request.Paths.push_back(roughness);
+	request.Paths.push_back(metalness);
+	request.Array = false;
+	request.Packed = true;
+	request.Target = srv;
+	requests.push_back(request);
+}
+
+ImageBatchStats TextureLoader::Load(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, AssetPack* pack)
+{
+	Decode(pack);
+	return Create(device, context);
+}
+
+void TextureLoader::Decode(AssetPack* pack)
+{
+	//Cooked textures need no decoding - only what's left goes to the decoder
+	std::vector<std::string> paths;
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		if (!OpenCooked(pack, requests[i]))
+			paths.insert(paths.end(), requests[i].Paths.begin(), requests[i].Paths.end());
+	}
+
+	//Every image decodes into its own slice of one allocation
+	images.clear();
+	pixels.assign(ImageDecoder::PlanBatch(paths, images, pack), 0);
+
+	stats = ImageBatchStats();
+	ImageDecoder::DecodeBatch(images, pixels.data(), &stats);
+}
+
+ImageBatchStats TextureLoader::Create(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	int cookedCount = 0;
+	int fallbacks = 0;
+	size_t next = 0;
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		const Request& request = requests[i];
+		if (!request.Cooked.empty())
+		{
+			//A cooked file that opened but wouldn't make a texture leaves the placeholder, same as a failed decode
+			if (CreateCooked(device.Get(), request))
+				cookedCount++;
+			continue;
+		}
+
+		size_t first = next;
+		next += request.Paths.size();
+
+		//Two maps into one texture - nothing WIC can do if they don't decode
+		if (request.Packed)
+		{
+			if (!CreatePacked(device.Get(), context.Get(), images[first], images[first + 1], pixels, request.Target))
+			{
+				#if defined(DEBUG) || defined(_DEBUG)
+					printf("TextureLoader: couldn't pack %s with %s\n", request.Paths[0].c_str(), request.Paths[1].c_str());
+				#endif
+			}
+			continue;
+		}
+
+		//Slices have to match the first one exactly
+		bool ok = !request.Paths.empty();
+		std::vector<const uint8_t*> slices;
+		for (size_t s = first; ok && s < next; s++)
+		{
+			ok = images[s].Ok && images[s].Info.Width == images[first].Info.Width &&
+				images[s].Info.Height == images[first].Info.Height && images[s].Info.SRGB == images[first].Info.SRGB;
+			slices.push_back(pixels.data() + images[s].Offset);
+		}
+
+		if (ok && CreateTexture(device.Get(), context.Get(), images[first].Info, slices, request.Array, request.Target))
+			continue;
+
+		//Not something the decoder handles (or not a PNG at all) - let WIC have a go.  WIC can't build arrays
+		if (request.Array)
+		{
+			#if defined(DEBUG) || defined(_DEBUG)
+				printf("TextureLoader: couldn't build a texture array from %s (and %zu more)\n", request.Paths.empty() ? "nothing" : request.Paths[0].c_str(), request.Paths.size() - 1);
+			#endif
+			continue;
+		}
+
+		const AssetSpan& packed = images[first].Source;
+		if (packed.Data)
+			DirectX::CreateWICTextureFromMemory(device.Get(), context.Get(), packed.Data, packed.Size, nullptr, request.Target->ReleaseAndGetAddressOf());
+		else
+		{
+			std::wstring widePath(request.Paths[0].begin(), request.Paths[0].end());
+			DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), widePath.c_str(), nullptr, request.Target->ReleaseAndGetAddressOf());
+		}
+		fallbacks++;
+	}
+
+	#if defined(DEBUG) || defined(_DEBUG)
+		if (!images.empty())
+			ImageDecoder::ReportBatch(images, stats);
+		printf("Textures: %zu requests created (%d cooked, %d through WIC) in %.2f ms\n", requests.size(), cookedCount, fallbacks,
+			std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() * 1000.0);
+	#else
+		(void)start;
+		(void)fallbacks;
+		(void)cookedCount;
+	#endif
+
+	requests.clear();
+	images.clear();
+	pixels.clear();
+	pixels.shrink_to_fit();
+	return stats;
+}
+
+// --------------------------------------------------------
+// Opens the cooked DDS of every path, if they all have one
+// and they all match (one slice each, same size, format and
+// mip count) - leaves request.Cooked empty otherwise
+// --------------------------------------------------------
+bool TextureLoader::OpenCooked(AssetPack* pack, Request& request)
+{
+	request.Cooked.clear();
+	if (cookedRoot.empty() || request.Paths.empty())
+		return false;
+
+	//Textures/floor.png -> Textures/floor.dds, relative to either root.  A pair has one file between them
+	std::vector<std::string> names;
+	for (size_t i = 0; i < request.Paths.size(); i++)
+	{
+		const std::string& path = request.Paths[i];
+		if (path.size() <= assetsRoot.size() + 4 || path.compare(0, assetsRoot.size(), assetsRoot) != 0)
+			return false;
+		names.push_back(path.substr(assetsRoot.size()));
+	}
+	if (request.Packed)
+		names.assign(1, DdsFile::GetPackedName(names[0], names[1]));
+	else
+	{
+		for (size_t i = 0; i < names.size(); i++)
+			names[i] = names[i].substr(0, names[i].size() - 4) + ".dds";
+	}
+
+	std::vector<std::shared_ptr<CookedFile>> files;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		const std::string& name = names[i];
+
+		files.push_back(std::make_shared<CookedFile>());
+		const DdsImage& image = files[i]->Image;
+		const DdsImage& first = files[0]->Image;
+		if (!files[i]->Open(pack, assetsRoot + name, cookedRoot + name) ||
+			image.Dimension != D3D11_RESOURCE_DIMENSION_TEXTURE2D || image.Cube || image.ArraySize != 1 ||
+			image.DxgiFormat != first.DxgiFormat || image.Width != first.Width || image.Height != first.Height || image.MipLevels != first.MipLevels)
+			return false;
+	}
+
+	request.Cooked.swap(files);
+	return true;
+}
+
+// --------------------------------------------------------
+// Makes the texture from the files OpenCooked found.
+// Immutable, with every subresource pointing into the files
+// --------------------------------------------------------
+bool TextureLoader::CreateCooked(ID3D11Device* device, const Request& request)
+{
+	//D3D's order is every mip of slice 0, then every mip of slice 1...
+	std::vector<D3D11_SUBRESOURCE_DATA> data;
+	for (size_t i = 0; i < request.Cooked.size(); i++)
+	{
+		const DdsImage& image = request.Cooked[i]->Image;
+		for (size_t s = 0; s < image.Subresources.size(); s++)
+		{
+			D3D11_SUBRESOURCE_DATA subresource = {};
+			subresource.pSysMem = image.Subresources[s].Data;
+			subresource.SysMemPitch = image.Subresources[s].RowPitch;
+			subresource.SysMemSlicePitch = image.Subresources[s].SlicePitch;
+			data.push_back(subresource);
+		}
+	}
+
+	const DdsImage& image = request.Cooked[0]->Image;
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = image.Width;
+	desc.Height = image.Height;
+	desc.MipLevels = image.MipLevels;
+	desc.ArraySize = (UINT)request.Cooked.size();
+	desc.Format = (DXGI_FORMAT)image.DxgiFormat;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	if (FAILED(device->CreateTexture2D(&desc, data.data(), texture.GetAddressOf())))
+		return false;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = desc.Format;
+	if (request.Array)
+	{
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+		srvDesc.Texture2DArray.MipLevels = (UINT)-1;
+		srvDesc.Texture2DArray.ArraySize = desc.ArraySize;
+	}
+	else
+	{
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MipLevels = (UINT)-1;
+	}
+	return SUCCEEDED(device->CreateShaderResourceView(texture.Get(), &srvDesc, request.Target->ReleaseAndGetAddressOf()));
+}
+
+// --------------------------------------------------------
+// Roughness in R and metalness in G, from the red of each
+// decoded map, as the cooker packs them.  The smaller map is
+// point sampled up to the larger one's size
+// --------------------------------------------------------
+bool TextureLoader::CreatePacked(ID3D11Device* device, ID3D11DeviceContext* context, const DecodedImage& roughness, const DecodedImage& metalness, const std::vector<uint8_t>& pixels, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv)
+{
+	if (!roughness.Ok || !metalness.Ok)
+		return false;
+
+	const DecodedImage* maps[2] = { &roughness, &metalness };
+	ImageInfo info;
+	info.Width = (std::max)(roughness.Info.Width, metalness.Info.Width);
+	info.Height = (std::max)(roughness.Info.Height, metalness.Info.Height);
+	info.SRGB = false;
+
+	std::vector<uint8_t> packed(info.DecodedSize());
+	for (uint32_t y = 0; y < info.Height; y++)
+	{
+		for (uint32_t x = 0; x < info.Width; x++)
+		{
+			uint8_t* dst = &packed[((size_t)y * info.Width + x) * 4];
+			for (int m = 0; m < 2; m++)
+			{
+				const ImageInfo& source = maps[m]->Info;
+				size_t sx = (size_t)x * source.Width / info.Width;
+				size_t sy = (size_t)y * source.Height / info.Height;
+				uint8_t value = pixels[maps[m]->Offset + (sy * source.Width + sx) * 4];
+				dst[m] = source.SRGB ? SrgbToLinear(value) : value;
+			}
+			dst[2] = 0;
+			dst[3] = 255;
+		}
+	}
+
+	return CreateTexture(device, context, info, std::vector<const uint8_t*>(1, packed.data()), false, srv);
+}
+
+// --------------------------------------------------------
+// Matches what the WIC loader made of these files: RGBA8 (sRGB
+// if the PNG says so) with a full mip chain generated on the GPU
+// --------------------------------------------------------
+bool TextureLoader::CreateTexture(ID3D11Device* device, ID3D11DeviceContext* context, const ImageInfo& info, const std::vector<const uint8_t*>& slices, bool array, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv)
+{
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = info.Width;
+	desc.Height = info.Height;
+	desc.MipLevels = 0;
+	desc.ArraySize = (UINT)slices.size();
+	desc.Format = info.SRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.SampleDesc.Quality = 0;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+	desc.CPUAccessFlags = 0;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	if (FAILED(device->CreateTexture2D(&desc, nullptr, texture.GetAddressOf())))
+		return false;
+
+	//MipLevels = 0 asked for the full chain - find out how long that is
+	texture->GetDesc(&desc);
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = desc.Format;
+	if (array)
+	{
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+		srvDesc.Texture2DArray.MostDetailedMip = 0;
+		srvDesc.Texture2DArray.MipLevels = (UINT)-1;
+		srvDesc.Texture2DArray.FirstArraySlice = 0;
+		srvDesc.Texture2DArray.ArraySize = desc.ArraySize;
+	}
+	else
+	{
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MostDetailedMip = 0;
+		srvDesc.Texture2D.MipLevels = (UINT)-1;
+	}
+	if (FAILED(device->CreateShaderResourceView(texture.Get(), &srvDesc, srv->ReleaseAndGetAddressOf())))
+		return false;
+
+	//Top level of each slice (subresource = mip + slice * mip count)
+	for (size_t s = 0; s < slices.size(); s++)
+		context->UpdateSubresource(texture.Get(), (UINT)s * desc.MipLevels, nullptr, slices[s], info.Width * 4, info.Width * info.Height * 4);
+	context->GenerateMips(srv->Get());
+	return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ImageDecoder.h"
+
+// --------------------------------------------------------
+// Loads a set of PNG textures in one go
+//
+// A texture with a cooked DDS (see AssetCooker) is made straight
+// from it - already block compressed and mipped.  The rest are
+// decoded at once on worker threads (see ImageDecoder); only
+// creating the textures and their mips happens on the calling
+// (device) thread.  Anything the decoder can't handle falls back
+// to the WIC loader
+//
+// Load() can also be done in its two halves: Decode() touches no
+// device, so it can run on a thread of its own while frames go
+// on, and Create() finishes the job on the device thread
+//
+// Same-sized images can also be packed into one Texture2DArray,
+// so materials that differ only by texture can share one, and a
+// roughness map and a metalness map into one texture's red and
+// green, so the shader samples them together
+// --------------------------------------------------------
+class TextureLoader
+{
+public:
+	// Where cooked textures live: assetsRoot/Textures/floor.png is cooked
+	// to cookedRoot/Textures/floor.dds (or assetsRoot/Textures/floor.dds in
+	// the pack).  Without this only the PNGs are read
+	void SetCookedRoots(const std::string& assetsRoot, const std::string& cookedRoot);
+
+	// srv is filled in by Load
+	void Add(const std::string& path, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv);
+
+	// One Texture2DArray with a slice per path, in order.  Every image
+	// needs the same size (a single path makes a one-slice array)
+	void AddArray(const std::vector<std::string>& paths, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv);
+
+	// One texture with the roughness map's red in R and the metalness map's in G - BC5 when
+	// the pair was cooked (see AssetCooker), otherwise RGBA8 packed here from the two PNGs
+	void AddRoughnessMetalness(const std::string& roughness, const std::string& metalness, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv);
+
+	// Loads everything added since the last Load (from the pack when it has the file)
+	ImageBatchStats Load(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, AssetPack* pack = nullptr);
+
+	// Opens the cooked files and decodes the rest of everything added - safe on any thread
+	void Decode(AssetPack* pack = nullptr);
+
+	// Makes the textures Decode got ready, on the device thread (Decode's pack has to stay open until then)
+	ImageBatchStats Create(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+
+private:
+	struct CookedFile;
+
+	struct Request
+	{
+		std::vector<std::string> Paths;
+		bool Array;
+		bool Packed;			// Paths are a roughness and a metalness map for one texture
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* Target;
+		std::vector<std::shared_ptr<CookedFile>> Cooked;		// One per path (per pair when packed), when every path has a cooked DDS
+	};
+
+	std::vector<Request> requests;
+	std::string assetsRoot;
+	std::string cookedRoot;
+
+	// The decoded batch, between Decode and Create
+	std::vector<DecodedImage> images;
+	std::vector<uint8_t> pixels;
+	ImageBatchStats stats;
+
+	bool OpenCooked(AssetPack* pack, Request& request);
+	static bool CreateCooked(ID3D11Device* device, const Request& request);
+	static bool CreatePacked(ID3D11Device* device, ID3D11DeviceContext* context, const DecodedImage& roughness, const DecodedImage& metalness, const std::vector<uint8_t>& pixels, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv);
+	static bool CreateTexture(ID3D11Device* device, ID3D11DeviceContext* context, const ImageInfo& info, const std::vector<const uint8_t*>& slices, bool array, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv);
+};
@@ -0,0 +1,320 @@
+#include "TextureResidency.h"
+#include "DdsFile.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace DirectX;
+
+TextureResidency::TextureResidency(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, AssetPack* pack, size_t budget) :
+	device(device), context(context), pack(pack), tracker(budget)
+{
+}
+
+TextureResidency::~TextureResidency()
+{
+	if (batch)
+		batch->Decoder.join();
+}
+
+void TextureResidency::SetCookedRoots(const std::string& assetsRoot, const std::string& cookedRoot)
+{
+	this->assetsRoot = assetsRoot;
+	this->cookedRoot = cookedRoot;
+}
+
+TextureHandle TextureResidency::Add(const std::string& path, XMFLOAT4 placeholder)
+{
+	return Register(std::vector<std::string>(1, path), false, false, placeholder);
+}
+
+TextureHandle TextureResidency::AddArray(const std::vector<std::string>& paths, XMFLOAT4 placeholder)
+{
+	return Register(paths, true, false, placeholder);
+}
+
+TextureHandle TextureResidency::AddRoughnessMetalness(const std::string& roughness, const std::string& metalness, XMFLOAT4 placeholder)
+{
+	std::vector<std::string> paths;
+	paths.push_back(roughness);
+	paths.push_back(metalness);
+	return Register(paths, false, true, placeholder);
+}
+
+TextureHandle TextureResidency::Register(const std::vector<std::string>& paths, bool array, bool packed, XMFLOAT4 placeholder)
+{
+	Texture texture;
+	texture.Paths = paths;
+	texture.Array = array;
+	texture.Packed = packed;
+	texture.Placeholder = GetPlaceholder(placeholder, array);
+	textures.push_back(texture);
+
+	TextureHandle handle;
+	handle.Index = tracker.Add();
+	return handle;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> TextureResidency::Use(TextureHandle handle)
+{
+	if (!handle.IsValid() || handle.Index >= textures.size())
+		return nullptr;
+
+	//A reduced texture still beats the placeholder while the full one is on its way
+	const Texture& texture = textures[handle.Index];
+	tracker.Use(handle.Index);
+	return texture.Srv.Get() ? texture.Srv : texture.Placeholder;
+}
+
+void TextureResidency::Update()
+{
+	tracker.BeginFrame();
+
+	//Nothing is created off the device thread - the batch only decoded
+	if (batch && batch->Decoded)
+		FinishBatch();
+
+	//Everything missed since goes in the next batch, so the decodes share the worker threads
+	if (!batch)
+	{
+		std::vector<uint32_t> missed;
+		tracker.TakeLoads(missed);
+		if (!missed.empty())
+			StartBatch(missed);
+	}
+
+	std::vector<ResidencyAction> actions;
+	tracker.Trim(actions);
+	for (size_t i = 0; i < actions.size(); i++)
+	{
+		Texture& texture = textures[actions[i].Item];
+		if (actions[i].Action == ResidencyAction::Evict)
+			texture.Srv.Reset();
+		else if (!DropMip(texture))
+		{
+			//Keeping it whole is the only safe option - the tracker undercounts it until it's reloaded
+			#if defined(DEBUG) || defined(_DEBUG)
+				printf("TextureResidency: couldn't drop a mip of %s\n", texture.Paths[0].c_str());
+			#endif
+		}
+	}
+}
+
+void TextureResidency::SetBudget(size_t bytes)
+{
+	tracker.SetBudget(bytes);
+}
+
+ResidencyStats TextureResidency::GetStats()
+{
+	return tracker.GetStats();
+}
+
+void TextureResidency::Report()
+{
+	ResidencyStats stats = tracker.GetStats();
+	printf("Textures: %zu of %zu resident (%.1f MB, peak %.1f MB, budget %.1f MB)\n", stats.Resident, stats.Items,
+		stats.ResidentBytes / (1024.0 * 1024.0), stats.PeakBytes / (1024.0 * 1024.0), stats.Budget / (1024.0 * 1024.0));
+	printf("  %zu uses: %zu hits, %zu misses (%.1f%% hit rate), %zu loads, %zu failed, %zu mips dropped, %zu evicted\n",
+		stats.Uses, stats.Hits, stats.Misses, stats.HitRate() * 100.0f, stats.Loads, stats.Failures, stats.MipDrops, stats.Evictions);
+}
+
+void TextureResidency::StartBatch(std::vector<uint32_t>& items)
+{
+	batch.reset(new Batch());
+	batch->Items.swap(items);
+	batch->Loaded.resize(batch->Items.size());
+	batch->Loader.SetCookedRoots(assetsRoot, cookedRoot);
+	for (size_t i = 0; i < batch->Items.size(); i++)
+	{
+		const Texture& texture = textures[batch->Items[i]];
+		if (texture.Array)
+			batch->Loader.AddArray(texture.Paths, &batch->Loaded[i]);
+		else if (texture.Packed)
+			batch->Loader.AddRoughnessMetalness(texture.Paths[0], texture.Paths[1], &batch->Loaded[i]);
+		else
+			batch->Loader.Add(texture.Paths[0], &batch->Loaded[i]);
+	}
+
+	//The tracker keeps these queued until FinishBatch, so they aren't missed into another batch meanwhile
+	Batch* decoding = batch.get();
+	AssetPack* source = pack;
+	decoding->Decoded = false;
+	decoding->Decoder = std::thread([decoding, source]()
+	{
+		decoding->Loader.Decode(source);
+		decoding->Decoded = true;
+	});
+}
+
+void TextureResidency::FinishBatch()
+{
+	batch->Decoder.join();
+	batch->Loader.Create(device, context);
+
+	for (size_t i = 0; i < batch->Items.size(); i++)
+	{
+		uint32_t item = batch->Items[i];
+		std::vector<size_t> mipBytes;
+		if (batch->Loaded[i].Get() && GetMipBytes(batch->Loaded[i].Get(), mipBytes))
+		{
+			textures[item].Srv = batch->Loaded[i];
+			tracker.Loaded(item, mipBytes);
+		}
+		else
+			tracker.LoadFailed(item);
+	}
+	batch.reset();
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> TextureResidency::GetPlaceholder(XMFLOAT4 color, bool array)
+{
+	float channels[4] = { color.x, color.y, color.z, color.w };
+	uint32_t texel = 0;
+	for (int c = 0; c < 4; c++)
+	{
+		float value = (std::min)((std::max)(channels[c], 0.0f), 1.0f);
+		texel |= (uint32_t)(value * 255.0f + 0.5f) << (c * 8);
+	}
+
+	uint64_t key = texel | ((uint64_t)(array ? 1 : 0) << 32);
+	std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>>::iterator found = placeholders.find(key);
+	if (found != placeholders.end())
+		return found->second;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = 1;
+	desc.Height = 1;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	D3D11_SUBRESOURCE_DATA data = {};
+	data.pSysMem = &texel;
+	data.SysMemPitch = 4;
+
+	//Same view type as the real texture, so the shader's declaration matches either way
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+	viewDesc.Format = desc.Format;
+	if (array)
+	{
+		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+		viewDesc.Texture2DArray.MipLevels = 1;
+		viewDesc.Texture2DArray.ArraySize = 1;
+	}
+	else
+	{
+		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		viewDesc.Texture2D.MipLevels = 1;
+	}
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	if (SUCCEEDED(device->CreateTexture2D(&desc, &data, texture.GetAddressOf())))
+		device->CreateShaderResourceView(texture.Get(), &viewDesc, srv.GetAddressOf());
+
+	placeholders[key] = srv;
+	return srv;
+}
+
+// --------------------------------------------------------
+// Swaps the texture for a copy without its top level - a
+// quarter of the memory.  The copy is GPU to GPU, level by
+// level, so nothing is decoded again
+// --------------------------------------------------------
+bool TextureResidency::DropMip(Texture& texture)
+{
+	if (!texture.Srv.Get())
+		return false;
+
+	Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> source;
+	texture.Srv->GetResource(resource.GetAddressOf());
+	if (FAILED(resource.As(&source)))
+		return false;
+
+	D3D11_TEXTURE2D_DESC desc;
+	source->GetDesc(&desc);
+	UINT levels = desc.MipLevels;
+	if (levels < 2)
+		return false;
+
+	//Cooked textures are block compressed, and the top level of those has to be whole blocks
+	bool blockCompressed = false;
+	DdsFile::GetElementBytes(desc.Format, blockCompressed);
+	if (blockCompressed && ((desc.Width / 2) % 4 != 0 || (desc.Height / 2) % 4 != 0))
+		return false;
+
+	//Never generated again, and it has to be writable for the copies
+	desc.Width = (std::max)(1u, desc.Width / 2);
+	desc.Height = (std::max)(1u, desc.Height / 2);
+	desc.MipLevels = levels - 1;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.CPUAccessFlags = 0;
+	desc.MiscFlags &= ~(UINT)D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> smaller;
+	if (FAILED(device->CreateTexture2D(&desc, nullptr, smaller.GetAddressOf())))
+		return false;
+
+	//Subresource = mip + slice * mip count, in both
+	for (UINT slice = 0; slice < desc.ArraySize; slice++)
+		for (UINT mip = 0; mip + 1 < levels; mip++)
+			context->CopySubresourceRegion(smaller.Get(), mip + slice * (levels - 1), 0, 0, 0, source.Get(), mip + 1 + slice * levels, nullptr);
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
+	texture.Srv->GetDesc(&viewDesc);
+	if (viewDesc.ViewDimension == D3D11_SRV_DIMENSION_TEXTURE2DARRAY)
+	{
+		viewDesc.Texture2DArray.MostDetailedMip = 0;
+		viewDesc.Texture2DArray.MipLevels = (UINT)-1;
+	}
+	else
+	{
+		viewDesc.Texture2D.MostDetailedMip = 0;
+		viewDesc.Texture2D.MipLevels = (UINT)-1;
+	}
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	if (FAILED(device->CreateShaderResourceView(smaller.Get(), &viewDesc, srv.GetAddressOf())))
+		return false;
+
+	texture.Srv = srv;
+	return true;
+}
+
+bool TextureResidency::GetMipBytes(ID3D11ShaderResourceView* srv, std::vector<size_t>& mipBytes)
+{
+	Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	srv->GetResource(resource.GetAddressOf());
+	if (FAILED(resource.As(&texture)))
+		return false;
+
+	D3D11_TEXTURE2D_DESC desc;
+	texture->GetDesc(&desc);
+
+	//Anything DdsFile doesn't know is counted as 32 bits a texel
+	bool blockCompressed = false;
+	uint32_t elementBytes = DdsFile::GetElementBytes(desc.Format, blockCompressed);
+	if (elementBytes == 0)
+		elementBytes = 4;
+
+	mipBytes.resize(desc.MipLevels);
+	for (UINT mip = 0; mip < desc.MipLevels; mip++)
+	{
+		size_t width = (std::max)(1u, desc.Width >> mip);
+		size_t height = (std::max)(1u, desc.Height >> mip);
+		if (blockCompressed)
+		{
+			width = (width + 3) / 4;
+			height = (height + 3) / 4;
+		}
+		mipBytes[mip] = width * height * elementBytes * desc.ArraySize;
+	}
+	return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <DirectXMath.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "AssetPack.h"
+#include "ResidencyTracker.h"
+#include "TextureLoader.h"
+
+// --------------------------------------------------------
+// Refers to one texture registered with a TextureResidency
+// --------------------------------------------------------
+struct TextureHandle
+{
+	uint32_t Index = 0xFFFFFFFF;
+
+	bool IsValid() const { return Index != 0xFFFFFFFF; }
+};
+
+// --------------------------------------------------------
+// Textures that load the first time they're drawn with and
+// shrink or go away when they aren't
+//
+// - Add() only records the paths - nothing is read until a
+//   material binds the texture (Material::ReadyTexture), which
+//   gets a 1x1 placeholder in the texture's own colour until
+//   the load is done
+// - Update() (once a frame, before drawing) sends everything
+//   missed since the last batch to a thread of its own to be
+//   decoded (TextureLoader::Decode), and creates the textures
+//   on the first Update after it's done - frames never wait on
+//   a decode, and one batch is in flight at a time.  Then it
+//   trims to the budget: least recently used textures lose
+//   their top mip, then go completely (see ResidencyTracker)
+// - A texture used again after losing mips keeps drawing with
+//   what's left until the full one is back
+// --------------------------------------------------------
+class TextureResidency
+{
+public:
+	// budget is in bytes of texture memory (0 = unlimited)
+	TextureResidency(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, AssetPack* pack = nullptr, size_t budget = 0);
+
+	// Waits for a batch that's still decoding (the pack has to outlive this)
+	~TextureResidency();
+
+	// Cooked DDS files are loaded in place of the PNGs when they exist (see TextureLoader::SetCookedRoots)
+	void SetCookedRoots(const std::string& assetsRoot, const std::string& cookedRoot);
+
+	// placeholder is the colour drawn until the texture is loaded, as stored (UNORM RGBA)
+	TextureHandle Add(const std::string& path, DirectX::XMFLOAT4 placeholder);
+
+	// A Texture2DArray with a slice per path (see TextureLoader::AddArray)
+	TextureHandle AddArray(const std::vector<std::string>& paths, DirectX::XMFLOAT4 placeholder);
+
+	// Roughness in R and metalness in G (see TextureLoader::AddRoughnessMetalness)
+	TextureHandle AddRoughnessMetalness(const std::string& roughness, const std::string& metalness, DirectX::XMFLOAT4 placeholder);
+
+	// Counts as a use this frame.  Returns the texture, or its placeholder until it's loaded
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Use(TextureHandle handle);
+
+	// Once a frame, before anything is drawn
+	void Update();
+
+	void SetBudget(size_t bytes);
+
+	ResidencyStats GetStats();
+	void Report();
+
+private:
+	struct Texture
+	{
+		std::vector<std::string> Paths;
+		bool Array;
+		bool Packed;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Srv;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Placeholder;
+	};
+
+	// Textures being decoded - only the decoding thread touches it until Decoded is set
+	struct Batch
+	{
+		std::vector<uint32_t> Items;
+		std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> Loaded;
+		TextureLoader Loader;
+		std::thread Decoder;
+		std::atomic<bool> Decoded;
+	};
+
+	void StartBatch(std::vector<uint32_t>& items);
+	void FinishBatch();
+
+	TextureHandle Register(const std::vector<std::string>& paths, bool array, bool packed, DirectX::XMFLOAT4 placeholder);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetPlaceholder(DirectX::XMFLOAT4 color, bool array);
+	bool DropMip(Texture& texture);
+
+	// Size of each mip level of the texture behind srv (every slice)
+	static bool GetMipBytes(ID3D11ShaderResourceView* srv, std::vector<size_t>& mipBytes);
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	AssetPack* pack;
+	std::string assetsRoot;
+	std::string cookedRoot;
+
+	ResidencyTracker tracker;
+	std::vector<Texture> textures;
+	std::unique_ptr<Batch> batch;
+
+	// One per colour (and array-ness)
+	std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> placeholders;
+};
@@ -12,5 +12,5 @@ struct Vertex
 	DirectX::XMFLOAT3 Position;	    // The local position of the vertex
 	DirectX::XMFLOAT3 Normal;       // Normal
 	DirectX::XMFLOAT2 UV;			//Texture UV coordinate
-	DirectX::XMFLOAT3 Tangent;
+	DirectX::XMFLOAT4 Tangent;		//Tangent + handedness in w (see TangentGenerator)
 };
\ No newline at end of file
@@ -0,0 +1,389 @@
+#include "VertexFormats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Input layouts - element order matches VertexShaderInput
+// (and PackedVertexShaderInput) in ShaderIncludes.hlsli
+// --------------------------------------------------------
+const D3D11_INPUT_ELEMENT_DESC FullVertexFormat::InputElements[] =
+{
+	{ "POSITION",	0, DXGI_FORMAT_R32G32B32_FLOAT,	0, 0,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "NORMAL",		0, DXGI_FORMAT_R32G32B32_FLOAT,	0, 12,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD",	0, DXGI_FORMAT_R32G32_FLOAT,	0, 24,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TANGENT",	0, DXGI_FORMAT_R32G32B32A32_FLOAT,	0, 32,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+const D3D11_INPUT_ELEMENT_DESC Unorm16VertexFormat::InputElements[] =
+{
+	{ "POSITION",	0, DXGI_FORMAT_R16G16B16A16_UNORM,	0, 0,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "NORMAL",		0, DXGI_FORMAT_R16G16_SNORM,		0, 8,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD",	0, DXGI_FORMAT_R16G16_UNORM,		0, 16,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TANGENT",	0, DXGI_FORMAT_R16G16_SNORM,		0, 12,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+const D3D11_INPUT_ELEMENT_DESC HalfVertexFormat::InputElements[] =
+{
+	{ "POSITION",	0, DXGI_FORMAT_R16G16B16A16_FLOAT,	0, 0,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "NORMAL",		0, DXGI_FORMAT_R16G16_SNORM,		0, 8,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD",	0, DXGI_FORMAT_R16G16_UNORM,		0, 16,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TANGENT",	0, DXGI_FORMAT_R16G16_SNORM,		0, 12,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+namespace
+{
+	//Position + UV ranges of a set of vertices
+	void GetRanges(const Vertex* vertices, size_t count, XMFLOAT3& posMin, XMFLOAT3& posMax, XMFLOAT2& uvMin, XMFLOAT2& uvMax)
+	{
+		posMin = posMax = count ? vertices[0].Position : XMFLOAT3(0, 0, 0);
+		uvMin = uvMax = count ? vertices[0].UV : XMFLOAT2(0, 0);
+		for (size_t i = 1; i < count; i++)
+		{
+			const Vertex& v = vertices[i];
+			posMin.x = (std::min)(posMin.x, v.Position.x); posMax.x = (std::max)(posMax.x, v.Position.x);
+			posMin.y = (std::min)(posMin.y, v.Position.y); posMax.y = (std::max)(posMax.y, v.Position.y);
+			posMin.z = (std::min)(posMin.z, v.Position.z); posMax.z = (std::max)(posMax.z, v.Position.z);
+			uvMin.x = (std::min)(uvMin.x, v.UV.x); uvMax.x = (std::max)(uvMax.x, v.UV.x);
+			uvMin.y = (std::min)(uvMin.y, v.UV.y); uvMax.y = (std::max)(uvMax.y, v.UV.y);
+		}
+	}
+
+	//(value - offset) / scale, with flat axes (scale 0) mapping to 0
+	inline float Normalize(float value, float offset, float scale)
+	{
+		return scale > 0.0f ? (value - offset) / scale : 0.0f;
+	}
+
+	//UVs are unorm16 across the UV range in both packed formats
+	void QuantizeUVs(XMFLOAT2 uvMin, XMFLOAT2 uvMax, VertexQuantization& q)
+	{
+		q.UVOffset = uvMin;
+		q.UVScale = XMFLOAT2(uvMax.x - uvMin.x, uvMax.y - uvMin.y);
+	}
+
+	//Everything but the position is stored the same way in both packed formats
+	void EncodeShared(const Vertex& v, const VertexQuantization& q, PackedVertex& out)
+	{
+		XMFLOAT2 n = VertexPacking::OctEncode(v.Normal);
+		XMFLOAT2 t = VertexPacking::OctEncode(XMFLOAT3(v.Tangent.x, v.Tangent.y, v.Tangent.z));
+		out.Normal[0] = VertexPacking::ToSnorm16(n.x);
+		out.Normal[1] = VertexPacking::ToSnorm16(n.y);
+		out.Tangent[0] = VertexPacking::ToSnorm16(t.x);
+		out.Tangent[1] = VertexPacking::ToSnorm16(t.y);
+		out.UV[0] = VertexPacking::ToUnorm16(Normalize(v.UV.x, q.UVOffset.x, q.UVScale.x));
+		out.UV[1] = VertexPacking::ToUnorm16(Normalize(v.UV.y, q.UVOffset.y, q.UVScale.y));
+	}
+
+	void DecodeShared(const PackedVertex& p, const VertexQuantization& q, Vertex& out)
+	{
+		out.Normal = VertexPacking::OctDecode(XMFLOAT2(VertexPacking::FromSnorm16(p.Normal[0]), VertexPacking::FromSnorm16(p.Normal[1])));
+		XMFLOAT3 t = VertexPacking::OctDecode(XMFLOAT2(VertexPacking::FromSnorm16(p.Tangent[0]), VertexPacking::FromSnorm16(p.Tangent[1])));
+		out.Tangent = XMFLOAT4(t.x, t.y, t.z, out.Tangent.w);
+		out.UV.x = q.UVOffset.x + VertexPacking::FromUnorm16(p.UV[0]) * q.UVScale.x;
+		out.UV.y = q.UVOffset.y + VertexPacking::FromUnorm16(p.UV[1]) * q.UVScale.y;
+	}
+
+	inline float Length(XMFLOAT3 v)
+	{
+		return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+	}
+
+	//Angle between two (not necessarily unit) vectors in degrees
+	inline float AngleBetween(XMFLOAT3 a, XMFLOAT3 b)
+	{
+		float la = Length(a);
+		float lb = Length(b);
+		if (la == 0.0f || lb == 0.0f)
+			return 0.0f;
+
+		float d = (a.x * b.x + a.y * b.y + a.z * b.z) / (la * lb);
+		return acosf((std::max)(-1.0f, (std::min)(1.0f, d))) * (180.0f / XM_PI);
+	}
+}
+
+// --------------------------------------------------------
+// Full floats - nothing to quantise
+// --------------------------------------------------------
+VertexQuantization FullVertexFormat::Quantize(const Vertex*, size_t)
+{
+	VertexQuantization q;
+	q.PositionOffset = XMFLOAT3(0, 0, 0);
+	q.PositionScale = XMFLOAT3(1, 1, 1);
+	q.UVOffset = XMFLOAT2(0, 0);
+	q.UVScale = XMFLOAT2(1, 1);
+	return q;
+}
+
+Vertex FullVertexFormat::Encode(const Vertex& v, const VertexQuantization&)
+{
+	return v;
+}
+
+Vertex FullVertexFormat::Decode(const Vertex& v, const VertexQuantization&)
+{
+	return v;
+}
+
+// --------------------------------------------------------
+// unorm16 positions - [0,1] across the bounding box
+// --------------------------------------------------------
+VertexQuantization Unorm16VertexFormat::Quantize(const Vertex* vertices, size_t count)
+{
+	XMFLOAT3 posMin, posMax;
+	XMFLOAT2 uvMin, uvMax;
+	GetRanges(vertices, count, posMin, posMax, uvMin, uvMax);
+
+	VertexQuantization q;
+	q.PositionOffset = posMin;
+	q.PositionScale = XMFLOAT3(posMax.x - posMin.x, posMax.y - posMin.y, posMax.z - posMin.z);
+	QuantizeUVs(uvMin, uvMax, q);
+	return q;
+}
+
+PackedVertex Unorm16VertexFormat::Encode(const Vertex& v, const VertexQuantization& q)
+{
+	PackedVertex p;
+	p.Position[0] = VertexPacking::ToUnorm16(Normalize(v.Position.x, q.PositionOffset.x, q.PositionScale.x));
+	p.Position[1] = VertexPacking::ToUnorm16(Normalize(v.Position.y, q.PositionOffset.y, q.PositionScale.y));
+	p.Position[2] = VertexPacking::ToUnorm16(Normalize(v.Position.z, q.PositionOffset.z, q.PositionScale.z));
+	p.Position[3] = v.Tangent.w < 0.0f ? 0 : 0xFFFF;
+	EncodeShared(v, q, p);
+	return p;
+}
+
+Vertex Unorm16VertexFormat::Decode(const PackedVertex& p, const VertexQuantization& q)
+{
+	Vertex v;
+	v.Position.x = q.PositionOffset.x + VertexPacking::FromUnorm16(p.Position[0]) * q.PositionScale.x;
+	v.Position.y = q.PositionOffset.y + VertexPacking::FromUnorm16(p.Position[1]) * q.PositionScale.y;
+	v.Position.z = q.PositionOffset.z + VertexPacking::FromUnorm16(p.Position[2]) * q.PositionScale.z;
+	v.Tangent.w = p.Position[3] >= 0x8000 ? 1.0f : -1.0f;
+	DecodeShared(p, q, v);
+	return v;
+}
+
+// --------------------------------------------------------
+// Half positions - [-1,1] around the center of the bounds
+// --------------------------------------------------------
+VertexQuantization HalfVertexFormat::Quantize(const Vertex* vertices, size_t count)
+{
+	XMFLOAT3 posMin, posMax;
+	XMFLOAT2 uvMin, uvMax;
+	GetRanges(vertices, count, posMin, posMax, uvMin, uvMax);
+
+	VertexQuantization q;
+	q.PositionOffset = XMFLOAT3((posMin.x + posMax.x) * 0.5f, (posMin.y + posMax.y) * 0.5f, (posMin.z + posMax.z) * 0.5f);
+	q.PositionScale = XMFLOAT3((posMax.x - posMin.x) * 0.5f, (posMax.y - posMin.y) * 0.5f, (posMax.z - posMin.z) * 0.5f);
+	QuantizeUVs(uvMin, uvMax, q);
+	return q;
+}
+
+PackedVertex HalfVertexFormat::Encode(const Vertex& v, const VertexQuantization& q)
+{
+	PackedVertex p;
+	p.Position[0] = VertexPacking::ToHalf(Normalize(v.Position.x, q.PositionOffset.x, q.PositionScale.x));
+	p.Position[1] = VertexPacking::ToHalf(Normalize(v.Position.y, q.PositionOffset.y, q.PositionScale.y));
+	p.Position[2] = VertexPacking::ToHalf(Normalize(v.Position.z, q.PositionOffset.z, q.PositionScale.z));
+	p.Position[3] = VertexPacking::ToHalf(v.Tangent.w < 0.0f ? -1.0f : 1.0f);	// Shader can use w as-is
+	EncodeShared(v, q, p);
+	return p;
+}
+
+Vertex HalfVertexFormat::Decode(const PackedVertex& p, const VertexQuantization& q)
+{
+	Vertex v;
+	v.Position.x = q.PositionOffset.x + VertexPacking::FromHalf(p.Position[0]) * q.PositionScale.x;
+	v.Position.y = q.PositionOffset.y + VertexPacking::FromHalf(p.Position[1]) * q.PositionScale.y;
+	v.Position.z = q.PositionOffset.z + VertexPacking::FromHalf(p.Position[2]) * q.PositionScale.z;
+	v.Tangent.w = VertexPacking::FromHalf(p.Position[3]) < 0.0f ? -1.0f : 1.0f;
+	DecodeShared(p, q, v);
+	return v;
+}
+
+// --------------------------------------------------------
+// Octahedral encoding - projects the vector onto an octahedron
+// and unfolds the lower half over the corners of the square
+// (Cigolle et al., "A Survey of Efficient Representations for
+// Independent Unit Vectors", 2014)
+// --------------------------------------------------------
+XMFLOAT2 VertexPacking::OctEncode(XMFLOAT3 n)
+{
+	float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+	if (l1 == 0.0f)
+		return XMFLOAT2(0, 0);
+
+	float u = n.x / l1;
+	float v = n.y / l1;
+	if (n.z < 0.0f)
+	{
+		float fu = (1.0f - fabsf(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+		float fv = (1.0f - fabsf(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+		u = fu;
+		v = fv;
+	}
+	return XMFLOAT2(u, v);
+}
+
+XMFLOAT3 VertexPacking::OctDecode(XMFLOAT2 e)
+{
+	XMFLOAT3 n(e.x, e.y, 1.0f - fabsf(e.x) - fabsf(e.y));
+	if (n.z < 0.0f)
+	{
+		n.x = (1.0f - fabsf(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f);
+		n.y = (1.0f - fabsf(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	float len = Length(n);
+	return XMFLOAT3(n.x / len, n.y / len, n.z / len);
+}
+
+// --------------------------------------------------------
+// Scalar conversions - decoding follows the D3D rules so the
+// error metrics match what the shader will actually see
+// --------------------------------------------------------
+int16_t VertexPacking::ToSnorm16(float v)
+{
+	v = (std::max)(-1.0f, (std::min)(1.0f, v));
+	return (int16_t)lroundf(v * 32767.0f);
+}
+
+float VertexPacking::FromSnorm16(int16_t v)
+{
+	return (std::max)(-1.0f, v / 32767.0f);
+}
+
+uint16_t VertexPacking::ToUnorm16(float v)
+{
+	v = (std::max)(0.0f, (std::min)(1.0f, v));
+	return (uint16_t)lroundf(v * 65535.0f);
+}
+
+float VertexPacking::FromUnorm16(uint16_t v)
+{
+	return v / 65535.0f;
+}
+
+//IEEE binary16 with round-to-nearest-even, like the hardware conversion
+uint16_t VertexPacking::ToHalf(float v)
+{
+	uint32_t f;
+	memcpy(&f, &v, 4);
+
+	uint16_t sign = (uint16_t)((f >> 16) & 0x8000);
+	uint32_t mantissa = f & 0x7FFFFF;
+	int exponent = (int)((f >> 23) & 0xFF) - 127 + 15;
+
+	//Inf/NaN
+	if ((f & 0x7FFFFFFF) >= 0x7F800000)
+		return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+
+	//Too big
+	if (exponent >= 31)
+		return sign | 0x7C00;
+
+	//Denormal (or flushes to zero)
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+			return sign;
+
+		mantissa |= 0x800000;
+		unsigned int shift = (unsigned int)(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1)))
+			half++;
+		return sign | (uint16_t)half;
+	}
+
+	//Rounding can carry into the exponent, which is still correct
+	uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+	uint32_t remainder = mantissa & 0x1FFF;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+		half++;
+	return sign | (uint16_t)half;
+}
+
+float VertexPacking::FromHalf(uint16_t h)
+{
+	uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+	uint32_t exponent = (h >> 10) & 0x1F;
+	uint32_t mantissa = h & 0x3FF;
+	uint32_t f;
+
+	if (exponent == 0)
+	{
+		if (mantissa == 0)
+		{
+			f = sign;
+		}
+		else
+		{
+			//Denormal - shift until the leading 1 is implicit
+			exponent = 127 - 15 + 1;
+			while (!(mantissa & 0x400))
+			{
+				mantissa <<= 1;
+				exponent--;
+			}
+			f = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+		}
+	}
+	else if (exponent == 31)
+	{
+		f = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else
+	{
+		f = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	}
+
+	float v;
+	memcpy(&v, &f, 4);
+	return v;
+}
+
+void VertexPacking::AccumulateError(const Vertex& original, const Vertex& decoded, VertexQuantizationError& error, double& positionTotal)
+{
+	XMFLOAT3 d(decoded.Position.x - original.Position.x, decoded.Position.y - original.Position.y, decoded.Position.z - original.Position.z);
+	float positionError = Length(d);
+	error.MaxPositionError = (std::max)(error.MaxPositionError, positionError);
+	positionTotal += positionError;
+
+	error.MaxNormalError = (std::max)(error.MaxNormalError, AngleBetween(original.Normal, decoded.Normal));
+	error.MaxTangentError = (std::max)(error.MaxTangentError, AngleBetween(
+		XMFLOAT3(original.Tangent.x, original.Tangent.y, original.Tangent.z),
+		XMFLOAT3(decoded.Tangent.x, decoded.Tangent.y, decoded.Tangent.z)));
+
+	float uvError = (std::max)(fabsf(decoded.UV.x - original.UV.x), fabsf(decoded.UV.y - original.UV.y));
+	error.MaxUVError = (std::max)(error.MaxUVError, uvError);
+
+	if ((original.Tangent.w < 0.0f) != (decoded.Tangent.w < 0.0f))
+		error.SignErrors++;
+}
+
+// --------------------------------------------------------
+// Prints size and round-trip error of each format for a mesh
+// --------------------------------------------------------
+void VertexPacking::ReportErrors(const char* name, const Vertex* vertices, size_t count)
+{
+	VertexQuantizationError unorm = MeasureError<Unorm16VertexFormat>(vertices, count);
+	VertexQuantizationError half = MeasureError<HalfVertexFormat>(vertices, count);
+
+	printf("%s: %zu vertices, %zu bytes full, %zu bytes packed\n", name, count,
+		count * FullVertexFormat::Stride, count * Unorm16VertexFormat::Stride);
+
+	const VertexQuantizationError* errors[] = { &unorm, &half };
+	const char* names[] = { Unorm16VertexFormat::Name(), HalfVertexFormat::Name() };
+	for (int i = 0; i < 2; i++)
+	{
+		printf("  %-8s position max %.6f avg %.6f, normal %.4f deg, tangent %.4f deg, uv %.6f, %zu sign errors\n",
+			names[i], errors[i]->MaxPositionError, errors[i]->AvgPositionError,
+			errors[i]->MaxNormalError, errors[i]->MaxTangentError, errors[i]->MaxUVError, errors[i]->SignErrors);
+	}
+}
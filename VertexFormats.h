@@ -0,0 +1,163 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// A 20 byte vertex shared by the packed formats below
+//
+// - Position: xyz quantised inside the mesh bounds, w holds
+//   the tangent handedness (0 = -1, max = +1)
+// - Normal/Tangent: octahedral encoded unit vectors
+// - UV: quantised inside the mesh's UV range
+//
+// How Position is stored (unorm16 or half) depends on the format
+// --------------------------------------------------------
+struct PackedVertex
+{
+	uint16_t Position[4];
+	int16_t Normal[2];
+	int16_t Tangent[2];
+	uint16_t UV[2];
+};
+static_assert(sizeof(PackedVertex) == 20, "PackedVertex should be 20 bytes");
+
+// --------------------------------------------------------
+// Per-mesh values needed to turn a packed vertex back into
+// real units (these go to the vertex shader alongside it)
+//
+// position = PositionOffset + stored * PositionScale
+// uv = UVOffset + stored * UVScale
+//
+// "stored" is [0,1] for unorm16 and [-1,1] for half positions
+// --------------------------------------------------------
+struct VertexQuantization
+{
+	DirectX::XMFLOAT3 PositionOffset;
+	DirectX::XMFLOAT3 PositionScale;
+	DirectX::XMFLOAT2 UVOffset;
+	DirectX::XMFLOAT2 UVScale;
+};
+
+// --------------------------------------------------------
+// How far decoded vertices ended up from the originals
+// --------------------------------------------------------
+struct VertexQuantizationError
+{
+	float MaxPositionError = 0.0f;		// Mesh units
+	float AvgPositionError = 0.0f;
+	float MaxNormalError = 0.0f;		// Degrees
+	float MaxTangentError = 0.0f;		// Degrees
+	float MaxUVError = 0.0f;			// UV units
+	size_t SignErrors = 0;				// Vertices whose handedness flipped
+};
+
+// --------------------------------------------------------
+// Compile-time vertex format descriptors
+//
+// Each one has:
+//   Type					- What goes in the vertex buffer
+//   Stride					- sizeof(Type)
+//   InputElements[]		- Matching input layout
+//   Quantize()				- Per-mesh scale/offset for the vertices
+//   Encode()/Decode()		- One vertex to/from the full Vertex
+// --------------------------------------------------------
+
+// The regular 48 byte Vertex, for comparison/fallback
+struct FullVertexFormat
+{
+	typedef Vertex Type;
+	static const unsigned int Stride = sizeof(Vertex);
+	static const unsigned int InputElementCount = 4;
+	static const D3D11_INPUT_ELEMENT_DESC InputElements[InputElementCount];
+	static const char* Name() { return "Full"; }
+
+	static VertexQuantization Quantize(const Vertex* vertices, size_t count);
+	static Type Encode(const Vertex& v, const VertexQuantization& q);
+	static Vertex Decode(const Type& v, const VertexQuantization& q);
+};
+
+// Positions as unorm16 across the bounds - even precision everywhere
+struct Unorm16VertexFormat
+{
+	typedef PackedVertex Type;
+	static const unsigned int Stride = sizeof(PackedVertex);
+	static const unsigned int InputElementCount = 4;
+	static const D3D11_INPUT_ELEMENT_DESC InputElements[InputElementCount];
+	static const char* Name() { return "Unorm16"; }
+
+	static VertexQuantization Quantize(const Vertex* vertices, size_t count);
+	static Type Encode(const Vertex& v, const VertexQuantization& q);
+	static Vertex Decode(const Type& v, const VertexQuantization& q);
+};
+
+// Positions as half floats centered on the bounds - finer near the
+// middle of the mesh, coarser at the edges
+struct HalfVertexFormat
+{
+	typedef PackedVertex Type;
+	static const unsigned int Stride = sizeof(PackedVertex);
+	static const unsigned int InputElementCount = 4;
+	static const D3D11_INPUT_ELEMENT_DESC InputElements[InputElementCount];
+	static const char* Name() { return "Half"; }
+
+	static VertexQuantization Quantize(const Vertex* vertices, size_t count);
+	static Type Encode(const Vertex& v, const VertexQuantization& q);
+	static Vertex Decode(const Type& v, const VertexQuantization& q);
+};
+
+// --------------------------------------------------------
+// Shared encode/decode pieces and whole-mesh helpers
+// --------------------------------------------------------
+class VertexPacking
+{
+public:
+	// Octahedral mapping of a unit vector to [-1,1]^2 and back
+	static DirectX::XMFLOAT2 OctEncode(DirectX::XMFLOAT3 n);
+	static DirectX::XMFLOAT3 OctDecode(DirectX::XMFLOAT2 e);
+
+	// Scalar quantisation matching how the input assembler expands each format
+	static int16_t ToSnorm16(float v);
+	static float FromSnorm16(int16_t v);
+	static uint16_t ToUnorm16(float v);
+	static float FromUnorm16(uint16_t v);
+	static uint16_t ToHalf(float v);
+	static float FromHalf(uint16_t h);
+
+	// Encodes a whole mesh
+	template<typename Format>
+	static VertexQuantization Encode(const Vertex* vertices, size_t count, std::vector<typename Format::Type>& out)
+	{
+		VertexQuantization q = Format::Quantize(vertices, count);
+		out.resize(count);
+		for (size_t i = 0; i < count; i++)
+			out[i] = Format::Encode(vertices[i], q);
+		return q;
+	}
+
+	// Round trips a whole mesh through the format and measures what was lost
+	template<typename Format>
+	static VertexQuantizationError MeasureError(const Vertex* vertices, size_t count)
+	{
+		VertexQuantizationError error;
+		VertexQuantization q = Format::Quantize(vertices, count);
+		double positionTotal = 0.0;
+
+		for (size_t i = 0; i < count; i++)
+			AccumulateError(vertices[i], Format::Decode(Format::Encode(vertices[i], q), q), error, positionTotal);
+
+		if (count > 0)
+			error.AvgPositionError = (float)(positionTotal / count);
+		return error;
+	}
+
+	// Debug output comparing every format on one mesh
+	static void ReportErrors(const char* name, const Vertex* vertices, size_t count);
+
+private:
+	static void AccumulateError(const Vertex& original, const Vertex& decoded, VertexQuantizationError& error, double& positionTotal);
+};
@@ -0,0 +1,307 @@
+// --------------------------------------------------------
+// Standalone tests for VertexFormats
+//
+// Not part of the game project (it has its own main) - build it
+// on its own, e.g. headless on Linux:
+//
+//   g++ -std=c++14 -O2 -ITestStubs -o VertexFormatsTest
+//       VertexFormatsTest.cpp VertexFormats.cpp
+//
+// Usage:
+//   VertexFormatsTest [random unit vectors (default 200000)] [seed]
+//
+// The packed layouts have to describe PackedVertex exactly (20
+// bytes, every element at its member's offset), the scalar
+// conversions have to round trip the way the input assembler
+// expands them, and octahedral normals have to come back within
+// a twentieth of a degree.  Whole meshes - a torus with both
+// handednesses, and a flat quad with an axis of no extent - have
+// to decode within half a quantization step of where they
+// started.  Returns 0 when everything passed
+// --------------------------------------------------------
+#include "VertexFormats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool condition, const char* what, int line)
+	{
+		if (condition)
+			return;
+		printf("  FAILED (line %d): %s\n", line, what);
+		failures++;
+	}
+
+	#define CHECK(condition) Check((condition), #condition, __LINE__)
+
+	// Octahedral snorm16 normals and tangents, in degrees.  Encoding just rounds (it doesn't
+	// search the neighbouring codes for the closest), which is about 0.04 at worst
+	const float MaxDirectionError = 0.05f;
+
+	UINT FormatBytes(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
+		case DXGI_FORMAT_R32G32B32_FLOAT: return 12;
+		case DXGI_FORMAT_R32G32_FLOAT: return 8;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT: return 8;
+		case DXGI_FORMAT_R16G16B16A16_UNORM: return 8;
+		case DXGI_FORMAT_R16G16_UNORM: return 4;
+		case DXGI_FORMAT_R16G16_SNORM: return 4;
+		default: return 0;
+		}
+	}
+
+	// Every element has to sit where the struct keeps it, and together cover the whole vertex
+	template<typename Format>
+	bool LayoutMatches(const size_t* offsets, const char* const* semantics)
+	{
+		UINT covered = 0;
+		for (unsigned int i = 0; i < Format::InputElementCount; i++)
+		{
+			const D3D11_INPUT_ELEMENT_DESC& element = Format::InputElements[i];
+			bool found = false;
+			for (unsigned int s = 0; s < Format::InputElementCount; s++)
+				found = found || (strcmp(element.SemanticName, semantics[s]) == 0 && element.AlignedByteOffset == offsets[s]);
+			if (!found || element.InputSlot != 0 || element.InputSlotClass != D3D11_INPUT_PER_VERTEX_DATA)
+				return false;
+			covered += FormatBytes(element.Format);
+		}
+		return covered == Format::Stride;
+	}
+
+	void TestLayouts()
+	{
+		printf("Layouts\n");
+		CHECK(sizeof(PackedVertex) == 20);
+		CHECK(Unorm16VertexFormat::Stride == 20 && HalfVertexFormat::Stride == 20);
+		CHECK(FullVertexFormat::Stride == sizeof(Vertex));
+
+		const char* const semantics[] = { "POSITION", "NORMAL", "TEXCOORD", "TANGENT" };
+		size_t packed[] = { offsetof(PackedVertex, Position), offsetof(PackedVertex, Normal), offsetof(PackedVertex, UV), offsetof(PackedVertex, Tangent) };
+		size_t full[] = { offsetof(Vertex, Position), offsetof(Vertex, Normal), offsetof(Vertex, UV), offsetof(Vertex, Tangent) };
+		CHECK(LayoutMatches<Unorm16VertexFormat>(packed, semantics));
+		CHECK(LayoutMatches<HalfVertexFormat>(packed, semantics));
+		CHECK(LayoutMatches<FullVertexFormat>(full, semantics));
+
+		CHECK(Unorm16VertexFormat::InputElements[0].Format == DXGI_FORMAT_R16G16B16A16_UNORM);
+		CHECK(HalfVertexFormat::InputElements[0].Format == DXGI_FORMAT_R16G16B16A16_FLOAT);
+	}
+
+	// --------------------------------------------------------
+	// Snorm/unorm against the D3D rules (-32768 and -32767 are
+	// both -1), and every finite half through float and back
+	// --------------------------------------------------------
+	void TestScalars()
+	{
+		printf("Scalars\n");
+		bool snormRoundTrips = true;
+		for (int v = -32767; v <= 32767; v++)
+			snormRoundTrips = snormRoundTrips && VertexPacking::ToSnorm16(VertexPacking::FromSnorm16((int16_t)v)) == v;
+		CHECK(snormRoundTrips);
+		CHECK(VertexPacking::FromSnorm16(-32768) == -1.0f && VertexPacking::FromSnorm16(32767) == 1.0f);
+		CHECK(VertexPacking::ToSnorm16(2.0f) == 32767 && VertexPacking::ToSnorm16(-2.0f) == -32767);
+
+		bool unormRoundTrips = true;
+		for (int v = 0; v <= 65535; v++)
+			unormRoundTrips = unormRoundTrips && VertexPacking::ToUnorm16(VertexPacking::FromUnorm16((uint16_t)v)) == v;
+		CHECK(unormRoundTrips);
+		CHECK(VertexPacking::ToUnorm16(-1.0f) == 0 && VertexPacking::ToUnorm16(1.5f) == 65535);
+
+		bool halfRoundTrips = true;
+		for (int h = 0; h <= 0xFFFF; h++)
+		{
+			if ((h & 0x7C00) == 0x7C00)
+				continue;
+			halfRoundTrips = halfRoundTrips && VertexPacking::ToHalf(VertexPacking::FromHalf((uint16_t)h)) == h;
+		}
+		CHECK(halfRoundTrips);
+
+		//Exact values, ties to even, overflow and the smallest denormal
+		CHECK(VertexPacking::ToHalf(1.0f) == 0x3C00 && VertexPacking::ToHalf(-2.0f) == 0xC000);
+		CHECK(VertexPacking::ToHalf(1.0f + 1.0f / 2048.0f) == 0x3C00);
+		CHECK(VertexPacking::ToHalf(1.0f + 3.0f / 2048.0f) == 0x3C02);
+		CHECK(VertexPacking::ToHalf(65504.0f) == 0x7BFF && VertexPacking::ToHalf(65520.0f) == 0x7C00);
+		CHECK(VertexPacking::ToHalf(ldexpf(1.0f, -24)) == 0x0001 && VertexPacking::ToHalf(ldexpf(1.0f, -26)) == 0);
+	}
+
+	float AngleDegrees(XMFLOAT3 a, XMFLOAT3 b)
+	{
+		float d = (a.x * b.x + a.y * b.y + a.z * b.z) /
+			sqrtf((a.x * a.x + a.y * a.y + a.z * a.z) * (b.x * b.x + b.y * b.y + b.z * b.z));
+		return acosf(d > 1.0f ? 1.0f : (d < -1.0f ? -1.0f : d)) * (180.0f / XM_PI);
+	}
+
+	// Through snorm16 like the vertex buffer stores it
+	XMFLOAT3 OctRoundTrip(XMFLOAT3 n)
+	{
+		XMFLOAT2 e = VertexPacking::OctEncode(n);
+		return VertexPacking::OctDecode(XMFLOAT2(
+			VertexPacking::FromSnorm16(VertexPacking::ToSnorm16(e.x)),
+			VertexPacking::FromSnorm16(VertexPacking::ToSnorm16(e.y))));
+	}
+
+	// --------------------------------------------------------
+	// The axes and diagonals (the octahedron's corners, edges
+	// and faces, where the folding is most likely to go wrong)
+	// and a spread of random directions
+	// --------------------------------------------------------
+	void TestOctahedral(int count, unsigned int seed)
+	{
+		printf("Octahedral (%d random directions, seed %u)\n", count, seed);
+		float worst = 0.0f;
+		for (int x = -1; x <= 1; x++)
+		{
+			for (int y = -1; y <= 1; y++)
+			{
+				for (int z = -1; z <= 1; z++)
+				{
+					if (x || y || z)
+						worst = (std::max)(worst, AngleDegrees(XMFLOAT3((float)x, (float)y, (float)z), OctRoundTrip(XMFLOAT3((float)x, (float)y, (float)z))));
+				}
+			}
+		}
+		CHECK(worst < MaxDirectionError);
+
+		std::mt19937 random(seed);
+		std::normal_distribution<float> gaussian;
+		for (int i = 0; i < count; i++)
+		{
+			XMFLOAT3 n(gaussian(random), gaussian(random), gaussian(random));
+			worst = (std::max)(worst, AngleDegrees(n, OctRoundTrip(n)));
+		}
+		CHECK(worst < MaxDirectionError);
+		printf("  worst %.5f degrees\n", worst);
+	}
+
+	// --------------------------------------------------------
+	// u around the ring, v around the tube, with the tangents
+	// of the inner half flipped so both handednesses show up
+	// --------------------------------------------------------
+	std::vector<Vertex> MakeTorus(int ringSegments, int tubeSegments)
+	{
+		const float ring = 3.0f;
+		const float tube = 1.0f;
+		std::vector<Vertex> vertices;
+		for (int t = 0; t <= tubeSegments; t++)
+		{
+			float phi = XM_2PI * t / tubeSegments;
+			for (int r = 0; r <= ringSegments; r++)
+			{
+				float theta = XM_2PI * r / ringSegments;
+				Vertex v;
+				v.Normal = XMFLOAT3(cosf(phi) * cosf(theta), sinf(phi), cosf(phi) * sinf(theta));
+				v.Position = XMFLOAT3((ring + tube * cosf(phi)) * cosf(theta) + 10.0f, tube * sinf(phi) - 2.0f, (ring + tube * cosf(phi)) * sinf(theta));
+				v.UV = XMFLOAT2(2.0f * r / ringSegments, 0.5f + (float)t / tubeSegments);
+				v.Tangent = XMFLOAT4(-sinf(theta), 0.0f, cosf(theta), cosf(phi) < 0.0f ? -1.0f : 1.0f);
+				vertices.push_back(v);
+			}
+		}
+		return vertices;
+	}
+
+	void Report(const char* name, const VertexQuantizationError& error)
+	{
+		printf("  %-8s position max %.7f avg %.7f, normal %.5f deg, tangent %.5f deg, uv %.7f, %zu sign errors\n",
+			name, error.MaxPositionError, error.AvgPositionError, error.MaxNormalError, error.MaxTangentError, error.MaxUVError, error.SignErrors);
+	}
+
+	// Half a step in each of x/y/z, as a distance
+	float HalfStepDistance(XMFLOAT3 step)
+	{
+		return 0.5f * sqrtf(step.x * step.x + step.y * step.y + step.z * step.z);
+	}
+
+	void TestTorus()
+	{
+		printf("Torus\n");
+		std::vector<Vertex> vertices = MakeTorus(96, 48);
+
+		//Unorm16 steps are even - scale / 65535 everywhere
+		VertexQuantization q = Unorm16VertexFormat::Quantize(&vertices[0], vertices.size());
+		CHECK(fabsf(q.PositionOffset.x - 6.0f) < 1e-4f && fabsf(q.PositionScale.x - 8.0f) < 1e-4f);
+		CHECK(fabsf(q.UVOffset.y - 0.5f) < 1e-6f && fabsf(q.UVScale.x - 2.0f) < 1e-6f);
+
+		VertexQuantizationError unorm = VertexPacking::MeasureError<Unorm16VertexFormat>(&vertices[0], vertices.size());
+		Report(Unorm16VertexFormat::Name(), unorm);
+		XMFLOAT3 step(q.PositionScale.x / 65535.0f, q.PositionScale.y / 65535.0f, q.PositionScale.z / 65535.0f);
+		CHECK(unorm.MaxPositionError <= HalfStepDistance(step) * 1.01f);
+		CHECK(unorm.MaxUVError <= 0.5f * q.UVScale.x / 65535.0f * 1.01f);
+		CHECK(unorm.MaxNormalError < MaxDirectionError && unorm.MaxTangentError < MaxDirectionError);
+		CHECK(unorm.SignErrors == 0);
+
+		//Half steps grow towards the edges of the bounds - at most 2^-11 of the half extent
+		VertexQuantization h = HalfVertexFormat::Quantize(&vertices[0], vertices.size());
+		VertexQuantizationError half = VertexPacking::MeasureError<HalfVertexFormat>(&vertices[0], vertices.size());
+		Report(HalfVertexFormat::Name(), half);
+		XMFLOAT3 halfStep(h.PositionScale.x / 1024.0f, h.PositionScale.y / 1024.0f, h.PositionScale.z / 1024.0f);
+		CHECK(half.MaxPositionError <= HalfStepDistance(halfStep) * 1.01f);
+		CHECK(half.MaxPositionError > unorm.MaxPositionError);
+		CHECK(half.SignErrors == 0);
+
+		//What Mesh uploads - one packed vertex per vertex, with the same quantization
+		std::vector<PackedVertex> packed;
+		VertexQuantization encoded = VertexPacking::Encode<Unorm16VertexFormat>(&vertices[0], vertices.size(), packed);
+		CHECK(packed.size() == vertices.size());
+		CHECK(memcmp(&encoded, &q, sizeof(q)) == 0);
+		CHECK(packed[0].Position[3] == 0xFFFF);
+		CHECK(packed[vertices.size() / 2].Position[3] == 0);
+
+		VertexQuantizationError full = VertexPacking::MeasureError<FullVertexFormat>(&vertices[0], vertices.size());
+		CHECK(full.MaxPositionError == 0.0f && full.MaxUVError == 0.0f && full.SignErrors == 0);
+	}
+
+	// A flat quad - no extent in y, and every vertex has the same UV v
+	void TestFlat()
+	{
+		printf("Flat quad\n");
+		std::vector<Vertex> vertices(4);
+		for (int i = 0; i < 4; i++)
+		{
+			vertices[i].Position = XMFLOAT3((i & 1) ? 5.0f : -5.0f, 1.25f, (i & 2) ? 5.0f : -5.0f);
+			vertices[i].Normal = XMFLOAT3(0, 1, 0);
+			vertices[i].UV = XMFLOAT2((i & 1) ? 1.0f : 0.0f, 0.75f);
+			vertices[i].Tangent = XMFLOAT4(1, 0, 0, 1);
+		}
+
+		VertexQuantization q = Unorm16VertexFormat::Quantize(&vertices[0], vertices.size());
+		CHECK(q.PositionScale.y == 0.0f && q.UVScale.y == 0.0f);
+
+		VertexQuantizationError unorm = VertexPacking::MeasureError<Unorm16VertexFormat>(&vertices[0], vertices.size());
+		VertexQuantizationError half = VertexPacking::MeasureError<HalfVertexFormat>(&vertices[0], vertices.size());
+		CHECK(unorm.MaxPositionError == 0.0f && unorm.MaxUVError == 0.0f && unorm.MaxNormalError == 0.0f);
+		CHECK(half.MaxPositionError == 0.0f && half.MaxUVError == 0.0f);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int directions = argc > 1 ? atoi(argv[1]) : 200000;
+	unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+
+	TestLayouts();
+	TestScalars();
+	TestOctahedral(directions, seed);
+	TestTorus();
+	TestFlat();
+
+	if (failures)
+	{
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("All passed\n");
+	return 0;
+}
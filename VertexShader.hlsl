@@ -1,10 +1,15 @@
 #include "ShaderIncludes.hlsli"
 
-cbuffer ExternalData : register(b0)
+//Split by how often they change - the camera is uploaded once a frame, the rest every draw
+cbuffer PerFrame : register(b0)
 {
-	matrix world;
 	matrix view;
 	matrix projection;
+}
+
+cbuffer PerObject : register(b1)
+{
+	matrix world;
 	matrix worldInvTranspose;
 }
 
@@ -35,7 +40,7 @@ VertexToPixel main( VertexShaderInput input )
 	output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
 
 	output.normal = mul((float3x3)worldInvTranspose, input.normal);
-	output.tangent = mul((float3x3)worldInvTranspose, input.tangent);
+	output.tangent = float4(mul((float3x3)worldInvTranspose, input.tangent.xyz), input.tangent.w);
 
 	output.worldPosition = mul(world, float4(input.localPosition, 1)).xyz;
 
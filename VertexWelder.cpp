@@ -0,0 +1,103 @@
+#include "VertexWelder.h"
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	//Position, normal and UV are laid out back to back at the front of Vertex
+	const size_t WeldKeySize = sizeof(DirectX::XMFLOAT3) * 2 + sizeof(DirectX::XMFLOAT2);
+	const unsigned int EmptySlot = 0xFFFFFFFF;
+
+	// --------------------------------------------------------
+	// Hashes the raw bits of the welded attributes
+	// (bits rather than values, so -0 and 0 stay distinct and
+	// the round trip stays exact)
+	// --------------------------------------------------------
+	inline uint32_t HashVertex(const Vertex& v)
+	{
+		uint32_t words[WeldKeySize / 4];
+		memcpy(words, &v, WeldKeySize);
+
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < WeldKeySize / 4; i++)
+		{
+			hash ^= words[i];
+			hash *= 16777619u;
+			hash ^= hash >> 15;
+		}
+		return hash;
+	}
+
+	inline bool SameVertex(const Vertex& a, const Vertex& b)
+	{
+		return memcmp(&a, &b, WeldKeySize) == 0;
+	}
+}
+
+// --------------------------------------------------------
+// Welds identical vertices together
+//
+// vertices - Flat triangle list
+// uniqueVertices - Receives each distinct vertex once
+// indices - Receives one index per input vertex
+// stats - Optional before/after vertex counts
+// --------------------------------------------------------
+void VertexWelder::Weld(const std::vector<Vertex>& vertices, std::vector<Vertex>& uniqueVertices, std::vector<unsigned int>& indices, WeldStats* stats)
+{
+	static_assert(offsetof(Vertex, Position) == 0 && offsetof(Vertex, Normal) == 12 && offsetof(Vertex, UV) == 24,
+		"VertexWelder expects Position, Normal and UV at the start of Vertex");
+
+	uniqueVertices.clear();
+	indices.clear();
+	uniqueVertices.reserve(vertices.size());
+	indices.reserve(vertices.size());
+
+	//Open addressing table, kept at most half full
+	size_t tableSize = 16;
+	while (tableSize < vertices.size() * 2)
+		tableSize <<= 1;
+	std::vector<unsigned int> table(tableSize, EmptySlot);
+	size_t mask = tableSize - 1;
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const Vertex& v = vertices[i];
+		size_t slot = HashVertex(v) & mask;
+
+		//Linear probe until we find this vertex or an empty slot
+		while (table[slot] != EmptySlot && !SameVertex(uniqueVertices[table[slot]], v))
+			slot = (slot + 1) & mask;
+
+		if (table[slot] == EmptySlot)
+		{
+			table[slot] = (unsigned int)uniqueVertices.size();
+			uniqueVertices.push_back(v);
+		}
+
+		indices.push_back(table[slot]);
+	}
+
+	if (stats)
+	{
+		stats->VerticesBefore = vertices.size();
+		stats->VerticesAfter = uniqueVertices.size();
+	}
+}
+
+// --------------------------------------------------------
+// Expands the welded mesh back out and compares it against
+// the original, attribute bits and all
+// --------------------------------------------------------
+bool VertexWelder::MatchesUnwelded(const std::vector<Vertex>& original, const std::vector<Vertex>& uniqueVertices, const std::vector<unsigned int>& indices)
+{
+	if (original.size() != indices.size())
+		return false;
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		if (indices[i] >= uniqueVertices.size() || !SameVertex(original[i], uniqueVertices[indices[i]]))
+			return false;
+	}
+
+	return true;
+}
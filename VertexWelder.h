@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Vertex counts from a weld
+// --------------------------------------------------------
+struct WeldStats
+{
+	size_t VerticesBefore = 0;
+	size_t VerticesAfter = 0;
+};
+
+// --------------------------------------------------------
+// Turns a flat triangle list (3 vertices per triangle, no
+// sharing) into a properly indexed mesh
+//
+// - Vertices are the same if their position, normal and UV
+//   are bit-for-bit identical; tangents are ignored since
+//   they're generated after welding
+// - Unique vertices keep the order they first appear in
+// --------------------------------------------------------
+class VertexWelder
+{
+public:
+	static void Weld(const std::vector<Vertex>& vertices, std::vector<Vertex>& uniqueVertices, std::vector<unsigned int>& indices, WeldStats* stats = nullptr);
+
+	// Checks that indexing into the welded mesh gives back exactly the original vertex list
+	static bool MatchesUnwelded(const std::vector<Vertex>& original, const std::vector<Vertex>& uniqueVertices, const std::vector<unsigned int>& indices);
+};